@@ -47,9 +47,14 @@ let package = Package(
                 "Driver/KvaserCAN_Driver.c",
                 "Driver/KvaserUSB_Device.c",
                 "Driver/KvaserUSB_LeafDevice.c",
+                "Driver/KvaserUSB_LoadMeter.c",
+                "Driver/KvaserUSB_InfoCache.c",
+                "Driver/KvaserUSB_FlightRec.c",
+                "Driver/KvaserUSB_SharedDevice.c",
                 "Driver/KvaserUSB_MhydraDevice.c",
                 "Driver/KvaserCAN_Devices.c",
                 "Wrapper/can_api.c",
+                "MacCAN/MacCAN_SharedMem.c",
                 "MacCAN/MacCAN_MsgPipe.c",
                 "MacCAN/MacCAN_MsgQueue.c",
                 "MacCAN/MacCAN_IOUsbKit.c",
@@ -71,7 +76,7 @@ let package = Package(
                 CSetting.define("OPTION_CANAPI_RETVALS=1"),
                 CSetting.define("OPTION_CANAPI_COMPANIONS=1"),
                 CSetting.define("OPTION_MACCAN_LOGGER=0"),
-                CSetting.define("OPTION_MACCAN_MULTICHANNEL=0"),
+                CSetting.define("OPTION_MACCAN_MULTICHANNEL=1"),
                 CSetting.define("OPTION_MACCAN_PIPE_TIMEOUT=1"),
                 CSetting.define("OPTION_MACCAN_DEBUG_LEVEL=0"),
                 CSetting.define("OPTION_MACCAN_INSTRUMENTATION=0"),
@@ -82,6 +82,8 @@
 #include <assert.h>
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
+#else
+#include <pthread.h>
 #endif
 #include <math.h>
 
@@ -102,12 +104,27 @@
 #define BTR_SAM(btr0btr1)       (((uint16_t)(btr0btr1) & 0x0080u) >> 7)
 #define BTR_TSEG2(btr0btr1)     (((uint16_t)(btr0btr1) & 0x0070u) >> 4)
 #define BTR_TSEG1(btr0btr1)     (((uint16_t)(btr0btr1) & 0x000Fu) >> 0)
+#define BTR_SJA1000_BITRATE(btr0btr1) \
+                                { .btr = { BTR_FREQ_SJA1000, { \
+                                  BTR_BRP(btr0btr1) + 1u, BTR_TSEG1(btr0btr1) + 1u, \
+                                  BTR_TSEG2(btr0btr1) + 1u, BTR_SJW(btr0btr1) + 1u, \
+                                  BTR_SAM(btr0btr1) } } }
 #define BTR_BTR0BTR1(sjw,brp,sam,tseg2,tseg1) \
                                 ((((uint16_t)(sjw) & 0x0003) << 14)  | \
                                  (((uint16_t)(brp) & 0x003F) << 8)   | \
                                  (((uint16_t)(sam) & 0x0001) << 7)   | \
                                  (((uint16_t)(tseg2) & 0x0007) << 4) | \
                                  (((uint16_t)(tseg1) & 0x000F) << 0))
+#if defined(_WIN32) || defined(_WIN64)
+#define ENTER_CACHE()           AcquireSRWLockExclusive(&solutions.lock)
+#define LEAVE_CACHE()           ReleaseSRWLockExclusive(&solutions.lock)
+#define CACHE_LOCK_INIT         SRWLOCK_INIT
+#else
+#define ENTER_CACHE()           (void)pthread_mutex_lock(&solutions.lock)
+#define LEAVE_CACHE()           (void)pthread_mutex_unlock(&solutions.lock)
+#define CACHE_LOCK_INIT         PTHREAD_MUTEX_INITIALIZER
+#endif
+#define ABS(x)                  (((x) < 0) ? -(x) : (x))
 #ifdef _MSC_VER
 //not #if defined(_WIN32) || defined(_WIN64) because we have strncasecmp in mingw
 #define strncasecmp _strnicmp
@@ -117,6 +134,41 @@
 /*  -----------  types  --------------------------------------------------
  */
 
+typedef enum keyword_tag {              // keys of the bit-rate string:
+    KEY_F_CLOCK,                        //   frequency in Hz
+    KEY_F_CLOCK_MHZ,                    //   frequency in MHz
+    KEY_NOM_BRP,                        //   bit-rate prescaler (nominal)
+    KEY_NOM_TSEG1,                      //   time segment 1 (nominal)
+    KEY_NOM_TSEG2,                      //   time segment 2 (nominal)
+    KEY_NOM_SJW,                        //   sync. jump width (nominal)
+    KEY_NOM_SAM,                        //   sampling (only CAN 2.0)
+#if (OPTION_CAN_2_0_ONLY == OPTION_DISABLED)
+    KEY_DATA_BRP,                       //   bit-rate prescaler (data phase)
+    KEY_DATA_TSEG1,                     //   time segment 1 (data phase)
+    KEY_DATA_TSEG2,                     //   time segment 2 (data phase)
+    KEY_DATA_SJW,                       //   sync. jump width (data phase)
+#endif
+    NUM_KEYS
+} keyword_t;
+
+typedef struct solution_tag {           // solution of the bit-timing solver:
+    btr_limits_t limits;                //   CAN controller (key)
+    btr_target_t target;                //   bit-rate and sample-point (key)
+    size_t count;                       //   number of candidates
+    btr_candidate_t candidate[BTR_SOLVER_CANDIDATES];
+} solution_t;
+
+typedef struct cache_tag {              // cache of the bit-timing solver:
+#if defined(_WIN32) || defined(_WIN64)
+    SRWLOCK lock;                       //   slim reader/writer lock
+#else
+    pthread_mutex_t lock;               //   mutex
+#endif
+    unsigned int used;                  //   number of valid entries
+    unsigned int next;                  //   entry to be replaced next
+    solution_t entry[BTR_SOLVER_ENTRIES];
+} cache_t;
+
 
 /*  -----------  prototypes  ---------------------------------------------
  */
@@ -124,9 +176,13 @@
 static int print_bitrate(const btr_bitrate_t *bitrate, bool data, bool sam, btr_string_t string, size_t maxbyte);
 static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *data, bool *sam);
 
-static char *scan_key(char *str);
-static char *scan_value(char *str);
-static char *skip_blanks(char *str);
+static int find_key(const char *key, size_t length);
+static size_t print_string(btr_string_t string, size_t maxbyte, size_t offset, const char *str);
+static size_t print_number(btr_string_t string, size_t maxbyte, size_t offset, long number);
+
+static void solve_bitrate(const btr_limits_t *limits, const btr_target_t *target, solution_t *solution);
+static bool split_quanta(const btr_limits_t *limits, const btr_target_t *target, uint32_t brp, uint32_t ntq, btr_candidate_t *candidate);
+static int compare_candidates(const btr_candidate_t *candidate1, const btr_candidate_t *candidate2);
 
 
 /*  -----------  variables  ----------------------------------------------
@@ -145,6 +201,41 @@ static const btr_sja1000_t sja1000_btr0btr1[BTR_SJA1000_ENTRIES] = {
     SJA1000_5K     //    5 kbps (SP=68.0%, SJW=2)
 };
 
+static const btr_bitrate_t sja1000_bitrate[BTR_SJA1000_ENTRIES] = {
+    BTR_SJA1000_BITRATE(SJA1000_1M),
+    BTR_SJA1000_BITRATE(SJA1000_800K),
+    BTR_SJA1000_BITRATE(SJA1000_500K),
+    BTR_SJA1000_BITRATE(SJA1000_250K),
+    BTR_SJA1000_BITRATE(SJA1000_125K),
+    BTR_SJA1000_BITRATE(SJA1000_100K),
+    BTR_SJA1000_BITRATE(SJA1000_50K),
+    BTR_SJA1000_BITRATE(SJA1000_20K),
+    BTR_SJA1000_BITRATE(SJA1000_10K),
+    BTR_SJA1000_BITRATE(SJA1000_5K)
+};
+
+static const struct {                   // keys of the bit-rate string:
+    const char *name;                   //   key (w/o '=')
+    size_t length;                      //   length of the key
+    long maximum;                       //   max. value
+} keys[NUM_KEYS] = {
+    { "f_clock",     7U, (long)INT32_MAX },
+    { "f_clock_mhz", 11U, ((long)INT32_MAX / 1000000L) },
+    { "nom_brp",     7U, (long)UINT16_MAX },
+    { "nom_tseg1",   9U, (long)UINT16_MAX },
+    { "nom_tseg2",   9U, (long)UINT16_MAX },
+    { "nom_sjw",     7U, (long)UINT16_MAX },
+    { "nom_sam",     7U, (long)UINT8_MAX },
+#if (OPTION_CAN_2_0_ONLY == OPTION_DISABLED)
+    { "data_brp",    8U, (long)UINT16_MAX },
+    { "data_tseg1", 10U, (long)UINT16_MAX },
+    { "data_tseg2", 10U, (long)UINT16_MAX },
+    { "data_sjw",    8U, (long)UINT16_MAX },
+#endif
+};
+
+static cache_t solutions = { .lock = CACHE_LOCK_INIT };
+
 /*  -----------  functions  ----------------------------------------------
  */
 
@@ -331,23 +422,19 @@ int btr_bitrate2speed(const btr_bitrate_t *bitrate, btr_speed_t *speed) {
 }
 
 int btr_index2bitrate(const btr_index_t index, btr_bitrate_t *bitrate) {
-    btr_sja1000_t btr0btr1 = 0x0000u;   // SJA1000 registers
-    int rc = BTRERR_FATAL;              // return value
-
     if (!bitrate)                       // check for null-pointer
         return BTRERR_NULLPTR;
+    if ((index > 0) || (index <= -BTR_SJA1000_ENTRIES))
+        return BTRERR_BAUDRATE;         // must be a valid index
 
-    /* first convert the index into SJA1000 BTR0BTR1 register */
-    if ((rc = btr_index2sja1000(index, &btr0btr1)) != BTRERR_NOERROR)
-        return rc;
-    /* then convert the SJA1000 BTR0BTR1 register into bit-rate settings */
-    return btr_sja10002bitrate(btr0btr1, bitrate);
+    /* the SJA1000 bit-rate settings from table */
+    memcpy(bitrate, &sja1000_bitrate[-index], sizeof(btr_bitrate_t));
+    return BTRERR_NOERROR;
 }
 
 int btr_bitrate2index(const btr_bitrate_t *bitrate, btr_index_t *index) {
     btr_sja1000_t btr0btr1;             // SJA1000 register
     int rc = BTRERR_FATAL;              // return value
-    int i;
 
     if (!bitrate || !index)             // check for null-pointer
         return BTRERR_NULLPTR;
@@ -363,14 +450,22 @@ int btr_bitrate2index(const btr_bitrate_t *bitrate, btr_index_t *index) {
     if ((rc = btr_bitrate2sja1000(bitrate, &btr0btr1)) != BTRERR_NOERROR)
         return rc;
     /* then look in the table of predefined bit-timing indexes */
-    for (i = 0; i < BTR_SJA1000_ENTRIES; i++) {
-        if (btr0btr1 == sja1000_btr0btr1[i]) {
-            *index = (btr_index_t)(i * (-1));
-            return BTRERR_NOERROR;
-        }
+    switch (btr0btr1) {
+        case SJA1000_1M:   *index = (btr_index_t)0; break;
+        case SJA1000_800K: *index = (btr_index_t)-1; break;
+        case SJA1000_500K: *index = (btr_index_t)-2; break;
+        case SJA1000_250K: *index = (btr_index_t)-3; break;
+        case SJA1000_125K: *index = (btr_index_t)-4; break;
+        case SJA1000_100K: *index = (btr_index_t)-5; break;
+        case SJA1000_50K:  *index = (btr_index_t)-6; break;
+        case SJA1000_20K:  *index = (btr_index_t)-7; break;
+        case SJA1000_10K:  *index = (btr_index_t)-8; break;
+        case SJA1000_5K:   *index = (btr_index_t)-9; break;
+        default:
+            /* bad luck, nothing found:( */
+            return BTRERR_BAUDRATE;
     }
-    /* bad luck, nothing found:( */
-    return BTRERR_BAUDRATE;
+    return BTRERR_NOERROR;
 }
 
 int btr_string2bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *data, bool *sam) {
@@ -474,76 +569,200 @@ int btr_index2sja1000(const btr_index_t index, btr_sja1000_t *btr0btr1)
     return rc;
 }
 
+int btr_solve_bitrate(const btr_limits_t *limits, const btr_target_t *target, btr_candidate_t *candidates, size_t *count) {
+    solution_t *solution = NULL;        // cached solution
+    btr_limits_t key_limits;            // key: CAN controller
+    btr_target_t key_target;            // key: bit-rate and sample-point
+    unsigned int i;                     // index of the cache
+    size_t n;                           // number of candidates
+
+    if (!limits || !target || !candidates || !count)  // check for null-pointer
+        return BTRERR_NULLPTR;
+    if (*count == 0U)                   // check for buffer size
+        return BTRERR_ILLPARA;
+    if ((limits->frequency <= 0) ||
+        (limits->brp_min < 1u) || (limits->brp_min > limits->brp_max) ||
+        (limits->tseg1_min < 1u) || (limits->tseg1_min > limits->tseg1_max) ||
+        (limits->tseg2_min < 1u) || (limits->tseg2_min > limits->tseg2_max) ||
+        (limits->sjw_min < 1u) || (limits->sjw_min > limits->sjw_max))
+        return BTRERR_ILLPARA;
+    if ((target->bitrate == 0u) || (target->bitrate > (uint32_t)limits->frequency) ||
+        (target->samplepoint == 0u) || (target->samplepoint >= 10000u) ||
+        (target->sjw > limits->sjw_max) || (target->tolerance >= 1000000u))
+        return BTRERR_ILLPARA;
+
+    // the key (w/o padding bytes)
+    memset(&key_limits, 0, sizeof(btr_limits_t));
+    key_limits.frequency = limits->frequency;
+    key_limits.brp_min = limits->brp_min;
+    key_limits.brp_max = limits->brp_max;
+    key_limits.tseg1_min = limits->tseg1_min;
+    key_limits.tseg1_max = limits->tseg1_max;
+    key_limits.tseg2_min = limits->tseg2_min;
+    key_limits.tseg2_max = limits->tseg2_max;
+    key_limits.sjw_min = limits->sjw_min;
+    key_limits.sjw_max = limits->sjw_max;
+    memset(&key_target, 0, sizeof(btr_target_t));
+    key_target.bitrate = target->bitrate;
+    key_target.samplepoint = target->samplepoint;
+    key_target.sjw = target->sjw;
+    key_target.tolerance = target->tolerance;
+
+    ENTER_CACHE();
+    // (1) lookup: the solution may have been cached before
+    for (i = 0U; i < solutions.used; i++) {
+        if (!memcmp(&solutions.entry[i].limits, &key_limits, sizeof(btr_limits_t)) &&
+            !memcmp(&solutions.entry[i].target, &key_target, sizeof(btr_target_t))) {
+            solution = &solutions.entry[i];
+            break;
+        }
+    }
+    // (2) search: replace the oldest entry by the new solution
+    if (!solution) {
+        solution = &solutions.entry[solutions.next];
+        solutions.next = (solutions.next + 1U) % BTR_SOLVER_ENTRIES;
+        if (solutions.used < BTR_SOLVER_ENTRIES)
+            solutions.used++;
+        solve_bitrate(&key_limits, &key_target, solution);
+    }
+    n = (solution->count < *count) ? solution->count : *count;
+    if (n > 0U)
+        memcpy(candidates, solution->candidate, n * sizeof(btr_candidate_t));
+    LEAVE_CACHE();
+
+    *count = n;                         // note: zero if no candidate found
+    return (n > 0U) ? BTRERR_NOERROR : BTRERR_BAUDRATE;
+}
+
+int btr_find_bitrate(int32_t frequency, const btr_target_t *nominal, const btr_target_t *data, btr_bitrate_t *bitrate) {
+    btr_limits_t limits = BTR_NOMINAL_LIMITS(frequency);
+    btr_candidate_t best;               // best candidate
+    size_t count;                       // number of candidates
+    int rc;                             // return value
+
+    if (!nominal || !bitrate)           // check for null-pointer
+        return BTRERR_NULLPTR;
+#if (OPTION_CAN_2_0_ONLY != OPTION_DISABLED)
+    if (data)
+        return BTRERR_NOTSUPP;
+#endif
+    memset(bitrate, 0, sizeof(btr_bitrate_t));
+    bitrate->btr.frequency = frequency;
+
+    // nominal bit-rate
+    count = 1U;
+    if ((rc = btr_solve_bitrate(&limits, nominal, &best, &count)) != BTRERR_NOERROR)
+        return rc;
+    bitrate->btr.nominal.brp = best.brp;
+    bitrate->btr.nominal.tseg1 = best.tseg1;
+    bitrate->btr.nominal.tseg2 = best.tseg2;
+    bitrate->btr.nominal.sjw = best.sjw;
+    bitrate->btr.nominal.sam = BTR_NOMINAL_SAM_SINGLE;
+#if (OPTION_CAN_2_0_ONLY == OPTION_DISABLED)
+    // data bit-rate (optional)
+    if (data) {
+        btr_limits_t data_limits = BTR_DATA_LIMITS(frequency);
+        count = 1U;
+        if ((rc = btr_solve_bitrate(&data_limits, data, &best, &count)) != BTRERR_NOERROR)
+            return rc;
+        bitrate->btr.data.brp = best.brp;
+        bitrate->btr.data.tseg1 = best.tseg1;
+        bitrate->btr.data.tseg2 = best.tseg2;
+        bitrate->btr.data.sjw = best.sjw;
+    }
+#endif
+    return BTRERR_NOERROR;
+}
+
+int btr_flush_solutions(void) {
+    ENTER_CACHE();
+    solutions.used = 0U;
+    solutions.next = 0U;
+    LEAVE_CACHE();
+    return BTRERR_NOERROR;
+}
+
 /*  -----------  local functions  ----------------------------------------
  */
 
 static int print_bitrate(const btr_bitrate_t *bitrate, bool data, bool sam, btr_string_t string, size_t maxbyte) {
+    size_t n = 0U;                      // length of the string (w/o truncation)
+
     assert(bitrate && string && maxbyte);  // just to make sure
 
     /* note: all fields have to be checked for their limits beforehand. But don't care! */
 
+    n = print_string(string, maxbyte, n, "f_clock=");
+    n = print_number(string, maxbyte, n, (long)bitrate->btr.frequency);
+    n = print_string(string, maxbyte, n, ",nom_brp=");
+    n = print_number(string, maxbyte, n, (long)bitrate->btr.nominal.brp);
+    n = print_string(string, maxbyte, n, ",nom_tseg1=");
+    n = print_number(string, maxbyte, n, (long)bitrate->btr.nominal.tseg1);
+    n = print_string(string, maxbyte, n, ",nom_tseg2=");
+    n = print_number(string, maxbyte, n, (long)bitrate->btr.nominal.tseg2);
+    n = print_string(string, maxbyte, n, ",nom_sjw=");
+    n = print_number(string, maxbyte, n, (long)bitrate->btr.nominal.sjw);
+    if (sam) {                          // with 'nom_sam' key/value pair
+        n = print_string(string, maxbyte, n, ",nom_sam=");
+        n = print_number(string, maxbyte, n, (long)bitrate->btr.nominal.sam);
+    }
 #if (OPTION_CAN_2_0_ONLY == OPTION_DISABLED)
     if (data) {                         // with data phase key/value pairs
-        if (!sam) {                     //      w/o 'nom_sam' key/value pair
-            if (snprintf(string, maxbyte,
-                         "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,"
-                         "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
-                         bitrate->btr.frequency,
-                         bitrate->btr.nominal.brp,
-                         bitrate->btr.nominal.tseg1,
-                         bitrate->btr.nominal.tseg2,
-                         bitrate->btr.nominal.sjw,
-                         bitrate->btr.data.brp,
-                         bitrate->btr.data.tseg1,
-                         bitrate->btr.data.tseg2,
-                         bitrate->btr.data.sjw) < 0)
-                return BTRERR_BAUDRATE;
-        } else {                        //      with'nom_sam' key/value pair
-            if (snprintf(string, maxbyte,
-                         "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,nom_sam=%u,"
-                         "data_brp=%u,data_tseg1=%u,data_tseg2=%u,data_sjw=%u",
-                         bitrate->btr.frequency,
-                         bitrate->btr.nominal.brp,
-                         bitrate->btr.nominal.tseg1,
-                         bitrate->btr.nominal.tseg2,
-                         bitrate->btr.nominal.sjw,
-                         bitrate->btr.nominal.sam,
-                         bitrate->btr.data.brp,
-                         bitrate->btr.data.tseg1,
-                         bitrate->btr.data.tseg2,
-                         bitrate->btr.data.sjw) < 0)
-                return BTRERR_BAUDRATE;
-        }
-    } else {                            // w/o data phase key/value pairs
+        n = print_string(string, maxbyte, n, ",data_brp=");
+        n = print_number(string, maxbyte, n, (long)bitrate->btr.data.brp);
+        n = print_string(string, maxbyte, n, ",data_tseg1=");
+        n = print_number(string, maxbyte, n, (long)bitrate->btr.data.tseg1);
+        n = print_string(string, maxbyte, n, ",data_tseg2=");
+        n = print_number(string, maxbyte, n, (long)bitrate->btr.data.tseg2);
+        n = print_string(string, maxbyte, n, ",data_sjw=");
+        n = print_number(string, maxbyte, n, (long)bitrate->btr.data.sjw);
+    }
 #else
-        (void)data; {  // That's ugly, but ...
+    (void)data;
 #endif
-        if (sam) {                      //     with 'nom_sam' key/value pair
-            if (snprintf(string, maxbyte,
-                         "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u,nom_sam=%u",
-                         bitrate->btr.frequency,
-                         bitrate->btr.nominal.brp,
-                         bitrate->btr.nominal.tseg1,
-                         bitrate->btr.nominal.tseg2,
-                         bitrate->btr.nominal.sjw,
-                         bitrate->btr.nominal.sam) < 0)
-                return BTRERR_BAUDRATE;
-        } else {                        //     w/o 'nom_sam' key/value pair
-            if (snprintf(string, maxbyte,
-                         "f_clock=%i,nom_brp=%u,nom_tseg1=%u,nom_tseg2=%u,nom_sjw=%u",
-                         bitrate->btr.frequency,
-                         bitrate->btr.nominal.brp,
-                         bitrate->btr.nominal.tseg1,
-                         bitrate->btr.nominal.tseg2,
-                         bitrate->btr.nominal.sjw) < 0)
-                return BTRERR_BAUDRATE;
-        }
-    }
-    string[maxbyte-1] = '\0';
+    /* note: the string is truncated if the buffer is too small (like snprintf) */
+    string[(n < maxbyte) ? n : (maxbyte - 1U)] = '\0';
     return BTRERR_NOERROR;
 }
 
+static size_t print_string(btr_string_t string, size_t maxbyte, size_t offset, const char *str) {
+    assert(string && maxbyte && str);
+
+    while (*str != '\0') {
+        if (offset < (maxbyte - 1U))
+            string[offset] = *str;
+        offset++;
+        str++;
+    }
+    return offset;
+}
+
+static size_t print_number(btr_string_t string, size_t maxbyte, size_t offset, long number) {
+    char digits[24];                    // enough for 64-bit numbers
+    unsigned long value = (number < 0L) ? (0UL - (unsigned long)number) : (unsigned long)number;
+    int i = (int)sizeof(digits) - 1;
+
+    assert(string && maxbyte);
+
+    digits[i] = '\0';
+    do {
+        digits[--i] = (char)('0' + (value % 10UL));
+        value /= 10UL;
+    } while (value != 0UL);
+    if (number < 0L)
+        digits[--i] = '-';
+    return print_string(string, maxbyte, offset, &digits[i]);
+}
+
 static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *data, bool *sam) {
+    const char *ptr = string;           // single pass, no copy of the string
+    const char *key;
+    size_t length;
+    unsigned int given = 0U;            // keys given (bit mask)
+    unsigned int flag;
+    long number;
+    int k;
+
     assert(bitrate && string);          // just to make sure
     assert(data && sam);
 
@@ -551,155 +770,64 @@ static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool
     *data = false;
     *sam = false;
 
-    char str[BTR_STRING_MAX], *ptr;     // local variables
-    char *key, *value;
-    long number;
-
-    int f_clock = 0;
-    int nom_brp = 0;
-    int nom_tseg1 = 0;
-    int nom_tseg2 = 0;
-    int nom_sjw = 0;
-    int nom_sam = 0;
-#if (OPTION_CAN_2_0_ONLY == OPTION_DISABLED)
-    int data_brp = 0;
-    int data_tseg1 = 0;
-    int data_tseg2 = 0;
-    int data_sjw = 0;
-#endif
-    if (strlen(string) >= BTR_STRING_MAX)
-        return BTRERR_BAUDRATE;
-    strncpy(str, string, BTR_STRING_MAX);
-    ptr = str;
-
     while (*ptr != '\0') {              // lexical analysis:
-        // skip blanks and scan: <key> '='
-        if (!(key = skip_blanks(ptr)))
+        // skip blanks and scan: <key> [' ']* '='
+        while (*ptr == ' ')
+            ptr++;
+        key = ptr;
+        while (('a' <= *ptr && *ptr <= 'z') || (*ptr == '_') || ('0' <= *ptr && *ptr <= '9') || ('A' <= *ptr && *ptr <= 'Z'))
+            ptr++;
+        length = (size_t)(ptr - key);
+        while (*ptr == ' ')
+            ptr++;
+        if (*ptr != '=')
             return BTRERR_BAUDRATE;
-        if (!(ptr = scan_key(key)))
+        ptr++;
+        // skip blanks and scan: <value> [' ']* [',']
+        while (*ptr == ' ')
+            ptr++;
+        if (!('0' <= *ptr && *ptr <= '9'))
             return BTRERR_BAUDRATE;
-        // skip blanks and scan: <value> [',']
-        if (!(value = skip_blanks(ptr)))
+        number = 0L;
+        while ('0' <= *ptr && *ptr <= '9') {
+            if (number <= (long)INT32_MAX)  // note: saturated, larger values are out of range anyway
+                number = (number * 10L) + (long)(*ptr - '0');
+            ptr++;
+        }
+        while (*ptr == ' ')
+            ptr++;
+        if (*ptr == ',')
+            ptr++;
+        else if (*ptr != '\0')
             return BTRERR_BAUDRATE;
-        if (!(ptr = scan_value(value)))
+        // note: the string must not be longer than BTR_STRING_MAX - 1
+        if ((size_t)(ptr - string) >= BTR_STRING_MAX)
             return BTRERR_BAUDRATE;
-        // evaluate <key> '=' <value> [',']
-        if (!strlen(key) || !strlen(value))
+        // evaluate <key> '=' <value>
+        if ((k = find_key(key, length)) < 0)
             return BTRERR_BAUDRATE;
-        // convert <value> = [0-9]+
-        errno = 0;
-        number = strtol(value, NULL, 10);
-        if (errno != 0)  // ERANGE or EINVAL
+        if (number > keys[k].maximum)
             return BTRERR_BAUDRATE;
-        // f_clock: 1..INT32_MAX
-        if (!strcmp(key, "f_clock")) {
-            if ((0L <= number) && (number <= (long)INT32_MAX))
-                bitrate->btr.frequency = (int32_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (f_clock++)
-                return BTRERR_BAUDRATE;
-        }
-        // f_clock_mhz: 1..INT32_MAX/1'000'000
-        else if (!strcmp(key, "f_clock_mhz")) {
-            if ((0L <= number) && (number <= ((long)INT32_MAX / 1000000L)))
-                bitrate->btr.frequency = (int32_t)(number * 1000000L);
-            else
-                return BTRERR_BAUDRATE;
-            if (f_clock++)
-                return BTRERR_BAUDRATE;
-        }
-        // nom_brp: 0..UINT16_MAX
-        else if (!strcmp(key, "nom_brp")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.nominal.brp = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (nom_brp++)
-                return BTRERR_BAUDRATE;
-        }
-        // nom_tseg1: 0..UINT16_MAX
-        else if (!strcmp(key, "nom_tseg1")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.nominal.tseg1 = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (nom_tseg1++)
-                return BTRERR_BAUDRATE;
-        }
-        // nom_tseg2: 0..UINT16_MAX
-        else if (!strcmp(key, "nom_tseg2")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.nominal.tseg2 = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (nom_tseg2++)
-                return BTRERR_BAUDRATE;
-        }
-        // nom_sjw: 0..UINT16_MAX
-        else if (!strcmp(key, "nom_sjw")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.nominal.sjw = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (nom_sjw++)
-                return BTRERR_BAUDRATE;
-        }
-        // nom_sam: 0..UINT8_MAX
-        else if (!strcmp(key, "nom_sam")) {
-            if ((0L <= number) && (number <= (long)UINT8_MAX))
-                bitrate->btr.nominal.sam = (uint8_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (nom_sam++)
-                return BTRERR_BAUDRATE;
-            *sam = true;
-        }
+        // each key only once (either 'f_clock' or 'f_clock_mhz')
+        flag = 1U << ((k == KEY_F_CLOCK_MHZ) ? KEY_F_CLOCK : k);
+        if (given & flag)
+            return BTRERR_BAUDRATE;
+        given |= flag;
+        switch (k) {
+            case KEY_F_CLOCK: bitrate->btr.frequency = (int32_t)number; break;
+            case KEY_F_CLOCK_MHZ: bitrate->btr.frequency = (int32_t)(number * 1000000L); break;
+            case KEY_NOM_BRP: bitrate->btr.nominal.brp = (uint16_t)number; break;
+            case KEY_NOM_TSEG1: bitrate->btr.nominal.tseg1 = (uint16_t)number; break;
+            case KEY_NOM_TSEG2: bitrate->btr.nominal.tseg2 = (uint16_t)number; break;
+            case KEY_NOM_SJW: bitrate->btr.nominal.sjw = (uint16_t)number; break;
+            case KEY_NOM_SAM: bitrate->btr.nominal.sam = (uint8_t)number; *sam = true; break;
 #if (OPTION_CAN_2_0_ONLY == OPTION_DISABLED)
-        // data_brp: 0..UINT16_MAX
-        else if (!strcmp(key, "data_brp")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.data.brp = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (data_brp++)
-                return BTRERR_BAUDRATE;
-            *data = true;
-        }
-        // data_tseg1: 0..UINT16_MAX
-        else if (!strcmp(key, "data_tseg1")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.data.tseg1 = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (data_tseg1++)
-                return BTRERR_BAUDRATE;
-            *data = true;
-        }
-        // data_tseg2: 0..UINT16_MAX
-        else if (!strcmp(key, "data_tseg2")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.data.tseg2 = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (data_tseg2++)
-                return BTRERR_BAUDRATE;
-            *data = true;
-        }
-        // data_sjw: 0..UINT16_MAX
-        else if (!strcmp(key, "data_sjw")) {
-            if ((0L <= number) && (number <= (long)UINT16_MAX))
-                bitrate->btr.data.sjw = (uint16_t)number;
-            else
-                return BTRERR_BAUDRATE;
-            if (data_sjw++)
-                return BTRERR_BAUDRATE;
-            *data = true;
-        }
+            case KEY_DATA_BRP: bitrate->btr.data.brp = (uint16_t)number; *data = true; break;
+            case KEY_DATA_TSEG1: bitrate->btr.data.tseg1 = (uint16_t)number; *data = true; break;
+            case KEY_DATA_TSEG2: bitrate->btr.data.tseg2 = (uint16_t)number; *data = true; break;
+            case KEY_DATA_SJW: bitrate->btr.data.sjw = (uint16_t)number; *data = true; break;
 #endif
-        else {
-            // unknown key
-            return BTRERR_BAUDRATE;
+            default: return BTRERR_BAUDRATE;
         }
     }
     // note: if the frequency is less or equal 0 then it will be
@@ -710,43 +838,123 @@ static int scan_bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool
     return BTRERR_NOERROR;
 }
 
-static char *scan_key(char *str) {
-    char *ptr = str;
-    assert(str);
+static int find_key(const char *key, size_t length) {
+    int k;
 
-    while (('a' <= *ptr && *ptr <= 'z') || (*ptr == '_') || ('0' <= *ptr && *ptr <= '9') || ('A' <= *ptr && *ptr <= 'Z'))
-        ptr++;
-    while (*ptr == ' ')
-        *ptr++ = '\0';
-    if ((*ptr != '='))
-        return NULL;
-    *ptr++ = '\0';
-    return ptr;
-}
+    assert(key);
 
-static char *scan_value(char *str) {
-    char *ptr = str;
-    assert(str);
-
-    while ('0' <= *ptr && *ptr <= '9')
-        ptr++;
-    while (*ptr == ' ')
-        *ptr++ = '\0';
-    if ((*ptr != ',') && (*ptr != '\0'))
-        return NULL;
-    if (*ptr != '\0')
-        *ptr++ = '\0';
-    return ptr;
+    for (k = 0; k < (int)NUM_KEYS; k++) {
+        if ((keys[k].length == length) && !memcmp(keys[k].name, key, length))
+            return k;
+    }
+    return -1;
 }
 
-static char *skip_blanks(char *str) {
-    char *ptr = str;
+static void solve_bitrate(const btr_limits_t *limits, const btr_target_t *target, solution_t *solution) {
+    btr_candidate_t candidate;          // candidate to be ranked
+    uint32_t ntq_min = 1u + limits->tseg1_min + limits->tseg2_min;
+    uint32_t ntq_max = 1u + limits->tseg1_max + limits->tseg2_max;
+    uint64_t quanta;                    // time quanta per bit
+    uint32_t brp, ntq;                  // prescaler and time quanta
+    size_t i;                           // index of the ranking
+
+    assert(limits && target && solution);
+
+    solution->limits = *limits;
+    solution->target = *target;
+    solution->count = 0U;
+
+    // bit-rate = frequency / (brp * (1 + tseg1 + tseg2))
+    for (brp = limits->brp_min; brp <= limits->brp_max; brp++) {
+        quanta = (uint64_t)limits->frequency / ((uint64_t)brp * (uint64_t)target->bitrate);
+        if ((quanta + 1u) < ntq_min)    // the more prescaler, the less time quanta
+            break;
+        // the number of time quanta next to the bit-rate (below and above)
+        for (ntq = (uint32_t)quanta; ntq <= (uint32_t)quanta + 1u; ntq++) {
+            if ((ntq < ntq_min) || (ntq_max < ntq))
+                continue;
+            if (!split_quanta(limits, target, brp, ntq, &candidate))
+                continue;
+            // insert the candidate into the ranking (best first)
+            i = solution->count;
+            if ((i == BTR_SOLVER_CANDIDATES) &&
+                (compare_candidates(&candidate, &solution->candidate[i - 1U]) >= 0))
+                continue;
+            if (i == BTR_SOLVER_CANDIDATES)
+                i--;
+            else
+                solution->count++;
+            while ((i > 0U) && (compare_candidates(&candidate, &solution->candidate[i - 1U]) < 0)) {
+                solution->candidate[i] = solution->candidate[i - 1U];
+                i--;
+            }
+            solution->candidate[i] = candidate;
+        }
+    }
+}
 
-    assert(str);
+static bool split_quanta(const btr_limits_t *limits, const btr_target_t *target, uint32_t brp, uint32_t ntq, btr_candidate_t *candidate) {
+    int64_t actual = (int64_t)brp * (int64_t)ntq * (int64_t)target->bitrate;
+    int64_t error = (((int64_t)limits->frequency - actual) * 1000000) / actual;
+    uint32_t tseg1, tseg2, sjw;         // bit-timing segments
+
+    assert(limits && target && candidate);
+
+    // (1) bit-rate error in [ppm]
+    if (ABS(error) > (int64_t)target->tolerance)
+        return false;
+    // (2) sample-point = (1 + tseg1) / (1 + tseg1 + tseg2)
+    tseg1 = ((ntq * (uint32_t)target->samplepoint + 5000u) / 10000u);
+    tseg1 = (tseg1 > 1u) ? (tseg1 - 1u) : 0u;
+    if (tseg1 < limits->tseg1_min) tseg1 = limits->tseg1_min;
+    if (tseg1 > limits->tseg1_max) tseg1 = limits->tseg1_max;
+    if ((tseg1 + 1u) >= ntq)
+        return false;
+    tseg2 = ntq - 1u - tseg1;
+    if ((tseg2 < limits->tseg2_min) || (limits->tseg2_max < tseg2)) {
+        tseg2 = (tseg2 < limits->tseg2_min) ? limits->tseg2_min : limits->tseg2_max;
+        if ((tseg2 + 1u) >= ntq)
+            return false;
+        tseg1 = ntq - 1u - tseg2;
+        if ((tseg1 < limits->tseg1_min) || (limits->tseg1_max < tseg1))
+            return false;
+    }
+    // (3) synchronization jump width (SJW <= TSEG2)
+    if (target->sjw == BTR_SJW_MAXIMUM)
+        sjw = (tseg2 < limits->sjw_max) ? tseg2 : limits->sjw_max;
+    else
+        sjw = target->sjw;
+    if ((sjw < limits->sjw_min) || (limits->sjw_max < sjw) || (tseg2 < sjw))
+        return false;
+
+    candidate->brp = (uint16_t)brp;
+    candidate->tseg1 = (uint16_t)tseg1;
+    candidate->tseg2 = (uint16_t)tseg2;
+    candidate->sjw = (uint16_t)sjw;
+    candidate->bitrate_error = (int32_t)error;
+    candidate->samplepoint_error = (int32_t)((((1u + tseg1) * 10000u) + (ntq / 2u)) / ntq) - (int32_t)target->samplepoint;
+    return true;
+}
 
-    while (*ptr == ' ')
-        *ptr++ = '\0';
-    return ptr;
+static int compare_candidates(const btr_candidate_t *candidate1, const btr_candidate_t *candidate2) {
+    int32_t error1, error2;             // errors to be compared
+
+    assert(candidate1 && candidate2);
+
+    // (1) the smaller bit-rate error
+    error1 = ABS(candidate1->bitrate_error);
+    error2 = ABS(candidate2->bitrate_error);
+    if (error1 != error2)
+        return (error1 < error2) ? -1 : +1;
+    // (2) the smaller sample-point error
+    error1 = ABS(candidate1->samplepoint_error);
+    error2 = ABS(candidate2->samplepoint_error);
+    if (error1 != error2)
+        return (error1 < error2) ? -1 : +1;
+    // (3) the more time quanta per bit (i.e. the smaller prescaler)
+    if (candidate1->brp != candidate2->brp)
+        return (candidate1->brp < candidate2->brp) ? -1 : +1;
+    return 0;
 }
 
 /** @}
@@ -266,6 +266,34 @@ extern "C" {
 #define BTR_SJA1000_ENTRIES       10  /**< number of predifined SJA1000 bit-rates */
  /** @} */
 
+/** @name  Bit-timing Solver
+ *  @brief Settings of the bit-timing solver
+ *  @{ */
+#define BTR_SOLVER_CANDIDATES     64  /**< max. number of candidates per solution (best first) */
+#define BTR_SOLVER_ENTRIES        16  /**< number of solutions kept in the cache */
+#define BTR_SJW_MAXIMUM           0u  /**< SJW policy: as large as possible (up to TSEG2) */
+/** @} */
+
+/** @name  Bit-timing Limits
+ *  @brief Initializers for the bit-timing limits of a CAN controller
+ *  @{ */
+#define BTR_NOMINAL_LIMITS(freq)  { (int32_t)(freq), \
+                                    BTR_NOMINAL_BRP_MIN, BTR_NOMINAL_BRP_MAX, \
+                                    BTR_NOMINAL_TSEG1_MIN, BTR_NOMINAL_TSEG1_MAX, \
+                                    BTR_NOMINAL_TSEG2_MIN, BTR_NOMINAL_TSEG2_MAX, \
+                                    BTR_NOMINAL_SJW_MIN, BTR_NOMINAL_SJW_MAX }
+#define BTR_DATA_LIMITS(freq)     { (int32_t)(freq), \
+                                    BTR_DATA_BRP_MIN, BTR_DATA_BRP_MAX, \
+                                    BTR_DATA_TSEG1_MIN, BTR_DATA_TSEG1_MAX, \
+                                    BTR_DATA_TSEG2_MIN, BTR_DATA_TSEG2_MAX, \
+                                    BTR_DATA_SJW_MIN, BTR_DATA_SJW_MAX }
+#define BTR_SJA1000_LIMITS        { (int32_t)(BTR_FREQ_SJA1000), \
+                                    BTR_SJA1000_BRP_MIN, BTR_SJA1000_BRP_MAX, \
+                                    BTR_SJA1000_TSEG1_MIN, BTR_SJA1000_TSEG1_MAX, \
+                                    BTR_SJA1000_TSEG2_MIN, BTR_SJA1000_TSEG2_MAX, \
+                                    BTR_SJA1000_SJW_MIN, BTR_SJA1000_SJW_MAX }
+/** @} */
+
 /*  -----------  types  --------------------------------------------------
  */
 
@@ -332,6 +360,40 @@ typedef char* btr_string_t;
  */
 typedef uint16_t btr_sja1000_t;
 
+/** @brief       Bit-timing limits of a CAN controller (clock and register ranges)
+ */
+typedef struct btr_limits_tag {
+    int32_t frequency;                  /**< controller clock (frequency in [Hz]) */
+    uint16_t brp_min;                   /**< min. bit-rate prescaler */
+    uint16_t brp_max;                   /**< max. bit-rate prescaler */
+    uint16_t tseg1_min;                 /**< min. time segment 1 (before SP) */
+    uint16_t tseg1_max;                 /**< max. time segment 1 (before SP) */
+    uint16_t tseg2_min;                 /**< min. time segment 2 (after SP) */
+    uint16_t tseg2_max;                 /**< max. time segment 2 (after SP) */
+    uint16_t sjw_min;                   /**< min. synchronization jump width */
+    uint16_t sjw_max;                   /**< max. synchronization jump width */
+} btr_limits_t;
+
+/** @brief       Target of the bit-timing solver (bit-rate and sample-point)
+ */
+typedef struct btr_target_tag {
+    uint32_t bitrate;                   /**< bit-rate in [Bit/s] */
+    uint16_t samplepoint;               /**< sample-point in [0.01%] (e.g. 8750 = 87.5%) */
+    uint16_t sjw;                       /**< SJW policy: BTR_SJW_MAXIMUM or a fixed value */
+    uint32_t tolerance;                 /**< max. deviation from the bit-rate in [ppm] (0 = exact) */
+} btr_target_t;
+
+/** @brief       Candidate of the bit-timing solver (register values and errors)
+ */
+typedef struct btr_candidate_tag {
+    uint16_t brp;                       /**< bit-rate prescaler */
+    uint16_t tseg1;                     /**< time segment 1 (before SP) */
+    uint16_t tseg2;                     /**< time segment 2 (after SP) */
+    uint16_t sjw;                       /**< synchronization jump width */
+    int32_t bitrate_error;              /**< deviation from the target bit-rate in [ppm] */
+    int32_t samplepoint_error;          /**< deviation from the target sample-point in [0.01%] */
+} btr_candidate_t;
+
 
 /*  -----------  variables  ----------------------------------------------
  */
@@ -514,6 +576,10 @@ int btr_string2bitrate(const btr_string_t string, btr_bitrate_t *bitrate, bool *
  *  @note        The given bit-rate settings are not checked for validity.
  *               However, an invalid index will result in an error.
  *
+ *  @note        The function is the inverse of 'btr_string2bitrate': the
+ *               printed string is parsed back into the same bit-rate settings.
+ *               If the buffer is too small, the string is truncated.
+ *
  *  @param[in]   bitrate - bit-rate settings or index to predefined bit-rate
  *  @param[in]   data    - flag to print also CAN FD data phase key/value pairs
  *  @param[in]   sam     - flag to print also CAN 2.0 'nom_sam' key/value pair
@@ -599,6 +665,66 @@ int btr_bitrate2sja1000(const btr_bitrate_t *bitrate, btr_sja1000_t *btr0btr1);
 int btr_index2sja1000(const btr_index_t index, btr_sja1000_t *btr0btr1);
 
 
+/** @brief       searches for bit-timing settings of a CAN controller which
+ *               meet the given bit-rate and sample-point.
+ *
+ *               For every bit-rate prescaler within the limits the number of
+ *               time quanta per bit is determined, and the time quanta are
+ *               split into TSEG1 and TSEG2 such that the sample-point is as
+ *               close as possible to the target. The valid candidates are
+ *               ranked by their bit-rate error, then by their sample-point
+ *               error, then by their number of time quanta (more is better).
+ *
+ *  @note        The solutions are cached per controller and target, so that
+ *               a repeated search costs a lookup only (thread-safe).
+ *
+ *  @note        SJW policy: with BTR_SJW_MAXIMUM the SJW is set as large as
+ *               possible (min. of TSEG2 and max. SJW), otherwise the given
+ *               value is used and candidates with TSEG2 < SJW are dropped.
+ *
+ *  @param[in]     limits     - bit-timing limits of the CAN controller
+ *  @param[in]     target     - bit-rate and sample-point to be met
+ *  @param[out]    candidates - array for the candidates (best first)
+ *  @param[in,out] count      - size of the array / number of candidates
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      BTRERR_BAUDRATE - no candidate found (count is set to 0)
+ *  @retval      BTRERR_ILLPARA  - invalid limits, target or array size given
+ *  @retval      BTRERR_NULLPTR  - null-pointer assignment
+ */
+int btr_solve_bitrate(const btr_limits_t *limits, const btr_target_t *target, btr_candidate_t *candidates, size_t *count);
+
+
+/** @brief       searches for the best bit-rate settings for the given CAN
+ *               controller clock, nominal bit-rate and (optionally) data
+ *               bit-rate, within the CAN API V3 limits.
+ *
+ *  @note        If no data phase target is given (NULL), the fields for the
+ *               data phase are set to zero (CAN 2.0 or CAN FD without BRS).
+ *
+ *  @param[in]   frequency - controller clock (frequency in [Hz])
+ *  @param[in]   nominal   - nominal bit-rate and sample-point
+ *  @param[in]   data      - data bit-rate and sample-point (or NULL)
+ *  @param[out]  bitrate   - bit-rate settings
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      BTRERR_BAUDRATE - no candidate found
+ *  @retval      BTRERR_ILLPARA  - invalid frequency or target given
+ *  @retval      BTRERR_NOTSUPP  - data phase w/ CAN 2.0 frame format only
+ *  @retval      BTRERR_NULLPTR  - null-pointer assignment
+ */
+int btr_find_bitrate(int32_t frequency, const btr_target_t *nominal, const btr_target_t *data, btr_bitrate_t *bitrate);
+
+
+/** @brief       removes all solutions from the cache of the bit-timing solver.
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ */
+int btr_flush_solutions(void);
+
+
 #ifdef __cplusplus
 }
 #endif
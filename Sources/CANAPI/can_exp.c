@@ -0,0 +1,757 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Message Exporter)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_exp.c
+ *
+ *  @brief       CAN Message Exporter (candump, ASC and BLF log files)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @addtogroup  can_exp
+ *  @{
+ */
+
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_exp.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define NSEC_PER_SEC  1000000000ULL
+#define NSEC_PER_USEC  1000L
+
+#define LINE_MAX_LENGTH  512U           /* longest line: ASC CAN FD frame */
+
+#define PUT_TEXT(ptr, text)  (memcpy(ptr, text, sizeof(text) - 1U), (ptr) + (sizeof(text) - 1U))
+
+#define CAN_ERR_FLAG  0x20000000U       /* SocketCAN: error frame */
+
+#define ASC_SYMBOLIC_NAME  32U          /* width of the symbolic name */
+
+#define BLF_FILE_HEADER  144U           /* size of the file header */
+#define BLF_OBJECT_HEADER  32U          /* size of the object header (V1) */
+#define BLF_CONTAINER_HEADER  32U       /* size of the log container header */
+#define BLF_OBJECT_MAX  (BLF_OBJECT_HEADER + 40U + 64U)
+#define BLF_CAN_MESSAGE  1U             /* object type: CAN message */
+#define BLF_LOG_CONTAINER  10U          /* object type: log container */
+#define BLF_CAN_ERROR_EXT  73U          /* object type: CAN error frame */
+#define BLF_CAN_FD_MESSAGE_64  101U     /* object type: CAN FD message */
+#define BLF_ZLIB_DEFLATE  2U            /* compression method: zlib */
+#define BLF_TIME_ONE_NANS  2U           /* object flag: time-stamp in [ns] */
+#define BLF_ID_XTD  0x80000000U         /* CAN identifier: extended format */
+#define BLF_MSG_RTR  0x80U              /* CAN message: remote frame */
+#define BLF_FD_RTR  0x0010U             /* CAN FD message: remote frame */
+#define BLF_FD_EDL  0x1000U             /* CAN FD message: CAN FD format */
+#define BLF_FD_BRS  0x2000U             /* CAN FD message: bit-rate switching */
+#define BLF_FD_ESI  0x4000U             /* CAN FD message: error state indicator */
+
+#if (OPTION_CAN_2_0_ONLY == 0)
+#define IS_FDF(msg)  ((msg)->fdf)
+#define IS_BRS(msg)  ((msg)->brs)
+#define IS_ESI(msg)  ((msg)->esi)
+#else
+#define IS_FDF(msg)  0
+#define IS_BRS(msg)  0
+#define IS_ESI(msg)  0
+#endif
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+struct exp_exporter_t_ {                /* exporter: */
+    int fd;                             /*   file descriptor */
+    bool seekable;                      /*   regular file (BLF: header update) */
+    exp_options_t options;              /*   format, time-stamps, channel, name */
+    uint8_t *buffer;                    /*   output buffer (BLF: log container) */
+    size_t used;                        /*   number of bytes in the buffer */
+    size_t limit;                       /*   flush threshold of the buffer */
+    uint8_t *zbuffer;                   /*   BLF: compressed log container */
+    size_t zsize;                       /*   BLF: size of the compression buffer */
+    char prefix[EXP_NAME_LENGTH + 2U];  /*   candump: " <interface> " */
+    size_t prefix_length;               /*   candump: length of the prefix */
+    bool started;                       /*   first message exported */
+    msg_timestamp_t laststamp;          /*   time-stamp reference (ZERO, REL) */
+    msg_timestamp_t first;              /*   time-stamp of the first message */
+    msg_timestamp_t last;               /*   time-stamp of the last message */
+    uint64_t objects;                   /*   BLF: number of objects */
+    uint64_t uncompressed;              /*   BLF: uncompressed file size */
+    exp_stats_t stats;                  /*   statistics */
+};
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static char *put_hex(char *ptr, uint32_t value, int digits);
+static char *put_id(char *ptr, const exp_message_t *message);
+static char *put_dec(char *ptr, uint64_t value, int width, char fill);
+static char *put_bytes(char *ptr, const uint8_t *data, size_t length, bool blank);
+static char *put_spaces(char *ptr, int count);
+
+static void put_u16(uint8_t *ptr, uint16_t value);
+static void put_u32(uint8_t *ptr, uint32_t value);
+static void put_u64(uint8_t *ptr, uint64_t value);
+
+static size_t data_length(const exp_message_t *message);
+
+static char *candump_line(exp_exporter_t exporter, const exp_message_t *message, char *ptr);
+static char *asc_line(exp_exporter_t exporter, const exp_message_t *message, char *ptr);
+static char *asc_date(const msg_timestamp_t *timestamp, char *ptr);
+static char *asc_header(exp_exporter_t exporter, char *ptr);
+static uint8_t *blf_object(exp_exporter_t exporter, const exp_message_t *message, uint8_t *ptr);
+static void blf_header(exp_exporter_t exporter, uint8_t *header);
+static void blf_systemtime(const msg_timestamp_t *timestamp, uint8_t *ptr);
+
+static int write_buffer(exp_exporter_t exporter);
+static int write_container(exp_exporter_t exporter);
+static int write_all(int fd, const uint8_t *buffer, size_t length);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+static const uint8_t dlc_table[16] = {
+    0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U
+};
+
+static const char hex_digits[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+int exp_format_from_path(const char *path) {
+    const char *ext;
+
+    if (!path)
+        return EXPERR_NULLPTR;
+    if ((ext = strrchr(path, '.')) == NULL)
+        return EXPERR_ILLPARA;
+    if (!strcasecmp(ext, ".log"))
+        return (int)EXP_FORMAT_CANDUMP;
+    if (!strcasecmp(ext, ".asc"))
+        return (int)EXP_FORMAT_ASC;
+    if (!strcasecmp(ext, ".blf"))
+        return (int)EXP_FORMAT_BLF;
+    return EXPERR_ILLPARA;
+}
+
+int exp_exporter_create(exp_exporter_t *exporter, const char *path, const exp_options_t *options) {
+    exp_exporter_t self;
+    struct stat st;
+    size_t length;
+
+    if (!exporter || !path || !options)
+        return EXPERR_NULLPTR;
+    if ((options->format != EXP_FORMAT_CANDUMP) && (options->format != EXP_FORMAT_ASC) &&
+        (options->format != EXP_FORMAT_BLF))
+        return EXPERR_ILLPARA;
+    if ((options->time_stamp != MSG_FMT_TIMESTAMP_ZERO) && (options->time_stamp != MSG_FMT_TIMESTAMP_ABSOLUTE) &&
+        (options->time_stamp != MSG_FMT_TIMESTAMP_RELATIVE))
+        return EXPERR_ILLPARA;
+
+    if ((self = (exp_exporter_t)calloc(1U, sizeof(struct exp_exporter_t_))) == NULL)
+        return EXPERR_RESOURCE;
+    memcpy(&self->options, options, sizeof(exp_options_t));
+    self->options.interface[EXP_NAME_LENGTH - 1U] = '\0';
+    if (self->options.channel == 0U)
+        self->options.channel = 1U;
+    if (self->options.interface[0] == '\0')
+        strcpy(self->options.interface, "can0");
+    length = strlen(self->options.interface);
+    self->prefix[0] = ' ';
+    memcpy(&self->prefix[1], self->options.interface, length);
+    self->prefix[length + 1U] = ' ';
+    self->prefix_length = length + 2U;
+
+    /* text: output buffer with space for one more line,
+     * BLF: log container and its compressed image */
+    if (self->options.format != EXP_FORMAT_BLF) {
+        self->limit = EXP_BUFFER_SIZE - LINE_MAX_LENGTH;
+        self->buffer = (uint8_t*)malloc(EXP_BUFFER_SIZE);
+    } else {
+        self->limit = EXP_CONTAINER_SIZE - BLF_OBJECT_MAX;
+        self->buffer = (uint8_t*)malloc(EXP_CONTAINER_SIZE);
+        self->zsize = (size_t)compressBound((uLong)EXP_CONTAINER_SIZE);
+        self->zbuffer = (uint8_t*)malloc(BLF_CONTAINER_HEADER + self->zsize + 4U);
+    }
+    if (!self->buffer || ((self->options.format == EXP_FORMAT_BLF) && !self->zbuffer)) {
+        free(self->zbuffer);
+        free(self->buffer);
+        free(self);
+        return EXPERR_RESOURCE;
+    }
+    /* the log file (or the standard output) */
+    if (strcmp(path, "-") != 0) {
+        if ((self->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+            free(self->zbuffer);
+            free(self->buffer);
+            free(self);
+            return EXPERR_IO;
+        }
+        self->seekable = (fstat(self->fd, &st) == 0) && S_ISREG(st.st_mode);
+    } else {
+        self->fd = STDOUT_FILENO;
+        self->seekable = false;
+    }
+    /* BLF: preliminary file header (completed on close) */
+    if (self->options.format == EXP_FORMAT_BLF) {
+        uint8_t header[BLF_FILE_HEADER];
+        self->uncompressed = BLF_FILE_HEADER;
+        blf_header(self, header);
+        if (write_all(self->fd, header, BLF_FILE_HEADER) != EXPERR_NOERROR) {
+            if (self->fd != STDOUT_FILENO)
+                (void)close(self->fd);
+            free(self->zbuffer);
+            free(self->buffer);
+            free(self);
+            return EXPERR_IO;
+        }
+        self->stats.bytes = BLF_FILE_HEADER;
+    }
+    *exporter = self;
+    return EXPERR_NOERROR;
+}
+
+int exp_exporter_write(exp_exporter_t exporter, const exp_message_t *messages, size_t count) {
+    size_t i;
+    int rc;
+
+    if (!exporter || (!messages && count))
+        return EXPERR_NULLPTR;
+
+    for (i = 0U; i < count; i++) {
+        if (!exporter->started) {
+            exporter->first = messages[i].timestamp;
+            exporter->started = true;
+            if (exporter->options.format == EXP_FORMAT_ASC)
+                exporter->used = (size_t)(asc_header(exporter, (char*)exporter->buffer) - (char*)exporter->buffer);
+        }
+        exporter->last = messages[i].timestamp;
+        switch (exporter->options.format) {
+        case EXP_FORMAT_CANDUMP:
+            exporter->used = (size_t)(candump_line(exporter, &messages[i], (char*)&exporter->buffer[exporter->used]) -
+                                      (char*)exporter->buffer);
+            break;
+        case EXP_FORMAT_ASC:
+            exporter->used = (size_t)(asc_line(exporter, &messages[i], (char*)&exporter->buffer[exporter->used]) -
+                                      (char*)exporter->buffer);
+            break;
+        case EXP_FORMAT_BLF:
+            exporter->used = (size_t)(blf_object(exporter, &messages[i], &exporter->buffer[exporter->used]) -
+                                      exporter->buffer);
+            exporter->objects++;
+            break;
+        }
+        exporter->stats.messages++;
+        if (exporter->used > exporter->limit) {
+            rc = (exporter->options.format == EXP_FORMAT_BLF) ? write_container(exporter) : write_buffer(exporter);
+            if (rc != EXPERR_NOERROR)
+                return rc;
+        }
+    }
+    return EXPERR_NOERROR;
+}
+
+int exp_exporter_flush(exp_exporter_t exporter) {
+    if (!exporter)
+        return EXPERR_NULLPTR;
+
+    return (exporter->options.format == EXP_FORMAT_BLF) ? write_container(exporter) : write_buffer(exporter);
+}
+
+int exp_exporter_stats(exp_exporter_t exporter, exp_stats_t *stats) {
+    if (!exporter || !stats)
+        return EXPERR_NULLPTR;
+
+    memcpy(stats, &exporter->stats, sizeof(exp_stats_t));
+    return EXPERR_NOERROR;
+}
+
+int exp_exporter_close(exp_exporter_t exporter) {
+    uint8_t header[BLF_FILE_HEADER];
+    char *ptr;
+    int rc;
+
+    if (!exporter)
+        return EXPERR_NULLPTR;
+
+    switch (exporter->options.format) {
+    case EXP_FORMAT_ASC:
+        /* note: an empty log gets the current time as start date */
+        if (!exporter->started) {
+            struct timespec now;
+            (void)clock_gettime(CLOCK_REALTIME, &now);
+            exporter->first.tv_sec = now.tv_sec;
+            exporter->first.tv_nsec = now.tv_nsec;
+            exporter->started = true;
+            exporter->used = (size_t)(asc_header(exporter, (char*)exporter->buffer) - (char*)exporter->buffer);
+        }
+        ptr = PUT_TEXT((char*)&exporter->buffer[exporter->used], "End TriggerBlock\n");
+        exporter->used = (size_t)(ptr - (char*)exporter->buffer);
+        rc = write_buffer(exporter);
+        break;
+    case EXP_FORMAT_BLF:
+        /* the file header is completed when the file is seekable */
+        if (((rc = write_container(exporter)) == EXPERR_NOERROR) && exporter->seekable) {
+            blf_header(exporter, header);
+            if (pwrite(exporter->fd, header, BLF_FILE_HEADER, 0) != (ssize_t)BLF_FILE_HEADER)
+                rc = EXPERR_IO;
+        }
+        break;
+    default:
+        rc = write_buffer(exporter);
+        break;
+    }
+    if (exporter->fd != STDOUT_FILENO)
+        (void)close(exporter->fd);
+    free(exporter->zbuffer);
+    free(exporter->buffer);
+    free(exporter);
+    return rc;
+}
+
+/*  - - - - - -  text formatting  - - - - - - - - - - - - - - - - - - - -
+ */
+
+static char *put_hex(char *ptr, uint32_t value, int digits) {
+    int i;
+
+    for (i = digits - 1; i >= 0; i--) {
+        ptr[i] = hex_digits[value & 0xFU];
+        value >>= 4;
+    }
+    return ptr + digits;
+}
+
+static char *put_id(char *ptr, const exp_message_t *message) {
+    uint32_t id = message->xtd ? (message->id & CAN_MAX_XTD_ID) : (message->id & CAN_MAX_STD_ID);
+    int digits = 1;
+
+    /* note: without leading zeros, extended identifiers with suffix 'x' */
+    while ((digits < 8) && (id >> (4 * digits)))
+        digits++;
+    ptr = put_hex(ptr, id, digits);
+    if (message->xtd)
+        *ptr++ = 'x';
+    return ptr;
+}
+
+static char *put_dec(char *ptr, uint64_t value, int width, char fill) {
+    char digits[20];
+    int n = 0;
+
+    do {
+        digits[n++] = (char)('0' + (value % 10U));
+        value /= 10U;
+    } while (value && (n < 20));
+    while (width-- > n)
+        *ptr++ = fill;
+    while (n > 0)
+        *ptr++ = digits[--n];
+    return ptr;
+}
+
+static char *put_bytes(char *ptr, const uint8_t *data, size_t length, bool blank) {
+    size_t i;
+
+    for (i = 0U; i < length; i++) {
+        if (blank)
+            *ptr++ = ' ';
+        *ptr++ = hex_digits[data[i] >> 4];
+        *ptr++ = hex_digits[data[i] & 0xFU];
+    }
+    return ptr;
+}
+
+static char *put_spaces(char *ptr, int count) {
+    while (count-- > 0)
+        *ptr++ = ' ';
+    return ptr;
+}
+
+static size_t data_length(const exp_message_t *message) {
+    if (IS_FDF(message))
+        return (size_t)dlc_table[message->dlc & 0xFU];
+    else
+        return (size_t)((message->dlc < 8U) ? message->dlc : 8U);
+}
+
+/*  - - - - - -  candump  - - - - - - - - - - - - - - - - - - - - - - - -
+ */
+
+static char *candump_line(exp_exporter_t exporter, const exp_message_t *message, char *ptr) {
+    msg_timestamp_t timestamp;
+
+    /* (<sec>.<usec>) <interface> <id>#<data> */
+    timestamp = msg_time_difference(exporter->options.time_stamp, &exporter->laststamp, &message->timestamp);
+    *ptr++ = '(';
+    ptr = put_dec(ptr, (uint64_t)timestamp.tv_sec, 10, '0');
+    *ptr++ = '.';
+    ptr = put_dec(ptr, (uint64_t)(timestamp.tv_nsec / NSEC_PER_USEC), 6, '0');
+    *ptr++ = ')';
+    memcpy(ptr, exporter->prefix, exporter->prefix_length);
+    ptr += exporter->prefix_length;
+
+    if (message->sts) {
+        /* status message: error frame with the status as payload */
+        ptr = put_hex(ptr, CAN_ERR_FLAG, 8);
+        *ptr++ = '#';
+        ptr = put_bytes(ptr, message->data, (message->dlc < 8U) ? message->dlc : 8U, false);
+    } else {
+        if (message->xtd)
+            ptr = put_hex(ptr, message->id & CAN_MAX_XTD_ID, 8);
+        else
+            ptr = put_hex(ptr, message->id & CAN_MAX_STD_ID, 3);
+        *ptr++ = '#';
+        if (IS_FDF(message)) {
+            /* CAN FD: '#' and the flags (BRS = 1, ESI = 2) before the payload */
+            *ptr++ = '#';
+            *ptr++ = hex_digits[(IS_BRS(message) ? 1U : 0U) | (IS_ESI(message) ? 2U : 0U)];
+            ptr = put_bytes(ptr, message->data, data_length(message), false);
+        } else if (message->rtr) {
+            *ptr++ = 'R';
+            if (message->dlc)
+                *ptr++ = hex_digits[message->dlc & 0xFU];
+        } else {
+            ptr = put_bytes(ptr, message->data, data_length(message), false);
+        }
+    }
+    *ptr++ = '\n';
+    return ptr;
+}
+
+/*  - - - - - -  Vector ASCII log file  - - - - - - - - - - - - - - - - -
+ */
+
+static char *asc_date(const msg_timestamp_t *timestamp, char *ptr) {
+    time_t t = (time_t)timestamp->tv_sec;
+    struct tm tm;
+    size_t n;
+
+    /* e.g. 'Thu Oct 19 02:15:42.123 pm 2023' */
+    (void)localtime_r(&t, &tm);
+    n = strftime(ptr, 32U, "%a %b %d %I:%M:%S", &tm);
+    ptr += n;
+    *ptr++ = '.';
+    ptr = put_dec(ptr, (uint64_t)(timestamp->tv_nsec / 1000000L), 3, '0');
+    ptr = (tm.tm_hour < 12) ? PUT_TEXT(ptr, " am ") : PUT_TEXT(ptr, " pm ");
+    ptr = put_dec(ptr, (uint64_t)tm.tm_year + 1900U, 4, '0');
+    return ptr;
+}
+
+static char *asc_header(exp_exporter_t exporter, char *ptr) {
+    ptr = asc_date(&exporter->first, PUT_TEXT(ptr, "date "));
+    if (exporter->options.time_stamp != MSG_FMT_TIMESTAMP_RELATIVE)
+        ptr = PUT_TEXT(ptr, "\nbase hex  timestamps absolute\n");
+    else
+        ptr = PUT_TEXT(ptr, "\nbase hex  timestamps relative\n");
+    ptr = PUT_TEXT(ptr, "internal events logged\n// version 9.0.0\nBegin Triggerblock ");
+    ptr = asc_date(&exporter->first, ptr);
+    return PUT_TEXT(ptr, "\n   0.000000 Start of measurement\n");
+}
+
+static char *asc_line(exp_exporter_t exporter, const exp_message_t *message, char *ptr) {
+    msg_timestamp_t timestamp;
+    size_t length;
+    char *id;
+
+    /* time-stamps are relative to the start date (ABS) or the previous message (REL) */
+    if (exporter->options.time_stamp != MSG_FMT_TIMESTAMP_RELATIVE)
+        timestamp = msg_time_difference(MSG_FMT_TIMESTAMP_ZERO, &exporter->laststamp, &message->timestamp);
+    else
+        timestamp = msg_time_difference(MSG_FMT_TIMESTAMP_RELATIVE, &exporter->laststamp, &message->timestamp);
+    ptr = put_dec(ptr, (uint64_t)timestamp.tv_sec, 4, ' ');
+    *ptr++ = '.';
+    ptr = put_dec(ptr, (uint64_t)(timestamp.tv_nsec / NSEC_PER_USEC), 6, '0');
+    *ptr++ = ' ';
+
+    if (message->sts) {
+        /* <time> <channel>  ErrorFrame */
+        ptr = put_dec(ptr, exporter->options.channel, 0, ' ');
+        return PUT_TEXT(ptr, "  ErrorFrame\n");
+    }
+    if (!IS_FDF(message)) {
+        /* <time> <channel>  <id>[x]  Rx   d <dlc> <data> | r <dlc> */
+        ptr = put_dec(ptr, exporter->options.channel, 0, ' ');
+        *ptr++ = ' ';
+        *ptr++ = ' ';
+        id = ptr;
+        ptr = put_id(ptr, message);
+        ptr = put_spaces(ptr, 16 - (int)(ptr - id));
+        if (!message->rtr) {
+            ptr = PUT_TEXT(ptr, "Rx   d ");
+            *ptr++ = hex_digits[(message->dlc < 8U) ? message->dlc : 8U];
+            ptr = put_bytes(ptr, message->data, data_length(message), true);
+        } else {
+            ptr = PUT_TEXT(ptr, "Rx   r ");
+            *ptr++ = hex_digits[message->dlc & 0xFU];
+        }
+    } else {
+        /* <time> CANFD <channel> Rx <id>[x] <name> <brs> <esi> <dlc> <length> <data>
+         *        <duration> <length> <flags> <crc> <bit-timing (4x)> */
+        length = data_length(message);
+        ptr = put_dec(PUT_TEXT(ptr, "CANFD "), exporter->options.channel, 3, ' ');
+        ptr = PUT_TEXT(ptr, " Rx   ");
+        id = ptr;
+        ptr = put_id(ptr, message);
+        if ((ptr - id) < 8) {               /* right-aligned */
+            int shift = 8 - (int)(ptr - id);
+            memmove(id + shift, id, (size_t)(ptr - id));
+            (void)put_spaces(id, shift);
+            ptr += shift;
+        }
+        ptr = put_spaces(ptr, 2 + ASC_SYMBOLIC_NAME);
+        *ptr++ = ' ';
+        *ptr++ = IS_BRS(message) ? '1' : '0';
+        *ptr++ = ' ';
+        *ptr++ = IS_ESI(message) ? '1' : '0';
+        *ptr++ = ' ';
+        *ptr++ = hex_digits[message->dlc & 0xFU];
+        *ptr++ = ' ';
+        ptr = put_dec(ptr, (uint64_t)length, 2, ' ');
+        ptr = put_bytes(ptr, message->data, length, true);
+        ptr = PUT_TEXT(ptr, "        0    0     ");
+        ptr = put_hex(ptr, BLF_FD_EDL | (IS_BRS(message) ? BLF_FD_BRS : 0U) | (IS_ESI(message) ? BLF_FD_ESI : 0U), 4);
+        ptr = PUT_TEXT(ptr, "        0        0        0        0        0");
+    }
+    *ptr++ = '\n';
+    return ptr;
+}
+
+/*  - - - - - -  Vector binary log file  - - - - - - - - - - - - - - - - -
+ */
+
+static void put_u16(uint8_t *ptr, uint16_t value) {
+    ptr[0] = (uint8_t)value;
+    ptr[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *ptr, uint32_t value) {
+    ptr[0] = (uint8_t)value;
+    ptr[1] = (uint8_t)(value >> 8);
+    ptr[2] = (uint8_t)(value >> 16);
+    ptr[3] = (uint8_t)(value >> 24);
+}
+
+static void put_u64(uint8_t *ptr, uint64_t value) {
+    put_u32(ptr, (uint32_t)value);
+    put_u32(ptr + 4, (uint32_t)(value >> 32));
+}
+
+static uint8_t *blf_object(exp_exporter_t exporter, const exp_message_t *message, uint8_t *ptr) {
+    msg_timestamp_t timestamp;
+    uint32_t type, size, id;
+    size_t length;
+    uint16_t flags;
+
+    /* note: object sizes are a multiple of 4 (no padding between objects) */
+    length = data_length(message);
+    id = message->xtd ? ((message->id & CAN_MAX_XTD_ID) | BLF_ID_XTD) : (message->id & CAN_MAX_STD_ID);
+    if (message->sts) {
+        type = BLF_CAN_ERROR_EXT;
+        size = BLF_OBJECT_HEADER + 32U;
+        memset(&ptr[BLF_OBJECT_HEADER], 0, 32U);
+        put_u16(&ptr[BLF_OBJECT_HEADER + 0U], (uint16_t)exporter->options.channel);
+        ptr[BLF_OBJECT_HEADER + 10U] = (uint8_t)((message->dlc < 8U) ? message->dlc : 8U);
+        memcpy(&ptr[BLF_OBJECT_HEADER + 24U], message->data, (message->dlc < 8U) ? message->dlc : 8U);
+    } else if (!IS_FDF(message)) {
+        type = BLF_CAN_MESSAGE;
+        size = BLF_OBJECT_HEADER + 16U;
+        put_u16(&ptr[BLF_OBJECT_HEADER + 0U], (uint16_t)exporter->options.channel);
+        ptr[BLF_OBJECT_HEADER + 2U] = message->rtr ? BLF_MSG_RTR : 0U;
+        ptr[BLF_OBJECT_HEADER + 3U] = message->dlc;
+        put_u32(&ptr[BLF_OBJECT_HEADER + 4U], id);
+        memset(&ptr[BLF_OBJECT_HEADER + 8U], 0, 8U);
+        memcpy(&ptr[BLF_OBJECT_HEADER + 8U], message->data, message->rtr ? 0U : length);
+    } else {
+        type = BLF_CAN_FD_MESSAGE_64;
+        size = BLF_OBJECT_HEADER + 40U + (((uint32_t)length + 3U) & ~3U);
+        flags = BLF_FD_EDL | (IS_BRS(message) ? BLF_FD_BRS : 0U) | (IS_ESI(message) ? BLF_FD_ESI : 0U);
+        memset(&ptr[BLF_OBJECT_HEADER], 0, size - BLF_OBJECT_HEADER);
+        ptr[BLF_OBJECT_HEADER + 0U] = (uint8_t)exporter->options.channel;
+        ptr[BLF_OBJECT_HEADER + 1U] = message->dlc;
+        ptr[BLF_OBJECT_HEADER + 2U] = (uint8_t)length;
+        put_u32(&ptr[BLF_OBJECT_HEADER + 4U], id);
+        put_u32(&ptr[BLF_OBJECT_HEADER + 12U], flags);
+        memcpy(&ptr[BLF_OBJECT_HEADER + 40U], message->data, length);
+    }
+    /* object header (V1) with the time since the start of the measurement */
+    timestamp = msg_time_difference(MSG_FMT_TIMESTAMP_ZERO, &exporter->laststamp, &message->timestamp);
+    memcpy(&ptr[0], "LOBJ", 4U);
+    put_u16(&ptr[4], (uint16_t)BLF_OBJECT_HEADER);
+    put_u16(&ptr[6], 1U);
+    put_u32(&ptr[8], size);
+    put_u32(&ptr[12], type);
+    put_u32(&ptr[16], BLF_TIME_ONE_NANS);
+    put_u16(&ptr[20], 0U);
+    put_u16(&ptr[22], 0U);
+    put_u64(&ptr[24], ((uint64_t)timestamp.tv_sec * NSEC_PER_SEC) + (uint64_t)timestamp.tv_nsec);
+    return ptr + size;
+}
+
+static void blf_systemtime(const msg_timestamp_t *timestamp, uint8_t *ptr) {
+    time_t t = (time_t)timestamp->tv_sec;
+    struct tm tm;
+
+    (void)localtime_r(&t, &tm);
+    put_u16(&ptr[0], (uint16_t)(tm.tm_year + 1900));
+    put_u16(&ptr[2], (uint16_t)(tm.tm_mon + 1));
+    put_u16(&ptr[4], (uint16_t)tm.tm_wday);
+    put_u16(&ptr[6], (uint16_t)tm.tm_mday);
+    put_u16(&ptr[8], (uint16_t)tm.tm_hour);
+    put_u16(&ptr[10], (uint16_t)tm.tm_min);
+    put_u16(&ptr[12], (uint16_t)tm.tm_sec);
+    put_u16(&ptr[14], (uint16_t)(timestamp->tv_nsec / 1000000L));
+}
+
+static void blf_header(exp_exporter_t exporter, uint8_t *header) {
+    memset(header, 0, BLF_FILE_HEADER);
+    memcpy(&header[0], "LOGG", 4U);
+    put_u32(&header[4], BLF_FILE_HEADER);
+    header[12] = 2U;                    /* binary log version 2.6.8.1 */
+    header[13] = 6U;
+    header[14] = 8U;
+    header[15] = 1U;
+    put_u64(&header[16], exporter->stats.bytes);
+    put_u64(&header[24], exporter->uncompressed);
+    put_u32(&header[32], (uint32_t)exporter->objects);
+    if (exporter->started) {
+        blf_systemtime(&exporter->first, &header[40]);
+        blf_systemtime(&exporter->last, &header[56]);
+    }
+}
+
+/*  - - - - - -  file output  - - - - - - - - - - - - - - - - - - - - - -
+ */
+
+static int write_buffer(exp_exporter_t exporter) {
+    if (exporter->used == 0U)
+        return EXPERR_NOERROR;
+    if (write_all(exporter->fd, exporter->buffer, exporter->used) != EXPERR_NOERROR)
+        return EXPERR_IO;
+    exporter->stats.bytes += (uint64_t)exporter->used;
+    exporter->used = 0U;
+    return EXPERR_NOERROR;
+}
+
+static int write_container(exp_exporter_t exporter) {
+    uLongf length = (uLongf)exporter->zsize;
+    uint32_t size, padding;
+
+    if (exporter->used == 0U)
+        return EXPERR_NOERROR;
+    if (compress2(&exporter->zbuffer[BLF_CONTAINER_HEADER], &length, exporter->buffer,
+                  (uLong)exporter->used, Z_BEST_SPEED) != Z_OK)
+        return EXPERR_COMPRESS;
+    /* note: log containers are padded by (size % 4) bytes */
+    size = BLF_CONTAINER_HEADER + (uint32_t)length;
+    padding = size % 4U;
+    memset(&exporter->zbuffer[0], 0, BLF_CONTAINER_HEADER);
+    memcpy(&exporter->zbuffer[0], "LOBJ", 4U);
+    put_u16(&exporter->zbuffer[4], 16U);
+    put_u16(&exporter->zbuffer[6], 1U);
+    put_u32(&exporter->zbuffer[8], size);
+    put_u32(&exporter->zbuffer[12], BLF_LOG_CONTAINER);
+    put_u16(&exporter->zbuffer[16], BLF_ZLIB_DEFLATE);
+    put_u32(&exporter->zbuffer[24], (uint32_t)exporter->used);
+    memset(&exporter->zbuffer[size], 0, padding);
+    if (write_all(exporter->fd, exporter->zbuffer, size + padding) != EXPERR_NOERROR)
+        return EXPERR_IO;
+    exporter->stats.bytes += (uint64_t)(size + padding);
+    exporter->uncompressed += (uint64_t)(BLF_CONTAINER_HEADER + exporter->used);
+    exporter->used = 0U;
+    return EXPERR_NOERROR;
+}
+
+static int write_all(int fd, const uint8_t *buffer, size_t length) {
+    ssize_t n;
+
+    while (length > 0U) {
+        if ((n = write(fd, buffer, length)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return EXPERR_IO;
+        }
+        buffer += n;
+        length -= (size_t)n;
+    }
+    return EXPERR_NOERROR;
+}
+
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
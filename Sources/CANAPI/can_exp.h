@@ -0,0 +1,265 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Message Exporter)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_exp.h
+ *
+ *  @brief       CAN Message Exporter (candump, ASC and BLF log files)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @defgroup    can_exp CAN Message Exporter
+ *  @{
+ */
+#ifndef CAN_EXP_H_INCLUDED
+#define CAN_EXP_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_msg.h"                    // CAN message (w/ or w/o CAN API V3)
+
+#include <stddef.h>                     // C99 header for size_t
+#include <stdint.h>                     // C99 header for sized integer types
+
+
+/*  -----------  options  ------------------------------------------------
+ */
+
+/** @note  Set define OPTION_CANAPI_COMPANIONS to a non-zero value to compile
+ *         this module in conjunction with the CAN API V3 sources (e.g. in
+ *         the build environment).
+ */
+
+/** @note  The exporter writes a stream of CAN messages (received live or
+ *         read from a capture file, see can_rec.h) directly into one of the
+ *         following log file formats:
+ *
+ *         - candump: the log file format of the SocketCAN can-utils, e.g.
+ *           '(1697702400.123456) can0 123#1122334455667788'
+ *         - ASC: the Vector ASCII log file format (CAN and CAN FD frames)
+ *         - BLF: the Vector binary logging format; the objects are written
+ *           into zlib-compressed log containers (requires libz)
+ *
+ *         The time-stamps are handled as by the message formatter (can_msg.h):
+ *         ZERO = time since the first message, ABS = absolute time-stamp, and
+ *         REL = time since the previous message.  An ASC file always carries
+ *         the time of its first message as start date; its time-stamps are
+ *         absolute (ZERO, ABS) or relative (REL) to it.  The time-stamps of
+ *         a BLF file are always relative to the start of the measurement.
+ *
+ *         Status messages are written as error frames.
+ */
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+/** @name  Buffer Sizes
+ *  @brief Default sizes of the file buffers
+ *  @{ */
+#define EXP_BUFFER_SIZE     (256U * 1024U)  /**< size of the output buffer */
+#define EXP_CONTAINER_SIZE  (128U * 1024U)  /**< size of a BLF log container (uncompressed) */
+#define EXP_NAME_LENGTH            16U  /**< size of the interface name (incl. zero) */
+/** @} */
+
+/** @name  Error Codes
+ *  @brief Error codes of the exporter
+ *  @{ */
+#define EXPERR_NOERROR               0  /**< no error! */
+#define EXPERR_IO                  (-1) /**< file i/o error (see errno) */
+#define EXPERR_COMPRESS            (-2) /**< compression error (zlib) */
+#define EXPERR_RESOURCE           (-90) /**< resource allocation failed */
+#define EXPERR_ILLPARA            (-93) /**< illegal parameter */
+#define EXPERR_NULLPTR            (-94) /**< null-pointer assignment */
+/** @} */
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+/** @brief       CAN Message (with Time-stamp):
+ */
+typedef msg_message_t exp_message_t;
+
+/** @brief       Log File Format: candump, ASC, BLF
+ */
+typedef enum exp_format_t_ {
+    EXP_FORMAT_CANDUMP = 0,             /**< SocketCAN candump log file */
+    EXP_FORMAT_ASC,                     /**< Vector ASCII log file */
+    EXP_FORMAT_BLF                      /**< Vector binary log file */
+} exp_format_t;
+
+/** @brief       Exporter Options:
+ */
+typedef struct exp_options_t_ {
+    exp_format_t format;                /**< log file format */
+    msg_fmt_timestamp_t time_stamp;     /**< time-stamp reference: ZERO, ABS or REL */
+    uint32_t channel;                   /**< channel number (ASC and BLF: 1, 2, ...) */
+    char interface[EXP_NAME_LENGTH];    /**< interface name (candump, e.g. "can0") */
+} exp_options_t;
+
+/** @brief       Exporter Statistics:
+ */
+typedef struct exp_stats_t_ {
+    uint64_t messages;                  /**< number of messages exported */
+    uint64_t bytes;                     /**< number of bytes written */
+} exp_stats_t;
+
+/** @brief       Exporter Handle (opaque):
+ */
+typedef struct exp_exporter_t_ *exp_exporter_t;
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+/** @brief       determines the log file format from the file extension of
+ *               the given path ('.log' = candump, '.asc' = ASC, '.blf' = BLF).
+ *
+ *  @param[in]   path - path of the log file
+ *
+ *  @returns     the log file format (exp_format_t), or a negative value on error.
+ *
+ *  @retval      EXPERR_ILLPARA  - unknown file extension
+ *  @retval      EXPERR_NULLPTR  - null-pointer assignment
+ */
+int exp_format_from_path(const char *path);
+
+/** @brief       creates a log file and an exporter for it.
+ *
+ *  @remarks     If the path is "-" the log is written to the standard output
+ *               (the BLF file header can then not be completed on close).
+ *
+ *  @param[out]  exporter - handle of the exporter
+ *  @param[in]   path     - path of the log file (or "-")
+ *  @param[in]   options  - format, time-stamp reference, channel number and
+ *                          interface name (the latter two may be 0 resp. empty)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      EXPERR_IO       - the file could not be created (see errno)
+ *  @retval      EXPERR_RESOURCE - resource allocation failed
+ *  @retval      EXPERR_ILLPARA  - illegal format or time-stamp reference
+ *  @retval      EXPERR_NULLPTR  - null-pointer assignment
+ */
+int exp_exporter_create(exp_exporter_t *exporter, const char *path, const exp_options_t *options);
+
+/** @brief       exports CAN messages into the log file (buffered).
+ *
+ *  @param[in]   exporter - handle of the exporter
+ *  @param[in]   messages - array of CAN messages
+ *  @param[in]   count    - number of CAN messages
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      EXPERR_IO       - the messages could not be written (see errno)
+ *  @retval      EXPERR_COMPRESS - a log container could not be compressed
+ *  @retval      EXPERR_NULLPTR  - null-pointer assignment
+ */
+int exp_exporter_write(exp_exporter_t exporter, const exp_message_t *messages, size_t count);
+
+/** @brief       writes the buffered output to the log file.
+ *
+ *  @note        For BLF files this closes the current log container.
+ *
+ *  @param[in]   exporter - handle of the exporter
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      EXPERR_IO       - the output could not be written (see errno)
+ *  @retval      EXPERR_COMPRESS - the log container could not be compressed
+ *  @retval      EXPERR_NULLPTR  - null-pointer assignment
+ */
+int exp_exporter_flush(exp_exporter_t exporter);
+
+/** @brief       retrieves the statistics of the exporter.
+ *
+ *  @param[in]   exporter - handle of the exporter
+ *  @param[out]  stats    - number of messages and bytes written
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      EXPERR_NULLPTR  - null-pointer assignment
+ */
+int exp_exporter_stats(exp_exporter_t exporter, exp_stats_t *stats);
+
+/** @brief       writes the trailer of the log file (ASC: end of the trigger
+ *               block, BLF: completed file header), closes the log file and
+ *               releases the exporter.
+ *
+ *  @param[in]   exporter - handle of the exporter
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      EXPERR_IO       - the output could not be written (see errno)
+ *  @retval      EXPERR_COMPRESS - the log container could not be compressed
+ *  @retval      EXPERR_NULLPTR  - null-pointer assignment
+ */
+int exp_exporter_close(exp_exporter_t exporter);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_EXP_H_INCLUDED */
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
@@ -0,0 +1,431 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Latency Meter)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_lat.c
+ *
+ *  @brief       CAN Latency Meter (end-to-end latency, jitter, loss and reordering)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @addtogroup  can_lat
+ *  @{
+ */
+
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_lat.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <time.h>
+#include <inttypes.h>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define NSEC_PER_SEC  1000000000ULL
+#define NSEC_PER_USEC       1000.0
+
+#define VALUE_BITS      32U             /* values are below 2^32 nanoseconds */
+#define SUB_BUCKETS     (1U << LAT_SUB_BUCKET_BITS)
+#define HALF_BUCKETS    (SUB_BUCKETS >> 1)
+#define NUM_BUCKETS     (SUB_BUCKETS + ((VALUE_BITS - LAT_SUB_BUCKET_BITS) * HALF_BUCKETS))
+
+#define TICKS_PER_HALF_DISTANCE  5U     /* .hgrm: percentile steps per halving distance to 100% */
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+typedef struct histogram_t_ {           /* log-linear histogram: */
+    uint64_t count;                     /*   number of values */
+    uint64_t min;                       /*   smallest value */
+    uint64_t max;                       /*   largest value */
+    double sum;                         /*   sum of the values */
+    double squares;                     /*   sum of the squared values */
+    uint64_t bucket[NUM_BUCKETS];       /*   buckets */
+} histogram_t;
+
+struct lat_meter_t_ {                   /* latency meter: */
+    uint32_t next;                      /*   highest sequence number received plus one */
+    uint64_t window;                    /*   frames received below 'next' (bit 0 = next - 1) */
+    bool started;                       /*   at least one frame received */
+    int64_t transit;                    /*   latency of the previous frame in sequence */
+    double jitter;                      /*   jitter estimate (RFC 3550) */
+    uint64_t received;                  /*   number of frames received */
+    uint64_t reordered;                 /*   number of frames received after a later one */
+    uint64_t duplicates;                /*   number of frames received twice (or more) */
+    uint64_t invalid;                   /*   number of payloads without a stamp */
+    histogram_t latency;                /*   latencies */
+    histogram_t delta;                  /*   differences of consecutive latencies */
+};
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static void record(histogram_t *histogram, uint64_t value);
+static uint64_t value_at(const histogram_t *histogram, double percentile);
+static void summarize(const histogram_t *histogram, lat_summary_t *summary);
+static uint32_t bucket_index(uint64_t value);
+static uint64_t highest_value(uint32_t index);
+static const histogram_t *select_histogram(lat_meter_t meter, int histogram);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+uint64_t lat_clock(void) {
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+}
+
+int lat_stamp(uint8_t *data, size_t length, uint32_t sequence, uint64_t time) {
+    if (!data)
+        return LATERR_NULLPTR;
+    if (length < LAT_STAMP_LENGTH)
+        return LATERR_NOSTAMP;
+
+    /* byte 0..3: sequence number, byte 4..7: send time (little endian) */
+    data[0] = (uint8_t)(sequence >> 0);
+    data[1] = (uint8_t)(sequence >> 8);
+    data[2] = (uint8_t)(sequence >> 16);
+    data[3] = (uint8_t)(sequence >> 24);
+    data[4] = (uint8_t)(time >> 0);
+    data[5] = (uint8_t)(time >> 8);
+    data[6] = (uint8_t)(time >> 16);
+    data[7] = (uint8_t)(time >> 24);
+    return LATERR_NOERROR;
+}
+
+int lat_unstamp(const uint8_t *data, size_t length, uint32_t *sequence, uint32_t *time) {
+    if (!data || !sequence || !time)
+        return LATERR_NULLPTR;
+    if (length < LAT_STAMP_LENGTH)
+        return LATERR_NOSTAMP;
+
+    *sequence = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    *time = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+    return LATERR_NOERROR;
+}
+
+int lat_meter_create(lat_meter_t *meter) {
+    lat_meter_t self;
+
+    if (!meter)
+        return LATERR_NULLPTR;
+
+    if ((self = (lat_meter_t)malloc(sizeof(struct lat_meter_t_))) == NULL)
+        return LATERR_RESOURCE;
+    (void)lat_meter_reset(self);
+    *meter = self;
+    return LATERR_NOERROR;
+}
+
+int lat_meter_reset(lat_meter_t meter) {
+    if (!meter)
+        return LATERR_NULLPTR;
+
+    memset(meter, 0, sizeof(struct lat_meter_t_));
+    meter->latency.min = UINT64_MAX;
+    meter->delta.min = UINT64_MAX;
+    return LATERR_NOERROR;
+}
+
+int lat_meter_account(lat_meter_t meter, const uint8_t *data, size_t length, uint64_t time) {
+    uint32_t sequence, sent;
+    int64_t transit, diff;
+    int32_t distance;
+    uint32_t age;
+
+    if (!meter || !data)
+        return LATERR_NULLPTR;
+    if (lat_unstamp(data, length, &sequence, &sent) != LATERR_NOERROR) {
+        meter->invalid++;
+        return LATERR_NOSTAMP;
+    }
+    meter->received++;
+
+    /* latency (modulo 2^32 nanoseconds) */
+    transit = (int64_t)(uint32_t)((uint32_t)time - sent);
+    record(&meter->latency, (uint64_t)transit);
+
+    /* sequence: in order (or with a gap), or below the highest one */
+    distance = (int32_t)(sequence - meter->next);
+    if (!meter->started || (distance >= 0)) {
+        if (!meter->started)
+            meter->window = 0U;
+        else if ((uint32_t)distance + 1U < LAT_REORDER_WINDOW)
+            meter->window <<= ((uint32_t)distance + 1U);
+        else
+            meter->window = 0U;
+        meter->window |= 1U;
+        meter->next = sequence + 1U;
+        /* jitter: difference of consecutive latencies (RFC 3550) */
+        if (meter->started) {
+            diff = transit - meter->transit;
+            if (diff < 0)
+                diff = -diff;
+            record(&meter->delta, (uint64_t)diff);
+            meter->jitter += ((double)diff - meter->jitter) / (double)LAT_JITTER_GAIN;
+        }
+        meter->transit = transit;
+        meter->started = true;
+    } else {
+        age = (uint32_t)(-(distance + 1));  /* 0 = the highest one */
+        if (age < LAT_REORDER_WINDOW) {
+            if (meter->window & ((uint64_t)1U << age))
+                meter->duplicates++;
+            else {
+                meter->window |= ((uint64_t)1U << age);
+                meter->reordered++;
+            }
+        } else {
+            /* note: too old to tell a duplicate from a latecomer */
+            meter->reordered++;
+        }
+    }
+    return LATERR_NOERROR;
+}
+
+int lat_meter_stats(lat_meter_t meter, uint64_t sent, lat_stats_t *stats) {
+    uint64_t distinct;
+
+    if (!meter || !stats)
+        return LATERR_NULLPTR;
+
+    memset(stats, 0, sizeof(lat_stats_t));
+    stats->sent = sent ? sent : (meter->started ? (uint64_t)meter->next : 0U);
+    stats->received = meter->received;
+    stats->reordered = meter->reordered;
+    stats->duplicates = meter->duplicates;
+    stats->invalid = meter->invalid;
+    distinct = meter->received - meter->duplicates;
+    stats->lost = (stats->sent > distinct) ? (stats->sent - distinct) : 0U;
+    stats->jitter = (uint64_t)(meter->jitter + 0.5);
+    summarize(&meter->latency, &stats->latency);
+    summarize(&meter->delta, &stats->delta);
+    return LATERR_NOERROR;
+}
+
+int lat_meter_percentile(lat_meter_t meter, int histogram, double percentile, uint64_t *value) {
+    const histogram_t *h;
+
+    if (!meter || !value)
+        return LATERR_NULLPTR;
+    if ((h = select_histogram(meter, histogram)) == NULL)
+        return LATERR_ILLPARA;
+    if ((percentile < 0.0) || (percentile > 100.0))
+        return LATERR_ILLPARA;
+    if (h->count == 0U)
+        return LATERR_EMPTY;
+
+    *value = value_at(h, percentile);
+    return LATERR_NOERROR;
+}
+
+int lat_meter_distribution(lat_meter_t meter, int histogram, FILE *stream) {
+    const histogram_t *h;
+    double percentile, step, mean = 0.0, deviation = 0.0;
+    uint64_t value, below;
+    uint32_t index, tick, half;
+
+    if (!meter || !stream)
+        return LATERR_NULLPTR;
+    if ((h = select_histogram(meter, histogram)) == NULL)
+        return LATERR_ILLPARA;
+
+    fprintf(stream, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    if (h->count > 0U) {
+        /* percentiles: TICKS_PER_HALF_DISTANCE steps for each halving of the distance to 100% */
+        for (half = 0U, percentile = 0.0; half < 64U; half++) {
+            step = (100.0 - percentile) / 2.0 / (double)TICKS_PER_HALF_DISTANCE;
+            for (tick = 0U; tick < TICKS_PER_HALF_DISTANCE; tick++, percentile += step) {
+                value = value_at(h, percentile);
+                /* number of values up to the bucket of the value */
+                for (index = 0U, below = 0U; index <= bucket_index(value) && index < NUM_BUCKETS; index++)
+                    below += h->bucket[index];
+                fprintf(stream, "%12.3f %14.12f %10" PRIu64 " %14.2f\n",
+                        (double)value / NSEC_PER_USEC, percentile / 100.0, below, 100.0 / (100.0 - percentile));
+            }
+            /* stop when the resolution exceeds the number of values */
+            if ((100.0 - percentile) * (double)h->count < 100.0)
+                break;
+        }
+        fprintf(stream, "%12.3f %14.12f %10" PRIu64 "\n", (double)h->max / NSEC_PER_USEC, 1.0, h->count);
+        mean = h->sum / (double)h->count;
+        deviation = (h->squares / (double)h->count) - (mean * mean);
+        deviation = (deviation > 0.0) ? sqrt(deviation) : 0.0;
+    }
+    fprintf(stream, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean / NSEC_PER_USEC, deviation / NSEC_PER_USEC);
+    fprintf(stream, "#[Max     = %12.3f, Total count    = %12" PRIu64 "]\n", (double)(h->count ? h->max : 0U) / NSEC_PER_USEC, h->count);
+    fprintf(stream, "#[Buckets = %12u, SubBuckets     = %12u]\n", (unsigned)NUM_BUCKETS, (unsigned)SUB_BUCKETS);
+    return LATERR_NOERROR;
+}
+
+int lat_meter_destroy(lat_meter_t meter) {
+    if (!meter)
+        return LATERR_NULLPTR;
+
+    free(meter);
+    return LATERR_NOERROR;
+}
+
+/*  -----------  local functions  ----------------------------------------
+ */
+
+static void record(histogram_t *histogram, uint64_t value) {
+    histogram->bucket[bucket_index(value)]++;
+    histogram->count++;
+    if (value < histogram->min)
+        histogram->min = value;
+    if (value > histogram->max)
+        histogram->max = value;
+    histogram->sum += (double)value;
+    histogram->squares += (double)value * (double)value;
+}
+
+static uint64_t value_at(const histogram_t *histogram, double percentile) {
+    uint64_t target, sum = 0U, value;
+    uint32_t index;
+
+    /* the 0th percentile is the smallest value */
+    if (percentile <= 0.0)
+        return histogram->min;
+    /* the value of the n-th smallest value (n >= 1) */
+    target = (uint64_t)ceil((percentile / 100.0) * (double)histogram->count);
+    if (target < 1U)
+        target = 1U;
+    for (index = 0U; index < NUM_BUCKETS; index++) {
+        sum += histogram->bucket[index];
+        if (sum >= target)
+            break;
+    }
+    value = (index < NUM_BUCKETS) ? highest_value(index) : histogram->max;
+    if (value > histogram->max)
+        value = histogram->max;
+    if (value < histogram->min)
+        value = histogram->min;
+    return value;
+}
+
+static void summarize(const histogram_t *histogram, lat_summary_t *summary) {
+    memset(summary, 0, sizeof(lat_summary_t));
+    if (histogram->count == 0U)
+        return;
+    summary->count = histogram->count;
+    summary->min = histogram->min;
+    summary->max = histogram->max;
+    summary->mean = (uint64_t)(histogram->sum / (double)histogram->count + 0.5);
+    summary->p50 = value_at(histogram, 50.0);
+    summary->p90 = value_at(histogram, 90.0);
+    summary->p99 = value_at(histogram, 99.0);
+    summary->p999 = value_at(histogram, 99.9);
+    summary->p9999 = value_at(histogram, 99.99);
+}
+
+static uint32_t bucket_index(uint64_t value) {
+    uint32_t msb = 0U, shift;
+
+    /* values below SUB_BUCKETS: one bucket per value */
+    if (value < (uint64_t)SUB_BUCKETS)
+        return (uint32_t)value;
+    if (value >= ((uint64_t)1U << VALUE_BITS))
+        return NUM_BUCKETS - 1U;
+    /* otherwise: HALF_BUCKETS buckets per power of two */
+#if defined(__GNUC__) || defined(__clang__)
+    msb = 63U - (uint32_t)__builtin_clzll(value);
+#else
+    for (uint64_t v = value; v > 1U; v >>= 1)
+        msb++;
+#endif
+    shift = msb - LAT_SUB_BUCKET_BITS + 1U;
+    return SUB_BUCKETS + ((shift - 1U) * HALF_BUCKETS) + (uint32_t)((value >> shift) - HALF_BUCKETS);
+}
+
+static uint64_t highest_value(uint32_t index) {
+    uint32_t shift;
+    uint64_t mantissa;
+
+    if (index < SUB_BUCKETS)
+        return (uint64_t)index;
+    shift = ((index - SUB_BUCKETS) / HALF_BUCKETS) + 1U;
+    mantissa = (uint64_t)(((index - SUB_BUCKETS) % HALF_BUCKETS) + HALF_BUCKETS);
+    return ((mantissa + 1U) << shift) - 1U;
+}
+
+static const histogram_t *select_histogram(lat_meter_t meter, int histogram) {
+    switch (histogram) {
+        case LAT_LATENCY: return &meter->latency;
+        case LAT_JITTER: return &meter->delta;
+        default: return NULL;
+    }
+}
+
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
@@ -0,0 +1,322 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Latency Meter)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_lat.h
+ *
+ *  @brief       CAN Latency Meter (end-to-end latency, jitter, loss and reordering)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @defgroup    can_lat CAN Latency Meter
+ *  @{
+ */
+#ifndef CAN_LAT_H_INCLUDED
+#define CAN_LAT_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include <stdio.h>                      // C99 header for FILE
+#include <stddef.h>                     // C99 header for size_t
+#include <stdint.h>                     // C99 header for sized integer types
+
+
+/*  -----------  options  ------------------------------------------------
+ */
+
+/** @note  Set define OPTION_CANAPI_COMPANIONS to a non-zero value to compile
+ *         this module in conjunction with the CAN API V3 sources (e.g. in
+ *         the build environment).
+ */
+
+/** @note  The sender stamps a sequence number and its send time into the
+ *         first LAT_STAMP_LENGTH bytes of the payload (little endian):
+ *         - byte 0..3: sequence number (counting up from 0)
+ *         - byte 4..7: send time from lat_clock() in [nsec] (lower 32 bits)
+ *
+ *         The receiver hands each payload over to the latency meter with
+ *         its receive time (also from lat_clock()).  The latency of a frame
+ *         is the receive time minus the send time (modulo 2^32 nanoseconds,
+ *         so latencies must stay below 4.29 seconds).
+ *
+ *         The inter-arrival jitter is taken from the difference D of the
+ *         latencies of two consecutive frames (RFC 3550): the estimate J is
+ *         updated by J += (|D| - J) / 16.  In addition, |D| is put into a
+ *         histogram of its own.
+ *
+ *         A frame with a sequence number below the highest one received is
+ *         counted as reordered (or as duplicate, if it was received within
+ *         the last LAT_REORDER_WINDOW frames).  Lost frames are the frames
+ *         sent minus the distinct frames received.
+ *
+ *         The histograms are log-linear (like HDR histograms): each power of
+ *         two is divided into 2^(LAT_SUB_BUCKET_BITS-1) buckets, so a value
+ *         is resolved with a relative error below 2^-(LAT_SUB_BUCKET_BITS-1).
+ *
+ *         The latency meter is not thread-safe: the frames must be accounted
+ *         by one thread (the receiver), the statistics are retrieved after it.
+ */
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+/** @name  Latency Meter Limits
+ *  @brief Limits and default values of the latency meter
+ *  @{ */
+#define LAT_STAMP_LENGTH            8U  /**< length of the stamp in the payload (sequence number and send time) */
+#define LAT_SUB_BUCKET_BITS         7U  /**< resolution of the histograms (relative error below 1/64) */
+#define LAT_REORDER_WINDOW         64U  /**< window for the detection of duplicates (in frames) */
+#define LAT_JITTER_GAIN            16U  /**< gain of the jitter estimate (RFC 3550) */
+/** @} */
+
+/** @name  Histogram Selection
+ *  @brief Histograms of the latency meter
+ *  @{ */
+#define LAT_LATENCY                 0   /**< latency (receive time minus send time) */
+#define LAT_JITTER                  1   /**< jitter (difference of consecutive latencies) */
+/** @} */
+
+/** @name  Error Codes
+ *  @brief Error codes of the latency meter
+ *  @{ */
+#define LATERR_NOERROR              0   /**< no error! */
+#define LATERR_NOSTAMP            (-1)  /**< payload too short for a stamp */
+#define LATERR_EMPTY              (-2)  /**< no values in the histogram */
+#define LATERR_RESOURCE           (-90) /**< resource allocation failed */
+#define LATERR_ILLPARA            (-93) /**< illegal parameter */
+#define LATERR_NULLPTR            (-94) /**< null-pointer assignment */
+/** @} */
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+/** @brief       Summary of a Histogram (values in [nsec]):
+ */
+typedef struct lat_summary_t_ {
+    uint64_t count;                     /**< number of values */
+    uint64_t min;                       /**< smallest value */
+    uint64_t max;                       /**< largest value */
+    uint64_t mean;                      /**< arithmetic mean */
+    uint64_t p50;                       /**< median */
+    uint64_t p90;                       /**< 90th percentile */
+    uint64_t p99;                       /**< 99th percentile */
+    uint64_t p999;                      /**< 99.9th percentile */
+    uint64_t p9999;                     /**< 99.99th percentile */
+} lat_summary_t;
+
+/** @brief       Latency Meter Statistics:
+ */
+typedef struct lat_stats_t_ {
+    uint64_t sent;                      /**< number of frames sent (as given to lat_meter_stats) */
+    uint64_t received;                  /**< number of frames received (with a stamp) */
+    uint64_t lost;                      /**< number of frames sent but not received */
+    uint64_t reordered;                 /**< number of frames received after a later one */
+    uint64_t duplicates;                /**< number of frames received twice (or more) */
+    uint64_t invalid;                   /**< number of payloads without a stamp */
+    uint64_t jitter;                    /**< inter-arrival jitter estimate (RFC 3550) in [nsec] */
+    lat_summary_t latency;              /**< latency summary */
+    lat_summary_t delta;                /**< summary of the latency differences |D| */
+} lat_stats_t;
+
+/** @brief       Latency Meter Handle (opaque):
+ */
+typedef struct lat_meter_t_ *lat_meter_t;
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+/** @brief       returns the time of the monotonic clock in nanoseconds (the
+ *               clock for the send time and the receive time of a frame).
+ *
+ *  @returns     monotonic time in [nsec].
+ */
+uint64_t lat_clock(void);
+
+/** @brief       stamps a sequence number and the send time into a payload.
+ *
+ *  @param[out]  data     - payload of the CAN frame
+ *  @param[in]   length   - length of the payload in bytes (at least LAT_STAMP_LENGTH)
+ *  @param[in]   sequence - sequence number of the frame
+ *  @param[in]   time     - send time from lat_clock() in [nsec]
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_NOSTAMP  - payload too short for a stamp
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_stamp(uint8_t *data, size_t length, uint32_t sequence, uint64_t time);
+
+/** @brief       reads the sequence number and the send time from a payload.
+ *
+ *  @param[in]   data     - payload of the CAN frame
+ *  @param[in]   length   - length of the payload in bytes
+ *  @param[out]  sequence - sequence number of the frame
+ *  @param[out]  time     - send time in [nsec] (lower 32 bits)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_NOSTAMP  - payload too short for a stamp
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_unstamp(const uint8_t *data, size_t length, uint32_t *sequence, uint32_t *time);
+
+/** @brief       creates a latency meter (with empty histograms).
+ *
+ *  @param[out]  meter - handle of the latency meter
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_RESOURCE - resource allocation failed
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_create(lat_meter_t *meter);
+
+/** @brief       clears the histograms and counters of a latency meter (the
+ *               next frame is expected with sequence number 0).
+ *
+ *  @param[in]   meter - handle of the latency meter
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_reset(lat_meter_t meter);
+
+/** @brief       accounts a received frame: latency, jitter, loss and
+ *               reordering (a payload without a stamp is counted as invalid).
+ *
+ *  @param[in]   meter  - handle of the latency meter
+ *  @param[in]   data   - payload of the received CAN frame
+ *  @param[in]   length - length of the payload in bytes
+ *  @param[in]   time   - receive time from lat_clock() in [nsec]
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_NOSTAMP  - payload too short for a stamp
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_account(lat_meter_t meter, const uint8_t *data, size_t length, uint64_t time);
+
+/** @brief       retrieves the statistics of a latency meter.
+ *
+ *  @param[in]   meter - handle of the latency meter
+ *  @param[in]   sent  - number of frames sent (or 0 to take the highest
+ *                       sequence number received plus one)
+ *  @param[out]  stats - counters, jitter estimate and histogram summaries
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_stats(lat_meter_t meter, uint64_t sent, lat_stats_t *stats);
+
+/** @brief       returns the value at a percentile of a histogram (the upper
+ *               bound of its bucket, but not above the largest value; the
+ *               0th percentile is the smallest value).
+ *
+ *  @param[in]   meter      - handle of the latency meter
+ *  @param[in]   histogram  - LAT_LATENCY or LAT_JITTER
+ *  @param[in]   percentile - percentile (0.0 to 100.0)
+ *  @param[out]  value      - value at the percentile in [nsec]
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_EMPTY    - no values in the histogram
+ *  @retval      LATERR_ILLPARA  - illegal histogram or percentile
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_percentile(lat_meter_t meter, int histogram, double percentile, uint64_t *value);
+
+/** @brief       writes the percentile distribution of a histogram in the
+ *               format of HdrHistogram (.hgrm), values in microseconds.
+ *
+ *  @param[in]   meter     - handle of the latency meter
+ *  @param[in]   histogram - LAT_LATENCY or LAT_JITTER
+ *  @param[in]   stream    - output stream (e.g. a file opened for writing)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_ILLPARA  - illegal histogram
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_distribution(lat_meter_t meter, int histogram, FILE *stream);
+
+/** @brief       releases a latency meter.
+ *
+ *  @param[in]   meter - handle of the latency meter
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      LATERR_NULLPTR  - null-pointer assignment
+ */
+int lat_meter_destroy(lat_meter_t meter);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_LAT_H_INCLUDED */
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
@@ -84,6 +84,18 @@
 #else
 #include <windows.h>
 #endif
+#if (OPTION_MSG_NO_SIMD == 0)
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MSG_SIMD_NEON
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#define MSG_SIMD_SSE2
+#endif
+#endif
 
 /*  -----------  defines  ------------------------------------------------
  */
@@ -100,23 +112,41 @@
                     ((x) > 12U) ? 0xAU : \
                     ((x) > 8U) ?  0x9U : (x)
 #endif
+#define HEX_ROW(h)  h"0" h"1" h"2" h"3" h"4" h"5" h"6" h"7" h"8" h"9" h"A" h"B" h"C" h"D" h"E" h"F"
+#define DEC_ROW(d)  d"0" d"1" d"2" d"3" d"4" d"5" d"6" d"7" d"8" d"9"
 
 
 /*  -----------  types  --------------------------------------------------
  */
 
+typedef struct msg_writer_t_ {          /* output buffer: */
+    char *begin;                        /*   first character */
+    char *ptr;                          /*   next character to be written */
+    char *end;                          /*   reserved for the terminating zero */
+} msg_writer_t;
+
 
 /*  -----------  prototypes  ---------------------------------------------
  */
 
-static void format_time(char *string, const msg_message_t *message);
-static void format_id(char *string, const msg_message_t *message);
-static void format_dlc(char *string, const msg_message_t *message);
-static void format_data(char *string, const msg_message_t *message, int ascii, int indent);
-static void format_ascii(char *string, const msg_message_t *message);
-static void format_data_byte(char *string, unsigned char data);
-static void format_data_ascii(char *string, unsigned char data);
-static void format_fill_byte(char *string);
+static void writer_init(msg_writer_t *writer, char *buffer, size_t length);
+static int writer_done(msg_writer_t *writer);
+static void put_char(msg_writer_t *writer, char c);
+static void put_chars(msg_writer_t *writer, const char *string, size_t length);
+static void put_fill(msg_writer_t *writer, char c, int count);
+static void put_dec(msg_writer_t *writer, uint64_t value, int width, char fill, int left);
+static void put_radix(msg_writer_t *writer, uint32_t value, int width, unsigned int shift);
+
+static void format_time(msg_writer_t *writer, const msg_message_t *message, msg_timestamp_t *laststamp);
+static void format_id(msg_writer_t *writer, const msg_message_t *message);
+static void format_flags(msg_writer_t *writer, const msg_message_t *message);
+static void format_dlc(msg_writer_t *writer, const msg_message_t *message);
+static void format_data(msg_writer_t *writer, const msg_message_t *message, int ascii, int indent);
+static void format_ascii(msg_writer_t *writer, const msg_message_t *message);
+static void format_data_bytes(msg_writer_t *writer, const uint8_t *data, int count, msg_fmt_number_t number);
+static void format_data_chars(msg_writer_t *writer, const uint8_t *data, int count, char subst, int spaced);
+static void hex_block(char *string, const uint8_t *data, int count);
+static void ascii_block(char *string, const uint8_t *data, int count, char subst, int spaced);
 
 
 /*  -----------  variables  ----------------------------------------------
@@ -165,9 +195,21 @@ static struct {                         /* format option: */
 };
 static msg_format_t msg_format = MSG_FORMAT_DEFAULT;
 static char msg_string[MSG_STRING_LENGTH] = "";
+static msg_timestamp_t msg_laststamp = { 0, 0 };
 static const unsigned char dlc_table[16] = {
     0U,1U,2U,3U,4U,5U,6U,7U,8U,12U,16U,20U,24U,32U,48U,64U
 };
+static const char hex_table[2*256+1] = {   /* "00" .. "FF" */
+    HEX_ROW("0") HEX_ROW("1") HEX_ROW("2") HEX_ROW("3") HEX_ROW("4") HEX_ROW("5") HEX_ROW("6") HEX_ROW("7")
+    HEX_ROW("8") HEX_ROW("9") HEX_ROW("A") HEX_ROW("B") HEX_ROW("C") HEX_ROW("D") HEX_ROW("E") HEX_ROW("F")
+};
+static const char dec_table[2*100+1] = {   /* "00" .. "99" */
+    DEC_ROW("0") DEC_ROW("1") DEC_ROW("2") DEC_ROW("3") DEC_ROW("4")
+    DEC_ROW("5") DEC_ROW("6") DEC_ROW("7") DEC_ROW("8") DEC_ROW("9")
+};
+static const char digit_table[16+1] = "0123456789ABCDEF";
+static const char *const field_separator[2] = { "  ", "\t" };  /* {SPACES, TABS} */
+static const char *const short_separator[2] = { " ", "\t" };   /* {SPACES, TABS} */
 
 
 /*  -----------  functions  ----------------------------------------------
@@ -176,179 +218,206 @@ static const unsigned char dlc_table[16] = {
 char *msg_format_message(const msg_message_t *message, msg_direction_t direction,
                                msg_counter_t counter, msg_channel_t channel)
 {
-    char tmp_string[MSG_STRING_LENGTH];
+    (void)msg_format_message_r(msg_string, sizeof(msg_string), message, direction, counter, channel, &msg_laststamp);
+
+    return msg_string;
+}
+
+int msg_format_message_r(char *buffer, size_t length, const msg_message_t *message,
+                         msg_direction_t direction, msg_counter_t counter, msg_channel_t channel,
+                         msg_timestamp_t *laststamp)
+{
+    msg_writer_t writer;
+    int tabs = (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? 1 : 0;
 
-    memset(msg_string, 0, sizeof(msg_string));
+    if (!buffer || !length)
+        return -1;
+    writer_init(&writer, buffer, length);
 
     if (message) {
         /* prompt (optional) */
-        if (strlen(msg_option.tx_prompt) && (direction == MSG_TX_MESSAGE)) {
-            strcat(msg_string, msg_option.tx_prompt);
-            strcat(msg_string, (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? "\t" : " ");
+        if (msg_option.tx_prompt[0] && (direction == MSG_TX_MESSAGE)) {
+            put_chars(&writer, msg_option.tx_prompt, strlen(msg_option.tx_prompt));
+            put_char(&writer, tabs ? '\t' : ' ');
         }
-        else if (strlen(msg_option.rx_prompt)) { /* defaults to MSG_DIRECTION_RX_MSG */
-            strcat(msg_string, msg_option.rx_prompt);
-            strcat(msg_string, (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? "\t" : " ");
+        else if (msg_option.rx_prompt[0]) { /* defaults to MSG_DIRECTION_RX_MSG */
+            put_chars(&writer, msg_option.rx_prompt, strlen(msg_option.rx_prompt));
+            put_char(&writer, tabs ? '\t' : ' ');
         }
         /* counter (optional) */
-        if ((msg_option.counter != MSG_FMT_OPTION_OFF) && ((msg_option.separator == MSG_FMT_SEPARATOR_TABS))) {
-            sprintf(tmp_string, "%" PRIu64 "\t", counter);
-            strcat(msg_string, tmp_string);
+        if ((msg_option.counter != MSG_FMT_OPTION_OFF) && tabs) {
+            put_dec(&writer, counter, 0, ' ', 0);
+            put_char(&writer, '\t');
         }
         else if (msg_option.counter != MSG_FMT_OPTION_OFF) { /* defaults to MSG_FMT_SEPARATOR_SPACES */
-            sprintf(tmp_string, "%-7" PRIu64 "  ", counter);
-            strcat(msg_string, tmp_string);
+            put_dec(&writer, counter, 7, ' ', 1);
+            put_chars(&writer, "  ", 2U);
         }
         /* time-stamp (abs/rel/zero) (hhmmss/sec/DJD).(msec/usec) */
-        format_time(tmp_string, message);
-        strcat(msg_string, tmp_string);
-        strcat(msg_string, (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? "\t" : "  ");
+        format_time(&writer, message, laststamp);
+        put_chars(&writer, field_separator[tabs], tabs ? 1U : 2U);
 
         /* channel (optional) */
-        if ((msg_option.channel != MSG_FMT_OPTION_OFF) && (msg_option.separator == MSG_FMT_SEPARATOR_TABS)) {
-            sprintf(tmp_string, "%i\t", channel);
-            strcat(msg_string, tmp_string);
-        }
-        else if (msg_option.channel != MSG_FMT_OPTION_OFF) { /* defaults to MSG_FMT_SEPARATOR_SPACES */
-            sprintf(tmp_string, "%-2i  ", channel);
-            strcat(msg_string, tmp_string);
+        if (msg_option.channel != MSG_FMT_OPTION_OFF) {
+            if (channel < 0) {
+                put_char(&writer, '-');
+                put_dec(&writer, (uint64_t)(-(int64_t)channel), tabs ? 0 : 1, ' ', 1);
+            }
+            else
+                put_dec(&writer, (uint64_t)channel, tabs ? 0 : 2, ' ', 1);
+            put_chars(&writer, field_separator[tabs], tabs ? 1U : 2U);
         }
         /* identifier (hex/dec/oct) */
-        format_id(tmp_string, message);
-        strcat(msg_string, tmp_string);
-        strcat(msg_string, (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? "\t" : "  ");
+        format_id(&writer, message);
+        put_chars(&writer, field_separator[tabs], tabs ? 1U : 2U);
 
         /* flags (optional) */
         if (msg_option.flags != MSG_FMT_OPTION_OFF) {
-#if (OPTION_CAN_2_0_ONLY == 0)
-            if (!message->sts) {
-                strcat(msg_string, message->xtd ? "X" : "S");
-                strcat(msg_string, message->fdf ? "F" : "-");
-                strcat(msg_string, message->brs ? "B" : "-");
-                strcat(msg_string, message->esi ? "E" : "-");
-                strcat(msg_string, message->rtr ? "R" : "-");
-            }
-            else {
-                strcat(msg_string, "Error");
-            }
-#else
-            if (!message->sts) {
-                strcat(msg_string, message->xtd ? "X" : "S");
-                strcat(msg_string, message->rtr ? "R" : "-");
-            }
-            else {
-                strcat(msg_string, "E!");
-            }
-#endif
-            strcat(msg_string, (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? "\t" : " ");  /* only one space! */
+            format_flags(&writer, message);
+            put_chars(&writer, short_separator[tabs], 1U);  /* only one space! */
         }
         /* dlc/length (hex/dec/oct) */
-        format_dlc(tmp_string, message);
-        strcat(msg_string, tmp_string);
+        format_dlc(&writer, message);
 
         /* data (hex/dec/oct) plus ascii (optional) */
         if (message->dlc && !message->rtr) {
-            strcat(msg_string, (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? "\t" : "  ");
-            format_data(tmp_string, message, (msg_option.ascii == MSG_FMT_OPTION_OFF) ? 0 : 1, (int)strlen(msg_string));
-            strcat(msg_string, tmp_string);
+            put_chars(&writer, field_separator[tabs], tabs ? 1U : 2U);
+            format_data(&writer, message, (msg_option.ascii == MSG_FMT_OPTION_OFF) ? 0 : 1, (int)(writer.ptr - writer.begin));
         }
         /* end-of-line (optional) */
         if (msg_option.end_of_line) {
-            strcat(msg_string, "\n");
+            put_char(&writer, '\n');
         }
     }
-    return msg_string;
+    return writer_done(&writer);
+}
+
+msg_timestamp_t msg_time_difference(msg_fmt_timestamp_t reference, msg_timestamp_t *laststamp, const msg_timestamp_t *timestamp)
+{
+    msg_timestamp_t difftime;
+
+    assert(laststamp);
+    assert(timestamp);
+
+    switch (reference) {
+    case MSG_FMT_TIMESTAMP_RELATIVE:
+    case MSG_FMT_TIMESTAMP_ZERO:
+        if (laststamp->tv_sec == 0) { /* first init */
+            laststamp->tv_sec = timestamp->tv_sec;
+            laststamp->tv_nsec = timestamp->tv_nsec;
+        }
+        difftime.tv_sec = timestamp->tv_sec - laststamp->tv_sec;
+        difftime.tv_nsec = timestamp->tv_nsec - laststamp->tv_nsec;
+        if (difftime.tv_nsec < 0) {
+            difftime.tv_sec -= 1;
+            difftime.tv_nsec += 1000000000;
+        }
+        if (difftime.tv_sec < 0) {
+            difftime.tv_sec = 0;
+            difftime.tv_nsec = 0;
+        }
+        if (reference == MSG_FMT_TIMESTAMP_RELATIVE) { /* update for delta calculation */
+            laststamp->tv_sec = timestamp->tv_sec;
+            laststamp->tv_nsec = timestamp->tv_nsec;
+        }
+        break;
+    case MSG_FMT_TIMESTAMP_ABSOLUTE:
+    default:
+        difftime.tv_sec = timestamp->tv_sec;
+        difftime.tv_nsec = timestamp->tv_nsec;
+        break;
+    }
+    return difftime;
 }
 
 char *msg_format_time(const msg_message_t *message)
 {
-    memset(msg_string, 0, sizeof(msg_string));
+    msg_writer_t writer;
+
+    writer_init(&writer, msg_string, sizeof(msg_string));
 
     if (message) {
         /* time-stamp (abs/rel/zero) (hhmmss/sec/DJD).(msec/usec) */
-        format_time(msg_string, message);
+        format_time(&writer, message, &msg_laststamp);
     }
+    (void)writer_done(&writer);
     return msg_string;
 }
 
 char *msg_format_id(const msg_message_t *message)
 {
-    memset(msg_string, 0, sizeof(msg_string));
+    msg_writer_t writer;
+
+    writer_init(&writer, msg_string, sizeof(msg_string));
 
     if (message) {
         /* identifier (hex/dec/oct) */
-        format_id(msg_string, message);
+        format_id(&writer, message);
     }
+    (void)writer_done(&writer);
     return msg_string;
 }
 
 char *msg_format_flags(const msg_message_t *message)
 {
-    memset(msg_string, 0, sizeof(msg_string));
+    msg_writer_t writer;
+
+    writer_init(&writer, msg_string, sizeof(msg_string));
 
     if (message) {
-#if (OPTION_CAN_2_0_ONLY == 0)
-        if (!message->sts) {
-            strcat(msg_string, message->xtd ? "X" : "S");
-            strcat(msg_string, message->fdf ? "F" : "-");
-            strcat(msg_string, message->brs ? "B" : "-");
-            strcat(msg_string, message->esi ? "E" : "-");
-            strcat(msg_string, message->rtr ? "R" : "-");
-        }
-        else {
-            strcat(msg_string, "Error");
-        }
-#else
-        if (!message->sts) {
-            strcat(msg_string, message->xtd ? "X" : "S");
-            strcat(msg_string, message->rtr ? "R" : "-");
-        }
-        else {
-            strcat(msg_string, "E!");
-        }
-#endif
+        /* flags (XFBER or Error) */
+        format_flags(&writer, message);
     }
+    (void)writer_done(&writer);
     return msg_string;
 }
 
 char *msg_format_dlc(const msg_message_t *message)
 {
-    memset(msg_string, 0, sizeof(msg_string));
+    msg_writer_t writer;
+
+    writer_init(&writer, msg_string, sizeof(msg_string));
 
     if (message) {
         /* dlc/length (hex/dec/oct) */
-        format_dlc(msg_string, message);
+        format_dlc(&writer, message);
     }
+    (void)writer_done(&writer);
     return msg_string;
 }
 
 char *msg_format_data(const msg_message_t *message)
 {
-    memset(msg_string, 0, sizeof(msg_string));
+    msg_writer_t writer;
+
+    writer_init(&writer, msg_string, sizeof(msg_string));
 
     if (message) {
         /* data (hex/dec/oct) */
         if (message->dlc) {
-            format_data(msg_string, message, 0, 0);
+            format_data(&writer, message, 0, 0);
         }
     }
+    (void)writer_done(&writer);
     return msg_string;
 }
 
 char *msg_format_ascii(const msg_message_t *message)
 {
-    memset(msg_string, 0, sizeof(msg_string));
+    msg_writer_t writer;
+
+    writer_init(&writer, msg_string, sizeof(msg_string));
 
     if (message) {
         /* data (hex/dec/oct) */
         if (message->dlc) {
-            format_ascii(msg_string, message);
+            format_ascii(&writer, message);
         }
     }
+    (void)writer_done(&writer);
     return msg_string;
 }
 
-
 /* message output format {DEFAULT, ...} */
 int msg_set_format(msg_format_t format)
 {
@@ -686,56 +755,138 @@ int msg_set_fmt_tx_prompt(const char *option)
 /*  -----------  local functions  ----------------------------------------
  */
 
-static void format_time(char *string, const msg_message_t *message)
+static void writer_init(msg_writer_t *writer, char *buffer, size_t length)
+{
+    assert(writer);
+    assert(buffer);
+    assert(length);
+
+    writer->begin = buffer;
+    writer->ptr = buffer;
+    writer->end = buffer + length - 1U;
+}
+
+static int writer_done(msg_writer_t *writer)
 {
-    static msg_timestamp_t laststamp = { 0, 0 };
-    struct timespec difftime;
+    assert(writer);
+
+    *writer->ptr = '\0';
+    return (int)(writer->ptr - writer->begin);
+}
+
+static void put_char(msg_writer_t *writer, char c)
+{
+    if (writer->ptr < writer->end)
+        *writer->ptr++ = c;
+}
+
+static void put_chars(msg_writer_t *writer, const char *string, size_t length)
+{
+    size_t room = (size_t)(writer->end - writer->ptr);
+
+    if (length <= room) {
+        memcpy(writer->ptr, string, length);
+        writer->ptr += length;
+    }
+    else {  /* truncate */
+        memcpy(writer->ptr, string, room);
+        writer->ptr += room;
+    }
+}
+
+static void put_fill(msg_writer_t *writer, char c, int count)
+{
+    for (; (count > 0) && (writer->ptr < writer->end); count--)
+        *writer->ptr++ = c;
+}
+
+static void put_dec(msg_writer_t *writer, uint64_t value, int width, char fill, int left)
+{
+    char digits[20], *p = digits + sizeof(digits);
+    unsigned int pair;
+    int count;
+
+    /* two digits at a time, from right to left */
+    while (value >= 100U) {
+        pair = (unsigned int)(value % 100U);
+        value /= 100U;
+        p -= 2; memcpy(p, &dec_table[2U * pair], 2U);
+    }
+    if (value >= 10U) {
+        p -= 2; memcpy(p, &dec_table[2U * (unsigned int)value], 2U);
+    }
+    else
+        *--p = (char)('0' + (unsigned int)value);
+    count = (int)((digits + sizeof(digits)) - p);
+
+    if (!left)
+        put_fill(writer, fill, width - count);
+    put_chars(writer, p, (size_t)count);
+    if (left)
+        put_fill(writer, ' ', width - count);
+}
+
+static void put_radix(msg_writer_t *writer, uint32_t value, int width, unsigned int shift)
+{
+    char digits[16], *p = digits + sizeof(digits);
+    uint32_t mask = ((uint32_t)1 << shift) - 1U;
+    int count;
+
+    /* hex (shift = 4) or oct (shift = 3), zero padded */
+    do {
+        *--p = digit_table[value & mask];
+        value >>= shift;
+    } while (value);
+    count = (int)((digits + sizeof(digits)) - p);
+
+    put_fill(writer, '0', width - count);
+    put_chars(writer, p, (size_t)count);
+}
+
+static void format_time(msg_writer_t *writer, const msg_message_t *message, msg_timestamp_t *laststamp)
+{
+    msg_fmt_timestamp_t reference = msg_option.time_stamp;
+    msg_timestamp_t nostamp = { 0, 0 };
+    msg_timestamp_t difftime;
     struct tm tm; time_t t;
-    char   timestring[25];
+    char   timestring[48];
     double djd;
 
-    assert(string);
+    assert(writer);
     assert(message);
 
-    switch (msg_option.time_stamp) {
-    case MSG_FMT_TIMESTAMP_RELATIVE:
-    case MSG_FMT_TIMESTAMP_ZERO:
-        if (laststamp.tv_sec == 0) { /* first init */
-            laststamp.tv_sec = message->timestamp.tv_sec;
-            laststamp.tv_nsec = message->timestamp.tv_nsec;
-        }
-        difftime.tv_sec = message->timestamp.tv_sec - laststamp.tv_sec;
-        difftime.tv_nsec = message->timestamp.tv_nsec - laststamp.tv_nsec;
-        if (difftime.tv_nsec < 0) {
-            difftime.tv_sec -= 1;
-            difftime.tv_nsec += 1000000000;
-        }
-        if (difftime.tv_sec < 0) {
-            difftime.tv_sec = 0;
-            difftime.tv_nsec = 0;
-        }
-        if (msg_option.time_stamp == MSG_FMT_TIMESTAMP_RELATIVE) { /* update for delta calculation */
-            laststamp.tv_sec = message->timestamp.tv_sec;
-            laststamp.tv_nsec = message->timestamp.tv_nsec;
-        }
-        t = (time_t)difftime.tv_sec;
-        tm = *gmtime(&t);
-        break;
-    case MSG_FMT_TIMESTAMP_ABSOLUTE:
-    default:
-        difftime.tv_sec = message->timestamp.tv_sec;
-        difftime.tv_nsec = message->timestamp.tv_nsec;
-        t = (time_t)message->timestamp.tv_sec;
-        tm = *localtime(&t);
-        break;
+    /* without a reference time the time-stamp is absolute */
+    if (!laststamp) {
+        reference = MSG_FMT_TIMESTAMP_ABSOLUTE;
+        laststamp = &nostamp;
     }
+    difftime = msg_time_difference(reference, laststamp, &message->timestamp);
     switch (msg_option.time_format) {
     case MSG_FMT_TIME_HHMMSS:
-        strftime(timestring, 24, "%H:%M:%S", &tm); // TODO: tm > 24h (?)
+        t = (time_t)difftime.tv_sec;
+        if ((reference != MSG_FMT_TIMESTAMP_ZERO) &&
+            (reference != MSG_FMT_TIMESTAMP_RELATIVE)) {
+#if !defined(_WIN32) && !defined(_WIN64)
+            (void)localtime_r(&t, &tm);
+#else
+            (void)localtime_s(&tm, &t);
+#endif
+        }
+        else {  /* time difference (UTC) */
+            tm.tm_hour = (int)((t / 3600) % 24);  // TODO: tm > 24h (?)
+            tm.tm_min = (int)((t / 60) % 60);
+            tm.tm_sec = (int)(t % 60);
+        }
+        put_dec(writer, (uint64_t)tm.tm_hour, 2, '0', 0);
+        put_char(writer, ':');
+        put_dec(writer, (uint64_t)tm.tm_min, 2, '0', 0);
+        put_char(writer, ':');
+        put_dec(writer, (uint64_t)tm.tm_sec, 2, '0', 0);
+        put_char(writer, '.');
         if (msg_option.time_usec)
-            sprintf(string, "%s.%06li", timestring, (long)difftime.tv_nsec / 1000L);
+            put_dec(writer, (uint64_t)difftime.tv_nsec / 1000U, 6, '0', 0);
         else/* resolution is 0.1 milliseconds! */
-            sprintf(string, "%s.%04li", timestring, (long)difftime.tv_nsec / 100000L);
+            put_dec(writer, (uint64_t)difftime.tv_nsec / 100000U, 4, '0', 0);
         break;
     case MSG_FMT_TIME_DJD:
         if (!msg_option.time_usec)  /* round to milliseconds resolution */
@@ -743,105 +894,134 @@ static void format_time(char *string, const msg_message_t *message)
         djd = (double)difftime.tv_sec / (double)86400;
         djd += (double)difftime.tv_nsec / (double)86400000000000;
         if (msg_option.time_usec)
-            sprintf(string, "%1.12lf", djd);
+            (void)snprintf(timestring, sizeof(timestring), "%1.12lf", djd);
         else
-            sprintf(string, "%1.9lf", djd);
+            (void)snprintf(timestring, sizeof(timestring), "%1.9lf", djd);
+        put_chars(writer, timestring, strlen(timestring));
         break;
     case MSG_FMT_TIME_SEC:
     default:
+        if (difftime.tv_sec < 0) {  /* not via the lookup table */
+            if (msg_option.time_usec)
+                (void)snprintf(timestring, sizeof(timestring), "%3li.%06li", (long)difftime.tv_sec, (long)difftime.tv_nsec / 1000L);
+            else
+                (void)snprintf(timestring, sizeof(timestring), "%3li.%04li", (long)difftime.tv_sec, (long)difftime.tv_nsec / 100000L);
+            put_chars(writer, timestring, strlen(timestring));
+            break;
+        }
+        put_dec(writer, (uint64_t)difftime.tv_sec, 3, ' ', 0);
+        put_char(writer, '.');
         if (msg_option.time_usec)
-            sprintf(string, "%3li.%06li", (long)difftime.tv_sec, (long)difftime.tv_nsec / 1000L);
+            put_dec(writer, (uint64_t)difftime.tv_nsec / 1000U, 6, '0', 0);
         else/* resolution is 0.1 milliseconds! */
-            sprintf(string, "%3li.%04li", (long)difftime.tv_sec, (long)difftime.tv_nsec / 100000L);
+            put_dec(writer, (uint64_t)difftime.tv_nsec / 100000U, 4, '0', 0);
         break;
     }
 }
 
-static void format_id(char *string, const msg_message_t *message)
+static void format_id(msg_writer_t *writer, const msg_message_t *message)
 {
-    assert(string);
+    assert(writer);
     assert(message);
 
-    string[0] = '\0';
     switch (msg_option.id) {
     case MSG_FMT_NUMBER_DEC:
-        if (!msg_option.id_xtd)
-            sprintf(string, "%-4" PRIu32, message->id);
-        else
-            sprintf(string, "%-9" PRIu32, message->id);
+        put_dec(writer, (uint64_t)message->id, !msg_option.id_xtd ? 4 : 9, ' ', 1);
         break;
     case MSG_FMT_NUMBER_OCT:
-        if (!msg_option.id_xtd)
-            sprintf(string, "%04" PRIo32, message->id);
-        else
-            sprintf(string, "%010" PRIo32, message->id);
+        put_radix(writer, message->id, !msg_option.id_xtd ? 4 : 10, 3U);
         break;
     case MSG_FMT_NUMBER_HEX:
     default:
-        if (!msg_option.id_xtd)
-            sprintf(string, "%03" PRIX32, message->id);
-        else
-            sprintf(string, "%08" PRIX32, message->id);
+        put_radix(writer, message->id, !msg_option.id_xtd ? 3 : 8, 4U);
         break;
     }
 }
 
-static void format_dlc(char *string, const msg_message_t *message)
+static void format_flags(msg_writer_t *writer, const msg_message_t *message)
+{
+    assert(writer);
+    assert(message);
+
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if (!message->sts) {
+        char flags[5];
+        flags[0] = message->xtd ? 'X' : 'S';
+        flags[1] = message->fdf ? 'F' : '-';
+        flags[2] = message->brs ? 'B' : '-';
+        flags[3] = message->esi ? 'E' : '-';
+        flags[4] = message->rtr ? 'R' : '-';
+        put_chars(writer, flags, 5U);
+    }
+    else {
+        put_chars(writer, "Error", 5U);
+    }
+#else
+    if (!message->sts) {
+        char flags[2];
+        flags[0] = message->xtd ? 'X' : 'S';
+        flags[1] = message->rtr ? 'R' : '-';
+        put_chars(writer, flags, 2U);
+    }
+    else {
+        put_chars(writer, "E!", 2U);
+    }
+#endif
+}
+
+static void format_dlc(msg_writer_t *writer, const msg_message_t *message)
 {
-    assert(string);
+    assert(writer);
     assert(message);
 
     unsigned char length = (msg_option.dlc_format == MSG_FMT_CANFD_DLC) ? message->dlc : DLC2LEN(message->dlc);
     char pre = '\0', post = '\0';
     int blank = 0;
 
-    string[0] = '\0';
     switch (msg_option.dlc_brackets) {
     case '(': pre = '('; post = ')'; break;
     case '[': pre = '['; post = ']'; break;
     default: break;
     }
+    if (pre)
+        put_char(writer, pre);
     switch (msg_option.dlc) {
     case MSG_FMT_NUMBER_DEC:
-        if (pre && post)
-            sprintf(string, "%c%u%c", pre, length, post);
-        else
-            sprintf(string, "%u", length);
+        put_dec(writer, (uint64_t)length, 0, ' ', 0);
         blank = length >= 10 ? 0 : 1;
         break;
     case MSG_FMT_NUMBER_OCT:
-        if (pre && post)
-            sprintf(string, "%c%02o%c", pre, length, post);
-        else
-            sprintf(string, "%02o", length);
+        put_radix(writer, (uint32_t)length, 2, 3U);
         blank = length >= 64 ? 0 : 1;
         break;
     case MSG_FMT_NUMBER_HEX:
     default:
-        if (pre && post)
-            sprintf(string, "%c%X%c", pre, length, post);
-        else
-            sprintf(string, "%X", length);
+        put_radix(writer, (uint32_t)length, 1, 4U);
         break;
     }
+    if (post)
+        put_char(writer, post);
 #if (OPTION_CAN_2_0_ONLY == 0)
     if (message->fdf && blank)
-        strcat(string, " ");
+        put_char(writer, ' ');
 #else
     (void)blank;  /* to avoid compiler warnings */
 #endif
 }
 
-static void format_data(char *string, const msg_message_t *message, int ascii, int indent)
+static void format_data(msg_writer_t *writer, const msg_message_t *message, int ascii, int indent)
 {
-    assert(string);
+    assert(writer);
     assert(message);
 
+    msg_writer_t output = *writer;  /* not aliased by the character stores */
+    msg_fmt_number_t number = msg_option.data;
+    char subst = (char)msg_option.ascii_subst;
     int length = DLC2LEN(message->dlc);
-    int i, j, col, wraparound;
-    char datastring[8];
+    int tabs = (msg_option.separator == MSG_FMT_SEPARATOR_TABS) ? 1 : 0;
+    int i, count, wraparound;
+    int shown = 0;  /* data bytes already shown as ASCII */
 
-    string[0] = '\0';
 #if (OPTION_CAN_2_0_ONLY == 0)
     if (msg_option.wraparound == MSG_FMT_WRAPAROUND_NO)
         wraparound = message->fdf ? (int)MSG_FMT_WRAPAROUND_64 : (int)MSG_FMT_WRAPAROUND_8;
@@ -850,63 +1030,47 @@ static void format_data(char *string, const msg_message_t *message, int ascii, i
 #else
     wraparound = (int)MSG_FMT_WRAPAROUND_8;
 #endif
-    for (i = 0, j = 0, col = 0; i < length; i++) {
-        format_data_byte(datastring, message->data[i]);
-        strcat(string, datastring);
-        if ((i + 1) < length) {
-            if ((col + 1) == wraparound) {
-                if (ascii) {
-                    strcat(string, msg_option.separator == MSG_FMT_SEPARATOR_TABS ? "\t" : "  ");
-                    for (col = 0; col < (int)msg_option.wraparound; j++, col++) {
-                        format_data_ascii(datastring, message->data[j]);
-                        strcat(string, datastring);
-                    }
-                }
-                strcat(string, "\n");
-                if (msg_option.separator != MSG_FMT_SEPARATOR_TABS) {
-                    for (col = 0; col < indent; col++)
-                        strcat(string, " ");
+    /* line by line: data bytes, and if wrapped around the ASCII column, new-line and indent
+     * note: w/o wraparound option (CAN CC frame with DLC > 8) the ASCII column of a wrapped
+     *       line is empty and all data bytes are shown as ASCII in the last line */
+    for (i = 0, count = 0; i < length; i += count) {
+        count = ((length - i) < wraparound) ? (length - i) : wraparound;
+        format_data_bytes(&output, &message->data[i], count, number);
+        if ((i + count) < length) {
+            if (ascii) {
+                put_chars(&output, field_separator[tabs], tabs ? 1U : 2U);
+                if (msg_option.wraparound != MSG_FMT_WRAPAROUND_NO) {
+                    format_data_chars(&output, &message->data[i], count, subst, 0);
+                    shown = i + count;
                 }
-                else
-                    strcat(string, "\t");
-                col = 0;
-            }
-            else {
-                strcat(string, " ");
-                col++;
             }
+            put_char(&output, '\n');
+            if (!tabs)
+                put_fill(&output, ' ', indent);
+            else
+                put_char(&output, '\t');
         }
-        else
-            col++;
     }
     if (ascii) {
-        if ((col < wraparound) && (i != 0)) {
-            strcat(string, " ");
-            for (; col < wraparound; col++) {
-                format_fill_byte(datastring);
-                strcat(string, datastring);
-                if ((col + 1) != wraparound)
-                    strcat(string, " ");
-            }
-        }
-        strcat(string, msg_option.separator == MSG_FMT_SEPARATOR_TABS ? "\t" : "  ");
-        for (; j < length; j++) {
-            format_data_ascii(datastring, message->data[j]);
-            strcat(string, datastring);
-        }
+        /* fill bytes up to the ASCII column of a full line, each followed by a space */
+        if ((count < wraparound) && (length != 0))
+            put_fill(&output, ' ', (wraparound - count) * ((number == MSG_FMT_NUMBER_HEX) ? 3 : 4));
+        put_chars(&output, field_separator[tabs], tabs ? 1U : 2U);
+        format_data_chars(&output, &message->data[shown], length - shown, subst, 0);
     }
+    *writer = output;
 }
 
-static void format_ascii(char *string, const msg_message_t *message)
+static void format_ascii(msg_writer_t *writer, const msg_message_t *message)
 {
-    assert(string);
+    assert(writer);
     assert(message);
 
+    msg_writer_t output = *writer;  /* not aliased by the character stores */
+    char subst = (char)msg_option.ascii_subst;
     int length = DLC2LEN(message->dlc);
-    int i, col, wraparound;
-    char datastring[8];
+    int i, count, wraparound;
 
-    string[0] = '\0';
 #if (OPTION_CAN_2_0_ONLY == 0)
     if (msg_option.wraparound == MSG_FMT_WRAPAROUND_NO)
         wraparound = message->fdf ? (int)MSG_FMT_WRAPAROUND_64 : (int)MSG_FMT_WRAPAROUND_8;
@@ -915,63 +1079,182 @@ static void format_ascii(char *string, const msg_message_t *message)
 #else
     wraparound = (int)MSG_FMT_WRAPAROUND_8;
 #endif
-    for (i = 0, col = 0; i < length; i++) {
-        format_data_ascii(datastring, message->data[i]);
-        strcat(string, datastring);
-        if ((i + 1) < length) {
-            if ((col + 1) == wraparound) {
-                strcat(string, "\n");
-                col = 0;
-            }
-            else {
-                strcat(string, " ");
-                col++;
-            }
-        }
+    for (i = 0, count = 0; i < length; i += count) {
+        count = ((length - i) < wraparound) ? (length - i) : wraparound;
+        format_data_chars(&output, &message->data[i], count, subst, 1);
+        if ((i + count) < length)
+            put_char(&output, '\n');
     }
+    *writer = output;
 }
 
-static void format_data_byte(char *string, unsigned char data)
+static void format_data_bytes(msg_writer_t *writer, const uint8_t *data, int count, msg_fmt_number_t number)
 {
-    assert(string);
-
-    switch (msg_option.data) {
-    case MSG_FMT_NUMBER_DEC:
-        sprintf(string, "%-3u", data);
-        break;
-    case MSG_FMT_NUMBER_OCT:
-        sprintf(string, "%03o", data);
-        break;
-    case MSG_FMT_NUMBER_HEX:
-    default:
-        sprintf(string, "%02X", data);
-        break;
+    char digits[3];
+    int i;
+
+    if ((number == MSG_FMT_NUMBER_HEX) && (count > 0) &&
+        ((writer->end - writer->ptr) >= (ptrdiff_t)(3 * count - 1))) {
+        /* "XX XX .. XX" (the trailing space is not taken over) */
+        hex_block(writer->ptr, data, count);
+        writer->ptr += 3 * count - 1;
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        switch (number) {
+        case MSG_FMT_NUMBER_DEC:
+            put_dec(writer, (uint64_t)data[i], 3, ' ', 1);
+            break;
+        case MSG_FMT_NUMBER_OCT:
+            digits[0] = (char)('0' + (data[i] >> 6));
+            digits[1] = (char)('0' + ((data[i] >> 3) & 7U));
+            digits[2] = (char)('0' + (data[i] & 7U));
+            put_chars(writer, digits, 3U);
+            break;
+        case MSG_FMT_NUMBER_HEX:
+        default:
+            put_chars(writer, &hex_table[2U * data[i]], 2U);
+            break;
+        }
+        if ((i + 1) < count)
+            put_char(writer, ' ');
     }
 }
 
-static void format_fill_byte(char *string)
+static void format_data_chars(msg_writer_t *writer, const uint8_t *data, int count, char subst, int spaced)
 {
-    assert(string);
-
-    switch (msg_option.data) {
-    case MSG_FMT_NUMBER_DEC:
-        sprintf(string, "   ");
-        break;
-    case MSG_FMT_NUMBER_OCT:
-        sprintf(string, "   ");
-        break;
-    case MSG_FMT_NUMBER_HEX:
-    default:
-        sprintf(string, "  ");
-        break;
+    int i;
+
+    if ((count > 0) &&
+        ((writer->end - writer->ptr) >= (ptrdiff_t)(spaced ? (2 * count - 1) : count))) {
+        /* "c c .. c" or "cc..c" (the trailing space is not taken over) */
+        ascii_block(writer->ptr, data, count, subst, spaced);
+        writer->ptr += spaced ? (2 * count - 1) : count;
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        /* printable characters of the "C" locale (cf. isprint) */
+        put_char(writer, ((data[i] >= 0x20U) && (data[i] < 0x7FU)) ? (char)data[i] : subst);
+        if (spaced && ((i + 1) < count))
+            put_char(writer, ' ');
     }
 }
 
-static void format_data_ascii(char *string, unsigned char data)
+static void hex_block(char *string, const uint8_t *data, int count)
 {
-    assert(string);
+    int i = 0;
+
+    /* 16 bytes at a time to "XX XX .. XX " (48 characters) */
+#if defined(MSG_SIMD_NEON)
+    const uint8x16_t digits = vld1q_u8((const uint8_t*)digit_table);
+    const uint8x16_t nibble = vdupq_n_u8(0x0FU);
+    uint8x16x3_t output;
+
+    output.val[2] = vdupq_n_u8((uint8_t)' ');
+    for (; (i + 16) <= count; i += 16) {
+        uint8x16_t bytes = vld1q_u8(&data[i]);
+        output.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(bytes, 4));
+        output.val[1] = vqtbl1q_u8(digits, vandq_u8(bytes, nibble));
+        vst3q_u8((uint8_t*)&string[3 * i], output);  /* interleaved: hi, lo, space */
+    }
+#elif defined(MSG_SIMD_SSE2)
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i alpha = _mm_set1_epi8('A' - '0' - 10);
+#if defined(__SSSE3__)
+    const __m128i shuffle0 = _mm_setr_epi8(0, 1, -1, 2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1, 10);
+    const __m128i shuffle1a = _mm_setr_epi8(11, -1, 12, 13, -1, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i shuffle1b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, -1, 2, 3, -1, 4, 5);
+    const __m128i shuffle2 = _mm_setr_epi8(-1, 6, 7, -1, 8, 9, -1, 10, 11, -1, 12, 13, -1, 14, 15, -1);
+    const __m128i spaces0 = _mm_setr_epi8(0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0);
+    const __m128i spaces1 = _mm_setr_epi8(0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0);
+    const __m128i spaces2 = _mm_setr_epi8(' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ');
+#else
+    char pairs[32];
+    int j;
+#endif
+    for (; (i + 16) <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)&data[i]);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        __m128i lo = _mm_and_si128(bytes, nibble);
+        /* nibble to digit: '0' + n (+ 7 for 'A' .. 'F') */
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), alpha));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), alpha));
+        __m128i pairs0 = _mm_unpacklo_epi8(hi, lo);  /* bytes 0 .. 7 */
+        __m128i pairs1 = _mm_unpackhi_epi8(hi, lo);  /* bytes 8 .. 15 */
+#if defined(__SSSE3__)
+        _mm_storeu_si128((__m128i*)&string[3 * i], _mm_or_si128(_mm_shuffle_epi8(pairs0, shuffle0), spaces0));
+        _mm_storeu_si128((__m128i*)&string[3 * i + 16], _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(pairs0, shuffle1a),
+                                                                                  _mm_shuffle_epi8(pairs1, shuffle1b)), spaces1));
+        _mm_storeu_si128((__m128i*)&string[3 * i + 32], _mm_or_si128(_mm_shuffle_epi8(pairs1, shuffle2), spaces2));
+#else
+        _mm_storeu_si128((__m128i*)&pairs[0], pairs0);
+        _mm_storeu_si128((__m128i*)&pairs[16], pairs1);
+        for (j = 0; j < 16; j++) {
+            string[3 * (i + j)] = pairs[2 * j];
+            string[3 * (i + j) + 1] = pairs[2 * j + 1];
+            string[3 * (i + j) + 2] = ' ';
+        }
+#endif
+    }
+#endif
+    /* the remaining bytes (or all w/o SIMD) */
+    for (; i < count; i++) {
+        string[3 * i] = hex_table[2U * data[i]];
+        string[3 * i + 1] = hex_table[2U * data[i] + 1U];
+        string[3 * i + 2] = ' ';
+    }
+}
 
-    sprintf(string, "%c", isprint((int)data) ? (char)data : (char)msg_option.ascii_subst);
+static void ascii_block(char *string, const uint8_t *data, int count, char subst, int spaced)
+{
+    int stride = spaced ? 2 : 1;
+    int i = 0;
+
+    /* 16 bytes at a time to "cc..c" or "c c .. c " (printable or substitute) */
+#if defined(MSG_SIMD_NEON)
+    const uint8x16_t first = vdupq_n_u8(0x20U);
+    const uint8x16_t last = vdupq_n_u8(0x7EU);
+    const uint8x16_t substitute = vdupq_n_u8((uint8_t)subst);
+    uint8x16x2_t output;
+
+    output.val[1] = vdupq_n_u8((uint8_t)' ');
+    for (; (i + 16) <= count; i += 16) {
+        uint8x16_t bytes = vld1q_u8(&data[i]);
+        uint8x16_t printable = vandq_u8(vcgeq_u8(bytes, first), vcleq_u8(bytes, last));
+        output.val[0] = vbslq_u8(printable, bytes, substitute);
+        if (spaced)
+            vst2q_u8((uint8_t*)&string[2 * i], output);  /* interleaved: char, space */
+        else
+            vst1q_u8((uint8_t*)&string[i], output.val[0]);
+    }
+#elif defined(MSG_SIMD_SSE2)
+    const __m128i below = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i substitute = _mm_set1_epi8(subst);
+    const __m128i spaces = _mm_set1_epi8(' ');
+
+    for (; (i + 16) <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)&data[i]);
+        /* signed compare: 0x80 .. 0xFF are negative, thus not above 0x1F */
+        __m128i printable = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, del), _mm_cmpgt_epi8(bytes, below));
+        __m128i chars = _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, substitute));
+        if (spaced) {
+            _mm_storeu_si128((__m128i*)&string[2 * i], _mm_unpacklo_epi8(chars, spaces));
+            _mm_storeu_si128((__m128i*)&string[2 * i + 16], _mm_unpackhi_epi8(chars, spaces));
+        }
+        else
+            _mm_storeu_si128((__m128i*)&string[i], chars);
+    }
+#endif
+    /* the remaining bytes (or all w/o SIMD) */
+    for (; i < count; i++) {
+        /* printable characters of the "C" locale (cf. isprint) */
+        string[stride * i] = ((data[i] >= 0x20U) && (data[i] < 0x7FU)) ? (char)data[i] : subst;
+        if (spaced)
+            string[stride * i + 1] = ' ';
+    }
 }
 
 /** @}
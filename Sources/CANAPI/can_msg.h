@@ -74,6 +74,7 @@ extern "C" {
 #include <stdbool.h>                    //   C99 header for boolean type
 #include <time.h>                       //   time types for time-stamp
 #endif
+#include <stddef.h>                     //   C99 header for size_t
 
 /*  -----------  options  ------------------------------------------------
  */
@@ -85,6 +86,10 @@ extern "C" {
 /** @note  Set define OPTION_CAN_2_0_ONLY to a non-zero value to compile
  *         with CAN 2.0 frame format only (e.g. in the build environment).
  */
+/** @note  Set define OPTION_MSG_NO_SIMD to a non-zero value to compile
+ *         without SSE2/NEON formatting of the data field (e.g. in the build
+ *         environment).
+ */
 #if (OPTION_CAN_2_0_ONLY != 0)
 #ifdef _MSC_VER
 #pragma message ( "Compilation with with legacy CAN 2.0 frame format!" )
@@ -290,6 +295,47 @@ typedef enum msg_direction_t_ {
 char *msg_format_message(const msg_message_t *message, msg_direction_t direction,
                                msg_counter_t counter, msg_channel_t channel);
 
+/** @brief       formats a CAN message into a caller-supplied buffer (reentrant).
+ *
+ *  @note        The message is written in a single pass without dynamic memory,
+ *               using the same format options as msg_format_message.  The
+ *               reference time of ZERO and REL time-stamps is kept by the caller
+ *               in 'laststamp' (see msg_time_difference).
+ *
+ *  @param[out]  buffer    - buffer for the zero-terminated string
+ *  @param[in]   length    - size of the buffer (in bytes), the string is
+ *                           truncated to (length - 1) characters if too small
+ *  @param[in]   message   - the CAN message to be formatted (or NULL)
+ *  @param[in]   direction - message direction (RX or TX)
+ *  @param[in]   counter   - message counter
+ *  @param[in]   channel   - message source (channel)
+ *  @param[in,out] laststamp - reference time of the time-stamp, to be zeroed
+ *                           before the first call (or NULL for absolute time)
+ *
+ *  @returns     number of characters written (without the terminating zero),
+ *               or a negative value if the buffer is NULL or its size is zero.
+ */
+int msg_format_message_r(char *buffer, size_t length, const msg_message_t *message,
+                         msg_direction_t direction, msg_counter_t counter, msg_channel_t channel,
+                         msg_timestamp_t *laststamp);
+
+/** @brief       computes the time-stamp of a message relative to the given
+ *               time-stamp reference (reentrant).
+ *
+ *  @note        This is the time-stamp handling of the message formatter;
+ *               each caller keeps its own reference time in 'laststamp'.
+ *
+ *  @param[in]   reference - time-stamp reference: ZERO, ABS or REL
+ *  @param[in,out] laststamp - time-stamp of the first (ZERO) or of the previous
+ *                           message (REL), to be zeroed before the first call
+ *  @param[in]   timestamp - time-stamp of the message
+ *
+ *  @returns     the time since the first message (ZERO), since the previous
+ *               message (REL), or the unchanged time-stamp (ABS).
+ */
+msg_timestamp_t msg_time_difference(msg_fmt_timestamp_t reference, msg_timestamp_t *laststamp,
+                                    const msg_timestamp_t *timestamp);
+
 /** @brief       ...
  *
  *  @param[in]   message - ...
@@ -0,0 +1,625 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Message Recorder)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_rec.c
+ *
+ *  @brief       CAN Message Recorder (binary capture files)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @addtogroup  can_rec
+ *  @{
+ */
+
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_rec.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define NSEC_PER_SEC  1000000000ULL
+#define PATH_EXTRA    12U               /* ".<segment>" and zero */
+
+#define VERSION_MAJOR(x)  ((x) >> 8)
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+struct rec_recorder_t_ {                /* recorder: */
+    int fd;                             /*   file descriptor */
+    char *path;                         /*   path of the capture file */
+    uint8_t *buffer;                    /*   aligned file buffer */
+    size_t used;                        /*   number of bytes in the buffer */
+    uint64_t segment_size;              /*   max. size of a file (or 0) */
+    uint64_t file_size;                 /*   bytes written to the current file */
+    uint32_t segment;                   /*   current segment number */
+    uint8_t header[REC_HEADER_SIZE];    /*   file header (of the segment) */
+    rec_stats_t stats;                  /*   statistics */
+};
+
+struct rec_reader_t_ {                  /* reader: */
+    int fd;                             /*   file descriptor */
+    char *path;                         /*   path of the capture file */
+    uint8_t *buffer;                    /*   aligned file buffer */
+    size_t head;                        /*   first unread byte in the buffer */
+    size_t tail;                        /*   first free byte in the buffer */
+    rec_info_t info;                    /*   info of the current segment */
+};
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static void put_u16(uint8_t *ptr, uint16_t value);
+static void put_u32(uint8_t *ptr, uint32_t value);
+static void put_u64(uint8_t *ptr, uint64_t value);
+static uint16_t get_u16(const uint8_t *ptr);
+static uint32_t get_u32(const uint8_t *ptr);
+static uint64_t get_u64(const uint8_t *ptr);
+
+static void encode_header(uint8_t *header, const rec_info_t *info);
+static int decode_header(const uint8_t *header, rec_info_t *info);
+
+static char *segment_path(const char *path, uint32_t segment);
+static int open_segment(rec_recorder_t recorder);
+static int write_buffer(rec_recorder_t recorder);
+static int write_all(int fd, const uint8_t *buffer, size_t length);
+
+static int open_file(rec_reader_t reader, uint32_t segment);
+static int next_segment(rec_reader_t reader);
+static int fill_buffer(rec_reader_t reader, size_t length);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+static const uint8_t dlc_table[16] = {
+    0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U
+};
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+int rec_recorder_create(rec_recorder_t *recorder, const char *path, const rec_info_t *info, uint64_t segment_size) {
+    rec_recorder_t self;
+    struct timespec now;
+    rec_info_t header;
+    int rc;
+
+    if (!recorder || !path)
+        return RECERR_NULLPTR;
+    if (segment_size && (segment_size < (uint64_t)(REC_HEADER_SIZE + REC_RECORD_MAX)))
+        return RECERR_ILLPARA;
+
+    if ((self = (rec_recorder_t)calloc(1U, sizeof(struct rec_recorder_t_))) == NULL)
+        return RECERR_RESOURCE;
+    if ((self->path = strdup(path)) == NULL) {
+        free(self);
+        return RECERR_RESOURCE;
+    }
+    if (posix_memalign((void**)&self->buffer, REC_BUFFER_ALIGN, REC_BUFFER_SIZE) != 0) {
+        free(self->path);
+        free(self);
+        return RECERR_RESOURCE;
+    }
+    self->fd = -1;
+    self->segment_size = segment_size;
+
+    /* the file header (the same for all segments except the segment number) */
+    if (info)
+        memcpy(&header, info, sizeof(rec_info_t));
+    else
+        memset(&header, 0, sizeof(rec_info_t));
+    (void)clock_gettime(CLOCK_REALTIME, &now);
+    header.start.tv_sec = now.tv_sec;
+    header.start.tv_nsec = now.tv_nsec;
+    header.session = ((uint64_t)now.tv_sec * NSEC_PER_SEC) + (uint64_t)now.tv_nsec;
+    header.segment = 0U;
+    encode_header(self->header, &header);
+
+    if ((rc = open_segment(self)) != RECERR_NOERROR) {
+        free(self->buffer);
+        free(self->path);
+        free(self);
+        return rc;
+    }
+    *recorder = self;
+    return RECERR_NOERROR;
+}
+
+int rec_recorder_write(rec_recorder_t recorder, const rec_message_t *messages, size_t count) {
+    const rec_message_t *message;
+    uint64_t timestamp;
+    size_t length, size, i;
+    uint8_t *ptr, flags;
+    int rc;
+
+    if (!recorder || (!messages && count))
+        return RECERR_NULLPTR;
+
+    for (i = 0U; i < count; i++) {
+        message = &messages[i];
+#if (OPTION_CAN_2_0_ONLY == 0)
+        length = message->fdf ? (size_t)dlc_table[message->dlc & 0xFU] : (size_t)((message->dlc < 8U) ? message->dlc : 8U);
+#else
+        length = (size_t)((message->dlc < 8U) ? message->dlc : 8U);
+#endif
+        if (message->rtr)
+            length = 0U;
+        size = REC_RECORD_SIZE(length);
+
+        /* start a new segment if the record does not fit into the current file */
+        if (recorder->segment_size &&
+           ((recorder->file_size + (uint64_t)recorder->used + (uint64_t)size) > recorder->segment_size)) {
+            if ((rc = write_buffer(recorder)) != RECERR_NOERROR)
+                return rc;
+            (void)close(recorder->fd);
+            recorder->fd = -1;
+            recorder->segment += 1U;
+            put_u32(&recorder->header[24], recorder->segment);
+            if ((rc = open_segment(recorder)) != RECERR_NOERROR)
+                return rc;
+        }
+        /* write the buffer to the file if the record does not fit into it */
+        if ((recorder->used + size) > REC_BUFFER_SIZE) {
+            if ((rc = write_buffer(recorder)) != RECERR_NOERROR)
+                return rc;
+        }
+        flags = (message->xtd ? REC_FLAG_XTD : 0U) | (message->rtr ? REC_FLAG_RTR : 0U) |
+#if (OPTION_CAN_2_0_ONLY == 0)
+                (message->fdf ? REC_FLAG_FDF : 0U) | (message->brs ? REC_FLAG_BRS : 0U) |
+                (message->esi ? REC_FLAG_ESI : 0U) |
+#endif
+                (message->sts ? REC_FLAG_STS : 0U);
+        timestamp = ((uint64_t)message->timestamp.tv_sec * NSEC_PER_SEC) + (uint64_t)message->timestamp.tv_nsec;
+
+        ptr = &recorder->buffer[recorder->used];
+        put_u16(&ptr[0], (uint16_t)size);
+        ptr[2] = (uint8_t)REC_TYPE_MESSAGE;
+        ptr[3] = flags;
+        put_u32(&ptr[4], message->id);
+        put_u64(&ptr[8], timestamp);
+        ptr[16] = message->dlc;
+        ptr[17] = ptr[18] = ptr[19] = 0U;
+        memcpy(&ptr[REC_RECORD_HEADER], message->data, length);
+        memset(&ptr[REC_RECORD_HEADER + length], 0, size - REC_RECORD_HEADER - length);
+        recorder->used += size;
+        recorder->stats.records += 1U;
+    }
+    return RECERR_NOERROR;
+}
+
+int rec_recorder_flush(rec_recorder_t recorder) {
+    if (!recorder)
+        return RECERR_NULLPTR;
+
+    return write_buffer(recorder);
+}
+
+int rec_recorder_stats(rec_recorder_t recorder, rec_stats_t *stats) {
+    if (!recorder || !stats)
+        return RECERR_NULLPTR;
+
+    memcpy(stats, &recorder->stats, sizeof(rec_stats_t));
+    stats->bytes += (uint64_t)recorder->used;
+    return RECERR_NOERROR;
+}
+
+int rec_recorder_close(rec_recorder_t recorder) {
+    int rc;
+
+    if (!recorder)
+        return RECERR_NULLPTR;
+
+    rc = write_buffer(recorder);
+    if (recorder->fd >= 0)
+        (void)close(recorder->fd);
+    free(recorder->buffer);
+    free(recorder->path);
+    free(recorder);
+    return rc;
+}
+
+int rec_reader_open(rec_reader_t *reader, const char *path) {
+    rec_reader_t self;
+    int rc;
+
+    if (!reader || !path)
+        return RECERR_NULLPTR;
+
+    if ((self = (rec_reader_t)calloc(1U, sizeof(struct rec_reader_t_))) == NULL)
+        return RECERR_RESOURCE;
+    if ((self->path = strdup(path)) == NULL) {
+        free(self);
+        return RECERR_RESOURCE;
+    }
+    if (posix_memalign((void**)&self->buffer, REC_BUFFER_ALIGN, REC_BUFFER_SIZE) != 0) {
+        free(self->path);
+        free(self);
+        return RECERR_RESOURCE;
+    }
+    self->fd = -1;
+    if ((rc = open_file(self, 0U)) != RECERR_NOERROR) {
+        free(self->buffer);
+        free(self->path);
+        free(self);
+        return rc;
+    }
+    *reader = self;
+    return RECERR_NOERROR;
+}
+
+int rec_reader_info(rec_reader_t reader, rec_info_t *info) {
+    if (!reader || !info)
+        return RECERR_NULLPTR;
+
+    memcpy(info, &reader->info, sizeof(rec_info_t));
+    return RECERR_NOERROR;
+}
+
+int rec_reader_read(rec_reader_t reader, rec_message_t *message) {
+    const uint8_t *ptr;
+    uint64_t timestamp;
+    size_t size, length;
+    uint8_t flags;
+    int rc;
+
+    if (!reader || !message)
+        return RECERR_NULLPTR;
+
+    for (;;) {
+        /* the size of the next record */
+        if ((rc = fill_buffer(reader, 2U)) < 0)
+            return rc;
+        if (rc == 0) {
+            if (reader->head != reader->tail)
+                return RECERR_FORMAT;  /* truncated record */
+            if ((rc = next_segment(reader)) <= 0)
+                return rc;
+            continue;
+        }
+        size = (size_t)get_u16(&reader->buffer[reader->head]);
+        if ((size < REC_RECORD_HEADER) || (size & 3U))
+            return RECERR_FORMAT;
+        /* the whole record */
+        if ((rc = fill_buffer(reader, size)) < 0)
+            return rc;
+        if (rc == 0)
+            return RECERR_FORMAT;  /* truncated record */
+        ptr = &reader->buffer[reader->head];
+        reader->head += size;
+        if (ptr[2] != (uint8_t)REC_TYPE_MESSAGE)
+            continue;  /* skip unknown records */
+        if (size > REC_RECORD_MAX)
+            return RECERR_FORMAT;
+
+        flags = ptr[3];
+        timestamp = get_u64(&ptr[8]);
+        memset(message, 0, sizeof(rec_message_t));
+        message->id = get_u32(&ptr[4]);
+        message->xtd = (flags & REC_FLAG_XTD) ? 1 : 0;
+        message->rtr = (flags & REC_FLAG_RTR) ? 1 : 0;
+#if (OPTION_CAN_2_0_ONLY == 0)
+        message->fdf = (flags & REC_FLAG_FDF) ? 1 : 0;
+        message->brs = (flags & REC_FLAG_BRS) ? 1 : 0;
+        message->esi = (flags & REC_FLAG_ESI) ? 1 : 0;
+#endif
+        message->sts = (flags & REC_FLAG_STS) ? 1 : 0;
+        message->dlc = ptr[16];
+        message->timestamp.tv_sec = (time_t)(timestamp / NSEC_PER_SEC);
+        message->timestamp.tv_nsec = (long)(timestamp % NSEC_PER_SEC);
+        length = size - REC_RECORD_HEADER;
+        if (length > sizeof(message->data))
+            length = sizeof(message->data);
+        memcpy(message->data, &ptr[REC_RECORD_HEADER], length);
+        return 1;
+    }
+}
+
+int rec_reader_rewind(rec_reader_t reader) {
+    if (!reader)
+        return RECERR_NULLPTR;
+
+    return open_file(reader, 0U);
+}
+
+int rec_reader_close(rec_reader_t reader) {
+    if (!reader)
+        return RECERR_NULLPTR;
+
+    if (reader->fd >= 0)
+        (void)close(reader->fd);
+    free(reader->buffer);
+    free(reader->path);
+    free(reader);
+    return RECERR_NOERROR;
+}
+
+/*  -----------  local functions  ----------------------------------------
+ */
+
+static void put_u16(uint8_t *ptr, uint16_t value) {
+    ptr[0] = (uint8_t)value;
+    ptr[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t *ptr, uint32_t value) {
+    ptr[0] = (uint8_t)value;
+    ptr[1] = (uint8_t)(value >> 8);
+    ptr[2] = (uint8_t)(value >> 16);
+    ptr[3] = (uint8_t)(value >> 24);
+}
+
+static void put_u64(uint8_t *ptr, uint64_t value) {
+    put_u32(&ptr[0], (uint32_t)value);
+    put_u32(&ptr[4], (uint32_t)(value >> 32));
+}
+
+static uint16_t get_u16(const uint8_t *ptr) {
+    return (uint16_t)ptr[0] | ((uint16_t)ptr[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *ptr) {
+    return (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *ptr) {
+    return (uint64_t)get_u32(&ptr[0]) | ((uint64_t)get_u32(&ptr[4]) << 32);
+}
+
+static void encode_header(uint8_t *header, const rec_info_t *info) {
+    memset(header, 0, REC_HEADER_SIZE);
+    memcpy(&header[0], REC_FILE_MAGIC, 8U);
+    put_u16(&header[8], (uint16_t)REC_FILE_VERSION);
+    put_u16(&header[10], (uint16_t)REC_HEADER_SIZE);
+    put_u64(&header[16], info->session);
+    put_u32(&header[24], info->segment);
+    put_u32(&header[28], (uint32_t)info->channel);
+    header[32] = info->mode;
+    put_u32(&header[36], (uint32_t)info->bitrate.btr.frequency);
+    if (info->bitrate.btr.frequency > 0) {
+        put_u16(&header[40], info->bitrate.btr.nominal.brp);
+        put_u16(&header[42], info->bitrate.btr.nominal.tseg1);
+        put_u16(&header[44], info->bitrate.btr.nominal.tseg2);
+        put_u16(&header[46], info->bitrate.btr.nominal.sjw);
+        header[48] = info->bitrate.btr.nominal.sam;
+#if (OPTION_CAN_2_0_ONLY == 0)
+        put_u16(&header[50], info->bitrate.btr.data.brp);
+        put_u16(&header[52], info->bitrate.btr.data.tseg1);
+        put_u16(&header[54], info->bitrate.btr.data.tseg2);
+        put_u16(&header[56], info->bitrate.btr.data.sjw);
+#endif
+    }
+    put_u64(&header[64], (uint64_t)info->start.tv_sec);
+    put_u32(&header[72], (uint32_t)info->start.tv_nsec);
+    memcpy(&header[80], info->device, strnlen(info->device, REC_DEVICE_LENGTH - 1U));
+}
+
+static int decode_header(const uint8_t *header, rec_info_t *info) {
+    if (memcmp(&header[0], REC_FILE_MAGIC, 8U) != 0)
+        return RECERR_FORMAT;
+    if (VERSION_MAJOR(get_u16(&header[8])) != VERSION_MAJOR(REC_FILE_VERSION))
+        return RECERR_VERSION;
+    if (get_u16(&header[10]) < REC_HEADER_SIZE)
+        return RECERR_FORMAT;
+
+    memset(info, 0, sizeof(rec_info_t));
+    info->session = get_u64(&header[16]);
+    info->segment = get_u32(&header[24]);
+    info->channel = (int32_t)get_u32(&header[28]);
+    info->mode = header[32];
+    info->bitrate.btr.frequency = (int32_t)get_u32(&header[36]);
+    if (info->bitrate.btr.frequency > 0) {
+        info->bitrate.btr.nominal.brp = get_u16(&header[40]);
+        info->bitrate.btr.nominal.tseg1 = get_u16(&header[42]);
+        info->bitrate.btr.nominal.tseg2 = get_u16(&header[44]);
+        info->bitrate.btr.nominal.sjw = get_u16(&header[46]);
+        info->bitrate.btr.nominal.sam = header[48];
+#if (OPTION_CAN_2_0_ONLY == 0)
+        info->bitrate.btr.data.brp = get_u16(&header[50]);
+        info->bitrate.btr.data.tseg1 = get_u16(&header[52]);
+        info->bitrate.btr.data.tseg2 = get_u16(&header[54]);
+        info->bitrate.btr.data.sjw = get_u16(&header[56]);
+#endif
+    }
+    info->start.tv_sec = (time_t)get_u64(&header[64]);
+    info->start.tv_nsec = (long)get_u32(&header[72]);
+    memcpy(info->device, &header[80], REC_DEVICE_LENGTH - 1U);
+    info->device[REC_DEVICE_LENGTH - 1U] = '\0';
+    return RECERR_NOERROR;
+}
+
+static char *segment_path(const char *path, uint32_t segment) {
+    size_t length = strlen(path) + PATH_EXTRA;
+    char *name;
+
+    if ((name = (char*)malloc(length)) != NULL) {
+        if (segment)
+            (void)snprintf(name, length, "%s.%u", path, (unsigned int)segment);
+        else
+            (void)snprintf(name, length, "%s", path);
+    }
+    return name;
+}
+
+static int open_segment(rec_recorder_t recorder) {
+    char *name;
+
+    if ((name = segment_path(recorder->path, recorder->segment)) == NULL)
+        return RECERR_RESOURCE;
+    recorder->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    free(name);
+    if (recorder->fd < 0)
+        return RECERR_IO;
+    /* the file header goes to the buffer (written with the first records) */
+    memcpy(recorder->buffer, recorder->header, REC_HEADER_SIZE);
+    recorder->used = REC_HEADER_SIZE;
+    recorder->file_size = 0U;
+    recorder->stats.segments += 1U;
+    return RECERR_NOERROR;
+}
+
+static int write_buffer(rec_recorder_t recorder) {
+    int rc = RECERR_NOERROR;
+
+    if (recorder->used && (recorder->fd >= 0)) {
+        rc = write_all(recorder->fd, recorder->buffer, recorder->used);
+        if (rc == RECERR_NOERROR) {
+            recorder->file_size += (uint64_t)recorder->used;
+            recorder->stats.bytes += (uint64_t)recorder->used;
+        }
+        /* note: on error the buffered records are lost */
+        recorder->used = 0U;
+    }
+    return rc;
+}
+
+static int write_all(int fd, const uint8_t *buffer, size_t length) {
+    ssize_t n;
+
+    while (length > 0U) {
+        if ((n = write(fd, buffer, length)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return RECERR_IO;
+        }
+        buffer += n;
+        length -= (size_t)n;
+    }
+    return RECERR_NOERROR;
+}
+
+static int open_file(rec_reader_t reader, uint32_t segment) {
+    rec_info_t info;
+    char *name;
+    int fd, rc;
+
+    if ((name = segment_path(reader->path, segment)) == NULL)
+        return RECERR_RESOURCE;
+    fd = open(name, O_RDONLY);
+    free(name);
+    if (fd < 0)
+        return RECERR_IO;
+    if (reader->fd >= 0)
+        (void)close(reader->fd);
+    reader->fd = fd;
+    reader->head = reader->tail = 0U;
+
+    if ((rc = fill_buffer(reader, REC_HEADER_SIZE)) <= 0)
+        return (rc < 0) ? rc : RECERR_FORMAT;
+    if ((rc = decode_header(&reader->buffer[reader->head], &info)) != RECERR_NOERROR)
+        return rc;
+    if (segment && ((info.session != reader->info.session) || (info.segment != segment)))
+        return RECERR_FORMAT;
+    /* skip the file header (it may be larger than ours) */
+    if ((rc = fill_buffer(reader, (size_t)get_u16(&reader->buffer[reader->head + 10U]))) <= 0)
+        return (rc < 0) ? rc : RECERR_FORMAT;
+    reader->head += (size_t)get_u16(&reader->buffer[reader->head + 10U]);
+    memcpy(&reader->info, &info, sizeof(rec_info_t));
+    return RECERR_NOERROR;
+}
+
+static int next_segment(rec_reader_t reader) {
+    int rc;
+
+    if ((rc = open_file(reader, reader->info.segment + 1U)) == RECERR_NOERROR)
+        return 1;
+    if ((rc == RECERR_IO) && (errno == ENOENT))
+        return 0;  /* end of the capture */
+    return rc;
+}
+
+static int fill_buffer(rec_reader_t reader, size_t length) {
+    ssize_t n;
+
+    /* note: returns 1 if 'length' bytes are in the buffer, 0 at the end of
+     *       the file, or a negative value on error.
+     */
+    while ((reader->tail - reader->head) < length) {
+        if ((reader->head + length) > REC_BUFFER_SIZE) {
+            memmove(reader->buffer, &reader->buffer[reader->head], reader->tail - reader->head);
+            reader->tail -= reader->head;
+            reader->head = 0U;
+        }
+        if ((n = read(reader->fd, &reader->buffer[reader->tail], REC_BUFFER_SIZE - reader->tail)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return RECERR_IO;
+        }
+        if (n == 0)
+            return 0;
+        reader->tail += (size_t)n;
+    }
+    return 1;
+}
+
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
@@ -0,0 +1,374 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Message Recorder)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_rec.h
+ *
+ *  @brief       CAN Message Recorder (binary capture files)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @defgroup    can_rec CAN Message Recorder
+ *  @{
+ */
+#ifndef CAN_REC_H_INCLUDED
+#define CAN_REC_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_msg.h"                    // CAN message (w/ or w/o CAN API V3)
+#include "can_btr.h"                    // CAN bit-rate (w/ or w/o CAN API V3)
+
+#include <stddef.h>                     // C99 header for size_t
+#include <stdint.h>                     // C99 header for sized integer types
+
+
+/*  -----------  options  ------------------------------------------------
+ */
+
+/** @note  Set define OPTION_CANAPI_COMPANIONS to a non-zero value to compile
+ *         this module in conjunction with the CAN API V3 sources (e.g. in
+ *         the build environment).
+ */
+
+/** @note  Capture file format (all values in little-endian byte order):
+ *
+ *         A capture file starts with a file header of REC_HEADER_SIZE bytes:
+ *
+ *         | Offset | Size | Field                                        |
+ *         |-------:|-----:|:---------------------------------------------|
+ *         |      0 |    8 | magic "CANREC\r\n"                           |
+ *         |      8 |    2 | file format version (major.minor)            |
+ *         |     10 |    2 | size of the file header (in bytes)           |
+ *         |     12 |    4 | reserved (0)                                 |
+ *         |     16 |    8 | session id (start time in [ns])              |
+ *         |     24 |    4 | segment number (0, 1, 2, ...)                |
+ *         |     28 |    4 | channel number                               |
+ *         |     32 |    1 | operation mode (can_mode_t)                  |
+ *         |     33 |    3 | reserved (0)                                 |
+ *         |     36 |    4 | frequency (> 0) or bit-rate index (<= 0)     |
+ *         |     40 |    8 | nominal brp, tseg1, tseg2, sjw (16-bit each) |
+ *         |     48 |    1 | nominal sam                                  |
+ *         |     49 |    1 | reserved (0)                                 |
+ *         |     50 |    8 | data brp, tseg1, tseg2, sjw (16-bit each)    |
+ *         |     58 |    6 | reserved (0)                                 |
+ *         |     64 |    8 | start time: seconds                          |
+ *         |     72 |    4 | start time: nanoseconds                      |
+ *         |     76 |    4 | reserved (0)                                 |
+ *         |     80 |   64 | device name (zero-terminated)                |
+ *         |    144 |  112 | reserved (0)                                 |
+ *
+ *         The file header is followed by length-prefixed records, each of
+ *         them aligned to 4 bytes:
+ *
+ *         | Offset | Size | Field                                        |
+ *         |-------:|-----:|:---------------------------------------------|
+ *         |      0 |    2 | size of the record incl. padding (in bytes)  |
+ *         |      2 |    1 | record type (REC_TYPE_MESSAGE)               |
+ *         |      3 |    1 | flags (REC_FLAG_XTD, _RTR, _FDF, ...)        |
+ *         |      4 |    4 | CAN identifier                               |
+ *         |      8 |    8 | time-stamp in [ns]                           |
+ *         |     16 |    1 | data length code                             |
+ *         |     17 |    3 | reserved (0)                                 |
+ *         |     20 |    n | payload (0 .. 64 bytes), padded to 4 bytes   |
+ *
+ *         Records of an unknown type are skipped by the reader.  When the
+ *         recorder rotates files, the n-th segment is written to the file
+ *         '<path>.<n>'; all segments of a capture carry the same session id.
+ */
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+/** @name  Capture File Format
+ *  @brief Properties of the capture file format
+ *  @{ */
+#define REC_FILE_MAGIC      "CANREC\r\n"  /**< magic (8 characters) */
+#define REC_FILE_VERSION       0x0100U  /**< file format version 1.0 */
+#define REC_HEADER_SIZE           256U  /**< size of the file header */
+#define REC_DEVICE_LENGTH          64U  /**< size of the device name (incl. zero) */
+#define REC_RECORD_HEADER          20U  /**< size of a record without payload */
+#define REC_RECORD_SIZE(n)  ((REC_RECORD_HEADER + (n) + 3U) & ~3U)  /**< size of a record */
+#define REC_RECORD_MAX  REC_RECORD_SIZE(64U)  /**< max. size of a message record */
+/** @} */
+
+/** @name  Record Types and Flags
+ *  @brief Record types and message flags of the capture file format
+ *  @{ */
+#define REC_TYPE_MESSAGE             1U /**< record type: CAN message */
+#define REC_FLAG_XTD              0x01U /**< flag: extended format */
+#define REC_FLAG_RTR              0x02U /**< flag: remote frame */
+#define REC_FLAG_FDF              0x04U /**< flag: CAN FD format */
+#define REC_FLAG_BRS              0x08U /**< flag: bit-rate switching */
+#define REC_FLAG_ESI              0x10U /**< flag: error state indicator */
+#define REC_FLAG_STS              0x80U /**< flag: status message */
+/** @} */
+
+/** @name  Buffer Sizes
+ *  @brief Default sizes of the file buffers
+ *  @{ */
+#define REC_BUFFER_SIZE        1048576U /**< size of the file buffer (1 MiB) */
+#define REC_BUFFER_ALIGN          4096U /**< alignment of the file buffer */
+/** @} */
+
+/** @name  Error Codes
+ *  @brief Error codes of the recorder and the reader
+ *  @{ */
+#define RECERR_NOERROR              (0) /**< no error! */
+#define RECERR_IO                  (-1) /**< file I/O error (see errno) */
+#define RECERR_FORMAT              (-2) /**< not a capture file or file corrupted */
+#define RECERR_VERSION             (-3) /**< file format version not supported */
+#define RECERR_RESOURCE           (-90) /**< resource allocation */
+#define RECERR_ILLPARA            (-93) /**< illegal parameter */
+#define RECERR_NULLPTR            (-94) /**< null-pointer assignment */
+/** @} */
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+/** @brief       CAN Message (with Time-stamp):
+ */
+typedef msg_message_t rec_message_t;
+
+/** @brief       CAN Bit-rate Settings:
+ */
+#ifdef CANMSG_STANDALONE
+typedef btr_bitrate_t rec_bitrate_t;    /* bit-rate settings (can_btr) */
+#else
+typedef can_bitrate_t rec_bitrate_t;    /* CAN API V3 bit-rate settings */
+#endif
+
+/** @brief       Capture Information (from the file header):
+ */
+typedef struct rec_info_t_ {
+    int32_t channel;                    /**< channel number */
+    uint8_t mode;                       /**< operation mode (can_mode_t) */
+    rec_bitrate_t bitrate;              /**< bit-rate settings */
+    char device[REC_DEVICE_LENGTH];     /**< device name (zero-terminated) */
+    uint64_t session;                   /**< session id (read-only) */
+    uint32_t segment;                   /**< segment number (read-only) */
+    msg_timestamp_t start;              /**< start time (read-only) */
+} rec_info_t;
+
+/** @brief       Recorder Statistics:
+ */
+typedef struct rec_stats_t_ {
+    uint64_t records;                   /**< number of records written */
+    uint64_t bytes;                     /**< number of bytes written */
+    uint32_t segments;                  /**< number of segments (files) */
+} rec_stats_t;
+
+/** @brief       Recorder (opaque handle):
+ */
+typedef struct rec_recorder_t_ *rec_recorder_t;
+
+/** @brief       Reader (opaque handle):
+ */
+typedef struct rec_reader_t_ *rec_reader_t;
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+/** @brief       creates a capture file and writes the file header.
+ *
+ *  @note        The records are collected in an aligned buffer of REC_BUFFER_SIZE
+ *               bytes, which is written to the file when it is full.  When a
+ *               segment size is given, the recorder continues with a new file
+ *               '<path>.<n>' before the size of the current file would exceed it.
+ *
+ *  @param[out]  recorder     - handle of the recorder
+ *  @param[in]   path         - path of the capture file
+ *  @param[in]   info         - channel number, operation mode, bit-rate settings
+ *                              and device name for the file header (or NULL)
+ *  @param[in]   segment_size - max. size of a file (in bytes), or 0 (no rotation)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the file could not be created (see errno)
+ *  @retval      RECERR_RESOURCE - resource allocation failed
+ *  @retval      RECERR_ILLPARA  - segment size too small
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_recorder_create(rec_recorder_t *recorder, const char *path, const rec_info_t *info, uint64_t segment_size);
+
+/** @brief       writes CAN messages to the capture file.
+ *
+ *  @param[in]   recorder - handle of the recorder
+ *  @param[in]   messages - array of CAN messages
+ *  @param[in]   count    - number of CAN messages
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the messages could not be written (see errno)
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_recorder_write(rec_recorder_t recorder, const rec_message_t *messages, size_t count);
+
+/** @brief       writes the buffered records to the capture file.
+ *
+ *  @param[in]   recorder - handle of the recorder
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the records could not be written (see errno)
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_recorder_flush(rec_recorder_t recorder);
+
+/** @brief       retrieves the statistics of the recorder.
+ *
+ *  @param[in]   recorder - handle of the recorder
+ *  @param[out]  stats    - number of records, bytes and segments written
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_recorder_stats(rec_recorder_t recorder, rec_stats_t *stats);
+
+/** @brief       flushes the buffered records, closes the capture file and
+ *               releases the recorder.
+ *
+ *  @param[in]   recorder - handle of the recorder
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the records could not be written (see errno)
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_recorder_close(rec_recorder_t recorder);
+
+/** @brief       opens a capture file and reads the file header.
+ *
+ *  @note        At the end of a file the reader continues with the next
+ *               segment '<path>.<n>' of the same session, if it exists.
+ *
+ *  @param[out]  reader - handle of the reader
+ *  @param[in]   path   - path of the capture file (first segment)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the file could not be opened (see errno)
+ *  @retval      RECERR_FORMAT   - not a capture file
+ *  @retval      RECERR_VERSION  - file format version not supported
+ *  @retval      RECERR_RESOURCE - resource allocation failed
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_reader_open(rec_reader_t *reader, const char *path);
+
+/** @brief       retrieves the capture information from the file header.
+ *
+ *  @param[in]   reader - handle of the reader
+ *  @param[out]  info   - capture information (of the current segment)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_reader_info(rec_reader_t reader, rec_info_t *info);
+
+/** @brief       reads the next CAN message from the capture file.
+ *
+ *  @param[in]   reader  - handle of the reader
+ *  @param[out]  message - the CAN message read
+ *
+ *  @returns     1 if a message has been read, 0 at the end of the capture,
+ *               or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the file could not be read (see errno)
+ *  @retval      RECERR_FORMAT   - file corrupted
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_reader_read(rec_reader_t reader, rec_message_t *message);
+
+/** @brief       rewinds the reader to the first message of the capture.
+ *
+ *  @param[in]   reader - handle of the reader
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_IO       - the file could not be opened (see errno)
+ *  @retval      RECERR_FORMAT   - not a capture file
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_reader_rewind(rec_reader_t reader);
+
+/** @brief       closes the capture file and releases the reader.
+ *
+ *  @param[in]   reader - handle of the reader
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RECERR_NULLPTR  - null-pointer assignment
+ */
+int rec_reader_close(rec_reader_t reader);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_REC_H_INCLUDED */
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
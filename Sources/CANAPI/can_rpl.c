@@ -0,0 +1,565 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Message Replayer)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_rpl.c
+ *
+ *  @brief       CAN Message Replayer (timing-accurate replay of recorded traffic)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @addtogroup  can_rpl
+ *  @{
+ */
+
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_rpl.h"
+#include "can_rec.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <math.h>
+
+#include <time.h>
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+#define NSEC_PER_SEC  1000000000ULL
+#define NSEC_PER_USEC       1000ULL
+#define SLEEP_SLICE     10000000ULL     /* max. sleep time (to look for a stop request) */
+
+#define MAX_STD_ID    0x7FFU
+#define MAX_XTD_ID    0x1FFFFFFFU
+#define ERR_FLAG      0x20000000U       /* candump: error frame (SocketCAN CAN_ERR_FLAG) */
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+struct rpl_replayer_t_ {                /* replayer: */
+    rec_reader_t reader;                /*   binary capture file (or NULL) */
+    FILE *file;                         /*   candump log file (or NULL) */
+    rpl_options_t options;              /*   replayer options */
+    int stopped;                        /*   stop request (atomic) */
+    uint64_t first;                     /*   time-stamp of the first message in [nsec] */
+    uint64_t last;                      /*   time-stamp of the previous message in [nsec] */
+    uint64_t start;                     /*   start of the pass (monotonic clock) */
+    rpl_stats_t stats;                  /*   statistics */
+    uint64_t accounted;                 /*   number of messages with a timing error */
+    int64_t error_sum;                  /*   sum of the timing errors in [nsec] */
+    uint64_t histogram[RPL_HISTOGRAM_SIZE];  /* absolute timing errors in [usec] */
+};
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+static int read_message(rpl_replayer_t replayer, rpl_message_t *message);
+static int read_line(rpl_replayer_t replayer, rpl_message_t *message);
+static int parse_candump(const char *line, rpl_message_t *message);
+static int rewind_capture(rpl_replayer_t replayer);
+
+static uint64_t due_time(rpl_replayer_t replayer, const rpl_message_t *message);
+static int wait_until(rpl_replayer_t replayer, uint64_t deadline);
+static void account(rpl_replayer_t replayer, uint64_t now, const uint64_t *deadlines, size_t count);
+static void summarize(rpl_replayer_t replayer);
+static uint64_t percentile(rpl_replayer_t replayer, uint64_t permille);
+
+static uint64_t now_nsec(void);
+static int hex_digit(char c);
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+static const uint8_t dlc_table[16] = {
+    0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U
+};
+
+
+/*  -----------  functions  ----------------------------------------------
+ */
+
+int rpl_options_default(rpl_options_t *options) {
+    if (!options)
+        return RPLERR_NULLPTR;
+
+    memset(options, 0, sizeof(rpl_options_t));
+    options->speed = 1.0;
+    options->loops = 1U;
+    options->spin_time = RPL_SPIN_TIME;
+    options->max_batch = RPL_MAX_BATCH;
+    return RPLERR_NOERROR;
+}
+
+int rpl_replayer_open(rpl_replayer_t *replayer, const char *path, const rpl_options_t *options) {
+    rpl_replayer_t self;
+    uint32_t i;
+    int rc;
+
+    if (!replayer || !path)
+        return RPLERR_NULLPTR;
+    if (options) {
+        if (!isfinite(options->speed) || (options->speed < 0.0))
+            return RPLERR_ILLPARA;
+        if ((options->max_batch < 1U) || (options->max_batch > RPL_MAX_BATCH))
+            return RPLERR_ILLPARA;
+        if (options->num_remaps > RPL_MAX_REMAP)
+            return RPLERR_ILLPARA;
+        for (i = 0U; i < options->num_remaps; i++) {
+            if ((options->remap[i].from > MAX_XTD_ID) || (options->remap[i].to > MAX_XTD_ID))
+                return RPLERR_ILLPARA;
+        }
+    }
+    if ((self = (rpl_replayer_t)calloc(1U, sizeof(struct rpl_replayer_t_))) == NULL)
+        return RPLERR_RESOURCE;
+    if (options)
+        memcpy(&self->options, options, sizeof(rpl_options_t));
+    else
+        (void)rpl_options_default(&self->options);
+
+    /* a binary capture file, or else a candump log file */
+    switch ((rc = rec_reader_open(&self->reader, path))) {
+        case RECERR_NOERROR:
+            break;
+        case RECERR_FORMAT:
+            self->reader = NULL;
+            if ((self->file = fopen(path, "r")) == NULL) {
+                free(self);
+                return RPLERR_IO;
+            }
+            break;
+        default:
+            free(self);
+            return (rc == RECERR_IO) ? RPLERR_IO : (rc == RECERR_RESOURCE) ? RPLERR_RESOURCE : RPLERR_FORMAT;
+    }
+    *replayer = self;
+    return RPLERR_NOERROR;
+}
+
+int rpl_replayer_run(rpl_replayer_t replayer, rpl_sender_t sender, void *context) {
+    rpl_message_t batch[RPL_MAX_BATCH];
+    uint64_t deadlines[RPL_MAX_BATCH];
+    rpl_message_t next;
+    uint64_t started, horizon, deadline, now;
+    uint64_t window;
+    uint32_t pass;
+    size_t count;
+    int rc, res;
+
+    if (!replayer || !sender)
+        return RPLERR_NULLPTR;
+
+    memset(&replayer->stats, 0, sizeof(rpl_stats_t));
+    memset(replayer->histogram, 0, sizeof(replayer->histogram));
+    replayer->accounted = 0U;
+    replayer->error_sum = 0;
+    __atomic_store_n(&replayer->stopped, 0, __ATOMIC_RELEASE);
+    replayer->stats.error_min = INT64_MAX;
+    replayer->stats.error_max = INT64_MIN;
+    window = (uint64_t)replayer->options.window * NSEC_PER_USEC;
+    started = now_nsec();
+    rc = RPLERR_NOERROR;
+
+    for (pass = 0U; (replayer->options.loops == 0U) || (pass < replayer->options.loops); pass++) {
+        if ((pass > 0U) && ((rc = rewind_capture(replayer)) < 0))
+            break;
+        /* the first message of the capture starts the clock */
+        if ((rc = read_message(replayer, &next)) <= 0)
+            break;  /* note: an empty capture is not replayed endlessly */
+        replayer->first = replayer->last = (uint64_t)next.timestamp.tv_sec * NSEC_PER_SEC + (uint64_t)next.timestamp.tv_nsec;
+        replayer->start = now_nsec();
+
+        while (rc > 0) {
+            /* wait for the next message to be due */
+            deadline = due_time(replayer, &next);
+            if ((rc = wait_until(replayer, deadline)) < 0)
+                break;
+            batch[0] = next;
+            deadlines[0] = deadline;
+            count = 1U;
+            /* collect the messages that are due as well (or within the window) */
+            if ((horizon = deadline + window) < (now = now_nsec()))
+                horizon = now;
+            while ((rc = read_message(replayer, &next)) > 0) {
+                deadline = due_time(replayer, &next);
+                if ((count >= (size_t)replayer->options.max_batch) || (deadline > horizon))
+                    break;  /* note: the message is pending */
+                batch[count] = next;
+                deadlines[count] = deadline;
+                count++;
+            }
+            if (rc < 0)
+                break;
+            /* hand them over to the sender */
+            now = now_nsec();
+            if ((res = sender(context, batch, count)) < 0) {
+                rc = res;
+                break;
+            }
+            account(replayer, now, deadlines, count);
+        }
+        if (rc < 0)
+            break;
+        replayer->stats.loops++;
+    }
+    replayer->stats.duration = now_nsec() - started;
+    summarize(replayer);
+    return (rc < 0) ? rc : RPLERR_NOERROR;
+}
+
+int rpl_replayer_stop(rpl_replayer_t replayer) {
+    if (!replayer)
+        return RPLERR_NULLPTR;
+
+    __atomic_store_n(&replayer->stopped, 1, __ATOMIC_RELEASE);
+    return RPLERR_NOERROR;
+}
+
+int rpl_replayer_stats(rpl_replayer_t replayer, rpl_stats_t *stats) {
+    if (!replayer || !stats)
+        return RPLERR_NULLPTR;
+
+    memcpy(stats, &replayer->stats, sizeof(rpl_stats_t));
+    return RPLERR_NOERROR;
+}
+
+int rpl_replayer_close(rpl_replayer_t replayer) {
+    if (!replayer)
+        return RPLERR_NULLPTR;
+
+    if (replayer->reader)
+        (void)rec_reader_close(replayer->reader);
+    if (replayer->file)
+        (void)fclose(replayer->file);
+    free(replayer);
+    return RPLERR_NOERROR;
+}
+
+static int read_message(rpl_replayer_t replayer, rpl_message_t *message) {
+    const rpl_options_t *options = &replayer->options;
+    uint32_t i;
+    int rc;
+
+    for (;;) {
+        if (replayer->reader)
+            rc = rec_reader_read(replayer->reader, (rec_message_t*)message);
+        else
+            rc = read_line(replayer, message);
+        if (rc <= 0)
+            return (rc == RECERR_IO) ? RPLERR_IO : (rc < 0) ? RPLERR_FORMAT : 0;
+        /* status messages cannot be sent, and the acceptance filter */
+        if (message->sts || ((message->id ^ options->filter_code) & options->filter_mask)) {
+            replayer->stats.filtered++;
+            continue;
+        }
+        /* identifier mapping (identifiers above 7FFh are sent in extended format) */
+        for (i = 0U; i < options->num_remaps; i++) {
+            if (message->id == options->remap[i].from) {
+                message->id = options->remap[i].to;
+                if (message->id > MAX_STD_ID)
+                    message->xtd = 1;
+                break;
+            }
+        }
+        return 1;
+    }
+}
+
+static int read_line(rpl_replayer_t replayer, rpl_message_t *message) {
+    char line[RPL_LINE_LENGTH];
+    size_t length;
+    int rc;
+
+    for (;;) {
+        if (fgets(line, (int)sizeof(line), replayer->file) == NULL)
+            return ferror(replayer->file) ? RPLERR_IO : 0;
+        length = strlen(line);
+        if ((length > 0U) && (line[length - 1U] != '\n') && !feof(replayer->file))
+            return RPLERR_FORMAT;  /* line too long */
+        if ((rc = parse_candump(line, message)) != 0)
+            return rc;
+        /* note: empty lines are skipped */
+    }
+}
+
+static int parse_candump(const char *line, rpl_message_t *message) {
+    const char *ptr = line;
+    uint64_t sec = 0U, frac = 0U;
+    uint32_t id = 0U, digits, length;
+    int nibble, hi, lo;
+
+    /* candump log file: '(<sec>.<usec>) <interface> <id>#<data>' */
+    while ((*ptr == ' ') || (*ptr == '\t'))
+        ptr++;
+    if ((*ptr == '\0') || (*ptr == '\r') || (*ptr == '\n'))
+        return 0;
+    memset(message, 0, sizeof(rpl_message_t));
+    /* - time-stamp (seconds and fraction) */
+    if (*ptr++ != '(')
+        return RPLERR_FORMAT;
+    for (digits = 0U; (*ptr >= '0') && (*ptr <= '9'); ptr++, digits++)
+        sec = sec * 10U + (uint64_t)(*ptr - '0');
+    if (!digits || (*ptr++ != '.'))
+        return RPLERR_FORMAT;
+    for (digits = 0U; (*ptr >= '0') && (*ptr <= '9'); ptr++, digits++) {
+        if (digits < 9U)
+            frac = frac * 10U + (uint64_t)(*ptr - '0');
+    }
+    if (!digits || (*ptr++ != ')'))
+        return RPLERR_FORMAT;
+    for (; digits < 9U; digits++)
+        frac *= 10U;
+    message->timestamp.tv_sec = (time_t)sec;
+    message->timestamp.tv_nsec = (long)frac;
+    /* - interface name (ignored) */
+    while ((*ptr == ' ') || (*ptr == '\t'))
+        ptr++;
+    while ((*ptr != ' ') && (*ptr != '\t') && (*ptr != '\0'))
+        ptr++;
+    while ((*ptr == ' ') || (*ptr == '\t'))
+        ptr++;
+    /* - identifier (3 digits = standard, 8 digits = extended format) */
+    for (digits = 0U; (nibble = hex_digit(*ptr)) >= 0; ptr++, digits++)
+        id = (id << 4) | (uint32_t)nibble;
+    if (((digits != 3U) && (digits != 8U)) || (*ptr++ != '#'))
+        return RPLERR_FORMAT;
+    message->xtd = (digits == 8U) ? 1 : 0;
+    message->sts = (message->xtd && (id & ERR_FLAG)) ? 1 : 0;
+    message->id = id & MAX_XTD_ID;
+    if (!message->xtd && (message->id > MAX_STD_ID))
+        return RPLERR_FORMAT;
+    /* - remote frame ('R' and optional DLC) or CAN FD flags ('#' and one digit) */
+    if (*ptr == 'R') {
+        message->rtr = 1;
+        if ((nibble = hex_digit(*++ptr)) >= 0) {
+            if (nibble > 8)
+                return RPLERR_FORMAT;
+            message->dlc = (uint8_t)nibble;
+        }
+        return 1;
+    }
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if (*ptr == '#') {
+        if ((nibble = hex_digit(*++ptr)) < 0)
+            return RPLERR_FORMAT;
+        message->fdf = 1;
+        message->brs = (nibble & 0x1) ? 1 : 0;
+        message->esi = (nibble & 0x2) ? 1 : 0;
+        ptr++;
+    }
+#endif
+    /* - payload (optionally separated by dots) */
+    for (length = 0U; ; length++) {
+        if (*ptr == '.')
+            ptr++;
+        if ((hi = hex_digit(ptr[0])) < 0)
+            break;
+        if (((lo = hex_digit(ptr[1])) < 0) || (length >= (uint32_t)sizeof(message->data)))
+            return RPLERR_FORMAT;
+        message->data[length] = (uint8_t)((hi << 4) | lo);
+        ptr += 2;
+    }
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if (message->fdf) {
+        for (message->dlc = 0U; message->dlc < 15U; message->dlc++) {
+            if (dlc_table[message->dlc] >= (uint8_t)length)
+                break;
+        }
+        if (dlc_table[message->dlc] != (uint8_t)length)
+            return RPLERR_FORMAT;  /* not a CAN FD length */
+        return 1;
+    }
+#endif
+    if (length > 8U)
+        return RPLERR_FORMAT;
+    message->dlc = (uint8_t)length;
+    /* - DLC of a classic CAN frame with 8 data bytes ('_' and one digit) */
+    if ((length == 8U) && (*ptr == '_') && ((nibble = hex_digit(ptr[1])) > 8))
+        message->dlc = (uint8_t)nibble;
+    return 1;
+}
+
+static int rewind_capture(rpl_replayer_t replayer) {
+    if (replayer->reader) {
+        switch (rec_reader_rewind(replayer->reader)) {
+            case RECERR_NOERROR: return RPLERR_NOERROR;
+            case RECERR_IO: return RPLERR_IO;
+            default: return RPLERR_FORMAT;
+        }
+    }
+    if (fseek(replayer->file, 0L, SEEK_SET) != 0)
+        return RPLERR_IO;
+    clearerr(replayer->file);
+    return RPLERR_NOERROR;
+}
+
+static uint64_t due_time(rpl_replayer_t replayer, const rpl_message_t *message) {
+    uint64_t stamp = (uint64_t)message->timestamp.tv_sec * NSEC_PER_SEC + (uint64_t)message->timestamp.tv_nsec;
+
+    /* note: time-stamps going backwards are replayed without delay */
+    if (stamp < replayer->last)
+        stamp = replayer->last;
+    replayer->last = stamp;
+    if (replayer->options.speed <= 0.0)
+        return 0U;  /* as fast as possible */
+    if (replayer->options.speed == 1.0)
+        return replayer->start + (stamp - replayer->first);
+    return replayer->start + (uint64_t)((double)(stamp - replayer->first) / replayer->options.speed);
+}
+
+static int wait_until(rpl_replayer_t replayer, uint64_t deadline) {
+    uint64_t spin = (uint64_t)replayer->options.spin_time * NSEC_PER_USEC;
+    uint64_t now, remaining;
+    struct timespec delay;
+
+    /* sleep until shortly before the deadline, then spin */
+    for (;;) {
+        if (__atomic_load_n(&replayer->stopped, __ATOMIC_ACQUIRE))
+            return RPLERR_STOPPED;
+        if ((now = now_nsec()) >= deadline)
+            return RPLERR_NOERROR;
+        remaining = deadline - now;
+        if (remaining > spin) {
+            remaining -= spin;
+            if (remaining > SLEEP_SLICE)
+                remaining = SLEEP_SLICE;
+            delay.tv_sec = (time_t)(remaining / NSEC_PER_SEC);
+            delay.tv_nsec = (long)(remaining % NSEC_PER_SEC);
+            (void)nanosleep(&delay, NULL);
+        }
+    }
+}
+
+static void account(rpl_replayer_t replayer, uint64_t now, const uint64_t *deadlines, size_t count) {
+    rpl_stats_t *stats = &replayer->stats;
+    uint64_t bin;
+    int64_t error;
+    size_t i;
+
+    stats->messages += (uint64_t)count;
+    stats->batches++;
+    if (replayer->options.speed <= 0.0)
+        return;  /* no deadlines */
+    for (i = 0U; i < count; i++) {
+        error = (int64_t)(now - deadlines[i]);  /* note: negative when handed over early */
+        if (error < stats->error_min)
+            stats->error_min = error;
+        if (error > stats->error_max)
+            stats->error_max = error;
+        if (error > (int64_t)RPL_LATE_LIMIT * (int64_t)NSEC_PER_USEC)
+            stats->late++;
+        replayer->error_sum += error;
+        bin = (uint64_t)((error < 0) ? -error : error) / NSEC_PER_USEC;
+        replayer->histogram[(bin < RPL_HISTOGRAM_SIZE) ? bin : (RPL_HISTOGRAM_SIZE - 1U)]++;
+        replayer->accounted++;
+    }
+}
+
+static void summarize(rpl_replayer_t replayer) {
+    rpl_stats_t *stats = &replayer->stats;
+
+    if (replayer->accounted == 0U) {
+        stats->error_min = stats->error_max = stats->error_avg = 0;
+        stats->error_p50 = stats->error_p99 = stats->error_p999 = 0U;
+        return;
+    }
+    stats->error_avg = replayer->error_sum / (int64_t)replayer->accounted;
+    stats->error_p50 = percentile(replayer, 500U);
+    stats->error_p99 = percentile(replayer, 990U);
+    stats->error_p999 = percentile(replayer, 999U);
+}
+
+static uint64_t percentile(rpl_replayer_t replayer, uint64_t permille) {
+    uint64_t rank = (replayer->accounted * permille + 999U) / 1000U;
+    uint64_t sum = 0U;
+    uint64_t bin;
+    int64_t max;
+
+    for (bin = 0U; bin < (RPL_HISTOGRAM_SIZE - 1U); bin++) {
+        if ((sum += replayer->histogram[bin]) >= rank)
+            return bin * NSEC_PER_USEC;
+    }
+    /* the last bin collects the rest: take the max. error */
+    max = (replayer->stats.error_max > -replayer->stats.error_min) ? replayer->stats.error_max : -replayer->stats.error_min;
+    return (uint64_t)max;
+}
+
+static uint64_t now_nsec(void) {
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+}
+
+static int hex_digit(char c) {
+    if ((c >= '0') && (c <= '9'))
+        return (int)(c - '0');
+    if ((c >= 'A') && (c <= 'F'))
+        return (int)(c - 'A') + 10;
+    if ((c >= 'a') && (c <= 'f'))
+        return (int)(c - 'a') + 10;
+    return -1;
+}
+
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
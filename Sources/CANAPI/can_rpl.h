@@ -0,0 +1,284 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (Message Replayer)
+ *
+ *  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+ *  All rights reserved.
+ *
+ *  This file is part of CAN API V3.
+ *
+ *  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  CAN API V3 is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CAN API V3 is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @file        can_rpl.h
+ *
+ *  @brief       CAN Message Replayer (timing-accurate replay of recorded traffic)
+ *
+ *  @author      $Author: haumea $
+ *
+ *  @version     $Rev: 1044 $
+ *
+ *  @defgroup    can_rpl CAN Message Replayer
+ *  @{
+ */
+#ifndef CAN_RPL_H_INCLUDED
+#define CAN_RPL_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  -----------  includes  -----------------------------------------------
+ */
+
+#include "can_msg.h"                    // CAN message (w/ or w/o CAN API V3)
+
+#include <stddef.h>                     // C99 header for size_t
+#include <stdint.h>                     // C99 header for sized integer types
+
+
+/*  -----------  options  ------------------------------------------------
+ */
+
+/** @note  Set define OPTION_CANAPI_COMPANIONS to a non-zero value to compile
+ *         this module in conjunction with the CAN API V3 sources (e.g. in
+ *         the build environment).
+ */
+
+/** @note  The replayer reads a capture file, either a binary capture file
+ *         (see can_rec.h) or a candump log file (e.g. written by can_exp.h),
+ *         and hands the CAN messages over to a sender callback at the same
+ *         relative time as they were recorded (divided by a speed factor).
+ *
+ *         Each deadline is taken from the monotonic clock: the replayer
+ *         sleeps until shortly before the deadline and spins for the rest
+ *         of the time (spin time).  Messages that are due at once (or within
+ *         a window after the deadline) are handed over together, so that the
+ *         sender can put them into one USB transfer.
+ *
+ *         The timing error of a message is the time when it was handed over
+ *         to the sender minus its deadline.  Status messages (error frames)
+ *         are not replayed.
+ */
+
+
+/*  -----------  defines  ------------------------------------------------
+ */
+
+/** @name  Replayer Limits
+ *  @brief Limits and default values of the replayer
+ *  @{ */
+#define RPL_MAX_BATCH              16U  /**< max. number of messages handed over at once */
+#define RPL_MAX_REMAP              16U  /**< max. number of identifier mappings */
+#define RPL_SPIN_TIME             200U  /**< default spin time before a deadline in [usec] */
+#define RPL_LATE_LIMIT           1000U  /**< a message is late after this time in [usec] */
+#define RPL_HISTOGRAM_SIZE       4096U  /**< timing error histogram in [usec] (the last bin collects the rest) */
+#define RPL_LINE_LENGTH           256U  /**< max. length of a line in a candump log file */
+/** @} */
+
+/** @name  Error Codes
+ *  @brief Error codes of the replayer
+ *  @{ */
+#define RPLERR_NOERROR               0  /**< no error! */
+#define RPLERR_IO                  (-1) /**< file i/o error (see errno) */
+#define RPLERR_FORMAT              (-2) /**< not a capture file or file corrupted */
+#define RPLERR_STOPPED             (-3) /**< replay stopped (rpl_replayer_stop) */
+#define RPLERR_RESOURCE           (-90) /**< resource allocation failed */
+#define RPLERR_ILLPARA            (-93) /**< illegal parameter */
+#define RPLERR_NULLPTR            (-94) /**< null-pointer assignment */
+/** @} */
+
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+/** @brief       CAN Message (with Time-stamp):
+ */
+typedef msg_message_t rpl_message_t;
+
+/** @brief       Identifier Mapping:
+ */
+typedef struct rpl_remap_t_ {
+    uint32_t from;                      /**< CAN identifier in the capture */
+    uint32_t to;                        /**< CAN identifier to be sent */
+} rpl_remap_t;
+
+/** @brief       Replayer Options:
+ */
+typedef struct rpl_options_t_ {
+    double speed;                       /**< speed factor (1.0 = original timing, 0.0 = no delay) */
+    uint32_t loops;                     /**< number of passes (0 = until stopped) */
+    uint32_t spin_time;                 /**< spin time before a deadline in [usec] (0 = sleep only) */
+    uint32_t max_batch;                 /**< max. number of messages handed over at once (1..RPL_MAX_BATCH) */
+    uint32_t window;                    /**< messages due within this time after a deadline are handed over together [usec] */
+    uint32_t filter_code;               /**< acceptance code: a message passes if ((id ^ code) & mask) == 0 */
+    uint32_t filter_mask;               /**< acceptance mask (0 = all messages pass) */
+    uint32_t num_remaps;                /**< number of identifier mappings */
+    rpl_remap_t remap[RPL_MAX_REMAP];   /**< identifier mappings (applied after the filter) */
+} rpl_options_t;
+
+/** @brief       Replayer Statistics:
+ */
+typedef struct rpl_stats_t_ {
+    uint64_t messages;                  /**< number of messages handed over */
+    uint64_t batches;                   /**< number of calls of the sender */
+    uint64_t filtered;                  /**< number of messages not replayed (filter, status messages) */
+    uint64_t late;                      /**< number of messages handed over more than RPL_LATE_LIMIT late */
+    uint32_t loops;                     /**< number of completed passes */
+    int64_t error_min;                  /**< min. timing error in [nsec] */
+    int64_t error_max;                  /**< max. timing error in [nsec] */
+    int64_t error_avg;                  /**< average timing error in [nsec] */
+    uint64_t error_p50;                 /**< median of the absolute timing error in [nsec] (usec resolution) */
+    uint64_t error_p99;                 /**< 99th percentile of the absolute timing error in [nsec] (usec resolution) */
+    uint64_t error_p999;                /**< 99.9th percentile of the absolute timing error in [nsec] (usec resolution) */
+    uint64_t duration;                  /**< duration of the replay in [nsec] */
+} rpl_stats_t;
+
+/** @brief       Sender Callback:
+ *
+ *  @param[in]   context  - context given to rpl_replayer_run
+ *  @param[in]   messages - array of CAN messages that are due
+ *  @param[in]   count    - number of CAN messages (1..max_batch)
+ *
+ *  @returns     0 if all messages have been sent, or a negative value to
+ *               stop the replay (the value is returned by rpl_replayer_run).
+ */
+typedef int (*rpl_sender_t)(void *context, const rpl_message_t *messages, size_t count);
+
+/** @brief       Replayer Handle (opaque):
+ */
+typedef struct rpl_replayer_t_ *rpl_replayer_t;
+
+
+/*  -----------  variables  ----------------------------------------------
+ */
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+/** @brief       initializes the replayer options with their default values
+ *               (original timing, one pass, RPL_SPIN_TIME, RPL_MAX_BATCH,
+ *               no window, no filter and no identifier mapping).
+ *
+ *  @param[out]  options - replayer options
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RPLERR_NULLPTR  - null-pointer assignment
+ */
+int rpl_options_default(rpl_options_t *options);
+
+/** @brief       opens a capture file (binary capture file or candump log
+ *               file) and creates a replayer for it.
+ *
+ *  @param[out]  replayer - handle of the replayer
+ *  @param[in]   path     - path of the capture file
+ *  @param[in]   options  - replayer options (or NULL for default values)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RPLERR_IO       - the file could not be opened (see errno)
+ *  @retval      RPLERR_FORMAT   - file format version not supported
+ *  @retval      RPLERR_RESOURCE - resource allocation failed
+ *  @retval      RPLERR_ILLPARA  - illegal speed factor, batch size or mapping
+ *  @retval      RPLERR_NULLPTR  - null-pointer assignment
+ */
+int rpl_replayer_open(rpl_replayer_t *replayer, const char *path, const rpl_options_t *options);
+
+/** @brief       replays the capture: hands the CAN messages over to the
+ *               sender when they are due (blocking until all passes are
+ *               done or the replay is stopped).
+ *
+ *  @param[in]   replayer - handle of the replayer
+ *  @param[in]   sender   - sender callback
+ *  @param[in]   context  - context for the sender callback (or NULL)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RPLERR_IO       - the file could not be read (see errno)
+ *  @retval      RPLERR_FORMAT   - file corrupted (or a line could not be parsed)
+ *  @retval      RPLERR_STOPPED  - the replay has been stopped
+ *  @retval      RPLERR_NULLPTR  - null-pointer assignment
+ *  @retval      others          - the error returned by the sender
+ */
+int rpl_replayer_run(rpl_replayer_t replayer, rpl_sender_t sender, void *context);
+
+/** @brief       stops a running replay (e.g. from a signal handler).
+ *
+ *  @param[in]   replayer - handle of the replayer
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RPLERR_NULLPTR  - null-pointer assignment
+ */
+int rpl_replayer_stop(rpl_replayer_t replayer);
+
+/** @brief       retrieves the statistics of the (last) replay.
+ *
+ *  @param[in]   replayer - handle of the replayer
+ *  @param[out]  stats    - number of messages and timing error statistics
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RPLERR_NULLPTR  - null-pointer assignment
+ */
+int rpl_replayer_stats(rpl_replayer_t replayer, rpl_stats_t *stats);
+
+/** @brief       closes the capture file and releases the replayer.
+ *
+ *  @param[in]   replayer - handle of the replayer
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      RPLERR_NULLPTR  - null-pointer assignment
+ */
+int rpl_replayer_close(rpl_replayer_t replayer);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_RPL_H_INCLUDED */
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
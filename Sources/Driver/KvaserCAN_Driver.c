@@ -50,11 +50,22 @@
 #include "KvaserCAN_Devices.h"
 #include "KvaserUSB_LeafDevice.h"
 #include "KvaserUSB_MhydraDevice.h"
+#include "KvaserUSB_SharedDevice.h"
+#include "KvaserUSB_LoadMeter.h"
+#include "KvaserUSB_FlightRec.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <errno.h>
 #include <assert.h>
 
+#define SINCE(value,baseline)  (((value) >= (baseline)) ? ((value) - (baseline)) : (value))  /* note: counter may have been cleared */
+
+static CANUSB_Return_t StartSampler(KvaserUSB_Device_t *device);
+static CANUSB_Return_t StopSampler(KvaserUSB_Device_t *device);
+static void *SamplerThread(void *arg);
+
 CANUSB_Return_t KvaserCAN_ProbeChannel(KvaserUSB_Channel_t channel, const KvaserUSB_OpMode_t opMode, int *state) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
     KvaserUSB_OpMode_t opCapa = CANMODE_DEFAULT;
@@ -79,7 +90,7 @@ CANUSB_Return_t KvaserCAN_ProbeChannel(KvaserUSB_Channel_t channel, const Kvaser
     opCapa |= KvaserDEV_IsCanFdSupported(productId) ? CANMODE_FDOE : 0x00U;
     opCapa |= KvaserDEV_IsCanFdSupported(productId) ? CANMODE_BRSE : 0x00U;
     // TODO: opCapa |= KvaserDEV_IsNonIsoCanFdSupported(productId) ? CANMODE_NISO : 0x00U;
-    //opCapa |= CANMODE_SHRD;  /{ not possible with IOUsbKit }/
+    opCapa |= CANMODE_SHRD;    /* shared access through a shared memory segment of the owner */
     opCapa |= CANMODE_NXTD;    /* suppressing extended frames (software solution) */
     opCapa |= CANMODE_NRTR;    /* suppressing remote frames (software solution) */
     opCapa |= CANMODE_ERR;     /* status frames are always enabled / error frames only with SJA1000 */
@@ -96,10 +107,20 @@ CANUSB_Return_t KvaserCAN_InitializeChannel(KvaserUSB_Channel_t channel, const K
 
     /* open USB device at given index (channel) and allocate required resources (pipe context) */
     /* note: the device context is preinitialized, but must be confirmed by the CAN channel */
+    if (device) {
+        memset(&device->baseline, 0, sizeof(KvaserUSB_PathCounters_t));
+        device->baselineSeq = 0U;
+    }
     retVal = KvaserUSB_OpenUsbDevice(channel, device);
     if (retVal < 0) {
+        /* shared access: the USB device may be in use by the owner of the CAN channel */
+        if ((opMode & CANMODE_SHRD) && (Shared_AttachChannel(channel, opMode, device) == CANUSB_SUCCESS))
+            return CANUSB_SUCCESS;
         return retVal;
     }
+    /* bus load and status sampler: default interval (started on bus on) */
+    device->sampler.interval = KVASER_SAMPLER_INTERVAL;
+    device->sampler.running = false;
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
             /* configure and confirm device context for Mhydra compatible device and
@@ -122,6 +143,12 @@ CANUSB_Return_t KvaserCAN_InitializeChannel(KvaserUSB_Channel_t channel, const K
              * Send me some Dollars and I will give my best. */
             retVal = CANUSB_ERROR_NOTINIT;
     }
+    /* shared access: we are the owner of the CAN channel */
+    if ((retVal == CANUSB_SUCCESS) && (opMode & CANMODE_SHRD)) {
+        if ((retVal = Shared_CreateChannel(channel, device)) < 0)
+            (void)KvaserCAN_TeardownChannel(device);
+        return retVal;
+    }
     if (retVal < 0) {
         (void)KvaserUSB_CloseUsbDevice(device);
     }
@@ -137,6 +164,17 @@ CANUSB_Return_t KvaserCAN_TeardownChannel(KvaserUSB_Device_t *device) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: detach from the owner's segment (client) or close it (owner) */
+    if (device->shared.client)
+        return Shared_DetachChannel(device);
+    if (device->shared.segment)
+        (void)Shared_DestroyChannel(device);
+
+    /* stop the bus load and status sampler, if running */
+    (void)StopSampler(device);
+    /* stop the flight recorder, if running (a pending capture is written) */
+    (void)FlightRec_Stop(&device->recvData.flightRec);
+
     /* teardown the whole ... */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -187,6 +225,10 @@ CANUSB_Return_t KvaserCAN_SetBusParams(KvaserUSB_Device_t *device, const KvaserU
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the bus parameters are set by the owner */
+    if (device->shared.client)
+        return CANUSB_SUCCESS;
+
     /* set bus parameters */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -199,6 +241,14 @@ CANUSB_Return_t KvaserCAN_SetBusParams(KvaserUSB_Device_t *device, const KvaserU
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if ((retVal == CANUSB_SUCCESS) && params) {
+        KvaserUSB_BusParamsFd_t paramsFd;
+        bzero(&paramsFd, sizeof(KvaserUSB_BusParamsFd_t));
+        paramsFd.nominal = *params;
+        LoadMeter_Configure(&device->recvData.loadMeter, &paramsFd);
+        if (device->shared.segment)
+            (void)Shared_PublishBusParams(device, &paramsFd);
+    }
     return retVal;
 }
 
@@ -211,6 +261,15 @@ CANUSB_Return_t KvaserCAN_GetBusParams(KvaserUSB_Device_t *device, KvaserUSB_Bus
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the bus parameters as published by the owner */
+    if (device->shared.client) {
+        KvaserUSB_BusParamsFd_t paramsFd;
+        if (!params)
+            return CANUSB_ERROR_NULLPTR;
+        if ((retVal = Shared_GetBusParams(device, &paramsFd)) == CANUSB_SUCCESS)
+            *params = paramsFd.nominal;
+        return retVal;
+    }
     /* get bus parameters */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -235,6 +294,10 @@ CANUSB_Return_t KvaserCAN_SetBusParamsFd(KvaserUSB_Device_t *device, const Kvase
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the bus parameters are set by the owner */
+    if (device->shared.client)
+        return CANUSB_SUCCESS;
+
     /* set bus parameters */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -247,6 +310,10 @@ CANUSB_Return_t KvaserCAN_SetBusParamsFd(KvaserUSB_Device_t *device, const Kvase
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if ((retVal == CANUSB_SUCCESS) && params)
+        LoadMeter_Configure(&device->recvData.loadMeter, params);
+    if ((retVal == CANUSB_SUCCESS) && device->shared.segment && params)
+        (void)Shared_PublishBusParams(device, params);
     return retVal;
 }
 
@@ -259,6 +326,10 @@ CANUSB_Return_t KvaserCAN_GetBusParamsFd(KvaserUSB_Device_t *device, KvaserUSB_B
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the bus parameters as published by the owner */
+    if (device->shared.client)
+        return Shared_GetBusParams(device, params);
+
     /* get bus parameters */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -284,18 +355,29 @@ CANUSB_Return_t KvaserCAN_CanBusOn(KvaserUSB_Device_t *device, bool silent) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
-    /* start CAN controller */
+    /* shared access: the CAN controller is started by the owner */
+    if (device->shared.client)
+        return CANUSB_SUCCESS;
+
+    /* start CAN controller
+     * note: the resets are not acknowledged by the firmware, but the requests are
+     *       processed in the order they were sent on the bulk-out pipe.  So they
+     *       are done when the response of the start chip request has been received
+     *       and there is no need to wait for them (0 = no delay).
+     */
+    KvaserUSB_ResetEventQueue(&device->recvData);
+    LoadMeter_Restart(&device->recvData.loadMeter, LoadMeter_Now());
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
-             (void)Mhydra_ResetStatistics(device, KVASER_USB_REQUEST_DELAY);
-             (void)Mhydra_ResetErrorCounter(device, KVASER_USB_REQUEST_DELAY);
+            (void)Mhydra_ResetStatistics(device, 0U);
+            (void)Mhydra_ResetErrorCounter(device, 0U);
             retVal = Mhydra_SetDriverMode(device, silent ? DRIVERMODE_SILENT : DRIVERMODE_NORMAL);
             if (retVal == CANUSB_SUCCESS)
                 retVal = Mhydra_StartChip(device, KVASER_USB_COMMAND_TIMEOUT);
            break;
         case USB_LEAF_DRIVER:
-            (void)Leaf_ResetStatistics(device, KVASER_USB_REQUEST_DELAY);
-            (void)Leaf_ResetErrorCounter(device, KVASER_USB_REQUEST_DELAY);
+            (void)Leaf_ResetStatistics(device, 0U);
+            (void)Leaf_ResetErrorCounter(device, 0U);
             retVal = Leaf_SetDriverMode(device, silent ? DRIVERMODE_SILENT : DRIVERMODE_NORMAL);
             if (retVal == CANUSB_SUCCESS)
                 retVal = Leaf_StartChip(device, KVASER_USB_COMMAND_TIMEOUT);
@@ -304,6 +386,14 @@ CANUSB_Return_t KvaserCAN_CanBusOn(KvaserUSB_Device_t *device, bool silent) {
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if ((retVal == CANUSB_SUCCESS) && device->shared.segment)
+        (void)Shared_PublishRunning(device, true);
+    /* start the bus load and status sampler (note: an error is not fatal, we poll instead) */
+    if ((retVal == CANUSB_SUCCESS) && (device->sampler.interval > 0U))
+        (void)StartSampler(device);
+    /* start the flight recorder, if configured (note: an error is not fatal, there is no capture) */
+    if ((retVal == CANUSB_SUCCESS) && !device->shared.client)
+        (void)FlightRec_Start(&device->recvData.flightRec, (int32_t)device->channelNo, device->name);
     return retVal;
 }
 
@@ -316,6 +406,15 @@ CANUSB_Return_t KvaserCAN_CanBusOff(KvaserUSB_Device_t *device) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the CAN controller is stopped by the owner */
+    if (device->shared.client)
+        return CANUSB_SUCCESS;
+
+    /* stop the bus load and status sampler, if running */
+    (void)StopSampler(device);
+    /* stop the flight recorder, if running (a pending capture is written) */
+    (void)FlightRec_Stop(&device->recvData.flightRec);
+
     /* reset CAN controller */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -332,11 +431,14 @@ CANUSB_Return_t KvaserCAN_CanBusOff(KvaserUSB_Device_t *device) {
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if ((retVal == CANUSB_SUCCESS) && device->shared.segment)
+        (void)Shared_PublishRunning(device, false);
     return retVal;
 }
 
 CANUSB_Return_t KvaserCAN_WriteMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message, uint16_t timeout) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint64_t now;
 
     /* sanity check */
     if (!device)
@@ -344,7 +446,13 @@ CANUSB_Return_t KvaserCAN_WriteMessage(KvaserUSB_Device_t *device, const KvaserU
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
-    /* send a CAN message */
+    /* shared access: submit the CAN message to the owner (client) */
+    if (device->shared.client)
+        return Shared_WriteMessage(device, message, timeout);
+
+    /* send a CAN message (note: the owner also sends on behalf of its clients) */
+    if (device->shared.segment)
+        (void)pthread_mutex_lock(&device->shared.mutex);
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
             retVal = Mhydra_SendMessage(device, message, timeout);
@@ -356,6 +464,60 @@ CANUSB_Return_t KvaserCAN_WriteMessage(KvaserUSB_Device_t *device, const KvaserU
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if (device->shared.segment)
+        (void)pthread_mutex_unlock(&device->shared.mutex);
+    /* bus load meter: account the CAN frame when it is handed over to the device */
+    if ((retVal == CANUSB_SUCCESS) && message) {
+        now = LoadMeter_Now();
+        LoadMeter_Account(&device->recvData.loadMeter, message, now);
+        /* flight recorder: copy the CAN frame into the ring */
+        if (device->recvData.flightRec.ring)
+            FlightRec_RecordSent(&device->recvData.flightRec, message, now);
+    }
+    return retVal;
+}
+
+CANUSB_Return_t KvaserCAN_WriteMessages(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *messages, uint32_t count) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint64_t now;
+    uint32_t i;
+
+    /* sanity check */
+    if (!device || !messages)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if ((count < 1U) || (count > KVASER_MAX_TX_BATCH))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* shared access: the messages go through the owner's queue one by one (client) */
+    if (device->shared.client)
+        return CANUSB_ERROR_NOTSUPP;
+    /* send the CAN messages in one USB transfer (all or nothing) */
+    if (device->shared.segment)
+        (void)pthread_mutex_lock(&device->shared.mutex);
+    switch (device->driverType) {
+        case USB_MHYDRA_DRIVER:
+            retVal = Mhydra_SendMessages(device, messages, count);
+            break;
+        case USB_LEAF_DRIVER:
+            retVal = Leaf_SendMessages(device, messages, count);
+            break;
+        default:
+            retVal = CANUSB_ERROR_FATAL;
+            break;
+    }
+    if (device->shared.segment)
+        (void)pthread_mutex_unlock(&device->shared.mutex);
+    /* bus load meter and flight recorder: the CAN frames when they are handed over to the device */
+    if (retVal == CANUSB_SUCCESS) {
+        now = LoadMeter_Now();
+        for (i = 0U; i < count; i++) {
+            LoadMeter_Account(&device->recvData.loadMeter, &messages[i], now);
+            if (device->recvData.flightRec.ring)
+                FlightRec_RecordSent(&device->recvData.flightRec, &messages[i], now);
+        }
+    }
     return retVal;
 }
 
@@ -392,6 +554,18 @@ CANUSB_Return_t KvaserCAN_GetBusStatus(KvaserUSB_Device_t *device, KvaserUSB_Bus
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the bus status as published by the owner */
+    if (device->shared.client)
+        return Shared_GetBusStatus(device, status);
+
+    /* bus load and status sampler: the bus status from the snapshot */
+    if (device->sampler.running) {
+        KvaserUSB_BusSample_t sample;
+        KvaserUSB_ReadBusSample(&device->recvData, &sample);
+        if (status)
+            *status = sample.busStatus;
+        return CANUSB_SUCCESS;
+    }
     /* get CAN bus status */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -410,6 +584,8 @@ CANUSB_Return_t KvaserCAN_GetBusStatus(KvaserUSB_Device_t *device, KvaserUSB_Bus
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if ((retVal == CANUSB_SUCCESS) && device->shared.segment)
+        (void)Shared_PublishBusStatus(device, device->recvData.evData.chipState.busStatus);
     return retVal;
 }
 
@@ -422,6 +598,26 @@ CANUSB_Return_t KvaserCAN_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLo
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* shared access: the bus load as published by the owner */
+    if (device->shared.client)
+        return Shared_GetBusLoad(device, load);
+
+    /* bus load meter: when the device has no bus statistics, the bus load is computed on the host */
+    if (!device->deviceInfo.capabilities.busStats) {
+        if (load)
+            *load = LoadMeter_BusLoad(&device->recvData.loadMeter, LoadMeter_Now());
+        if (device->shared.segment && load)
+            (void)Shared_PublishBusLoad(device, *load);
+        return CANUSB_SUCCESS;
+    }
+    /* bus load and status sampler: the bus load from the snapshot */
+    if (device->sampler.running) {
+        KvaserUSB_BusSample_t sample;
+        KvaserUSB_ReadBusSample(&device->recvData, &sample);
+        if (load)
+            *load = sample.busLoad;
+        return CANUSB_SUCCESS;
+    }
     /* call device specific function */
     switch (device->driverType) {
         case USB_MHYDRA_DRIVER:
@@ -434,9 +630,339 @@ CANUSB_Return_t KvaserCAN_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLo
             retVal = CANUSB_ERROR_FATAL;
             break;
     }
+    if ((retVal == CANUSB_SUCCESS) && device->shared.segment && load)
+        (void)Shared_PublishBusLoad(device, *load);
+    return retVal;
+}
+
+CANUSB_Return_t KvaserCAN_GetBusSample(KvaserUSB_Device_t *device, KvaserUSB_BusSample_t *sample) {
+    /* sanity check */
+    if (!device || !sample)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* bus load and status sampler: not running (or shared access as client) */
+    if (!device->sampler.running)
+        return CANUSB_ERROR_NOTSUPP;
+
+    /* read the snapshot (lock-free) */
+    KvaserUSB_ReadBusSample(&device->recvData, sample);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetHostBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load) {
+    /* sanity check */
+    if (!device || !load)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* shared access: the host computes the bus load in the owner's process only */
+    if (device->shared.client)
+        return CANUSB_ERROR_NOTSUPP;
+
+    /* bus load computed from the CAN frames received and sent (sliding window) */
+    *load = LoadMeter_BusLoad(&device->recvData.loadMeter, LoadMeter_Now());
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_ReadBusEvents(KvaserUSB_Device_t *device, KvaserUSB_BusEvent_t *events, uint32_t count, uint32_t *read) {
+    /* sanity check */
+    if (!device || !events || !read)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* shared access: the events are received in the owner's process only */
+    if (device->shared.client)
+        return CANUSB_ERROR_NOTSUPP;
+
+    /* read up to count events from the queue (lock-free, no USB request) */
+    *read = KvaserUSB_ReadEventQueue(&device->recvData, events, count);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetLostEvents(KvaserUSB_Device_t *device, uint64_t *lost) {
+    /* sanity check */
+    if (!device || !lost)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    *lost = __atomic_load_n(&device->recvData.evQueue.lost, __ATOMIC_RELAXED);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetGapMarkers(KvaserUSB_Device_t *device, bool enable) {
+    CANUSB_Return_t retVal;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the message queue keeps one element free for the gap marker */
+    retVal = CANQUE_SetGapMarker(device->recvData.msgQueue, enable ? KvaserUSB_QueueGapMarker : NULL);
+    if (retVal == CANUSB_SUCCESS)
+        device->recvData.gapMarkers = enable;
     return retVal;
 }
 
+CANUSB_Return_t KvaserCAN_GetGapMarkers(KvaserUSB_Device_t *device, bool *enabled) {
+    /* sanity check */
+    if (!device || !enabled)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    *enabled = device->recvData.gapMarkers;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetPathCounters(KvaserUSB_Device_t *device, KvaserUSB_PathCounters_t *counters) {
+    KvaserUSB_PathCounters_t current;
+    KvaserUSB_PathCounters_t baseline;
+    uint32_t before, after = 0U;
+
+    /* sanity check */
+    if (!device || !counters)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* hot-path counters since the last reset (note: the queue high-water mark
+     * and the outstanding Tx acknowledges are levels, not counters) */
+    KvaserUSB_ReadPathCounters(device, &current);
+    /* seqlock: the baseline may be written by a concurrent reset (retry) */
+    do {
+        before = __atomic_load_n(&device->baselineSeq, __ATOMIC_ACQUIRE);
+        if (before & 1U)
+            continue;
+        memcpy(&baseline, &device->baseline, sizeof(KvaserUSB_PathCounters_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&device->baselineSeq, __ATOMIC_RELAXED);
+    } while ((before & 1U) || (before != after));
+    counters->urb.urbs = SINCE(current.urb.urbs, baseline.urb.urbs);
+    counters->urb.bytes = SINCE(current.urb.bytes, baseline.urb.bytes);
+    counters->urb.errors = SINCE(current.urb.errors, baseline.urb.errors);
+    counters->urb.unknown = SINCE(current.urb.unknown, baseline.urb.unknown);
+    counters->urb.splits = SINCE(current.urb.splits, baseline.urb.splits);
+    counters->queueHigh = current.queueHigh;
+    counters->queueOverflows = SINCE(current.queueOverflows, baseline.queueOverflows);
+    counters->lockWaits = SINCE(current.lockWaits, baseline.lockWaits);
+    counters->lockWaitTime = SINCE(current.lockWaitTime, baseline.lockWaitTime);
+    counters->txPending = current.txPending;
+    counters->writeFailures = SINCE(current.writeFailures, baseline.writeFailures);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_ResetPathCounters(KvaserUSB_Device_t *device) {
+    KvaserUSB_PathCounters_t current;
+    uint32_t sequence;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the counters keep running, the current values become the baseline */
+    KvaserUSB_ReadPathCounters(device, &current);
+    /* seqlock: an odd sequence number tells the readers to retry
+     * (note: several threads may reset, the odd number is taken by compare-and-swap) */
+    do {
+        sequence = __atomic_load_n(&device->baselineSeq, __ATOMIC_RELAXED) & ~1U;
+    } while (!__atomic_compare_exchange_n(&device->baselineSeq, &sequence, sequence + 1U,
+                                          false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&device->baseline, &current, sizeof(KvaserUSB_PathCounters_t));
+    __atomic_store_n(&device->baselineSeq, sequence + 2U, __ATOMIC_RELEASE);
+    (void)CANQUE_ResetQueueHigh(device->recvData.msgQueue);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetSamplerInterval(KvaserUSB_Device_t *device, uint32_t interval) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the interval takes effect when the CAN controller is started */
+    device->sampler.interval = interval;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetSamplerInterval(KvaserUSB_Device_t *device, uint32_t *interval) {
+    /* sanity check */
+    if (!device || !interval)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    *interval = device->sampler.interval;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetFlightCapacity(KvaserUSB_Device_t *device, uint32_t capacity) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* shared access: the flight recorder runs in the owner's process only */
+    if (device->shared.client)
+        return CANUSB_ERROR_NOTSUPP;
+
+    /* note: the ring can only be (re)allocated when the CAN controller is stopped */
+    return FlightRec_Configure(&device->recvData.flightRec, capacity);
+}
+
+CANUSB_Return_t KvaserCAN_GetFlightCapacity(KvaserUSB_Device_t *device, uint32_t *capacity) {
+    /* sanity check */
+    if (!device || !capacity)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    *capacity = device->recvData.flightRec.capacity;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetFlightWindow(KvaserUSB_Device_t *device, uint32_t preTime, uint32_t postTime) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the window takes effect with the next trigger */
+    device->recvData.flightRec.preTime = preTime;
+    device->recvData.flightRec.postTime = postTime;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetFlightWindow(KvaserUSB_Device_t *device, uint32_t *preTime, uint32_t *postTime) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    if (preTime)
+        *preTime = device->recvData.flightRec.preTime;
+    if (postTime)
+        *postTime = device->recvData.flightRec.postTime;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetFlightTriggers(KvaserUSB_Device_t *device, uint8_t triggers) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the trigger conditions take effect immediately (the API call is always enabled) */
+    __atomic_store_n(&device->recvData.flightRec.triggers, triggers & (KVASER_FLIGHT_ERROR_FRAME |
+                     KVASER_FLIGHT_BUS_OFF | KVASER_FLIGHT_ID_MATCH), __ATOMIC_RELAXED);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetFlightTriggers(KvaserUSB_Device_t *device, uint8_t *triggers) {
+    /* sanity check */
+    if (!device || !triggers)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    *triggers = device->recvData.flightRec.triggers;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetFlightMatch(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *match) {
+    /* sanity check */
+    if (!device || !match)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the pattern is compared by the producers, it cannot be changed while running */
+    if (device->recvData.flightRec.running)
+        return CANUSB_ERROR_BUSY;
+    memcpy(&device->recvData.flightRec.match, match, sizeof(KvaserUSB_CanMessage_t));
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetFlightMatch(KvaserUSB_Device_t *device, KvaserUSB_CanMessage_t *match) {
+    /* sanity check */
+    if (!device || !match)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    memcpy(match, &device->recvData.flightRec.match, sizeof(KvaserUSB_CanMessage_t));
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_SetFlightFile(KvaserUSB_Device_t *device, const char *prefix) {
+    /* sanity check */
+    if (!device || !prefix)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if ((prefix[0] == '\0') || (strlen(prefix) > KVASER_FLIGHT_PATH_LENGTH))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* note: the path is used by the writer thread, it cannot be changed while running */
+    if (device->recvData.flightRec.running)
+        return CANUSB_ERROR_BUSY;
+    strncpy(device->recvData.flightRec.path, prefix, KVASER_FLIGHT_PATH_LENGTH);
+    device->recvData.flightRec.path[KVASER_FLIGHT_PATH_LENGTH] = '\0';
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_GetFlightFile(KvaserUSB_Device_t *device, char *prefix, size_t size) {
+    /* sanity check */
+    if (!device || !prefix)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if (size <= strlen(device->recvData.flightRec.path))
+        return CANUSB_ERROR_ILLPARA;
+
+    strcpy(prefix, device->recvData.flightRec.path);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserCAN_TriggerFlightRecorder(KvaserUSB_Device_t *device) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: only the first trigger counts until the capture file is written */
+    if (!device->recvData.flightRec.running)
+        return CANUSB_ERROR_NOTSUPP;
+    return FlightRec_Trigger(&device->recvData.flightRec, KVASER_FLIGHT_API_CALL, LoadMeter_Now()) ?
+           CANUSB_SUCCESS : CANUSB_ERROR_BUSY;
+}
+
+CANUSB_Return_t KvaserCAN_GetFlightCaptures(KvaserUSB_Device_t *device, uint32_t *captures) {
+    /* sanity check */
+    if (!device || !captures)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    *captures = __atomic_load_n(&device->recvData.flightRec.captures, __ATOMIC_RELAXED);
+    return CANUSB_SUCCESS;
+}
+
 /* ---  MacCAN IOUsbKit initialization  ---
  */
 CANUSB_Return_t KvaserCAN_InitializeDriver(void) {
@@ -454,6 +980,109 @@ uint32_t KvaserCAN_DriverVersion(void) {
     return CANUSB_GetVersion();
 }
 
+/* ---  bus load and status sampler  ---
+ */
+static CANUSB_Return_t StartSampler(KvaserUSB_Device_t *device) {
+    assert(device);
+
+    /* only the owner of the CAN channel requests bus load and chip state */
+    if (device->sampler.running || device->shared.client)
+        return CANUSB_SUCCESS;
+    if (pthread_mutex_init(&device->sampler.mutex, NULL) != 0)
+        return CANUSB_ERROR_RESOURCE;
+    if (pthread_cond_init(&device->sampler.cond, NULL) != 0) {
+        (void)pthread_mutex_destroy(&device->sampler.mutex);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    /* note: the bus load window starts empty (no samples of a previous run) */
+    KvaserUSB_ResetBusSample(&device->recvData);
+    /* note: the reception callback takes the bus load responses from now on */
+    device->recvData.busSample.active = true;
+    device->sampler.running = true;
+    if (pthread_create(&device->sampler.thread, NULL, SamplerThread, (void*)device) != 0) {
+        device->sampler.running = false;
+        device->recvData.busSample.active = false;
+        (void)pthread_cond_destroy(&device->sampler.cond);
+        (void)pthread_mutex_destroy(&device->sampler.mutex);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    return CANUSB_SUCCESS;
+}
+
+static CANUSB_Return_t StopSampler(KvaserUSB_Device_t *device) {
+    assert(device);
+
+    if (!device->sampler.running)
+        return CANUSB_SUCCESS;
+
+    /* wake up the thread and wait for its termination */
+    (void)pthread_mutex_lock(&device->sampler.mutex);
+    device->sampler.running = false;
+    (void)pthread_cond_signal(&device->sampler.cond);
+    (void)pthread_mutex_unlock(&device->sampler.mutex);
+    (void)pthread_join(device->sampler.thread, NULL);
+    (void)pthread_cond_destroy(&device->sampler.cond);
+    (void)pthread_mutex_destroy(&device->sampler.mutex);
+
+    /* note: the bus load responses go into the pipe again */
+    device->recvData.busSample.active = false;
+    return CANUSB_SUCCESS;
+}
+
+static void *SamplerThread(void *arg) {
+    KvaserUSB_Device_t *device = (KvaserUSB_Device_t*)arg;
+    KvaserUSB_BusSample_t sample;
+    struct timespec abstime;
+    uint64_t nsec;
+    int res;
+
+    assert(device);
+
+    (void)pthread_mutex_lock(&device->sampler.mutex);
+    while (device->sampler.running) {
+        (void)pthread_mutex_unlock(&device->sampler.mutex);
+        /* bus load meter: when the device has no bus statistics, the bus load is computed on the host */
+        if (!device->deviceInfo.capabilities.busStats)
+            KvaserUSB_UpdateBusLoad(&device->recvData, LoadMeter_BusLoad(&device->recvData.loadMeter, LoadMeter_Now()));
+        /* request bus load and chip state (the responses update the snapshot) */
+        (void)__atomic_fetch_add(&device->recvData.busSample.polls, 1U, __ATOMIC_RELAXED);
+        switch (device->driverType) {
+            case USB_MHYDRA_DRIVER:
+                if (device->deviceInfo.capabilities.busStats)
+                    (void)Mhydra_RequestBusLoad(device);
+                if (Mhydra_RequestChipState(device, 0U) != CANUSB_SUCCESS)
+                    (void)KvaserUSB_PolledChipState(&device->recvData);
+                break;
+            case USB_LEAF_DRIVER:
+                if (device->deviceInfo.capabilities.busStats)
+                    (void)Leaf_RequestBusLoad(device);
+                if (Leaf_RequestChipState(device, 0U) != CANUSB_SUCCESS)
+                    (void)KvaserUSB_PolledChipState(&device->recvData);
+                break;
+            default:
+                (void)KvaserUSB_PolledChipState(&device->recvData);
+                break;
+        }
+        /* shared access: publish the last sample for the clients */
+        if (device->shared.segment) {
+            KvaserUSB_ReadBusSample(&device->recvData, &sample);
+            (void)Shared_PublishBusLoad(device, sample.busLoad);
+            (void)Shared_PublishBusStatus(device, sample.busStatus);
+        }
+        /* wait for the next interval (or until the sampler is stopped) */
+        (void)clock_gettime(CLOCK_REALTIME, &abstime);
+        nsec = (uint64_t)abstime.tv_nsec + ((uint64_t)device->sampler.interval * 1000000ULL);
+        abstime.tv_sec += (time_t)(nsec / 1000000000ULL);
+        abstime.tv_nsec = (long)(nsec % 1000000000ULL);
+        (void)pthread_mutex_lock(&device->sampler.mutex);
+        res = 0;
+        while (device->sampler.running && (res != ETIMEDOUT))
+            res = pthread_cond_timedwait(&device->sampler.cond, &device->sampler.mutex, &abstime);
+    }
+    (void)pthread_mutex_unlock(&device->sampler.mutex);
+    return NULL;
+}
+
 /* ---  mother's little helper  ---
  */
 uint8_t KvaserCAN_Dlc2Len(uint8_t dlc) {
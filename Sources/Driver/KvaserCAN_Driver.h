@@ -75,10 +75,36 @@ extern CANUSB_Return_t KvaserCAN_CanBusOn(KvaserUSB_Device_t *device, bool silen
 extern CANUSB_Return_t KvaserCAN_CanBusOff(KvaserUSB_Device_t *device);
 
 extern CANUSB_Return_t KvaserCAN_WriteMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t KvaserCAN_WriteMessages(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *messages, uint32_t count);
 extern CANUSB_Return_t KvaserCAN_ReadMessage(KvaserUSB_Device_t *device, KvaserUSB_CanMessage_t *message, uint16_t timeout);
 
 extern CANUSB_Return_t KvaserCAN_GetBusStatus(KvaserUSB_Device_t *device, KvaserUSB_BusStatus_t *status);
 extern CANUSB_Return_t KvaserCAN_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load);
+extern CANUSB_Return_t KvaserCAN_GetBusSample(KvaserUSB_Device_t *device, KvaserUSB_BusSample_t *sample);
+extern CANUSB_Return_t KvaserCAN_GetHostBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load);
+extern CANUSB_Return_t KvaserCAN_ReadBusEvents(KvaserUSB_Device_t *device, KvaserUSB_BusEvent_t *events, uint32_t count, uint32_t *read);
+extern CANUSB_Return_t KvaserCAN_GetLostEvents(KvaserUSB_Device_t *device, uint64_t *lost);
+extern CANUSB_Return_t KvaserCAN_SetGapMarkers(KvaserUSB_Device_t *device, bool enable);
+extern CANUSB_Return_t KvaserCAN_GetGapMarkers(KvaserUSB_Device_t *device, bool *enabled);
+
+extern CANUSB_Return_t KvaserCAN_GetPathCounters(KvaserUSB_Device_t *device, KvaserUSB_PathCounters_t *counters);
+extern CANUSB_Return_t KvaserCAN_ResetPathCounters(KvaserUSB_Device_t *device);
+
+extern CANUSB_Return_t KvaserCAN_SetSamplerInterval(KvaserUSB_Device_t *device, uint32_t interval);
+extern CANUSB_Return_t KvaserCAN_GetSamplerInterval(KvaserUSB_Device_t *device, uint32_t *interval);
+
+extern CANUSB_Return_t KvaserCAN_SetFlightCapacity(KvaserUSB_Device_t *device, uint32_t capacity);
+extern CANUSB_Return_t KvaserCAN_GetFlightCapacity(KvaserUSB_Device_t *device, uint32_t *capacity);
+extern CANUSB_Return_t KvaserCAN_SetFlightWindow(KvaserUSB_Device_t *device, uint32_t preTime, uint32_t postTime);
+extern CANUSB_Return_t KvaserCAN_GetFlightWindow(KvaserUSB_Device_t *device, uint32_t *preTime, uint32_t *postTime);
+extern CANUSB_Return_t KvaserCAN_SetFlightTriggers(KvaserUSB_Device_t *device, uint8_t triggers);
+extern CANUSB_Return_t KvaserCAN_GetFlightTriggers(KvaserUSB_Device_t *device, uint8_t *triggers);
+extern CANUSB_Return_t KvaserCAN_SetFlightMatch(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *match);
+extern CANUSB_Return_t KvaserCAN_GetFlightMatch(KvaserUSB_Device_t *device, KvaserUSB_CanMessage_t *match);
+extern CANUSB_Return_t KvaserCAN_SetFlightFile(KvaserUSB_Device_t *device, const char *prefix);
+extern CANUSB_Return_t KvaserCAN_GetFlightFile(KvaserUSB_Device_t *device, char *prefix, size_t size);
+extern CANUSB_Return_t KvaserCAN_TriggerFlightRecorder(KvaserUSB_Device_t *device);
+extern CANUSB_Return_t KvaserCAN_GetFlightCaptures(KvaserUSB_Device_t *device, uint32_t *captures);
 
 extern uint8_t KvaserCAN_Dlc2Len(uint8_t dlc);
 extern uint8_t KvaserCAN_Len2Dlc(uint8_t len);
@@ -57,13 +57,15 @@
 
 /* ---  general defines  ---
  */
-#define KVASER_MAX_CAN_CHANNELS  1U  // TODO: set to 5 for multi-channel devices
+#define KVASER_MAX_CAN_CHANNELS  5U  /* max. number of CAN channels on a device */
+#define KVASER_MAX_HE_COUNT  64U  /* max. number of Hydra HE addresses (6-bit) */
 #define KVASER_MAX_STRING_LENGTH  256U
 
 #define KVASER_MIN_COMMAND_LENGTH  4U
 #define KVASER_MAX_COMMAND_LENGTH  32U
 #define KVASER_USB_COMMAND_TIMEOUT 800U
 #define KVASER_USB_REQUEST_DELAY   100U
+#define KVASER_MAX_TX_BATCH  16U  /* max. number of CAN frames in one bulk transfer (batched transmission) */
 
 #define KVASER_HYDRA_COMMAND_LENGTH  32U
 #define KVASER_HYDRA_EXT_COMMAND_LENGTH  96U
@@ -74,6 +76,39 @@
 
 #define KVASER_RECEIVE_QUEUE_SIZE  65536U
 
+#define KVASER_SHARED_RING_SIZE  4096U  /* CAN frames in the shared reception ring */
+#define KVASER_SHARED_QUEUE_SIZE  256U  /* CAN frames in the shared transmission queue */
+#define KVASER_SHARED_POLL_DELAY  1000U /* polling interval of the shared access threads (in [usec]) */
+#define KVASER_INFO_CACHE_SIZE  32U  /* entries in the device information cache */
+#define KVASER_SAMPLER_INTERVAL  100U  /* default interval of the bus load and status sampler (in [ms]) */
+#define KVASER_SAMPLER_WINDOW  10U  /* bus load samples for min./max./average */
+#define KVASER_LOAD_BUCKET_TIME  100000000U  /* bucket length of the bus load meter (in [ns]) */
+#define KVASER_LOAD_BUCKETS  10U  /* buckets of the bus load meter (sliding window) */
+#define KVASER_FLIGHT_PRE_TIME  1000U  /* default pre-trigger window of the flight recorder (in [ms]) */
+#define KVASER_FLIGHT_POST_TIME  500U  /* default post-trigger window of the flight recorder (in [ms]) */
+#define KVASER_FLIGHT_FILE_PREFIX  "flight"  /* default path prefix of the flight recorder captures */
+#define KVASER_FLIGHT_PATH_LENGTH  240U  /* max. length of the path prefix (w/o number and extension) */
+#define KVASER_FLIGHT_MAX_CAPACITY  0x1000000U  /* max. number of CAN frames in the flight recorder (16M) */
+#define KVASER_EVENT_QUEUE_SIZE  256U  /* entries in the bus event queue (power of 2) */
+
+/* ---  flight recorder trigger conditions (same as in KvaserCAN_Defines.h)  ---
+ */
+#define KVASER_FLIGHT_ERROR_FRAME   0x01U   /* error frame received */
+#define KVASER_FLIGHT_BUS_OFF       0x02U   /* bus status changed to bus off */
+#define KVASER_FLIGHT_ID_MATCH      0x04U   /* CAN frame with given identifier and payload (received or sent) */
+#define KVASER_FLIGHT_API_CALL      0x80U   /* API call (always enabled, driver only) */
+
+/* ---  bus event types  ---
+ */
+#define KVASER_EVENT_TYPE_CHIP_STATE  0x01U  /* chip state changed (bus status or error counters) */
+#define KVASER_EVENT_TYPE_CAN_ERROR  0x02U  /* CAN error event (bus error) */
+#define KVASER_EVENT_TYPE_ERROR  0x03U  /* error event (firmware) */
+
+/* ---  gap markers in the reception queue (same as in KvaserCAN_Defines.h)  ---
+ */
+#define KVASER_GAP_QUEUE_OVERRUN    0x80000001U  /* CAN frames lost in the reception queue (host) */
+#define KVASER_GAP_DEVICE_OVERRUN   0x80000002U  /* CAN frames lost in the device (overrun flag) */
+
 /* ---  general CAN data types and defines  ---
  */
 #if (OPTION_CANAPI_DRIVER != 0)
@@ -46,6 +46,7 @@
  *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "KvaserUSB_Device.h"
+#include "KvaserUSB_FlightRec.h"
 #include "KvaserCAN_Devices.h"
 #include "MacCAN_Debug.h"
 
@@ -54,6 +55,20 @@
 #include <unistd.h>
 #include <assert.h>
 
+#define IS_READER_VALID(hnd)  ((0 <= (hnd)) && ((hnd) < CANUSB_MAX_DEVICES))
+#define ENTER_READER_SECTION()  (void)pthread_mutex_lock(&readerMutex)
+#define LEAVE_READER_SECTION()  (void)pthread_mutex_unlock(&readerMutex)
+
+static KvaserUSB_UsbReader_t usbReader[CANUSB_MAX_DEVICES];
+static pthread_mutex_t readerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t readerOnce = PTHREAD_ONCE_INIT;
+
+static void InitUsbReaders(void);
+static void ReaderCallback(void *refCon, UInt8 *buffer, UInt32 size);
+static CANUSB_Return_t AttachUsbReader(KvaserUSB_Device_t *device);
+static CANUSB_Return_t DetachUsbReader(KvaserUSB_Device_t *device);
+static CANUSB_Index_t GetUsbDeviceIndex(CANUSB_Index_t channel, KvaserUSB_CanChannel_t *canChannel);
+
 static KvaserUSB_DriverType_t GetUsbDriverType(uint16_t productId) {
     switch (KvaserDEV_GetDeviceFamily(productId)) {
         /* ---  driver for Leaf devices  --- */
@@ -104,7 +119,8 @@ static CANUSB_Return_t GetUsbConfiguration(CANUSB_Handle_t handle, KvaserUSB_Can
         return retVal;
     /* get endpoint properties from device */
     // TODO: Nah, nah, there's gotta be something better!
-    for (uint8_t i = 1U; (i <= device->endpoints.numEndpoints) && (i < (1U + (KVASER_MAX_CAN_CHANNELS * 2U))); i++) {
+    // note: all CAN channels on a device share the first pair of bulk endpoints
+    for (uint8_t i = 1U; (i <= device->endpoints.numEndpoints) && (i < 3U); i++) {
         if (CANUSB_GetInterfaceEndpointDirection(handle, i, &dir) < 0)
             return retVal;
         if (CANUSB_GetInterfaceEndpointTransferType(handle, i, &type) < 0)
@@ -141,12 +157,30 @@ static CANUSB_Return_t GetUsbConfiguration(CANUSB_Handle_t handle, KvaserUSB_Can
 
 CANUSB_Return_t KvaserUSB_ProbeUsbDevice(CANUSB_Index_t channel, uint16_t *productId) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
-    CANUSB_Index_t index = channel;
-
+    KvaserUSB_CanChannel_t canChannel = 0U;
+    CANUSB_Index_t index = GetUsbDeviceIndex(channel, &canChannel);
+    bool attached = false;
+
+    /* a CAN channel on a device already opened by us is occupied, if and only if it is attached */
+    if (IS_READER_VALID(index)) {
+        (void)pthread_once(&readerOnce, InitUsbReaders);
+        MACCAN_DEBUG_FUNC("lock #%i\n", index);
+        ENTER_READER_SECTION();
+        if (usbReader[index].refCount > 0U)
+            attached = (usbReader[index].recvData[canChannel] != NULL) ? true : false;
+        LEAVE_READER_SECTION();
+        MACCAN_DEBUG_FUNC("unlocked\n");
+    }
     /* check if the device is present (available) and opened (occupied) */
     if (!CANUSB_IsDevicePresent(index)) {
 //        MACCAN_DEBUG_INFO("+++ MacCAN-Core: device (%02x) not available\n", channel);
         retVal = CANERR_HANDLE;
+    } else if (attached) {
+//        MACCAN_DEBUG_INFO("+++ MacCAN-Core: device (%02x) occupied\n", channel);
+        retVal = CANERR_NOERROR + 1;
+    } else if (IS_READER_VALID(index) && (usbReader[index].refCount > 0U)) {
+//        MACCAN_DEBUG_INFO("+++ MacCAN-Core: device (%02x) available\n", channel);
+        retVal = CANERR_NOERROR;
     } else if (!CANUSB_IsDeviceInUse(index)) {
 //        MACCAN_DEBUG_INFO("+++ MacCAN-Core: device (%02x) available\n", channel);
         retVal = CANERR_NOERROR;
@@ -163,7 +197,8 @@ CANUSB_Return_t KvaserUSB_ProbeUsbDevice(CANUSB_Index_t channel, uint16_t *produ
 CANUSB_Return_t KvaserUSB_OpenUsbDevice(CANUSB_Index_t channel, KvaserUSB_Device_t *device) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
     CANUSB_Handle_t handle = CANUSB_INVALID_HANDLE;
-    CANUSB_Index_t index = channel;
+    KvaserUSB_CanChannel_t canChannel = 0U;
+    CANUSB_Index_t index = GetUsbDeviceIndex(channel, &canChannel);
 
     /* sanity check */
     if (!device)
@@ -178,7 +213,7 @@ CANUSB_Return_t KvaserUSB_OpenUsbDevice(CANUSB_Index_t channel, KvaserUSB_Device
         return CANUSB_ERROR_NOTINIT;
     }
     /* get the USB configuration of the device (also check the CAN channel number) */
-    retVal = GetUsbConfiguration(handle, 0U, device);  // TODO: multi-channel devices
+    retVal = GetUsbConfiguration(handle, canChannel, device);
     if (retVal < 0) {
 //        MACCAN_DEBUG_ERROR("+++ MacCAN-Core: configuration could not be read (%02x)\n", channel);
         (void)CANUSB_CloseDevice(handle);
@@ -199,16 +234,19 @@ CANUSB_Return_t KvaserUSB_OpenUsbDevice(CANUSB_Index_t channel, KvaserUSB_Device
         (void)CANUSB_CloseDevice(handle);
         return retVal;;
     }
-    /* create a pipe context for the selected CAN channel on the device */
-    uint8_t pipeRef = device->endpoints.bulkIn.pipeRef;
-    size_t bufSize = device->endpoints.bulkIn.packetSize;
-    device->recvPipe = CANUSB_CreatePipeAsync(device->handle, pipeRef, bufSize);
-    if (device->recvPipe == NULL) {
-//        MACCAN_DEBUG_ERROR("+++ %s CAN%u: asynchronous pipe context could not be created (NULL)\n", device->name, device->channelNo+1);
+    device->recvData.sharedMem = NULL;
+    memset(&device->recvData.evQueue, 0, sizeof(KvaserUSB_EventQueue_t));
+    device->recvData.gapMarkers = false;
+    FlightRec_Init(&device->recvData.flightRec);
+    /* attach the selected CAN channel to the USB reader of the device */
+    retVal = AttachUsbReader(device);
+    if (retVal < 0) {
+//        MACCAN_DEBUG_ERROR("+++ %s CAN%u: channel could not be attached to USB reader (%i)\n", device->name, device->channelNo+1, retVal);
+        FlightRec_Release(&device->recvData.flightRec);
         (void)CANQUE_Destroy(device->recvData.msgQueue);
         (void)CANPIP_Destroy(device->recvData.msgPipe);
         (void)CANUSB_CloseDevice(handle);
-        return CANUSB_ERROR_RESOURCE;
+        return retVal;
     }
     return retVal;
 }
@@ -220,18 +258,14 @@ CANUSB_Return_t KvaserUSB_CloseUsbDevice(KvaserUSB_Device_t *device) {
     if (!device)
         return CANUSB_ERROR_NULLPTR;
 
-    /* abort asynchronous pipe */
-    /*retVal =*/ CANUSB_AbortPipeAsync(device->recvPipe);
+    /* detach the CAN channel from the USB reader (the last one stops it) */
+    /*retVal =*/ DetachUsbReader(device);
 //    if (retVal < 0)
-//        MACCAN_DEBUG_ERROR("+++ %s CAN%u: asynchronous pipe could not be stopped (%i)\n", device->name, device->channelNo+1, retVal);
-    /* close the USB device */
+//        MACCAN_DEBUG_ERROR("+++ %s CAN%u: channel could not be detached from USB reader (%i)\n", device->name, device->channelNo+1, retVal);
+    /* close the USB device (note: reference counted for multi-channel devices) */
     retVal = CANUSB_CloseDevice(device->handle);
 //    if (retVal < 0)
 //        MACCAN_DEBUG_ERROR("+++ %s CAN%u: device could not be closed (%i)\n", device->name, device->channelNo+1, retVal);
-    /* destroy the pipe context */
-    /*retVal =*/ CANUSB_DestroyPipeAsync(device->recvPipe);
-//    if (retVal < 0)
-//        MACCAN_DEBUG_ERROR("+++ %s CAN%u: asynchronous pipe context could not be released (%i)\n", device->name, device->channelNo+1, retVal);
     /* destroy the message queue */
     /*retVal =*/ CANQUE_Destroy(device->recvData.msgQueue);
 //    if (retVal < 0)
@@ -240,16 +274,50 @@ CANUSB_Return_t KvaserUSB_CloseUsbDevice(KvaserUSB_Device_t *device) {
     /*retVal =*/ CANPIP_Destroy(device->recvData.msgPipe);
 //    if (retVal < 0)
 //        MACCAN_DEBUG_ERROR("+++ %s CAN%u: pipe could not be released (%i)\n", device->name, device->channelNo+1, retVal);
+    /* release the flight recorder (a pending capture is written) */
+    FlightRec_Release(&device->recvData.flightRec);
     /* Live long and prosper! */
     device->handle = CANUSB_INVALID_HANDLE;
     device->recvData.msgQueue = NULL;
     device->recvData.msgPipe = NULL;
-    device->recvPipe = NULL;
+    device->usbReader = NULL;
     device->configured = false;
 
     return retVal;
 }
 
+CANUSB_Return_t KvaserUSB_LockRequester(KvaserUSB_Device_t *device) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if (!device->usbReader)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* device-level responses (without a channel number) are routed to the requester,
+     * so only one CAN channel of a device may have such a request pending at once */
+    pthread_mutex_lock(&device->usbReader->request);
+    pthread_mutex_lock(&device->usbReader->mutex);
+    device->usbReader->requester = device->channelNo;
+    pthread_mutex_unlock(&device->usbReader->mutex);
+
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t KvaserUSB_UnlockRequester(KvaserUSB_Device_t *device) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->usbReader)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* note: the requester is kept for asynchronous device-level events */
+    pthread_mutex_unlock(&device->usbReader->request);
+
+    return CANUSB_SUCCESS;
+}
+
 CANUSB_Return_t KvaserUSB_SendRequest(KvaserUSB_Device_t *device, const uint8_t *buffer, uint32_t nbyte) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
 
@@ -259,11 +327,17 @@ CANUSB_Return_t KvaserUSB_SendRequest(KvaserUSB_Device_t *device, const uint8_t
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* note: responses without a channel number are routed to the requester,
+     *       device-level requests are bracketed by KvaserUSB_LockRequester
+     *       and KvaserUSB_UnlockRequester
+     */
     retVal = CANUSB_WritePipe(device->handle, device->endpoints.bulkOut.pipeRef, buffer, nbyte, 0U);  // note: time-out only used if OPTION_MACCAN_PIPE_TIMEOUT enabled
     if (retVal == CANUSB_SUCCESS)
-        MACCAN_LOG_WRITE((uint8_t*)buffer, nbyte, ">");
-    else
+        MACCAN_TRACE(CANTRC_USB_WRITE, nbyte, CANTRC_Word(buffer, nbyte));
+    else {
+        MACCAN_TRACE(CANTRC_USB_FAILED, nbyte, (SInt64)retVal);
         MACCAN_LOG_PRINTF("error(%i)\n", retVal);
+    }
     return retVal;
 }
 
@@ -314,8 +388,19 @@ CANUSB_Return_t KvaserUSB_StartReception(KvaserUSB_Device_t *device, CANUSB_Asyn
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
-    /* start asynchronous read on endpoint */
-    retVal = CANUSB_ReadPipeAsync(device->recvPipe, callback, (void*)&device->recvData);
+    if (!device->usbReader)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* register the driver callback (it is the same for all CAN channels on a device) */
+    pthread_mutex_lock(&device->usbReader->mutex);
+    device->usbReader->callback = callback;
+    pthread_mutex_unlock(&device->usbReader->mutex);
+
+    /* start asynchronous read on endpoint (if not already started by another CAN channel) */
+    if (!CANUSB_IsPipeAsyncRunning(device->usbReader->recvPipe))
+        retVal = CANUSB_ReadPipeAsync(device->usbReader->recvPipe, ReaderCallback, (void*)device->usbReader);
+    else
+        retVal = CANUSB_SUCCESS;
 //    if (retVal < 0)
 //        MACCAN_DEBUG_ERROR("+++ %s #%u: reception loop could not be started (%i)\n", device->name, device->channelNo, retVal);
 
@@ -331,14 +416,376 @@ CANUSB_Return_t KvaserUSB_AbortReception(KvaserUSB_Device_t *device) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
-    /* stop asynchronous read on endpoint */
-    retVal = CANUSB_AbortPipeAsync(device->recvPipe);
+    if (!device->usbReader)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* stop asynchronous read on endpoint (if no other CAN channel is attached) */
+    if (device->usbReader->refCount <= 1U)
+        retVal = CANUSB_AbortPipeAsync(device->usbReader->recvPipe);
+    else
+        retVal = CANUSB_SUCCESS;
 //    if (retVal < 0)
 //        MACCAN_DEBUG_ERROR("+++ %s #%u: reception loop could not be stopped (%i)\n", device->name, device->channelNo, retVal);
 
     return retVal;
 }
 
+KvaserUSB_RecvData_t *KvaserUSB_GetRecvData(KvaserUSB_UsbReader_t *reader, KvaserUSB_CanChannel_t channel) {
+    /* note: to be called from the reception callback only (mutex is held) */
+    if (!reader || (channel >= KVASER_MAX_CAN_CHANNELS))
+        return NULL;
+    return reader->recvData[channel];
+}
+
+CANUSB_Return_t KvaserUSB_MapHeAddress(KvaserUSB_Device_t *device, uint8_t he) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->usbReader)
+        return CANUSB_ERROR_NOTINIT;
+    if (he >= KVASER_MAX_HE_COUNT)
+        return CANUSB_ERROR_ILLPARA;
+
+    /* map the HE address to the CAN channel on the device */
+    pthread_mutex_lock(&device->usbReader->mutex);
+    device->usbReader->he2channel[he] = device->channelNo;
+    pthread_mutex_unlock(&device->usbReader->mutex);
+
+    return CANUSB_SUCCESS;
+}
+
+static uint32_t LockBusSample(KvaserUSB_RecvData_t *context) {
+    uint32_t sequence;
+
+    /* seqlock: an odd sequence number tells the readers to retry
+     * (note: the reception callback and the sampler thread (host bus load)
+     *        are writers, the odd number is taken by compare-and-swap) */
+    do {
+        sequence = __atomic_load_n(&context->busSample.sequence, __ATOMIC_RELAXED) & ~1U;
+    } while (!__atomic_compare_exchange_n(&context->busSample.sequence, &sequence, sequence + 1U,
+                                          false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return sequence;
+}
+
+void KvaserUSB_UpdateBusLoad(KvaserUSB_RecvData_t *context, KvaserUSB_BusLoad_t load) {
+    KvaserUSB_BusSample_t *snapshot;
+    uint32_t sequence, i, n;
+    uint32_t sum = 0U;
+
+    /* note: to be called from the reception callback or the sampler thread */
+    if (!context)
+        return;
+    snapshot = &context->busSample.snapshot;
+    sequence = LockBusSample(context);
+
+    /* the last bus load samples (sliding window) */
+    context->busSample.window[snapshot->samples % KVASER_SAMPLER_WINDOW] = load;
+    snapshot->samples += 1U;
+    n = (snapshot->samples < KVASER_SAMPLER_WINDOW) ? (uint32_t)snapshot->samples : KVASER_SAMPLER_WINDOW;
+    snapshot->busLoad = load;
+    snapshot->minLoad = load;
+    snapshot->maxLoad = load;
+    for (i = 0U; i < n; i++) {
+        if (context->busSample.window[i] < snapshot->minLoad)
+            snapshot->minLoad = context->busSample.window[i];
+        if (context->busSample.window[i] > snapshot->maxLoad)
+            snapshot->maxLoad = context->busSample.window[i];
+        sum += (uint32_t)context->busSample.window[i];
+    }
+    snapshot->avgLoad = (KvaserUSB_BusLoad_t)(sum / n);
+
+    __atomic_store_n(&context->busSample.sequence, sequence + 2U, __ATOMIC_RELEASE);
+}
+
+void KvaserUSB_UpdateBusStatus(KvaserUSB_RecvData_t *context, KvaserUSB_BusStatus_t status) {
+    uint32_t sequence;
+
+    /* note: to be called from the reception callback only */
+    if (!context)
+        return;
+
+    /* flight recorder: trigger on the transition to bus off */
+    if (context->flightRec.ring)
+        FlightRec_BusStatus(&context->flightRec, context->busSample.snapshot.busStatus, status);
+
+    sequence = LockBusSample(context);
+    context->busSample.snapshot.busStatus = status;
+    __atomic_store_n(&context->busSample.sequence, sequence + 2U, __ATOMIC_RELEASE);
+}
+
+void KvaserUSB_ReadBusSample(KvaserUSB_RecvData_t *context, KvaserUSB_BusSample_t *sample) {
+    uint32_t before, after = 0U;
+
+    /* note: lock-free, the reader retries while the snapshot is written */
+    if (!context || !sample)
+        return;
+    do {
+        before = __atomic_load_n(&context->busSample.sequence, __ATOMIC_ACQUIRE);
+        if (before & 1U)
+            continue;
+        memcpy(sample, &context->busSample.snapshot, sizeof(KvaserUSB_BusSample_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&context->busSample.sequence, __ATOMIC_RELAXED);
+    } while ((before & 1U) || (before != after));
+}
+
+void KvaserUSB_ResetBusSample(KvaserUSB_RecvData_t *context) {
+    uint32_t sequence;
+
+    /* note: the bus status is kept, the bus load window starts empty */
+    if (!context)
+        return;
+    sequence = LockBusSample(context);
+    bzero(context->busSample.window, sizeof(context->busSample.window));
+    context->busSample.snapshot.busLoad = 0U;
+    context->busSample.snapshot.minLoad = 0U;
+    context->busSample.snapshot.maxLoad = 0U;
+    context->busSample.snapshot.avgLoad = 0U;
+    context->busSample.snapshot.samples = 0U;
+    __atomic_store_n(&context->busSample.polls, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&context->busSample.sequence, sequence + 2U, __ATOMIC_RELEASE);
+}
+
+bool KvaserUSB_PolledChipState(KvaserUSB_RecvData_t *context) {
+    uint32_t polls;
+
+    /* note: a chip state event is the response to a request of the sampler
+     *       as long as there are requests of the sampler not yet answered */
+    if (!context)
+        return false;
+    polls = __atomic_load_n(&context->busSample.polls, __ATOMIC_RELAXED);
+    while (polls != 0U) {
+        if (__atomic_compare_exchange_n(&context->busSample.polls, &polls, polls - 1U,
+                                        false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return true;
+    }
+    return false;
+}
+
+void KvaserUSB_UpdateEventQueue(KvaserUSB_RecvData_t *context, uint8_t cmdCode) {
+    KvaserUSB_EventQueue_t *queue;
+    KvaserUSB_BusEvent_t *event;
+    const uint16_t *time;
+    uint8_t type, status, txErrors, rxErrors, code;
+    uint64_t ticks;
+    uint32_t head;
+
+    /* note: to be called from the reception callback only (single writer) */
+    if (!context)
+        return;
+    queue = &context->evQueue;
+
+    /* the event data have been updated by the device driver (UpdateEventData) */
+    switch (cmdCode) {
+        case CMD_CHIP_STATE_EVENT:
+            type = KVASER_EVENT_TYPE_CHIP_STATE;
+            time = context->evData.chipState.time;
+            status = context->evData.chipState.busStatus;
+            txErrors = context->evData.chipState.txErrorCounter;
+            rxErrors = context->evData.chipState.rxErrorCounter;
+            code = 0U;
+            /* chip states are also responses to polling: only transitions and counter changes */
+            if ((status == queue->busStatus) && (txErrors == queue->txErrorCounter) && (rxErrors == queue->rxErrorCounter))
+                return;
+            break;
+        case CMD_CAN_ERROR_EVENT:
+            type = KVASER_EVENT_TYPE_CAN_ERROR;
+            time = context->evData.canError.time;
+            status = context->evData.canError.busStatus;
+            txErrors = context->evData.canError.txErrorCounter;
+            rxErrors = context->evData.canError.rxErrorCounter;
+            code = context->evData.canError.errorFactor;
+            break;
+        case CMD_ERROR_EVENT:
+            /* the error event has no bus status and error counters: keep the last ones */
+            type = KVASER_EVENT_TYPE_ERROR;
+            time = context->evData.errorEvent.time;
+            status = queue->busStatus;
+            txErrors = queue->txErrorCounter;
+            rxErrors = queue->rxErrorCounter;
+            code = context->evData.errorEvent.errorCode;
+            break;
+        default:
+            return;
+    }
+    /* queue full: the event is lost (the readers are never blocked) */
+    head = queue->head;
+    if ((head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE)) >= KVASER_EVENT_QUEUE_SIZE) {
+        (void)__atomic_fetch_add(&queue->lost, 1U, __ATOMIC_RELAXED);
+    } else {
+        event = &queue->entry[head & (KVASER_EVENT_QUEUE_SIZE - 1U)];
+        ticks  = (uint64_t)time[0] << 0;
+        ticks |= (uint64_t)time[1] << 16;
+        ticks |= (uint64_t)time[2] << 32;
+        KvaserUSB_TimestampFromTicks(&event->timestamp, ticks, context->timerFreq);
+        event->type = type;
+        event->prevStatus = queue->busStatus;
+        event->busStatus = status;
+        event->txErrorCounter = txErrors;
+        event->rxErrorCounter = rxErrors;
+        event->errorCode = code;
+        __atomic_store_n(&queue->head, head + 1U, __ATOMIC_RELEASE);
+    }
+    queue->busStatus = status;
+    queue->txErrorCounter = txErrors;
+    queue->rxErrorCounter = rxErrors;
+}
+
+uint32_t KvaserUSB_ReadEventQueue(KvaserUSB_RecvData_t *context, KvaserUSB_BusEvent_t *events, uint32_t count) {
+    KvaserUSB_EventQueue_t *queue;
+    uint32_t head, tail, n, i;
+
+    /* note: lock-free, a reader retries when another reader was faster */
+    if (!context || !events)
+        return 0U;
+    queue = &context->evQueue;
+    do {
+        tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        n = ((head - tail) < count) ? (head - tail) : count;
+        /* the entries between tail and head are not overwritten until tail has moved */
+        for (i = 0U; i < n; i++)
+            events[i] = queue->entry[(tail + i) & (KVASER_EVENT_QUEUE_SIZE - 1U)];
+    } while ((n > 0U) && !__atomic_compare_exchange_n(&queue->tail, &tail, tail + n, false,
+                                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return n;
+}
+
+void KvaserUSB_ResetEventQueue(KvaserUSB_RecvData_t *context) {
+    KvaserUSB_EventQueue_t *queue;
+
+    /* note: the reception callback may still be running (the CAN controller is stopped),
+     *       so the pending events are skipped by the readers' position and not overwritten */
+    if (!context)
+        return;
+    queue = &context->evQueue;
+    __atomic_store_n(&queue->tail, __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    __atomic_store_n(&queue->lost, 0U, __ATOMIC_RELAXED);
+    queue->busStatus = 0U;
+    queue->txErrorCounter = 0U;
+    queue->rxErrorCounter = 0U;
+}
+
+static void SetGapData(KvaserUSB_CanMessage_t *marker, uint64_t lost, const KvaserUSB_Timestamp_t *last) {
+    int64_t span;
+
+    /* data[0..3]: number of lost CAN frames (saturated, 0 = unknown) */
+    if (lost > (uint64_t)UINT32_MAX)
+        lost = (uint64_t)UINT32_MAX;
+    marker->data[0] = (uint8_t)(lost >> 0);
+    marker->data[1] = (uint8_t)(lost >> 8);
+    marker->data[2] = (uint8_t)(lost >> 16);
+    marker->data[3] = (uint8_t)(lost >> 24);
+    /* data[4..7]: time from the first to the last lost CAN frame in [us] (saturated) */
+    span = ((int64_t)(last->tv_sec - marker->timestamp.tv_sec) * 1000000LL) +
+           ((int64_t)(last->tv_nsec - marker->timestamp.tv_nsec) / 1000LL);
+    if (span < 0)
+        span = 0;
+    if (span > (int64_t)UINT32_MAX)
+        span = (int64_t)UINT32_MAX;
+    marker->data[4] = (uint8_t)((uint64_t)span >> 0);
+    marker->data[5] = (uint8_t)((uint64_t)span >> 8);
+    marker->data[6] = (uint8_t)((uint64_t)span >> 16);
+    marker->data[7] = (uint8_t)((uint64_t)span >> 24);
+}
+
+void KvaserUSB_QueueGapMarker(void *marker, const void *element, UInt64 lost) {
+    KvaserUSB_CanMessage_t *gap = (KvaserUSB_CanMessage_t*)marker;
+    const KvaserUSB_CanMessage_t *message = (const KvaserUSB_CanMessage_t*)element;
+
+    /* note: called by the message queue (CANQUE_GapMarker_t) under its mutex */
+    if (!gap || !message)
+        return;
+    /* the first lost CAN frame opens the gap, the others extend it (0 = number unknown) */
+    if (lost == 1U) {
+        gap->id = KVASER_GAP_QUEUE_OVERRUN;
+        gap->sts = 1;
+        gap->dlc = 8U;
+        gap->timestamp = message->timestamp;
+    }
+    SetGapData(gap, (uint64_t)lost, &message->timestamp);
+}
+
+void KvaserUSB_DeviceGapMarker(KvaserUSB_RecvData_t *context, const KvaserUSB_Timestamp_t *timestamp) {
+    KvaserUSB_CanMessage_t gap;
+
+    /* note: to be called from the reception callback only */
+    if (!context || !timestamp || !context->gapMarkers)
+        return;
+    /* the device tells only that CAN frames were lost before this time */
+    bzero(&gap, sizeof(KvaserUSB_CanMessage_t));
+    gap.id = KVASER_GAP_DEVICE_OVERRUN;
+    gap.sts = 1;
+    gap.dlc = 8U;
+    gap.timestamp = *timestamp;
+    SetGapData(&gap, 0U, timestamp);
+    /* note: the marker is no lost CAN frame; when the queue is full, it takes
+     *       the gap marker of the queue (the number of lost CAN frames unknown) */
+    (void)CANQUE_EnqueueMarker(context->msgQueue, (void*)&gap);
+}
+
+void KvaserUSB_BeginUrb(KvaserUSB_UsbReader_t *reader) {
+    uint32_t sequence;
+
+    /* note: to be called from the reception callback only (single writer) */
+    if (!reader)
+        return;
+
+    /* seqlock: odd while the hot-path counters are updated */
+    sequence = __atomic_load_n(&reader->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&reader->sequence, sequence + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    reader->counters.urbs += 1U;
+}
+
+void KvaserUSB_EndUrb(KvaserUSB_UsbReader_t *reader) {
+    /* note: to be called from the reception callback only (single writer) */
+    if (!reader)
+        return;
+
+    /* seqlock: even again, the counters are consistent */
+    __atomic_store_n(&reader->sequence, __atomic_load_n(&reader->sequence, __ATOMIC_RELAXED) + 1U, __ATOMIC_RELEASE);
+}
+
+void KvaserUSB_ReadPathCounters(KvaserUSB_Device_t *device, KvaserUSB_PathCounters_t *counters) {
+    KvaserUSB_UsbReader_t *reader;
+    uint32_t before = 0U, after = 0U;
+
+    /* note: lock-free, the reader retries while a URB is decoded */
+    if (!device || !counters)
+        return;
+    reader = device->usbReader;
+    memset(counters, 0, sizeof(KvaserUSB_PathCounters_t));
+    do {
+        if (reader) {
+            before = __atomic_load_n(&reader->sequence, __ATOMIC_ACQUIRE);
+            if (before & 1U)
+                continue;
+            memcpy(&counters->urb, &reader->counters, sizeof(KvaserUSB_UrbCounters_t));
+        }
+        /* the reception queue is written by the reception callback (within the URB) */
+        counters->queueHigh = (uint64_t)CANQUE_QueueHigh(device->recvData.msgQueue);
+        counters->queueOverflows = (uint64_t)CANQUE_OverflowCounter(device->recvData.msgQueue);
+        if (reader) {
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            after = __atomic_load_n(&reader->sequence, __ATOMIC_RELAXED);
+        }
+    } while ((before & 1U) || (before != after));
+    /* lock waits, Tx acknowledges and write failures: written by the application threads */
+    (void)CANQUE_LockWaits(device->recvData.msgQueue, (UInt64*)&counters->lockWaits, (UInt64*)&counters->lockWaitTime);
+    counters->txPending = (uint64_t)__atomic_load_n(&device->recvData.txAck.cntMsg, __ATOMIC_RELAXED);
+    counters->writeFailures = __atomic_load_n(&device->sendData.errCounter, __ATOMIC_RELAXED);
+}
+
+CANUSB_Return_t KvaserUSB_GetUsbLocation(CANUSB_Index_t channel, uint32_t *location, KvaserUSB_CanChannel_t *canChannel) {
+    KvaserUSB_CanChannel_t dummy = 0U;
+    CANUSB_Index_t index = GetUsbDeviceIndex(channel, canChannel ? canChannel : &dummy);
+
+    /* note: the USB location ID identifies a device across process boundaries */
+    return CANUSB_GetDeviceLocation(index, (UInt32*)location);
+}
+
 uint64_t KvaserUSB_NanosecondsFromTicks(KvaserUSB_CpuTicks_t cpuTicks, KvaserUSB_Frequency_t cpuFreq) {
     /*
      *  param[in]   cpuTicks   - timer value from device
@@ -362,3 +809,136 @@ void KvaserUSB_TimestampFromTicks(KvaserUSB_Timestamp_t *timeStamp, KvaserUSB_Cp
     timeStamp->tv_sec = (time_t)(nsec / 1000000000ULL);
     timeStamp->tv_nsec =  (long)(nsec % 1000000000ULL);
 }
+
+static void InitUsbReaders(void) {
+    pthread_mutexattr_t attr;
+
+    (void)pthread_mutexattr_init(&attr);
+    (void)pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    for (int i = 0; i < CANUSB_MAX_DEVICES; i++) {
+        bzero(&usbReader[i], sizeof(KvaserUSB_UsbReader_t));
+        (void)pthread_mutex_init(&usbReader[i].mutex, NULL);
+        (void)pthread_mutex_init(&usbReader[i].request, &attr);
+    }
+    (void)pthread_mutexattr_destroy(&attr);
+}
+
+static void ReaderCallback(void *refCon, UInt8 *buffer, UInt32 size) {
+    KvaserUSB_UsbReader_t *reader = (KvaserUSB_UsbReader_t*)refCon;
+
+    assert(refCon);
+
+    /* call the driver callback with the USB reader as context,
+     * it demultiplexes the commands to the attached CAN channels */
+    pthread_mutex_lock(&reader->mutex);
+    if (reader->callback && (reader->refCount > 0U))
+        reader->callback((void*)reader, buffer, size);
+    pthread_mutex_unlock(&reader->mutex);
+}
+
+static CANUSB_Return_t AttachUsbReader(KvaserUSB_Device_t *device) {
+    KvaserUSB_UsbReader_t *reader = NULL;
+
+    assert(device);
+
+    if (!IS_READER_VALID(device->handle))
+        return CANUSB_ERROR_HANDLE;
+    if (device->channelNo >= KVASER_MAX_CAN_CHANNELS)
+        return CANUSB_ERROR_ILLPARA;
+    (void)pthread_once(&readerOnce, InitUsbReaders);
+    reader = &usbReader[device->handle];
+
+    ENTER_READER_SECTION();
+    if (reader->refCount == 0U) {
+        /* first CAN channel: create a pipe context for the bulk-in endpoint of the device */
+        reader->recvPipe = CANUSB_CreatePipeAsync(device->handle, device->endpoints.bulkIn.pipeRef,
+                                                                  device->endpoints.bulkIn.packetSize);
+        if (reader->recvPipe == NULL) {
+            LEAVE_READER_SECTION();
+            return CANUSB_ERROR_RESOURCE;
+        }
+        reader->callback = NULL;
+        reader->hydraBuf.length = 0U;
+        memset(reader->recvData, 0, sizeof(reader->recvData));
+        memset(reader->he2channel, 0xFF, sizeof(reader->he2channel));
+    } else if (reader->recvData[device->channelNo] != NULL) {
+        /* the CAN channel is already attached (by another handle) */
+        LEAVE_READER_SECTION();
+        return CANUSB_ERROR_YETINIT;
+    }
+    pthread_mutex_lock(&reader->mutex);
+    if (reader->refCount == 0U)
+        reader->requester = device->channelNo;
+    reader->recvData[device->channelNo] = &device->recvData;
+    reader->refCount++;
+    pthread_mutex_unlock(&reader->mutex);
+    device->usbReader = reader;
+    LEAVE_READER_SECTION();
+
+    return CANUSB_SUCCESS;
+}
+
+static CANUSB_Return_t DetachUsbReader(KvaserUSB_Device_t *device) {
+    KvaserUSB_UsbReader_t *reader = NULL;
+    bool last = false;
+
+    assert(device);
+
+    if ((reader = device->usbReader) == NULL)
+        return CANUSB_ERROR_NOTINIT;
+
+    ENTER_READER_SECTION();
+    pthread_mutex_lock(&reader->mutex);
+    reader->recvData[device->channelNo] = NULL;
+    for (int i = 0; i < (int)KVASER_MAX_HE_COUNT; i++) {
+        if (reader->he2channel[i] == device->channelNo)
+            reader->he2channel[i] = 0xFFU;
+    }
+    if (reader->refCount > 0U)
+        reader->refCount--;
+    last = (reader->refCount == 0U) ? true : false;
+    /* asynchronous device-level events go to another attached CAN channel */
+    for (int i = 0; !last && (reader->requester == device->channelNo) && (i < (int)KVASER_MAX_CAN_CHANNELS); i++) {
+        if (reader->recvData[i] != NULL)
+            reader->requester = (uint8_t)i;
+    }
+    pthread_mutex_unlock(&reader->mutex);
+    if (last) {
+        /* last CAN channel: stop the reader and release the pipe context */
+        (void)CANUSB_AbortPipeAsync(reader->recvPipe);
+        (void)CANUSB_DestroyPipeAsync(reader->recvPipe);
+        reader->recvPipe = NULL;
+        reader->callback = NULL;
+    }
+    LEAVE_READER_SECTION();
+    device->usbReader = NULL;
+
+    return CANUSB_SUCCESS;
+}
+
+static CANUSB_Index_t GetUsbDeviceIndex(CANUSB_Index_t channel, KvaserUSB_CanChannel_t *canChannel) {
+    assert(canChannel);
+
+#if (OPTION_MACCAN_MULTICHANNEL != 0)
+    CANUSB_Index_t index;
+    uint8_t n;
+
+    /* channel numbers are assigned consecutively to the CAN channels of all devices,
+     * whereby an empty slot in the device list counts as one channel (so that with
+     * single-channel devices the channel number is still the device index) */
+    for (index = 0; (index < CANUSB_MAX_DEVICES) && (channel >= 0); index++) {
+        if ((CANUSB_GetDeviceNumCanChannels(index, &n) < 0) || (n == 0U))
+            n = 1U;
+        if (channel < (CANUSB_Index_t)n) {
+            *canChannel = (KvaserUSB_CanChannel_t)channel;
+            return index;
+        }
+        channel -= (CANUSB_Index_t)n;
+    }
+    *canChannel = 0U;
+    return CANUSB_MAX_DEVICES;  /* note: invalid index */
+#else
+    *canChannel = 0U;
+    return channel;
+#endif
+}
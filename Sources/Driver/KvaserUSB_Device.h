@@ -53,6 +53,12 @@
 #include "MacCAN_IOUsbKit.h"
 #include "MacCAN_MsgQueue.h"
 #include "MacCAN_MsgPipe.h"
+#include "MacCAN_SharedMem.h"
+#include "MacCAN_Trace.h"
+
+#include <pthread.h>
+
+#define KVASER_TRACE_TIME(ts)  (((UInt64)(ts).tv_sec * 1000000000ULL) + (UInt64)(ts).tv_nsec)
 
 typedef enum kavser_driver_type_t_ {    /* driver type: */
     USB_LEAF_DRIVER,                    /* - driver for Leaf devices */
@@ -158,6 +164,58 @@ typedef uint8_t KvaserUSB_BusStatus_t;  /* bus status (Kvaser bus status)! */
 
 typedef uint16_t KvaserUSB_BusLoad_t;   /* bus load (0..10000 = 0.00..100.00) */
 
+typedef struct kvaser_bus_sample_t_ {   /* bus load and status (snapshot): */
+    KvaserUSB_BusLoad_t busLoad;        /* - bus load of the last sample */
+    KvaserUSB_BusLoad_t minLoad;        /* - min. bus load within the window */
+    KvaserUSB_BusLoad_t maxLoad;        /* - max. bus load within the window */
+    KvaserUSB_BusLoad_t avgLoad;        /* - average bus load within the window */
+    KvaserUSB_BusStatus_t busStatus;    /* - bus status of the last chip state */
+    uint64_t samples;                   /* - number of bus load samples */
+} KvaserUSB_BusSample_t;
+
+typedef struct kvaser_bus_sampler_t_ {  /* bus load and status sampler (reception side): */
+    volatile uint32_t sequence;         /* - seqlock: odd while the snapshot is written */
+    KvaserUSB_BusSample_t snapshot;     /* - the snapshot (written by the reception callback) */
+    KvaserUSB_BusLoad_t window[KVASER_SAMPLER_WINDOW];  /* - the last bus load samples */
+    uint32_t polls;                     /* - chip state requests of the sampler (not yet answered) */
+    volatile bool active;               /* - flag: sampler thread running (responses not piped) */
+} KvaserUSB_BusSampler_t;
+
+typedef struct kvaser_load_meter_t_ {   /* bus load computed from the CAN frames (host side): */
+    uint32_t nominalTime;               /* - nominal bit time in [ps] (0 = not configured) */
+    uint32_t dataTime;                  /* - data phase bit time in [ps] */
+    uint64_t startTime;                 /* - start of the measurement in [ns] */
+    uint64_t bucket[KVASER_LOAD_BUCKETS];  /* - bucket no. (24 bits) and busy time in [ps] (40 bits) */
+} KvaserUSB_LoadMeter_t;
+
+typedef struct kvaser_flight_slot_t_ {  /* flight recorder slot: */
+    volatile uint64_t sequence;         /* - position + 1 (0 = slot is written) */
+    uint64_t time;                      /* - host time in [ns] */
+    KvaserUSB_CanMessage_t message;     /* - the CAN frame (received or sent) */
+} KvaserUSB_FlightSlot_t;
+
+typedef struct kvaser_flight_recorder_t_ {  /* flight recorder (circular capture): */
+    KvaserUSB_FlightSlot_t *ring;       /* - mmap-backed ring of CAN frames (NULL = off) */
+    uint32_t capacity;                  /* - number of slots (power of 2) */
+    volatile uint64_t head;             /* - next position (claimed by the producers) */
+    uint8_t triggers;                   /* - enabled trigger conditions */
+    KvaserUSB_CanMessage_t match;       /* - identifier and payload for the ID match */
+    uint32_t preTime;                   /* - pre-trigger window in [ms] */
+    uint32_t postTime;                  /* - post-trigger window in [ms] */
+    int64_t wallOffset;                 /* - wall clock minus host time in [ns] (capture file) */
+    volatile uint32_t state;            /* - armed, firing, triggered or writing */
+    volatile uint64_t triggerTime;      /* - host time of the trigger in [ns] */
+    volatile uint8_t cause;             /* - trigger condition of the pending capture */
+    volatile uint32_t captures;         /* - number of capture files written */
+    int32_t channel;                    /* - channel no. (for the file header) */
+    const char *device;                 /* - device name (for the file header) */
+    char path[KVASER_FLIGHT_PATH_LENGTH+1];  /* - path prefix of the capture files */
+    pthread_t thread;                   /* - writer thread */
+    pthread_mutex_t mutex;              /* - to wait for a trigger */
+    pthread_cond_t cond;                /* - to wake up the thread on trigger or stop */
+    volatile bool running;              /* - to terminate the thread */
+} KvaserUSB_FlightRecorder_t;
+
 typedef struct kvaser_chip_state_event_t_ {  /* event - chip state: */
     uint8_t  channel;                   /* - channel no. (from header) */
     uint16_t time[3];                   /* - 48-bit timer value */
@@ -193,6 +251,26 @@ typedef struct kvaser_event_data_t_  {  /* event data: */
     KvaserUSB_CanErrorEvent_t canError; /* - CAN error event */
 } KvaserUSB_EventData_t;
 
+typedef struct kvaser_event_entry_t_ {  /* bus event (chip state, CAN error or error event): */
+    KvaserUSB_Timestamp_t timestamp;    /* - time-stamp from the device (time base of the CAN frames) */
+    uint8_t type;                       /* - event type (KVASER_EVENT_TYPE_xxx) */
+    uint8_t prevStatus;                 /* - bus status before the event */
+    uint8_t busStatus;                  /* - bus status after the event */
+    uint8_t txErrorCounter;             /* - tx error counter */
+    uint8_t rxErrorCounter;             /* - rx error counter */
+    uint8_t errorCode;                  /* - error code (error event) or error factor (CAN error) */
+} KvaserUSB_BusEvent_t;
+
+typedef struct kvaser_event_queue_t_ {  /* bus event queue (one producer, lock-free readers): */
+    KvaserUSB_BusEvent_t entry[KVASER_EVENT_QUEUE_SIZE];  /* - ring of bus events */
+    volatile uint32_t head;             /* - next entry to be written (reception callback) */
+    volatile uint32_t tail;             /* - next entry to be read (readers) */
+    volatile uint64_t lost;             /* - number of events lost (queue full) */
+    uint8_t busStatus;                  /* - last bus status (reception callback) */
+    uint8_t txErrorCounter;             /* - last tx error counter (reception callback) */
+    uint8_t rxErrorCounter;             /* - last rx error counter (reception callback) */
+} KvaserUSB_EventQueue_t;
+
 typedef struct kvaser_endpoints_t_ {    /* USB endpoints: */
     uint8_t numEndpoints;               /* - number of endpoints */
     struct {                            /* - endpoints (pipes): */
@@ -205,6 +283,24 @@ typedef uint8_t KvaserUSB_Frequency_t;  /* CAN clock / timer (in [MHz]) */
 
 typedef uint64_t KvaserUSB_CpuTicks_t;  /* 48-bit timer value (ticks) */
 
+typedef struct kvaser_urb_counters_t_ { /* hot-path counters (USB reader, all CAN channels of a device): */
+    uint64_t urbs;                      /* - number of URBs received */
+    uint64_t bytes;                     /* - number of bytes decoded (commands) */
+    uint64_t errors;                    /* - number of decode errors (malformed URBs or commands) */
+    uint64_t unknown;                   /* - number of unknown commands */
+    uint64_t splits;                    /* - number of commands reassembled from two URBs */
+} KvaserUSB_UrbCounters_t;
+
+typedef struct kvaser_path_counters_t_ {/* hot-path counters (snapshot of a CAN channel): */
+    KvaserUSB_UrbCounters_t urb;        /* - reception: URBs, bytes, errors, unknown commands, splits */
+    uint64_t queueHigh;                 /* - high-water mark of the reception queue */
+    uint64_t queueOverflows;            /* - number of overflow events of the reception queue */
+    uint64_t lockWaits;                 /* - number of contended locks of the reception queue */
+    uint64_t lockWaitTime;              /* - total wait time for the lock of the reception queue in [ns] */
+    uint64_t txPending;                 /* - number of outstanding Tx acknowledges */
+    uint64_t writeFailures;             /* - number of USB write failures */
+} KvaserUSB_PathCounters_t;
+
 typedef struct kavser_hydra_buffer_t_ { /* USB Hydra retention buffer (Leaf Pro): */
     uint32_t length;                    /* - number of bytes in the retention buffer */
     uint8_t buffer[KVASER_HYDRA_RETENTION_SIZE];
@@ -214,37 +310,73 @@ typedef struct kvaser_recv_context_t_ { /* USB read pipe context: */
     CANPIP_MsgPipe_t msgPipe;           /* - message pipe for data exchange */
     CANQUE_MsgQueue_t msgQueue;         /* - message queue for received CAN frames */
     KvaserUSB_OpMode_t opMode;          /* - demanded CAN operation mode */
+    bool gapMarkers;                    /* - flag: gap markers in the message queue */
     KvaserUSB_EventData_t evData;       /* - asynchronous event data */
+    KvaserUSB_EventQueue_t evQueue;     /* - queue of bus events (with time-stamp) */
     KvaserUSB_Timestamp_t timeRef;      /* - time reference (UTC+0) */
     KvaserUSB_Frequency_t canClock;     /* - CAN clock in [MHz] */
     KvaserUSB_Frequency_t timerFreq;    /* - CAN timer in [MHz] */
-    KvaserUSB_HydraBuffer_t hydraBuf;   /* - retention buffer */
     struct tx_acknowledge_tag {         /* - Tx acknowledge: */
         uint8_t maxMsg;                 /*   - max. outstanding Tx messages */
         uint8_t cntMsg;                 /*   - number of sent Tx messages */
         uint8_t transId;                /*   - transaction ID (0..maxMsg-1) */
         bool noAck;                     /*   - flag to skip CMD_TX_ACKNOWLEDGE */
     } txAck;
-    uint64_t msgCounter;                /* - number of received CAN frames */
-    uint64_t stsCounter;                /* - number of received error frames */
-    uint64_t errCounter;                /* - number of received error events */
+    uint64_t msgCounter;                /* - number of received CAN frames (atomic) */
+    uint64_t stsCounter;                /* - number of received error frames (atomic) */
+    uint64_t errCounter;                /* - number of received error events (atomic) */
+    KvaserUSB_BusSampler_t busSample;   /* - bus load and status (snapshot) */
+    KvaserUSB_LoadMeter_t loadMeter;    /* - bus load computed from the CAN frames */
+    KvaserUSB_FlightRecorder_t flightRec;  /* - flight recorder of all CAN frames */
+    CANSHM_Segment_t sharedMem;         /* - shared memory to publish all CAN frames (or NULL) */
     // TODO: do we need a mutex?
 } KvaserUSB__AsyncContext_t, KvaserUSB_RecvData_t;
 typedef CANUSB_AsyncPipe_t KvaserUSB_RecvPipe_t;
 
+typedef struct kvaser_usb_reader_t_ {   /* USB reader (shared by all CAN channels on a device): */
+    KvaserUSB_RecvPipe_t recvPipe;      /* - USB reception pipe (bulk in) */
+    CANUSB_AsyncPipeCbk_t callback;     /* - reception callback of the driver */
+    KvaserUSB_HydraBuffer_t hydraBuf;   /* - retention buffer (Hydra devices) */
+    KvaserUSB_RecvData_t *recvData[KVASER_MAX_CAN_CHANNELS];  /* - per-channel queue and pipe */
+    uint8_t he2channel[KVASER_MAX_HE_COUNT];  /* - to map 6-bit HE to a channel no. */
+    uint8_t requester;                  /* - channel no. of the pending device-level request */
+    uint8_t refCount;                   /* - number of CAN channels attached */
+    pthread_mutex_t mutex;              /* - to guard the channel list */
+    pthread_mutex_t request;            /* - to serialize device-level requests (recursive) */
+    volatile uint32_t sequence;         /* - seqlock: odd while a URB is decoded */
+    KvaserUSB_UrbCounters_t counters;   /* - hot-path counters (written by the reception callback) */
+} KvaserUSB_UsbReader_t;
+
 typedef struct kvaser_send_context_t_ { /* USB write pipe context: */
 #if (0)
     CANQUE_MsgQueue_t msgQueue;         /* - message queue for CAN frames to be sent */
     bool isBusy;                        /* - to indicate a transmission in progress */
 #endif
-    uint64_t msgCounter;                /* - number of written CAN frames */
-    uint64_t errCounter;                /* - number of write pipe errors */
+    uint64_t msgCounter;                /* - number of written CAN frames (atomic) */
+    uint64_t errCounter;                /* - number of write pipe errors (atomic) */
     // TODO: do we need a mutex?
 } KvaserUSB_SendContext_t, KvaserUSB_SendData_t;
 // TODO: typedef CANUSB_AsyncPipe_t KvaserUSB_SendPipe_t;
 
 typedef uint8_t KvaserUSB_CanChannel_t; /* CAN channel on a device (range 0,..n) */
 
+typedef struct kvaser_shared_access_t_ {/* shared access (CANMODE_SHRD): */
+    CANSHM_Segment_t segment;           /* - shared memory segment (NULL if exclusive) */
+    pthread_t thread;                   /* - server thread (owner) or forwarder thread (client) */
+    pthread_mutex_t mutex;              /* - to serialize transmission (owner) */
+    bool running;                       /* - to terminate the thread (atomic) */
+    bool client;                        /* - flag: CAN channel is owned by another process */
+    uint64_t lostCounter;               /* - number of CAN frames lost in the ring (client) */
+} KvaserUSB_SharedAccess_t;
+
+typedef struct kvaser_sampler_thread_t_ {/* bus load and status sampler (request side): */
+    pthread_t thread;                   /* - sampler thread */
+    pthread_mutex_t mutex;              /* - to wait for the next interval */
+    pthread_cond_t cond;                /* - to wake up the thread on stop */
+    uint32_t interval;                  /* - sampling interval in [ms] (0 = off) */
+    volatile bool running;              /* - to terminate the thread */
+} KvaserUSB_SamplerThread_t;
+
 typedef int32_t KvaserUSB_CanClock_t;
 
 typedef struct kavser_hydra_channel_t_ {/* Hydra device data (Leaf Pro): */
@@ -258,7 +390,7 @@ typedef struct kvaser_device_t_ {       /* KvaserCAN device: */
     uint16_t releaseNo;                 /* - USB release no. */
     CANUSB_Handle_t handle;             /* - USB hanlde */
     KvaserUSB_Endpoints_t endpoints;    /* - USB endpoints */
-    KvaserUSB_RecvPipe_t recvPipe;      /* - USB reception pipe */
+    KvaserUSB_UsbReader_t *usbReader;   /* - USB reader (shared) */
     KvaserUSB_RecvData_t recvData;      /* - pipe w/ CAN message queue */
     KvaserUSB_SendData_t sendData;      /* - only some statistical counters */
     KvaserUSB_CanChannel_t numChannels; /* - number of CAN channels */
@@ -267,6 +399,10 @@ typedef struct kvaser_device_t_ {       /* KvaserCAN device: */
     KvaserUSB_DeviceInfo_t deviceInfo;  /* - device information (hw, sw, etc.) */
     KvaserUSB_DriverType_t driverType;  /* - driver type (Leaf or Mhydra device) */
     KvaserUSB_HydraData_t hydraData;    /* - Hydra device data (e.g. Leaf Pro HS v2) */
+    KvaserUSB_SharedAccess_t shared;    /* - shared access by several processes */
+    KvaserUSB_SamplerThread_t sampler;  /* - bus load and status sampler */
+    KvaserUSB_PathCounters_t baseline;  /* - hot-path counters at the last reset */
+    volatile uint32_t baselineSeq;      /* - seqlock: odd while the baseline is written */
     char name[KVASER_MAX_STRING_LENGTH+1];   /* - device name (zero-terminated string) */
     char vendor[KVASER_MAX_STRING_LENGTH+1]; /* - vendor name (zero-terminated string) */
     char website[KVASER_MAX_STRING_LENGTH+1];/* - vendor website (zero-terminated string) */
@@ -284,6 +420,25 @@ extern CANUSB_Return_t KvaserUSB_CloseUsbDevice(KvaserUSB_Device_t *device);
 extern CANUSB_Return_t KvaserUSB_StartReception(KvaserUSB_Device_t *device, CANUSB_AsyncPipeCbk_t callback);
 extern CANUSB_Return_t KvaserUSB_AbortReception(KvaserUSB_Device_t *device);
 
+extern KvaserUSB_RecvData_t *KvaserUSB_GetRecvData(KvaserUSB_UsbReader_t *reader, KvaserUSB_CanChannel_t channel);
+extern CANUSB_Return_t KvaserUSB_MapHeAddress(KvaserUSB_Device_t *device, uint8_t he);
+extern void KvaserUSB_UpdateBusLoad(KvaserUSB_RecvData_t *context, KvaserUSB_BusLoad_t load);
+extern void KvaserUSB_UpdateBusStatus(KvaserUSB_RecvData_t *context, KvaserUSB_BusStatus_t status);
+extern void KvaserUSB_ReadBusSample(KvaserUSB_RecvData_t *context, KvaserUSB_BusSample_t *sample);
+extern void KvaserUSB_ResetBusSample(KvaserUSB_RecvData_t *context);
+extern bool KvaserUSB_PolledChipState(KvaserUSB_RecvData_t *context);
+extern void KvaserUSB_UpdateEventQueue(KvaserUSB_RecvData_t *context, uint8_t cmdCode);
+extern uint32_t KvaserUSB_ReadEventQueue(KvaserUSB_RecvData_t *context, KvaserUSB_BusEvent_t *events, uint32_t count);
+extern void KvaserUSB_ResetEventQueue(KvaserUSB_RecvData_t *context);
+extern void KvaserUSB_QueueGapMarker(void *marker, const void *element, UInt64 lost);
+extern void KvaserUSB_DeviceGapMarker(KvaserUSB_RecvData_t *context, const KvaserUSB_Timestamp_t *timestamp);
+extern void KvaserUSB_BeginUrb(KvaserUSB_UsbReader_t *reader);
+extern void KvaserUSB_EndUrb(KvaserUSB_UsbReader_t *reader);
+extern void KvaserUSB_ReadPathCounters(KvaserUSB_Device_t *device, KvaserUSB_PathCounters_t *counters);
+extern CANUSB_Return_t KvaserUSB_GetUsbLocation(CANUSB_Index_t channel, uint32_t *location, KvaserUSB_CanChannel_t *canChannel);
+
+extern CANUSB_Return_t KvaserUSB_LockRequester(KvaserUSB_Device_t *device);
+extern CANUSB_Return_t KvaserUSB_UnlockRequester(KvaserUSB_Device_t *device);
 extern CANUSB_Return_t KvaserUSB_SendRequest(KvaserUSB_Device_t *device, const uint8_t *buffer, uint32_t nbyte);
 extern CANUSB_Return_t KvaserUSB_ReadResponse(KvaserUSB_Device_t *device, uint8_t *buffer, uint32_t nbyte,
                                                                           uint8_t cmdCode, /*uint8_t transId,*/ uint16_t timeout);
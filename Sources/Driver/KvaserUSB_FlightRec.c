@@ -0,0 +1,383 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Interfaces
+ *
+ *  Copyright (c) 2020-2022 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "KvaserUSB_FlightRec.h"
+#include "KvaserUSB_LoadMeter.h"
+#include "can_rec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <assert.h>
+#include "MacCAN_Debug.h"
+
+#if (OPTION_CANAPI_COMPANIONS == 0)
+#error Set OPTION_CANAPI_COMPANIONS to a non-zero value (the capture file takes CAN API V3 messages)
+#endif
+
+/*  ---  flight recorder  ---
+ *
+ *  Every CAN frame received (where the reception callback enqueues it, before any suppression)
+ *  and sent (when it is handed over to the device) is copied into a ring of slots.  The ring
+ *  is mapped anonymously when the capacity is configured and is never locked: the producers
+ *  (the reception callback and the sending threads) claim a position with a fetch-and-add on
+ *  the head, and every slot carries its own sequence number (0 while the slot is written,
+ *  position + 1 when it is complete), so the writer thread can copy the slots without
+ *  stopping the producers.  The oldest CAN frames are overwritten.
+ *
+ *  A trigger (error frame, bus off, ID and payload match or an API call) stores the host time
+ *  of the event.  The writer thread waits until the post-trigger window has elapsed, copies
+ *  all CAN frames between trigger - pre-time and trigger + post-time from the ring and writes
+ *  them into the capture file '<prefix>-<n>.crec' (see can_rec.h).  Further triggers are
+ *  ignored until the capture file is written, then the recorder is armed again.
+ *
+ *  Note: the ring must hold pre-time + post-time worth of CAN frames, otherwise the beginning
+ *  of the pre-trigger window is lost.  All CAN frames in the capture file get the wall clock
+ *  time when they were recorded (the device time-stamps of received CAN frames and the host
+ *  time-stamps of sent CAN frames are not on the same time base).
+ */
+#define STATE_ARMED      0U  /* waiting for a trigger */
+#define STATE_FIRING     1U  /* trigger time and cause are being stored */
+#define STATE_TRIGGERED  2U  /* waiting for the end of the post-trigger window */
+#define STATE_WRITING    3U  /* capture file is written */
+
+#define NSEC_PER_MSEC  1000000ULL
+#define NSEC_PER_SEC  1000000000ULL
+
+static const uint8_t dlc2len[16] = { 0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64 };
+
+static void PutFrame(KvaserUSB_FlightRecorder_t *recorder, const KvaserUSB_CanMessage_t *message, uint64_t now);
+static bool MatchFrame(const KvaserUSB_CanMessage_t *pattern, const KvaserUSB_CanMessage_t *message);
+static int WriteCapture(KvaserUSB_FlightRecorder_t *recorder);
+static void *WriterThread(void *arg);
+
+void FlightRec_Init(KvaserUSB_FlightRecorder_t *recorder) {
+    /* sanity check */
+    if (!recorder)
+        return;
+
+    /* note: the recorder is off until a capacity is configured */
+    memset(recorder, 0, sizeof(KvaserUSB_FlightRecorder_t));
+    recorder->preTime = KVASER_FLIGHT_PRE_TIME;
+    recorder->postTime = KVASER_FLIGHT_POST_TIME;
+    recorder->state = STATE_ARMED;
+    strncpy(recorder->path, KVASER_FLIGHT_FILE_PREFIX, KVASER_FLIGHT_PATH_LENGTH);
+    (void)pthread_mutex_init(&recorder->mutex, NULL);
+    (void)pthread_cond_init(&recorder->cond, NULL);
+}
+
+void FlightRec_Release(KvaserUSB_FlightRecorder_t *recorder) {
+    /* sanity check */
+    if (!recorder)
+        return;
+
+    /* note: to be called when the reception callback is detached */
+    (void)FlightRec_Stop(recorder);
+    (void)FlightRec_Configure(recorder, 0U);
+    (void)pthread_cond_destroy(&recorder->cond);
+    (void)pthread_mutex_destroy(&recorder->mutex);
+}
+
+CANUSB_Return_t FlightRec_Configure(KvaserUSB_FlightRecorder_t *recorder, uint32_t capacity) {
+    KvaserUSB_FlightSlot_t *ring = NULL;
+    uint32_t slots = 1U;
+
+    /* sanity check */
+    if (!recorder)
+        return CANUSB_ERROR_NULLPTR;
+    if (capacity > KVASER_FLIGHT_MAX_CAPACITY)
+        return CANUSB_ERROR_ILLPARA;
+    if (recorder->running)
+        return CANUSB_ERROR_BUSY;
+
+    /* the capacity is rounded up to a power of 2 (0 = off) */
+    while (slots < capacity)
+        slots <<= 1;
+    if (capacity && (slots == recorder->capacity))
+        return CANUSB_SUCCESS;
+    if (capacity) {
+        ring = (KvaserUSB_FlightSlot_t*)mmap(NULL, (size_t)slots * sizeof(KvaserUSB_FlightSlot_t),
+                                             PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (ring == (KvaserUSB_FlightSlot_t*)MAP_FAILED)
+            return CANUSB_ERROR_RESOURCE;
+    }
+    /* note: the CAN controller is stopped, there is no producer on the ring */
+    if (recorder->ring)
+        (void)munmap((void*)recorder->ring, (size_t)recorder->capacity * sizeof(KvaserUSB_FlightSlot_t));
+    recorder->capacity = capacity ? slots : 0U;
+    recorder->head = 0U;
+    __atomic_store_n(&recorder->ring, ring, __ATOMIC_RELEASE);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t FlightRec_Start(KvaserUSB_FlightRecorder_t *recorder, int32_t channel, const char *device) {
+    struct timespec wall;
+
+    /* sanity check */
+    if (!recorder)
+        return CANUSB_ERROR_NULLPTR;
+    if (!recorder->ring || recorder->running)
+        return CANUSB_SUCCESS;
+
+    /* offset between wall clock and host time (for the time-stamps in the capture file) */
+    (void)clock_gettime(CLOCK_REALTIME, &wall);
+    recorder->wallOffset = (int64_t)(((uint64_t)wall.tv_sec * NSEC_PER_SEC) + (uint64_t)wall.tv_nsec) -
+                           (int64_t)LoadMeter_Now();
+    recorder->channel = channel;
+    recorder->device = device;
+    recorder->running = true;
+    if (pthread_create(&recorder->thread, NULL, WriterThread, (void*)recorder) != 0) {
+        recorder->running = false;
+        return CANUSB_ERROR_RESOURCE;
+    }
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t FlightRec_Stop(KvaserUSB_FlightRecorder_t *recorder) {
+    /* sanity check */
+    if (!recorder)
+        return CANUSB_ERROR_NULLPTR;
+    if (!recorder->running)
+        return CANUSB_SUCCESS;
+
+    /* wake up the thread and wait for its termination (a pending capture is written) */
+    (void)pthread_mutex_lock(&recorder->mutex);
+    recorder->running = false;
+    (void)pthread_cond_signal(&recorder->cond);
+    (void)pthread_mutex_unlock(&recorder->mutex);
+    (void)pthread_join(recorder->thread, NULL);
+    return CANUSB_SUCCESS;
+}
+
+void FlightRec_Record(KvaserUSB_FlightRecorder_t *recorder, const KvaserUSB_CanMessage_t *message, uint64_t now) {
+    /* note: to be called from the reception callback (the device time-stamp is replaced) */
+    PutFrame(recorder, message, now);
+}
+
+void FlightRec_RecordSent(KvaserUSB_FlightRecorder_t *recorder, const KvaserUSB_CanMessage_t *message, uint64_t now) {
+    /* note: to be called from the sending threads */
+    PutFrame(recorder, message, now);
+}
+
+void FlightRec_BusStatus(KvaserUSB_FlightRecorder_t *recorder, KvaserUSB_BusStatus_t previous, KvaserUSB_BusStatus_t status) {
+    /* trigger on the transition to bus off */
+    if (recorder && recorder->ring && (recorder->triggers & KVASER_FLIGHT_BUS_OFF) &&
+        (status & BUSSTAT_BUSOFF) && !(previous & BUSSTAT_BUSOFF))
+        (void)FlightRec_Trigger(recorder, KVASER_FLIGHT_BUS_OFF, LoadMeter_Now());
+}
+
+bool FlightRec_Trigger(KvaserUSB_FlightRecorder_t *recorder, uint8_t cause, uint64_t now) {
+    uint32_t state = STATE_ARMED;
+
+    /* sanity check */
+    if (!recorder || !recorder->ring || !recorder->running)
+        return false;
+
+    /* only the first trigger counts until the capture file is written */
+    if (!__atomic_compare_exchange_n(&recorder->state, &state, STATE_FIRING, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return false;
+    recorder->triggerTime = now;
+    recorder->cause = cause;
+    __atomic_store_n(&recorder->state, STATE_TRIGGERED, __ATOMIC_RELEASE);
+
+    /* wake up the writer thread (note: once per capture) */
+    (void)pthread_mutex_lock(&recorder->mutex);
+    (void)pthread_cond_signal(&recorder->cond);
+    (void)pthread_mutex_unlock(&recorder->mutex);
+    return true;
+}
+
+static void PutFrame(KvaserUSB_FlightRecorder_t *recorder, const KvaserUSB_CanMessage_t *message, uint64_t now) {
+    KvaserUSB_FlightSlot_t *slot;
+    uint64_t position;
+
+    assert(recorder);
+    assert(message);
+
+    /* claim a position (note: several producers) */
+    position = __atomic_fetch_add(&recorder->head, 1U, __ATOMIC_RELAXED);
+    slot = &recorder->ring[position & (uint64_t)(recorder->capacity - 1U)];
+
+    /* seqlock per slot: 0 tells the writer thread to skip it */
+    __atomic_store_n(&slot->sequence, 0U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->time = now;
+    memcpy(&slot->message, message, sizeof(KvaserUSB_CanMessage_t));
+    __atomic_store_n(&slot->sequence, position + 1U, __ATOMIC_RELEASE);
+
+    /* trigger conditions (note: the state is only read when armed) */
+    if (recorder->triggers && (__atomic_load_n(&recorder->state, __ATOMIC_RELAXED) == STATE_ARMED)) {
+        if (message->sts && (recorder->triggers & KVASER_FLIGHT_ERROR_FRAME))
+            (void)FlightRec_Trigger(recorder, KVASER_FLIGHT_ERROR_FRAME, now);
+        else if ((recorder->triggers & KVASER_FLIGHT_ID_MATCH) && MatchFrame(&recorder->match, message))
+            (void)FlightRec_Trigger(recorder, KVASER_FLIGHT_ID_MATCH, now);
+    }
+}
+
+static bool MatchFrame(const KvaserUSB_CanMessage_t *pattern, const KvaserUSB_CanMessage_t *message) {
+    uint8_t length;
+
+    /* identifier and format, then the first DLC bytes of the pattern */
+    if ((message->id != pattern->id) || (message->xtd != pattern->xtd) || message->sts)
+        return false;
+    length = dlc2len[pattern->dlc & 0xFU];
+    if (length > dlc2len[message->dlc & 0xFU])
+        return false;
+    return (memcmp(message->data, pattern->data, (size_t)length) == 0) ? true : false;
+}
+
+static int WriteCapture(KvaserUSB_FlightRecorder_t *recorder) {
+    KvaserUSB_FlightSlot_t *slot, *frames, temp;
+    rec_recorder_t capture = NULL;
+    rec_info_t info;
+    char path[KVASER_FLIGHT_PATH_LENGTH+16];
+    uint64_t head, position, sequence, first, last, nsec;
+    uint64_t mask = (uint64_t)(recorder->capacity - 1U);
+    size_t count = 0U, i, j;
+    int rc;
+
+    assert(recorder);
+
+    /* the window around the trigger (host time) */
+    first = recorder->triggerTime - (((uint64_t)recorder->preTime * NSEC_PER_MSEC) < recorder->triggerTime ?
+                                     ((uint64_t)recorder->preTime * NSEC_PER_MSEC) : recorder->triggerTime);
+    last = recorder->triggerTime + ((uint64_t)recorder->postTime * NSEC_PER_MSEC);
+
+    /* copy the complete slots within the window (the producers keep running) */
+    if ((frames = (KvaserUSB_FlightSlot_t*)malloc((size_t)recorder->capacity * sizeof(KvaserUSB_FlightSlot_t))) == NULL)
+        return RECERR_RESOURCE;
+    head = __atomic_load_n(&recorder->head, __ATOMIC_ACQUIRE);
+    position = (head > (uint64_t)recorder->capacity) ? (head - (uint64_t)recorder->capacity) : 0U;
+    for (; position < head; position++) {
+        slot = &recorder->ring[position & mask];
+        sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (sequence != (position + 1U))
+            continue;
+        memcpy(&frames[count], slot, sizeof(KvaserUSB_FlightSlot_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != sequence)
+            continue;
+        if ((frames[count].time >= first) && (frames[count].time <= last))
+            count++;
+    }
+    /* received and sent CAN frames in the order of the host time (note: almost sorted) */
+    for (i = 1U; i < count; i++) {
+        for (j = i; (j > 0U) && (frames[j-1U].time > frames[j].time); j--) {
+            temp = frames[j];
+            frames[j] = frames[j-1U];
+            frames[j-1U] = temp;
+        }
+    }
+    /* one time base: the host time of every CAN frame converted to wall clock time */
+    for (i = 0U; i < count; i++) {
+        nsec = (uint64_t)((int64_t)frames[i].time + recorder->wallOffset);
+        frames[i].message.timestamp.tv_sec = (time_t)(nsec / NSEC_PER_SEC);
+        frames[i].message.timestamp.tv_nsec = (long)(nsec % NSEC_PER_SEC);
+    }
+    /* the capture file '<prefix>-<n>.crec' */
+    memset(&info, 0, sizeof(rec_info_t));
+    info.channel = recorder->channel;
+    if (recorder->device)
+        strncpy(info.device, recorder->device, REC_DEVICE_LENGTH - 1U);
+    (void)snprintf(path, sizeof(path), "%s-%u.crec", recorder->path, recorder->captures + 1U);
+    if ((rc = rec_recorder_create(&capture, path, &info, 0U)) == RECERR_NOERROR) {
+        for (i = 0U; (i < count) && (rc == RECERR_NOERROR); i++)
+            rc = rec_recorder_write(capture, &frames[i].message, 1U);
+        if (rec_recorder_close(capture) != RECERR_NOERROR)
+            rc = RECERR_IO;
+    }
+    if (rc == RECERR_NOERROR)
+        __atomic_add_fetch(&recorder->captures, 1U, __ATOMIC_RELAXED);
+    MACCAN_DEBUG_DRIVER("    Flight recorder: %zu CAN frame(s) written into '%s' (%i)\n", count, path, rc);
+    free(frames);
+    return rc;
+}
+
+static void *WriterThread(void *arg) {
+    KvaserUSB_FlightRecorder_t *recorder = (KvaserUSB_FlightRecorder_t*)arg;
+    struct timespec abstime;
+    uint64_t deadline, now, nsec;
+
+    assert(recorder);
+
+    (void)pthread_mutex_lock(&recorder->mutex);
+    while (recorder->running) {
+        if (__atomic_load_n(&recorder->state, __ATOMIC_ACQUIRE) == STATE_TRIGGERED) {
+            /* wait for the end of the post-trigger window */
+            deadline = recorder->triggerTime + ((uint64_t)recorder->postTime * NSEC_PER_MSEC);
+            now = LoadMeter_Now();
+            if (now < deadline) {
+                (void)clock_gettime(CLOCK_REALTIME, &abstime);
+                nsec = (uint64_t)abstime.tv_nsec + (deadline - now);
+                abstime.tv_sec += (time_t)(nsec / NSEC_PER_SEC);
+                abstime.tv_nsec = (long)(nsec % NSEC_PER_SEC);
+                (void)pthread_cond_timedwait(&recorder->cond, &recorder->mutex, &abstime);
+                continue;
+            }
+            /* freeze the window into a capture file, then arm again */
+            __atomic_store_n(&recorder->state, STATE_WRITING, __ATOMIC_RELAXED);
+            (void)pthread_mutex_unlock(&recorder->mutex);
+            (void)WriteCapture(recorder);
+            __atomic_store_n(&recorder->state, STATE_ARMED, __ATOMIC_RELEASE);
+            (void)pthread_mutex_lock(&recorder->mutex);
+            continue;
+        }
+        (void)pthread_cond_wait(&recorder->cond, &recorder->mutex);
+    }
+    (void)pthread_mutex_unlock(&recorder->mutex);
+
+    /* stopped: a pending capture is written with the post-trigger window so far */
+    if (__atomic_load_n(&recorder->state, __ATOMIC_ACQUIRE) == STATE_TRIGGERED) {
+        (void)WriteCapture(recorder);
+        __atomic_store_n(&recorder->state, STATE_ARMED, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
@@ -0,0 +1,274 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Interfaces
+ *
+ *  Copyright (c) 2020-2022 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "KvaserUSB_InfoCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "MacCAN_Debug.h"
+
+/*  ---  device information cache  ---
+ *
+ *  Card info, software info/details, transceiver info and channel capabilities do not
+ *  change for a given device and firmware version.  The driver reads the card info and
+ *  the software info/details on every open, and takes the rest from the cache when an
+ *  entry with the same product id., serial no., firmware version and channel no. exists.
+ *
+ *  The cache is kept in memory for the lifetime of the process.  When the environment
+ *  variable MACCAN_INFO_CACHE names a file, the cache is loaded from and written to that
+ *  file as well (value "0" or "off" disables the cache).
+ */
+#define CACHE_FILE_MAGIC  0x4349564BU  /* 'K','V','I','C' */
+#define CACHE_FILE_VERSION  1U
+#define CACHE_ENV_VARIABLE  "MACCAN_INFO_CACHE"
+
+#define ENTER_CRITICAL_SECTION()  (void)pthread_mutex_lock(&cache.mutex)
+#define LEAVE_CRITICAL_SECTION()  (void)pthread_mutex_unlock(&cache.mutex)
+
+typedef struct info_entry_tag {             /* Cache entry: */
+    uint16_t productId;                     /*   USB product id. */
+    KvaserUSB_CanChannel_t channelNo;       /*   CAN channel on device */
+    uint8_t valid;                          /*   flag: entry in use */
+    uint32_t serialNumber;                  /*   serial no. */
+    uint32_t firmwareVersion;               /*   firmware version */
+    KvaserUSB_DeviceInfo_t deviceInfo;      /*   device information (cached) */
+} InfoEntry_t;
+
+typedef struct info_file_tag {              /* Cache file header: */
+    uint32_t magic;                         /*   magic number */
+    uint16_t version;                       /*   file format version */
+    uint16_t entrySize;                     /*   size of an entry (in [byte]) */
+    uint32_t count;                         /*   number of entries */
+} InfoFile_t;
+
+typedef struct info_cache_tag {             /* Device information cache: */
+    InfoEntry_t entry[KVASER_INFO_CACHE_SIZE];  /* cache entries */
+    unsigned int next;                      /*   next entry to be replaced */
+    uint64_t hits;                          /*   number of lookups found */
+    uint64_t misses;                        /*   number of lookups not found */
+    bool initialized;                       /*   flag: settings read, file loaded */
+    bool disabled;                          /*   flag: cache disabled */
+    char *fileName;                         /*   cache file (or NULL) */
+    pthread_mutex_t mutex;                  /*   mutex for mutual exclusion */
+} InfoCache_t;
+
+static InfoCache_t cache = {
+    .next = 0U,
+    .hits = 0U,
+    .misses = 0U,
+    .initialized = false,
+    .disabled = false,
+    .fileName = NULL,
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void Initialize(void);
+static void LoadFile(void);
+static void SaveFile(void);
+static InfoEntry_t *FindEntry(const KvaserUSB_Device_t *device, uint32_t serialNumber, uint32_t firmwareVersion);
+
+bool InfoCache_Lookup(const KvaserUSB_Device_t *device, KvaserUSB_DeviceInfo_t *info) {
+    InfoEntry_t *entry = NULL;
+    bool found = false;
+
+    /* sanity check */
+    if (!device || !info)
+        return false;
+
+    /* key: product id., serial no., firmware version and channel no. */
+    ENTER_CRITICAL_SECTION();
+    Initialize();
+    if (!cache.disabled) {
+        entry = FindEntry(device, info->card.serialNumber, info->software.firmwareVersion);
+        if (entry) {
+            *info = entry->deviceInfo;
+            found = true;
+            cache.hits++;
+        } else
+            cache.misses++;
+    }
+    LEAVE_CRITICAL_SECTION();
+    if (found)
+        MACCAN_DEBUG_DRIVER("    Device information of %s #%u taken from cache (serial no. %u)\n", device->name, device->channelNo, info->card.serialNumber);
+    return found;
+}
+
+CANUSB_Return_t InfoCache_Store(const KvaserUSB_Device_t *device, const KvaserUSB_DeviceInfo_t *info) {
+    InfoEntry_t *entry = NULL;
+
+    /* sanity check */
+    if (!device || !info)
+        return CANUSB_ERROR_NULLPTR;
+
+    ENTER_CRITICAL_SECTION();
+    Initialize();
+    if (cache.disabled) {
+        LEAVE_CRITICAL_SECTION();
+        return CANUSB_ERROR_NOTSUPP;
+    }
+    /* update an existing entry or replace the oldest one */
+    entry = FindEntry(device, info->card.serialNumber, info->software.firmwareVersion);
+    if (!entry) {
+        entry = &cache.entry[cache.next];
+        cache.next = (cache.next + 1U) % KVASER_INFO_CACHE_SIZE;
+    }
+    entry->productId = device->productId;
+    entry->channelNo = device->channelNo;
+    entry->serialNumber = info->card.serialNumber;
+    entry->firmwareVersion = info->software.firmwareVersion;
+    entry->deviceInfo = *info;
+    entry->valid = 1U;
+    /* write the cache file (if any) */
+    if (cache.fileName)
+        SaveFile();
+    LEAVE_CRITICAL_SECTION();
+    return CANUSB_SUCCESS;
+}
+
+void InfoCache_Statistics(uint64_t *hits, uint64_t *misses) {
+    /* note: the lookups since the start of the process (a disabled cache is not looked up) */
+    ENTER_CRITICAL_SECTION();
+    if (hits)
+        *hits = cache.hits;
+    if (misses)
+        *misses = cache.misses;
+    LEAVE_CRITICAL_SECTION();
+}
+
+static void Initialize(void) {
+    /* note: the caller holds the mutex */
+    if (cache.initialized)
+        return;
+    cache.initialized = true;
+
+    const char *value = getenv(CACHE_ENV_VARIABLE);
+    if (value && value[0]) {
+        if (!strcmp(value, "0") || !strcmp(value, "off")) {
+            cache.disabled = true;
+        } else if ((cache.fileName = strdup(value)) != NULL) {
+            LoadFile();
+        }
+    }
+}
+
+static void LoadFile(void) {
+    InfoFile_t header;
+    InfoEntry_t entry;
+    FILE *fp = NULL;
+    uint32_t i;
+
+    /* note: the caller holds the mutex */
+    if ((fp = fopen(cache.fileName, "rb")) == NULL)
+        return;  /* not written yet */
+    if ((fread(&header, sizeof(InfoFile_t), 1, fp) != 1) ||
+        (header.magic != CACHE_FILE_MAGIC) ||
+        (header.version != CACHE_FILE_VERSION) ||
+        (header.entrySize != (uint16_t)sizeof(InfoEntry_t))) {
+        MACCAN_DEBUG_ERROR("+++ device information cache: %s ignored (wrong format)\n", cache.fileName);
+        (void)fclose(fp);
+        return;
+    }
+    for (i = 0U; (i < header.count) && (cache.next < KVASER_INFO_CACHE_SIZE); i++) {
+        if (fread(&entry, sizeof(InfoEntry_t), 1, fp) != 1)
+            break;
+        if (entry.valid)
+            cache.entry[cache.next++] = entry;
+    }
+    cache.next %= KVASER_INFO_CACHE_SIZE;
+    (void)fclose(fp);
+}
+
+static void SaveFile(void) {
+    char tmpName[FILENAME_MAX];
+    InfoFile_t header;
+    FILE *fp = NULL;
+    uint32_t i;
+
+    /* note: the caller holds the mutex */
+    if (snprintf(tmpName, FILENAME_MAX, "%s.%u", cache.fileName, (unsigned int)getpid()) >= FILENAME_MAX)
+        return;
+    if ((fp = fopen(tmpName, "wb")) == NULL) {
+        MACCAN_DEBUG_ERROR("+++ device information cache: %s could not be written (%i)\n", cache.fileName, errno);
+        return;
+    }
+    header.magic = CACHE_FILE_MAGIC;
+    header.version = CACHE_FILE_VERSION;
+    header.entrySize = (uint16_t)sizeof(InfoEntry_t);
+    header.count = 0U;
+    for (i = 0U; i < KVASER_INFO_CACHE_SIZE; i++)
+        header.count += cache.entry[i].valid ? 1U : 0U;
+    bool ok = (fwrite(&header, sizeof(InfoFile_t), 1, fp) == 1);
+    for (i = 0U; ok && (i < KVASER_INFO_CACHE_SIZE); i++) {
+        if (cache.entry[i].valid)
+            ok = (fwrite(&cache.entry[i], sizeof(InfoEntry_t), 1, fp) == 1);
+    }
+    /* replace the file atomically (other processes may read it) */
+    if ((fclose(fp) != 0) || !ok || (rename(tmpName, cache.fileName) != 0)) {
+        MACCAN_DEBUG_ERROR("+++ device information cache: %s could not be written (%i)\n", cache.fileName, errno);
+        (void)remove(tmpName);
+    }
+}
+
+static InfoEntry_t *FindEntry(const KvaserUSB_Device_t *device, uint32_t serialNumber, uint32_t firmwareVersion) {
+    unsigned int i;
+
+    /* note: the caller holds the mutex */
+    for (i = 0U; i < KVASER_INFO_CACHE_SIZE; i++) {
+        if (cache.entry[i].valid &&
+            (cache.entry[i].productId == device->productId) &&
+            (cache.entry[i].channelNo == device->channelNo) &&
+            (cache.entry[i].serialNumber == serialNumber) &&
+            (cache.entry[i].firmwareVersion == firmwareVersion))
+            return &cache.entry[i];
+    }
+    return NULL;
+}
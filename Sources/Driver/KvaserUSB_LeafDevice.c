@@ -46,6 +46,9 @@
  *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "KvaserUSB_LeafDevice.h"
+#include "KvaserUSB_InfoCache.h"
+#include "KvaserUSB_LoadMeter.h"
+#include "KvaserUSB_FlightRec.h"
 #include "KvaserCAN_Devices.h"
 
 #include <stdio.h>
@@ -113,7 +116,9 @@
 #define MIN(x,y)  (((x) < (y)) ? (x) : (y))
 
 static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size);
+static uint8_t GetChannelOfCommand(const uint8_t *buffer, uint32_t nbyte, uint8_t requester);
 static bool UpdateEventData(KvaserUSB_EventData_t *event, uint8_t *buffer, uint32_t nbyte, KvaserUSB_Frequency_t frequency);
+static KvaserUSB_BusLoad_t DecodeBusLoad(const uint8_t *buffer);
 static bool DecodeMessage(KvaserUSB_CanMessage_t *message, uint8_t *buffer, uint32_t nbyte, KvaserUSB_Frequency_t frequency);
 
 static uint32_t FillSetBusParamsReq(uint8_t *buffer, uint32_t maxbyte, uint8_t channel, const KvaserUSB_BusParams_t *params);
@@ -149,20 +154,21 @@ bool Leaf_ConfigureChannel(KvaserUSB_Device_t *device) {
         return false;
     if (device->driverType != USB_LEAF_DRIVER)
         return false;
-    if (device->numChannels != LEAF_NUM_CHANNELS)  // TODO: multi-channel devices
+    if ((device->numChannels < 1U) || (device->numChannels > LEAF_NUM_CHANNELS))
+        return false;
+    if (device->channelNo >= device->numChannels)
         return false;
     if (device->endpoints.numEndpoints != LEAF_NUM_ENDPOINTS)
         return false;
 
-    /* set CAN channel properties and defaults */
-    device->channelNo = 0U;  /* note: only one CAN channel */
+    /* set CAN channel properties and defaults (note: channel no. set when opened) */
     device->recvData.canClock = KvaserDEV_GetCanClockInMHz(device->productId);
     device->recvData.timerFreq = KvaserDEV_GetTimerFreqInMHz(device->productId);
     device->recvData.txAck.maxMsg = LEAF_MAX_OUTSTANDING_TX;
 
     /* set CAN channel operation capabilities from device spec. */
     device->opCapability = CANMODE_DEFAULT;  /* note: CAN FD not supported by Leaf devices */
-    //device->opCapability |= CANMODE_SHRD;  /{ not possible with IOUsbKit }/
+    device->opCapability |= CANMODE_SHRD;    /* shared access through a shared memory segment of the owner */
     device->opCapability |= CANMODE_NXTD;    /* suppressing extended frames (software solution) */
     device->opCapability |= CANMODE_NRTR;    /* suppressing remote frames (software solution) */
     device->opCapability |= CANMODE_ERR;     /* status frames are always enabled / error frames only with SJA1000 */
@@ -211,7 +217,7 @@ CANUSB_Return_t Leaf_InitializeChannel(KvaserUSB_Device_t *device, const KvaserU
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): chip state event could not be triggered (%i)\n", device->name, device->handle, retVal);
         goto err_init;
     }
-    /* get device information: card, software, interface, transceiver */
+    /* get device information: card, software, transceiver, capabilities (cached) */
     retVal = Leaf_GetCardInfo(device, &device->deviceInfo.card);
     if (retVal < 0) {
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): card information could not be read (%i)\n", device->name, device->handle, retVal);
@@ -222,18 +228,23 @@ CANUSB_Return_t Leaf_InitializeChannel(KvaserUSB_Device_t *device, const KvaserU
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): firmware information could not be read (%i)\n", device->name, device->handle, retVal);
         goto err_init;
     }
-    retVal = Leaf_GetTransceiverInfo(device, &device->deviceInfo.transceiver);
-    if (retVal < 0) {
-        MACCAN_DEBUG_ERROR("+++ %s (device #%u): transceiver information could not be read (%i)\n", device->name, device->handle, retVal);
-        goto err_init;
-    }
-    /* get device capabilities (if supported) */
-    if (device->deviceInfo.software.swOptions & SWOPTION_CAP_REQ) {
-        retVal = Leaf_GetCapabilities(device, &device->deviceInfo.capabilities);
+    /* the rest is known when the device (serial no. and firmware version) is in the cache */
+    if (!InfoCache_Lookup(device, &device->deviceInfo)) {
+        retVal = Leaf_GetTransceiverInfo(device, &device->deviceInfo.transceiver);
         if (retVal < 0) {
-            MACCAN_DEBUG_ERROR("+++ %s (device #%u): channel capabilities could not be read (%i)\n", device->name, device->handle, retVal);
+            MACCAN_DEBUG_ERROR("+++ %s (device #%u): transceiver information could not be read (%i)\n", device->name, device->handle, retVal);
             goto err_init;
         }
+        /* get device capabilities (if supported) */
+        if (device->deviceInfo.software.swOptions & SWOPTION_CAP_REQ) {
+            retVal = Leaf_GetCapabilities(device, &device->deviceInfo.capabilities);
+            if (retVal < 0) {
+                MACCAN_DEBUG_ERROR("+++ %s (device #%u): channel capabilities could not be read (%i)\n", device->name, device->handle, retVal);
+                goto err_init;
+            }
+        }
+        /* remember them for the next time */
+        (void)InfoCache_Store(device, &device->deviceInfo);
     }
 #if (OPTION_PRINT_DEVICE_INFO != 0)
     MACCAN_DEBUG_DRIVER(">>> %s (device #%u): properties and capabilities\n", device->name, device->handle);
@@ -322,11 +333,11 @@ CANUSB_Return_t Leaf_TeardownChannel(KvaserUSB_Device_t *device) {
     }
     /* now we are off :( */
     MACCAN_DEBUG_DRIVER("    Diagnostic data:\n");
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) written to endpoint\n", device->sendData.msgCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" error(s) while writing to endpoint\n", device->sendData.errCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) received and enqueued\n", device->recvData.msgCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" error frame(s) received and encoded\n", device->recvData.stsCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" error event(s) received and recorded\n", device->recvData.errCounter);
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) written to endpoint\n", __atomic_load_n(&device->sendData.msgCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" error(s) while writing to endpoint\n", __atomic_load_n(&device->sendData.errCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) received and enqueued\n", __atomic_load_n(&device->recvData.msgCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" error frame(s) received and encoded\n", __atomic_load_n(&device->recvData.stsCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" error event(s) received and recorded\n", __atomic_load_n(&device->recvData.errCounter, __ATOMIC_RELAXED));
     MACCAN_DEBUG_DRIVER("%10.1f%% highest level of the receive queue\n", ((float)CANQUE_QueueHigh(device->recvData.msgQueue) * 100.0) \
                                                                        /  (float)CANQUE_QueueSize(device->recvData.msgQueue));
     MACCAN_DEBUG_DRIVER("%8"PRIu64" overrun event(s) of the receive queue\n", CANQUE_OverflowCounter(device->recvData.msgQueue));
@@ -651,9 +662,70 @@ CANUSB_Return_t Leaf_SendMessage(KvaserUSB_Device_t *device, const KvaserUSB_Can
     }
     /* counting */
     if (retVal == CANUSB_SUCCESS)
-        device->sendData.msgCounter++;
+        (void)__atomic_fetch_add(&device->sendData.msgCounter, 1U, __ATOMIC_RELAXED);
+    else
+        (void)__atomic_fetch_add(&device->sendData.errCounter, 1U, __ATOMIC_RELAXED);
+    return retVal;
+}
+
+CANUSB_Return_t Leaf_SendMessages(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *messages, uint32_t count) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint8_t buffer[KVASER_MAX_TX_BATCH * KVASER_MAX_COMMAND_LENGTH];
+    uint32_t packetSize, offset = 0U;
+    uint32_t i;
+
+    /* sanity check */
+    if (!device || !messages)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if ((count < 1U) || (count > KVASER_MAX_TX_BATCH))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* suppress certain CAN messages depending on the operation mode (all or nothing) */
+    for (i = 0U; i < count; i++) {
+        if (messages[i].xtd && (device->recvData.opMode & CANMODE_NXTD))
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].rtr && (device->recvData.opMode & CANMODE_NRTR))
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].sts)  /* note: error frames cannot be sent */
+            return CANUSB_ERROR_ILLPARA;
+    }
+    /* check for pending transmit messages (room for all of them) */
+    if ((device->recvData.txAck.cntMsg + count) > device->recvData.txAck.maxMsg)
+        return CANUSB_ERROR_BUSY;
+
+    /* channel no. and USB packet size (a command must not cross a packet boundary) */
+    uint8_t channel = device->channelNo;
+    packetSize = device->endpoints.bulkOut.packetSize ? device->endpoints.bulkOut.packetSize : 64U;
+
+    /* send requests CMD_TX_{STD|EXT}_MESSAGE w/o acknowledge in one bulk transfer
+     * note: a command length of zero tells the firmware to continue with the
+     *       next packet, so the remainder of a packet is filled up with zeros
+     */
+    bzero(buffer, sizeof(buffer));
+    for (i = 0U; i < count; i++) {
+        if (((offset % packetSize) + LEN_TX_STD_MESSAGE) > packetSize)
+            offset += packetSize - (offset % packetSize);
+        if ((offset + LEN_TX_STD_MESSAGE) > sizeof(buffer))
+            break;
+        device->recvData.txAck.transId = (device->recvData.txAck.transId + 1U) % device->recvData.txAck.maxMsg;
+        offset += FillTxCanMessageReq(&buffer[offset], LEN_TX_STD_MESSAGE, channel, device->recvData.txAck.transId, &messages[i]);
+    }
+    if (i < count)  /* note: not with an endpoint size of 20 bytes or more */
+        return CANUSB_ERROR_RESOURCE;
+    retVal = KvaserUSB_SendRequest(device, buffer, offset);
+    if (retVal == CANUSB_SUCCESS) {
+        /* skip the responses in the callback routine */
+        device->recvData.txAck.noAck = true;
+        /* some more transmit messages pending */
+        device->recvData.txAck.cntMsg += count;
+    }
+    /* counting */
+    if (retVal == CANUSB_SUCCESS)
+        (void)__atomic_fetch_add(&device->sendData.msgCounter, (uint64_t)count, __ATOMIC_RELAXED);
     else
-        device->sendData.errCounter++;
+        (void)__atomic_fetch_add(&device->sendData.errCounter, 1U, __ATOMIC_RELAXED);
     return retVal;
 }
 
@@ -668,6 +740,8 @@ CANUSB_Return_t Leaf_ReadMessage(KvaserUSB_Device_t *device, KvaserUSB_CanMessag
 
     /* read one CAN message from message queue, if any */
     retVal = CANQUE_Dequeue(device->recvData.msgQueue, (void*)message, timeout);
+    if (retVal == CANUSB_SUCCESS)
+        MACCAN_TRACE(CANTRC_MSG_DEQUEUED, message->id, KVASER_TRACE_TIME(message->timestamp));
 
     return retVal;
 }
@@ -760,6 +834,9 @@ CANUSB_Return_t Leaf_ReadClock(KvaserUSB_Device_t *device, uint64_t *nsec) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_READ_CLOCK_REQ and wait for response */
     bzero(buffer, KVASER_MAX_COMMAND_LENGTH);
     size = FillReadClockReq(buffer, KVASER_MAX_COMMAND_LENGTH, 0x00U); // note: READ_CLOCK_NOW is not supported
@@ -785,6 +862,7 @@ CANUSB_Return_t Leaf_ReadClock(KvaserUSB_Device_t *device, uint64_t *nsec) {
             *nsec = KvaserUSB_NanosecondsFromTicks(ticks, device->recvData.timerFreq);
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -816,23 +894,30 @@ CANUSB_Return_t Leaf_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t
              * - byte 12+13: number of samples where tx or rx was active
              * - byte 14+15: milliseconds since last response
              */
-            uint64_t interval = (uint64_t)BUF2UINT16(buffer[10]);
-            uint64_t samples = (uint64_t)BUF2UINT16(buffer[12]);
-            uint64_t delta_t = (uint64_t)BUF2UINT16(buffer[14]);
-            if (delta_t != 0U) {
-                uint64_t zwerg = (samples * interval * 10ULL) / delta_t;
-                /* 0..10000 is equivalent 0.00%..100.00% */
-                if (zwerg > 10000ULL)
-                    zwerg = 10000ULL;
-                *load = (KvaserUSB_BusLoad_t)zwerg;
-            }
-            else
-                *load = (KvaserUSB_BusLoad_t)0;
+            *load = DecodeBusLoad(buffer);
         }
     }
     return retVal;
 }
 
+CANUSB_Return_t Leaf_RequestBusLoad(KvaserUSB_Device_t *device) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint8_t buffer[KVASER_MAX_COMMAND_LENGTH];
+    uint32_t size;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* send request CMD_GET_BUSLOAD_REQ w/o response (the sampler takes it) */
+    bzero(buffer, KVASER_MAX_COMMAND_LENGTH);
+    size = FillGetBusLoadReq(buffer, KVASER_MAX_COMMAND_LENGTH, device->channelNo);
+    retVal = KvaserUSB_SendRequest(device, buffer, size);
+    return retVal;
+}
+
 CANUSB_Return_t Leaf_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInfo_t *info/*, uint8_t dataLevel*/) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
     uint8_t buffer[KVASER_MAX_COMMAND_LENGTH];
@@ -845,6 +930,9 @@ CANUSB_Return_t Leaf_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInfo_
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_CARD_INFO_REQ and wait for response */
     bzero(buffer, KVASER_MAX_COMMAND_LENGTH);
     size = FillGetCardInfoReq(buffer, KVASER_MAX_COMMAND_LENGTH, 0U/*dataLevel*/);
@@ -889,6 +977,7 @@ CANUSB_Return_t Leaf_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInfo_
             info->canTimeStampRef = BUF2UINT8(buffer[31]);
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -904,6 +993,9 @@ CANUSB_Return_t Leaf_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_Softw
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_SOFTWARE_INFO_REQ and wait for response */
     bzero(buffer, KVASER_MAX_COMMAND_LENGTH);
     size = FillGetSoftwareInfoReq(buffer, KVASER_MAX_COMMAND_LENGTH);
@@ -926,6 +1018,7 @@ CANUSB_Return_t Leaf_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_Softw
             info->maxBitrate = 1000000U;  // CAN 2.0 max. 1Mbit/s
        }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -944,6 +1037,9 @@ CANUSB_Return_t Leaf_GetInterfaceInfo(KvaserUSB_Device_t *device, KvaserUSB_Inte
 
     /* note: this command seem not to work on the Leaf Light v2 device!
      */
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_INTERFACE_INFO_REQ and wait for response */
     bzero(buffer, KVASER_MAX_COMMAND_LENGTH);
     size = FillGetInterfaceInfoReq(buffer, KVASER_MAX_COMMAND_LENGTH, device->channelNo);
@@ -965,6 +1061,7 @@ CANUSB_Return_t Leaf_GetInterfaceInfo(KvaserUSB_Device_t *device, KvaserUSB_Inte
             info->canChipSubType = BUF2UINT8(buffer[9]);
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 #endif
@@ -1005,6 +1102,9 @@ CANUSB_Return_t Leaf_GetCapabilities(KvaserUSB_Device_t *device, KvaserUSB_Capab
         CAP_SUB_CMD_HAS_REMOTE,
         CAP_SUB_CMD_HAS_SCRIPT
     };
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_CAPABILITIES_REQ w/ sub-command and wait for response */
     for (int i = 0; i < 9; i++) {
         bzero(buffer, KVASER_MAX_COMMAND_LENGTH);
@@ -1047,6 +1147,7 @@ CANUSB_Return_t Leaf_GetCapabilities(KvaserUSB_Device_t *device, KvaserUSB_Capab
             }
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -1087,10 +1188,13 @@ CANUSB_Return_t Leaf_GetTransceiverInfo(KvaserUSB_Device_t *device, KvaserUSB_Tr
 }
 
 static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
-    KvaserUSB_RecvData_t *context = (KvaserUSB_RecvData_t*)refCon;
+    KvaserUSB_UsbReader_t *reader = (KvaserUSB_UsbReader_t*)refCon;
+    KvaserUSB_RecvData_t *context = NULL;
     KvaserUSB_CanMessage_t message;
+    uint64_t now = LoadMeter_Now();  /* note: one time for all CAN frames of the transfer */
     UInt32 index = 0U;
     UInt32 nbyte;
+    UInt8 channel;
 
     assert(refCon);
     assert(buffer);
@@ -1101,16 +1205,34 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
      * - byte 2: transaction id.
      * - byte 3...
      */
+    KvaserUSB_BeginUrb(reader);
+    MACCAN_TRACE(CANTRC_URB_RECEIVED, size, CANTRC_Word(buffer, size));
     if (size >= KVASER_MIN_COMMAND_LENGTH) {
         /* the "command/message pump" */
         while (index < size) {
             /* get the command length */
             nbyte = (UInt32)buffer[index];
-            MACCAN_LOG_WRITE(&buffer[index], nbyte, index ? "+" : "<");
             if ((index + nbyte) > size) {
                 MACCAN_LOG_PRINTF("! URB error: expected=%lu vs. received=%lu\n", (index + nbyte), size);
+                MACCAN_TRACE(CANTRC_URB_ERROR, size, index);
+                reader->counters.errors += 1U;
+                break;
+            }
+            if (nbyte < KVASER_MIN_COMMAND_LENGTH) {
+                MACCAN_LOG_PRINTF("! URB error: command length=%lu\n", nbyte);
+                MACCAN_TRACE(CANTRC_URB_ERROR, size, index);
+                reader->counters.errors += 1U;
                 break;
             }
+            reader->counters.bytes += nbyte;
+            MACCAN_TRACE(CANTRC_CMD_DECODED, nbyte, CANTRC_Word(&buffer[index], nbyte));
+            /* demultiplex by channel no. (device-level commands to the requester) */
+            channel = GetChannelOfCommand(&buffer[index], nbyte, reader->requester);
+            if ((context = KvaserUSB_GetRecvData(reader, channel)) == NULL) {
+                /* CAN channel not attached: skip the command */
+                index += nbyte;
+                continue;
+            }
             /* interpret the command code */
             switch (buffer[index+1]) {
                 case CMD_RX_STD_MESSAGE:
@@ -1122,8 +1244,18 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                 case CMD_ERROR_EVENT:
                 case CMD_CAN_ERROR_EVENT:
                     /* event message: update event status */
-                    (void)UpdateEventData(&context->evData, &buffer[index], nbyte, context->timerFreq);
-                    context->errCounter++;
+                    if (UpdateEventData(&context->evData, &buffer[index], nbyte, context->timerFreq))
+                        KvaserUSB_UpdateEventQueue(context, buffer[index+1]);
+                    KvaserUSB_UpdateBusStatus(context, context->evData.chipState.busStatus);
+                    /* note: chip states polled by the sampler are not counted as events */
+                    if ((buffer[index+1] != CMD_CHIP_STATE_EVENT) || !KvaserUSB_PolledChipState(context))
+                        (void)__atomic_fetch_add(&context->errCounter, 1U, __ATOMIC_RELAXED);
+                    break;
+                case CMD_GET_BUSLOAD_RESP:
+                    /* bus load: update the snapshot, write packet into the pipe only when requested */
+                    KvaserUSB_UpdateBusLoad(context, DecodeBusLoad(&buffer[index]));
+                    if (!context->busSample.active)
+                        (void)CANPIP_Write(context->msgPipe, &buffer[index], nbyte);
                     break;
                 case CMD_GET_BUSPARAMS_RESP:
                 case CMD_GET_DRIVERMODE_RESP:
@@ -1133,7 +1265,6 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                 case CMD_GET_CARD_INFO_RESP:
                 case CMD_GET_INTERFACE_INFO_RESP:
                 case CMD_GET_SOFTWARE_INFO_RESP:
-                case CMD_GET_BUSLOAD_RESP:
                 case CMD_FILO_FLUSH_QUEUE_RESP:
                 case CMD_GET_CAPABILITIES_RESP:
                 case CMD_GET_TRANSCEIVER_INFO_RESP:
@@ -1143,6 +1274,18 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                 case CMD_LOG_MESSAGE:
                     /* logged CAN message: decode and enqueue */
                     if (DecodeMessage(&message, &buffer[index], nbyte, context->timerFreq)) {
+                        /* bus load meter: account the CAN frame (before any suppression) */
+                        if (!message.sts)
+                            LoadMeter_Account(&context->loadMeter, &message, now);
+                        /* shared access: publish all CAN messages for the clients (unfiltered) */
+                        if (context->sharedMem)
+                            (void)CANSHM_Publish(context->sharedMem, (void*)&message);
+                        /* flight recorder: copy all CAN messages into the ring (unfiltered) */
+                        if (context->flightRec.ring)
+                            FlightRec_Record(&context->flightRec, &message, now);
+                        /* overrun flag: CAN frames were lost in the device before this one */
+                        if (context->gapMarkers && (BUF2UINT8(buffer[index+3]) & MSGFLAG_OVERRUN))
+                            KvaserUSB_DeviceGapMarker(context, &message.timestamp);
                         /* suppress certain CAN messages depending on the operation mode */
                         if (message.xtd && (context->opMode & CANMODE_NXTD))
                             break;
@@ -1151,11 +1294,13 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                         if (message.sts && !(context->opMode & CANMODE_ERR))
                             break;
                         if (CANQUE_Enqueue(context->msgQueue, (void*)&message) == CANUSB_SUCCESS) {
+                            MACCAN_TRACE(CANTRC_MSG_ENQUEUED, message.id, KVASER_TRACE_TIME(message.timestamp));
                             if (!message.sts)
-                                context->msgCounter++;
+                                (void)__atomic_fetch_add(&context->msgCounter, 1U, __ATOMIC_RELAXED);
                             else
-                                context->stsCounter++;
-                        }
+                                (void)__atomic_fetch_add(&context->stsCounter, 1U, __ATOMIC_RELAXED);
+                        } else
+                            MACCAN_TRACE(CANTRC_MSG_DROPPED, message.id, KVASER_TRACE_TIME(message.timestamp));
                     } else {
                         /* there are flags that do not belong to a received CAN message */
                         (void)UpdateEventData(&context->evData, &buffer[index], nbyte, context->timerFreq);
@@ -1167,9 +1312,11 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                         (void)CANPIP_Write(context->msgPipe, &buffer[index], nbyte);
                     if (context->txAck.cntMsg > 0)
                         context->txAck.cntMsg--;
+                    MACCAN_TRACE(CANTRC_TX_ACK, buffer[index+3], context->txAck.cntMsg);
                     break;
                 default:
                     /* ignore the rest */
+                    reader->counters.unknown += 1U;
                     break;
             }
             /* next command */
@@ -1177,8 +1324,59 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
         }
     } else {
         /* something went wrong on the USB line */
-        MACCAN_LOG_WRITE(buffer, size, "?");
+        MACCAN_TRACE(CANTRC_URB_ERROR, size, 0U);
+        reader->counters.errors += 1U;
+    }
+    KvaserUSB_EndUrb(reader);
+}
+
+static uint8_t GetChannelOfCommand(const uint8_t *buffer, uint32_t nbyte, uint8_t requester) {
+    assert(buffer);
+
+    /* Kvaser USB command:
+     * - byte 0: command length
+     * - byte 1: command code
+     * - byte 2: transaction id. or channel
+     * - byte 3: channel or variable field
+     */
+    switch (buffer[1]) {
+        case CMD_LOG_MESSAGE:
+        case CMD_TX_ACKNOWLEDGE:
+            /* channel in byte 2 */
+            return buffer[2];
+        case CMD_CAN_ERROR_EVENT:
+            /* channel in byte 10 */
+            return (nbyte > 10U) ? buffer[10] : requester;
+        case CMD_ERROR_EVENT:
+        case CMD_READ_CLOCK_RESP:
+        case CMD_GET_CARD_INFO_RESP:
+        case CMD_GET_SOFTWARE_INFO_RESP:
+        case CMD_GET_CAPABILITIES_RESP:
+            /* device-level: no channel */
+            return requester;
+        default:
+            /* channel in byte 3 */
+            return buffer[3];
+    }
+}
+
+static KvaserUSB_BusLoad_t DecodeBusLoad(const uint8_t *buffer) {
+    /* - byte 10+11: sampling interval (in [usec])
+     * - byte 12+13: number of samples where tx or rx was active
+     * - byte 14+15: milliseconds since last response
+     */
+    uint64_t interval = (uint64_t)BUF2UINT16(buffer[10]);
+    uint64_t samples = (uint64_t)BUF2UINT16(buffer[12]);
+    uint64_t delta_t = (uint64_t)BUF2UINT16(buffer[14]);
+    uint64_t zwerg = 0ULL;
+
+    if (delta_t != 0U) {
+        zwerg = (samples * interval * 10ULL) / delta_t;
+        /* 0..10000 is equivalent 0.00%..100.00% */
+        if (zwerg > 10000ULL)
+            zwerg = 10000ULL;
     }
+    return (KvaserUSB_BusLoad_t)zwerg;
 }
 
 static bool UpdateEventData(KvaserUSB_EventData_t *event, uint8_t *buffer, uint32_t nbyte, KvaserUSB_Frequency_t frequency) {
@@ -1328,10 +1526,12 @@ static bool DecodeMessage(KvaserUSB_CanMessage_t *message, uint8_t *buffer, uint
     ticks |= (uint64_t)BUF2UINT16(buffer[8]) << 32;
     KvaserUSB_TimestampFromTicks(&message->timestamp, ticks, frequency);
     /* note: we only enqueue ordinary CAN messages and error frames.
-     *       The flags MSGFLAG_OVERRUN, MSGFLAG_NERR, MSGFLAG_WAKEUP,
-     *       MSGFLAG_TX and MSGFLAG_TXRQ are handled by UpdateEventData
+     *       The flags MSGFLAG_NERR, MSGFLAG_WAKEUP, MSGFLAG_TX and
+     *       MSGFLAG_TXRQ are handled by UpdateEventData.  The flag
+     *       MSGFLAG_OVERRUN belongs to a valid CAN message (the lost
+     *       ones were before), it is handled by the reception callback
      */
-    if (!(BUF2UINT8(buffer[3]) & ~(MSGFLAG_REMOTE_FRAME | MSGFLAG_ERROR_FRAME)))
+    if (!(BUF2UINT8(buffer[3]) & ~(MSGFLAG_REMOTE_FRAME | MSGFLAG_ERROR_FRAME | MSGFLAG_OVERRUN)))
         result = true;
     return result;
 }
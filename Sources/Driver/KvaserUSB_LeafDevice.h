@@ -51,7 +51,7 @@
 #include "KvaserUSB_Common.h"
 #include "KvaserUSB_Device.h"
 
-#define LEAF_NUM_CHANNELS  1U
+#define LEAF_NUM_CHANNELS  2U  /* max. number of CAN channels */
 #define LEAF_NUM_ENDPOINTS  2U
 #define LEAF_CPU_FREQUENCY  24U
 #define LEAF_MAX_OUTSTANDING_TX  64U
@@ -78,6 +78,7 @@ extern CANUSB_Return_t Leaf_ResetCard(KvaserUSB_Device_t *device, uint16_t delay
 extern CANUSB_Return_t Leaf_RequestChipState(KvaserUSB_Device_t *device, uint16_t delay);
 
 extern CANUSB_Return_t Leaf_SendMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t Leaf_SendMessages(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *messages, uint32_t count);
 extern CANUSB_Return_t Leaf_ReadMessage(KvaserUSB_Device_t *device, KvaserUSB_CanMessage_t *message, uint16_t timeout);
 
 extern CANUSB_Return_t Leaf_FlushQueue(KvaserUSB_Device_t *device/*, uint8_t flags*/);
@@ -86,6 +87,7 @@ extern CANUSB_Return_t Leaf_ResetStatistics(KvaserUSB_Device_t *device, uint16_t
 
 extern CANUSB_Return_t Leaf_ReadClock(KvaserUSB_Device_t *device, uint64_t *nsec);
 extern CANUSB_Return_t Leaf_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load);
+extern CANUSB_Return_t Leaf_RequestBusLoad(KvaserUSB_Device_t *device);
 
 extern CANUSB_Return_t Leaf_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInfo_t *info/*, uint8_t dataLevel*/);
 extern CANUSB_Return_t Leaf_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_SoftwareInfo_t *info);
@@ -0,0 +1,373 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Interfaces
+ *
+ *  Copyright (c) 2020-2022 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "KvaserUSB_LoadMeter.h"
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/*  ---  bus load meter  ---
+ *
+ *  The bus load is computed on the host from the CAN frames received (and sent) on a CAN
+ *  channel.  The on-wire length of a frame is calculated from SOF to the end of intermission:
+ *  stuff bits are counted over the actual bit stream (SOF to the end of the data field, and
+ *  for CAN 2.0 including the CRC sequence), for CAN FD the stuff count and the fixed stuff
+ *  bits of the CRC field are added.  With bit-rate switching the data phase (ESI to the end
+ *  of the CRC field) is timed with the data bit-rate, the rest with the nominal bit-rate.
+ *
+ *  The bus busy time is integrated into KVASER_LOAD_BUCKETS buckets of KVASER_LOAD_BUCKET_TIME
+ *  nanoseconds.  The bus load is the busy time of the current and the preceding buckets
+ *  divided by the time they cover (sliding window).  Every bucket is one 64-bit word (the
+ *  bucket number and the busy time), so the reception callback and the sending thread can
+ *  update it with a compare-and-swap, and the reader does not lock at all.
+ *
+ *  Note: error frames, overload frames and CAN frames not seen by the device are not counted.
+ */
+#define FRAME_TRAILER_BITS  13U  /* CRC delimiter, ACK slot and delimiter, EOF (7), IFS (3) */
+#define CRC17_FIELD_BITS  (4U + 17U + 6U)  /* stuff count, CRC-17 and fixed stuff bits */
+#define CRC21_FIELD_BITS  (4U + 21U + 7U)  /* stuff count, CRC-21 and fixed stuff bits */
+#define CRC15_POLYNOMIAL  0x4599U
+#define MAX_STREAM_BYTES  72U  /* 553 bits (CAN FD, extended, 64 bytes) */
+
+#define BUCKET_BUSY_BITS  40U  /* busy time in [ps], max. 1.09s */
+#define BUCKET_BUSY_MASK  ((1ULL << BUCKET_BUSY_BITS) - 1ULL)
+#define BUCKET_EPOCH_MASK  ((1ULL << (64U - BUCKET_BUSY_BITS)) - 1ULL)
+#define BUCKET_EPOCH(word)  ((word) >> BUCKET_BUSY_BITS)
+#define BUCKET_BUSY(word)  ((word) & BUCKET_BUSY_MASK)
+
+#define STUFF_STATE(bit,run)  (uint8_t)(((bit) << 2) | ((run) - 1U))
+#define STUFF_ENTRY(count,state)  (uint8_t)(((count) << 4) | (state))
+
+typedef struct bit_stream_tag {             /* Bit stream (MSB first): */
+    uint8_t byte[MAX_STREAM_BYTES];         /*   the bits */
+    uint32_t length;                        /*   number of bits */
+} BitStream_t;
+
+static const uint8_t dlc2len[16] = { 0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64 };
+
+static uint8_t stuffTable[8][256];          /* stuff bits (high nibble) and next state (low nibble) */
+static uint16_t crc15Table[256];            /* CRC-15 of CAN 2.0 (byte-wise) */
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+static void InitTables(void);
+static uint8_t StuffStep(uint8_t state, uint8_t bit, uint32_t *count);
+static uint32_t CountStuffBits(const BitStream_t *stream, uint32_t first, uint32_t last, uint8_t *state);
+static uint16_t CalcCrc15(const BitStream_t *stream);
+static void PutBits(BitStream_t *stream, uint32_t value, uint32_t nbits);
+static void PutBytes(BitStream_t *stream, const uint8_t *data, uint32_t nbytes);
+
+void LoadMeter_Configure(KvaserUSB_LoadMeter_t *meter, const KvaserUSB_BusParamsFd_t *params) {
+    uint64_t nominal = 0ULL, data = 0ULL;
+
+    /* sanity check */
+    if (!meter || !params)
+        return;
+
+    /* bit times in [ps] (0 = not configured) */
+    if (params->nominal.bitRate > 0U)
+        nominal = 1000000000000ULL / (uint64_t)params->nominal.bitRate;
+    if (params->canFd && (params->data.bitRate > 0U))
+        data = 1000000000000ULL / (uint64_t)params->data.bitRate;
+    meter->nominalTime = (nominal <= UINT32_MAX) ? (uint32_t)nominal : 0U;
+    meter->dataTime = ((data > 0ULL) && (data <= UINT32_MAX)) ? (uint32_t)data : meter->nominalTime;
+
+    (void)pthread_once(&tablesOnce, InitTables);
+}
+
+void LoadMeter_Restart(KvaserUSB_LoadMeter_t *meter, uint64_t now) {
+    uint32_t i;
+
+    /* sanity check */
+    if (!meter)
+        return;
+
+    /* clear all buckets (note: not concurrently with LoadMeter_Account) */
+    for (i = 0U; i < KVASER_LOAD_BUCKETS; i++)
+        __atomic_store_n(&meter->bucket[i], 0ULL, __ATOMIC_RELAXED);
+    __atomic_store_n(&meter->startTime, now, __ATOMIC_RELEASE);
+}
+
+void LoadMeter_Account(KvaserUSB_LoadMeter_t *meter, const KvaserUSB_CanMessage_t *message, uint64_t now) {
+    uint32_t nominalBits = 0U, dataBits = 0U;
+    uint64_t epoch, busy, old, word;
+    uint64_t *bucket;
+
+    /* sanity check */
+    if (!meter || !message || !meter->nominalTime || message->sts)
+        return;
+
+    /* on-wire time of the CAN frame in [ps] */
+    LoadMeter_FrameBits(message, &nominalBits, &dataBits);
+    busy = ((uint64_t)nominalBits * (uint64_t)meter->nominalTime) + ((uint64_t)dataBits * (uint64_t)meter->dataTime);
+
+    /* add it to the current bucket, or start the bucket anew when it is stale */
+    epoch = now / (uint64_t)KVASER_LOAD_BUCKET_TIME;
+    bucket = &meter->bucket[epoch % KVASER_LOAD_BUCKETS];
+    old = __atomic_load_n(bucket, __ATOMIC_RELAXED);
+    do {
+        if (BUCKET_EPOCH(old) == (epoch & BUCKET_EPOCH_MASK))
+            word = old + ((BUCKET_BUSY(old) + busy <= BUCKET_BUSY_MASK) ? busy : (BUCKET_BUSY_MASK - BUCKET_BUSY(old)));
+        else
+            word = ((epoch & BUCKET_EPOCH_MASK) << BUCKET_BUSY_BITS) | ((busy <= BUCKET_BUSY_MASK) ? busy : BUCKET_BUSY_MASK);
+    } while (!__atomic_compare_exchange_n(bucket, &old, word, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+KvaserUSB_BusLoad_t LoadMeter_BusLoad(const KvaserUSB_LoadMeter_t *meter, uint64_t now) {
+    uint64_t epoch, word, busy = 0ULL, window, start;
+    uint64_t load;
+    uint32_t i;
+
+    /* sanity check */
+    if (!meter || !meter->nominalTime)
+        return (KvaserUSB_BusLoad_t)0;
+
+    /* sum up the busy time of the current and the preceding buckets */
+    epoch = now / (uint64_t)KVASER_LOAD_BUCKET_TIME;
+    for (i = 0U; (i < KVASER_LOAD_BUCKETS) && (i <= epoch); i++) {
+        word = __atomic_load_n(&meter->bucket[(epoch - i) % KVASER_LOAD_BUCKETS], __ATOMIC_ACQUIRE);
+        if (BUCKET_EPOCH(word) == ((epoch - i) & BUCKET_EPOCH_MASK))
+            busy += BUCKET_BUSY(word);
+    }
+    /* the time covered by the buckets (but not before the restart) in [ns] */
+    window = ((uint64_t)(KVASER_LOAD_BUCKETS - 1U) * (uint64_t)KVASER_LOAD_BUCKET_TIME) +
+             (now - (epoch * (uint64_t)KVASER_LOAD_BUCKET_TIME));
+    start = __atomic_load_n(&meter->startTime, __ATOMIC_ACQUIRE);
+    if ((now >= start) && ((now - start) < window))
+        window = now - start;
+    if (window == 0ULL)
+        return (KvaserUSB_BusLoad_t)0;
+
+    /* 0..10000 is equivalent 0.00%..100.00% (note: busy in [ps], window in [ns]) */
+    load = (busy * 10ULL) / window;
+    if (load > 10000ULL)
+        load = 10000ULL;
+    return (KvaserUSB_BusLoad_t)load;
+}
+
+void LoadMeter_FrameBits(const KvaserUSB_CanMessage_t *message, uint32_t *nominalBits, uint32_t *dataBits) {
+    BitStream_t stream;
+    uint32_t arbitration, length;
+    uint32_t stuffBits = 0U, brsBits = 0U;
+    uint8_t state = STUFF_STATE(1U, 1U);  /* note: the bus is idle (recessive) before SOF */
+
+    /* sanity check */
+    if (!message)
+        return;
+    (void)pthread_once(&tablesOnce, InitTables);
+
+    /* SOF and arbitration field (11-bit identifier, or 29-bit identifier with SRR and IDE) */
+    memset(stream.byte, 0, MAX_STREAM_BYTES);
+    stream.length = 0U;
+    PutBits(&stream, 0U, 1U);
+    if (!message->xtd) {
+        PutBits(&stream, (uint32_t)message->id & 0x7FFU, 11U);
+    } else {
+        PutBits(&stream, ((uint32_t)message->id >> 18) & 0x7FFU, 11U);
+        PutBits(&stream, 0x3U, 2U);
+        PutBits(&stream, (uint32_t)message->id & 0x3FFFFU, 18U);
+    }
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if (message->fdf) {
+        /* CAN FD: RRS, (IDE,) FDF, res, BRS | ESI, DLC, data field */
+        PutBits(&stream, 0x2U, message->xtd ? 3U : 4U);  /* note: only FDF is recessive */
+        PutBits(&stream, message->brs ? 1U : 0U, 1U);
+        arbitration = stream.length;
+        PutBits(&stream, message->esi ? 1U : 0U, 1U);
+        PutBits(&stream, (uint32_t)message->dlc & 0xFU, 4U);
+        length = (uint32_t)dlc2len[message->dlc & 0xFU];
+        PutBytes(&stream, message->data, length);
+
+        /* dynamic stuff bits: a stuff bit after BRS is already sent with the data bit-rate */
+        stuffBits = CountStuffBits(&stream, 0U, arbitration - 1U, &state);
+        state = StuffStep(state, (stream.byte[(arbitration - 1U) >> 3] >> (7U - ((arbitration - 1U) & 7U))) & 1U, &brsBits);
+        if (message->brs) {
+            if (nominalBits)
+                *nominalBits = arbitration + stuffBits + FRAME_TRAILER_BITS;
+            stuffBits = brsBits + CountStuffBits(&stream, arbitration, stream.length, &state);
+            if (dataBits)
+                *dataBits = (stream.length - arbitration) + stuffBits + ((length <= 16U) ? CRC17_FIELD_BITS : CRC21_FIELD_BITS);
+        } else {
+            stuffBits += brsBits + CountStuffBits(&stream, arbitration, stream.length, &state);
+            if (nominalBits)
+                *nominalBits = stream.length + stuffBits + ((length <= 16U) ? CRC17_FIELD_BITS : CRC21_FIELD_BITS) + FRAME_TRAILER_BITS;
+            if (dataBits)
+                *dataBits = 0U;
+        }
+        return;
+    }
+#endif
+    /* CAN 2.0: RTR, IDE, r0 (or RTR, r1, r0), DLC, data field, CRC sequence */
+    PutBits(&stream, message->rtr ? 1U : 0U, 1U);
+    PutBits(&stream, 0x0U, 2U);
+    PutBits(&stream, (uint32_t)message->dlc & 0xFU, 4U);
+    length = message->rtr ? 0U : ((message->dlc < 8U) ? (uint32_t)message->dlc : 8U);
+    PutBytes(&stream, message->data, length);
+    PutBits(&stream, (uint32_t)CalcCrc15(&stream), 15U);
+
+    /* dynamic stuff bits from SOF to the end of the CRC sequence */
+    stuffBits = CountStuffBits(&stream, 0U, stream.length, &state);
+    if (nominalBits)
+        *nominalBits = stream.length + stuffBits + FRAME_TRAILER_BITS;
+    if (dataBits)
+        *dataBits = 0U;
+}
+
+uint64_t LoadMeter_Now(void) {
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void InitTables(void) {
+    uint32_t count;
+    uint16_t crc;
+    uint8_t state;
+    int s, b, i;
+
+    /* stuff bits and next state for each state (last bit, run length 1..4) and each byte */
+    for (s = 0; s < 8; s++) {
+        for (b = 0; b < 256; b++) {
+            count = 0U;
+            state = (uint8_t)s;
+            for (i = 7; i >= 0; i--)
+                state = StuffStep(state, (uint8_t)((b >> i) & 1), &count);
+            stuffTable[s][b] = STUFF_ENTRY(count, state);
+        }
+    }
+    /* CRC-15 of CAN 2.0 (x^15 + x^14 + x^10 + x^8 + x^7 + x^4 + x^3 + 1) for each byte */
+    for (b = 0; b < 256; b++) {
+        crc = (uint16_t)(b << 7);
+        for (i = 0; i < 8; i++)
+            crc = (crc & 0x4000U) ? (uint16_t)(((crc << 1) ^ CRC15_POLYNOMIAL) & 0x7FFFU) : (uint16_t)((crc << 1) & 0x7FFFU);
+        crc15Table[b] = crc;
+    }
+}
+
+static uint8_t StuffStep(uint8_t state, uint8_t bit, uint32_t *count) {
+    uint8_t last = (state >> 2) & 1U;
+    uint8_t run = (state & 3U) + 1U;
+
+    /* after five consecutive bits of equal value a complementary bit is inserted */
+    if (bit == last) {
+        if (++run == 5U) {
+            *count += 1U;
+            return STUFF_STATE(bit ^ 1U, 1U);
+        }
+        return STUFF_STATE(bit, run);
+    }
+    return STUFF_STATE(bit, 1U);
+}
+
+static uint32_t CountStuffBits(const BitStream_t *stream, uint32_t first, uint32_t last, uint8_t *state) {
+    const uint8_t *byte = stream->byte;
+    uint32_t count = 0U;
+    uint32_t i = first;
+    uint8_t current = *state;
+    uint8_t entry;
+
+    /* bit-wise up to the next byte boundary, then byte-wise by table, then the remaining bits */
+    for (; (i < last) && (i & 7U); i++)
+        current = StuffStep(current, (byte[i >> 3] >> (7U - (i & 7U))) & 1U, &count);
+    for (; (i + 8U) <= last; i += 8U) {
+        entry = stuffTable[current][byte[i >> 3]];
+        count += (uint32_t)(entry >> 4);
+        current = entry & 0x0FU;
+    }
+    for (; i < last; i++)
+        current = StuffStep(current, (byte[i >> 3] >> (7U - (i & 7U))) & 1U, &count);
+    *state = current;
+    return count;
+}
+
+static uint16_t CalcCrc15(const BitStream_t *stream) {
+    uint16_t crc = 0x0000U;
+    uint32_t i;
+    uint8_t bit;
+
+    /* byte-wise by table, then the remaining bits */
+    for (i = 0U; (i + 8U) <= stream->length; i += 8U)
+        crc = (uint16_t)(((crc << 8) & 0x7FFFU) ^ crc15Table[((crc >> 7) ^ stream->byte[i >> 3]) & 0xFFU]);
+    for (; i < stream->length; i++) {
+        bit = (stream->byte[i >> 3] >> (7U - (i & 7U))) & 1U;
+        crc = (uint16_t)((crc << 1) & 0x7FFFU) ^ ((bit ^ ((crc >> 14) & 1U)) ? CRC15_POLYNOMIAL : 0x0000U);
+    }
+    return crc;
+}
+
+static void PutBits(BitStream_t *stream, uint32_t value, uint32_t nbits) {
+    uint32_t length = stream->length;
+    uint32_t count;
+
+    /* note: the stream is zero-initialized, the bits are or'ed in up to a byte at once */
+    while (nbits > 0U) {
+        count = 8U - (length & 7U);
+        if (count > nbits)
+            count = nbits;
+        nbits -= count;
+        stream->byte[length >> 3] |= (uint8_t)(((value >> nbits) & ((1U << count) - 1U)) << (8U - (length & 7U) - count));
+        length += count;
+    }
+    stream->length = length;
+}
+
+static void PutBytes(BitStream_t *stream, const uint8_t *data, uint32_t nbytes) {
+    uint32_t shift = stream->length & 7U;
+    uint8_t *byte = &stream->byte[stream->length >> 3];
+    uint32_t i;
+
+    /* note: the stream is zero-initialized, the bytes are or'ed in at any bit position */
+    if (shift) {
+        for (i = 0U; i < nbytes; i++) {
+            byte[i] |= (uint8_t)(data[i] >> shift);
+            byte[i + 1U] = (uint8_t)(data[i] << (8U - shift));
+        }
+    } else
+        memcpy(byte, data, (size_t)nbytes);
+    stream->length += nbytes * 8U;
+}
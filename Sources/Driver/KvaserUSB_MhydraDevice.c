@@ -46,6 +46,9 @@
  *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "KvaserUSB_MhydraDevice.h"
+#include "KvaserUSB_InfoCache.h"
+#include "KvaserUSB_LoadMeter.h"
+#include "KvaserUSB_FlightRec.h"
 #include "KvaserCAN_Devices.h"
 
 #include <stdio.h>
@@ -81,16 +84,38 @@
 
 #define SET_DST(x,dst)  (((x)&0xC0U) | ((dst)&0x3FU))
 #define SET_SEQ(x,seq)  (((x)&0xF000U) | ((seq)&0xFFFU))
+#define SRC_HE(buf)  ((((buf)[1]&0xC0U) >> 2) | (((buf)[3]&0xF0U) >> 4))
+#define GET_SEQ(buf)  ((((uint16_t)(buf)[3]&0x0FU) << 8) | (uint16_t)(buf)[2])
+
+#define HYDRA_PIPELINE_SEQ  0x800U
+#define HYDRA_MAX_PIPELINED  16U
 
 #define MIN(x,y)  (((x) < (y)) ? (x) : (y))
 
+typedef struct hydra_request_tag {          /* Pipelined request: */
+    uint8_t buffer[HYDRA_CMD_SIZE];         /*   request, replaced by the response */
+    uint8_t cmdCode;                        /*   expected response code */
+    bool pending;                           /*   response outstanding */
+    CANUSB_Return_t result;                 /*   result of the transaction */
+} HydraRequest_t;
+
 static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size);
 static bool UpdateEventData(KvaserUSB_EventData_t *event, uint8_t *buffer, uint32_t nbyte, KvaserUSB_Frequency_t frequency);
+static KvaserUSB_BusLoad_t DecodeBusLoad(const uint8_t *buffer);
 static bool DecodeMessage(KvaserUSB_CanMessage_t *message, uint8_t *buffer, uint32_t nbyte, KvaserUSB_Frequency_t frequency);
 
 static CANUSB_Return_t MapChannel(KvaserUSB_Device_t *device);
 static CANUSB_Return_t SendRequest(KvaserUSB_Device_t *device, const uint8_t *buffer, uint32_t nbyte);
 static CANUSB_Return_t ReadResponse(KvaserUSB_Device_t *device, uint8_t *buffer, uint32_t nbyte, uint8_t cmdCode, /*uint8_t transId,*/ uint16_t timeout);
+static CANUSB_Return_t SendRequests(KvaserUSB_Device_t *device, HydraRequest_t *requests, uint32_t count, uint16_t timeout);
+static CANUSB_Return_t MapErrorCode(uint8_t errorCode);
+
+static CANUSB_Return_t GetDeviceInfo(KvaserUSB_Device_t *device, KvaserUSB_DeviceInfo_t *info);
+static void DecodeCardInfo(uint8_t *buffer, KvaserUSB_CardInfo_t *info);
+static void DecodeSoftwareDetails(uint8_t *buffer, KvaserUSB_SoftwareInfo_t *info);
+static void DecodeSoftwareInfo(uint8_t *buffer, KvaserUSB_SoftwareInfo_t *info);
+static void DecodeTransceiverInfo(uint8_t *buffer, KvaserUSB_TransceiverInfo_t *info);
+static void DecodeCapability(uint8_t *buffer, uint8_t channelNo, KvaserUSB_Capabilities_t *capabilities);
 
 static uint32_t FillMapChannelReq(uint8_t *buffer, uint32_t maxbyte, uint8_t channel);
 static uint32_t FillMapChannelSysDbgReq(uint8_t *buffer, uint32_t maxbyte);
@@ -134,13 +159,14 @@ bool Mhydra_ConfigureChannel(KvaserUSB_Device_t *device) {
         return false;
     if (device->driverType != USB_MHYDRA_DRIVER)
         return false;
-    if (device->numChannels != MHYDRA_NUM_CHANNELS)  // TODO: multi-channel devices
+    if ((device->numChannels < 1U) || (device->numChannels > MHYDRA_NUM_CHANNELS))
+        return false;
+    if (device->channelNo >= device->numChannels)
         return false;
     if (device->endpoints.numEndpoints != MHYDRA_NUM_ENDPOINTS)
         return false;
 
-    /* set CAN channel properties and defaults */
-    device->channelNo = 0U;  /* note: only one CAN channel */
+    /* set CAN channel properties and defaults (note: channel no. set when opened) */
     device->recvData.canClock = KvaserDEV_GetCanClockInMHz(device->productId);
     device->recvData.timerFreq = KvaserDEV_GetTimerFreqInMHz(device->productId);
     device->recvData.txAck.maxMsg = MHYDRA_MAX_OUTSTANDING_TX;
@@ -150,7 +176,7 @@ bool Mhydra_ConfigureChannel(KvaserUSB_Device_t *device) {
     device->opCapability |= KvaserDEV_IsCanFdSupported(device->productId) ? CANMODE_FDOE : 0x00U;
     device->opCapability |= KvaserDEV_IsCanFdSupported(device->productId) ? CANMODE_BRSE : 0x00U;
     // TODO: device->opCapability |= KvaserDEV_IsNonIsoCanFdSupported(device->productId) ? CANMODE_NISO : 0x00U;
-    //device->opCapability |= CANMODE_SHRD;  /{ not possible with IOUsbKit }/
+    device->opCapability |= CANMODE_SHRD;    /* shared access through a shared memory segment of the owner */
     device->opCapability |= CANMODE_NXTD;    /* suppressing extended frames (software solution) */
     device->opCapability |= CANMODE_NRTR;    /* suppressing remote frames (software solution) */
     device->opCapability |= CANMODE_ERR;     /* status frames are always enabled / error frames only with SJA1000 */
@@ -209,30 +235,12 @@ CANUSB_Return_t Mhydra_InitializeChannel(KvaserUSB_Device_t *device, const Kvase
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): chip state event could not be triggered (%i)\n", device->name, device->handle, retVal);
         goto err_init;
     }
-    /* get device information: card, software, interface, transceiver */
-    retVal = Mhydra_GetCardInfo(device, &device->deviceInfo.card);
-    if (retVal < 0) {
-        MACCAN_DEBUG_ERROR("+++ %s (device #%u): card information could not be read (%i)\n", device->name, device->handle, retVal);
-        goto err_init;
-    }
-    retVal = Mhydra_GetSoftwareInfo(device, &device->deviceInfo.software);
+    /* get device information: card, software, transceiver, capabilities (cached) */
+    retVal = GetDeviceInfo(device, &device->deviceInfo);
     if (retVal < 0) {
-        MACCAN_DEBUG_ERROR("+++ %s (device #%u): firmware information could not be read (%i)\n", device->name, device->handle, retVal);
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): device information could not be read (%i)\n", device->name, device->handle, retVal);
         goto err_init;
     }
-    retVal = Mhydra_GetTransceiverInfo(device, &device->deviceInfo.transceiver);
-    if (retVal < 0) {
-        MACCAN_DEBUG_ERROR("+++ %s (device #%u): transceiver information could not be read (%i)\n", device->name, device->handle, retVal);
-        goto err_init;
-    }
-    /* get device capabilities (if supported) */
-    if (device->deviceInfo.software.swOptions & SWOPTION_CAP_REQ) {
-        retVal = Mhydra_GetCapabilities(device, &device->deviceInfo.capabilities);
-        if (retVal < 0) {
-            MACCAN_DEBUG_ERROR("+++ %s (device #%u): channel capabilities could not be read (%i)\n", device->name, device->handle, retVal);
-            goto err_init;
-        }
-    }
 #if (OPTION_PRINT_DEVICE_INFO != 0)
     MACCAN_DEBUG_DRIVER(">>> %s (device #%u): properties and capabilities\n", device->name, device->handle);
     PrintDeviceInfo(&device->deviceInfo);  /* note: only for debugging purposes */
@@ -321,11 +329,11 @@ CANUSB_Return_t Mhydra_TeardownChannel(KvaserUSB_Device_t *device) {
     }
     /* now we are off :( */
     MACCAN_DEBUG_DRIVER("    Diagnostic data:\n");
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) written to endpoint\n", device->sendData.msgCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" error(s) while writing to endpoint\n", device->sendData.errCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) received and enqueued\n", device->recvData.msgCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" error frame(s) received and encoded\n", device->recvData.stsCounter);
-    MACCAN_DEBUG_DRIVER("%8"PRIu64" error event(s) received and recorded\n", device->recvData.errCounter);
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) written to endpoint\n", __atomic_load_n(&device->sendData.msgCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" error(s) while writing to endpoint\n", __atomic_load_n(&device->sendData.errCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) received and enqueued\n", __atomic_load_n(&device->recvData.msgCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" error frame(s) received and encoded\n", __atomic_load_n(&device->recvData.stsCounter, __ATOMIC_RELAXED));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" error event(s) received and recorded\n", __atomic_load_n(&device->recvData.errCounter, __ATOMIC_RELAXED));
     MACCAN_DEBUG_DRIVER("%10.1f%% highest level of the receive queue\n", ((float)CANQUE_QueueHigh(device->recvData.msgQueue) * 100.0) \
                                                                        /  (float)CANQUE_QueueSize(device->recvData.msgQueue));
     MACCAN_DEBUG_DRIVER("%8"PRIu64" overrun event(s) of the receive queue\n", CANQUE_OverflowCounter(device->recvData.msgQueue));
@@ -966,9 +974,67 @@ CANUSB_Return_t Mhydra_SendMessage(KvaserUSB_Device_t *device, const KvaserUSB_C
     }
     /* counting */
     if (retVal == CANUSB_SUCCESS)
-        device->sendData.msgCounter++;
+        (void)__atomic_fetch_add(&device->sendData.msgCounter, 1U, __ATOMIC_RELAXED);
     else
-        device->sendData.errCounter++;
+        (void)__atomic_fetch_add(&device->sendData.errCounter, 1U, __ATOMIC_RELAXED);
+    return retVal;
+}
+
+CANUSB_Return_t Mhydra_SendMessages(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *messages, uint32_t count) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint8_t buffer[KVASER_MAX_TX_BATCH * HYDRA_CMD_EXT_SIZE];
+    uint32_t offset = 0U;
+    uint32_t i;
+
+    /* sanity check */
+    if (!device || !messages)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if ((count < 1U) || (count > KVASER_MAX_TX_BATCH))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* refuse certain CAN messages depending on the operation mode (all or nothing) */
+    for (i = 0U; i < count; i++) {
+        if (messages[i].xtd && (device->recvData.opMode & CANMODE_NXTD))
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].rtr && (device->recvData.opMode & CANMODE_NRTR))
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].fdf && !(device->recvData.opMode & CANMODE_FDOE))
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].brs && !(device->recvData.opMode & CANMODE_BRSE))
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].brs && !messages[i].fdf)
+            return CANUSB_ERROR_ILLPARA;
+        if (messages[i].sts)  /* note: error frames cannot be sent */
+            return CANUSB_ERROR_ILLPARA;
+    }
+    /* check for pending transmit messages (room for all of them) */
+    if ((device->recvData.txAck.cntMsg + count) > device->recvData.txAck.maxMsg)
+        return CANUSB_ERROR_BUSY;
+
+    /* channel no. */
+    uint8_t channel = device->hydraData.channel2he;
+
+    /* send requests CMD_EXTENDED[CMD_TX_CAN_MESSAGE_FD] w/o acknowledge in one bulk transfer
+     * note: the commands carry their length (32 or 96 bytes), so they are simply concatenated
+     */
+    for (i = 0U; i < count; i++) {
+        device->recvData.txAck.transId = (device->recvData.txAck.transId + 1U) % device->recvData.txAck.maxMsg;
+        offset += FillTxCanMessageReq(&buffer[offset], HYDRA_CMD_EXT_SIZE, channel, device->recvData.txAck.transId, &messages[i]);
+    }
+    retVal = SendRequest(device, buffer, offset);
+    if (retVal == CANUSB_SUCCESS) {
+        /* skip the responses in the callback routine */
+        device->recvData.txAck.noAck = true;
+        /* some more transmit messages pending */
+        device->recvData.txAck.cntMsg += count;
+    }
+    /* counting */
+    if (retVal == CANUSB_SUCCESS)
+        (void)__atomic_fetch_add(&device->sendData.msgCounter, (uint64_t)count, __ATOMIC_RELAXED);
+    else
+        (void)__atomic_fetch_add(&device->sendData.errCounter, 1U, __ATOMIC_RELAXED);
     return retVal;
 }
 
@@ -983,6 +1049,8 @@ CANUSB_Return_t Mhydra_ReadMessage(KvaserUSB_Device_t *device, KvaserUSB_CanMess
 
     /* read one CAN message from message queue, if any */
     retVal = CANQUE_Dequeue(device->recvData.msgQueue, (void*)message, timeout);
+    if (retVal == CANUSB_SUCCESS)
+        MACCAN_TRACE(CANTRC_MSG_DEQUEUED, message->id, KVASER_TRACE_TIME(message->timestamp));
 
     return retVal;
 }
@@ -1077,6 +1145,9 @@ CANUSB_Return_t Mhydra_ReadClock(KvaserUSB_Device_t *device, uint64_t *nsec) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_READ_CLOCK_REQ and wait for response */
     bzero(buffer, HYDRA_CMD_SIZE);
     size = FillReadClockReq(buffer, HYDRA_CMD_SIZE, 0x00U);  // TODO: flags
@@ -1104,6 +1175,7 @@ CANUSB_Return_t Mhydra_ReadClock(KvaserUSB_Device_t *device, uint64_t *nsec) {
             *nsec = KvaserUSB_NanosecondsFromTicks(ticks, device->recvData.timerFreq);
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -1138,23 +1210,30 @@ CANUSB_Return_t Mhydra_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_
              * - byte 14+15: milliseconds since last response
              * - byte 16..31: (not used)
              */
-            uint64_t interval = (uint64_t)BUF2UINT16(buffer[10]);
-            uint64_t samples = (uint64_t)BUF2UINT16(buffer[12]);
-            uint64_t delta_t = (uint64_t)BUF2UINT16(buffer[14]);
-            if (delta_t != 0U) {
-                uint64_t zwerg = (samples * interval * 10ULL) / delta_t;
-                /* 0..10000 is equivalent 0.00%..100.00% */
-                if (zwerg > 10000ULL)
-                    zwerg = 10000ULL;
-                *load = (KvaserUSB_BusLoad_t)zwerg;
-            }
-            else
-                *load = (KvaserUSB_BusLoad_t)0;
+            *load = DecodeBusLoad(buffer);
         }
     }
     return retVal;
 }
 
+CANUSB_Return_t Mhydra_RequestBusLoad(KvaserUSB_Device_t *device) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint8_t buffer[HYDRA_CMD_SIZE];
+    uint32_t size;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* send request CMD_GET_BUSLOAD_REQ w/o response (the sampler takes it) */
+    bzero(buffer, HYDRA_CMD_SIZE);
+    size = FillGetBusLoadReq(buffer, HYDRA_CMD_SIZE, device->hydraData.channel2he);
+    retVal = SendRequest(device, buffer, size);
+    return retVal;
+}
+
 CANUSB_Return_t Mhydra_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInfo_t *info/*, int8_t dataLevel*/) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
     uint8_t buffer[HYDRA_CMD_SIZE];
@@ -1167,6 +1246,9 @@ CANUSB_Return_t Mhydra_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInf
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_CARD_INFO_REQ and wait for response */
     bzero(buffer, HYDRA_CMD_SIZE);
     size = FillGetCardInfoReq(buffer, HYDRA_CMD_SIZE, /*dataLevel*/0);
@@ -1176,39 +1258,10 @@ CANUSB_Return_t Mhydra_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInf
         resp = CMD_GET_CARD_INFO_RESP;
         retVal = ReadResponse(device, buffer, size, resp, HYDRA_CMD_RESP_TIMEOUT);
         if (retVal == CANUSB_SUCCESS) {
-            /* command response:
-             * - byte 0: command code
-             * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
-             * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
-             * - byte 4..7: serialNumber
-             * - byte 8..11: clockResolution
-             * - byte 12..15: mfgDate
-             * - byte 16..23: EAN[8]
-             * - byte 24: hwRevision
-             * - byte 25: usbHsMode
-             * - byte 26: hwType
-             * - byte 27: canTimeStampRef
-             * - byte 28: channelCount
-             * - byte 29..31: (not used)
-             */
-            info->serialNumber = BUF2UINT32(buffer[4]);
-            info->clockResolution = BUF2UINT32(buffer[8]);
-            info->mfgDate = BUF2UINT32(buffer[12]);
-            info->EAN[0] = BUF2UINT8(buffer[16]);
-            info->EAN[1] = BUF2UINT8(buffer[17]);
-            info->EAN[2] = BUF2UINT8(buffer[28]);
-            info->EAN[3] = BUF2UINT8(buffer[29]);
-            info->EAN[4] = BUF2UINT8(buffer[20]);
-            info->EAN[5] = BUF2UINT8(buffer[21]);
-            info->EAN[6] = BUF2UINT8(buffer[22]);
-            info->EAN[7] = BUF2UINT8(buffer[23]);
-            info->hwRevision = BUF2UINT8(buffer[24]);
-            info->usbHsMode = BUF2UINT8(buffer[25]);
-            info->hwType = BUF2UINT8(buffer[26]);
-            info->canTimeStampRef = BUF2UINT8(buffer[27]);
-            info->channelCount = BUF2UINT8(buffer[28]);
+            DecodeCardInfo(buffer, info);
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -1224,6 +1277,9 @@ CANUSB_Return_t Mhydra_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_Sof
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_SOFTWARE_DETAILS_REQ and wait for response */
     bzero(buffer, HYDRA_CMD_SIZE);
     size = FillGetSoftwareDetailsReq(buffer, HYDRA_CMD_SIZE, /*hydraExt*/1);
@@ -1233,29 +1289,7 @@ CANUSB_Return_t Mhydra_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_Sof
         resp = CMD_GET_SOFTWARE_DETAILS_RESP;
         retVal = ReadResponse(device, buffer, size, resp, HYDRA_CMD_RESP_TIMEOUT);
         if (retVal == CANUSB_SUCCESS) {
-            /* command response:
-             * - byte 0: command code
-             * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
-             * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
-             * - byte 4..7: swOptions
-             * - byte 8..11: swVersion
-             * - byte 12..15: swName
-             * - byte 16..23: EAN code (LSB first)
-             * - byte 24..27: maxBitrate
-             * - byte 28..31: (not used)
-             */
-            info->swOptions = BUF2UINT32(buffer[4]);
-            info->firmwareVersion = BUF2UINT32(buffer[8]);
-            info->swName = BUF2UINT32(buffer[12]);
-            info->EAN[0] = BUF2UINT8(buffer[16]);
-            info->EAN[1] = BUF2UINT8(buffer[17]);
-            info->EAN[2] = BUF2UINT8(buffer[18]);
-            info->EAN[3] = BUF2UINT8(buffer[19]);
-            info->EAN[4] = BUF2UINT8(buffer[20]);
-            info->EAN[5] = BUF2UINT8(buffer[21]);
-            info->EAN[6] = BUF2UINT8(buffer[22]);
-            info->EAN[7] = BUF2UINT8(buffer[23]);
-            info->maxBitrate = BUF2UINT32(buffer[24]);
+            DecodeSoftwareDetails(buffer, info);
 
             /* send request CMD_GET_SOFTWARE_INFO_REQ and wait for response */
             bzero(buffer, HYDRA_CMD_SIZE);
@@ -1266,20 +1300,12 @@ CANUSB_Return_t Mhydra_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_Sof
                 resp = CMD_GET_SOFTWARE_INFO_RESP;
                 retVal = ReadResponse(device, buffer, size, resp, HYDRA_CMD_RESP_TIMEOUT);
                 if (retVal == CANUSB_SUCCESS) {
-                    /* command response:
-                     * - byte 0: command code
-                     * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
-                     * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
-                     * - byte 4..7: (reserved)
-                     * - byte 8..11: (reserved)
-                     * - byte 12..13: maxOutstandingTx
-                     * - byte 14..31: (not used)
-                     */
-                    info->maxOutstandingTx = BUF2UINT16(buffer[12]);
+                    DecodeSoftwareInfo(buffer, info);
                 }
             }
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -1298,6 +1324,9 @@ CANUSB_Return_t Mhydra_GetInterfaceInfo(KvaserUSB_Device_t *device, KvaserUSB_In
 
     /* note: this command seem not to work on the Leaf Pro HS v2 device!
      */
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_GET_INTERFACE_INFO_REQ and wait for response */
     bzero(buffer, HYDRA_CMD_SIZE);
     size = FillGetInterfaceInfoReq(buffer, HYDRA_CMD_SIZE);
@@ -1319,15 +1348,13 @@ CANUSB_Return_t Mhydra_GetInterfaceInfo(KvaserUSB_Device_t *device, KvaserUSB_In
             info->canChipSubType = BUF2UINT8(buffer[9]);
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 #endif
 
 CANUSB_Return_t Mhydra_GetCapabilities(KvaserUSB_Device_t *device, KvaserUSB_Capabilities_t *capabilities) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
-    uint8_t buffer[HYDRA_CMD_SIZE];
-    uint32_t size;
-    uint8_t resp;
 
     /* sanity check */
     if (!device || !capabilities)
@@ -1369,50 +1396,19 @@ CANUSB_Return_t Mhydra_GetCapabilities(KvaserUSB_Device_t *device, KvaserUSB_Cap
         CAP_SUB_CMD_HAS_IO_API,
         CAP_SUB_CMD_HAS_BUSPARAMS_TQ
     };
-    /* send request CMD_GET_CAPABILITIES_REQ w/ sub-command and wait for response */
+    /* send request CMD_GET_CAPABILITIES_REQ w/ sub-command for all sub-commands back-to-back */
+    HydraRequest_t requests[14];
     for (int i = 0; i < 14; i++) {
-        bzero(buffer, HYDRA_CMD_SIZE);
-        size = FillGetCapabilitiesReq(buffer, HYDRA_CMD_SIZE, device->hydraData.sysdbg_he, subCmds[i]);
-        retVal = SendRequest(device, buffer, size);
-        if (retVal == CANUSB_SUCCESS) {
-            size = HYDRA_CMD_SIZE;
-            resp = CMD_GET_CAPABILITIES_RESP;
-            retVal = ReadResponse(device, buffer, size, resp, HYDRA_CMD_RESP_TIMEOUT);
-            if (retVal == CANUSB_SUCCESS) {
-                /* command response:
-                 * - byte 0..3: (header)
-                 * - byte 4..5: sub-command
-                 * - byte 6..7: status (0=OK, 1=NOT_IMPLEMENTED, 2=UNAVAILABLE)
-                 * - byte 8..31: depend on sub-command
-                 *   for mask & value responses:
-                 * - byte 8..11: mask (bit 0 = CAN1, bit 1 = CAN2, etc.)
-                 * - byte 12..15: value (bit 0 = CAN1, bit 1 = CAN2, etc.)
-                 */
-                uint16_t status = BUF2UINT16(buffer[6]);
-                uint32_t mask = BUF2UINT32(buffer[8]);
-                uint32_t value = BUF2UINT32(buffer[12]);
-                uint32_t channel = (uint32_t)0x1U << device->channelNo;
-                if (status == 0) {
-                    switch (subCmds[i]) {
-                        case CAP_SUB_CMD_SILENT_MODE: capabilities->silentMode = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_ERRFRAME: capabilities->errorGen = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_BUS_STATS: capabilities->busStats = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_ERRCOUNT_READ: capabilities->errorCount = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_SINGLE_SHOT: capabilities->singleShot = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_SYNC_TX_FLUSH: capabilities->syncTxFlush= ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_HAS_LOGGER: capabilities->hasLogger = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_HAS_REMOTE: capabilities->hasRemote = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_HAS_SCRIPT: capabilities->hasScript = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_LIN_HYBRID: capabilities->linHybrid = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_KDI_INFO: capabilities->kdiInfo = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_HAS_KDI: capabilities->hasKdi = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_HAS_IO_API: capabilities->hasIoApi = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        case CAP_SUB_CMD_HAS_BUSPARAMS_TQ: capabilities->hasTimeQuanta = ((mask & channel) && (value & channel)) ? 1 : 0; break;
-                        default: /* nothing to do here */ break;
-                    }
-                }
-                // TODO: decode other stuff if needed (i.e. loggerType, hwStatus, remoteInfo etc.)
-            }
+        (void)FillGetCapabilitiesReq(requests[i].buffer, HYDRA_CMD_SIZE, device->hydraData.sysdbg_he, subCmds[i]);
+        requests[i].cmdCode = CMD_GET_CAPABILITIES_RESP;
+    }
+    /* and collect the responses by transaction id. */
+    retVal = SendRequests(device, requests, 14U, HYDRA_CMD_RESP_TIMEOUT);
+    if (retVal == CANUSB_SUCCESS) {
+        for (int i = 0; i < 14; i++) {
+            /* note: an error event means the sub-command is not supported */
+            if (requests[i].result == CANUSB_SUCCESS)
+                DecodeCapability(requests[i].buffer, device->channelNo, capabilities);
         }
     }
     return retVal;
@@ -1439,28 +1435,20 @@ CANUSB_Return_t Mhydra_GetTransceiverInfo(KvaserUSB_Device_t *device, KvaserUSB_
         resp = CMD_GET_TRANSCEIVER_INFO_RESP;
         retVal = ReadResponse(device, buffer, size, resp, HYDRA_CMD_RESP_TIMEOUT);
         if (retVal == CANUSB_SUCCESS) {
-            /* command response:
-             * - byte 0: command code
-             * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
-             * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
-             * - byte 4..7: transceiver capabilities
-             * - byte 8: transceiver status
-             * - byte 9: transceiver type
-             * - byte 10..31: (not used)
-             */
-            info->transceiverCapabilities = BUF2UINT32(buffer[4]);
-            info->transceiverStatus = BUF2UINT8(buffer[8]);
-            info->transceiverType = BUF2UINT8(buffer[9]);
+            DecodeTransceiverInfo(buffer, info);
         }
     }
     return retVal;
 }
 
 static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
-    KvaserUSB_RecvData_t *context = (KvaserUSB_RecvData_t*)refCon;
+    KvaserUSB_UsbReader_t *reader = (KvaserUSB_UsbReader_t*)refCon;
+    KvaserUSB_RecvData_t *context = NULL;
     KvaserUSB_CanMessage_t message;
+    uint64_t now = LoadMeter_Now();  /* note: one time for all CAN frames of the transfer */
     UInt32 index = 0U;
     UInt32 nbyte;
+    UInt8 channel;
 
     assert(refCon);
     assert(buffer);
@@ -1468,8 +1456,22 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
     /* note: Hydra devices sometimes split a response into two URB packets.
      *       We store the remainder of the first one in a retention buffer.
      */
-    KvaserUSB_HydraBuffer_t *hydra = &context->hydraBuf;
-    memcpy(&hydra->buffer[hydra->length], buffer, (size_t)size);  // TODO: array boundaries
+    KvaserUSB_HydraBuffer_t *hydra = &reader->hydraBuf;
+    KvaserUSB_BeginUrb(reader);
+    MACCAN_TRACE(CANTRC_URB_RECEIVED, size, CANTRC_Word(buffer, size));
+    if ((hydra->length + size) > KVASER_HYDRA_RETENTION_SIZE) {
+        MACCAN_LOG_PRINTF("! retention buffer overflow: %lu + %lu bytes\n", hydra->length, size);
+        MACCAN_TRACE(CANTRC_URB_ERROR, size, hydra->length);
+        reader->counters.errors += 1U;
+        hydra->length = 0U;
+        if (size > KVASER_HYDRA_RETENTION_SIZE) {
+            KvaserUSB_EndUrb(reader);
+            return;
+        }
+    }
+    if (hydra->length > 0U)  /* the remainder of a split command */
+        reader->counters.splits += 1U;
+    memcpy(&hydra->buffer[hydra->length], buffer, (size_t)size);
     hydra->length += size;
 
     /* Hydra USB response:
@@ -1487,26 +1489,55 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
             /* get the command length */
             if (hydra->buffer[index] != CMD_EXTENDED)
                 nbyte = (UInt32)HYDRA_CMD_SIZE;
-            else
-                nbyte = (UInt32)BUF2UINT16(hydra->buffer[4]);
+            else if ((index + 6U) <= hydra->length)
+                nbyte = (UInt32)BUF2UINT16(hydra->buffer[index+4]);
+            else  /* note: the length itself is not received yet */
+                nbyte = (UInt32)HYDRA_CMD_EXT_SIZE;
+            if (nbyte < HYDRA_CMD_SIZE) {
+                /* corrupted command length: discard the rest of the buffer */
+                MACCAN_LOG_PRINTF("! URB error: command length=%lu\n", nbyte);
+                MACCAN_TRACE(CANTRC_URB_ERROR, hydra->length, index);
+                reader->counters.errors += 1U;
+                index = hydra->length;
+                break;
+            }
             if ((index + nbyte) > hydra->length) {
                 /* not enough bytes received (splitted response) */
-                MACCAN_LOG_WRITE(&hydra->buffer[index], hydra->length - index, "%");
                 break;
             }
-            MACCAN_LOG_WRITE(&hydra->buffer[index], nbyte, index ? "+" : "<");
+            reader->counters.bytes += nbyte;
+            MACCAN_TRACE(CANTRC_CMD_DECODED, nbyte, CANTRC_Word(&hydra->buffer[index], nbyte));
+            /* demultiplex by source HE: CAN channel or the requester (router, sysdbg) */
+            channel = reader->he2channel[SRC_HE(&hydra->buffer[index]) % KVASER_MAX_HE_COUNT];
+            if (channel >= KVASER_MAX_CAN_CHANNELS)
+                channel = reader->requester;
+            if ((context = KvaserUSB_GetRecvData(reader, channel)) == NULL) {
+                /* CAN channel not attached: skip the command */
+                index += nbyte;
+                continue;
+            }
             /* interpret the command code */
             switch (hydra->buffer[index]) {
                 case CMD_CHIP_STATE_EVENT:
                 case CMD_ERROR_EVENT:
                 case CMD_CAN_ERROR_EVENT:
                     /* event message: update event status */
-                    (void)UpdateEventData(&context->evData, &hydra->buffer[index], nbyte, context->timerFreq);
+                    if (UpdateEventData(&context->evData, &hydra->buffer[index], nbyte, context->timerFreq))
+                        KvaserUSB_UpdateEventQueue(context, hydra->buffer[index]);
+                    KvaserUSB_UpdateBusStatus(context, context->evData.chipState.busStatus);
                     /* on error event: write packet into the pipe */
                     if (CMD_ERROR_EVENT == hydra->buffer[index]) {
                         (void)CANPIP_Write(context->msgPipe, &hydra->buffer[index], nbyte);
                     }
-                    context->errCounter++;
+                    /* note: chip states polled by the sampler are not counted as events */
+                    if ((hydra->buffer[index] != CMD_CHIP_STATE_EVENT) || !KvaserUSB_PolledChipState(context))
+                        (void)__atomic_fetch_add(&context->errCounter, 1U, __ATOMIC_RELAXED);
+                    break;
+                case CMD_GET_BUSLOAD_RESP:
+                    /* bus load: update the snapshot, write packet into the pipe only when requested */
+                    KvaserUSB_UpdateBusLoad(context, DecodeBusLoad(&hydra->buffer[index]));
+                    if (!context->busSample.active)
+                        (void)CANPIP_Write(context->msgPipe, &hydra->buffer[index], nbyte);
                     break;
                 case CMD_GET_BUSPARAMS_RESP:
                 case CMD_GET_DRIVERMODE_RESP:
@@ -1516,7 +1547,6 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                 case CMD_GET_CARD_INFO_RESP:
                 case CMD_GET_INTERFACE_INFO_RESP:
                 case CMD_GET_SOFTWARE_INFO_RESP:
-                case CMD_GET_BUSLOAD_RESP:
                 case CMD_FLUSH_QUEUE_RESP:
                 case CMD_SET_BUSPARAMS_FD_RESP:
                 case CMD_SET_BUSPARAMS_RESP:
@@ -1530,10 +1560,22 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                     (void)CANPIP_Write(context->msgPipe, &hydra->buffer[index], nbyte);
                     break;
                 case CMD_EXTENDED:
-                    switch (hydra->buffer[6]) {
+                    switch (hydra->buffer[index+6]) {
                         case CMD_EXT_RX_MSG_FD:
                             /* received CAN message: decode and enqueue */
                             if (DecodeMessage(&message, &hydra->buffer[index], nbyte, context->timerFreq)) {
+                                /* bus load meter: account the CAN frame (before any suppression) */
+                                if (!message.sts)
+                                    LoadMeter_Account(&context->loadMeter, &message, now);
+                                /* shared access: publish all CAN messages for the clients (unfiltered) */
+                                if (context->sharedMem)
+                                    (void)CANSHM_Publish(context->sharedMem, (void*)&message);
+                                /* flight recorder: copy all CAN messages into the ring (unfiltered) */
+                                if (context->flightRec.ring)
+                                    FlightRec_Record(&context->flightRec, &message, now);
+                                /* overrun flag: CAN frames were lost in the device before this one */
+                                if (context->gapMarkers && (BUF2UINT32(hydra->buffer[index+8]) & MSGFLAG_OVERRUN))
+                                    KvaserUSB_DeviceGapMarker(context, &message.timestamp);
                                 /* suppress certain CAN messages depending on the operation mode */
                                 if (message.xtd && (context->opMode & CANMODE_NXTD))
                                     break;
@@ -1542,11 +1584,13 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                                 if (message.sts && !(context->opMode & CANMODE_ERR))
                                     break;
                                 if (CANQUE_Enqueue(context->msgQueue, (void*)&message) == CANUSB_SUCCESS) {
+                                    MACCAN_TRACE(CANTRC_MSG_ENQUEUED, message.id, KVASER_TRACE_TIME(message.timestamp));
                                     if (!message.sts)
-                                        context->msgCounter++;
+                                        (void)__atomic_fetch_add(&context->msgCounter, 1U, __ATOMIC_RELAXED);
                                     else
-                                        context->stsCounter++;
-                                }
+                                        (void)__atomic_fetch_add(&context->stsCounter, 1U, __ATOMIC_RELAXED);
+                                } else
+                                    MACCAN_TRACE(CANTRC_MSG_DROPPED, message.id, KVASER_TRACE_TIME(message.timestamp));
                             } else {
                                 /* there are flags that do not belong to a received CAN message */
                                 (void)UpdateEventData(&context->evData, &hydra->buffer[index], nbyte, context->timerFreq);
@@ -1558,14 +1602,17 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
                                 (void)CANPIP_Write(context->msgPipe, &hydra->buffer[index], nbyte);
                             if (context->txAck.cntMsg > 0)
                                 context->txAck.cntMsg--;
+                            MACCAN_TRACE(CANTRC_TX_ACK, hydra->buffer[index+2], context->txAck.cntMsg);
                             break;
                         default:
                             /* there are not others */
+                            reader->counters.unknown += 1U;
                             break;
                     }
                     break;
                 default:
                     /* ignore the rest */
+                    reader->counters.unknown += 1U;
                     break;
             }
             /* next command */
@@ -1573,7 +1620,7 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
         }
     } else {
         /* something went wrong on the USB line */
-        MACCAN_LOG_WRITE(hydra->buffer, hydra->length, "?");
+        MACCAN_TRACE(CANTRC_URB_ERROR, hydra->length, 0U);
     }
     /* move remaining bytes to the beginning of the retention buffer */
     if (index < hydra->length) {
@@ -1581,6 +1628,26 @@ static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 size) {
         hydra->length -= index;
     } else
         hydra->length = 0U;
+    KvaserUSB_EndUrb(reader);
+}
+
+static KvaserUSB_BusLoad_t DecodeBusLoad(const uint8_t *buffer) {
+    /* - byte 10+11: sampling interval (in [usec])
+     * - byte 12+13: number of samples where tx or rx was active
+     * - byte 14+15: milliseconds since last response
+     */
+    uint64_t interval = (uint64_t)BUF2UINT16(buffer[10]);
+    uint64_t samples = (uint64_t)BUF2UINT16(buffer[12]);
+    uint64_t delta_t = (uint64_t)BUF2UINT16(buffer[14]);
+    uint64_t zwerg = 0ULL;
+
+    if (delta_t != 0U) {
+        zwerg = (samples * interval * 10ULL) / delta_t;
+        /* 0..10000 is equivalent 0.00%..100.00% */
+        if (zwerg > 10000ULL)
+            zwerg = 10000ULL;
+    }
+    return (KvaserUSB_BusLoad_t)zwerg;
 }
 
 static bool UpdateEventData(KvaserUSB_EventData_t *event, uint8_t *buffer, uint32_t nbyte, KvaserUSB_Frequency_t frequency) {
@@ -1762,10 +1829,12 @@ static bool DecodeMessage(KvaserUSB_CanMessage_t *message, uint8_t *buffer, uint
     ticks = BUF2UINT64(buffer[24]);
     KvaserUSB_TimestampFromTicks(&message->timestamp, ticks, frequency);
     /* note: we only enqueue ordinary CAN messages and error frames.
-     *       The flags MSGFLAG_OVERRUN, MSGFLAG_NERR, MSGFLAG_WAKEUP,
-     *       MSGFLAG_TX and MSGFLAG_TXRQ are handled by UpdateEventData
+     *       The flags MSGFLAG_NERR, MSGFLAG_WAKEUP, MSGFLAG_TX and
+     *       MSGFLAG_TXRQ are handled by UpdateEventData.  The flag
+     *       MSGFLAG_OVERRUN belongs to a valid CAN message (the lost
+     *       ones were before), it is handled by the reception callback
      */
-    if (!(flags & ~(MSGFLAG_REMOTE_FRAME | MSGFLAG_ERROR_FRAME |
+    if (!(flags & ~(MSGFLAG_REMOTE_FRAME | MSGFLAG_ERROR_FRAME | MSGFLAG_OVERRUN |
                     MSGFLAG_EXTENDED_ID | MSGFLAG_FDF | MSGFLAG_BRS | MSGFLAG_ESI)))
         result = true;
     return result;
@@ -1783,6 +1852,9 @@ static CANUSB_Return_t MapChannel(KvaserUSB_Device_t *device) {
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
+    /* device-level request: the response is routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
     /* send request CMD_MAP_CHANNEL_REQ and wait for response */
     bzero(buffer, HYDRA_CMD_SIZE);
     size = FillMapChannelReq(buffer, HYDRA_CMD_SIZE, device->channelNo);
@@ -1804,6 +1876,8 @@ static CANUSB_Return_t MapChannel(KvaserUSB_Device_t *device) {
             uint16_t transId = BUF2UINT16(buffer[2]);
             device->hydraData.channel2he = BUF2UINT8(buffer[4]);
             device->hydraData.he2channel = (uint8_t)(transId & 0xFU);
+            /* note: the USB reader dispatches received commands by its source HE */
+            (void)KvaserUSB_MapHeAddress(device, device->hydraData.channel2he);
             // TODO: position = BUF2UINT8(buffer[5]);
             // TODO: flags = BUF2UINT16(buffer[6]);
 
@@ -1830,6 +1904,7 @@ static CANUSB_Return_t MapChannel(KvaserUSB_Device_t *device) {
             }
         }
     }
+    (void)KvaserUSB_UnlockRequester(device);
     return retVal;
 }
 
@@ -1895,25 +1970,7 @@ static CANUSB_Return_t ReadResponse(KvaserUSB_Device_t *device, uint8_t *buffer,
          */
         if (buffer[0] == CMD_ERROR_EVENT) {
             /* map error code (if possible) */
-            switch (buffer[11]) {  // TODO: map firmware error codes
-                case FIRMWARE_ERR_OK:
-                case FIRMWARE_ERR_CAN:
-                case FIRMWARE_ERR_NVRAM_ERROR:
-                case FIRMWARE_ERR_NOPRIV:
-                case FIRMWARE_ERR_ILLEGAL_ADDRESS:
-                case FIRMWARE_ERR_UNKNOWN_CMD:
-                case FIRMWARE_ERR_FATAL:
-                case FIRMWARE_ERR_CHECKSUM_ERROR:
-                case FIRMWARE_ERR_QUEUE_LEVEL:
-                    retVal = (CANUSB_Return_t)(-100) - (CANUSB_Return_t)buffer[11];
-                    break;
-                case FIRMWARE_ERR_PARAMETER:
-                    retVal = (CANUSB_Return_t)CANUSB_ERROR_ILLPARA;
-                    break;
-                default:
-                    retVal = (CANUSB_Return_t)(-100) - (CANUSB_Return_t)buffer[11];
-                    break;
-            }
+            retVal = MapErrorCode(buffer[11]);
             break;
         }
     } while (buffer[0] != cmdCode);
@@ -1921,6 +1978,309 @@ static CANUSB_Return_t ReadResponse(KvaserUSB_Device_t *device, uint8_t *buffer,
     return retVal;
 }
 
+static CANUSB_Return_t SendRequests(KvaserUSB_Device_t *device, HydraRequest_t *requests, uint32_t count, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_SUCCESS;
+    uint8_t buffer[HYDRA_CMD_SIZE];
+    uint32_t pending = 0U;
+    uint32_t i, match;
+    uint16_t seq;
+
+    /* sanity check */
+    if (!device || !requests)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if ((count < 1U) || (count > HYDRA_MAX_PIPELINED))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* device-level requests: the responses are routed to this CAN channel */
+    if ((retVal = KvaserUSB_LockRequester(device)) != CANUSB_SUCCESS)
+        return retVal;
+    /* issue all requests back-to-back, each one with its own transaction id.
+     * note: the requests must be independent from each other (no request
+     *       must depend on the response of another one)
+     */
+    for (i = 0U; i < count; i++) {
+        seq = (uint16_t)(HYDRA_PIPELINE_SEQ + i);
+        requests[i].buffer[2] = (uint8_t)(seq & 0xFFU);
+        requests[i].buffer[3] = (uint8_t)(requests[i].buffer[3] & 0xF0U) | (uint8_t)((seq >> 8) & 0x0FU);
+        requests[i].result = SendRequest(device, requests[i].buffer, HYDRA_CMD_SIZE);
+        requests[i].pending = (requests[i].result == CANUSB_SUCCESS) ? true : false;
+        if (requests[i].pending)
+            pending++;
+    }
+    /* collect the responses by command code and transaction id.
+     * note: the firmware answers the requests in the order they were sent.
+     *       When the transaction id. is not echoed, the oldest outstanding
+     *       request with a matching command code takes the response.
+     *       An error event is only assigned to the request with the same
+     *       transaction id.; any other error event has already been taken
+     *       by the event path of the reception callback and is skipped.
+     */
+    while (pending > 0U) {
+        retVal = CANPIP_Read(device->recvData.msgPipe, &buffer[0], KVASER_HYDRA_COMMAND_LENGTH, timeout);
+        if (retVal != CANUSB_SUCCESS)
+            break;
+        for (match = count, i = 0U; i < count; i++) {
+            if (!requests[i].pending)
+                continue;
+            if (GET_SEQ(buffer) == (uint16_t)(HYDRA_PIPELINE_SEQ + i)) {
+                if ((buffer[0] == requests[i].cmdCode) || (buffer[0] == CMD_ERROR_EVENT)) {
+                    match = i;
+                    break;
+                }
+            }
+            if ((buffer[0] == requests[i].cmdCode) && (match == count))
+                match = i;
+        }
+        if (match < count) {
+            if (buffer[0] != CMD_ERROR_EVENT)
+                memcpy(requests[match].buffer, buffer, HYDRA_CMD_SIZE);
+            else
+                requests[match].result = MapErrorCode(buffer[11]);
+            requests[match].pending = false;
+            pending--;
+        }
+    }
+    /* requests without response (timed out) */
+    for (i = 0U; i < count; i++) {
+        if (requests[i].pending) {
+            requests[i].result = retVal;
+            requests[i].pending = false;
+        }
+    }
+    (void)KvaserUSB_UnlockRequester(device);
+    /* note: the result of each transaction is stored in the request */
+    return retVal;
+}
+
+static CANUSB_Return_t MapErrorCode(uint8_t errorCode) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    switch (errorCode) {  // TODO: map firmware error codes
+        case FIRMWARE_ERR_OK:
+        case FIRMWARE_ERR_CAN:
+        case FIRMWARE_ERR_NVRAM_ERROR:
+        case FIRMWARE_ERR_NOPRIV:
+        case FIRMWARE_ERR_ILLEGAL_ADDRESS:
+        case FIRMWARE_ERR_UNKNOWN_CMD:
+        case FIRMWARE_ERR_FATAL:
+        case FIRMWARE_ERR_CHECKSUM_ERROR:
+        case FIRMWARE_ERR_QUEUE_LEVEL:
+            retVal = (CANUSB_Return_t)(-100) - (CANUSB_Return_t)errorCode;
+            break;
+        case FIRMWARE_ERR_PARAMETER:
+            retVal = (CANUSB_Return_t)CANUSB_ERROR_ILLPARA;
+            break;
+        default:
+            retVal = (CANUSB_Return_t)(-100) - (CANUSB_Return_t)errorCode;
+            break;
+    }
+    return retVal;
+}
+
+static CANUSB_Return_t GetDeviceInfo(KvaserUSB_Device_t *device, KvaserUSB_DeviceInfo_t *info) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    HydraRequest_t requests[2];
+
+    /* sanity check */
+    if (!device || !info)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* send requests for card info and software details back-to-back */
+    (void)FillGetCardInfoReq(requests[0].buffer, HYDRA_CMD_SIZE, /*dataLevel*/0);
+    requests[0].cmdCode = CMD_GET_CARD_INFO_RESP;
+    (void)FillGetSoftwareDetailsReq(requests[1].buffer, HYDRA_CMD_SIZE, /*hydraExt*/1);
+    requests[1].cmdCode = CMD_GET_SOFTWARE_DETAILS_RESP;
+    /* and collect the responses by transaction id. */
+    retVal = SendRequests(device, requests, 2U, HYDRA_CMD_RESP_TIMEOUT);
+    if (retVal != CANUSB_SUCCESS)
+        return retVal;
+    if ((retVal = requests[0].result) != CANUSB_SUCCESS) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): card information could not be read (%i)\n", device->name, device->handle, retVal);
+        return retVal;
+    }
+    DecodeCardInfo(requests[0].buffer, &info->card);
+    if ((retVal = requests[1].result) != CANUSB_SUCCESS) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): firmware information could not be read (%i)\n", device->name, device->handle, retVal);
+        return retVal;
+    }
+    DecodeSoftwareDetails(requests[1].buffer, &info->software);
+
+    /* the rest is known when the device (serial no. and firmware version) is in the cache */
+    if (InfoCache_Lookup(device, info))
+        return CANUSB_SUCCESS;
+
+    /* send requests for max. outstanding Tx and transceiver info back-to-back */
+    (void)FillGetMaxOutstandingTxReq(requests[0].buffer, HYDRA_CMD_SIZE);
+    requests[0].cmdCode = CMD_GET_SOFTWARE_INFO_RESP;
+    (void)FillGetTransceiverInfoReq(requests[1].buffer, HYDRA_CMD_SIZE, device->hydraData.channel2he);
+    requests[1].cmdCode = CMD_GET_TRANSCEIVER_INFO_RESP;
+    /* and collect the responses by transaction id. */
+    retVal = SendRequests(device, requests, 2U, HYDRA_CMD_RESP_TIMEOUT);
+    if (retVal != CANUSB_SUCCESS)
+        return retVal;
+    if ((retVal = requests[0].result) != CANUSB_SUCCESS) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): firmware information could not be read (%i)\n", device->name, device->handle, retVal);
+        return retVal;
+    }
+    DecodeSoftwareInfo(requests[0].buffer, &info->software);
+    if ((retVal = requests[1].result) != CANUSB_SUCCESS) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): transceiver information could not be read (%i)\n", device->name, device->handle, retVal);
+        return retVal;
+    }
+    DecodeTransceiverInfo(requests[1].buffer, &info->transceiver);
+
+    /* get device capabilities (if supported, requests pipelined) */
+    if (info->software.swOptions & SWOPTION_CAP_REQ) {
+        retVal = Mhydra_GetCapabilities(device, &info->capabilities);
+        if (retVal < 0) {
+            MACCAN_DEBUG_ERROR("+++ %s (device #%u): channel capabilities could not be read (%i)\n", device->name, device->handle, retVal);
+            return retVal;
+        }
+    }
+    /* remember them for the next time */
+    (void)InfoCache_Store(device, info);
+    return CANUSB_SUCCESS;
+}
+
+static void DecodeCardInfo(uint8_t *buffer, KvaserUSB_CardInfo_t *info) {
+    assert(buffer);
+    assert(info);
+    /* command response:
+     * - byte 0: command code
+     * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
+     * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
+     * - byte 4..7: serialNumber
+     * - byte 8..11: clockResolution
+     * - byte 12..15: mfgDate
+     * - byte 16..23: EAN[8]
+     * - byte 24: hwRevision
+     * - byte 25: usbHsMode
+     * - byte 26: hwType
+     * - byte 27: canTimeStampRef
+     * - byte 28: channelCount
+     * - byte 29..31: (not used)
+     */
+    info->serialNumber = BUF2UINT32(buffer[4]);
+    info->clockResolution = BUF2UINT32(buffer[8]);
+    info->mfgDate = BUF2UINT32(buffer[12]);
+    info->EAN[0] = BUF2UINT8(buffer[16]);
+    info->EAN[1] = BUF2UINT8(buffer[17]);
+    info->EAN[2] = BUF2UINT8(buffer[28]);
+    info->EAN[3] = BUF2UINT8(buffer[29]);
+    info->EAN[4] = BUF2UINT8(buffer[20]);
+    info->EAN[5] = BUF2UINT8(buffer[21]);
+    info->EAN[6] = BUF2UINT8(buffer[22]);
+    info->EAN[7] = BUF2UINT8(buffer[23]);
+    info->hwRevision = BUF2UINT8(buffer[24]);
+    info->usbHsMode = BUF2UINT8(buffer[25]);
+    info->hwType = BUF2UINT8(buffer[26]);
+    info->canTimeStampRef = BUF2UINT8(buffer[27]);
+    info->channelCount = BUF2UINT8(buffer[28]);
+}
+
+static void DecodeSoftwareDetails(uint8_t *buffer, KvaserUSB_SoftwareInfo_t *info) {
+    assert(buffer);
+    assert(info);
+    /* command response:
+     * - byte 0: command code
+     * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
+     * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
+     * - byte 4..7: swOptions
+     * - byte 8..11: swVersion
+     * - byte 12..15: swName
+     * - byte 16..23: EAN code (LSB first)
+     * - byte 24..27: maxBitrate
+     * - byte 28..31: (not used)
+     */
+    info->swOptions = BUF2UINT32(buffer[4]);
+    info->firmwareVersion = BUF2UINT32(buffer[8]);
+    info->swName = BUF2UINT32(buffer[12]);
+    info->EAN[0] = BUF2UINT8(buffer[16]);
+    info->EAN[1] = BUF2UINT8(buffer[17]);
+    info->EAN[2] = BUF2UINT8(buffer[18]);
+    info->EAN[3] = BUF2UINT8(buffer[19]);
+    info->EAN[4] = BUF2UINT8(buffer[20]);
+    info->EAN[5] = BUF2UINT8(buffer[21]);
+    info->EAN[6] = BUF2UINT8(buffer[22]);
+    info->EAN[7] = BUF2UINT8(buffer[23]);
+    info->maxBitrate = BUF2UINT32(buffer[24]);
+}
+
+static void DecodeSoftwareInfo(uint8_t *buffer, KvaserUSB_SoftwareInfo_t *info) {
+    assert(buffer);
+    assert(info);
+    /* command response:
+     * - byte 0: command code
+     * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
+     * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
+     * - byte 4..7: (reserved)
+     * - byte 8..11: (reserved)
+     * - byte 12..13: maxOutstandingTx
+     * - byte 14..31: (not used)
+     */
+    info->maxOutstandingTx = BUF2UINT16(buffer[12]);
+}
+
+static void DecodeTransceiverInfo(uint8_t *buffer, KvaserUSB_TransceiverInfo_t *info) {
+    assert(buffer);
+    assert(info);
+    /* command response:
+     * - byte 0: command code
+     * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
+     * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
+     * - byte 4..7: transceiver capabilities
+     * - byte 8: transceiver status
+     * - byte 9: transceiver type
+     * - byte 10..31: (not used)
+     */
+    info->transceiverCapabilities = BUF2UINT32(buffer[4]);
+    info->transceiverStatus = BUF2UINT8(buffer[8]);
+    info->transceiverType = BUF2UINT8(buffer[9]);
+}
+
+static void DecodeCapability(uint8_t *buffer, uint8_t channelNo, KvaserUSB_Capabilities_t *capabilities) {
+    assert(buffer);
+    assert(capabilities);
+    /* command response:
+     * - byte 0..3: (header)
+     * - byte 4..5: sub-command
+     * - byte 6..7: status (0=OK, 1=NOT_IMPLEMENTED, 2=UNAVAILABLE)
+     * - byte 8..31: depend on sub-command
+     *   for mask & value responses:
+     * - byte 8..11: mask (bit 0 = CAN1, bit 1 = CAN2, etc.)
+     * - byte 12..15: value (bit 0 = CAN1, bit 1 = CAN2, etc.)
+     */
+    uint16_t subCmd = BUF2UINT16(buffer[4]);
+    uint16_t status = BUF2UINT16(buffer[6]);
+    uint32_t mask = BUF2UINT32(buffer[8]);
+    uint32_t value = BUF2UINT32(buffer[12]);
+    uint32_t channel = (uint32_t)0x1U << channelNo;
+    if (status == 0) {
+        switch (subCmd) {
+            case CAP_SUB_CMD_SILENT_MODE: capabilities->silentMode = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_ERRFRAME: capabilities->errorGen = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_BUS_STATS: capabilities->busStats = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_ERRCOUNT_READ: capabilities->errorCount = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_SINGLE_SHOT: capabilities->singleShot = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_SYNC_TX_FLUSH: capabilities->syncTxFlush= ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_HAS_LOGGER: capabilities->hasLogger = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_HAS_REMOTE: capabilities->hasRemote = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_HAS_SCRIPT: capabilities->hasScript = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_LIN_HYBRID: capabilities->linHybrid = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_KDI_INFO: capabilities->kdiInfo = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_HAS_KDI: capabilities->hasKdi = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_HAS_IO_API: capabilities->hasIoApi = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            case CAP_SUB_CMD_HAS_BUSPARAMS_TQ: capabilities->hasTimeQuanta = ((mask & channel) && (value & channel)) ? 1 : 0; break;
+            default: /* nothing to do here */ break;
+        }
+    }
+    // TODO: decode other stuff if needed (i.e. loggerType, hwStatus, remoteInfo etc.)
+}
+
 static uint32_t FillMapChannelReq(uint8_t *buffer, uint32_t maxbyte, uint8_t channel) {
     assert(buffer);
     assert(maxbyte >= HYDRA_CMD_SIZE);
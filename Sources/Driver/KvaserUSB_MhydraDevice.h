@@ -51,7 +51,7 @@
 #include "KvaserUSB_Common.h"
 #include "KvaserUSB_Device.h"
 
-#define MHYDRA_NUM_CHANNELS  1U
+#define MHYDRA_NUM_CHANNELS  5U  /* max. number of CAN channels */
 #define MHYDRA_NUM_ENDPOINTS  4U
 #define MHYDRA_CPU_FREQUENCY  80U
 #define MHYDRA_MAX_OUTSTANDING_TX  200U
@@ -82,6 +82,7 @@ extern CANUSB_Return_t Mhydra_ResetCard(KvaserUSB_Device_t *device, uint16_t del
 extern CANUSB_Return_t Mhydra_RequestChipState(KvaserUSB_Device_t *device, uint16_t delay);
 
 extern CANUSB_Return_t Mhydra_SendMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t Mhydra_SendMessages(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *messages, uint32_t count);
 extern CANUSB_Return_t Mhydra_ReadMessage(KvaserUSB_Device_t *device, KvaserUSB_CanMessage_t *message, uint16_t timeout);
 
 extern CANUSB_Return_t Mhydra_FlushQueue(KvaserUSB_Device_t *device/*, uint8_t flags*/);
@@ -90,6 +91,7 @@ extern CANUSB_Return_t Mhydra_ResetStatistics(KvaserUSB_Device_t *device, uint16
 
 extern CANUSB_Return_t Mhydra_ReadClock(KvaserUSB_Device_t *device, uint64_t *nsec);
 extern CANUSB_Return_t Mhydra_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load);
+extern CANUSB_Return_t Mhydra_RequestBusLoad(KvaserUSB_Device_t *device);
 
 extern CANUSB_Return_t Mhydra_GetCardInfo(KvaserUSB_Device_t *device, KvaserUSB_CardInfo_t *info/*, int8_t dataLevel*/);
 extern CANUSB_Return_t Mhydra_GetSoftwareInfo(KvaserUSB_Device_t *device, KvaserUSB_SoftwareInfo_t *info/*, uint8_t hydraExt*/);
@@ -0,0 +1,525 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Interfaces
+ *
+ *  Copyright (c) 2020-2022 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "KvaserUSB_SharedDevice.h"
+#include "KvaserUSB_LeafDevice.h"
+#include "KvaserUSB_MhydraDevice.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "MacCAN_Debug.h"
+
+/*  ---  shared access (CANMODE_SHRD)  ---
+ *
+ *  The first process that opens a CAN channel with CANMODE_SHRD becomes its owner:
+ *  it has the USB device, it configures and starts the CAN controller, and it creates
+ *  a named shared memory segment for the CAN channel.  The reception callback of the
+ *  owner publishes every received CAN frame (unfiltered) into a multi-reader ring.
+ *
+ *  Each further process that opens the same CAN channel with CANMODE_SHRD (while the
+ *  USB device is in use) becomes a client: it attaches to the segment, a forwarder
+ *  thread copies the CAN frames from the ring into its own message queue (filtered by
+ *  its own operation mode), and CAN frames to be sent are submitted to a transmission
+ *  queue that is emptied by a server thread of the owner.
+ *
+ *  Bus parameters and the CAN controller state are owned by the owner; a client sees
+ *  them through the info block of the segment.
+ */
+#define SEGMENT_NAME_FORMAT  "/maccan.kvaser.%08x.%u"
+#define SEGMENT_NAME_LENGTH  32U
+#define ALIVE_CHECK_CYCLES  1000U  /* polling cycles between two owner checks (client) */
+
+#define ENTER_TX_SECTION(dev)  (void)pthread_mutex_lock(&(dev)->shared.mutex)
+#define LEAVE_TX_SECTION(dev)  (void)pthread_mutex_unlock(&(dev)->shared.mutex)
+
+static CANUSB_Return_t GetSegmentName(CANUSB_Index_t channel, char *name, size_t size);
+static CANUSB_Return_t UpdateInfo(KvaserUSB_Device_t *device, void (*modify)(KvaserUSB_SharedInfo_t*, const void*), const void *arg);
+static CANUSB_Return_t ReadInfo(KvaserUSB_Device_t *device, KvaserUSB_SharedInfo_t *info);
+static CANUSB_Return_t SendMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message);
+static void *ServerThread(void *arg);
+static void *ClientThread(void *arg);
+
+CANUSB_Return_t Shared_CreateChannel(CANUSB_Index_t channel, KvaserUSB_Device_t *device) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_SharedInfo_t info;
+    char name[SEGMENT_NAME_LENGTH];
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured || !device->usbReader)
+        return CANUSB_ERROR_NOTINIT;
+    if (device->shared.segment)
+        return CANUSB_ERROR_YETINIT;
+
+    /* create the shared memory segment for the CAN channel (we own the USB device) */
+    if ((retVal = GetSegmentName(channel, name, SEGMENT_NAME_LENGTH)) < 0)
+        return retVal;
+    device->shared.segment = CANSHM_Create(name, KVASER_SHARED_RING_SIZE, KVASER_SHARED_QUEUE_SIZE,
+                                           sizeof(KvaserUSB_CanMessage_t), sizeof(KvaserUSB_SharedInfo_t));
+    if (!device->shared.segment) {
+        MACCAN_DEBUG_ERROR("+++ %s #%u: shared memory segment could not be created (%s)\n", device->name, device->channelNo, name);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    /* publish the device information for the clients */
+    bzero(&info, sizeof(KvaserUSB_SharedInfo_t));
+    info.productId = device->productId;
+    info.releaseNo = device->releaseNo;
+    info.numChannels = device->numChannels;
+    info.channelNo = device->channelNo;
+    info.opCapability = device->opCapability;
+    info.opMode = device->recvData.opMode;
+    info.deviceInfo = device->deviceInfo;
+    info.driverType = device->driverType;
+    info.canClock = device->recvData.canClock;
+    info.timerFreq = device->recvData.timerFreq;
+    info.busStatus = device->recvData.evData.chipState.busStatus;
+    info.running = false;
+    strncpy(info.name, device->name, KVASER_MAX_STRING_LENGTH);
+    strncpy(info.vendor, device->vendor, KVASER_MAX_STRING_LENGTH);
+    strncpy(info.website, device->website, KVASER_MAX_STRING_LENGTH);
+    (void)CANSHM_WriteInfo(device->shared.segment, &info, sizeof(KvaserUSB_SharedInfo_t));
+
+    /* start the server thread (transmission on behalf of the clients) */
+    device->shared.client = false;
+    device->shared.lostCounter = 0U;
+    __atomic_store_n(&device->shared.running, true, __ATOMIC_RELEASE);
+    (void)pthread_mutex_init(&device->shared.mutex, NULL);
+    if (pthread_create(&device->shared.thread, NULL, ServerThread, (void*)device) != 0) {
+        MACCAN_DEBUG_ERROR("+++ %s #%u: server thread could not be started\n", device->name, device->channelNo);
+        (void)pthread_mutex_destroy(&device->shared.mutex);
+        (void)CANSHM_Destroy(device->shared.segment);
+        device->shared.segment = NULL;
+        __atomic_store_n(&device->shared.running, false, __ATOMIC_RELEASE);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    /* from now on the reception callback publishes all received CAN frames */
+    (void)pthread_mutex_lock(&device->usbReader->mutex);
+    device->recvData.sharedMem = device->shared.segment;
+    (void)pthread_mutex_unlock(&device->usbReader->mutex);
+
+    MACCAN_DEBUG_DRIVER("    Shared access: %s (owner)\n", name);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t Shared_DestroyChannel(KvaserUSB_Device_t *device) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->shared.segment || device->shared.client)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* stop publishing (the callback holds the reader mutex while publishing) */
+    if (device->usbReader) {
+        (void)pthread_mutex_lock(&device->usbReader->mutex);
+        device->recvData.sharedMem = NULL;
+        (void)pthread_mutex_unlock(&device->usbReader->mutex);
+    }
+    /* stop the server thread */
+    __atomic_store_n(&device->shared.running, false, __ATOMIC_RELEASE);
+    (void)pthread_join(device->shared.thread, NULL);
+    (void)pthread_mutex_destroy(&device->shared.mutex);
+
+    /* close the segment (the clients will notice it) */
+    retVal = CANSHM_Destroy(device->shared.segment);
+    device->shared.segment = NULL;
+
+    return retVal;
+}
+
+CANUSB_Return_t Shared_AttachChannel(CANUSB_Index_t channel, const KvaserUSB_OpMode_t opMode, KvaserUSB_Device_t *device) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_SharedInfo_t info;
+    char name[SEGMENT_NAME_LENGTH];
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (device->configured)
+        return CANUSB_ERROR_YETINIT;
+
+    /* attach to the shared memory segment of the owner (if any) */
+    if ((retVal = GetSegmentName(channel, name, SEGMENT_NAME_LENGTH)) < 0)
+        return retVal;
+    if (!(device->shared.segment = CANSHM_Attach(name)))
+        return CANUSB_ERROR_NOTINIT;
+    (void)CANSHM_ReadInfo(device->shared.segment, &info, sizeof(KvaserUSB_SharedInfo_t));
+
+    /* check the demanded operation mode against the capabilities of the CAN channel
+     * and against the operation mode of the owner (CAN FD and monitor mode are fixed) */
+    if (((opMode & ~info.opCapability) != 0) ||
+        ((opMode & (CANMODE_FDOE | CANMODE_BRSE | CANMODE_NISO)) != (info.opMode & (CANMODE_FDOE | CANMODE_BRSE | CANMODE_NISO)))) {
+        (void)CANSHM_Destroy(device->shared.segment);
+        device->shared.segment = NULL;
+        return CANUSB_ERROR_ILLPARA;
+    }
+    /* device context from the info block (there is no USB handle) */
+    device->productId = info.productId;
+    device->releaseNo = info.releaseNo;
+    device->handle = CANUSB_INVALID_HANDLE;
+    device->usbReader = NULL;
+    device->numChannels = info.numChannels;
+    device->channelNo = info.channelNo;
+    device->opCapability = info.opCapability;
+    device->deviceInfo = info.deviceInfo;
+    device->driverType = info.driverType;
+    strncpy(device->name, info.name, KVASER_MAX_STRING_LENGTH);
+    strncpy(device->vendor, info.vendor, KVASER_MAX_STRING_LENGTH);
+    strncpy(device->website, info.website, KVASER_MAX_STRING_LENGTH);
+    device->recvData.opMode = opMode;
+    device->recvData.canClock = info.canClock;
+    device->recvData.timerFreq = info.timerFreq;
+    device->recvData.msgCounter = 0U;
+    device->recvData.stsCounter = 0U;
+    device->recvData.errCounter = 0U;
+    device->recvData.sharedMem = NULL;
+    device->sendData.msgCounter = 0U;
+    device->sendData.errCounter = 0U;
+
+    /* create a message queue for the received CAN frames */
+    device->recvData.msgQueue = CANQUE_Create(KVASER_RECEIVE_QUEUE_SIZE, sizeof(KvaserUSB_CanMessage_t));
+    if (!device->recvData.msgQueue) {
+        (void)CANSHM_Destroy(device->shared.segment);
+        device->shared.segment = NULL;
+        return CANUSB_ERROR_RESOURCE;
+    }
+    /* start the forwarder thread (shared ring to message queue) */
+    device->shared.client = true;
+    device->shared.lostCounter = 0U;
+    __atomic_store_n(&device->shared.running, true, __ATOMIC_RELEASE);
+    if (pthread_create(&device->shared.thread, NULL, ClientThread, (void*)device) != 0) {
+        (void)CANQUE_Destroy(device->recvData.msgQueue);
+        device->recvData.msgQueue = NULL;
+        (void)CANSHM_Destroy(device->shared.segment);
+        device->shared.segment = NULL;
+        device->shared.client = false;
+        __atomic_store_n(&device->shared.running, false, __ATOMIC_RELEASE);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    device->configured = true;
+
+    MACCAN_DEBUG_DRIVER("    Shared access: %s (client)\n", name);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t Shared_DetachChannel(KvaserUSB_Device_t *device) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->shared.segment || !device->shared.client)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* stop the forwarder thread */
+    __atomic_store_n(&device->shared.running, false, __ATOMIC_RELEASE);
+    (void)pthread_join(device->shared.thread, NULL);
+
+    /* detach from the segment and release the message queue */
+    retVal = CANSHM_Destroy(device->shared.segment);
+    device->shared.segment = NULL;
+    device->shared.client = false;
+    (void)CANQUE_Destroy(device->recvData.msgQueue);
+    device->recvData.msgQueue = NULL;
+    device->configured = false;
+
+    return retVal;
+}
+
+static void SetBusParams(KvaserUSB_SharedInfo_t *info, const void *arg) {
+    info->busParams = *(const KvaserUSB_BusParamsFd_t*)arg;
+}
+
+static void SetBusStatus(KvaserUSB_SharedInfo_t *info, const void *arg) {
+    info->busStatus = *(const KvaserUSB_BusStatus_t*)arg;
+}
+
+static void SetBusLoad(KvaserUSB_SharedInfo_t *info, const void *arg) {
+    info->busLoad = *(const KvaserUSB_BusLoad_t*)arg;
+}
+
+static void SetRunning(KvaserUSB_SharedInfo_t *info, const void *arg) {
+    info->running = *(const bool*)arg;
+}
+
+CANUSB_Return_t Shared_PublishBusParams(KvaserUSB_Device_t *device, const KvaserUSB_BusParamsFd_t *params) {
+    if (!device || !params)
+        return CANUSB_ERROR_NULLPTR;
+    return UpdateInfo(device, SetBusParams, (const void*)params);
+}
+
+CANUSB_Return_t Shared_PublishBusStatus(KvaserUSB_Device_t *device, KvaserUSB_BusStatus_t status) {
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    return UpdateInfo(device, SetBusStatus, (const void*)&status);
+}
+
+CANUSB_Return_t Shared_PublishBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t load) {
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    return UpdateInfo(device, SetBusLoad, (const void*)&load);
+}
+
+CANUSB_Return_t Shared_PublishRunning(KvaserUSB_Device_t *device, bool running) {
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    return UpdateInfo(device, SetRunning, (const void*)&running);
+}
+
+CANUSB_Return_t Shared_GetBusParams(KvaserUSB_Device_t *device, KvaserUSB_BusParamsFd_t *params) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_SharedInfo_t info;
+
+    if (!device || !params)
+        return CANUSB_ERROR_NULLPTR;
+    if ((retVal = ReadInfo(device, &info)) == CANUSB_SUCCESS)
+        *params = info.busParams;
+    return retVal;
+}
+
+CANUSB_Return_t Shared_GetBusStatus(KvaserUSB_Device_t *device, KvaserUSB_BusStatus_t *status) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_SharedInfo_t info;
+
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (((retVal = ReadInfo(device, &info)) == CANUSB_SUCCESS) && status)
+        *status = info.busStatus;
+    return retVal;
+}
+
+CANUSB_Return_t Shared_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_SharedInfo_t info;
+
+    if (!device || !load)
+        return CANUSB_ERROR_NULLPTR;
+    if ((retVal = ReadInfo(device, &info)) == CANUSB_SUCCESS)
+        *load = info.busLoad;
+    return retVal;
+}
+
+CANUSB_Return_t Shared_WriteMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    uint32_t waited = 0U;
+
+    /* sanity check */
+    if (!device || !message)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured || !device->shared.client)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* suppress certain CAN messages depending on the operation mode */
+    if (message->xtd && (device->recvData.opMode & CANMODE_NXTD))
+        return CANUSB_ERROR_ILLPARA;
+    if (message->rtr && (device->recvData.opMode & CANMODE_NRTR))
+        return CANUSB_ERROR_ILLPARA;
+    if (message->sts)  /* note: error frames cannot be sent */
+        return CANUSB_ERROR_ILLPARA;
+
+    /* submit the CAN message to the owner (retry while the queue is full) */
+    while ((retVal = CANSHM_Submit(device->shared.segment, (void const*)message)) == CANUSB_ERROR_BUSY) {
+        if ((timeout != 65535U) && ((waited / 1000U) >= (uint32_t)timeout))
+            break;
+        if (!CANSHM_IsOwnerAlive(device->shared.segment)) {
+            retVal = CANUSB_ERROR_RESOURCE;
+            break;
+        }
+        (void)usleep(KVASER_SHARED_POLL_DELAY);
+        waited += KVASER_SHARED_POLL_DELAY;
+    }
+    if (retVal == CANUSB_SUCCESS)
+        (void)__atomic_fetch_add(&device->sendData.msgCounter, 1U, __ATOMIC_RELAXED);
+    else
+        (void)__atomic_fetch_add(&device->sendData.errCounter, 1U, __ATOMIC_RELAXED);
+    return retVal;
+}
+
+/*  ---  owner: server thread  ---
+ */
+static void *ServerThread(void *arg) {
+    KvaserUSB_Device_t *device = (KvaserUSB_Device_t*)arg;
+    KvaserUSB_CanMessage_t message;
+    KvaserUSB_BusStatus_t status;
+    bool pending = false;
+    bool idle;
+
+    assert(device);
+    status = device->recvData.evData.chipState.busStatus;
+
+    while (__atomic_load_n(&device->shared.running, __ATOMIC_ACQUIRE)) {
+        idle = true;
+        /* transmit the CAN messages submitted by the clients (in order) */
+        while (pending || (CANSHM_Collect(device->shared.segment, (void*)&message) == CANUSB_SUCCESS)) {
+            pending = (SendMessage(device, &message) == CANUSB_ERROR_BUSY) ? true : false;
+            if (pending)
+                break;  /* note: try again in the next cycle */
+            idle = false;
+        }
+        /* publish the bus status whenever it has changed */
+        if (device->recvData.evData.chipState.busStatus != status) {
+            status = device->recvData.evData.chipState.busStatus;
+            (void)Shared_PublishBusStatus(device, status);
+        }
+        if (idle)
+            (void)usleep(KVASER_SHARED_POLL_DELAY);
+    }
+    return NULL;
+}
+
+static CANUSB_Return_t SendMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* note: the owner's own write function is serialized by the same mutex */
+    ENTER_TX_SECTION(device);
+    switch (device->driverType) {
+        case USB_MHYDRA_DRIVER:
+            retVal = Mhydra_SendMessage(device, message, 0U);
+            break;
+        case USB_LEAF_DRIVER:
+            retVal = Leaf_SendMessage(device, message, 0U);
+            break;
+        default:
+            retVal = CANUSB_ERROR_FATAL;
+            break;
+    }
+    LEAVE_TX_SECTION(device);
+    return retVal;
+}
+
+/*  ---  client: forwarder thread  ---
+ */
+static void *ClientThread(void *arg) {
+    KvaserUSB_Device_t *device = (KvaserUSB_Device_t*)arg;
+    KvaserUSB_RecvData_t *context;
+    KvaserUSB_CanMessage_t message;
+    CANUSB_Return_t retVal;
+    uint32_t cycles = 0U;
+
+    assert(device);
+    context = &device->recvData;
+
+    while (__atomic_load_n(&device->shared.running, __ATOMIC_ACQUIRE)) {
+        retVal = CANSHM_Receive(device->shared.segment, (void*)&message, &device->shared.lostCounter);
+        if (retVal == CANUSB_SUCCESS) {
+            /* suppress certain CAN messages depending on the operation mode */
+            if (message.xtd && (context->opMode & CANMODE_NXTD))
+                continue;
+            if (message.rtr && (context->opMode & CANMODE_NRTR))
+                continue;
+            if (message.sts && !(context->opMode & CANMODE_ERR))
+                continue;
+            if (CANQUE_Enqueue(context->msgQueue, (void*)&message) == CANUSB_SUCCESS) {
+                if (!message.sts)
+                    (void)__atomic_fetch_add(&context->msgCounter, 1U, __ATOMIC_RELAXED);
+                else
+                    (void)__atomic_fetch_add(&context->stsCounter, 1U, __ATOMIC_RELAXED);
+            }
+        } else if (retVal == CANUSB_ERROR_EMPTY) {
+            /* check from time to time if the owner is still alive */
+            if ((++cycles % ALIVE_CHECK_CYCLES) == 0U) {
+                if (!CANSHM_IsOwnerAlive(device->shared.segment))
+                    break;
+            }
+            (void)usleep(KVASER_SHARED_POLL_DELAY);
+        } else {
+            /* the owner has closed the segment */
+            break;
+        }
+    }
+    /* wake up a blocking read */
+    (void)CANQUE_Signal(context->msgQueue);
+    return NULL;
+}
+
+/*  ---  helper functions  ---
+ */
+static CANUSB_Return_t GetSegmentName(CANUSB_Index_t channel, char *name, size_t size) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_CanChannel_t canChannel = 0U;
+    uint32_t location = 0U;
+
+    assert(name);
+    /* note: the USB location ID and the CAN channel on the device are unique system-wide */
+    if ((retVal = KvaserUSB_GetUsbLocation(channel, &location, &canChannel)) < 0)
+        return retVal;
+    (void)snprintf(name, size, SEGMENT_NAME_FORMAT, location, canChannel);
+    return CANUSB_SUCCESS;
+}
+
+static CANUSB_Return_t UpdateInfo(KvaserUSB_Device_t *device, void (*modify)(KvaserUSB_SharedInfo_t*, const void*), const void *arg) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    KvaserUSB_SharedInfo_t info;
+
+    assert(device);
+    assert(modify);
+    /* note: only the owner writes the info block (read-modify-write under the mutex) */
+    if (!device->shared.segment || device->shared.client)
+        return CANUSB_ERROR_NOTINIT;
+    ENTER_TX_SECTION(device);
+    if ((retVal = CANSHM_ReadInfo(device->shared.segment, &info, sizeof(KvaserUSB_SharedInfo_t))) == CANUSB_SUCCESS) {
+        modify(&info, arg);
+        retVal = CANSHM_WriteInfo(device->shared.segment, &info, sizeof(KvaserUSB_SharedInfo_t));
+    }
+    LEAVE_TX_SECTION(device);
+    return retVal;
+}
+
+static CANUSB_Return_t ReadInfo(KvaserUSB_Device_t *device, KvaserUSB_SharedInfo_t *info) {
+    assert(device);
+    assert(info);
+    if (!device->shared.segment)
+        return CANUSB_ERROR_NOTINIT;
+    if (!CANSHM_IsOwnerAlive(device->shared.segment))
+        return CANUSB_ERROR_RESOURCE;
+    return CANSHM_ReadInfo(device->shared.segment, (void*)info, sizeof(KvaserUSB_SharedInfo_t));
+}
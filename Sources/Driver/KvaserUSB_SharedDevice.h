@@ -0,0 +1,98 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Interfaces
+ *
+ *  Copyright (c) 2020-2022 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KVASERUSB_SHAREDDEVICE_H_INCLUDED
+#define KVASERUSB_SHAREDDEVICE_H_INCLUDED
+
+#include "KvaserUSB_Common.h"
+#include "KvaserUSB_Device.h"
+
+typedef struct kvaser_shared_info_t_ {  /* shared info (published by the owner): */
+    uint16_t productId;                 /* - USB product id. */
+    uint16_t releaseNo;                 /* - USB release no. */
+    KvaserUSB_CanChannel_t numChannels; /* - number of CAN channels */
+    KvaserUSB_CanChannel_t channelNo;   /* - active CAN channel on device */
+    KvaserUSB_OpMode_t opCapability;    /* - CAN operation mode capabilities */
+    KvaserUSB_OpMode_t opMode;          /* - CAN operation mode of the owner */
+    KvaserUSB_DeviceInfo_t deviceInfo;  /* - device information (hw, sw, etc.) */
+    KvaserUSB_DriverType_t driverType;  /* - driver type (Leaf or Mhydra device) */
+    KvaserUSB_Frequency_t canClock;     /* - CAN clock in [MHz] */
+    KvaserUSB_Frequency_t timerFreq;    /* - CAN timer in [MHz] */
+    KvaserUSB_BusParamsFd_t busParams;  /* - bus parameters (set by the owner) */
+    KvaserUSB_BusStatus_t busStatus;    /* - bus status (last known) */
+    KvaserUSB_BusLoad_t busLoad;        /* - bus load (last known) */
+    bool running;                       /* - flag: CAN controller started */
+    char name[KVASER_MAX_STRING_LENGTH+1];   /* - device name (zero-terminated string) */
+    char vendor[KVASER_MAX_STRING_LENGTH+1]; /* - vendor name (zero-terminated string) */
+    char website[KVASER_MAX_STRING_LENGTH+1];/* - vendor website (zero-terminated string) */
+} KvaserUSB_SharedInfo_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CANUSB_Return_t Shared_CreateChannel(CANUSB_Index_t channel, KvaserUSB_Device_t *device);
+extern CANUSB_Return_t Shared_DestroyChannel(KvaserUSB_Device_t *device);
+
+extern CANUSB_Return_t Shared_AttachChannel(CANUSB_Index_t channel, const KvaserUSB_OpMode_t opMode, KvaserUSB_Device_t *device);
+extern CANUSB_Return_t Shared_DetachChannel(KvaserUSB_Device_t *device);
+
+extern CANUSB_Return_t Shared_PublishBusParams(KvaserUSB_Device_t *device, const KvaserUSB_BusParamsFd_t *params);
+extern CANUSB_Return_t Shared_PublishBusStatus(KvaserUSB_Device_t *device, KvaserUSB_BusStatus_t status);
+extern CANUSB_Return_t Shared_PublishBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t load);
+extern CANUSB_Return_t Shared_PublishRunning(KvaserUSB_Device_t *device, bool running);
+
+extern CANUSB_Return_t Shared_GetBusParams(KvaserUSB_Device_t *device, KvaserUSB_BusParamsFd_t *params);
+extern CANUSB_Return_t Shared_GetBusStatus(KvaserUSB_Device_t *device, KvaserUSB_BusStatus_t *status);
+extern CANUSB_Return_t Shared_GetBusLoad(KvaserUSB_Device_t *device, KvaserUSB_BusLoad_t *load);
+
+extern CANUSB_Return_t Shared_WriteMessage(KvaserUSB_Device_t *device, const KvaserUSB_CanMessage_t *message, uint16_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KVASERUSB_SHAREDDEVICE_H_INCLUDED */
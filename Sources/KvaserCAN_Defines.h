@@ -125,9 +125,108 @@ extern "C" {
 //#define KVASER_IO_SERIAL_NUMBER  0x??U
 // TODO: define more or all parameters
 // ...
+#define KVASER_PROP_RX_THREAD_MODE    0x10U  /**< reception thread: 0 = driver, 1 = per device, 2 = pool (uint8_t) */
+#define KVASER_PROP_RX_THREAD_POOL    0x11U  /**< number of threads in the pool (uint8_t) */
+#define KVASER_PROP_RX_SCHED_POLICY   0x12U  /**< scheduling policy: SCHED_OTHER, SCHED_RR or SCHED_FIFO (int32_t) */
+#define KVASER_PROP_RX_SCHED_PRIORITY 0x13U  /**< scheduling priority, 0 = inherited (int32_t) */
+#define KVASER_PROP_RX_CPU_AFFINITY   0x14U  /**< CPU affinity, bit n = CPU n, 0 = none (uint64_t) */
+#define KVASER_PROP_RX_LOCK_MEMORY    0x15U  /**< lock reception buffers into memory (uint8_t) */
+#define KVASER_PROP_RX_WAIT_MODE      0x20U  /**< can_read wait mode: 0 = block, 1 = spin-then-block, 2 = busy-poll (uint8_t) */
+#define KVASER_PROP_RX_SPIN_TIME      0x21U  /**< spin time before blocking in [usec] (uint32_t) */
+#define KVASER_PROP_RX_GAP_MARKERS    0x22U  /**< status messages marking lost CAN frames in the reception queue, 0 = off (uint8_t) */
+#define KVASER_PROP_SAMPLER_INTERVAL  0x30U  /**< bus load and status sampler interval in [ms], 0 = off (uint32_t) */
+#define KVASER_PROP_BUSLOAD_MIN       0x31U  /**< min. bus load within the sampler window, 0..10000 (uint16_t) */
+#define KVASER_PROP_BUSLOAD_MAX       0x32U  /**< max. bus load within the sampler window, 0..10000 (uint16_t) */
+#define KVASER_PROP_BUSLOAD_AVG       0x33U  /**< average bus load within the sampler window, 0..10000 (uint16_t) */
+#define KVASER_PROP_BUSLOAD_HOST      0x34U  /**< bus load computed on the host from the CAN frames, 0..10000 (uint16_t) */
+#define KVASER_PROP_TX_BATCH          0x40U  /**< send 1..16 CAN messages in one USB transfer, all or nothing (can_message_t[]) */
+#define KVASER_PROP_PATH_COUNTERS     0x50U  /**< consistent snapshot of the hot-path counters (uint64_t[KVASER_PATH_COUNTERS]) */
+#define KVASER_PROP_PATH_RESET        0x51U  /**< reset the hot-path counters, the channel keeps running (uint8_t, any value) */
+#define KVASER_PROP_FLIGHT_CAPACITY   0x60U  /**< flight recorder: ring size in CAN frames, 0 = off, set when stopped (uint32_t) */
+#define KVASER_PROP_FLIGHT_PRE_TIME   0x61U  /**< flight recorder: pre-trigger window in [ms] (uint32_t) */
+#define KVASER_PROP_FLIGHT_POST_TIME  0x62U  /**< flight recorder: post-trigger window in [ms] (uint32_t) */
+#define KVASER_PROP_FLIGHT_TRIGGERS   0x63U  /**< flight recorder: trigger conditions, see KVASER_FLIGHT_xxx (uint8_t) */
+#define KVASER_PROP_FLIGHT_MATCH      0x64U  /**< flight recorder: identifier and first DLC bytes for the ID match, set when stopped (can_message_t) */
+#define KVASER_PROP_FLIGHT_FILE       0x65U  /**< flight recorder: path prefix of the capture files, set when stopped (char[]) */
+#define KVASER_PROP_FLIGHT_TRIGGER    0x66U  /**< flight recorder: trigger a capture (uint8_t, any value) */
+#define KVASER_PROP_FLIGHT_CAPTURES   0x67U  /**< flight recorder: number of capture files written (uint32_t) */
+#define KVASER_PROP_BUS_EVENTS        0x70U  /**< read bus events from the event queue, w/o USB request (kvaser_bus_event_t[]) */
+#define KVASER_PROP_BUS_EVENTS_LOST   0x71U  /**< number of bus events lost due to a full event queue (uint64_t) */
 #define KVASERCAN_MAX_BUFFER_SIZE 256U  /**< max. buffer size for GetProperty/SetProperty */
 /** @} */
 
+/** @name  Hot-Path Counters
+ *  @brief Index into the snapshot of KVASER_PROP_PATH_COUNTERS
+ *  @note  The reception counters (URBs to splits) are shared by all CAN
+ *         channels of a device (one USB pipe).  The queue high-water mark
+ *         and the outstanding Tx acknowledges are levels, not counters.
+ *  @{ */
+#define KVASER_PATH_URBS_RECEIVED   0   /**< number of URBs received */
+#define KVASER_PATH_BYTES_DECODED   1   /**< number of bytes decoded (commands) */
+#define KVASER_PATH_DECODE_ERRORS   2   /**< number of malformed URBs or commands */
+#define KVASER_PATH_UNKNOWN_CMDS    3   /**< number of unknown commands */
+#define KVASER_PATH_REASSEMBLIES    4   /**< number of commands reassembled from two URBs */
+#define KVASER_PATH_QUEUE_HIGH      5   /**< high-water mark of the reception queue */
+#define KVASER_PATH_QUEUE_OVERFLOWS 6   /**< number of overflow events of the reception queue */
+#define KVASER_PATH_LOCK_WAITS      7   /**< number of contended locks of the reception queue */
+#define KVASER_PATH_LOCK_WAIT_TIME  8   /**< total wait time for the lock of the reception queue in [ns] */
+#define KVASER_PATH_TX_PENDING      9   /**< number of outstanding Tx acknowledges */
+#define KVASER_PATH_WRITE_FAILURES  10  /**< number of USB write failures */
+#define KVASER_PATH_COUNTERS        11  /**< number of hot-path counters */
+/** @} */
+
+/** @name  Flight Recorder Triggers
+ *  @brief Trigger conditions of KVASER_PROP_FLIGHT_TRIGGERS (bit mask)
+ *  @note  On a trigger the CAN frames received and sent within the pre- and
+ *         post-trigger window are written into the capture file
+ *         '<prefix>-<n>.crec' (see can_rec.h).  KVASER_PROP_FLIGHT_TRIGGER
+ *         is always enabled.
+ *  @{ */
+#define KVASER_FLIGHT_ERROR_FRAME   0x01U   /**< error frame received */
+#define KVASER_FLIGHT_BUS_OFF       0x02U   /**< bus status changed to bus off */
+#define KVASER_FLIGHT_ID_MATCH      0x04U   /**< CAN frame matches KVASER_PROP_FLIGHT_MATCH */
+/** @} */
+
+/** @name  Bus Events
+ *  @brief Entries of KVASER_PROP_BUS_EVENTS
+ *  @note  Every chip state change (bus status or error counters), CAN
+ *         error event and error event is queued with the time-stamp from
+ *         the device (time base of the received CAN frames).  The status
+ *         before and after the event is given as CAN status register
+ *         (CANSTAT_BOFF, CANSTAT_EWRN and CANSTAT_BERR).  The entries
+ *         after the last event read are zeroed (KVASER_EVENT_NONE).  The
+ *         queue and the number of lost events are cleared by can_start.
+ *  @{ */
+#define KVASER_EVENT_NONE           0x00U   /**< no (more) events */
+#define KVASER_EVENT_CHIP_STATE     0x01U   /**< bus status or error counters changed */
+#define KVASER_EVENT_CAN_ERROR      0x02U   /**< CAN error event (error code = error factor) */
+#define KVASER_EVENT_ERROR          0x03U   /**< error event from the firmware (error code) */
+
+typedef struct kvaser_bus_event_t_ {    /**< bus event: */
+    uint64_t timestamp;                 /**< time-stamp from the device in [ns] */
+    uint8_t  type;                      /**< event type (KVASER_EVENT_xxx) */
+    uint8_t  prevStatus;                /**< CAN status before the event */
+    uint8_t  status;                    /**< CAN status after the event */
+    uint8_t  txErrors;                  /**< transmit error counter (TEC) */
+    uint8_t  rxErrors;                  /**< receive error counter (REC) */
+    uint8_t  errorCode;                 /**< error code or error factor */
+    uint16_t _reserved;                 /**< (not used) */
+} kvaser_bus_event_t;
+/** @} */
+
+/** @name  Gap Markers
+ *  @brief Identifiers of the status messages of KVASER_PROP_RX_GAP_MARKERS
+ *  @note  A gap marker is a status message (flag sts) in the reception
+ *         queue at the position of the lost CAN frames.  Its time-stamp
+ *         is the one of the first lost CAN frame, data[0..3] holds the
+ *         number of lost CAN frames (0 = unknown) and data[4..7] the time
+ *         to the last lost CAN frame in [us] (both little-endian).  One
+ *         element of the reception queue is kept free for the marker.
+ *  @{ */
+#define KVASER_GAP_QUEUE_OVERRUN    0x80000001U  /**< reception queue full (host) */
+#define KVASER_GAP_DEVICE_OVERRUN   0x80000002U  /**< overrun flag of a received CAN frame (device) */
+/** @} */
+
 /** @name  CAN API Library ID
  *  @brief Library ID and dynamic library names
  *  @{ */
@@ -142,16 +142,26 @@ int can_log_close(void) {
 int can_log_write(unsigned char *buffer, size_t nbyte, const char *prefix) {
     int i = (-1);
 #if (OPTION_MACCAN_LOGGER > 0)
+    static const char hex[] = "0123456789ABCDEF";
+    char line[3 * 64];
+    size_t n = 0U;
     if (!fp)
         return i;  /* shoplifted */
     if ((i = pthread_mutex_lock(&mt)) < 0)
         return i;  /* shoplifted */
     if (prefix)
         fprintf(fp, "%s ", prefix);
+    /* note: formatted chunk-wise, not byte by byte (for the hot path use MACCAN_TRACE) */
     for (i = 0; i < (int)nbyte; i++) {
-        if (fprintf(fp, "%02X%c", buffer[i], (i+1) < (int)nbyte ? ' ' : '\n') < 3) {
-            i = (-1);
-            break;
+        line[n++] = hex[buffer[i] >> 4];
+        line[n++] = hex[buffer[i] & 0xF];
+        line[n++] = (i+1) < (int)nbyte ? ' ' : '\n';
+        if (((n + 3U) > sizeof(line)) || ((i+1) == (int)nbyte)) {
+            if (fwrite(line, 1U, n, fp) != n) {
+                i = (-1);
+                break;
+            }
+            n = 0U;
         }
     }
     (void)pthread_mutex_unlock(&mt);
@@ -54,10 +54,14 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
+#include <errno.h>
 #include <pthread.h>
+#include <sys/mman.h>
 
 #include <mach/mach.h>
 #include <mach/clock.h>
+#include <mach/thread_act.h>
+#include <mach/thread_policy.h>
 
 #include <IOKit/IOKitLib.h>
 #include <IOKit/IOKitKeys.h>
@@ -77,16 +81,14 @@
 
 #define VERSION_MAJOR     0
 #define VERSION_MINOR     4
-#define VERSION_PATCH     1
+#define VERSION_PATCH     2
 #define SVN_REVISION     "$Rev: 1816 $"
 
 /*#define OPTION_MACCAN_MULTICHANNEL  0  !* set globally: 0 = only one channel on multi-channel devices */
+                                        /*                   1 = all channels share the opened USB interface */
 /*#define OPTION_MACCAN_PIPE_TIMEOUT  0  !* set globally: 0 = do not use xxxPipeTO variant (e.g. macOS < 10.15) */
 /*#define OPTION_MACCAN_PIPE_INFO  !* activate it, if needed */
 
-#if (OPTION_MACCAN_MULTICHANNEL != 0)
-#error multi-channel feature not supported
-#endif
 #ifdef OPTION_MACCAN_PIPE_TIMEOUT
 #if !defined(__MAC_11_0)
 #undef OPTION_MACCAN_PIPE_TIMEOUT      /* xxxPipeTO() not available in macOS < 11 */
@@ -114,11 +116,19 @@ static void DeviceRemoved(void *refCon, io_iterator_t iterator);
 static IOReturn ConfigureDevice(IOUSBDeviceInterface **dev);
 static IOReturn FindInterface(IOUSBDeviceInterface **device, int index);
 static void* WorkerThread(void* arg);
+static void* ReceptionThread(void* arg);
+static int StartReceptionThread(int number);
+static void StopReceptionThread(int number);
+static CFRunLoopRef AttachReceptionThread(CANUSB_Index_t index);
+static void DetachReceptionThread(CANUSB_Index_t index);
+static void GetThreadParamFromEnv(CANUSB_ThreadParam_t *param);
+static Boolean IsThreadParamValid(const CANUSB_ThreadParam_t *param);
 
 typedef struct usb_buffer_tag {             /* Double buffer: */
     UInt8 *data[2];                         /*   pointer to data buffers */
     UInt8 index;                            /*   index to active data buffer */
     UInt32 size;                            /*   size of each buffer (in byte) */
+    Boolean locked;                         /*   buffers are locked into memory */
 } CANUSB_Buffer_t;
 
 typedef struct usb_async_pipe_tag {         /* Asynchrounous pipe: */
@@ -132,11 +142,14 @@ typedef struct usb_async_pipe_tag {         /* Asynchrounous pipe: */
 
 typedef struct usb_interface_tag {          /* USB interface: */
     Boolean fOpened;                        /*   interface is opened */
+    UInt8 nOpened;                          /*   number of CAN channels opened */
     UInt8 u8Class;                          /*   class of the interface (8-bit) */
     UInt8 u8SubClass;                       /*   subclass of the interface (8-bit) */
     UInt8 u8Protocol;                       /*   protocol of the interface (8-bit) */
     UInt8 u8NumEndpoints;                   /*   number of endpoints of the interface */
     IOUSBInterfaceInterface **ioInterface;  /*   interface interface (instance) */
+    CFRunLoopSourceRef refRunLoopSource;    /*   asynchronous event source of the interface */
+    int nRxThread;                          /*   reception thread (-1 = driver thread) */
 } USBInterface_t;
 
 typedef struct usb_device_tag {             /* USB device: */
@@ -164,8 +177,23 @@ typedef struct usb_driver_tag {             /* USB driver: */
     int nRevision;                          /*   revision number */
 } USBDriver_t;
 
+typedef struct usb_rx_thread_tag {          /* USB reception thread: */
+    Boolean fRunning;                       /*   flag: thread running */
+    Boolean fCancelled;                     /*   flag: start timed out (thread not wanted) */
+    int nNumber;                            /*   thread number (for CPU affinity) */
+    UInt32 nDevices;                        /*   number of USB devices served */
+    pthread_t ptThread;                     /*   pthread of the reception thread */
+    CFRunLoopRef refRunLoop;                /*   run loop of the reception thread */
+    CFRunLoopSourceRef refKeepAlive;        /*   dummy source (run loop w/o source exits) */
+} USBRxThread_t;
+
 static USBDriver_t usbDriver;
 static USBDevice_t usbDevice[CANUSB_MAX_DEVICES];
+static USBRxThread_t usbRxThread[CANUSB_MAX_DEVICES];
+static pthread_cond_t condRxStarted = PTHREAD_COND_INITIALIZER;
+static CANUSB_ThreadParam_t rxParam = { CANUSB_RXTHREAD_DRIVER, 0U, SCHED_OTHER, 0, 0x0ULL, false };
+static Boolean fThreadParam = false;
+static UInt32 idxRxThread = 0U;
 static CANUSB_Index_t idxDevice = 0;
 static Boolean fInitialized = false;
 
@@ -179,12 +207,19 @@ CANUSB_Return_t CANUSB_Initialize(void) {
     if (fInitialized)
         return CANUSB_ERROR_YETINIT;
 
+    /* reception thread(s): environment variables, unless set by the application */
+    if (!fThreadParam)
+        GetThreadParamFromEnv(&rxParam);
+
     /* initialize the driver and its devices */
     bzero(&usbDriver, sizeof(USBDriver_t));
     usbDriver.fRunning = false;
+    bzero(usbRxThread, sizeof(usbRxThread));
+    idxRxThread = 0U;
     for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
         bzero(&usbDevice[index], sizeof(USBDevice_t));
         usbDevice[index].fPresent = false;
+        usbDevice[index].usbInterface.nRxThread = -1;
         /* create a mutex for each device */
         if (pthread_mutex_init(&usbDevice[index].ptMutex, NULL) != 0)
             goto error_initialize;
@@ -221,9 +256,21 @@ CANUSB_Return_t CANUSB_Initialize(void) {
     if (!running)
         goto error_runloop;
     
+    /* start the pool of reception threads (if configured) */
+    if (rxParam.mode == CANUSB_RXTHREAD_POOL) {
+        for (rc = 0; rc < (int)rxParam.poolSize; rc++) {
+            if (StartReceptionThread(rc) != 0)
+                goto error_rxthread;
+        }
+        MACCAN_DEBUG_CORE("    - Pool of %u reception thread(s) started\n", rxParam.poolSize);
+    }
     /* the driver is now loaded (notifications will be received) */
     return CANUSB_SUCCESS;
 
+error_rxthread:
+    /* on error: stop the reception threads! */
+    for (rc = rc - 1; rc >= 0; rc--)
+        StopReceptionThread(rc);
 error_runloop:
     /* on error: terminate the thread! */
     CFRunLoopStop(usbDriver.refRunLoop);
@@ -253,6 +300,9 @@ CANUSB_Return_t CANUSB_Teardown(void) {
     // TODO: switch completely over to CFRunLoop interface
     CFRunLoopStop(usbDriver.refRunLoop);
 #endif
+    /* stop all reception threads (pool or per device) */
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++)
+        StopReceptionThread(index);
     usleep(54945);
 
     /* close all USB devices */
@@ -275,6 +325,7 @@ CANUSB_Return_t CANUSB_Teardown(void) {
                 MACCAN_DEBUG_CODE(0, "close I/O device\n");
                 (void)(*usbDevice[index].ioDevice)->USBDeviceClose(usbDevice[index].ioDevice);
                 usbDevice[index].usbInterface.fOpened = false;
+                usbDevice[index].usbInterface.nOpened = 0U;
             }
             /* rest in pease */
             MACCAN_DEBUG_CODE(0, "release I/O device\n");
@@ -292,6 +343,35 @@ CANUSB_Return_t CANUSB_Teardown(void) {
     return 0;
 }
 
+CANUSB_Return_t CANUSB_SetThreadParam(const CANUSB_ThreadParam_t *param) {
+
+    /* must not be initialized */
+    if (fInitialized)
+        return CANUSB_ERROR_YETINIT;
+    /* check for NULL pointer */
+    if (!param)
+        return CANUSB_ERROR_NULLPTR;
+    /* check the parameter set */
+    if (!IsThreadParamValid(param))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* note: the application overrules the environment variables */
+    memcpy(&rxParam, param, sizeof(CANUSB_ThreadParam_t));
+    fThreadParam = true;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t CANUSB_GetThreadParam(CANUSB_ThreadParam_t *param) {
+
+    /* check for NULL pointer */
+    if (!param)
+        return CANUSB_ERROR_NULLPTR;
+
+    /* note: before initialization the environment is not yet evaluated */
+    memcpy(param, &rxParam, sizeof(CANUSB_ThreadParam_t));
+    return CANUSB_SUCCESS;
+}
+
 CANUSB_Return_t CANUSB_DeviceRequest(CANUSB_Index_t index, CANUSB_SetupPacket_t setupPacket, void *buffer, UInt16 size, UInt32 *transferred) {
     IOUSBDevRequest request;
     IOReturn kr;
@@ -405,7 +485,17 @@ CANUSB_Handle_t CANUSB_OpenDevice(CANUSB_Index_t index, UInt16 vendorId, UInt16
                 return CANUSB_INVALID_HANDLE;
             }
             /* note: fOpened is true */
-        } else {
+            usbDevice[index].usbInterface.nOpened = 1U;
+        }
+#if (OPTION_MACCAN_MULTICHANNEL != 0)
+        else if (usbDevice[index].usbInterface.nOpened < usbDevice[index].nCanChannels) {
+            /* another CAN channel on the already opened USB interface */
+            usbDevice[index].usbInterface.nOpened++;
+            MACCAN_DEBUG_CORE("      - Device #%i: %u of %u CAN channel(s) opened\n", index,
+                              usbDevice[index].usbInterface.nOpened, usbDevice[index].nCanChannels);
+        }
+#endif
+        else {
             /* all CAN channels on the USB interface are opened */
             LEAVE_CRITICAL_SECTION(index);
             MACCAN_DEBUG_FUNC("unlocked\n");
@@ -439,7 +529,16 @@ CANUSB_Return_t CANUSB_CloseDevice(CANUSB_Handle_t handle) {
     MACCAN_DEBUG_FUNC("lock #%i\n", handle);
     ENTER_CRITICAL_SECTION(handle);
     if (usbDevice[handle].fPresent) {
+#if (OPTION_MACCAN_MULTICHANNEL != 0)
+        if (usbDevice[handle].usbInterface.fOpened &&
+            (usbDevice[handle].usbInterface.nOpened > 1U)) {
+            /* other CAN channels are still using the USB interface */
+            usbDevice[handle].usbInterface.nOpened--;
+        } else
+#endif
         if (usbDevice[handle].usbInterface.fOpened) {
+            /* remove the event source from the reception thread */
+            DetachReceptionThread(handle);
             /* close the USB interface interface(s) */
             if (usbDevice[handle].usbInterface.ioInterface) {
                 MACCAN_DEBUG_CODE(0, "close and release I/O interface\n");
@@ -468,6 +567,7 @@ CANUSB_Return_t CANUSB_CloseDevice(CANUSB_Handle_t handle) {
             }
             /* the USB interface is now closed */
             usbDevice[handle].usbInterface.fOpened = false;
+            usbDevice[handle].usbInterface.nOpened = 0U;
         } else {
             /* the USB interface is not opened */
             ret = CANUSB_ERROR_NOTINIT;
@@ -669,6 +769,14 @@ CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef,
     if ((asyncPipe->buffer.data[0] = malloc(bufferSize)) &&
         (asyncPipe->buffer.data[1] = malloc(bufferSize))) {
         asyncPipe->buffer.size = (UInt32)bufferSize;
+        /* lock the double buffer into memory (optional, no page faults on reception) */
+        if (rxParam.lockMemory) {
+            if ((mlock(asyncPipe->buffer.data[0], bufferSize) == 0) &&
+                (mlock(asyncPipe->buffer.data[1], bufferSize) == 0))
+                asyncPipe->buffer.locked = true;
+            else
+                MACCAN_DEBUG_ERROR("+++ Unable to lock double buffer for endpoint #%u (%i)\n", pipeRef, errno);
+        }
         asyncPipe->callback = NULL;
         asyncPipe->context = NULL;
         asyncPipe->pipeRef = pipeRef;
@@ -697,6 +805,10 @@ CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
         (void)CANUSB_AbortPipeAsync(asyncPipe);
 
     /* free double buffer and asynchronous pipe context */
+    if (asyncPipe->buffer.locked) {
+        (void)munlock(asyncPipe->buffer.data[0], asyncPipe->buffer.size);
+        (void)munlock(asyncPipe->buffer.data[1], asyncPipe->buffer.size);
+    }
     if (asyncPipe->buffer.data[1])
         free(asyncPipe->buffer.data[1]);
     if (asyncPipe->buffer.data[0])
@@ -1204,7 +1316,7 @@ CANUSB_Return_t CANUSB_GetDeviceCanChannelsOpened(CANUSB_Index_t index, UInt8 *v
     ENTER_CRITICAL_SECTION(index);
     if (usbDevice[index].fPresent &&
         (usbDevice[index].ioDevice != NULL)) {
-        *value = (UInt8)usbDevice[index].usbInterface.fOpened ? 1U : 0U;
+        *value = (UInt8)usbDevice[index].usbInterface.fOpened ? usbDevice[index].usbInterface.nOpened : 0U;
     } else {
         MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not available\n", index);
         ret = CANUSB_ERROR_HANDLE;
@@ -1850,7 +1962,8 @@ static IOReturn FindInterface(IOUSBDeviceInterface **device, int index)
                 (void)(*interface)->Release(interface);
                 break;
             }
-            CFRunLoopAddSource(usbDriver.refRunLoop, runLoopSource,
+            usbDevice[index].usbInterface.refRunLoopSource = runLoopSource;
+            CFRunLoopAddSource(AttachReceptionThread(index), runLoopSource,
                                     kCFRunLoopDefaultMode);
             MACCAN_DEBUG_CORE("      + Device #%i: asynchronous event source added to run loop\n", index);
             /* the USB interface can now be used */
@@ -1908,5 +2021,288 @@ exit_worker_thread:
     return NULL;
 }
 
+static void KeepAlive(void *info)
+{
+    /* note: the dummy source is never signaled */
+    (void)info;
+}
+
+static void* ReceptionThread(void* arg)
+{
+    USBRxThread_t *thread = (USBRxThread_t*)arg;
+    CFRunLoopSourceContext context;
+    thread_affinity_policy_data_t affinity;
+    kern_return_t kr;
+    Boolean running;
+    int cpu, n, i;
+
+    assert(thread);
+    /* note: a thread whose start has timed out is cancelled here at the latest */
+    pthread_testcancel();
+    /* CPU affinity: the n-th thread gets the n-th CPU of the mask (round-robin) */
+    if (rxParam.cpuMask) {
+        for (n = 0, i = 0; i < 64; i++)
+            n += (rxParam.cpuMask & (1ULL << i)) ? 1 : 0;
+        n = thread->nNumber % n;
+        for (cpu = 0; cpu < 64; cpu++) {
+            if ((rxParam.cpuMask & (1ULL << cpu)) && (n-- == 0))
+                break;
+        }
+        /* note: macOS knows affinity tags only (threads with different tags are
+         *       scheduled on different cores, if possible), but no CPU binding */
+        affinity.affinity_tag = (integer_t)(cpu + 1);
+        kr = thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_AFFINITY_POLICY,
+                               (thread_policy_t)&affinity, THREAD_AFFINITY_POLICY_COUNT);
+        if (KERN_SUCCESS != kr)
+            MACCAN_DEBUG_ERROR("+++ Unable to set affinity of reception thread #%i (%08x)\n", thread->nNumber, kr);
+    }
+    /* a run loop without a source would exit immediately */
+    bzero(&context, sizeof(CFRunLoopSourceContext));
+    context.perform = KeepAlive;
+    thread->refKeepAlive = CFRunLoopSourceCreate(kCFAllocatorDefault, 0, &context);
+    thread->refRunLoop = CFRunLoopGetCurrent();
+    if (thread->refKeepAlive)
+        CFRunLoopAddSource(thread->refRunLoop, thread->refKeepAlive, kCFRunLoopDefaultMode);
+
+    /* indicate to the creator that the thread is running (unless it has given up) */
+    assert(0 == pthread_mutex_lock(&usbDriver.ptMutex));
+    if (!thread->fCancelled)
+        thread->fRunning = TRUE;
+    running = thread->fRunning;
+    (void)pthread_cond_broadcast(&condRxStarted);
+    assert(0 == pthread_mutex_unlock(&usbDriver.ptMutex));
+
+    /* run the loop so completions of asynchronous reads will be received */
+    if (running)
+        CFRunLoopRun();
+
+    if (thread->refKeepAlive) {
+        CFRunLoopRemoveSource(thread->refRunLoop, thread->refKeepAlive, kCFRunLoopDefaultMode);
+        CFRelease(thread->refKeepAlive);
+        thread->refKeepAlive = NULL;
+    }
+    /* terminate the thread */
+    pthread_exit(NULL);
+    return NULL;
+}
+
+static int StartReceptionThread(int number)
+{
+    USBRxThread_t *thread = &usbRxThread[number];
+    struct sched_param param;
+    pthread_attr_t attr;
+    struct timespec abstime;
+    Boolean fExplicit = false;
+    Boolean running;
+    int rc;
+
+    assert((0 <= number) && (number < CANUSB_MAX_DEVICES));
+    bzero(thread, sizeof(USBRxThread_t));
+    thread->nNumber = number;
+
+    /* create the reception thread with the configured scheduling */
+    if (pthread_attr_init(&attr) != 0)
+        return -1;
+    if (pthread_attr_setstacksize(&attr, 64*1024) != 0)
+        goto error_attr;
+    if ((rxParam.policy != SCHED_OTHER) || (rxParam.priority != 0)) {
+        bzero(&param, sizeof(struct sched_param));
+        param.sched_priority = (rxParam.priority != 0) ? rxParam.priority : sched_get_priority_min(rxParam.policy);
+        if ((pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED) != 0) ||
+            (pthread_attr_setschedpolicy(&attr, rxParam.policy) != 0) ||
+            (pthread_attr_setschedparam(&attr, &param) != 0))
+            goto error_attr;
+        fExplicit = true;
+    } else {
+        if (pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED) != 0)
+            goto error_attr;
+    }
+    rc = pthread_create(&thread->ptThread, &attr, ReceptionThread, (void*)thread);
+    if ((rc == EPERM) && fExplicit) {
+        /* note: real-time scheduling may require special privileges */
+        MACCAN_DEBUG_ERROR("+++ No permission for scheduling policy %i, priority %i (inherited)\n", rxParam.policy, rxParam.priority);
+        (void)pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        rc = pthread_create(&thread->ptThread, &attr, ReceptionThread, (void*)thread);
+    }
+    assert(pthread_attr_destroy(&attr) == 0);
+    if (rc != 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create reception thread #%i (%i)\n", number, rc);
+        return -1;
+    }
+    /* wait for the run loop being started (signaled by the created thread) or timed out */
+    (void)clock_gettime(CLOCK_REALTIME, &abstime);
+    abstime.tv_sec += 5/*seconds*/;
+    assert(0 == pthread_mutex_lock(&usbDriver.ptMutex));
+    rc = 0;
+    while (!thread->fRunning && (rc != ETIMEDOUT))
+        rc = pthread_cond_timedwait(&condRxStarted, &usbDriver.ptMutex, &abstime);
+    running = thread->fRunning;
+    if (!running)
+        thread->fCancelled = TRUE;
+    assert(0 == pthread_mutex_unlock(&usbDriver.ptMutex));
+    if (!running) {
+        MACCAN_DEBUG_ERROR("+++ Reception thread #%i not started (timed out)\n", number);
+        /* note: the thread exits w/o entering its run loop, so it can be joined */
+        (void)pthread_cancel(thread->ptThread);
+        (void)pthread_join(thread->ptThread, NULL);
+        bzero(thread, sizeof(USBRxThread_t));
+        thread->nNumber = number;
+        return -1;
+    }
+    return 0;
+error_attr:
+    assert(pthread_attr_destroy(&attr) == 0);
+    return -1;
+}
+
+static void StopReceptionThread(int number)
+{
+    USBRxThread_t *thread = &usbRxThread[number];
+
+    assert((0 <= number) && (number < CANUSB_MAX_DEVICES));
+    if (thread->fRunning) {
+        /* note: a stop request before the loop is entered is not lost */
+        CFRunLoopStop(thread->refRunLoop);
+        (void)pthread_join(thread->ptThread, NULL);
+        thread->refRunLoop = NULL;
+        thread->fRunning = FALSE;
+        thread->nDevices = 0U;
+    }
+}
+
+static CFRunLoopRef AttachReceptionThread(CANUSB_Index_t index)
+{
+    int number = -1;
+
+    /* note: to be called with the device mutex held */
+    switch (rxParam.mode) {
+    case CANUSB_RXTHREAD_DEVICE:
+        /* one thread per USB device (the index is the thread number) */
+        if (!usbRxThread[index].fRunning && (StartReceptionThread(index) != 0))
+            break;
+        number = index;
+        break;
+    case CANUSB_RXTHREAD_POOL:
+        /* threads of the pool are assigned round-robin */
+        assert(0 == pthread_mutex_lock(&usbDriver.ptMutex));
+        if (rxParam.poolSize && usbRxThread[idxRxThread % rxParam.poolSize].fRunning)
+            number = (int)(idxRxThread++ % rxParam.poolSize);
+        assert(0 == pthread_mutex_unlock(&usbDriver.ptMutex));
+        break;
+    default:
+        break;
+    }
+    usbDevice[index].usbInterface.nRxThread = number;
+    if (number < 0) {
+        /* fall back to the driver thread */
+        MACCAN_DEBUG_CORE("      + Device #%i: reception on the driver thread\n", index);
+        return usbDriver.refRunLoop;
+    }
+    assert(0 == pthread_mutex_lock(&usbDriver.ptMutex));
+    usbRxThread[number].nDevices++;
+    assert(0 == pthread_mutex_unlock(&usbDriver.ptMutex));
+    MACCAN_DEBUG_CORE("      + Device #%i: reception on thread #%i\n", index, number);
+    return usbRxThread[number].refRunLoop;
+}
+
+static void DetachReceptionThread(CANUSB_Index_t index)
+{
+    CFRunLoopRef runLoop = usbDriver.refRunLoop;
+    int number = usbDevice[index].usbInterface.nRxThread;
+    Boolean last = false;
+
+    /* note: to be called with the device mutex held */
+    if ((0 <= number) && (number < CANUSB_MAX_DEVICES)) {
+        assert(0 == pthread_mutex_lock(&usbDriver.ptMutex));
+        runLoop = usbRxThread[number].refRunLoop;
+        if (usbRxThread[number].nDevices)
+            usbRxThread[number].nDevices--;
+        last = (usbRxThread[number].nDevices == 0U) ? true : false;
+        assert(0 == pthread_mutex_unlock(&usbDriver.ptMutex));
+    }
+    if (usbDevice[index].usbInterface.refRunLoopSource && runLoop) {
+        CFRunLoopRemoveSource(runLoop, usbDevice[index].usbInterface.refRunLoopSource, kCFRunLoopDefaultMode);
+    }
+    usbDevice[index].usbInterface.refRunLoopSource = NULL;
+    usbDevice[index].usbInterface.nRxThread = -1;
+    /* the thread of a USB device ends with the device (the pool lives with the driver) */
+    if ((rxParam.mode == CANUSB_RXTHREAD_DEVICE) && (number == index) && last)
+        StopReceptionThread(number);
+}
+
+static Boolean IsThreadParamValid(const CANUSB_ThreadParam_t *param)
+{
+    assert(param);
+    if (param->mode > CANUSB_RXTHREAD_POOL)
+        return false;
+    if ((param->mode == CANUSB_RXTHREAD_POOL) &&
+        ((param->poolSize < 1U) || (CANUSB_MAX_RXTHREADS < param->poolSize)))
+        return false;
+    if ((param->policy != SCHED_OTHER) && (param->policy != SCHED_RR) && (param->policy != SCHED_FIFO))
+        return false;
+    if ((param->priority != 0) &&
+        ((param->priority < sched_get_priority_min(param->policy)) ||
+         (param->priority > sched_get_priority_max(param->policy))))
+        return false;
+    return true;
+}
+
+static void GetThreadParamFromEnv(CANUSB_ThreadParam_t *param)
+{
+    CANUSB_ThreadParam_t tmp;
+    const char *env;
+    char *end;
+    long val;
+
+    assert(param);
+    memcpy(&tmp, param, sizeof(CANUSB_ThreadParam_t));
+    /* MACCAN_RX_THREAD = driver | device | pool[:<n>] */
+    if ((env = getenv("MACCAN_RX_THREAD")) != NULL) {
+        if (!strcmp(env, "driver"))
+            tmp.mode = CANUSB_RXTHREAD_DRIVER;
+        else if (!strcmp(env, "device"))
+            tmp.mode = CANUSB_RXTHREAD_DEVICE;
+        else if (!strncmp(env, "pool", 4)) {
+            tmp.mode = CANUSB_RXTHREAD_POOL;
+            tmp.poolSize = (env[4] == ':') ? (UInt8)strtol(&env[5], NULL, 10) : 2U;
+        }
+    }
+    /* MACCAN_RX_POLICY = other | rr | fifo */
+    if ((env = getenv("MACCAN_RX_POLICY")) != NULL) {
+        if (!strcmp(env, "other"))
+            tmp.policy = SCHED_OTHER;
+        else if (!strcmp(env, "rr"))
+            tmp.policy = SCHED_RR;
+        else if (!strcmp(env, "fifo"))
+            tmp.policy = SCHED_FIFO;
+    }
+    /* MACCAN_RX_PRIORITY = <priority> */
+    if ((env = getenv("MACCAN_RX_PRIORITY")) != NULL)
+        tmp.priority = (int)strtol(env, NULL, 10);
+    /* MACCAN_RX_CPUS = <cpu>[,<cpu>...] | 0x<mask> */
+    if ((env = getenv("MACCAN_RX_CPUS")) != NULL) {
+        if (!strncmp(env, "0x", 2) || !strncmp(env, "0X", 2))
+            tmp.cpuMask = (UInt64)strtoull(env, NULL, 16);
+        else {
+            tmp.cpuMask = 0x0ULL;
+            while (*env) {
+                val = strtol(env, &end, 10);
+                if ((end == env) || (val < 0) || (val > 63))
+                    break;
+                tmp.cpuMask |= (1ULL << val);
+                env = (*end == ',') ? (end + 1) : end;
+            }
+        }
+    }
+    /* MACCAN_RX_MLOCK = 0 | 1 */
+    if ((env = getenv("MACCAN_RX_MLOCK")) != NULL)
+        tmp.lockMemory = (strtol(env, NULL, 10) != 0) ? true : false;
+    /* take it or leave it */
+    if (IsThreadParamValid(&tmp))
+        memcpy(param, &tmp, sizeof(CANUSB_ThreadParam_t));
+    else
+        MACCAN_DEBUG_ERROR("+++ Invalid reception thread settings in environment (ignored)\n");
+}
+
 /* * $Id: MacCAN_IOUsbKit.c 1816 2023-10-14 18:22:59Z makemake $ *** (c) UV Software, Berlin ***
  */
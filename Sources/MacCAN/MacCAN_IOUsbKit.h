@@ -84,6 +84,13 @@
 #define USBREQ_RECIPIENT_ENDPOINT   0x02U
 #define USBREQ_RECIPIENT_OTHER      0x03U
 
+#define CANUSB_RXTHREAD_DRIVER  0U     /* reception on the driver thread (default) */
+#define CANUSB_RXTHREAD_DEVICE  1U     /* one reception thread per USB device */
+#define CANUSB_RXTHREAD_POOL    2U     /* pool of reception threads (round-robin) */
+#ifndef CANUSB_MAX_RXTHREADS
+#define CANUSB_MAX_RXTHREADS    8U     /* max. number of threads in the pool */
+#endif
+
 typedef struct usb_setup_packet_tag {
     UInt8  RequestType;
     UInt8  Request;
@@ -101,6 +108,15 @@ typedef void (*CANUSB_AsyncPipeCbk_t)(CANUSB_Context_t refCon, UInt8 *buffer, UI
 
 typedef struct usb_async_pipe_tag *CANUSB_AsyncPipe_t;
 
+typedef struct usb_thread_param_tag {   /* Reception thread(s): */
+    UInt8 mode;                         /*   threading: DRIVER, DEVICE or POOL */
+    UInt8 poolSize;                     /*   number of threads in the pool */
+    int policy;                         /*   scheduling policy (SCHED_OTHER, SCHED_RR or SCHED_FIFO) */
+    int priority;                       /*   scheduling priority (0 = inherited) */
+    UInt64 cpuMask;                     /*   CPU affinity (bit n = CPU n, 0 = none) */
+    Boolean lockMemory;                 /*   lock reception buffers into memory */
+} CANUSB_ThreadParam_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -109,6 +125,10 @@ extern CANUSB_Return_t CANUSB_Initialize(void);
 
 extern CANUSB_Return_t CANUSB_Teardown(void);
 
+extern CANUSB_Return_t CANUSB_SetThreadParam(const CANUSB_ThreadParam_t *param);
+
+extern CANUSB_Return_t CANUSB_GetThreadParam(CANUSB_ThreadParam_t *param);
+
 extern CANUSB_Return_t CANUSB_DeviceRequest(CANUSB_Index_t index, CANUSB_SetupPacket_t setupPacket, void *buffer, UInt16 size, UInt32 *transferred);
 
 extern CANUSB_Handle_t CANUSB_OpenDevice(CANUSB_Index_t index, UInt16 vendorId, UInt16 productId);
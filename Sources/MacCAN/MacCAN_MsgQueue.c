@@ -63,14 +63,39 @@
                                  ts.tv_sec += (time_t)1; \
                              } } while(0)
 
-#define SIGNAL_WAIT_CONDITION(queue,flg)  do{ queue->wait.flag = flg; \
+/*#define OPTION_CANQUE_STATISTICS  0  !* set globally: 1 = count condition waits/wakeups and measure lock-hold time */
+#if (OPTION_CANQUE_STATISTICS != 0)
+#define LOCK_ACQUIRED(queue)  do{ queue->stats.since = Nanoseconds(); } while(0)
+#define LOCK_RELEASED(queue)  do{ UInt64 held = Nanoseconds() - queue->stats.since; \
+                                  queue->stats.data.lockCount += 1U; \
+                                  queue->stats.data.lockTime += held; \
+                                  if (queue->stats.data.lockMax < held) queue->stats.data.lockMax = held; } while(0)
+#define COUNT_EVENT(queue,counter)  do{ queue->stats.data.counter += 1U; } while(0)
+#else
+#define LOCK_ACQUIRED(queue)  do{ } while(0)
+#define LOCK_RELEASED(queue)  do{ } while(0)
+#define COUNT_EVENT(queue,counter)  do{ } while(0)
+#endif
+#define SIGNAL_WAIT_CONDITION(queue,flg)  do{ queue->wait.flag = flg; COUNT_EVENT(queue, signals); \
                                                assert(0 == pthread_cond_signal(&queue->wait.cond)); } while(0)
-#define WAIT_CONDITION_INFINITE(queue,res)  do{ queue->wait.flag = false; \
-                                                res = pthread_cond_wait(&queue->wait.cond, &queue->wait.mutex); } while(0)
-#define WAIT_CONDITION_TIMEOUT(queue,abstime,res)  do{ queue->wait.flag = false; \
-                                                       res = pthread_cond_timedwait(&queue->wait.cond, &queue->wait.mutex, &abstime); } while(0)
-#define ENTER_CRITICAL_SECTION(queue)  assert(0 == pthread_mutex_lock(&queue->wait.mutex))
-#define LEAVE_CRITICAL_SECTION(queue)  assert(0 == pthread_mutex_unlock(&queue->wait.mutex))
+#define WAIT_CONDITION_INFINITE(queue,res)  do{ queue->wait.flag = false; COUNT_EVENT(queue, waits); LOCK_RELEASED(queue); \
+                                                res = pthread_cond_wait(&queue->wait.cond, &queue->wait.mutex); \
+                                                LOCK_ACQUIRED(queue); } while(0)
+#define WAIT_CONDITION_TIMEOUT(queue,abstime,res)  do{ queue->wait.flag = false; COUNT_EVENT(queue, waits); LOCK_RELEASED(queue); \
+                                                       res = pthread_cond_timedwait(&queue->wait.cond, &queue->wait.mutex, &abstime); \
+                                                       LOCK_ACQUIRED(queue); } while(0)
+#define ENTER_CRITICAL_SECTION(queue)  do{ if (pthread_mutex_trylock(&queue->wait.mutex) != 0) LockContended(queue); \
+                                           LOCK_ACQUIRED(queue); } while(0)
+#define LEAVE_CRITICAL_SECTION(queue)  do{ LOCK_RELEASED(queue); assert(0 == pthread_mutex_unlock(&queue->wait.mutex)); } while(0)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX()  __asm__ __volatile__("pause")
+#elif defined(__aarch64__) || defined(__arm64__)
+#define CPU_RELAX()  __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX()  do{ } while(0)
+#endif
+#define SPIN_CHECK_TIME  64U  /* read the clock every n-th spin */
 
 struct msg_queue_tag {                  /* Message Queue (w/ elements of user-defined size): */
     UInt32 size;                        /* - total number of ring-buffer elements */
@@ -84,14 +109,39 @@ struct msg_queue_tag {                  /* Message Queue (w/ elements of user-de
         pthread_mutex_t mutex;          /*   - a Posix mutex */
         pthread_cond_t cond;            /*   - a Posix condition */
         Boolean flag;                   /*   - and a flag */
+        UInt32 signals;                 /*   - number of signals (for spinners) */
     } wait;
+    struct spin_wait_t {                /* - spinning operation: */
+        UInt8 mode;                     /*   - BLOCK, SPIN or POLL */
+        UInt64 budget;                  /*   - spin time (in [ns]) */
+    } spin;
     struct overflow_t {                 /* - overflow events: */
         Boolean flag;                   /*   - to indicate an overflow */
         UInt64 counter;                 /*   - overflow counter */
     } ovfl;
+    struct gap_marker_t {               /* - gap markers (optional): */
+        CANQUE_GapMarker_t marker;      /*   - to write a marker element (NULL = off) */
+        Boolean open;                   /*   - marker is the last element (not yet closed) */
+        UInt64 lost;                    /*   - number of elements lost behind the open marker */
+        Boolean unknown;                /*   - number of lost elements unknown (synthetic marker) */
+    } gap;
+    struct contention_t {               /* - lock contention (always on): */
+        UInt64 waits;                   /*   - number of contended locks */
+        UInt64 time;                    /*   - total wait time (in [ns]) */
+    } lock;
+#if (OPTION_CANQUE_STATISTICS != 0)
+    struct statistics_t {               /* - statistics (optional): */
+        CANQUE_Statistics_t data;       /*   - counters and lock-hold time */
+        UInt64 since;                   /*   - time when the lock was acquired */
+    } stats;
+#endif
 };
 static Boolean EnqueueElement(CANQUE_MsgQueue_t queue, const void *element);
+static Boolean EnqueueMarker(CANQUE_MsgQueue_t queue, const void *marker);
 static Boolean DequeueElement(CANQUE_MsgQueue_t queue, void *element);
+static Boolean SpinWait(CANQUE_MsgQueue_t queue, UInt64 deadline);
+static void LockContended(CANQUE_MsgQueue_t queue);
+static UInt64 Nanoseconds(void);
 
 CANQUE_MsgQueue_t CANQUE_Create(size_t numElem, size_t elemSize) {
     CANQUE_MsgQueue_t msgQueue = NULL;
@@ -143,6 +193,7 @@ CANQUE_Return_t CANQUE_Signal(CANQUE_MsgQueue_t msgQueue) {
 
     if (msgQueue) {
         ENTER_CRITICAL_SECTION(msgQueue);
+        (void)__atomic_fetch_add(&msgQueue->wait.signals, 1U, __ATOMIC_RELEASE);
         SIGNAL_WAIT_CONDITION(msgQueue, false);
         LEAVE_CRITICAL_SECTION(msgQueue);
         retVal = CANUSB_SUCCESS;
@@ -158,9 +209,14 @@ CANQUE_Return_t CANQUE_Enqueue(CANQUE_MsgQueue_t msgQueue, void const *message)
     if (message && msgQueue) {
         ENTER_CRITICAL_SECTION(msgQueue);
         if (EnqueueElement(msgQueue, message)) {
+            COUNT_EVENT(msgQueue, enqueued);
             SIGNAL_WAIT_CONDITION(msgQueue, true);
             retVal = CANUSB_SUCCESS;
         } else {
+            COUNT_EVENT(msgQueue, overruns);
+            /* note: a new gap marker is an element for the readers */
+            if (msgQueue->gap.open && (msgQueue->gap.lost == 1U) && !msgQueue->gap.unknown)
+                SIGNAL_WAIT_CONDITION(msgQueue, true);
             retVal = CANUSB_ERROR_OVERRUN;
         }
         LEAVE_CRITICAL_SECTION(msgQueue);
@@ -170,28 +226,86 @@ CANQUE_Return_t CANQUE_Enqueue(CANQUE_MsgQueue_t msgQueue, void const *message)
     return retVal;
 }
 
+CANQUE_Return_t CANQUE_EnqueueMarker(CANQUE_MsgQueue_t msgQueue, void const *marker) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+    UInt32 used;
+
+    if (marker && msgQueue) {
+        ENTER_CRITICAL_SECTION(msgQueue);
+        used = msgQueue->used;
+        if (EnqueueMarker(msgQueue, marker)) {
+            /* note: a marker taken by the open gap marker is no new element */
+            if (msgQueue->used != used) {
+                COUNT_EVENT(msgQueue, enqueued);
+                SIGNAL_WAIT_CONDITION(msgQueue, true);
+            }
+            retVal = CANUSB_SUCCESS;
+        } else {
+            retVal = CANUSB_ERROR_OVERRUN;
+        }
+        LEAVE_CRITICAL_SECTION(msgQueue);
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to enqueue marker (NULL pointer)\n");
+    }
+    return retVal;
+}
+
 CANQUE_Return_t CANQUE_Dequeue(CANQUE_MsgQueue_t msgQueue, void *message, UInt16 timeout) {
     CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
     struct timespec absTime;
+    UInt64 deadline = 0U;
+    UInt32 signals;
     int waitCond = 0;
 
     GET_TIME(absTime);
     ADD_TIME(absTime, timeout);
 
     if (message && msgQueue) {
+        /* spin-then-block or busy-poll: wait for an element w/o the mutex */
+        if ((msgQueue->spin.mode != CANQUE_WAIT_BLOCK) && (timeout != 0U)) {
+            if (msgQueue->spin.mode == CANQUE_WAIT_POLL) {
+                deadline = (timeout != CANUSB_INFINITE) ? Nanoseconds() + ((UInt64)timeout * 1000000ULL) : UINT64_MAX;
+                /* note: another reader may have taken the element, so spin again */
+                while (SpinWait(msgQueue, deadline)) {
+                    ENTER_CRITICAL_SECTION(msgQueue);
+                    if (DequeueElement(msgQueue, message)) {
+                        COUNT_EVENT(msgQueue, dequeued);
+                        LEAVE_CRITICAL_SECTION(msgQueue);
+                        return CANUSB_SUCCESS;
+                    }
+                    LEAVE_CRITICAL_SECTION(msgQueue);
+                }
+                return CANUSB_ERROR_EMPTY;
+            }
+            deadline = Nanoseconds() + msgQueue->spin.budget;
+            if ((timeout != CANUSB_INFINITE) && (msgQueue->spin.budget > ((UInt64)timeout * 1000000ULL)))
+                deadline = Nanoseconds() + ((UInt64)timeout * 1000000ULL);
+            /* note: a signal during the spin must not be lost by blocking afterwards */
+            signals = __atomic_load_n(&msgQueue->wait.signals, __ATOMIC_ACQUIRE);
+            if (!SpinWait(msgQueue, deadline) &&
+                (__atomic_load_n(&msgQueue->wait.signals, __ATOMIC_ACQUIRE) != signals))
+                return CANUSB_ERROR_EMPTY;
+        }
         ENTER_CRITICAL_SECTION(msgQueue);
 dequeue:
         if (DequeueElement(msgQueue, message)) {
+            COUNT_EVENT(msgQueue, dequeued);
             retVal = CANUSB_SUCCESS;
         } else {
             if (timeout == CANUSB_INFINITE) {  /* blocking read */
                 WAIT_CONDITION_INFINITE(msgQueue, waitCond);
-                if ((waitCond == 0) && msgQueue->wait.flag)
+                if ((waitCond == 0) && msgQueue->wait.flag) {
+                    COUNT_EVENT(msgQueue, wakeups);
                     goto dequeue;
+                }
             } else if (timeout != 0U) {  /* timed blocking read */
                 WAIT_CONDITION_TIMEOUT(msgQueue, absTime, waitCond);
-                if ((waitCond == 0) && msgQueue->wait.flag)
+                if ((waitCond == 0) && msgQueue->wait.flag) {
+                    COUNT_EVENT(msgQueue, wakeups);
                     goto dequeue;
+                }
+                if (waitCond != 0)
+                    COUNT_EVENT(msgQueue, timeouts);
             }
             retVal = CANUSB_ERROR_EMPTY;
         }
@@ -214,6 +328,12 @@ CANQUE_Return_t CANQUE_Reset(CANQUE_MsgQueue_t msgQueue) {
         msgQueue->wait.flag = false;
         msgQueue->ovfl.flag = false;
         msgQueue->ovfl.counter = 0U;
+        msgQueue->gap.open = false;
+        msgQueue->gap.lost = 0U;
+        msgQueue->gap.unknown = false;
+#if (OPTION_CANQUE_STATISTICS != 0)
+        bzero(&msgQueue->stats.data, sizeof(CANQUE_Statistics_t));
+#endif
         LEAVE_CRITICAL_SECTION(msgQueue);
         retVal = CANUSB_SUCCESS;
     } else {
@@ -243,6 +363,62 @@ UInt32 CANQUE_QueueSize(CANQUE_MsgQueue_t msgQueue) {
         return 0U;;
 }
 
+CANQUE_Return_t CANQUE_SetWaitMode(CANQUE_MsgQueue_t msgQueue, UInt8 mode, UInt32 spinTime) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        if (mode <= CANQUE_WAIT_POLL) {
+            ENTER_CRITICAL_SECTION(msgQueue);
+            msgQueue->spin.mode = mode;
+            msgQueue->spin.budget = (UInt64)spinTime * 1000ULL;
+            LEAVE_CRITICAL_SECTION(msgQueue);
+            retVal = CANUSB_SUCCESS;
+        } else {
+            retVal = CANUSB_ERROR_ILLPARA;
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to set wait mode of message queue (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_GetWaitMode(CANQUE_MsgQueue_t msgQueue, UInt8 *mode, UInt32 *spinTime) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        if (mode)
+            *mode = msgQueue->spin.mode;
+        if (spinTime)
+            *spinTime = (UInt32)(msgQueue->spin.budget / 1000ULL);
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to get wait mode of message queue (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_SetGapMarker(CANQUE_MsgQueue_t msgQueue, CANQUE_GapMarker_t marker) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        /* note: one element is kept free for the marker, so two at least */
+        if (!marker || (msgQueue->size >= 2U)) {
+            ENTER_CRITICAL_SECTION(msgQueue);
+            msgQueue->gap.marker = marker;
+            msgQueue->gap.open = false;
+            msgQueue->gap.lost = 0U;
+            msgQueue->gap.unknown = false;
+            LEAVE_CRITICAL_SECTION(msgQueue);
+            retVal = CANUSB_SUCCESS;
+        } else {
+            retVal = CANUSB_ERROR_ILLPARA;
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to set gap marker of message queue (NULL pointer)\n");
+    }
+    return retVal;
+}
+
 UInt32 CANQUE_QueueHigh(CANQUE_MsgQueue_t msgQueue) {
     if (msgQueue)
         return msgQueue->high;
@@ -250,6 +426,55 @@ UInt32 CANQUE_QueueHigh(CANQUE_MsgQueue_t msgQueue) {
         return 0U;;
 }
 
+CANQUE_Return_t CANQUE_ResetQueueHigh(CANQUE_MsgQueue_t msgQueue) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        ENTER_CRITICAL_SECTION(msgQueue);
+        msgQueue->high = msgQueue->used;
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to reset high-water mark of message queue (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_LockWaits(CANQUE_MsgQueue_t msgQueue, UInt64 *waits, UInt64 *time) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        /* note: lock-free, written in the critical section only */
+        if (waits)
+            *waits = __atomic_load_n(&msgQueue->lock.waits, __ATOMIC_RELAXED);
+        if (time)
+            *time = __atomic_load_n(&msgQueue->lock.time, __ATOMIC_RELAXED);
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to get lock waits of message queue (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_GetStatistics(CANQUE_MsgQueue_t msgQueue, CANQUE_Statistics_t *statistics) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue && statistics) {
+#if (OPTION_CANQUE_STATISTICS != 0)
+        ENTER_CRITICAL_SECTION(msgQueue);
+        (void)memcpy(statistics, &msgQueue->stats.data, sizeof(CANQUE_Statistics_t));
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        retVal = CANUSB_SUCCESS;
+#else
+        bzero(statistics, sizeof(CANQUE_Statistics_t));
+        retVal = CANUSB_ERROR_NOTSUPP;
+#endif
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to get statistics of message queue (NULL pointer)\n");
+    }
+    return retVal;
+}
+
 /*  ---  FIFO  ---
  *
  *  size :  total number of elements
@@ -260,14 +485,28 @@ UInt32 CANQUE_QueueHigh(CANQUE_MsgQueue_t msgQueue) {
  *
  *  (§1) empty :  used == 0
  *  (§2) full  :  used == size  &&  size > 0
+ *
+ *  With gap markers the elements may fill size - 1 entries only, the last
+ *  entry is kept for a marker.  On the first lost element the marker is
+ *  written behind the last element; further lost elements update the open
+ *  marker in place, until an element is enqueued behind it.  So the queue
+ *  is full (used == size) only with an open marker as the last element.
+ *
+ *  A synthetic marker (e.g. an overrun of the device) is not a lost element
+ *  and not counted as overflow.  When the queue is full, it takes the entry
+ *  kept for the marker resp. it joins the open marker, and the number of
+ *  lost elements of this gap is unknown (zero is passed to the marker).
  */
 static Boolean EnqueueElement(CANQUE_MsgQueue_t queue, const void *element) {
+    UInt32 limit;
+
     assert(queue);
     assert(element);
     assert(queue->size);
     assert(queue->queueElem);
 
-    if (queue->used < queue->size) {
+    limit = queue->gap.marker ? (queue->size - 1U) : queue->size;
+    if (queue->used < limit) {
         if (queue->used != 0U)
             queue->tail = (queue->tail + 1U) % queue->size;
         else
@@ -276,14 +515,68 @@ static Boolean EnqueueElement(CANQUE_MsgQueue_t queue, const void *element) {
         queue->used += 1U;
         if (queue->high < queue->used)
             queue->high = queue->used;
+        queue->gap.open = false;
         return true;
     } else {
         queue->ovfl.counter += 1U;
         queue->ovfl.flag = true;
+        /* note: the queue can be full w/o a marker when they were switched on while running */
+        if (queue->gap.marker && (queue->gap.open || (queue->used < queue->size))) {
+            if (!queue->gap.open) {
+                if (queue->used != 0U)
+                    queue->tail = (queue->tail + 1U) % queue->size;
+                else
+                    queue->head = queue->tail;  /* to make sure */
+                bzero(&queue->queueElem[(queue->tail * queue->elemSize)], queue->elemSize);
+                queue->used += 1U;
+                if (queue->high < queue->used)
+                    queue->high = queue->used;
+                queue->gap.open = true;
+                queue->gap.lost = 0U;
+                queue->gap.unknown = false;
+            }
+            queue->gap.lost += 1U;
+            queue->gap.marker(&queue->queueElem[(queue->tail * queue->elemSize)], element,
+                              queue->gap.unknown ? 0U : queue->gap.lost);
+        }
         return false;
     }
 }
 
+static Boolean EnqueueMarker(CANQUE_MsgQueue_t queue, const void *marker) {
+    UInt32 limit;
+
+    assert(queue);
+    assert(marker);
+    assert(queue->size);
+    assert(queue->queueElem);
+
+    limit = queue->gap.marker ? (queue->size - 1U) : queue->size;
+    if (queue->used < limit) {
+        return EnqueueElement(queue, marker);
+    } else if (queue->gap.marker && queue->gap.open) {
+        /* the open marker takes it: the number of lost elements is unknown now */
+        queue->gap.unknown = true;
+        queue->gap.marker(&queue->queueElem[(queue->tail * queue->elemSize)], marker, 0U);
+        return true;
+    } else if (queue->gap.marker && (queue->used < queue->size)) {
+        /* the entry kept for the marker takes it: further lost elements extend it */
+        if (queue->used != 0U)
+            queue->tail = (queue->tail + 1U) % queue->size;
+        else
+            queue->head = queue->tail;  /* to make sure */
+        (void)memcpy(&queue->queueElem[(queue->tail * queue->elemSize)], marker, queue->elemSize);
+        queue->used += 1U;
+        if (queue->high < queue->used)
+            queue->high = queue->used;
+        queue->gap.open = true;
+        queue->gap.lost = 0U;
+        queue->gap.unknown = true;
+        return true;
+    } else
+        return false;
+}
+
 static Boolean DequeueElement(CANQUE_MsgQueue_t queue, void *element) {
     assert(queue);
     assert(element);
@@ -294,10 +587,57 @@ static Boolean DequeueElement(CANQUE_MsgQueue_t queue, void *element) {
         (void)memcpy(element, &queue->queueElem[(queue->head * queue->elemSize)], queue->elemSize);
         queue->head = (queue->head + 1U) % queue->size;
         queue->used -= 1U;
+        if (queue->used == 0U)  /* the open marker has been read */
+            queue->gap.open = false;
         return true;
     } else
         return false;
 }
 
+/*  ---  SPIN  ---
+ *
+ *  The reader polls the number of used elements (w/o the mutex) until an
+ *  element is available, the deadline is reached or the queue is signaled.
+ *  The writer updates the number under the mutex, so the element itself is
+ *  read under the mutex after the spin (see CANQUE_Dequeue).
+ */
+static Boolean SpinWait(CANQUE_MsgQueue_t queue, UInt64 deadline) {
+    UInt32 signals, spins = 0U;
+
+    assert(queue);
+
+    signals = __atomic_load_n(&queue->wait.signals, __ATOMIC_ACQUIRE);
+    for (;;) {
+        if (__atomic_load_n(&queue->used, __ATOMIC_ACQUIRE) != 0U)
+            return true;
+        if (__atomic_load_n(&queue->wait.signals, __ATOMIC_ACQUIRE) != signals)
+            return false;
+        if ((++spins % SPIN_CHECK_TIME) == 0U) {
+            if (Nanoseconds() >= deadline)
+                return false;
+        }
+        CPU_RELAX();
+    }
+}
+
+static void LockContended(CANQUE_MsgQueue_t queue) {
+    UInt64 start = Nanoseconds();
+    int rc;
+
+    /* note: the clock is read only when the lock is held by another thread */
+    rc = pthread_mutex_lock(&queue->wait.mutex);
+    assert(0 == rc);
+    (void)rc;
+    __atomic_store_n(&queue->lock.waits, queue->lock.waits + 1U, __ATOMIC_RELAXED);
+    __atomic_store_n(&queue->lock.time, queue->lock.time + (Nanoseconds() - start), __ATOMIC_RELAXED);
+}
+
+static UInt64 Nanoseconds(void) {
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((UInt64)now.tv_sec * 1000000000ULL) + (UInt64)now.tv_nsec;
+}
+
 /* * $Id: MacCAN_MsgQueue.c 1752 2023-07-06 19:40:46Z makemake $ *** (c) UV Software, Berlin ***
  */
@@ -50,10 +50,29 @@
 
 #include "MacCAN_Common.h"
 
+#define CANQUE_WAIT_BLOCK  0U  /* block on the wait condition (default) */
+#define CANQUE_WAIT_SPIN   1U  /* spin for a time budget, then block */
+#define CANQUE_WAIT_POLL   2U  /* busy-poll until timeout (never block) */
+
 typedef struct msg_queue_tag *CANQUE_MsgQueue_t;
 
 typedef int CANQUE_Return_t;
 
+typedef void (*CANQUE_GapMarker_t)(void *marker, const void *element, UInt64 lost);
+
+typedef struct canque_statistics_tag {  /* Statistics (w/ OPTION_CANQUE_STATISTICS): */
+    UInt64 enqueued;                    /* - number of enqueued elements */
+    UInt64 dequeued;                    /* - number of dequeued elements */
+    UInt64 overruns;                    /* - number of rejected elements (queue full) */
+    UInt64 signals;                     /* - number of signaled wait conditions */
+    UInt64 waits;                       /* - number of waits on the wait condition */
+    UInt64 wakeups;                     /* - number of waits woken up by an element */
+    UInt64 timeouts;                    /* - number of waits timed out */
+    UInt64 lockCount;                   /* - number of critical sections */
+    UInt64 lockTime;                    /* - total lock-hold time (in [ns]) */
+    UInt64 lockMax;                     /* - longest lock-hold time (in [ns]) */
+} CANQUE_Statistics_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -66,10 +85,18 @@ extern CANQUE_Return_t CANQUE_Signal(CANQUE_MsgQueue_t msgQueue);
 
 extern CANQUE_Return_t CANQUE_Enqueue(CANQUE_MsgQueue_t msgQueue, void const *message);
 
+extern CANQUE_Return_t CANQUE_EnqueueMarker(CANQUE_MsgQueue_t msgQueue, void const *marker);
+
 extern CANQUE_Return_t CANQUE_Dequeue(CANQUE_MsgQueue_t msgQueue, void *message, UInt16 timeout);
 
 extern CANQUE_Return_t CANQUE_Reset(CANQUE_MsgQueue_t msgQueue);
 
+extern CANQUE_Return_t CANQUE_SetWaitMode(CANQUE_MsgQueue_t msgQueue, UInt8 mode, UInt32 spinTime);
+
+extern CANQUE_Return_t CANQUE_GetWaitMode(CANQUE_MsgQueue_t msgQueue, UInt8 *mode, UInt32 *spinTime);
+
+extern CANQUE_Return_t CANQUE_SetGapMarker(CANQUE_MsgQueue_t msgQueue, CANQUE_GapMarker_t marker);
+
 extern Boolean CANQUE_OverflowFlag(CANQUE_MsgQueue_t msgQueue);
 
 extern UInt64 CANQUE_OverflowCounter(CANQUE_MsgQueue_t msgQueue);
@@ -78,6 +105,12 @@ extern UInt32 CANQUE_QueueSize(CANQUE_MsgQueue_t msgQueue);
 
 extern UInt32 CANQUE_QueueHigh(CANQUE_MsgQueue_t msgQueue);
 
+extern CANQUE_Return_t CANQUE_ResetQueueHigh(CANQUE_MsgQueue_t msgQueue);
+
+extern CANQUE_Return_t CANQUE_LockWaits(CANQUE_MsgQueue_t msgQueue, UInt64 *waits, UInt64 *time);
+
+extern CANQUE_Return_t CANQUE_GetStatistics(CANQUE_MsgQueue_t msgQueue, CANQUE_Statistics_t *statistics);
+
 #ifdef __cplusplus
 }
 #endif
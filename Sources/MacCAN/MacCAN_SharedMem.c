@@ -0,0 +1,446 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  MacCAN - macOS User-Space Driver for USB-to-CAN Interfaces
+ *
+ *  Copyright (c) 2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-Core.
+ *
+ *  MacCAN-Core is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-Core IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-Core, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-Core is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-Core is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-Core.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MacCAN_SharedMem.h"
+#include "MacCAN_Debug.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHM_MAGIC  0x4D434E53U          /* "MCNS" */
+#define SHM_LAYOUT  1U                  /* layout version */
+#define SHM_STATE_OPEN  1U
+#define SHM_STATE_CLOSED  2U
+#define SHM_MAX_INFO_SIZE  4096U
+#ifndef CANSHM_ACCESS_MODE
+#define CANSHM_ACCESS_MODE  0600        /* owner only (0660: group, see README) */
+#endif
+
+#define ALIGN8(n)  (((n) + 7U) & ~(size_t)7U)
+
+struct shm_header_tag {                 /* Shared Memory Header (mapped by all processes): */
+    UInt32 magic;                       /* - magic number */
+    UInt32 layout;                      /* - layout version */
+    pid_t ownerPid;                     /* - process id. of the owner */
+    _Atomic UInt32 state;               /* - segment state (open or closed) */
+    _Atomic UInt32 clients;             /* - number of attached clients */
+    UInt32 elemSize;                    /* - size of one element */
+    UInt32 rxSize;                      /* - number of ring elements (power of 2) */
+    UInt32 txSize;                      /* - number of queue elements (power of 2) */
+    UInt32 infoSize;                    /* - size of the info block */
+    size_t slotSize;                    /* - size of one slot (sequence + element) */
+    size_t rxOffset;                    /* - offset of the ring (Rx) */
+    size_t txOffset;                    /* - offset of the queue (Tx) */
+    size_t infoOffset;                  /* - offset of the info block */
+    size_t totalSize;                   /* - size of the whole segment */
+    _Atomic UInt64 rxHead;              /* - ring: next write position (single writer) */
+    _Atomic UInt64 txHead;              /* - queue: next write position (many writers) */
+    _Atomic UInt64 txTail;              /* - queue: next read position (single reader) */
+    _Atomic UInt64 infoSeq;             /* - info block: sequence lock */
+};
+
+struct shm_slot_tag {                   /* Slot of the ring or the queue: */
+    _Atomic UInt64 seq;                 /* - sequence number of the element */
+    UInt8 data[];                       /* - the element itself */
+};
+
+struct shm_segment_tag {                /* Shared Memory Segment (process-local handle): */
+    struct shm_header_tag *header;      /* - the mapped segment */
+    char name[32];                      /* - name of the segment (max. 31 characters) */
+    Boolean owner;                      /* - to indicate the owner */
+    UInt64 rxNext;                      /* - ring: next read position of this reader */
+};
+
+static struct shm_slot_tag *GetSlot(struct shm_header_tag *header, size_t offset, UInt64 index, UInt32 size);
+static UInt32 RoundUpPow2(size_t value);
+
+CANSHM_Segment_t CANSHM_Create(const char *name, size_t numRxElem, size_t numTxElem, size_t elemSize, size_t infoSize) {
+    CANSHM_Segment_t segment = NULL;
+    struct shm_header_tag layout;
+    void *addr;
+    int fd;
+
+    /* sanity check */
+    if (!name || (strlen(name) >= sizeof(segment->name)) ||
+        !numRxElem || !numTxElem || !elemSize || (infoSize > SHM_MAX_INFO_SIZE))
+        return NULL;
+
+    /* compute the layout of the segment */
+    bzero(&layout, sizeof(struct shm_header_tag));
+    layout.elemSize = (UInt32)elemSize;
+    layout.rxSize = RoundUpPow2(numRxElem);
+    layout.txSize = RoundUpPow2(numTxElem);
+    layout.infoSize = (UInt32)infoSize;
+    layout.slotSize = ALIGN8(sizeof(struct shm_slot_tag) + elemSize);
+    layout.rxOffset = ALIGN8(sizeof(struct shm_header_tag));
+    layout.txOffset = layout.rxOffset + (layout.slotSize * layout.rxSize);
+    layout.infoOffset = layout.txOffset + (layout.slotSize * layout.txSize);
+    layout.totalSize = layout.infoOffset + ALIGN8(infoSize);
+
+    /* create the segment exclusively (a stale one from a dead owner is removed) */
+    if ((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, CANSHM_ACCESS_MODE)) < 0) {
+        if ((errno == EEXIST) && ((segment = CANSHM_Attach(name)) != NULL)) {
+            MACCAN_DEBUG_ERROR("+++ Shared memory segment '%s' is owned by process %i\n", name, segment->header->ownerPid);
+            (void)CANSHM_Destroy(segment);
+            return NULL;
+        }
+        /* note: a segment of another user is not accessible (and not removed) */
+        if (errno == EACCES) {
+            MACCAN_DEBUG_ERROR("+++ Shared memory segment '%s' is owned by another user\n", name);
+            return NULL;
+        }
+        (void)shm_unlink(name);
+        if ((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, CANSHM_ACCESS_MODE)) < 0) {
+            MACCAN_DEBUG_ERROR("+++ Unable to create shared memory segment '%s' (%i)\n", name, errno);
+            return NULL;
+        }
+    }
+    /* note: the mode is not reduced by the umask of the process */
+    (void)fchmod(fd, CANSHM_ACCESS_MODE);
+    if (ftruncate(fd, (off_t)layout.totalSize) < 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to size shared memory segment '%s' (%i)\n", name, errno);
+        (void)close(fd);
+        (void)shm_unlink(name);
+        return NULL;
+    }
+    addr = mmap(NULL, layout.totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if (addr == MAP_FAILED) {
+        MACCAN_DEBUG_ERROR("+++ Unable to map shared memory segment '%s' (%i)\n", name, errno);
+        (void)shm_unlink(name);
+        return NULL;
+    }
+    if ((segment = (CANSHM_Segment_t)malloc(sizeof(struct shm_segment_tag))) == NULL) {
+        (void)munmap(addr, layout.totalSize);
+        (void)shm_unlink(name);
+        return NULL;
+    }
+    bzero(segment, sizeof(struct shm_segment_tag));
+    strcpy(segment->name, name);
+    segment->header = (struct shm_header_tag*)addr;
+    segment->owner = true;
+
+    /* initialize the segment (note: ftruncate fills it with zeros) */
+    memcpy(segment->header, &layout, sizeof(struct shm_header_tag));
+    segment->header->ownerPid = getpid();
+    for (UInt64 i = 0U; i < (UInt64)layout.txSize; i++)
+        atomic_store(&GetSlot(segment->header, layout.txOffset, i, layout.txSize)->seq, i);
+    segment->header->layout = SHM_LAYOUT;
+    atomic_store(&segment->header->state, SHM_STATE_OPEN);
+    atomic_thread_fence(memory_order_release);
+    segment->header->magic = SHM_MAGIC;
+    MACCAN_DEBUG_CORE("        - Shared memory '%s' for %u+%u elements of size %u bytes\n", name, layout.rxSize, layout.txSize, elemSize);
+    return segment;
+}
+
+CANSHM_Segment_t CANSHM_Attach(const char *name) {
+    CANSHM_Segment_t segment = NULL;
+    struct shm_header_tag layout;
+    struct stat st;
+    void *addr;
+    int fd;
+
+    /* sanity check */
+    if (!name || (strlen(name) >= sizeof(segment->name)))
+        return NULL;
+
+    /* open the segment and read its layout */
+    if ((fd = shm_open(name, O_RDWR, CANSHM_ACCESS_MODE)) < 0)
+        return NULL;
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct shm_header_tag))) {
+        (void)close(fd);
+        return NULL;
+    }
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
+    memcpy(&layout, addr, sizeof(struct shm_header_tag));
+    if ((layout.magic != SHM_MAGIC) || (layout.layout != SHM_LAYOUT) ||
+        (layout.totalSize != (size_t)st.st_size)) {
+        (void)munmap(addr, (size_t)st.st_size);
+        return NULL;
+    }
+    if ((segment = (CANSHM_Segment_t)malloc(sizeof(struct shm_segment_tag))) == NULL) {
+        (void)munmap(addr, (size_t)st.st_size);
+        return NULL;
+    }
+    bzero(segment, sizeof(struct shm_segment_tag));
+    strcpy(segment->name, name);
+    segment->header = (struct shm_header_tag*)addr;
+    segment->owner = false;
+
+    /* the owner must be alive */
+    if (!CANSHM_IsOwnerAlive(segment)) {
+        (void)munmap(addr, (size_t)st.st_size);
+        free(segment);
+        return NULL;
+    }
+    /* start reading with the next published element */
+    segment->rxNext = atomic_load_explicit(&segment->header->rxHead, memory_order_acquire);
+    atomic_fetch_add(&segment->header->clients, 1U);
+    return segment;
+}
+
+CANSHM_Return_t CANSHM_Destroy(CANSHM_Segment_t segment) {
+    if (!segment)
+        return CANUSB_ERROR_NULLPTR;
+
+    if (segment->owner) {
+        /* owner: wake up the clients and remove the name */
+        atomic_store(&segment->header->state, SHM_STATE_CLOSED);
+        (void)shm_unlink(segment->name);
+    } else {
+        atomic_fetch_sub(&segment->header->clients, 1U);
+    }
+    (void)munmap((void*)segment->header, segment->header->totalSize);
+    free(segment);
+    return CANUSB_SUCCESS;
+}
+
+CANSHM_Return_t CANSHM_Publish(CANSHM_Segment_t segment, void const *element) {
+    struct shm_header_tag *header;
+    struct shm_slot_tag *slot;
+    UInt64 pos;
+
+    if (!segment || !element)
+        return CANUSB_ERROR_NULLPTR;
+    if (!segment->owner)
+        return CANUSB_ERROR_HANDLE;
+
+    /* single writer: odd sequence while writing, even sequence when done (seqlock) */
+    header = segment->header;
+    pos = atomic_load_explicit(&header->rxHead, memory_order_relaxed);
+    slot = GetSlot(header, header->rxOffset, pos, header->rxSize);
+    atomic_store_explicit(&slot->seq, (pos << 1) + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(slot->data, element, header->elemSize);
+    atomic_store_explicit(&slot->seq, (pos << 1) + 2U, memory_order_release);
+    atomic_store_explicit(&header->rxHead, pos + 1U, memory_order_release);
+    return CANUSB_SUCCESS;
+}
+
+CANSHM_Return_t CANSHM_Receive(CANSHM_Segment_t segment, void *element, UInt64 *lost) {
+    struct shm_header_tag *header;
+    struct shm_slot_tag *slot;
+    UInt64 head, seq;
+
+    if (!segment || !element)
+        return CANUSB_ERROR_NULLPTR;
+
+    header = segment->header;
+    for (;;) {
+        head = atomic_load_explicit(&header->rxHead, memory_order_acquire);
+        if (segment->rxNext == head)
+            return (atomic_load(&header->state) == SHM_STATE_OPEN) ? CANUSB_ERROR_EMPTY : CANUSB_ERROR_RESOURCE;
+        /* the writer lapped us: skip the overwritten elements */
+        if ((head - segment->rxNext) > (UInt64)header->rxSize) {
+            if (lost)
+                *lost += (head - (UInt64)header->rxSize) - segment->rxNext;
+            segment->rxNext = head - (UInt64)header->rxSize;
+        }
+        slot = GetSlot(header, header->rxOffset, segment->rxNext, header->rxSize);
+        seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq == ((segment->rxNext << 1) + 2U)) {
+            memcpy(element, slot->data, header->elemSize);
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq) {
+                segment->rxNext++;
+                return CANUSB_SUCCESS;
+            }
+        }
+        /* overwritten while reading: count it as lost and try the next one */
+        if (lost)
+            *lost += 1U;
+        segment->rxNext++;
+    }
+}
+
+CANSHM_Return_t CANSHM_Submit(CANSHM_Segment_t segment, void const *element) {
+    struct shm_header_tag *header;
+    struct shm_slot_tag *slot;
+    UInt64 pos, seq;
+    SInt64 dif;
+
+    if (!segment || !element)
+        return CANUSB_ERROR_NULLPTR;
+
+    /* many writers: bounded queue w/ a sequence number per slot */
+    header = segment->header;
+    if (atomic_load(&header->state) != SHM_STATE_OPEN)
+        return CANUSB_ERROR_RESOURCE;
+    pos = atomic_load_explicit(&header->txHead, memory_order_relaxed);
+    for (;;) {
+        slot = GetSlot(header, header->txOffset, pos, header->txSize);
+        seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        dif = (SInt64)seq - (SInt64)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&header->txHead, &pos, pos + 1U,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return CANUSB_ERROR_BUSY;  /* queue full */
+        } else {
+            pos = atomic_load_explicit(&header->txHead, memory_order_relaxed);
+        }
+    }
+    memcpy(slot->data, element, header->elemSize);
+    atomic_store_explicit(&slot->seq, pos + 1U, memory_order_release);
+    return CANUSB_SUCCESS;
+}
+
+CANSHM_Return_t CANSHM_Collect(CANSHM_Segment_t segment, void *element) {
+    struct shm_header_tag *header;
+    struct shm_slot_tag *slot;
+    UInt64 pos, seq;
+
+    if (!segment || !element)
+        return CANUSB_ERROR_NULLPTR;
+    if (!segment->owner)
+        return CANUSB_ERROR_HANDLE;
+
+    /* single reader: take the element if it is completely written */
+    header = segment->header;
+    pos = atomic_load_explicit(&header->txTail, memory_order_relaxed);
+    slot = GetSlot(header, header->txOffset, pos, header->txSize);
+    seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (seq != (pos + 1U))
+        return CANUSB_ERROR_EMPTY;
+    memcpy(element, slot->data, header->elemSize);
+    atomic_store_explicit(&slot->seq, pos + (UInt64)header->txSize, memory_order_release);
+    atomic_store_explicit(&header->txTail, pos + 1U, memory_order_relaxed);
+    return CANUSB_SUCCESS;
+}
+
+CANSHM_Return_t CANSHM_WriteInfo(CANSHM_Segment_t segment, void const *info, size_t size) {
+    struct shm_header_tag *header;
+    UInt64 seq;
+
+    if (!segment || !info)
+        return CANUSB_ERROR_NULLPTR;
+    if (!segment->owner)
+        return CANUSB_ERROR_HANDLE;
+    if (size > segment->header->infoSize)
+        return CANUSB_ERROR_ILLPARA;
+
+    /* single writer: sequence lock */
+    header = segment->header;
+    seq = atomic_load_explicit(&header->infoSeq, memory_order_relaxed);
+    atomic_store_explicit(&header->infoSeq, seq + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy((UInt8*)header + header->infoOffset, info, size);
+    atomic_store_explicit(&header->infoSeq, seq + 2U, memory_order_release);
+    return CANUSB_SUCCESS;
+}
+
+CANSHM_Return_t CANSHM_ReadInfo(CANSHM_Segment_t segment, void *info, size_t size) {
+    struct shm_header_tag *header;
+    UInt64 seq;
+
+    if (!segment || !info)
+        return CANUSB_ERROR_NULLPTR;
+    if (size > segment->header->infoSize)
+        return CANUSB_ERROR_ILLPARA;
+
+    /* many readers: retry while the owner is writing */
+    header = segment->header;
+    do {
+        while ((seq = atomic_load_explicit(&header->infoSeq, memory_order_acquire)) & 1U)
+            ;
+        memcpy(info, (UInt8*)header + header->infoOffset, size);
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&header->infoSeq, memory_order_relaxed) != seq);
+    return CANUSB_SUCCESS;
+}
+
+Boolean CANSHM_IsOwner(CANSHM_Segment_t segment) {
+    return segment ? segment->owner : false;
+}
+
+Boolean CANSHM_IsOwnerAlive(CANSHM_Segment_t segment) {
+    if (!segment)
+        return false;
+    if (atomic_load(&segment->header->state) != SHM_STATE_OPEN)
+        return false;
+    /* note: EPERM means the process exists (but belongs to another user) */
+    return ((kill(segment->header->ownerPid, 0) == 0) || (errno == EPERM)) ? true : false;
+}
+
+UInt32 CANSHM_NumClients(CANSHM_Segment_t segment) {
+    return segment ? atomic_load(&segment->header->clients) : 0U;
+}
+
+/*  ---  FIFO ---
+ *
+ *  ring (Rx): element at position pos is stored in slot (pos % size),
+ *             slot.seq = 2*pos+1 while writing, 2*pos+2 when written.
+ *  queue (Tx): slot.seq = pos when free, pos+1 when written (bounded MPMC).
+ */
+static struct shm_slot_tag *GetSlot(struct shm_header_tag *header, size_t offset, UInt64 index, UInt32 size) {
+    assert(header);
+    assert(size && !(size & (size - 1U)));
+    return (struct shm_slot_tag*)((UInt8*)header + offset + (size_t)(index & (UInt64)(size - 1U)) * header->slotSize);
+}
+
+static UInt32 RoundUpPow2(size_t value) {
+    UInt32 result = 1U;
+    while ((result < (UInt32)value) && (result < 0x80000000U))
+        result <<= 1;
+    return result;
+}
+
+/* * $Id$ *** (c) UV Software, Berlin ***
+ */
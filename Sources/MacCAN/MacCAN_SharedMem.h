@@ -0,0 +1,94 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  MacCAN - macOS User-Space Driver for USB-to-CAN Interfaces
+ *
+ *  Copyright (c) 2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-Core.
+ *
+ *  MacCAN-Core is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-Core IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-Core, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-Core is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-Core is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-Core.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MACCAN_SHAREDMEM_H_INCLUDED
+#define MACCAN_SHAREDMEM_H_INCLUDED
+
+#include "MacCAN_Common.h"
+
+typedef struct shm_segment_tag *CANSHM_Segment_t;
+
+typedef int CANSHM_Return_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* owner: create the named segment w/ a multi-reader ring (Rx), a multi-writer queue (Tx) and an info block */
+extern CANSHM_Segment_t CANSHM_Create(const char *name, size_t numRxElem, size_t numTxElem, size_t elemSize, size_t infoSize);
+
+/* client: attach to the named segment of a living owner (reading starts with the next published element) */
+extern CANSHM_Segment_t CANSHM_Attach(const char *name);
+
+/* owner: mark the segment as closed, unlink and unmap it / client: unmap it */
+extern CANSHM_Return_t CANSHM_Destroy(CANSHM_Segment_t segment);
+
+extern CANSHM_Return_t CANSHM_Publish(CANSHM_Segment_t segment, void const *element);
+
+extern CANSHM_Return_t CANSHM_Receive(CANSHM_Segment_t segment, void *element, UInt64 *lost);
+
+extern CANSHM_Return_t CANSHM_Submit(CANSHM_Segment_t segment, void const *element);
+
+extern CANSHM_Return_t CANSHM_Collect(CANSHM_Segment_t segment, void *element);
+
+extern CANSHM_Return_t CANSHM_WriteInfo(CANSHM_Segment_t segment, void const *info, size_t size);
+
+extern CANSHM_Return_t CANSHM_ReadInfo(CANSHM_Segment_t segment, void *info, size_t size);
+
+extern Boolean CANSHM_IsOwner(CANSHM_Segment_t segment);
+
+extern Boolean CANSHM_IsOwnerAlive(CANSHM_Segment_t segment);
+
+extern UInt32 CANSHM_NumClients(CANSHM_Segment_t segment);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* MACCAN_SHAREDMEM_H_INCLUDED */
+
+/* * $Id$ *** (c) UV Software, Berlin ***
+ */
@@ -0,0 +1,449 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  MacCAN - macOS User-Space Driver for USB-to-CAN Interfaces
+ *
+ *  Copyright (c) 2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-Core.
+ *
+ *  MacCAN-Core is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-Core IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-Core, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-Core is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-Core is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-Core.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MacCAN_Trace.h"
+#include "MacCAN_Debug.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <inttypes.h>
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#endif
+
+#if ((CANTRC_RING_SIZE < 2U) || ((CANTRC_RING_SIZE & (CANTRC_RING_SIZE - 1U)) != 0U))
+#error CANTRC_RING_SIZE must be a power of 2
+#endif
+#define RING_MASK  (CANTRC_RING_SIZE - 1U)
+
+#define DRAIN_BATCH  1024U              /* records per drain */
+#define DRAIN_INTERVAL  20000U          /* [usec] */
+
+#define FILE_MAGIC  "CANTRC1"           /* binary trace file (7 characters + '\0') */
+
+typedef struct trc_slot_tag {           /* Slot of a ring: */
+    UInt64 seq;                         /* - sequence number of the record + 1 (0 = being written) */
+    CANTRC_Record_t record;             /* - the record itself */
+} trc_slot_t;
+
+typedef struct trc_ring_tag {           /* Trace Ring (one per thread): */
+    struct trc_ring_tag *next;          /* - next ring in the list of all rings */
+    UInt32 owned;                       /* - ring is owned by a living thread */
+    UInt32 thread;                      /* - thread number of the owner */
+    UInt64 head __attribute__((aligned(64)));  /* - records written (owner only) */
+    UInt64 tail __attribute__((aligned(64)));  /* - records drained (drain only) */
+    trc_slot_t slot[CANTRC_RING_SIZE] __attribute__((aligned(64)));
+} trc_ring_t;
+
+typedef struct trc_header_tag {         /* Binary Trace File Header: */
+    char magic[8];                      /* - FILE_MAGIC */
+    UInt32 recordSize;                  /* - size of one record */
+    UInt32 ringSize;                    /* - records per thread */
+} trc_header_t;
+
+volatile UInt32 CANTRC_Enabled = 0U;
+
+static trc_ring_t *rings = NULL;        /* list of all rings (rings are never removed) */
+static UInt32 threads = 0U;             /* number of threads seen so far */
+static __thread trc_ring_t *local = NULL;
+static pthread_key_t ringKey;
+static pthread_once_t ringOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t drainMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {                         /* Background Drain: */
+    FILE *file;                         /* - trace file */
+    int format;                         /* - output format */
+    UInt32 running;                     /* - to stop the drain thread */
+    pthread_t thread;                   /* - the drain thread */
+    UInt64 records;                     /* - number of records written */
+    UInt64 lost;                        /* - number of records lost */
+} drain;
+
+static trc_ring_t *AttachRing(void);
+static void DetachRing(void *ring);
+static void CreateKey(void);
+static Boolean ReadSlot(trc_slot_t *slot, UInt64 pos, CANTRC_Record_t *record);
+static void *DrainThread(void *arg);
+static int CompareTime(const void *a, const void *b);
+static UInt64 Ticks(void);
+static UInt64 Nanoseconds(UInt64 ticks);
+
+CANTRC_Return_t CANTRC_Enable(Boolean on) {
+    __atomic_store_n(&CANTRC_Enabled, on ? 1U : 0U, __ATOMIC_RELEASE);
+    return CANUSB_SUCCESS;
+}
+
+void CANTRC_Record(UInt32 event, UInt64 arg0, UInt64 arg1) {
+    trc_ring_t *ring = local;
+    trc_slot_t *slot;
+    UInt64 head;
+
+    /* the first trace point of a thread attaches a ring */
+    if (!ring && ((ring = AttachRing()) == NULL))
+        return;
+    /* note: the owner is the only writer, the oldest record is overwritten */
+    head = ring->head;
+    slot = &ring->slot[head & RING_MASK];
+    __atomic_store_n(&slot->seq, 0U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->record.time = Ticks();  /* note: converted by the drain */
+    slot->record.event = event;
+    slot->record.thread = ring->thread;
+    slot->record.arg[0] = arg0;
+    slot->record.arg[1] = arg1;
+    __atomic_store_n(&slot->seq, head + 1U, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, head + 1U, __ATOMIC_RELEASE);
+}
+
+UInt64 CANTRC_Word(const UInt8 *buffer, size_t nbyte) {
+    UInt64 word = 0U;
+    size_t i;
+
+    for (i = 0U; buffer && (i < nbyte) && (i < 8U); i++)
+        word |= (UInt64)buffer[i] << (8U * i);
+    return word;
+}
+
+size_t CANTRC_Drain(CANTRC_Record_t *records, size_t count, UInt64 *lost) {
+    trc_ring_t *ring;
+    UInt64 head, skipped = 0U;
+    size_t n = 0U;
+
+    /* sanity check */
+    if (!records)
+        return 0U;
+
+    /* take the records of one ring after the other (one reader at a time) */
+    (void)pthread_mutex_lock(&drainMutex);
+    for (ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring && (n < count); ring = ring->next) {
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if ((head - ring->tail) > CANTRC_RING_SIZE) {
+            skipped += (head - ring->tail) - CANTRC_RING_SIZE;
+            ring->tail = head - CANTRC_RING_SIZE;
+        }
+        while ((ring->tail < head) && (n < count)) {
+            if (ReadSlot(&ring->slot[ring->tail & RING_MASK], ring->tail, &records[n])) {
+                records[n].time = Nanoseconds(records[n].time);
+                n++;
+            } else
+                skipped++;  /* overwritten while reading */
+            ring->tail++;
+        }
+    }
+    (void)pthread_mutex_unlock(&drainMutex);
+    if (lost)
+        *lost = skipped;
+    return n;
+}
+
+CANTRC_Return_t CANTRC_Write(FILE *stream, int format, const CANTRC_Record_t *records, size_t count) {
+    size_t i;
+
+    /* sanity check */
+    if (!stream || (!records && count))
+        return CANUSB_ERROR_NULLPTR;
+
+    switch (format) {
+        case CANTRC_FORMAT_BINARY:
+            if (fwrite(records, sizeof(CANTRC_Record_t), count, stream) != count)
+                return CANUSB_ERROR_RESOURCE;
+            break;
+        case CANTRC_FORMAT_TEXT:
+            for (i = 0U; i < count; i++) {
+                if (fprintf(stream, "%" PRIu64 ".%09" PRIu64 " #%-3" PRIu32 " %-10s %016" PRIx64 " %016" PRIx64 "\n",
+                            records[i].time / 1000000000U, records[i].time % 1000000000U, records[i].thread,
+                            CANTRC_EventName(records[i].event), records[i].arg[0], records[i].arg[1]) < 0)
+                    return CANUSB_ERROR_RESOURCE;
+            }
+            break;
+        case CANTRC_FORMAT_JSON:
+            /* note: instant events, time-stamps in [usec]; the array is opened and closed by the caller */
+            for (i = 0U; i < count; i++) {
+                if (fprintf(stream, "{\"name\":\"%s\",\"cat\":\"maccan\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64 ".%03" PRIu64
+                            ",\"pid\":%i,\"tid\":%" PRIu32 ",\"args\":{\"arg0\":\"0x%" PRIx64 "\",\"arg1\":\"0x%" PRIx64 "\"}},\n",
+                            CANTRC_EventName(records[i].event), records[i].time / 1000U, records[i].time % 1000U,
+                            (int)getpid(), records[i].thread, records[i].arg[0], records[i].arg[1]) < 0)
+                    return CANUSB_ERROR_RESOURCE;
+            }
+            break;
+        default:
+            return CANUSB_ERROR_ILLPARA;
+    }
+    return CANUSB_SUCCESS;
+}
+
+CANTRC_Return_t CANTRC_Open(const char *filename, int format) {
+    trc_header_t header;
+
+    /* sanity check */
+    if ((format < CANTRC_FORMAT_BINARY) || (format > CANTRC_FORMAT_JSON))
+        return CANUSB_ERROR_ILLPARA;
+    if (drain.file)
+        return CANUSB_ERROR_YETINIT;
+
+    /* create the trace file */
+    if ((drain.file = fopen(filename ? filename : MACCAN_TRACE_FILE, (format == CANTRC_FORMAT_BINARY) ? "wb" : "w")) == NULL) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create trace file (%i)\n", errno);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    if (format == CANTRC_FORMAT_BINARY) {
+        bzero(&header, sizeof(trc_header_t));
+        strncpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.recordSize = (UInt32)sizeof(CANTRC_Record_t);
+        header.ringSize = (UInt32)CANTRC_RING_SIZE;
+        (void)fwrite(&header, sizeof(trc_header_t), 1, drain.file);
+    } else if (format == CANTRC_FORMAT_JSON)
+        (void)fputs("[\n", drain.file);
+    drain.format = format;
+    drain.records = 0U;
+    drain.lost = 0U;
+
+    /* start the background drain, then the recording */
+    __atomic_store_n(&drain.running, 1U, __ATOMIC_RELEASE);
+    if (pthread_create(&drain.thread, NULL, DrainThread, NULL) != 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create trace drain thread\n");
+        (void)fclose(drain.file);
+        drain.file = NULL;
+        return CANUSB_ERROR_RESOURCE;
+    }
+    return CANTRC_Enable(true);
+}
+
+CANTRC_Return_t CANTRC_Close(void) {
+    int rc;
+
+    /* sanity check */
+    if (!drain.file)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* stop the recording, then the background drain (it drains the rest) */
+    (void)CANTRC_Enable(false);
+    __atomic_store_n(&drain.running, 0U, __ATOMIC_RELEASE);
+    (void)pthread_join(drain.thread, NULL);
+    if (drain.format == CANTRC_FORMAT_JSON)
+        (void)fprintf(drain.file, "{\"name\":\"end\",\"cat\":\"maccan\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%" PRIu64 ",\"pid\":%i,\"tid\":0}\n]\n",
+                      Nanoseconds(Ticks()) / 1000U, (int)getpid());
+    if (drain.lost)
+        MACCAN_DEBUG_ERROR("!!! %" PRIu64 " trace record(s) lost\n", drain.lost);
+    rc = fclose(drain.file);
+    drain.file = NULL;
+    return (rc == 0) ? CANUSB_SUCCESS : CANUSB_ERROR_RESOURCE;
+}
+
+CANTRC_Return_t CANTRC_Convert(const char *filename, FILE *stream, int format) {
+    CANTRC_Record_t records[DRAIN_BATCH];
+    CANTRC_Return_t retVal = CANUSB_SUCCESS;
+    trc_header_t header;
+    UInt64 last = 0U;
+    size_t n;
+    FILE *fp;
+
+    /* sanity check */
+    if (!filename || !stream)
+        return CANUSB_ERROR_NULLPTR;
+    if ((format != CANTRC_FORMAT_TEXT) && (format != CANTRC_FORMAT_JSON))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* open the binary trace file and check its header */
+    if ((fp = fopen(filename, "rb")) == NULL)
+        return CANUSB_ERROR_RESOURCE;
+    if ((fread(&header, sizeof(trc_header_t), 1, fp) != 1) || strncmp(header.magic, FILE_MAGIC, sizeof(header.magic)) ||
+        (header.recordSize != (UInt32)sizeof(CANTRC_Record_t))) {
+        (void)fclose(fp);
+        return CANUSB_ERROR_ILLPARA;
+    }
+    /* decode all records */
+    if (format == CANTRC_FORMAT_JSON)
+        (void)fputs("[\n", stream);
+    while ((retVal == CANUSB_SUCCESS) && ((n = fread(records, sizeof(CANTRC_Record_t), DRAIN_BATCH, fp)) > 0U)) {
+        retVal = CANTRC_Write(stream, format, records, n);
+        last = records[n - 1U].time;
+    }
+    if (format == CANTRC_FORMAT_JSON)
+        (void)fprintf(stream, "{\"name\":\"end\",\"cat\":\"maccan\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%" PRIu64 ",\"pid\":0,\"tid\":0}\n]\n",
+                      last / 1000U);
+    (void)fclose(fp);
+    return retVal;
+}
+
+const char *CANTRC_EventName(UInt32 event) {
+    switch (event) {
+        case CANTRC_URB_RECEIVED: return "urb";
+        case CANTRC_URB_ERROR: return "urb-error";
+        case CANTRC_CMD_DECODED: return "decode";
+        case CANTRC_MSG_ENQUEUED: return "enqueue";
+        case CANTRC_MSG_DROPPED: return "drop";
+        case CANTRC_MSG_DEQUEUED: return "dequeue";
+        case CANTRC_USB_WRITE: return "usb-write";
+        case CANTRC_USB_FAILED: return "usb-failed";
+        case CANTRC_TX_ACK: return "tx-ack";
+        case CANTRC_RECORDS_LOST: return "lost";
+        default: return "event";
+    }
+}
+
+static trc_ring_t *AttachRing(void) {
+    trc_ring_t *ring;
+    UInt32 owned;
+    void *mem;
+
+    (void)pthread_once(&ringOnce, CreateKey);
+
+    /* take over the ring of a terminated thread, if any */
+    for (ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+        owned = 0U;
+        if (__atomic_compare_exchange_n(&ring->owned, &owned, 1U, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+    }
+    /* otherwise create a new one and put it into the list */
+    if (!ring) {
+        if (posix_memalign(&mem, 64U, sizeof(trc_ring_t)) != 0)
+            return NULL;
+        ring = (trc_ring_t*)mem;
+        bzero(ring, sizeof(trc_ring_t));
+        ring->owned = 1U;
+        ring->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&rings, &ring->next, ring, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+    }
+    ring->thread = __atomic_add_fetch(&threads, 1U, __ATOMIC_RELAXED);
+    (void)pthread_setspecific(ringKey, (void*)ring);
+    local = ring;
+    return ring;
+}
+
+static void DetachRing(void *ring) {
+    /* note: the records stay in the ring until they are drained or overwritten */
+    if (ring)
+        __atomic_store_n(&((trc_ring_t*)ring)->owned, 0U, __ATOMIC_RELEASE);
+}
+
+static void CreateKey(void) {
+    (void)pthread_key_create(&ringKey, DetachRing);
+}
+
+static Boolean ReadSlot(trc_slot_t *slot, UInt64 pos, CANTRC_Record_t *record) {
+    UInt64 seq1, seq2;
+
+    /* note: the record is valid if its sequence number is unchanged after copying it */
+    seq1 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    memcpy(record, &slot->record, sizeof(CANTRC_Record_t));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    seq2 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    return ((seq1 == (pos + 1U)) && (seq2 == seq1)) ? true : false;
+}
+
+static void *DrainThread(void *arg) {
+    CANTRC_Record_t records[DRAIN_BATCH + 1U];
+    UInt64 lost;
+    Boolean last;
+    size_t n;
+
+    do {
+        last = __atomic_load_n(&drain.running, __ATOMIC_ACQUIRE) ? false : true;
+        do {
+            /* the oldest records first, a marker for records lost in between */
+            n = CANTRC_Drain(&records[1], DRAIN_BATCH, &lost);
+            qsort(&records[1], n, sizeof(CANTRC_Record_t), CompareTime);
+            if (lost) {
+                records[0].time = n ? records[1].time : Nanoseconds(Ticks());
+                records[0].event = CANTRC_RECORDS_LOST;
+                records[0].thread = 0U;
+                records[0].arg[0] = lost;
+                records[0].arg[1] = 0U;
+                drain.lost += lost;
+            }
+            if ((n || lost) && (CANTRC_Write(drain.file, drain.format, lost ? &records[0] : &records[1], lost ? n + 1U : n) != CANUSB_SUCCESS))
+                MACCAN_DEBUG_ERROR("+++ Unable to write trace file (%i)\n", errno);
+            drain.records += n;
+        } while (n == DRAIN_BATCH);
+        if (!last)
+            (void)usleep(DRAIN_INTERVAL);
+    } while (!last);
+    (void)fflush(drain.file);
+    (void)arg;
+    return NULL;
+}
+
+static int CompareTime(const void *a, const void *b) {
+    UInt64 t1 = ((const CANTRC_Record_t*)a)->time;
+    UInt64 t2 = ((const CANTRC_Record_t*)b)->time;
+
+    return (t1 < t2) ? -1 : (t1 > t2) ? 1 : 0;
+}
+
+static UInt64 Ticks(void) {
+#if defined(__APPLE__)
+    /* note: a few ns compared to some tens of ns for clock_gettime */
+    return (UInt64)mach_absolute_time();
+#else
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((UInt64)now.tv_sec * 1000000000ULL) + (UInt64)now.tv_nsec;
+#endif
+}
+
+static UInt64 Nanoseconds(UInt64 ticks) {
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t timebase = { 0U, 0U };
+
+    if (!timebase.denom)
+        (void)mach_timebase_info(&timebase);
+    return ((ticks / timebase.denom) * timebase.numer) + (((ticks % timebase.denom) * timebase.numer) / timebase.denom);
+#else
+    return ticks;
+#endif
+}
+
+/* * $Id$ *** (c) UV Software, Berlin ***
+ */
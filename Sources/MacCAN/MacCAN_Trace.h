@@ -0,0 +1,147 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  MacCAN - macOS User-Space Driver for USB-to-CAN Interfaces
+ *
+ *  Copyright (c) 2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-Core.
+ *
+ *  MacCAN-Core is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-Core IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-Core, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-Core is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-Core is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-Core.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MACCAN_TRACE_H_INCLUDED
+#define MACCAN_TRACE_H_INCLUDED
+
+#include "MacCAN_Common.h"
+
+#include <stdio.h>
+
+/* Trace points (event ids) with their raw argument words
+ */
+#define CANTRC_URB_RECEIVED   0x01U     /* URB received: size, first 8 bytes */
+#define CANTRC_URB_ERROR      0x02U     /* malformed URB: size, index of the error */
+#define CANTRC_CMD_DECODED    0x03U     /* command decoded: length, first 8 bytes */
+#define CANTRC_MSG_ENQUEUED   0x04U     /* CAN message enqueued: id, time-stamp */
+#define CANTRC_MSG_DROPPED    0x05U     /* CAN message dropped (queue full): id, time-stamp */
+#define CANTRC_MSG_DEQUEUED   0x06U     /* CAN message dequeued: id, time-stamp */
+#define CANTRC_USB_WRITE      0x07U     /* USB write: length, first 8 bytes */
+#define CANTRC_USB_FAILED     0x08U     /* USB write failed: length, error code */
+#define CANTRC_TX_ACK         0x09U     /* Tx acknowledge: transaction id, outstanding acks */
+#define CANTRC_RECORDS_LOST   0xFFU     /* records overwritten before drained: number, 0 */
+
+/* Output formats of the drain and of the offline decoder
+ */
+#define CANTRC_FORMAT_BINARY  0         /* raw trace records (for the offline decoder) */
+#define CANTRC_FORMAT_TEXT    1         /* one line per trace record */
+#define CANTRC_FORMAT_JSON    2         /* Chrome trace event format (chrome://tracing, Perfetto) */
+
+/* Number of trace records per thread (power of 2)
+ */
+#ifndef CANTRC_RING_SIZE
+#define CANTRC_RING_SIZE  4096U
+#endif
+
+/* Write trace records into a file (by a background drain)
+ */
+    #ifndef MACCAN_TRACE_FILE
+    #define MACCAN_TRACE_FILE  "mac-can.trace.json"
+    #endif
+    #ifndef MACCAN_TRACE_FORMAT
+    #define MACCAN_TRACE_FORMAT  CANTRC_FORMAT_JSON
+    #endif
+#if (OPTION_MACCAN_TRACE > 0)
+    #define MACCAN_TRACE_OPEN()  CANTRC_Open(NULL, MACCAN_TRACE_FORMAT)
+    #define MACCAN_TRACE_CLOSE()  CANTRC_Close()
+    #define MACCAN_TRACE(evt,arg0,arg1)  do { if (__builtin_expect(CANTRC_Enabled, 0)) \
+                                             CANTRC_Record(evt, (UInt64)(arg0), (UInt64)(arg1)); } while(0)
+#else
+    #define MACCAN_TRACE_OPEN()  while(0)
+    #define MACCAN_TRACE_CLOSE()  while(0)
+    #define MACCAN_TRACE(evt,arg0,arg1)  while(0)
+#endif
+
+typedef struct trc_record_tag {         /* Trace Record (32 bytes): */
+    UInt64 time;                        /* - time-stamp (uptime on macOS) in [ns] */
+    UInt32 event;                       /* - trace point (event id) */
+    UInt32 thread;                      /* - thread number (in order of the first trace point) */
+    UInt64 arg[2];                      /* - raw argument words */
+} CANTRC_Record_t;
+
+typedef int CANTRC_Return_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* note: read by MACCAN_TRACE before the arguments are evaluated */
+extern volatile UInt32 CANTRC_Enabled;
+
+/* start or stop recording (the rings of the threads are kept) */
+extern CANTRC_Return_t CANTRC_Enable(Boolean on);
+
+/* hot path: put one record into the ring of the calling thread (oldest records are overwritten) */
+extern void CANTRC_Record(UInt32 event, UInt64 arg0, UInt64 arg1);
+
+/* helper: up to 8 bytes of a buffer as one argument word (little endian) */
+extern UInt64 CANTRC_Word(const UInt8 *buffer, size_t nbyte);
+
+/* single reader: move up to count records out of the rings of all threads (not sorted by time) */
+extern size_t CANTRC_Drain(CANTRC_Record_t *records, size_t count, UInt64 *lost);
+
+/* format records as text lines or Chrome trace events, or write them in binary */
+extern CANTRC_Return_t CANTRC_Write(FILE *stream, int format, const CANTRC_Record_t *records, size_t count);
+
+/* enable recording and start a background drain into the file (NULL for MACCAN_TRACE_FILE) */
+extern CANTRC_Return_t CANTRC_Open(const char *filename, int format);
+
+/* stop recording, drain the rest and close the file */
+extern CANTRC_Return_t CANTRC_Close(void);
+
+/* offline decoder: convert a binary trace file into text or Chrome trace events */
+extern CANTRC_Return_t CANTRC_Convert(const char *filename, FILE *stream, int format);
+
+extern const char *CANTRC_EventName(UInt32 event);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* MACCAN_TRACE_H_INCLUDED */
+
+/* * $Id$ *** (c) UV Software, Berlin ***
+ */
@@ -68,7 +68,9 @@ static const char version[] = "CAN API V3 for Kvaser CAN Interfaces, Version " V
 #include "can_btr.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <assert.h>
 
 #include "KvaserCAN_Driver.h"
@@ -94,10 +96,26 @@ static void _finalizer() {
 /*  -----------  defines  ------------------------------------------------
  */
 #ifndef KVASER_MAX_HANDLES
-#define KVASER_MAX_HANDLES      (8)     // maximum number of open handles
+#define KVASER_MAX_HANDLES      (CANUSB_MAX_DEVICES * KVASER_MAX_CAN_CHANNELS)
+#endif                                  // maximum number of open handles
+#ifndef CACHE_LINE_SIZE
+#if defined(__arm64__) || defined(__aarch64__)
+#define CACHE_LINE_SIZE         (128)   // Apple silicon
+#else
+#define CACHE_LINE_SIZE         (64)    // Intel x64
+#endif
 #endif
 #define INVALID_HANDLE          (-1)
 #define IS_HANDLE_VALID(hnd)    ((0 <= (hnd)) && ((hnd) < KVASER_MAX_HANDLES))
+#define IS_HANDLE_OPENED(hnd)   ((can[hnd] != NULL) && can[hnd]->device.configured)
+#define ENTER_CRITICAL_SECTION()  (void)pthread_mutex_lock(&mutex)
+#define LEAVE_CRITICAL_SECTION()  (void)pthread_mutex_unlock(&mutex)
+#define SET_STATUS_FLAG(hnd,flag,cond)  \
+                                ((cond) ? (void)__atomic_fetch_or(&can[hnd]->status.byte, (uint8_t)(flag), __ATOMIC_RELAXED) : \
+                                          (void)__atomic_fetch_and(&can[hnd]->status.byte, (uint8_t)~(flag), __ATOMIC_RELAXED))
+#define INC_COUNTER(cnt,cond)   ((cond) ? (void)__atomic_fetch_add(&(cnt), 1U, __ATOMIC_RELAXED) : (void)0)
+#define IS_GAP_MARKER(msg)      ((msg)->sts && (((msg)->id == KVASER_GAP_QUEUE_OVERRUN) || \
+                                                ((msg)->id == KVASER_GAP_DEVICE_OVERRUN)))
 #ifndef DLC2LEN
 #define DLC2LEN(x)              dlc_table[((x) < 16) ? (x) : 15]
 #endif
@@ -124,7 +142,8 @@ typedef struct {                        // Kvaser CAN interface:
     can_mode_t mode;                    //   CAN operation mode
     can_status_t status;                //   8-bit status register
     can_counter_t counters;             //   statistical counters
-}   can_interface_t;
+}   __attribute__((aligned(CACHE_LINE_SIZE))) can_interface_t;
+                                        // note: one cache line (at least) per handle
 
 /*  -----------  prototypes  ---------------------------------------------
  */
@@ -133,7 +152,14 @@ static int map_busparams2bitrate(const KvaserUSB_BusParams_t *busParams, int32_t
 static int map_bitrate2busparams_fd(const can_bitrate_t *bitrate, bool fdoe, bool brse, KvaserUSB_BusParamsFd_t *busParams);
 static int map_busparams2bitrate_fd(const KvaserUSB_BusParamsFd_t *busParams, int32_t canClock, can_bitrate_t *bitrate);
 static int lib_parameter(uint16_t param, void *value, size_t nbyte);
+static int rxt_parameter(uint16_t param, void *value, size_t nbyte);
+static can_interface_t *alloc_interface(void);
+static int test_channel(int32_t channel, uint8_t mode, const void *param, int *result);
+static int init_channel(int32_t channel, uint8_t mode, const void *param);
+static int exit_channel(int handle);
 static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte);
+static bool check_message(int handle, const can_message_t *message);
+static uint8_t map_busstatus2status(KvaserUSB_BusStatus_t busStatus);
 
 /*  -----------  variables  ----------------------------------------------
  */
@@ -152,8 +178,10 @@ can_board_t can_boards[8+1] = {  // list of supported CAN Interfaces
 //static const uint8_t dlc_table[16] = {  // DLC to length
 //    0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64
 //};
-static can_interface_t can[KVASER_MAX_HANDLES]; // interface handles
+static can_interface_t *can[KVASER_MAX_HANDLES]; // interface handles (allocated on demand)
+static int opened = 0;  // number of opened handles
 static int init =  0;  // initialization flag
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;  // for can_test, can_init and can_exit
 
 /*  -----------  functions  ----------------------------------------------
  */
@@ -161,17 +189,20 @@ EXPORT
 int can_test(int32_t channel, uint8_t mode, const void *param, int *result)
 {
     int rc = CANERR_FATAL;              // return value
-    int i;
+
+    ENTER_CRITICAL_SECTION();
+    rc = test_channel(channel, mode, param, result);
+    LEAVE_CRITICAL_SECTION();
+    return rc;
+}
+
+static int test_channel(int32_t channel, uint8_t mode, const void *param, int *result)
+{
+    int rc = CANERR_FATAL;              // return value
 
     if (result)                         // the last resort
         *result = CANBRD_NOT_TESTABLE;
     if (!init) {                        // if not initialized:
-        for (i = 0; i < KVASER_MAX_HANDLES; i++) {
-            memset(&can[i], 0, sizeof(can_interface_t));
-            can[i].device.configured = false;
-            can[i].mode.byte = CANMODE_DEFAULT;
-            can[i].status.byte = CANSTAT_RESET;
-        }
         // initialize the driver (MacCAN-Core driver)
         if ((rc = KvaserCAN_InitializeDriver()) != CANERR_NOERROR)
             return rc;
@@ -192,11 +223,7 @@ int can_test(int32_t channel, uint8_t mode, const void *param, int *result)
     // probe the CAN channel and check it selected operation mode is supported by the CAN controller
     rc = KvaserCAN_ProbeChannel(channel, mode, result);
     // when the music's over, turn out the light
-    for (i = 0; i < KVASER_MAX_HANDLES; i++) {
-        if (can[i].device.configured)
-            break;
-    }
-    if (i == KVASER_MAX_HANDLES) {
+    if (opened == 0) {
         (void)KvaserCAN_TeardownDriver();
         init = 0;
     }
@@ -210,15 +237,18 @@ EXPORT
 int can_init(int32_t channel, uint8_t mode, const void *param)
 {
     int rc = CANERR_FATAL;              // return value
-    int i;
+
+    ENTER_CRITICAL_SECTION();
+    rc = init_channel(channel, mode, param);
+    LEAVE_CRITICAL_SECTION();
+    return rc;
+}
+
+static int init_channel(int32_t channel, uint8_t mode, const void *param)
+{
+    int rc = CANERR_FATAL;              // return value
 
     if (!init) {                        // when not initialized:
-        for (i = 0; i < KVASER_MAX_HANDLES; i++) {
-            memset(&can[i], 0, sizeof(can_interface_t));
-            can[i].device.configured = false;
-            can[i].mode.byte = CANMODE_DEFAULT;
-            can[i].status.byte = CANSTAT_RESET;
-        }
         // initialize the driver (MacCAN-Core driver)
         if ((rc = KvaserCAN_InitializeDriver()) != CANERR_NOERROR)
             return rc;
@@ -237,17 +267,31 @@ int can_init(int32_t channel, uint8_t mode, const void *param)
     // attention: check first CAN FD operation dependent mode flags
     if (!(mode & CANMODE_FDOE) && ((mode & CANMODE_BRSE) || (mode & CANMODE_NISO)))
         return CANERR_ILLPARA;
+    // allocate the interface handle on first use (it is kept for re-use)
+    if (!can[channel] && !(can[channel] = alloc_interface()))
+        return CANERR_RESOURCE;
     // initialize CAN channel with selected operation mode
-    if ((rc = KvaserCAN_InitializeChannel(channel, mode, &can[channel].device)) < CANERR_NOERROR)
+    if ((rc = KvaserCAN_InitializeChannel(channel, mode, &can[channel]->device)) < CANERR_NOERROR)
         return rc;
-    can[channel].mode.byte = mode;      // store selected operation mode
-    can[channel].status.byte = CANSTAT_RESET; // CAN not started yet
+    can[channel]->mode.byte = mode;     // store selected operation mode
+    can[channel]->status.byte = CANSTAT_RESET; // CAN not started yet
+    opened++;                           // one more opened handle
     (void)param;
     return (int)channel;                // return the handle (channel)
 }
 
 EXPORT
 int can_exit(int handle)
+{
+    int rc;                             // return value
+
+    ENTER_CRITICAL_SECTION();
+    rc = exit_channel(handle);
+    LEAVE_CRITICAL_SECTION();
+    return rc;
+}
+
+static int exit_channel(int handle)
 {
     int rc;                             // return value
     int i;
@@ -257,33 +301,31 @@ int can_exit(int handle)
     if (handle != CANEXIT_ALL) {
         if (!IS_HANDLE_VALID(handle))   // must be a valid handle
             return CANERR_HANDLE;
-        if (!can[handle].device.configured) // must be an opened handle
+        if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
             return CANERR_HANDLE;
-        /*if (!can[handle].status.can_stopped) // go to CAN INIT mode (bus off)*/
-            (void)KvaserCAN_CanBusOff(&can[handle].device);
-        if ((rc = KvaserCAN_TeardownChannel(&can[handle].device)) < CANERR_NOERROR)
+        /*if (!can[handle]->status.can_stopped) // go to CAN INIT mode (bus off)*/
+            (void)KvaserCAN_CanBusOff(&can[handle]->device);
+        if ((rc = KvaserCAN_TeardownChannel(&can[handle]->device)) < CANERR_NOERROR)
             return rc;
-        can[handle].status.byte |= CANSTAT_RESET; // CAN controller in INIT state
-        can[handle].device.configured = false;    // handle can be used again
+        can[handle]->status.byte |= CANSTAT_RESET; // CAN controller in INIT state
+        can[handle]->device.configured = false;    // handle can be used again
+        opened--;                                  // one less opened handle
     }
     else {
         for (i = 0; i < KVASER_MAX_HANDLES; i++) {
-            if (can[i].device.configured) // must be an opened handle
+            if (IS_HANDLE_OPENED(i)) // must be an opened handle
             {
-                /*if (!can[handle].status.can_stopped) // go to CAN INIT mode (bus off)*/
-                    (void)KvaserCAN_CanBusOff(&can[i].device);
-                (void)KvaserCAN_TeardownChannel(&can[i].device);
-                can[i].status.byte |= CANSTAT_RESET; // CAN controller in INIT state
-                can[i].device.configured = false;    // handle can be used again
+                /*if (!can[handle]->status.can_stopped) // go to CAN INIT mode (bus off)*/
+                    (void)KvaserCAN_CanBusOff(&can[i]->device);
+                (void)KvaserCAN_TeardownChannel(&can[i]->device);
+                can[i]->status.byte |= CANSTAT_RESET; // CAN controller in INIT state
+                can[i]->device.configured = false;    // handle can be used again
+                opened--;                             // one less opened handle
             }
         }
     }
     // teardown the driver when all interfaces released
-    for (i = 0; i < KVASER_MAX_HANDLES; i++) {
-        if (can[i].device.configured)
-            break;
-    }
-    if (i == KVASER_MAX_HANDLES) {
+    if (opened == 0) {
         (void)KvaserCAN_TeardownDriver();
         init = 0;
     }
@@ -301,15 +343,15 @@ int can_kill(int handle)
     if (handle != CANEXIT_ALL) {
         if (!IS_HANDLE_VALID(handle))   // must be a valid handle
             return CANERR_HANDLE;
-        if (!can[handle].device.configured) // must be an opened handle
+        if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
             return CANERR_HANDLE;
-        if ((rc = KvaserCAN_SignalChannel(&can[handle].device)) < CANERR_NOERROR)
+        if ((rc = KvaserCAN_SignalChannel(&can[handle]->device)) < CANERR_NOERROR)
             return rc;
     }
     else {
         for (i = 0; i < KVASER_MAX_HANDLES; i++) {
-            if (can[i].device.configured) // must be an opened handle
-                (void)KvaserCAN_SignalChannel(&can[i].device);
+            if (IS_HANDLE_OPENED(i)) // must be an opened handle
+                (void)KvaserCAN_SignalChannel(&can[i]->device);
         }
     }
     return CANERR_NOERROR;
@@ -328,21 +370,21 @@ int can_start(int handle, const can_bitrate_t *bitrate)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
     if (bitrate == NULL)                // check for null-pointer
         return CANERR_NULLPTR;
-    if (!can[handle].status.can_stopped) // must be stopped
+    if (!can[handle]->status.can_stopped) // must be stopped
         return CANERR_ONLINE;
 
     memcpy(&tmpBitrate, bitrate, sizeof(can_bitrate_t));
     memset(&busParams, 0, sizeof(KvaserUSB_BusParams_t));
     memset(&busParamsFd, 0, sizeof(KvaserUSB_BusParamsFd_t));
-    bool fdoe = can[handle].mode.fdoe ? true : false;
-    bool brse = can[handle].mode.brse ? true : false;
+    bool fdoe = can[handle]->mode.fdoe ? true : false;
+    bool brse = can[handle]->mode.brse ? true : false;
 
     // CAN 2.0 operation mode:
-    if (!can[handle].mode.fdoe) {
+    if (!can[handle]->mode.fdoe) {
         // (a) check bit-rate settings (possibly after conversion from index)
         if (bitrate->btr.frequency <= 0) {
             // note: bit-rate settings are checked by the conversion function
@@ -357,7 +399,7 @@ int can_start(int handle, const can_bitrate_t *bitrate)
         if (map_bitrate2busparams(&tmpBitrate, &busParams) < 0)
             return CANERR_BAUDRATE;
         // (c) set bit-rate (with respect of the selected operation mode)
-        if ((rc = KvaserCAN_SetBusParams(&can[handle].device, &busParams)) < 0)
+        if ((rc = KvaserCAN_SetBusParams(&can[handle]->device, &busParams)) < 0)
             return (rc != CANUSB_ERROR_ILLPARA) ? rc : CANERR_BAUDRATE;
     }
     // CAN FD operation mode:
@@ -374,18 +416,18 @@ int can_start(int handle, const can_bitrate_t *bitrate)
         if (map_bitrate2busparams_fd(&tmpBitrate, fdoe, brse, &busParamsFd) < 0)
             return CANERR_BAUDRATE;
         // (c) set bit-rate (with respect of the selected operation mode)
-        if ((rc = KvaserCAN_SetBusParamsFd(&can[handle].device, &busParamsFd)) < 0)
+        if ((rc = KvaserCAN_SetBusParamsFd(&can[handle]->device, &busParamsFd)) < 0)
             return (rc != CANUSB_ERROR_ILLPARA) ? rc : CANERR_BAUDRATE;
     }
     // (d) clear status, counters, and the receive queue
-    can[handle].status.byte = CANSTAT_RESET;
-    can[handle].counters.tx = 0U;
-    can[handle].counters.rx = 0U;
-    can[handle].counters.err = 0U;
-    (void)CANQUE_Reset(can[handle].device.recvData.msgQueue);
+    can[handle]->status.byte = CANSTAT_RESET;
+    can[handle]->counters.tx = 0U;
+    can[handle]->counters.rx = 0U;
+    can[handle]->counters.err = 0U;
+    (void)CANQUE_Reset(can[handle]->device.recvData.msgQueue);
     // (e) start the CAN controller with the selected operation mode
-    rc = KvaserCAN_CanBusOn(&can[handle].device, can[handle].mode.mon ? true : false);
-    can[handle].status.can_stopped = (rc == CANUSB_SUCCESS) ? 0 : 1;
+    rc = KvaserCAN_CanBusOn(&can[handle]->device, can[handle]->mode.mon ? true : false);
+    can[handle]->status.can_stopped = (rc == CANUSB_SUCCESS) ? 0 : 1;
     return rc;
 }
 
@@ -398,9 +440,9 @@ int can_reset(int handle)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
-    if (can[handle].status.can_stopped) // must be running
+    if (can[handle]->status.can_stopped) // must be running
 #ifndef OPTION_CANAPI_RETVALS
         return CANERR_OFFLINE;
 #else
@@ -409,8 +451,8 @@ int can_reset(int handle)
         return CANERR_NOERROR;
 #endif
     // stop the CAN controller (INIT state)
-    rc = KvaserCAN_CanBusOff(&can[handle].device);
-    can[handle].status.can_stopped = (rc == CANUSB_SUCCESS) ? 1 : 0;
+    rc = KvaserCAN_CanBusOff(&can[handle]->device);
+    can[handle]->status.can_stopped = (rc == CANUSB_SUCCESS) ? 1 : 0;
     return rc;
 }
 
@@ -423,34 +465,20 @@ int can_write(int handle, const can_message_t *message, uint16_t timeout)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
     if (message == NULL)                // check for null-pointer
         return CANERR_NULLPTR;
-    if (can[handle].status.can_stopped) // must be running
+    if (can[handle]->status.can_stopped) // must be running
         return CANERR_OFFLINE;
 
-    if (message->id > (uint32_t)(message->xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))
-        return CANERR_ILLPARA;          // invalid identifier
-    if (message->xtd && can[handle].mode.nxtd)
-        return CANERR_ILLPARA;          // suppress extended frames
-    if (message->rtr && can[handle].mode.nrtr)
-        return CANERR_ILLPARA;          // suppress remote frames
-    if (message->fdf && !can[handle].mode.fdoe)
-        return CANERR_ILLPARA;          // long frames only with CAN FD
-    if (message->brs && !can[handle].mode.brse)
-        return CANERR_ILLPARA;          // fast frames only with CAN FD
-    if (message->brs && !message->fdf)
-        return CANERR_ILLPARA;          // bit-rate switching only with CAN FD
-    if (message->sts)
-        return CANERR_ILLPARA;          // error frames cannot be sent
-    if (message->dlc > (uint8_t)(message->fdf ? CANFD_MAX_DLC : CAN_MAX_DLC))
-        return CANERR_ILLPARA;          // invalid data length code
+    if (!check_message(handle, message))
+        return CANERR_ILLPARA;          // invalid CAN message
 
     // transmit the given CAN message (w/ or w/o acknowledgment)
-    rc = KvaserCAN_WriteMessage(&can[handle].device, message, timeout);
-    can[handle].status.transmitter_busy = (rc != CANUSB_SUCCESS) ? 1 : 0;
-    can[handle].counters.tx += (rc == CANUSB_SUCCESS) ? 1U : 0U;
+    rc = KvaserCAN_WriteMessage(&can[handle]->device, message, timeout);
+    SET_STATUS_FLAG(handle, CANSTAT_TX_BUSY, rc != CANUSB_SUCCESS);
+    INC_COUNTER(can[handle]->counters.tx, rc == CANUSB_SUCCESS);
     return rc;
 }
 
@@ -463,19 +491,19 @@ int can_read(int handle, can_message_t *message, uint16_t timeout)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
     if (message == NULL)                // check for null-pointer
         return CANERR_NULLPTR;
-    if (can[handle].status.can_stopped) // must be running
+    if (can[handle]->status.can_stopped) // must be running
         return CANERR_OFFLINE;
 
     // read one CAN message from the message queue, if any
-    rc = KvaserCAN_ReadMessage(&can[handle].device, message, timeout);
-    can[handle].status.receiver_empty = (rc != CANUSB_SUCCESS) ? 1 : 0;
-    can[handle].status.queue_overrun = CANQUE_OverflowFlag(can[handle].device.recvData.msgQueue) ? 1 : 0;
-    can[handle].counters.rx += ((rc == CANUSB_SUCCESS) && !message->sts) ? 1U : 0U;
-    can[handle].counters.err += ((rc == CANUSB_SUCCESS) && message->sts) ? 1U : 0U;
+    rc = KvaserCAN_ReadMessage(&can[handle]->device, message, timeout);
+    SET_STATUS_FLAG(handle, CANSTAT_RX_EMPTY, rc != CANUSB_SUCCESS);
+    SET_STATUS_FLAG(handle, CANSTAT_QUE_OVR, CANQUE_OverflowFlag(can[handle]->device.recvData.msgQueue));
+    INC_COUNTER(can[handle]->counters.rx, (rc == CANUSB_SUCCESS) && !message->sts);
+    INC_COUNTER(can[handle]->counters.err, (rc == CANUSB_SUCCESS) && message->sts && !IS_GAP_MARKER(message));
     return rc;
 }
 
@@ -490,19 +518,19 @@ int can_status(int handle, uint8_t *status)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
 
     // get status-register from device
-    if ((rc = KvaserCAN_GetBusStatus(&can[handle].device, &busStatus)) == CANUSB_SUCCESS) {
-        can[handle].status.bus_off = (busStatus & (BUSSTAT_BUSOFF | BUSSTAT_FLAG_BUSOFF))? 1 : 0;
-        can[handle].status.bus_error = (busStatus & (BUSSTAT_FLAG_BUS_ERROR))? 1 : 0;
-        can[handle].status.warning_level = (busStatus & (BUSSTAT_ERROR_PASSIVE | BUSSTAT_FLAG_ERR_PASSIVE))? 1 : 0;
-        // TODO: can[handle].status.message_lost |= (busStatus & canSTAT_RXERR)? 1 : 0;
-        // TODO: can[handle].status.transmitter_busy |= (busStatus & canSTAT_TX_PENDING)? 1 : 0;
+    if ((rc = KvaserCAN_GetBusStatus(&can[handle]->device, &busStatus)) == CANUSB_SUCCESS) {
+        can[handle]->status.bus_off = (busStatus & (BUSSTAT_BUSOFF | BUSSTAT_FLAG_BUSOFF))? 1 : 0;
+        can[handle]->status.bus_error = (busStatus & (BUSSTAT_FLAG_BUS_ERROR))? 1 : 0;
+        can[handle]->status.warning_level = (busStatus & (BUSSTAT_ERROR_PASSIVE | BUSSTAT_FLAG_ERR_PASSIVE))? 1 : 0;
+        // TODO: can[handle]->status.message_lost |= (busStatus & canSTAT_RXERR)? 1 : 0;
+        // TODO: can[handle]->status.transmitter_busy |= (busStatus & canSTAT_TX_PENDING)? 1 : 0;
     }
     if (status)                         // status-register
-      *status = can[handle].status.byte;
+      *status = can[handle]->status.byte;
 
     return rc;
 }
@@ -518,11 +546,11 @@ int can_busload(int handle, uint8_t *load, uint8_t *status)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
 
     // get bus load from device (0..10000 ==> 0%..100%)
-    if ((rc = KvaserCAN_GetBusLoad(&can[handle].device, &busLoad)) == CANUSB_SUCCESS) {
+    if ((rc = KvaserCAN_GetBusLoad(&can[handle]->device, &busLoad)) == CANUSB_SUCCESS) {
         // get status-register from device
         rc = can_status(handle, status);
     }
@@ -547,19 +575,19 @@ int can_bitrate(int handle, can_bitrate_t *bitrate, can_speed_t *speed)
         return CANERR_NOTINIT;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return CANERR_HANDLE;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
 
     memset(&tmpBitrate, 0, sizeof(can_bitrate_t));
     memset(&tmpSpeed, 0, sizeof(can_speed_t));
     memset(&busParams, 0, sizeof(KvaserUSB_BusParams_t));
     memset(&busParamsFd, 0, sizeof(KvaserUSB_BusParamsFd_t));
-    int32_t canClock = (int32_t)can[handle].device.recvData.canClock * (int32_t)1000000;
+    int32_t canClock = (int32_t)can[handle]->device.recvData.canClock * (int32_t)1000000;
 
     // CAN 2.0 operation mode:
-    if (!can[handle].mode.fdoe) {
+    if (!can[handle]->mode.fdoe) {
         // get bit-rate settings from device
-        if ((rc = KvaserCAN_GetBusParams(&can[handle].device, &busParams)) == CANUSB_SUCCESS) {
+        if ((rc = KvaserCAN_GetBusParams(&can[handle]->device, &busParams)) == CANUSB_SUCCESS) {
             if ((rc = map_busparams2bitrate(&busParams, canClock, &tmpBitrate)) == CANUSB_SUCCESS) {
                 rc = btr_bitrate2speed(&tmpBitrate, &tmpSpeed);
             }
@@ -568,7 +596,7 @@ int can_bitrate(int handle, can_bitrate_t *bitrate, can_speed_t *speed)
     // CAN FD operation mode:
     else {
         // get bit-rate settings from device
-        if ((rc = KvaserCAN_GetBusParamsFd(&can[handle].device, &busParamsFd)) == CANUSB_SUCCESS) {
+        if ((rc = KvaserCAN_GetBusParamsFd(&can[handle]->device, &busParamsFd)) == CANUSB_SUCCESS) {
             if ((rc = map_busparams2bitrate_fd(&busParamsFd, canClock, &tmpBitrate)) == CANUSB_SUCCESS) {
                 rc = btr_bitrate2speed(&tmpBitrate, &tmpSpeed);
             }
@@ -581,7 +609,7 @@ int can_bitrate(int handle, can_bitrate_t *bitrate, can_speed_t *speed)
 #ifdef OPTION_CANAPI_RETVALS
     // note: can_bitrate shall return CANERR_OFFLINE when
     //       the CAN controller has not been started
-    if (can[handle].status.can_stopped)
+    if (can[handle]->status.can_stopped)
         rc = CANERR_OFFLINE;
 #endif
     return rc;
@@ -596,7 +624,7 @@ int can_property(int handle, uint16_t param, void *value, uint32_t nbyte)
     }
     // note: library is initialized and handle is valid
 
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return CANERR_HANDLE;
     // note: device properties must be queried with a valid handle
     return drv_parameter(handle, param, value, (size_t)nbyte);
@@ -611,17 +639,17 @@ char *can_hardware(int handle)
         return NULL;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return NULL;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return NULL;
 
     // get hardware version (zero-terminated string)
-    uint8_t major = (uint8_t)can[handle].device.deviceInfo.card.hwRevision;
+    uint8_t major = (uint8_t)can[handle]->device.deviceInfo.card.hwRevision;
     uint8_t minor = (uint8_t)0;
 #if (0)
-    sprintf(string, "%s, hardware revision %u.%u", can[handle].device.name, major, minor);
+    sprintf(string, "%s, hardware revision %u.%u", can[handle]->device.name, major, minor);
 #else
-    uint8_t type = (uint8_t)can[handle].device.deviceInfo.card.hwType;
-    sprintf(string, "%s, hardware revision %u.%u (type %u)", can[handle].device.name, major, minor, type);
+    uint8_t type = (uint8_t)can[handle]->device.deviceInfo.card.hwType;
+    sprintf(string, "%s, hardware revision %u.%u (type %u)", can[handle]->device.name, major, minor, type);
 #endif
     return string;
 }
@@ -635,17 +663,17 @@ char *can_software(int handle)
         return NULL;
     if (!IS_HANDLE_VALID(handle))       // must be a valid handle
         return NULL;
-    if (!can[handle].device.configured) // must be an opened handle
+    if (!IS_HANDLE_OPENED(handle)) // must be an opened handle
         return NULL;
 
     // get software version (zero-terminated string)
-    uint8_t major = (uint8_t)(can[handle].device.deviceInfo.software.firmwareVersion >> 24);
-    uint8_t minor = (uint8_t)(can[handle].device.deviceInfo.software.firmwareVersion >> 16);
+    uint8_t major = (uint8_t)(can[handle]->device.deviceInfo.software.firmwareVersion >> 24);
+    uint8_t minor = (uint8_t)(can[handle]->device.deviceInfo.software.firmwareVersion >> 16);
 #if (0)
-    sprintf(string, "%s, firmware version %u.%u", can[handle].device.name, major, minor);
+    sprintf(string, "%s, firmware version %u.%u", can[handle]->device.name, major, minor);
 #else
-    uint16_t build = (uint16_t)(can[handle].device.deviceInfo.software.firmwareVersion >> 0);
-    sprintf(string, "%s, firmware version %u.%u (build %u)", can[handle].device.name, major, minor, build);
+    uint16_t build = (uint16_t)(can[handle]->device.deviceInfo.software.firmwareVersion >> 0);
+    sprintf(string, "%s, firmware version %u.%u (build %u)", can[handle]->device.name, major, minor, build);
 #endif
     return string;
 }
@@ -800,6 +828,20 @@ static int map_busparams2bitrate_fd(const KvaserUSB_BusParamsFd_t *busParams, in
 
 /*  - - - - - -  CAN API V3 properties  - - - - - - - - - - - - - - - - -
  */
+static can_interface_t *alloc_interface(void)
+{
+    can_interface_t *interface = NULL;
+
+    // note: cache-line aligned to avoid false sharing between the handles
+    if (posix_memalign((void**)&interface, CACHE_LINE_SIZE, sizeof(can_interface_t)) != 0)
+        return NULL;
+    memset(interface, 0, sizeof(can_interface_t));
+    interface->device.configured = false;
+    interface->mode.byte = CANMODE_DEFAULT;
+    interface->status.byte = CANSTAT_RESET;
+    return interface;
+}
+
 static int lib_parameter(uint16_t param, void *value, size_t nbyte)
 {
     int rc = CANERR_ILLPARA;            // suppose an invalid parameter
@@ -961,6 +1003,102 @@ static int lib_parameter(uint16_t param, void *value, size_t nbyte)
         else
             rc = CANERR_HANDLE;
         break;
+    default:
+        if ((CANPROP_GET_VENDOR_PROP <= param) &&  // vendor-specific library properties
+           (param < (CANPROP_SET_VENDOR_PROP + CANPROP_VENDOR_PROP_RANGE)))
+            rc = rxt_parameter(param, value, nbyte);
+        else
+            rc = CANERR_NOTSUPP;
+        break;
+    }
+    return rc;
+}
+
+static int rxt_parameter(uint16_t param, void *value, size_t nbyte)
+{
+    int rc = CANERR_ILLPARA;            // suppose an invalid parameter
+    CANUSB_ThreadParam_t rxThread;
+
+    assert(value);                      // just to make sure
+    (void)CANUSB_GetThreadParam(&rxThread);
+
+    /* reception thread(s): can be read always, but only be set before can_init */
+    switch (param) {
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_THREAD_MODE:
+        if (nbyte >= sizeof(uint8_t)) {
+            *(uint8_t*)value = (uint8_t)rxThread.mode;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_THREAD_POOL:
+        if (nbyte >= sizeof(uint8_t)) {
+            *(uint8_t*)value = (uint8_t)rxThread.poolSize;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_SCHED_POLICY:
+        if (nbyte >= sizeof(int32_t)) {
+            *(int32_t*)value = (int32_t)rxThread.policy;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_SCHED_PRIORITY:
+        if (nbyte >= sizeof(int32_t)) {
+            *(int32_t*)value = (int32_t)rxThread.priority;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_CPU_AFFINITY:
+        if (nbyte >= sizeof(uint64_t)) {
+            *(uint64_t*)value = (uint64_t)rxThread.cpuMask;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_LOCK_MEMORY:
+        if (nbyte >= sizeof(uint8_t)) {
+            *(uint8_t*)value = (uint8_t)(rxThread.lockMemory ? 1 : 0);
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_THREAD_MODE:
+        if (nbyte >= sizeof(uint8_t)) {
+            rxThread.mode = *(uint8_t*)value;
+            if ((rxThread.mode == CANUSB_RXTHREAD_POOL) && (rxThread.poolSize == 0U))
+                rxThread.poolSize = 2U;
+            rc = CANUSB_SetThreadParam(&rxThread);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_THREAD_POOL:
+        if (nbyte >= sizeof(uint8_t)) {
+            rxThread.poolSize = *(uint8_t*)value;
+            rc = CANUSB_SetThreadParam(&rxThread);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_SCHED_POLICY:
+        if (nbyte >= sizeof(int32_t)) {
+            rxThread.policy = (int)*(int32_t*)value;
+            rxThread.priority = 0;  // note: priority range depends on the policy
+            rc = CANUSB_SetThreadParam(&rxThread);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_SCHED_PRIORITY:
+        if (nbyte >= sizeof(int32_t)) {
+            rxThread.priority = (int)*(int32_t*)value;
+            rc = CANUSB_SetThreadParam(&rxThread);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_CPU_AFFINITY:
+        if (nbyte >= sizeof(uint64_t)) {
+            rxThread.cpuMask = (UInt64)*(uint64_t*)value;
+            rc = CANUSB_SetThreadParam(&rxThread);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_LOCK_MEMORY:
+        if (nbyte >= sizeof(uint8_t)) {
+            rxThread.lockMemory = (*(uint8_t*)value != 0) ? true : false;
+            rc = CANUSB_SetThreadParam(&rxThread);
+        }
+        break;
     default:
         rc = CANERR_NOTSUPP;
         break;
@@ -968,6 +1106,42 @@ static int lib_parameter(uint16_t param, void *value, size_t nbyte)
     return rc;
 }
 
+static uint8_t map_busstatus2status(KvaserUSB_BusStatus_t busStatus)
+{
+    can_status_t status;
+
+    // note: same mapping as in can_status (Leaf and Mhydra bus status)
+    status.byte = 0x00U;
+    status.bus_off = (busStatus & (BUSSTAT_BUSOFF | BUSSTAT_FLAG_BUSOFF))? 1 : 0;
+    status.bus_error = (busStatus & (BUSSTAT_FLAG_BUS_ERROR))? 1 : 0;
+    status.warning_level = (busStatus & (BUSSTAT_ERROR_PASSIVE | BUSSTAT_FLAG_ERR_PASSIVE))? 1 : 0;
+    return status.byte;
+}
+
+static bool check_message(int handle, const can_message_t *message)
+{
+    assert(IS_HANDLE_VALID(handle));    // just to make sure
+    assert(message);
+
+    if (message->id > (uint32_t)(message->xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))
+        return false;                   // invalid identifier
+    if (message->xtd && can[handle]->mode.nxtd)
+        return false;                   // suppress extended frames
+    if (message->rtr && can[handle]->mode.nrtr)
+        return false;                   // suppress remote frames
+    if (message->fdf && !can[handle]->mode.fdoe)
+        return false;                   // long frames only with CAN FD
+    if (message->brs && !can[handle]->mode.brse)
+        return false;                   // fast frames only with CAN FD
+    if (message->brs && !message->fdf)
+        return false;                   // bit-rate switching only with CAN FD
+    if (message->sts)
+        return false;                   // error frames cannot be sent
+    if (message->dlc > (uint8_t)(message->fdf ? CANFD_MAX_DLC : CAN_MAX_DLC))
+        return false;                   // invalid data length code
+    return true;
+}
+
 static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
 {
     int rc = CANERR_ILLPARA;            // suppose an invalid parameter
@@ -986,19 +1160,19 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
     switch (param) {
     case CANPROP_GET_DEVICE_TYPE:       // device type of the CAN interface (int32_t)
         if (nbyte >= sizeof(int32_t)) {
-            *(int32_t*)value = (int32_t)can[handle].device.deviceInfo.card.hwType;
+            *(int32_t*)value = (int32_t)can[handle]->device.deviceInfo.card.hwType;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_DEVICE_NAME:       // device name of the CAN interface (char[256])
-        if ((nbyte > strlen(can[handle].device.name)) && (nbyte <= CANPROP_MAX_BUFFER_SIZE)) {
-            strcpy((char*)value, can[handle].device.name);
+        if ((nbyte > strlen(can[handle]->device.name)) && (nbyte <= CANPROP_MAX_BUFFER_SIZE)) {
+            strcpy((char*)value, can[handle]->device.name);
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_DEVICE_VENDOR:     // vendor name of the CAN interface (char[256])
-        if ((nbyte > strlen(can[handle].device.vendor)) && (nbyte <= CANPROP_MAX_BUFFER_SIZE)) {
-            strcpy((char*)value, can[handle].device.vendor);
+        if ((nbyte > strlen(can[handle]->device.vendor)) && (nbyte <= CANPROP_MAX_BUFFER_SIZE)) {
+            strcpy((char*)value, can[handle]->device.vendor);
             rc = CANERR_NOERROR;
         }
         break;
@@ -1010,13 +1184,13 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
         break;
     case CANPROP_GET_OP_CAPABILITY:     // supported operation modes of the CAN controller (uint8_t)
         if (nbyte >= sizeof(uint8_t)) {
-            *(uint8_t*)value = (uint8_t)can[handle].device.opCapability;
+            *(uint8_t*)value = (uint8_t)can[handle]->device.opCapability;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_OP_MODE:           // active operation mode of the CAN controller (uint8_t)
         if (nbyte >= sizeof(uint8_t)) {
-            *(uint8_t*)value = (uint8_t)can[handle].mode.byte;
+            *(uint8_t*)value = (uint8_t)can[handle]->mode.byte;
             rc = CANERR_NOERROR;
         }
         break;
@@ -1047,7 +1221,7 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
     case CANPROP_GET_BUSLOAD:           // current bus load of the CAN controller (uint16_t)
         if (nbyte >= sizeof(uint8_t)) {
             KvaserUSB_BusLoad_t load = 0U;
-            if ((rc = KvaserCAN_GetBusLoad(&can[handle].device, &load)) == CANERR_NOERROR) {
+            if ((rc = KvaserCAN_GetBusLoad(&can[handle]->device, &load)) == CANERR_NOERROR) {
                 if (nbyte > sizeof(uint8_t))
                     *(uint16_t*)value = (uint16_t)load;       // 0..10000 ==> 0.00%..100%
                 else
@@ -1058,63 +1232,303 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
         break;
     case CANPROP_GET_NUM_CHANNELS:      // numbers of CAN channels on the CAN interface (uint8_t)
         if (nbyte >= sizeof(uint8_t)) {
-            *(uint8_t*)value = (uint8_t)can[handle].device.numChannels;
+            *(uint8_t*)value = (uint8_t)can[handle]->device.numChannels;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_CAN_CHANNEL:       // active CAN channel on the CAN interface (uint8_t)
         if (nbyte >= sizeof(uint8_t)) {
-            *(uint8_t*)value = (uint8_t)can[handle].device.channelNo;
+            *(uint8_t*)value = (uint8_t)can[handle]->device.channelNo;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_CAN_CLOCK:         // frequency of the CAN controller clock in [Hz] (int32_t)
         if (nbyte >= sizeof(int32_t)) {
-            *(int32_t*)value = (int32_t)can[handle].device.recvData.canClock * 1000000;
+            *(int32_t*)value = (int32_t)can[handle]->device.recvData.canClock * 1000000;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_TX_COUNTER:        // total number of sent messages (uint64_t)
         if (nbyte >= sizeof(uint64_t)) {
-            *(uint64_t*)value = (uint64_t)can[handle].counters.tx;
+            *(uint64_t*)value = (uint64_t)can[handle]->counters.tx;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_RX_COUNTER:        // total number of reveiced messages (uint64_t)
         if (nbyte >= sizeof(uint64_t)) {
-            *(uint64_t*)value = (uint64_t)can[handle].counters.rx;
+            *(uint64_t*)value = (uint64_t)can[handle]->counters.rx;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_ERR_COUNTER:       // total number of reveiced error frames (uint64_t)
         if (nbyte >= sizeof(uint64_t)) {
-            *(uint64_t*)value = (uint64_t)can[handle].counters.err;
+            *(uint64_t*)value = (uint64_t)can[handle]->counters.err;
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_RCV_QUEUE_SIZE:    // maximum number of message the receive queue can hold (uint32_t)
         if (nbyte >= sizeof(uint32_t)) {
-            *(uint32_t*)value = (uint32_t)CANQUE_QueueSize(can[handle].device.recvData.msgQueue);
+            *(uint32_t*)value = (uint32_t)CANQUE_QueueSize(can[handle]->device.recvData.msgQueue);
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_RCV_QUEUE_HIGH:    // maximum number of message the receive queue has hold (uint32_t)
         if (nbyte >= sizeof(uint32_t)) {
-            *(uint32_t*)value = (uint32_t)CANQUE_QueueHigh(can[handle].device.recvData.msgQueue);
+            *(uint32_t*)value = (uint32_t)CANQUE_QueueHigh(can[handle]->device.recvData.msgQueue);
             rc = CANERR_NOERROR;
         }
         break;
     case CANPROP_GET_RCV_QUEUE_OVFL:    // overflow counter of the receive queue (uint64_t)
         if (nbyte >= sizeof(uint64_t)) {
-            *(uint64_t*)value = (uint64_t)CANQUE_OverflowCounter(can[handle].device.recvData.msgQueue);
+            *(uint64_t*)value = (uint64_t)CANQUE_OverflowCounter(can[handle]->device.recvData.msgQueue);
             rc = CANERR_NOERROR;
         }
         break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_WAIT_MODE:  // can_read wait mode (uint8_t)
+        if (nbyte >= sizeof(uint8_t)) {
+            rc = CANQUE_GetWaitMode(can[handle]->device.recvData.msgQueue, (UInt8*)value, NULL);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_SPIN_TIME:  // spin time before blocking in [usec] (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            rc = CANQUE_GetWaitMode(can[handle]->device.recvData.msgQueue, NULL, (UInt32*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_WAIT_MODE:  // set can_read wait mode (uint8_t)
+        if (nbyte >= sizeof(uint8_t)) {
+            uint32_t spinTime = 0U;
+            (void)CANQUE_GetWaitMode(can[handle]->device.recvData.msgQueue, NULL, (UInt32*)&spinTime);
+            rc = CANQUE_SetWaitMode(can[handle]->device.recvData.msgQueue, *(uint8_t*)value, (UInt32)spinTime);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_SPIN_TIME:  // set spin time before blocking in [usec] (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            uint8_t waitMode = CANQUE_WAIT_BLOCK;
+            (void)CANQUE_GetWaitMode(can[handle]->device.recvData.msgQueue, (UInt8*)&waitMode, NULL);
+            rc = CANQUE_SetWaitMode(can[handle]->device.recvData.msgQueue, waitMode, (UInt32)*(uint32_t*)value);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_GAP_MARKERS:  // gap markers in the reception queue (uint8_t)
+        if (nbyte >= sizeof(uint8_t)) {
+            bool enabled = false;
+            if ((rc = KvaserCAN_GetGapMarkers(&can[handle]->device, &enabled)) == CANERR_NOERROR)
+                *(uint8_t*)value = enabled ? 1U : 0U;
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_GAP_MARKERS:  // set gap markers in the reception queue, 0 = off (uint8_t)
+        if (nbyte >= sizeof(uint8_t)) {
+            rc = KvaserCAN_SetGapMarkers(&can[handle]->device, (*(uint8_t*)value != 0U) ? true : false);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_SAMPLER_INTERVAL:  // bus load and status sampler interval in [ms] (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            rc = KvaserCAN_GetSamplerInterval(&can[handle]->device, (uint32_t*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_SAMPLER_INTERVAL:  // set sampler interval in [ms], 0 = off (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            // note: the interval takes effect with the next can_start
+            rc = KvaserCAN_SetSamplerInterval(&can[handle]->device, *(uint32_t*)value);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_MIN:  // min. bus load within the sampler window (uint16_t)
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_MAX:  // max. bus load within the sampler window (uint16_t)
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_AVG:  // average bus load within the sampler window (uint16_t)
+        if (nbyte >= sizeof(uint16_t)) {
+            KvaserUSB_BusSample_t sample;
+            if ((rc = KvaserCAN_GetBusSample(&can[handle]->device, &sample)) == CANERR_NOERROR) {
+                if (param == (CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_MIN))
+                    *(uint16_t*)value = (uint16_t)sample.minLoad;
+                else if (param == (CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_MAX))
+                    *(uint16_t*)value = (uint16_t)sample.maxLoad;
+                else
+                    *(uint16_t*)value = (uint16_t)sample.avgLoad;
+            }
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_TX_BATCH:  // send up to 16 CAN messages in one USB transfer (can_message_t[])
+        if ((nbyte >= sizeof(can_message_t)) && ((nbyte % sizeof(can_message_t)) == 0U) &&
+            ((nbyte / sizeof(can_message_t)) <= KVASER_MAX_TX_BATCH)) {
+            const can_message_t *messages = (const can_message_t*)value;
+            uint32_t count = (uint32_t)(nbyte / sizeof(can_message_t));
+            uint32_t i;
+            if (can[handle]->status.can_stopped) {
+                rc = CANERR_OFFLINE;    // must be running
+                break;
+            }
+            for (i = 0U; i < count; i++) {
+                if (!check_message(handle, &messages[i]))
+                    break;
+            }
+            if (i < count)              // invalid CAN message
+                break;
+            // note: all or nothing, CANERR_TX_BUSY when the transmit window is too small
+            rc = KvaserCAN_WriteMessages(&can[handle]->device, messages, count);
+            SET_STATUS_FLAG(handle, CANSTAT_TX_BUSY, rc != CANUSB_SUCCESS);
+            if (rc == CANUSB_SUCCESS)
+                (void)__atomic_fetch_add(&can[handle]->counters.tx, (uint64_t)count, __ATOMIC_RELAXED);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_PATH_COUNTERS:  // snapshot of the hot-path counters (uint64_t[])
+        if (nbyte >= (sizeof(uint64_t) * KVASER_PATH_COUNTERS)) {
+            KvaserUSB_PathCounters_t counters;
+            uint64_t *snapshot = (uint64_t*)value;
+            if ((rc = KvaserCAN_GetPathCounters(&can[handle]->device, &counters)) == CANERR_NOERROR) {
+                snapshot[KVASER_PATH_URBS_RECEIVED] = counters.urb.urbs;
+                snapshot[KVASER_PATH_BYTES_DECODED] = counters.urb.bytes;
+                snapshot[KVASER_PATH_DECODE_ERRORS] = counters.urb.errors;
+                snapshot[KVASER_PATH_UNKNOWN_CMDS] = counters.urb.unknown;
+                snapshot[KVASER_PATH_REASSEMBLIES] = counters.urb.splits;
+                snapshot[KVASER_PATH_QUEUE_HIGH] = counters.queueHigh;
+                snapshot[KVASER_PATH_QUEUE_OVERFLOWS] = counters.queueOverflows;
+                snapshot[KVASER_PATH_LOCK_WAITS] = counters.lockWaits;
+                snapshot[KVASER_PATH_LOCK_WAIT_TIME] = counters.lockWaitTime;
+                snapshot[KVASER_PATH_TX_PENDING] = counters.txPending;
+                snapshot[KVASER_PATH_WRITE_FAILURES] = counters.writeFailures;
+            }
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_PATH_RESET:  // reset the hot-path counters (uint8_t, any value)
+        if (nbyte >= sizeof(uint8_t)) {
+            // note: the CAN channel keeps running
+            rc = KvaserCAN_ResetPathCounters(&can[handle]->device);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_HOST:  // bus load computed on the host from the CAN frames (uint16_t)
+        if (nbyte >= sizeof(uint16_t)) {
+            KvaserUSB_BusLoad_t load = 0U;
+            if ((rc = KvaserCAN_GetHostBusLoad(&can[handle]->device, &load)) == CANERR_NOERROR)
+                *(uint16_t*)value = (uint16_t)load;
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUS_EVENTS:  // read bus events, unused entries are zeroed (kvaser_bus_event_t[])
+        if ((nbyte >= sizeof(kvaser_bus_event_t)) && ((nbyte % sizeof(kvaser_bus_event_t)) == 0U)) {
+            kvaser_bus_event_t *events = (kvaser_bus_event_t*)value;
+            uint32_t count = (uint32_t)(nbyte / sizeof(kvaser_bus_event_t));
+            KvaserUSB_BusEvent_t buffer[16];
+            uint32_t i = 0U, n = 0U, j, m;
+            // note: the events are read in batches from the queue, the USB pipe is not touched
+            do {
+                m = ((count - i) < 16U) ? (count - i) : 16U;
+                if ((rc = KvaserCAN_ReadBusEvents(&can[handle]->device, buffer, m, &n)) != CANUSB_SUCCESS)
+                    break;
+                for (j = 0U; j < n; j++, i++) {
+                    events[i].timestamp = ((uint64_t)buffer[j].timestamp.tv_sec * 1000000000ULL) +
+                                          (uint64_t)buffer[j].timestamp.tv_nsec;
+                    events[i].type = buffer[j].type;
+                    events[i].prevStatus = map_busstatus2status(buffer[j].prevStatus);
+                    events[i].status = map_busstatus2status(buffer[j].busStatus);
+                    events[i].txErrors = buffer[j].txErrorCounter;
+                    events[i].rxErrors = buffer[j].rxErrorCounter;
+                    events[i].errorCode = buffer[j].errorCode;
+                    events[i]._reserved = 0U;
+                }
+            } while ((n == m) && (i < count));
+            if (rc == CANUSB_SUCCESS)
+                memset(&events[i], 0, (size_t)(count - i) * sizeof(kvaser_bus_event_t));
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUS_EVENTS_LOST:  // number of bus events lost (uint64_t)
+        if (nbyte >= sizeof(uint64_t)) {
+            rc = KvaserCAN_GetLostEvents(&can[handle]->device, (uint64_t*)value);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_CAPACITY:  // flight recorder: ring size in CAN frames (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            rc = KvaserCAN_GetFlightCapacity(&can[handle]->device, (uint32_t*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_CAPACITY:  // set ring size in CAN frames, 0 = off (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            if (!can[handle]->status.can_stopped) {
+                rc = CANERR_ONLINE;     // must be stopped
+                break;
+            }
+            rc = KvaserCAN_SetFlightCapacity(&can[handle]->device, *(uint32_t*)value);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_PRE_TIME:  // flight recorder: pre-trigger window in [ms] (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            rc = KvaserCAN_GetFlightWindow(&can[handle]->device, (uint32_t*)value, NULL);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_POST_TIME:  // flight recorder: post-trigger window in [ms] (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            rc = KvaserCAN_GetFlightWindow(&can[handle]->device, NULL, (uint32_t*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_PRE_TIME:  // set pre-trigger window in [ms] (uint32_t)
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_POST_TIME:  // set post-trigger window in [ms] (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            uint32_t preTime = 0U, postTime = 0U;
+            if ((rc = KvaserCAN_GetFlightWindow(&can[handle]->device, &preTime, &postTime)) != CANERR_NOERROR)
+                break;
+            if (param == (CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_PRE_TIME))
+                preTime = *(uint32_t*)value;
+            else
+                postTime = *(uint32_t*)value;
+            // note: the window takes effect with the next trigger
+            rc = KvaserCAN_SetFlightWindow(&can[handle]->device, preTime, postTime);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_TRIGGERS:  // flight recorder: trigger conditions (uint8_t)
+        if (nbyte >= sizeof(uint8_t)) {
+            rc = KvaserCAN_GetFlightTriggers(&can[handle]->device, (uint8_t*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_TRIGGERS:  // set trigger conditions (uint8_t)
+        if (nbyte >= sizeof(uint8_t)) {
+            rc = KvaserCAN_SetFlightTriggers(&can[handle]->device, *(uint8_t*)value);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_MATCH:  // flight recorder: pattern for the ID match (can_message_t)
+        if (nbyte >= sizeof(can_message_t)) {
+            rc = KvaserCAN_GetFlightMatch(&can[handle]->device, (can_message_t*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_MATCH:  // set pattern for the ID match (can_message_t)
+        if (nbyte >= sizeof(can_message_t)) {
+            if (!can[handle]->status.can_stopped) {
+                rc = CANERR_ONLINE;     // must be stopped
+                break;
+            }
+            rc = KvaserCAN_SetFlightMatch(&can[handle]->device, (const can_message_t*)value);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_FILE:  // flight recorder: path prefix of the capture files (char[])
+        if ((nbyte > 0U) && (nbyte <= CANPROP_MAX_BUFFER_SIZE)) {
+            rc = KvaserCAN_GetFlightFile(&can[handle]->device, (char*)value, (size_t)nbyte);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_FILE:  // set path prefix of the capture files (char[])
+        if ((nbyte > 0U) && (nbyte <= CANPROP_MAX_BUFFER_SIZE) && memchr(value, '\0', (size_t)nbyte)) {
+            if (!can[handle]->status.can_stopped) {
+                rc = CANERR_ONLINE;     // must be stopped
+                break;
+            }
+            rc = KvaserCAN_SetFlightFile(&can[handle]->device, (const char*)value);
+        }
+        break;
+    case CANPROP_SET_VENDOR_PROP + KVASER_PROP_FLIGHT_TRIGGER:  // trigger a capture (uint8_t, any value)
+        if (nbyte >= sizeof(uint8_t)) {
+            if (can[handle]->status.can_stopped) {
+                rc = CANERR_OFFLINE;    // must be running
+                break;
+            }
+            // note: only the first trigger counts until the capture file is written
+            rc = KvaserCAN_TriggerFlightRecorder(&can[handle]->device);
+        }
+        break;
+    case CANPROP_GET_VENDOR_PROP + KVASER_PROP_FLIGHT_CAPTURES:  // flight recorder: number of capture files written (uint32_t)
+        if (nbyte >= sizeof(uint32_t)) {
+            rc = KvaserCAN_GetFlightCaptures(&can[handle]->device, (uint32_t*)value);
+        }
+        break;
     default:
 #if (0)
         if ((CANPROP_GET_VENDOR_PROP <= param) &&  // get a vendor-specific property value (void*)
            (param < (CANPROP_GET_VENDOR_PROP + CANPROP_VENDOR_PROP_RANGE))) {
-            if ((sts = canIoCtl(can[handle].handle, (unsigned int)(param - CANPROP_GET_VENDOR_PROP),
+            if ((sts = canIoCtl(can[handle]->handle, (unsigned int)(param - CANPROP_GET_VENDOR_PROP),
                                                            (void*)value, (DWORD)nbyte)) == canOK)
                 rc = CANERR_NOERROR;
             else
@@ -1122,7 +1536,7 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
         }
         else if ((CANPROP_SET_VENDOR_PROP <= param) &&  // set a vendor-specific property value (void*)
                 (param < (CANPROP_SET_VENDOR_PROP + CANPROP_VENDOR_PROP_RANGE))) {
-            if ((sts = canIoCtl(can[handle].handle, (unsigned int)(param - CANPROP_SET_VENDOR_PROP),
+            if ((sts = canIoCtl(can[handle]->handle, (unsigned int)(param - CANPROP_SET_VENDOR_PROP),
                                                            (void*)value, (DWORD)nbyte)) == canOK)
                 rc = CANERR_NOERROR;
             else
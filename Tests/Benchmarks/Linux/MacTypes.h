@@ -0,0 +1,42 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  MacTypes.h - the few macOS basic types used by the portable MacCAN sources
+//
+//  Only for building the benchmarks of OS-independent MacCAN modules (e.g. the
+//  message queue) on Linux.  On macOS the header of the SDK is used.
+//
+#ifndef MACTYPES_H_INCLUDED
+#define MACTYPES_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t  UInt8;
+typedef int8_t   SInt8;
+typedef uint16_t UInt16;
+typedef int16_t  SInt16;
+typedef uint32_t UInt32;
+typedef int32_t  SInt32;
+typedef uint64_t UInt64;
+typedef int64_t  SInt64;
+typedef unsigned char Boolean;
+
+#endif /* MACTYPES_H_INCLUDED */
@@ -0,0 +1,144 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_bitrate - searches bit-timing settings (bit-timing solver of can_btr)
+//
+//  usage: bench_bitrate [-n <searches>] [-t <ppm>] [-s <samplepoint>]
+//
+//  Searches the bit-timing candidates for common nominal bit-rates and CAN FD
+//  data bit-rates at 24 MHz and 80 MHz controller clock (Kvaser Leaf and
+//  Mercury/Hydra).  Every search is done N times with an empty cache (cold)
+//  and N times with the solution cached (warm), and the mean duration of one
+//  search is reported together with the best candidate.  Option -t sets the
+//  bit-rate tolerance in ppm (default 0 = exact), option -s sets the sample-
+//  point in 0.01% (default 8000).
+//
+#include "can_btr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+typedef struct {
+    int32_t frequency;
+    uint32_t bitrate;
+    bool data;
+} search_t;
+
+static const search_t search[] = {
+    { BTR_FREQ_24MHz, 1000000U, false },
+    { BTR_FREQ_24MHz,  500000U, false },
+    { BTR_FREQ_24MHz,  250000U, false },
+    { BTR_FREQ_24MHz,  125000U, false },
+    { BTR_FREQ_24MHz,   83333U, false },
+    { BTR_FREQ_24MHz,   10000U, false },
+    { BTR_FREQ_80MHz, 1000000U, false },
+    { BTR_FREQ_80MHz,  500000U, false },
+    { BTR_FREQ_80MHz,  250000U, false },
+    { BTR_FREQ_80MHz,  125000U, false },
+    { BTR_FREQ_80MHz,   83333U, false },
+    { BTR_FREQ_80MHz,   10000U, false },
+    { BTR_FREQ_80MHz, 8000000U, true },
+    { BTR_FREQ_80MHz, 5000000U, true },
+    { BTR_FREQ_80MHz, 4000000U, true },
+    { BTR_FREQ_80MHz, 2000000U, true },
+    { BTR_FREQ_80MHz, 1000000U, true }
+};
+#define NUM_SEARCHES  (sizeof(search) / sizeof(search[0]))
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    btr_candidate_t candidate[BTR_SOLVER_CANDIDATES];
+    btr_target_t target;
+    uint64_t t0, cold, warm;
+    size_t count = 0U;
+    long searches = 10000L, tolerance = 0L, samplepoint = 8000L;
+    long n;
+    int opt, rc = BTRERR_NOERROR;
+    unsigned int i;
+
+    while ((opt = getopt(argc, argv, "n:t:s:h")) != -1) {
+        switch (opt) {
+            case 'n': searches = atol(optarg); break;
+            case 't': tolerance = atol(optarg); break;
+            case 's': samplepoint = atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n <searches>] [-t <ppm>] [-s <samplepoint>]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((searches < 1L) || (tolerance < 0L) || (tolerance >= 1000000L) ||
+        (samplepoint < 1L) || (samplepoint >= 10000L)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "Searches: %li, tolerance: %lippm, sample-point: %.2f%%\n",
+            searches, tolerance, (double)samplepoint / 100.0);
+    fprintf(stdout, "Clock  Phase   Bit-rate  Count  Cold[ns]  Warm[ns]   BRP TSEG1 TSEG2 SJW  Err[ppm]  SP[%%]\n");
+
+    for (i = 0U; i < NUM_SEARCHES; i++) {
+        btr_limits_t nominal = BTR_NOMINAL_LIMITS(search[i].frequency);
+        btr_limits_t data = BTR_DATA_LIMITS(search[i].frequency);
+        const btr_limits_t *limits = search[i].data ? &data : &nominal;
+
+        target.bitrate = search[i].bitrate;
+        target.samplepoint = (uint16_t)samplepoint;
+        target.sjw = BTR_SJW_MAXIMUM;
+        target.tolerance = (uint32_t)tolerance;
+
+        /* cold: search the candidates (empty cache) */
+        cold = 0U;
+        for (n = 0L; n < searches; n++) {
+            (void)btr_flush_solutions();
+            count = BTR_SOLVER_CANDIDATES;
+            t0 = nanoseconds();
+            rc = btr_solve_bitrate(limits, &target, candidate, &count);
+            cold += nanoseconds() - t0;
+        }
+        /* warm: lookup the candidates (cached solution) */
+        t0 = nanoseconds();
+        for (n = 0L; n < searches; n++) {
+            count = BTR_SOLVER_CANDIDATES;
+            rc = btr_solve_bitrate(limits, &target, candidate, &count);
+        }
+        warm = nanoseconds() - t0;
+
+        fprintf(stdout, "%2" PRIi32 "MHz  %-7s %8" PRIu32 "  %5zu  %8.1f  %8.1f", search[i].frequency / 1000000,
+                search[i].data ? "data" : "nominal", search[i].bitrate, count,
+                (double)cold / (double)searches, (double)warm / (double)searches);
+        if (rc == BTRERR_NOERROR)
+            fprintf(stdout, "  %4u  %4u  %4u %3u  %8" PRIi32 "  %5.2f\n", candidate[0].brp, candidate[0].tseg1,
+                    candidate[0].tseg2, candidate[0].sjw, candidate[0].bitrate_error,
+                    (double)(target.samplepoint + candidate[0].samplepoint_error) / 100.0);
+        else
+            fprintf(stdout, "  (no candidate)\n");
+    }
+    return 0;
+}
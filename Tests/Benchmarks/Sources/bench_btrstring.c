@@ -0,0 +1,114 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_btrstring - parses and prints bit-rate strings (string conversion of can_btr)
+//
+//  usage: bench_btrstring [-n <conversions>]
+//
+//  Converts a set of bit-rate strings (CAN 2.0 and CAN FD, canonical and with
+//  blanks, 'f_clock_mhz' or reordered keys) N times into bit-rate settings by
+//  'btr_string2bitrate', and the bit-rate settings N times back into strings
+//  by 'btr_bitrate2string'.  The mean duration of one conversion is reported
+//  together with the throughput in strings per second.  Also the conversion
+//  of an index to the predefined bit-rate settings is measured.
+//
+#include "can_btr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+static const char *strings[] = {
+    "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16",
+    "f_clock=8000000,nom_brp=1,nom_tseg1=5,nom_tseg2=2,nom_sjw=1,nom_sam=0",
+    " nom_sjw = 16 , nom_tseg2=16,nom_tseg1= 63,nom_brp =2, f_clock_mhz=80 ,",
+    "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16,data_brp=2,data_tseg1=7,data_tseg2=2,data_sjw=2",
+    "data_sjw=2,data_tseg2=2,data_tseg1=7,data_brp=2,f_clock_mhz=80,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16"
+};
+#define NUM_STRINGS  (sizeof(strings) / sizeof(strings[0]))
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    char string[BTR_STRING_LENGTH];
+    btr_bitrate_t bitrate;
+    btr_index_t index;
+    bool data = false, sam = false;
+    uint64_t t0, parse, print, total;
+    long conversions = 1000000L;
+    long n;
+    int opt, rc = BTRERR_NOERROR;
+    unsigned int i;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': conversions = atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n <conversions>]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (conversions < 1L) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "Conversions: %li\n", conversions);
+    fprintf(stdout, "String  Length  Parse[ns]  Print[ns]  Parse[Mstr/s]  Print[Mstr/s]\n");
+
+    for (i = 0U, total = 0U; i < NUM_STRINGS; i++) {
+        /* string to bit-rate settings */
+        t0 = nanoseconds();
+        for (n = 0L; n < conversions; n++)
+            rc |= btr_string2bitrate((btr_string_t)strings[i], &bitrate, &data, &sam);
+        parse = nanoseconds() - t0;
+        /* bit-rate settings to string */
+        t0 = nanoseconds();
+        for (n = 0L; n < conversions; n++)
+            rc |= btr_bitrate2string(&bitrate, data, sam, string, BTR_STRING_LENGTH);
+        print = nanoseconds() - t0;
+        total += parse + print;
+
+        fprintf(stdout, "%6u  %6zu  %9.1f  %9.1f  %13.3f  %13.3f\n", i + 1U, strlen(strings[i]),
+                (double)parse / (double)conversions, (double)print / (double)conversions,
+                (double)conversions / ((double)parse / 1e3), (double)conversions / ((double)print / 1e3));
+    }
+    /* index to bit-rate settings and back */
+    t0 = nanoseconds();
+    for (n = 0L; n < conversions; n++) {
+        rc |= btr_index2bitrate((btr_index_t)(-(n % BTR_SJA1000_ENTRIES)), &bitrate);
+        rc |= btr_bitrate2index(&bitrate, &index);
+    }
+    t0 = nanoseconds() - t0;
+    fprintf(stdout, "Index to bit-rate and back: %.1fns\n", (double)t0 / (double)conversions);
+    fprintf(stdout, "Total: %.3fs for %li string conversions\n", (double)total / 1e9,
+            conversions * (long)NUM_STRINGS * 2L);
+    if (rc != BTRERR_NOERROR)
+        fprintf(stdout, "Warning: at least one conversion failed\n");
+    return 0;
+}
@@ -0,0 +1,354 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_canque - contention and throughput of the message queue (MacCAN_MsgQueue)
+//
+//  usage: bench_canque [-n <messages>] [-q <size>[,<size>...]] [-c <consumers>] [-w <window>]
+//                      [-m block|spin|poll|try|all] [-s <usec>] [-d <nsec>] [-j <file>]
+//
+//  One producer thread enqueues N messages (CANQUE_Enqueue) into a queue that
+//  is read by one consumer (1P1C) or by C consumers (1PnC) with one of the wait
+//  modes: block on the wait condition, spin then block, busy-poll (CANQUE_Set-
+//  WaitMode), or try (non-blocking read in a loop).  The producer keeps at most
+//  W messages in flight, so that no message is lost.  In the overflow scenario
+//  the producer is not throttled and one consumer is slowed down by D ns per
+//  message, so that the queue overflows.
+//
+//  Every message carries the time when it was enqueued; the consumer puts the
+//  handoff latency (time until it was dequeued) into a table to compute p50,
+//  p99 and p99.9.  The queue has to be built with OPTION_CANQUE_STATISTICS=1
+//  to report the condition signals, waits and wakeups and the lock-hold time.
+//  With option -j the results are also written into a JSON file.
+//
+#include "MacCAN_MsgQueue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX()  __asm__ __volatile__("pause")
+#elif defined(__aarch64__) || defined(__arm64__)
+#define CPU_RELAX()  __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX()  do{ } while(0)
+#endif
+
+#define MAX_SIZES      8
+#define MAX_CONSUMERS  64
+#define TIMEOUT        100U  /* [ms] */
+
+#define MODE_BLOCK  CANQUE_WAIT_BLOCK
+#define MODE_SPIN   CANQUE_WAIT_SPIN
+#define MODE_POLL   CANQUE_WAIT_POLL
+#define MODE_TRY    3U
+#define NUM_MODES   4U
+
+static const char *modes[NUM_MODES] = { "block", "spin", "poll", "try" };
+
+typedef struct {                        /* queue element (size of a CAN FD message) */
+    uint64_t stamp;
+    uint64_t seq;
+    uint8_t data[72];
+} element_t;
+
+typedef struct {                        /* one scenario */
+    uint32_t size;
+    int consumers;
+    unsigned int mode;
+    uint64_t window;                    /* 0 = not throttled (overflow) */
+    uint64_t delay;                     /* consumer delay in [ns] */
+} scenario_t;
+
+typedef struct {                        /* its result */
+    double seconds;
+    uint64_t received;
+    uint64_t dropped;
+    uint64_t p50, p99, p999, max;
+    CANQUE_Statistics_t stats;
+    bool statistics;
+} result_t;
+
+static struct {                         /* shared between the threads */
+    CANQUE_MsgQueue_t queue;
+    const scenario_t *scenario;
+    uint64_t messages;
+    uint64_t *latency;
+    volatile bool start;
+    uint64_t received __attribute__((aligned(128)));
+    uint64_t dropped __attribute__((aligned(128)));
+    uint64_t finished __attribute__((aligned(128)));
+    uint64_t t1;
+} shared;
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static int compare(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+static bool accounted(void) {
+    return (__atomic_load_n(&shared.received, __ATOMIC_ACQUIRE) +
+            __atomic_load_n(&shared.dropped, __ATOMIC_ACQUIRE)) >= shared.messages;
+}
+
+static void *producer(void *arg) {
+    const scenario_t *scenario = shared.scenario;
+    element_t element;
+    uint64_t seq, spins;
+
+    (void)arg;
+    memset(&element, 0, sizeof(element_t));
+    while (!shared.start)
+        ;
+    for (seq = 0U; seq < shared.messages; seq++) {
+        /* keep at most W messages in flight (unless overflow scenario) */
+        if (scenario->window) {
+            for (spins = 0U; (seq - __atomic_load_n(&shared.received, __ATOMIC_ACQUIRE)) >= scenario->window; spins++) {
+                if ((spins % 256U) == 255U)
+                    (void)sched_yield();
+                else
+                    CPU_RELAX();
+            }
+        }
+        element.seq = seq;
+        element.stamp = nanoseconds();
+        if (CANQUE_Enqueue(shared.queue, &element) != CANUSB_SUCCESS)
+            (void)__atomic_fetch_add(&shared.dropped, 1U, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    const scenario_t *scenario = shared.scenario;
+    UInt16 timeout = (scenario->mode == MODE_TRY) ? 0U : TIMEOUT;
+    element_t element;
+    uint64_t now, index, until;
+
+    (void)arg;
+    while (!shared.start)
+        ;
+    while (!accounted()) {
+        if (CANQUE_Dequeue(shared.queue, &element, timeout) == CANUSB_SUCCESS) {
+            now = nanoseconds();
+            index = __atomic_fetch_add(&shared.received, 1U, __ATOMIC_ACQ_REL);
+            shared.latency[index] = now - element.stamp;
+            if ((index + 1U + __atomic_load_n(&shared.dropped, __ATOMIC_ACQUIRE)) >= shared.messages)
+                shared.t1 = now;
+            if (scenario->delay)
+                for (until = now + scenario->delay; nanoseconds() < until; )
+                    CPU_RELAX();
+        } else if (scenario->mode == MODE_TRY) {
+            CPU_RELAX();
+        }
+    }
+    (void)__atomic_fetch_add(&shared.finished, 1U, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static int run(const scenario_t *scenario, uint64_t messages, uint32_t spinTime, result_t *result) {
+    pthread_t prod, cons[MAX_CONSUMERS];
+    uint64_t t0, received;
+    int i;
+
+    memset(result, 0, sizeof(result_t));
+    if ((shared.queue = CANQUE_Create(scenario->size, sizeof(element_t))) == NULL)
+        return -1;
+    (void)CANQUE_SetWaitMode(shared.queue, (scenario->mode == MODE_TRY) ? CANQUE_WAIT_BLOCK : (UInt8)scenario->mode, spinTime);
+    shared.scenario = scenario;
+    shared.messages = messages;
+    shared.start = false;
+    shared.received = shared.dropped = shared.finished = 0U;
+    shared.t1 = 0U;
+
+    if (pthread_create(&prod, NULL, producer, NULL) != 0)
+        return -1;
+    for (i = 0; i < scenario->consumers; i++)
+        if (pthread_create(&cons[i], NULL, consumer, NULL) != 0)
+            return -1;
+    t0 = nanoseconds();
+    shared.start = true;
+    (void)pthread_join(prod, NULL);
+    /* wait until all messages are received or dropped, then take the statistics */
+    while (!accounted())
+        (void)usleep(100U);
+    result->statistics = (CANQUE_GetStatistics(shared.queue, &result->stats) == CANUSB_SUCCESS);
+    /* wake up the consumers waiting on the queue */
+    while (__atomic_load_n(&shared.finished, __ATOMIC_ACQUIRE) < (uint64_t)scenario->consumers) {
+        (void)CANQUE_Signal(shared.queue);
+        (void)usleep(100U);
+    }
+    for (i = 0; i < scenario->consumers; i++)
+        (void)pthread_join(cons[i], NULL);
+    (void)CANQUE_Destroy(shared.queue);
+
+    received = shared.received;
+    result->seconds = (double)((shared.t1 > t0) ? (shared.t1 - t0) : 1U) / 1e9;
+    result->received = received;
+    result->dropped = shared.dropped;
+    if (received) {
+        qsort(shared.latency, (size_t)received, sizeof(uint64_t), compare);
+        result->p50 = shared.latency[(received * 500U) / 1000U];
+        result->p99 = shared.latency[(received * 990U) / 1000U];
+        result->p999 = shared.latency[(received * 999U) / 1000U];
+        result->max = shared.latency[received - 1U];
+    }
+    return 0;
+}
+
+static void print_json(FILE *fp, bool first, const scenario_t *scenario, const result_t *result) {
+    fprintf(fp, "%s    {\"scenario\": \"%s\", \"queue_size\": %" PRIu32 ", \"consumers\": %i, \"wait_mode\": \"%s\", ",
+            first ? "" : ",\n", (scenario->window == 0U) ? "overflow" : (scenario->consumers == 1) ? "1P1C" : "1PnC",
+            scenario->size, scenario->consumers, modes[scenario->mode]);
+    fprintf(fp, "\"window\": %" PRIu64 ", \"delay_ns\": %" PRIu64 ", \"seconds\": %.6f, \"ops_per_sec\": %.1f, ",
+            scenario->window, scenario->delay, result->seconds, (double)result->received / result->seconds);
+    fprintf(fp, "\"received\": %" PRIu64 ", \"dropped\": %" PRIu64 ", ", result->received, result->dropped);
+    fprintf(fp, "\"latency_ns\": {\"p50\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"p99_9\": %" PRIu64 ", \"max\": %" PRIu64 "}",
+            result->p50, result->p99, result->p999, result->max);
+    if (result->statistics) {
+        fprintf(fp, ", \"condvar\": {\"signals\": %" PRIu64 ", \"waits\": %" PRIu64 ", \"wakeups\": %" PRIu64 ", \"timeouts\": %" PRIu64 "}",
+                result->stats.signals, result->stats.waits, result->stats.wakeups, result->stats.timeouts);
+        fprintf(fp, ", \"lock\": {\"count\": %" PRIu64 ", \"total_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64 "}",
+                result->stats.lockCount, result->stats.lockTime, result->stats.lockMax);
+    }
+    fprintf(fp, "}");
+}
+
+int main(int argc, char *argv[]) {
+    scenario_t scenario[MAX_SIZES * (NUM_MODES * 2U + 1U)];
+    result_t result;
+    uint32_t size[MAX_SIZES] = { 65536U };
+    int sizes = 1, consumers = 4, num = 0;
+    long messages = 1000000L, window = 64L, spinTime = 100L, delay = 2000L;
+    unsigned int mode, first = 0U, last = NUM_MODES - 1U;
+    const char *json = NULL;
+    FILE *fp = NULL;
+    char label[16];
+    char *ptr;
+    int opt, i, c;
+
+    while ((opt = getopt(argc, argv, "n:q:c:w:m:s:d:j:h")) != -1) {
+        switch (opt) {
+            case 'n': messages = atol(optarg); break;
+            case 'q':
+                for (sizes = 0, ptr = optarg; *ptr && (sizes < MAX_SIZES); sizes++) {
+                    size[sizes] = (uint32_t)strtoul(ptr, &ptr, 0);
+                    if (*ptr == ',') ptr++;
+                }
+                break;
+            case 'c': consumers = atoi(optarg); break;
+            case 'w': window = atol(optarg); break;
+            case 'm':
+                for (mode = 0U; mode < NUM_MODES; mode++)
+                    if (!strcmp(optarg, modes[mode])) break;
+                if (mode < NUM_MODES)
+                    first = last = mode;
+                else if (strcmp(optarg, "all"))
+                    first = NUM_MODES;
+                break;
+            case 's': spinTime = atol(optarg); break;
+            case 'd': delay = atol(optarg); break;
+            case 'j': json = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n <messages>] [-q <size>[,<size>...]] [-c <consumers>] [-w <window>]\n"
+                                "       %*s [-m block|spin|poll|try|all] [-s <usec>] [-d <nsec>] [-j <file>]\n",
+                        argv[0], (int)strlen(argv[0]), "");
+                return 1;
+        }
+    }
+    for (i = 0; i < sizes; i++)
+        if ((size[i] < 1U) || ((long)size[i] < window)) break;
+    if ((messages < 1L) || (sizes < 1) || (i < sizes) || (consumers < 2) || (consumers > MAX_CONSUMERS) ||
+        (window < 1L) || (first >= NUM_MODES) || (spinTime < 0L) || (delay < 0L)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    if ((shared.latency = (uint64_t*)malloc((size_t)messages * sizeof(uint64_t))) == NULL) {
+        fprintf(stderr, "+++ error: out of memory\n");
+        return 1;
+    }
+    if (json && ((fp = fopen(json, "w")) == NULL)) {
+        fprintf(stderr, "+++ error: file '%s' could not be created\n", json);
+        return 1;
+    }
+    /* the scenarios: 1P1C and 1PnC per wait mode, and overflow (per queue size) */
+    for (i = 0; i < sizes; i++) {
+        for (mode = first; mode <= last; mode++) {
+            for (c = 1; c <= consumers; c += consumers - 1) {
+                scenario[num].size = size[i];
+                scenario[num].consumers = c;
+                scenario[num].mode = mode;
+                scenario[num].window = (uint64_t)window;
+                scenario[num++].delay = 0U;
+            }
+        }
+        scenario[num].size = size[i];
+        scenario[num].consumers = 1;
+        scenario[num].mode = MODE_BLOCK;
+        scenario[num].window = 0U;
+        scenario[num++].delay = (uint64_t)delay;
+    }
+    fprintf(stdout, "Messages: %li, window: %li, spin time: %lius, consumer delay (overflow): %lins\n",
+            messages, window, spinTime, delay);
+    fprintf(stdout, "Scenario     Size  Mode    Mops/s   p50[ns]   p99[ns] p99.9[ns]   Dropped    Waits  Wakeups  Lock[ns] avg/max\n");
+    if (fp)
+        fprintf(fp, "{\n  \"benchmark\": \"bench_canque\",\n  \"messages\": %li,\n  \"element_size\": %zu,\n  \"results\": [\n",
+                messages, sizeof(element_t));
+
+    for (i = 0; i < num; i++) {
+        if (run(&scenario[i], (uint64_t)messages, (uint32_t)spinTime, &result) < 0) {
+            fprintf(stderr, "+++ error: scenario #%i could not be run\n", i + 1);
+            return 1;
+        }
+        if (scenario[i].window)
+            snprintf(label, sizeof(label), "1P%iC", scenario[i].consumers);
+        else
+            snprintf(label, sizeof(label), "overflow");
+        fprintf(stdout, "%-8s  %7" PRIu32 "  %-5s  %7.3f  %8" PRIu64 "  %8" PRIu64 "  %8" PRIu64 "  %8" PRIu64,
+                label, scenario[i].size, modes[scenario[i].mode], (double)result.received / result.seconds / 1e6,
+                result.p50, result.p99, result.p999, result.dropped);
+        if (result.statistics)
+            fprintf(stdout, "  %7" PRIu64 "  %7" PRIu64 "  %7.1f/%" PRIu64 "\n", result.stats.waits, result.stats.wakeups,
+                    result.stats.lockCount ? (double)result.stats.lockTime / (double)result.stats.lockCount : 0.0,
+                    result.stats.lockMax);
+        else
+            fprintf(stdout, "        -        -        -\n");
+        if (fp)
+            print_json(fp, (i == 0), &scenario[i], &result);
+    }
+    if (fp) {
+        fprintf(fp, "\n  ]\n}\n");
+        fclose(fp);
+    }
+    free(shared.latency);
+    return 0;
+}
@@ -0,0 +1,189 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_export - exports CAN messages to candump, ASC and BLF log files
+//
+//  usage: bench_export [-n <frames>] [-f candump|asc|blf] [-i <capture>] [-d <directory>] [-k]
+//
+//  Without option -i, synthetic CAN CC messages with 8 byte payload and CAN FD
+//  messages with 64 byte payload are exported in batches of 64 messages (as
+//  they come from the reception loop of can_moni) to a log file of each format
+//  (or of the format given by option -f).  With option -i, the messages of a
+//  capture file (recorder of can_moni) are read and exported, i.e. a capture
+//  file is converted into log files.  The log files are written to the given
+//  directory (default /tmp) and are removed at the end, unless option -k is
+//  given.
+//
+#include "can_exp.h"
+#include "can_rec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define BATCH_SIZE  64U
+
+static const char *extension[3] = { "log", "asc", "blf" };
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static int synthetic(exp_exporter_t exporter, int frames, bool fdf, uint64_t *nsTime) {
+    exp_message_t message[BATCH_SIZE];
+    uint64_t timestamp = 1700000000ULL * 1000000000ULL;
+    uint64_t t0;
+    uint32_t seed = 0x12345678U;
+    unsigned int i, j;
+    int n, rc;
+
+    memset(message, 0, sizeof(message));
+    for (i = 0U; i < BATCH_SIZE; i++) {
+        message[i].id = (uint32_t)(0x100U + i);
+        message[i].xtd = (i % 4U) == 3U;
+        message[i].fdf = fdf ? 1 : 0;
+        message[i].brs = fdf ? 1 : 0;
+        message[i].dlc = fdf ? CANFD_MAX_DLC : CAN_MAX_DLC;
+        for (j = 0U; j < CANFD_MAX_LEN; j++) {
+            seed = seed * 1103515245U + 12345U;
+            message[i].data[j] = (uint8_t)(seed >> 16);
+        }
+    }
+    t0 = nanoseconds();
+    for (n = 0; n < frames; n += (int)BATCH_SIZE) {
+        for (i = 0U; i < BATCH_SIZE; i++) {
+            timestamp += 123456ULL;
+            message[i].timestamp.tv_sec = (time_t)(timestamp / 1000000000ULL);
+            message[i].timestamp.tv_nsec = (long)(timestamp % 1000000000ULL);
+            message[i].data[0] = (uint8_t)(n + (int)i);
+        }
+        if ((rc = exp_exporter_write(exporter, message, BATCH_SIZE)) != EXPERR_NOERROR)
+            return rc;
+    }
+    rc = exp_exporter_flush(exporter);
+    *nsTime = nanoseconds() - t0;
+    return rc;
+}
+
+static int convert(exp_exporter_t exporter, const char *capture, uint64_t *nsTime) {
+    exp_message_t message[BATCH_SIZE];
+    rec_reader_t reader = NULL;
+    uint64_t t0;
+    size_t n = 0U;
+    int rc;
+
+    if ((rc = rec_reader_open(&reader, capture)) != RECERR_NOERROR) {
+        fprintf(stderr, "+++ error: capture file '%s' could not be opened (%i)\n", capture, rc);
+        return rc;
+    }
+    t0 = nanoseconds();
+    while ((rc = rec_reader_read(reader, &message[n])) == 1) {
+        if (++n == BATCH_SIZE) {
+            if ((rc = exp_exporter_write(exporter, message, n)) != EXPERR_NOERROR)
+                break;
+            n = 0U;
+        }
+    }
+    if ((rc == 0) && ((rc = exp_exporter_write(exporter, message, n)) == EXPERR_NOERROR))
+        rc = exp_exporter_flush(exporter);
+    *nsTime = nanoseconds() - t0;
+    (void)rec_reader_close(reader);
+    return rc;
+}
+
+int main(int argc, char *argv[]) {
+    int frames = 1000000, format = -1;
+    const char *directory = "/tmp";
+    const char *capture = NULL;
+    bool keep = false;
+    char path[256];
+    exp_exporter_t exporter;
+    exp_options_t options;
+    exp_stats_t stats;
+    uint64_t nsTime = 0U;
+    int opt, f, p, rc;
+
+    while ((opt = getopt(argc, argv, "n:f:i:d:kh")) != -1) {
+        switch (opt) {
+            case 'n': frames = atoi(optarg); break;
+            case 'f':
+                for (format = 2; format >= 0; format--)
+                    if (!strcmp(optarg, extension[format]) || ((format == 0) && !strcmp(optarg, "candump")))
+                        break;
+                if (format < 0)
+                    format = 3;
+                break;
+            case 'i': capture = optarg; break;
+            case 'd': directory = optarg; break;
+            case 'k': keep = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-n <frames>] [-f candump|asc|blf] [-i <capture>] [-d <directory>] [-k]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((frames < 1) || (format > 2)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    if (!capture)
+        fprintf(stdout, "Frames: %i per format and payload, batches of %u\n", frames, BATCH_SIZE);
+    else
+        fprintf(stdout, "Capture: %s\n", capture);
+    fprintf(stdout, "Format   Payload       Frames     Frames/s  ns/frame     MB/s  File size\n");
+
+    for (f = 0; f < 3; f++) {
+        if ((format >= 0) && (f != format))
+            continue;
+        (void)snprintf(path, sizeof(path), "%s/bench_export.%s", directory, extension[f]);
+        for (p = 0; p < (capture ? 1 : 2); p++) {
+            memset(&options, 0, sizeof(exp_options_t));
+            options.format = (exp_format_t)f;
+            options.time_stamp = MSG_FMT_TIMESTAMP_ABSOLUTE;
+            if ((rc = exp_exporter_create(&exporter, path, &options)) != EXPERR_NOERROR) {
+                fprintf(stderr, "+++ error: log file '%s' could not be created (%i)\n", path, rc);
+                return 1;
+            }
+            if (!capture)
+                rc = synthetic(exporter, frames, p != 0, &nsTime);
+            else
+                rc = convert(exporter, capture, &nsTime);
+            (void)exp_exporter_stats(exporter, &stats);
+            if ((exp_exporter_close(exporter) != EXPERR_NOERROR) || (rc != EXPERR_NOERROR)) {
+                fprintf(stderr, "+++ error: log file '%s' could not be written (%i)\n", path, rc);
+                return 1;
+            }
+            fprintf(stdout, "%-7s  %-8s  %11" PRIu64 "  %11.0f  %8.1f  %7.1f  %9" PRIu64 "\n",
+                    f ? extension[f] : "candump", capture ? "capture" : (p ? "CAN FD" : "CAN CC"), stats.messages,
+                    nsTime ? (double)stats.messages * 1e9 / (double)nsTime : 0.0,
+                    stats.messages ? (double)nsTime / (double)stats.messages : 0.0,
+                    nsTime ? (double)stats.bytes * 1e3 / (double)nsTime : 0.0, stats.bytes);
+        }
+        if (!keep)
+            (void)unlink(path);
+    }
+    return 0;
+}
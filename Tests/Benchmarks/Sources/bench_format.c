@@ -0,0 +1,165 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_format - formats CAN messages into strings (message formatter of can_moni)
+//
+//  usage: bench_format [-n <frames>] [-d hex|dec|oct] [-w <wraparound>] [-a] [-t]
+//
+//  Formats N messages with 8 byte payload (CAN CC) and N messages with 64 byte
+//  payload (CAN FD) with msg_format_message (static buffer), with the reentrant
+//  msg_format_message_r (caller's buffer), and only the data field with
+//  msg_format_data plus msg_format_ascii, and reports frames/s and the payload
+//  throughput.  The payload is formatted as hex (default), decimal or octal
+//  numbers plus ASCII; option -a omits the ASCII column, option -t uses tabs
+//  as separator, option -w sets the wraparound (0 = none, 8, 10, 16, 32, 64).
+//
+#include "can_msg.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define NUM_MESSAGES  256U  /* distinct messages (power of 2) */
+
+static msg_message_t message[NUM_MESSAGES];
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void prepare(uint8_t dlc, bool fdf) {
+    uint32_t seed = 0x12345678U;
+    unsigned int i, j;
+
+    memset(message, 0, sizeof(message));
+    for (i = 0U; i < NUM_MESSAGES; i++) {
+        message[i].id = i & 0x7FFU;
+        message[i].xtd = 0;
+        message[i].rtr = 0;
+        message[i].fdf = fdf ? 1 : 0;
+        message[i].brs = fdf ? 1 : 0;
+        message[i].dlc = dlc;
+        for (j = 0U; j < CANFD_MAX_LEN; j++) {
+            seed = seed * 1103515245U + 12345U;
+            message[i].data[j] = (uint8_t)(seed >> 16);
+        }
+        message[i].timestamp.tv_sec = 1700000000 + (time_t)(i / 10U);
+        message[i].timestamp.tv_nsec = (long)(i % 10U) * 100000000L;
+    }
+}
+
+static void report(const char *title, const char *function, uint64_t frames, uint64_t ns, uint8_t dlc) {
+    static const unsigned int length[16] = { 0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64 };
+
+    fprintf(stdout, "%-18s  %-22s  %10.0f  %8.1f  %8.1f\n", title, function,
+            (double)frames / ((double)ns / 1e9), (double)ns / (double)frames,
+            (double)frames * (double)length[dlc & 0xFU] / ((double)ns / 1e3));
+}
+
+static void run(const char *title, uint64_t frames) {
+    char buffer[MSG_STRING_LENGTH];
+    msg_timestamp_t laststamp = { 0, 0 };
+    uint64_t n, chars, t0, t1, t2, t3;
+
+    /* msg_format_message (static buffer) */
+    chars = 0U;
+    t0 = nanoseconds();
+    for (n = 0U; n < frames; n++)
+        chars += (uint64_t)strlen(msg_format_message(&message[n & (NUM_MESSAGES - 1U)], MSG_RX_MESSAGE, n, 0));
+    t1 = nanoseconds();
+    /* msg_format_message_r (caller's buffer) */
+    for (n = 0U; n < frames; n++)
+        chars += (uint64_t)msg_format_message_r(buffer, sizeof(buffer), &message[n & (NUM_MESSAGES - 1U)], MSG_RX_MESSAGE, n, 0, &laststamp);
+    t2 = nanoseconds();
+    /* msg_format_data and msg_format_ascii (data field only) */
+    for (n = 0U; n < frames; n++) {
+        chars += (uint64_t)strlen(msg_format_data(&message[n & (NUM_MESSAGES - 1U)]));
+        chars += (uint64_t)strlen(msg_format_ascii(&message[n & (NUM_MESSAGES - 1U)]));
+    }
+    t3 = nanoseconds();
+
+    report(title, "msg_format_message", frames, t1 - t0, message[0].dlc);
+    report(title, "msg_format_message_r", frames, t2 - t1, message[0].dlc);
+    report(title, "msg_format_data+ascii", frames, t3 - t2, message[0].dlc);
+    if (!chars)
+        fprintf(stdout, "Warning: nothing formatted\n");
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t frames = 1000000U;
+    msg_fmt_number_t data = MSG_FMT_NUMBER_HEX;
+    msg_fmt_wraparound_t wraparound = MSG_FMT_WRAPAROUND_NO;
+    bool ascii = true, tabs = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:w:ath")) != -1) {
+        switch (opt) {
+            case 'n': frames = (uint64_t)strtoull(optarg, NULL, 10); break;
+            case 'd':
+                if (!strcmp(optarg, "hex")) data = MSG_FMT_NUMBER_HEX;
+                else if (!strcmp(optarg, "dec")) data = MSG_FMT_NUMBER_DEC;
+                else if (!strcmp(optarg, "oct")) data = MSG_FMT_NUMBER_OCT;
+                else {
+                    fprintf(stderr, "%s: illegal argument\n", argv[0]);
+                    return 1;
+                }
+                break;
+            case 'w':
+                wraparound = (msg_fmt_wraparound_t)atoi(optarg);
+                if (!msg_set_fmt_wraparound(wraparound)) {
+                    fprintf(stderr, "%s: illegal argument\n", argv[0]);
+                    return 1;
+                }
+                break;
+            case 'a': ascii = false; break;
+            case 't': tabs = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-n <frames>] [-d hex|dec|oct] [-w <wraparound>] [-a] [-t]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (frames < 1U) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    /* the format of can_moni (defaults) */
+    (void)msg_set_fmt_time_stamp(MSG_FMT_TIMESTAMP_ZERO);
+    (void)msg_set_fmt_data(data);
+    (void)msg_set_fmt_ascii(ascii ? MSG_FMT_OPTION_ON : MSG_FMT_OPTION_OFF);
+    (void)msg_set_fmt_separator(tabs ? MSG_FMT_SEPARATOR_TABS : MSG_FMT_SEPARATOR_SPACES);
+    (void)msg_set_fmt_wraparound(wraparound);
+
+    fprintf(stdout, "Frames: %" PRIu64 ", data: %s%s, separator: %s, wraparound: %i\n", frames,
+            (data == MSG_FMT_NUMBER_DEC) ? "dec" : (data == MSG_FMT_NUMBER_OCT) ? "oct" : "hex",
+            ascii ? " + ascii" : "", tabs ? "tabs" : "spaces", (int)wraparound);
+    fprintf(stdout, "Payload             Function                  Frames/s  ns/frame      MB/s\n");
+    prepare(8U, false);
+    run("8 bytes (CAN CC)", frames);
+    prepare(15U, true);
+    run("64 bytes (CAN FD)", frames);
+    return 0;
+}
@@ -0,0 +1,161 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_handles - hammers N handles from M threads (handle lookup, status and counters)
+//
+//  usage: bench_handles [-n <handles>] [-t <threads>] [-s <seconds>] [-o]
+//
+//  Every thread calls can_read (non-blocking) and can_property (Rx counter) on
+//  its handle (thread i uses handle i % N).  Opened handles are started with
+//  250 kbit/s, unless option -o (offline) is given.  When no CAN channel could
+//  be opened at all, the threads hammer unopened handles (argument check only).
+//
+#include "can_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define MAX_THREADS  256
+#define MAX_HANDLES  256
+
+typedef struct {
+    pthread_t thread;
+    int handle;
+    uint64_t calls;
+    uint64_t nsMin;
+    uint64_t nsMax;
+    uint64_t nsSum;
+} __attribute__((aligned(128))) worker_t;
+
+static worker_t worker[MAX_THREADS];
+static volatile bool running = false;
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void *hammer(void *arg) {
+    worker_t *self = (worker_t*)arg;
+    can_message_t message;
+    uint64_t counter, t0, dt;
+
+    self->nsMin = UINT64_MAX;
+    while (!running)
+        ;
+    while (running) {
+        t0 = nanoseconds();
+        (void)can_read(self->handle, &message, 0U);
+        (void)can_property(self->handle, CANPROP_GET_RX_COUNTER, (void*)&counter, sizeof(uint64_t));
+        dt = nanoseconds() - t0;
+        if (dt < self->nsMin) self->nsMin = dt;
+        if (dt > self->nsMax) self->nsMax = dt;
+        self->nsSum += dt;
+        self->calls += 2U;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int numHandles = 32, numThreads = 32, seconds = 5;
+    bool offline = false;
+    int handle[MAX_HANDLES];
+    int opened = 0;
+    can_bitrate_t bitrate;
+    uint64_t total = 0U, t0, t1;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "n:t:s:oh")) != -1) {
+        switch (opt) {
+            case 'n': numHandles = atoi(optarg); break;
+            case 't': numThreads = atoi(optarg); break;
+            case 's': seconds = atoi(optarg); break;
+            case 'o': offline = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-n <handles>] [-t <threads>] [-s <seconds>] [-o]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((numHandles < 1) || (numHandles > MAX_HANDLES) ||
+        (numThreads < 1) || (numThreads > MAX_THREADS) || (seconds < 1)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "%s\n", can_version());
+
+    /* open (and start) as many CAN channels as available */
+    bitrate.index = CANBTR_INDEX_250K;
+    for (i = 0; (i < MAX_HANDLES) && (opened < numHandles); i++) {
+        int rc = can_init(i, CANMODE_DEFAULT, NULL);
+        if (rc < CANERR_NOERROR)
+            continue;
+        if (!offline && (can_start(rc, &bitrate) != CANERR_NOERROR)) {
+            (void)can_exit(rc);
+            continue;
+        }
+        handle[opened++] = rc;
+    }
+    if (opened == 0) {
+        fprintf(stdout, "Warning: no CAN channel opened (hammering unopened handles)\n");
+        for (i = 0; i < numHandles; i++)
+            handle[i] = i;
+    }
+    fprintf(stdout, "Handles: %i (%s), threads: %i, duration: %is\n",
+            opened ? opened : numHandles, opened ? (offline ? "opened" : "started") : "unopened", numThreads, seconds);
+
+    /* let the threads go */
+    for (i = 0; i < numThreads; i++) {
+        worker[i].handle = handle[i % (opened ? opened : numHandles)];
+        if (pthread_create(&worker[i].thread, NULL, hammer, (void*)&worker[i]) != 0) {
+            fprintf(stderr, "+++ error: thread #%i could not be created\n", i);
+            return 1;
+        }
+    }
+    t0 = nanoseconds();
+    running = true;
+    sleep((unsigned int)seconds);
+    running = false;
+    t1 = nanoseconds();
+    for (i = 0; i < numThreads; i++)
+        (void)pthread_join(worker[i].thread, NULL);
+
+    /* the result */
+    fprintf(stdout, "Thread  Handle       Calls   Min[ns]   Avg[ns]     Max[ns]\n");
+    for (i = 0; i < numThreads; i++) {
+        uint64_t loops = worker[i].calls / 2U;
+        fprintf(stdout, "%6i  %6i  %10" PRIu64 "  %8" PRIu64 "  %8" PRIu64 "  %10" PRIu64 "\n", i, worker[i].handle,
+                worker[i].calls, loops ? worker[i].nsMin / 2U : 0U, loops ? worker[i].nsSum / worker[i].calls : 0U,
+                worker[i].nsMax / 2U);
+        total += worker[i].calls;
+    }
+    fprintf(stdout, "Total: %" PRIu64 " calls in %.3fs = %.3f Mcalls/s\n", total,
+            (double)(t1 - t0) / 1e9, (double)total / ((double)(t1 - t0) / 1e3));
+
+    (void)can_exit(CANEXIT_ALL);
+    return 0;
+}
@@ -0,0 +1,225 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_record - records full-load CAN FD traffic of several channels to capture files
+//
+//  usage: bench_record [-c <channels>] [-s <seconds>] [-b <nominal>:<data>] [-r <MiB>] [-d <directory>] [-k]
+//
+//  Every channel is simulated by a thread, which writes CAN FD messages with
+//  64 byte payload as fast as possible to its own capture file (recorder of
+//  can_moni), in batches of 64 messages as they come from the reception loop.
+//  The achieved rate is compared with the max. frame rate of a CAN FD bus with
+//  the given nominal and data bit-rate in kbit/s (default 1000:8000), so that
+//  a factor greater than 1 means full bus load is sustained.  Thereafter the
+//  capture files are read back with the reader.  Option -r rotates the files
+//  after the given number of megabytes, option -k keeps the files.
+//
+#include "can_rec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define MAX_CHANNELS  64
+#define BATCH_SIZE    64U
+
+#define NOMINAL_BITS  43.0   /* SOF..BRS (11-bit id) and CRC delimiter..IFS */
+#define DATA_BITS    548.0   /* ESI, DLC, 64 bytes, stuff count, CRC-21, fixed stuff bits */
+
+typedef struct {
+    pthread_t thread;
+    int channel;
+    char path[256];
+    rec_recorder_t recorder;
+    uint64_t frames;
+    uint64_t nsTime;
+    rec_stats_t stats;
+    int error;
+} __attribute__((aligned(128))) worker_t;
+
+static worker_t worker[MAX_CHANNELS];
+static volatile bool running = false;
+static double frameTime = 0.0;  /* in [ns] */
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void *record(void *arg) {
+    worker_t *self = (worker_t*)arg;
+    rec_message_t message[BATCH_SIZE];
+    uint64_t timestamp = 1700000000ULL * 1000000000ULL;
+    uint64_t t0;
+    uint32_t seed = 0x12345678U + (uint32_t)self->channel;
+    unsigned int i, j;
+
+    memset(message, 0, sizeof(message));
+    for (i = 0U; i < BATCH_SIZE; i++) {
+        message[i].id = (uint32_t)(0x100U + i);
+        message[i].fdf = 1;
+        message[i].brs = 1;
+        message[i].dlc = CANFD_MAX_DLC;
+        for (j = 0U; j < CANFD_MAX_LEN; j++) {
+            seed = seed * 1103515245U + 12345U;
+            message[i].data[j] = (uint8_t)(seed >> 16);
+        }
+    }
+    while (!running)
+        ;
+    t0 = nanoseconds();
+    while (running) {
+        /* time-stamps of a fully loaded bus */
+        for (i = 0U; i < BATCH_SIZE; i++) {
+            timestamp += (uint64_t)frameTime;
+            message[i].timestamp.tv_sec = (time_t)(timestamp / 1000000000ULL);
+            message[i].timestamp.tv_nsec = (long)(timestamp % 1000000000ULL);
+            message[i].data[0] = (uint8_t)self->frames;
+        }
+        if ((self->error = rec_recorder_write(self->recorder, message, BATCH_SIZE)) != RECERR_NOERROR)
+            break;
+        self->frames += BATCH_SIZE;
+    }
+    if (self->error == RECERR_NOERROR)
+        self->error = rec_recorder_flush(self->recorder);
+    self->nsTime = nanoseconds() - t0;
+    (void)rec_recorder_stats(self->recorder, &self->stats);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int numChannels = 4, seconds = 5, segmentSize = 0;
+    unsigned int nominal = 1000U, data = 8000U;
+    const char *directory = "/tmp";
+    bool keep = false;
+    rec_info_t info;
+    rec_message_t message;
+    uint64_t total = 0U, read = 0U, t0, t1;
+    double required, rate, slowest = -1.0;
+    int opt, i, rc;
+
+    while ((opt = getopt(argc, argv, "c:s:b:r:d:kh")) != -1) {
+        switch (opt) {
+            case 'c': numChannels = atoi(optarg); break;
+            case 's': seconds = atoi(optarg); break;
+            case 'b':
+                if (sscanf(optarg, "%u:%u", &nominal, &data) != 2)
+                    nominal = data = 0U;
+                break;
+            case 'r': segmentSize = atoi(optarg); break;
+            case 'd': directory = optarg; break;
+            case 'k': keep = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-c <channels>] [-s <seconds>] [-b <nominal>:<data>] [-r <MiB>] [-d <directory>] [-k]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((numChannels < 1) || (numChannels > MAX_CHANNELS) || (seconds < 1) ||
+        (nominal == 0U) || (data == 0U) || (segmentSize < 0)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    frameTime = (NOMINAL_BITS * 1e6 / (double)nominal) + (DATA_BITS * 1e6 / (double)data);
+    required = 1e9 / frameTime;
+    fprintf(stdout, "Channels: %i, duration: %is, bit-rate: %u:%ukbps (max. %.0f frames/s per channel)\n",
+            numChannels, seconds, nominal, data, required);
+
+    /* one capture file per channel */
+    for (i = 0; i < numChannels; i++) {
+        memset(&info, 0, sizeof(rec_info_t));
+        info.channel = i;
+        info.mode = CANMODE_FDOE | CANMODE_BRSE;
+        (void)snprintf(info.device, REC_DEVICE_LENGTH, "bench_record #%i", i);
+        (void)snprintf(worker[i].path, sizeof(worker[i].path), "%s/bench_record_%i.crec", directory, i);
+        worker[i].channel = i;
+        if ((rc = rec_recorder_create(&worker[i].recorder, worker[i].path, &info, (uint64_t)segmentSize << 20)) != RECERR_NOERROR) {
+            fprintf(stderr, "+++ error: capture file '%s' could not be created (%i)\n", worker[i].path, rc);
+            return 1;
+        }
+    }
+    /* let the threads go */
+    for (i = 0; i < numChannels; i++) {
+        if (pthread_create(&worker[i].thread, NULL, record, (void*)&worker[i]) != 0) {
+            fprintf(stderr, "+++ error: thread #%i could not be created\n", i);
+            return 1;
+        }
+    }
+    running = true;
+    sleep((unsigned int)seconds);
+    running = false;
+    for (i = 0; i < numChannels; i++) {
+        (void)pthread_join(worker[i].thread, NULL);
+        rc = rec_recorder_close(worker[i].recorder);
+        if (worker[i].error == RECERR_NOERROR)
+            worker[i].error = rc;
+    }
+    /* the result */
+    fprintf(stdout, "Channel      Frames    Frames/s      MB/s  Files  Full-load\n");
+    for (i = 0; i < numChannels; i++) {
+        rate = (double)worker[i].frames / ((double)worker[i].nsTime / 1e9);
+        fprintf(stdout, "%7i  %10" PRIu64 "  %10.0f  %8.1f  %5" PRIu32 "  %8.1fx%s\n", i, worker[i].frames, rate,
+                (double)worker[i].stats.bytes / ((double)worker[i].nsTime / 1e3), worker[i].stats.segments,
+                rate / required, worker[i].error ? "  (write error)" : "");
+        if ((slowest < 0.0) || (rate < slowest))
+            slowest = rate;
+        total += worker[i].frames;
+    }
+    fprintf(stdout, "Total: %" PRIu64 " frames, full bus load on %i channel(s) %s (slowest channel %.1fx)\n",
+            total, numChannels, (slowest >= required) ? "sustained" : "NOT sustained", slowest / required);
+
+    /* read the capture files back */
+    t0 = nanoseconds();
+    for (i = 0; i < numChannels; i++) {
+        rec_reader_t reader;
+        if ((rc = rec_reader_open(&reader, worker[i].path)) != RECERR_NOERROR) {
+            fprintf(stderr, "+++ error: capture file '%s' could not be opened (%i)\n", worker[i].path, rc);
+            return 1;
+        }
+        while ((rc = rec_reader_read(reader, &message)) == 1)
+            read++;
+        if (rc < 0)
+            fprintf(stderr, "+++ error: capture file '%s' could not be read (%i)\n", worker[i].path, rc);
+        (void)rec_reader_close(reader);
+    }
+    t1 = nanoseconds();
+    fprintf(stdout, "Read back: %" PRIu64 " frames in %.3fs = %.0f frames/s%s\n", read,
+            (double)(t1 - t0) / 1e9, (double)read / ((double)(t1 - t0) / 1e9), (read != total) ? " (MISMATCH)" : "");
+
+    /* remove the capture files (and their segments) */
+    if (!keep) {
+        for (i = 0; i < numChannels; i++) {
+            char path[sizeof(worker[i].path) + 12];
+            uint32_t segment;
+            (void)unlink(worker[i].path);
+            for (segment = 1U; segment < worker[i].stats.segments; segment++) {
+                (void)snprintf(path, sizeof(path), "%s.%" PRIu32, worker[i].path, segment);
+                (void)unlink(path);
+            }
+        }
+    }
+    return (read == total) ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+//  bench_rxlatency - latency histogram of the reception path under synthetic CPU load
+//
+//  usage: bench_rxlatency [-c <tx-channel>] [-C <rx-channel>] [-n <frames>] [-l <load-threads>]
+//                         [-m driver|device|pool[:<n>]] [-p other|rr|fifo] [-P <priority>]
+//                         [-a <cpu-mask>] [-L] [-w block|spin[:<usec>]|poll]
+//
+//  A frame is sent on the tx-channel and received on the rx-channel (both
+//  channels must be connected to the same CAN bus, 1 Mbit/s).  The time from
+//  can_write until can_read returns is put into a histogram.  The load threads
+//  spin at normal priority on all cores to compete with the reception thread.
+//  The reception thread settings are passed to the library as properties
+//  before can_init (environment variables MACCAN_RX_xxx work as well).
+//  The wait mode of can_read on the rx-channel is set as a channel property.
+//
+#include "can_api.h"
+#include "KvaserCAN_Defines.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define MAX_LOADS    64
+#define BUCKET_US    25U
+#define NUM_BUCKETS  80U
+
+static uint64_t histogram[NUM_BUCKETS + 1U];
+static volatile bool loading = true;
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void *burn(void *arg) {
+    volatile uint64_t x = 0U;
+
+    while (loading)
+        x += 1U;
+    (void)arg;
+    return NULL;
+}
+
+static int set_property(uint16_t param, void *value, uint32_t nbyte, const char *name) {
+    int rc = can_property(-1, (uint16_t)(CANPROP_SET_VENDOR_PROP + param), value, nbyte);
+    if (rc != CANERR_NOERROR)
+        fprintf(stderr, "+++ error: property '%s' could not be set (%i)\n", name, rc);
+    return rc;
+}
+
+static uint64_t percentile(uint64_t total, double p) {
+    uint64_t sum = 0U, limit = (uint64_t)((double)total * p);
+    unsigned int i;
+
+    for (i = 0U; i < NUM_BUCKETS; i++) {
+        sum += histogram[i];
+        if (sum > limit)
+            return (uint64_t)(i + 1U) * BUCKET_US;
+    }
+    return UINT64_MAX;
+}
+
+int main(int argc, char *argv[]) {
+    int txChannel = 0, rxChannel = 1, frames = 10000, loads = 0;
+    int txHandle, rxHandle;
+    pthread_t load[MAX_LOADS];
+    can_bitrate_t bitrate;
+    can_message_t message, received;
+    uint64_t t0, dt, dtMin = UINT64_MAX, dtMax = 0U, dtSum = 0U, lost = 0U;
+    uint8_t mode = 0U, pool = 0U, mlock = 0U;
+    int32_t policy = -1, priority = 0;
+    uint64_t cpus = 0U;
+    uint8_t waitMode = 0U;
+    uint32_t spinTime = 0U;
+    int opt, rc, i;
+    unsigned int b, w;
+
+    while ((opt = getopt(argc, argv, "c:C:n:l:m:p:P:a:Lw:h")) != -1) {
+        switch (opt) {
+            case 'c': txChannel = atoi(optarg); break;
+            case 'C': rxChannel = atoi(optarg); break;
+            case 'n': frames = atoi(optarg); break;
+            case 'l': loads = atoi(optarg); break;
+            case 'm':
+                if (!strcmp(optarg, "driver")) mode = 0U;
+                else if (!strcmp(optarg, "device")) mode = 1U;
+                else if (!strncmp(optarg, "pool", 4)) { mode = 2U; pool = (optarg[4] == ':') ? (uint8_t)atoi(&optarg[5]) : 2U; }
+                else goto usage;
+                break;
+            case 'p':
+                if (!strcmp(optarg, "other")) policy = SCHED_OTHER;
+                else if (!strcmp(optarg, "rr")) policy = SCHED_RR;
+                else if (!strcmp(optarg, "fifo")) policy = SCHED_FIFO;
+                else goto usage;
+                break;
+            case 'P': priority = atoi(optarg); break;
+            case 'a': cpus = strtoull(optarg, NULL, 0); break;
+            case 'L': mlock = 1U; break;
+            case 'w':
+                if (!strcmp(optarg, "block")) waitMode = 0U;
+                else if (!strncmp(optarg, "spin", 4)) { waitMode = 1U; spinTime = (optarg[4] == ':') ? (uint32_t)atoi(&optarg[5]) : 100U; }
+                else if (!strcmp(optarg, "poll")) waitMode = 2U;
+                else goto usage;
+                break;
+            default:
+            usage:
+                fprintf(stderr, "usage: %s [-c <tx-channel>] [-C <rx-channel>] [-n <frames>] [-l <load-threads>]\n"
+                                "       %*s [-m driver|device|pool[:<n>]] [-p other|rr|fifo] [-P <priority>]\n"
+                                "       %*s [-a <cpu-mask>] [-L] [-w block|spin[:<usec>]|poll]\n", argv[0], (int)strlen(argv[0]), "", (int)strlen(argv[0]), "");
+                return 1;
+        }
+    }
+    if ((frames < 1) || (loads < 0) || (loads > MAX_LOADS)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "%s\n", can_version());
+
+    /* reception thread settings (must be set before can_init) */
+    if (pool && (set_property(KVASER_PROP_RX_THREAD_POOL, &pool, sizeof(uint8_t), "pool size") != CANERR_NOERROR))
+        return 1;
+    if (mode && (set_property(KVASER_PROP_RX_THREAD_MODE, &mode, sizeof(uint8_t), "thread mode") != CANERR_NOERROR))
+        return 1;
+    if ((policy >= 0) && (set_property(KVASER_PROP_RX_SCHED_POLICY, &policy, sizeof(int32_t), "policy") != CANERR_NOERROR))
+        return 1;
+    if (priority && (set_property(KVASER_PROP_RX_SCHED_PRIORITY, &priority, sizeof(int32_t), "priority") != CANERR_NOERROR))
+        return 1;
+    if (cpus && (set_property(KVASER_PROP_RX_CPU_AFFINITY, &cpus, sizeof(uint64_t), "affinity") != CANERR_NOERROR))
+        return 1;
+    if (mlock && (set_property(KVASER_PROP_RX_LOCK_MEMORY, &mlock, sizeof(uint8_t), "mlock") != CANERR_NOERROR))
+        return 1;
+
+    /* open and start both CAN channels */
+    bitrate.index = CANBTR_INDEX_1M;
+    if ((txHandle = can_init(txChannel, CANMODE_DEFAULT, NULL)) < 0) {
+        fprintf(stderr, "+++ error: tx-channel %i could not be initialized (%i)\n", txChannel, txHandle);
+        return 1;
+    }
+    if ((rxHandle = can_init(rxChannel, CANMODE_DEFAULT, NULL)) < 0) {
+        fprintf(stderr, "+++ error: rx-channel %i could not be initialized (%i)\n", rxChannel, rxHandle);
+        (void)can_exit(CANEXIT_ALL);
+        return 1;
+    }
+    if (((rc = can_start(txHandle, &bitrate)) != CANERR_NOERROR) ||
+        ((rc = can_start(rxHandle, &bitrate)) != CANERR_NOERROR)) {
+        fprintf(stderr, "+++ error: CAN controller could not be started (%i)\n", rc);
+        (void)can_exit(CANEXIT_ALL);
+        return 1;
+    }
+    if (waitMode && (((rc = can_property(rxHandle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_SPIN_TIME, &spinTime, sizeof(uint32_t))) != CANERR_NOERROR) ||
+                     ((rc = can_property(rxHandle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_WAIT_MODE, &waitMode, sizeof(uint8_t))) != CANERR_NOERROR))) {
+        fprintf(stderr, "+++ error: wait mode could not be set (%i)\n", rc);
+        (void)can_exit(CANEXIT_ALL);
+        return 1;
+    }
+    (void)can_property(-1, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_THREAD_MODE, &mode, sizeof(uint8_t));
+    (void)can_property(-1, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_SCHED_POLICY, &policy, sizeof(int32_t));
+    (void)can_property(-1, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_SCHED_PRIORITY, &priority, sizeof(int32_t));
+    fprintf(stdout, "Reception thread: mode %u, policy %i, priority %i; wait mode: %u (%u us); load threads: %i; frames: %i\n",
+            mode, policy, priority, waitMode, spinTime, loads, frames);
+
+    /* synthetic CPU load */
+    for (i = 0; i < loads; i++) {
+        if (pthread_create(&load[i], NULL, burn, NULL) != 0) {
+            fprintf(stderr, "+++ error: load thread #%i could not be created\n", i);
+            loads = i;
+            break;
+        }
+    }
+    /* ping-pong: one frame on the bus at a time */
+    memset(&message, 0, sizeof(can_message_t));
+    message.id = 0x100U;
+    message.dlc = 8U;
+    for (i = 0; i < frames; i++) {
+        memcpy(message.data, &i, sizeof(int));
+        t0 = nanoseconds();
+        if ((rc = can_write(txHandle, &message, 0U)) != CANERR_NOERROR) {
+            fprintf(stderr, "+++ error: frame #%i could not be sent (%i)\n", i, rc);
+            break;
+        }
+        do {
+            rc = can_read(rxHandle, &received, 1000U);
+        } while ((rc == CANERR_NOERROR) && received.sts);
+        if (rc != CANERR_NOERROR) {
+            lost++;
+            continue;
+        }
+        dt = (nanoseconds() - t0) / 1000U;
+        if (dt < dtMin) dtMin = dt;
+        if (dt > dtMax) dtMax = dt;
+        dtSum += dt;
+        histogram[(dt / BUCKET_US < NUM_BUCKETS) ? (dt / BUCKET_US) : NUM_BUCKETS] += 1U;
+    }
+    loading = false;
+    for (i = 0; i < loads; i++)
+        (void)pthread_join(load[i], NULL);
+    (void)can_exit(CANEXIT_ALL);
+
+    /* the result */
+    if ((uint64_t)frames <= lost) {
+        fprintf(stdout, "No frame received (%" PRIu64 " lost)\n", lost);
+        return 1;
+    }
+    fprintf(stdout, "Latency [us]: min %" PRIu64 ", avg %" PRIu64 ", max %" PRIu64 "; p50 %" PRIu64 ", p99 %" PRIu64 ", p99.9 %" PRIu64 "; lost %" PRIu64 "\n",
+            dtMin, dtSum / ((uint64_t)frames - lost), dtMax,
+            percentile((uint64_t)frames - lost, 0.5), percentile((uint64_t)frames - lost, 0.99),
+            percentile((uint64_t)frames - lost, 0.999), lost);
+    for (b = 0U; b <= NUM_BUCKETS; b++) {
+        if (!histogram[b])
+            continue;
+        if (b < NUM_BUCKETS)
+            fprintf(stdout, "%5u..%-5u %8" PRIu64 " ", b * BUCKET_US, (b + 1U) * BUCKET_US, histogram[b]);
+        else
+            fprintf(stdout, "%5u..     %8" PRIu64 " ", b * BUCKET_US, histogram[b]);
+        for (w = 0U; w < (unsigned int)((histogram[b] * 50U) / ((uint64_t)frames - lost)) + 1U; w++)
+            fputc('*', stdout);
+        fputc('\n', stdout);
+    }
+    return 0;
+}
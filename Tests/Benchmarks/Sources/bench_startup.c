@@ -0,0 +1,145 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_startup - time to open, start, stop and close a CAN channel
+//
+//  usage: bench_startup [-c <channel>] [-n <cycles>] [-f]
+//
+//  Each cycle calls can_init, can_start (250 kbit/s or 500/2000 kbit/s in CAN FD
+//  mode with option -f), can_reset and can_exit on the given channel, and
+//  the duration of each call is recorded.  can_init covers the device queries
+//  of the driver (card, software, transceiver, capabilities) and can_start
+//  the resets of the statistics and error counters.
+//
+#include "can_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define PHASES  4
+
+typedef struct {
+    const char *name;
+    uint64_t nsMin;
+    uint64_t nsMax;
+    uint64_t nsSum;
+} phase_t;
+
+static phase_t phase[PHASES] = {
+    { "can_init",  UINT64_MAX, 0U, 0U },
+    { "can_start", UINT64_MAX, 0U, 0U },
+    { "can_reset", UINT64_MAX, 0U, 0U },
+    { "can_exit",  UINT64_MAX, 0U, 0U }
+};
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void record(int i, uint64_t dt) {
+    if (dt < phase[i].nsMin) phase[i].nsMin = dt;
+    if (dt > phase[i].nsMax) phase[i].nsMax = dt;
+    phase[i].nsSum += dt;
+}
+
+int main(int argc, char *argv[]) {
+    int channel = 0, cycles = 20;
+    bool canFd = false;
+    uint8_t mode = CANMODE_DEFAULT;
+    can_bitrate_t bitrate;
+    uint64_t t0, t1;
+    int opt, i, rc, handle;
+
+    while ((opt = getopt(argc, argv, "c:n:fh")) != -1) {
+        switch (opt) {
+            case 'c': channel = atoi(optarg); break;
+            case 'n': cycles = atoi(optarg); break;
+            case 'f': canFd = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-c <channel>] [-n <cycles>] [-f]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((channel < 0) || (cycles < 1)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "%s\n", can_version());
+
+    /* bit-rate settings */
+    memset(&bitrate, 0, sizeof(can_bitrate_t));
+    if (canFd) {
+        mode = CANMODE_FDOE | CANMODE_BRSE;
+        bitrate.btr.frequency = 80000000;
+        bitrate.btr.nominal.brp = 2;
+        bitrate.btr.nominal.tseg1 = 63;
+        bitrate.btr.nominal.tseg2 = 16;
+        bitrate.btr.nominal.sjw = 16;
+        bitrate.btr.data.brp = 2;
+        bitrate.btr.data.tseg1 = 15;
+        bitrate.btr.data.tseg2 = 4;
+        bitrate.btr.data.sjw = 4;
+    } else
+        bitrate.index = CANBTR_INDEX_250K;
+
+    /* open, start, stop and close the channel */
+    t0 = nanoseconds();
+    for (i = 0; i < cycles; i++) {
+        t1 = nanoseconds();
+        if ((handle = can_init(channel, mode, NULL)) < CANERR_NOERROR) {
+            fprintf(stderr, "+++ error: channel %i could not be initialized (%i)\n", channel, handle);
+            return 1;
+        }
+        record(0, nanoseconds() - t1);
+        t1 = nanoseconds();
+        if ((rc = can_start(handle, &bitrate)) != CANERR_NOERROR) {
+            fprintf(stderr, "+++ error: channel %i could not be started (%i)\n", channel, rc);
+            (void)can_exit(handle);
+            return 1;
+        }
+        record(1, nanoseconds() - t1);
+        t1 = nanoseconds();
+        (void)can_reset(handle);
+        record(2, nanoseconds() - t1);
+        t1 = nanoseconds();
+        (void)can_exit(handle);
+        record(3, nanoseconds() - t1);
+    }
+    t1 = nanoseconds();
+
+    /* the result */
+    fprintf(stdout, "Channel: %i (%s), cycles: %i\n", channel, canFd ? "CAN FD" : "CAN CC", cycles);
+    fprintf(stdout, "Call        Min[ms]   Avg[ms]   Max[ms]\n");
+    for (i = 0; i < PHASES; i++) {
+        fprintf(stdout, "%-9s  %8.3f  %8.3f  %8.3f\n", phase[i].name, (double)phase[i].nsMin / 1e6,
+                (double)phase[i].nsSum / (double)cycles / 1e6, (double)phase[i].nsMax / 1e6);
+    }
+    fprintf(stdout, "Total: %i cycles in %.3fs = %.3f ms/cycle\n", cycles,
+            (double)(t1 - t0) / 1e9, (double)(t1 - t0) / (double)cycles / 1e6);
+    return 0;
+}
@@ -0,0 +1,169 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_trace - cost of a trace point of the lock-free trace ring (MacCAN_Trace)
+//
+//  usage: bench_trace [-n <records>] [-t <threads>] [-o <file>] [-f text|json|bin]
+//         bench_trace -x <file> [-f text|json]
+//
+//  Every thread hits a trace point N times: with tracing disabled at run-time,
+//  with tracing enabled but nobody draining the rings (oldest records are
+//  overwritten), and with the background drain writing into a file (option -o,
+//  default format is Chrome trace JSON).  The time per trace point is measured
+//  for each case.  With option -x a binary trace file is decoded to stdout
+//  (offline decoder).
+//
+#include "MacCAN_Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <inttypes.h>
+
+#define MAX_THREADS  64
+
+typedef struct {
+    pthread_t thread;
+    uint64_t count;
+    uint64_t nsTotal;
+} __attribute__((aligned(128))) worker_t;
+
+static worker_t worker[MAX_THREADS];
+static volatile bool running = false;
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void *hammer(void *arg) {
+    worker_t *self = (worker_t*)arg;
+    uint8_t buffer[8] = { 0x18U, 0x0CU, 0x00U, 0x01U, 0x23U, 0x45U, 0x67U, 0x89U };
+    uint64_t i, t0;
+
+    while (!running)
+        ;
+    t0 = nanoseconds();
+    for (i = 0U; i < self->count; i++) {
+        MACCAN_TRACE(CANTRC_CMD_DECODED, i, CANTRC_Word(buffer, sizeof(buffer)));
+    }
+    self->nsTotal = nanoseconds() - t0;
+    return NULL;
+}
+
+static double run(int numThreads, uint64_t count) {
+    uint64_t total = 0U;
+    int i;
+
+    running = false;
+    for (i = 0; i < numThreads; i++) {
+        worker[i].count = count;
+        worker[i].nsTotal = 0U;
+        if (pthread_create(&worker[i].thread, NULL, hammer, (void*)&worker[i]) != 0) {
+            fprintf(stderr, "+++ error: thread #%i could not be created\n", i);
+            exit(1);
+        }
+    }
+    running = true;
+    for (i = 0; i < numThreads; i++) {
+        (void)pthread_join(worker[i].thread, NULL);
+        total += worker[i].nsTotal;
+    }
+    return (double)total / ((double)count * (double)numThreads);
+}
+
+static int format_from_name(const char *name) {
+    if (!strcmp(name, "text")) return CANTRC_FORMAT_TEXT;
+    if (!strcmp(name, "json")) return CANTRC_FORMAT_JSON;
+    if (!strcmp(name, "bin")) return CANTRC_FORMAT_BINARY;
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t count = 1000000U;
+    int numThreads = 1;
+    int format = CANTRC_FORMAT_JSON;
+    char *file = NULL, *input = NULL;
+    CANTRC_Record_t records[256];
+    uint64_t lost, drained = 0U;
+    size_t n;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:o:f:x:h")) != -1) {
+        switch (opt) {
+            case 'n': count = strtoull(optarg, NULL, 10); break;
+            case 't': numThreads = atoi(optarg); break;
+            case 'o': file = optarg; break;
+            case 'f': format = format_from_name(optarg); break;
+            case 'x': input = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n <records>] [-t <threads>] [-o <file>] [-f text|json|bin]\n", argv[0]);
+                fprintf(stderr, "       %s -x <file> [-f text|json]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((count < 1U) || (numThreads < 1) || (numThreads > MAX_THREADS) || (format < 0)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    /* offline decoder */
+    if (input) {
+        if (CANTRC_Convert(input, stdout, (format == CANTRC_FORMAT_BINARY) ? CANTRC_FORMAT_JSON : format) != 0) {
+            fprintf(stderr, "+++ error: trace file '%s' could not be decoded\n", input);
+            return 1;
+        }
+        return 0;
+    }
+    fprintf(stdout, "Trace ring: %u records per thread, %zu bytes per record\n", (unsigned)CANTRC_RING_SIZE, sizeof(CANTRC_Record_t));
+    fprintf(stdout, "Threads: %i, trace points: %" PRIu64 " per thread\n", numThreads, count);
+
+    /* 1. tracing disabled at run-time */
+    (void)CANTRC_Enable(false);
+    fprintf(stdout, "Disabled:  %7.2f ns per trace point\n", run(numThreads, count));
+
+    /* 2. tracing enabled, nobody drains */
+    (void)CANTRC_Enable(true);
+    fprintf(stdout, "Enabled:   %7.2f ns per trace point\n", run(numThreads, count));
+    (void)CANTRC_Enable(false);
+    while ((n = CANTRC_Drain(records, 256U, &lost)) > 0U)
+        drained += n;
+    fprintf(stdout, "           %" PRIu64 " record(s) left in the rings\n", drained);
+
+    /* 3. tracing enabled with the background drain */
+    if (file) {
+        if (CANTRC_Open(file, format) != 0) {
+            fprintf(stderr, "+++ error: trace file '%s' could not be created\n", file);
+            return 1;
+        }
+        fprintf(stdout, "Draining:  %7.2f ns per trace point\n", run(numThreads, count));
+        if (CANTRC_Close() != 0) {
+            fprintf(stderr, "+++ error: trace file '%s' could not be written\n", file);
+            return 1;
+        }
+        fprintf(stdout, "           written to %s\n", file);
+    }
+    return 0;
+}
@@ -0,0 +1,454 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_urb - decode and encode throughput of the Leaf and Mhydra drivers
+//
+//  usage: bench_urb [-n <passes>] [-f <frames>] [-u <urb-size>] [-e <event-%>] [-d leaf|mhydra|all]
+//
+//  A synthetic URB stream (deterministic, generated once per driver) is fed
+//  into the reception callback of the driver, as the USB pipe would do it:
+//  - Leaf: classic CAN frames (std/xtd/rtr), error frames, chip state events,
+//    CAN error events and transmit acknowledges; whole commands per URB
+//    (the Leaf callback has no retention buffer, the firmware never splits).
+//  - Mhydra: classic CAN and CAN FD frames (DLC 0..15, BRS), error frames and
+//    the same events; the stream is cut at exact URB boundaries, so commands
+//    are split across URBs and go through the Hydra retention buffer.
+//  The first pass is checked against the generated frames.  The encoders are
+//  measured per CAN frame (FillTxCanMessageReq) and batched (xxx_SendMessages,
+//  16 frames per bulk transfer; the USB write pipe is a stub).
+//
+//  On Linux, cache misses are counted by the perf_event interface, if allowed.
+//
+#include "bench_urb.h"
+#include "KvaserUSB_LeafDevice.h"
+#include "KvaserUSB_MhydraDevice.h"
+#include "KvaserUSB_LoadMeter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#endif
+#include <inttypes.h>
+
+#define DEFAULT_PASSES  100
+#define DEFAULT_FRAMES  4096
+#define DEFAULT_URB_SIZE  512
+#define DEFAULT_EVENTS  5
+
+#define MAX_URB_SIZE  (KVASER_HYDRA_RETENTION_SIZE / 2)
+#define MIN_URB_SIZE  URB_HYDRA_MAX_COMMAND
+
+#define LEAF_TIMER_FREQ  24U
+#define HYDRA_TIMER_FREQ  80U
+#define HYDRA_CHANNEL_HE  2U
+
+typedef struct urb_stream_t_ {
+    uint8_t *data;                      /* concatenated URBs */
+    uint32_t *length;                   /* length of each URB */
+    uint32_t urbs;                      /* number of URBs */
+    uint32_t bytes;                     /* number of bytes */
+    KvaserUSB_CanMessage_t *frames;     /* expected CAN frames (incl. error frames) */
+    uint32_t numFrames;                 /* number of CAN frames */
+    uint32_t numEvents;                 /* number of event messages */
+    KvaserUSB_CanMessage_t *txFrames;   /* CAN frames to be sent (w/o error frames) */
+    uint32_t numTxFrames;               /* number of CAN frames to be sent */
+} urb_stream_t;
+
+typedef struct urb_result_t_ {
+    uint64_t nsDecode;
+    uint64_t nsEncode;
+    uint64_t nsSend;
+    int64_t cacheMisses;                /* -1 = not available */
+} urb_result_t;
+
+static uint32_t seed = 0x4B564153U;
+
+static uint32_t lcg(void) {
+    seed = (seed * 1103515245U) + 12345U;
+    return (seed >> 8);
+}
+
+static uint64_t nanoseconds(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+#if defined(__linux__)
+static int perf_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+static void perf_start(int fd) {
+    if (fd >= 0) {
+        (void)ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        (void)ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+static int64_t perf_stop(int fd) {
+    uint64_t count = 0U;
+    if (fd < 0)
+        return -1;
+    (void)ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+        return -1;
+    return (int64_t)count;
+}
+#else
+static int perf_open(void) { return -1; }
+static void perf_start(int fd) { (void)fd; }
+static int64_t perf_stop(int fd) { (void)fd; return -1; }
+#endif
+
+static const uint8_t dlc2len[16] = { 0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64 };
+
+static void random_frame(KvaserUSB_CanMessage_t *msg, bool canFd) {
+    uint32_t kind = lcg() % 16U;
+    uint8_t length;
+
+    memset(msg, 0, sizeof(KvaserUSB_CanMessage_t));
+    if (kind == 0U) {                   /* error frame */
+        msg->sts = 1;
+        msg->dlc = 4U;
+        for (int i = 0; i < 4; i++)
+            msg->data[i] = (uint8_t)lcg();
+        return;
+    }
+    msg->xtd = (kind & 0x1U) ? 1 : 0;
+    msg->id = msg->xtd ? (lcg() & CAN_MAX_XTD_ID) : (lcg() & CAN_MAX_STD_ID);
+    if (canFd && (kind >= 8U)) {        /* CAN FD frame (w/ or w/o BRS) */
+        msg->fdf = 1;
+        msg->brs = (kind & 0x2U) ? 1 : 0;
+        msg->dlc = (uint8_t)(lcg() % 16U);
+    } else if (kind == 2U) {            /* remote frame */
+        msg->rtr = 1;
+        msg->dlc = (uint8_t)(lcg() % 9U);
+        return;
+    } else {                            /* classic CAN frame */
+        msg->dlc = (uint8_t)(lcg() % 9U);
+    }
+    length = dlc2len[msg->dlc];
+    for (uint8_t i = 0U; i < length; i++)
+        msg->data[i] = (uint8_t)lcg();
+}
+
+static bool alloc_stream(urb_stream_t *stream, uint32_t frames, uint32_t events, uint32_t maxCommand) {
+    size_t maxBytes = (size_t)(frames + events) * maxCommand;
+
+    memset(stream, 0, sizeof(urb_stream_t));
+    stream->data = (uint8_t*)malloc(maxBytes);
+    stream->length = (uint32_t*)calloc(maxBytes / KVASER_MIN_COMMAND_LENGTH + 1U, sizeof(uint32_t));
+    stream->frames = (KvaserUSB_CanMessage_t*)calloc(frames, sizeof(KvaserUSB_CanMessage_t));
+    stream->txFrames = (KvaserUSB_CanMessage_t*)calloc(frames, sizeof(KvaserUSB_CanMessage_t));
+    return (stream->data && stream->length && stream->frames && stream->txFrames);
+}
+
+static void free_stream(urb_stream_t *stream) {
+    free(stream->data);
+    free(stream->length);
+    free(stream->frames);
+    free(stream->txFrames);
+    memset(stream, 0, sizeof(urb_stream_t));
+}
+
+static uint32_t event_command(uint8_t *buffer, bool hydra, uint32_t n, uint64_t ticks) {
+    uint8_t busStatus = (uint8_t)(lcg() & 0xE0U);  /* M16C_BUS_xxx */
+    uint8_t txErr = (uint8_t)lcg(), rxErr = (uint8_t)lcg();
+
+    switch (n % 3U) {
+        case 0U:
+            return hydra ? Mhydra_BenchChipState(buffer, HYDRA_CHANNEL_HE, busStatus, txErr, rxErr, ticks)
+                         : Leaf_BenchChipState(buffer, 0U, busStatus, txErr, rxErr, ticks);
+        case 1U:
+            return hydra ? Mhydra_BenchCanError(buffer, HYDRA_CHANNEL_HE, busStatus, txErr, rxErr, ticks)
+                         : Leaf_BenchCanError(buffer, 0U, busStatus, txErr, rxErr, ticks);
+        default:
+            return hydra ? Mhydra_BenchTxAck(buffer, HYDRA_CHANNEL_HE, (uint8_t)n, ticks)
+                         : Leaf_BenchTxAck(buffer, 0U, (uint8_t)n, ticks);
+    }
+}
+
+static bool build_stream(urb_stream_t *stream, bool hydra, uint32_t frames, uint32_t eventPct, uint32_t urbSize) {
+    uint8_t command[URB_HYDRA_MAX_COMMAND];
+    uint32_t maxCommand = hydra ? URB_HYDRA_MAX_COMMAND : URB_LEAF_MAX_COMMAND;
+    uint32_t nbyte, urbLength = 0U;
+    uint64_t ticks = 0U;
+
+    if (!alloc_stream(stream, frames, frames, maxCommand))
+        return false;
+    while (stream->numFrames < frames) {
+        ticks += 1U + (lcg() % 1000U);
+        if ((lcg() % 100U) < eventPct) {
+            nbyte = event_command(command, hydra, stream->numEvents, ticks);
+            stream->numEvents++;
+        } else {
+            KvaserUSB_CanMessage_t *msg = &stream->frames[stream->numFrames++];
+            random_frame(msg, hydra);
+            nbyte = hydra ? Mhydra_BenchRxMessage(command, HYDRA_CHANNEL_HE, msg, ticks)
+                          : Leaf_BenchLogMessage(command, 0U, msg, ticks);
+            if (!msg->sts)
+                stream->txFrames[stream->numTxFrames++] = *msg;
+        }
+        if (!hydra) {
+            /* Leaf: a command never crosses a transfer */
+            if ((urbLength + nbyte) > urbSize) {
+                stream->length[stream->urbs++] = urbLength;
+                urbLength = 0U;
+            }
+            urbLength += nbyte;
+        }
+        memcpy(&stream->data[stream->bytes], command, (size_t)nbyte);
+        stream->bytes += nbyte;
+    }
+    if (!hydra) {
+        if (urbLength)
+            stream->length[stream->urbs++] = urbLength;
+    } else {
+        /* Hydra: cut the stream into transfers of equal size */
+        for (uint32_t offset = 0U; offset < stream->bytes; offset += urbSize)
+            stream->length[stream->urbs++] = ((stream->bytes - offset) < urbSize) ? (stream->bytes - offset) : urbSize;
+    }
+    return true;
+}
+
+static bool setup_device(KvaserUSB_Device_t *device, KvaserUSB_UsbReader_t *reader, bool hydra, uint32_t frames) {
+    KvaserUSB_BusParamsFd_t params;
+
+    memset(device, 0, sizeof(KvaserUSB_Device_t));
+    memset(reader, 0, sizeof(KvaserUSB_UsbReader_t));
+    device->driverType = hydra ? USB_MHYDRA_DRIVER : USB_LEAF_DRIVER;
+    device->configured = true;
+    device->channelNo = 0U;
+    device->numChannels = 1U;
+    device->endpoints.bulkOut.packetSize = 64U;
+    device->hydraData.channel2he = HYDRA_CHANNEL_HE;
+    device->hydraData.he2channel = 0U;
+    device->usbReader = reader;
+    device->recvData.msgPipe = CANPIP_Create();
+    device->recvData.msgQueue = CANQUE_Create((size_t)frames, sizeof(KvaserUSB_CanMessage_t));
+    device->recvData.opMode = CANMODE_ERR | (hydra ? (CANMODE_FDOE | CANMODE_BRSE) : 0x00U);
+    device->recvData.canClock = hydra ? HYDRA_TIMER_FREQ : LEAF_TIMER_FREQ;
+    device->recvData.timerFreq = hydra ? HYDRA_TIMER_FREQ : LEAF_TIMER_FREQ;
+    device->recvData.txAck.maxMsg = 255U;
+    device->recvData.txAck.noAck = true;
+    memset(&params, 0, sizeof(params));
+    params.nominal.bitRate = 500000U;
+    params.data.bitRate = 2000000U;
+    params.canFd = hydra;
+    LoadMeter_Configure(&device->recvData.loadMeter, &params);
+    LoadMeter_Restart(&device->recvData.loadMeter, LoadMeter_Now());
+    memset(reader->he2channel, 0xFF, sizeof(reader->he2channel));
+    reader->he2channel[HYDRA_CHANNEL_HE] = 0U;
+    reader->recvData[0] = &device->recvData;
+    reader->refCount = 1U;
+    return (device->recvData.msgPipe && device->recvData.msgQueue);
+}
+
+static void teardown_device(KvaserUSB_Device_t *device) {
+    (void)CANQUE_Destroy(device->recvData.msgQueue);
+    (void)CANPIP_Destroy(device->recvData.msgPipe);
+}
+
+static void feed_stream(const urb_stream_t *stream, KvaserUSB_UsbReader_t *reader, bool hydra) {
+    uint8_t *urb = stream->data;
+
+    for (uint32_t i = 0U; i < stream->urbs; i++) {
+        if (hydra)
+            Mhydra_BenchReception((void*)reader, urb, stream->length[i]);
+        else
+            Leaf_BenchReception((void*)reader, urb, stream->length[i]);
+        urb += stream->length[i];
+    }
+}
+
+static uint32_t verify_stream(const urb_stream_t *stream, KvaserUSB_Device_t *device) {
+    KvaserUSB_CanMessage_t msg;
+    uint32_t n = 0U, errors = 0U;
+
+    while (CANQUE_Dequeue(device->recvData.msgQueue, (void*)&msg, 0U) == CANUSB_SUCCESS) {
+        const KvaserUSB_CanMessage_t *exp = &stream->frames[n];
+        uint8_t length = (exp->rtr) ? 0U : dlc2len[exp->dlc];
+        if ((n >= stream->numFrames) ||
+            (msg.id != exp->id) || (msg.dlc != exp->dlc) ||
+            (msg.xtd != exp->xtd) || (msg.rtr != exp->rtr) || (msg.sts != exp->sts) ||
+            (msg.fdf != exp->fdf) || (msg.brs != exp->brs) || (msg.esi != exp->esi) ||
+            memcmp(msg.data, exp->data, (size_t)length)) {
+            if (errors++ < 5U)
+                fprintf(stderr, "+++ error: frame #%u decoded wrong (id=%" PRIx32 ", dlc=%u)\n", n, msg.id, msg.dlc);
+        }
+        n++;
+    }
+    if (n != stream->numFrames) {
+        fprintf(stderr, "+++ error: %u of %u frames decoded\n", n, stream->numFrames);
+        errors++;
+    }
+    return errors;
+}
+
+static bool run_driver(bool hydra, int passes, uint32_t frames, uint32_t eventPct, uint32_t urbSize, urb_result_t *result) {
+    KvaserUSB_Device_t device;
+    KvaserUSB_UsbReader_t reader;
+    urb_stream_t stream;
+    uint8_t command[URB_HYDRA_MAX_COMMAND];
+    uint64_t t0, sink = 0U;
+    int fd, p;
+    bool ok = true;
+
+    memset(result, 0, sizeof(urb_result_t));
+    seed = hydra ? 0x4D485944U : 0x4C454146U;
+    if (!build_stream(&stream, hydra, frames, eventPct, urbSize)) {
+        fprintf(stderr, "+++ error: out of memory\n");
+        return false;
+    }
+    if (!setup_device(&device, &reader, hydra, frames)) {
+        fprintf(stderr, "+++ error: message queue or pipe could not be created\n");
+        free_stream(&stream);
+        return false;
+    }
+    fprintf(stdout, "%s: %u frames + %u events in %u URBs (%u bytes)\n", hydra ? "Mhydra" : "Leaf",
+            stream.numFrames, stream.numEvents, stream.urbs, stream.bytes);
+
+    /* first pass: decode and check */
+    feed_stream(&stream, &reader, hydra);
+    if (verify_stream(&stream, &device) != 0U)
+        ok = false;
+
+    /* decode: feed the URBs into the reception callback */
+    fd = perf_open();
+    for (p = 0; p < passes; p++) {
+        (void)CANQUE_Reset(device.recvData.msgQueue);
+        perf_start(fd);
+        t0 = nanoseconds();
+        feed_stream(&stream, &reader, hydra);
+        result->nsDecode += nanoseconds() - t0;
+        int64_t misses = perf_stop(fd);
+        result->cacheMisses = (misses >= 0) ? (result->cacheMisses + misses) : -1;
+    }
+    if (fd >= 0)
+        (void)close(fd);
+
+    /* encode: one command per CAN frame */
+    t0 = nanoseconds();
+    for (p = 0; p < passes; p++) {
+        for (uint32_t i = 0U; i < stream.numTxFrames; i++) {
+            sink += hydra ? Mhydra_BenchEncode(command, URB_HYDRA_MAX_COMMAND, HYDRA_CHANNEL_HE, (uint8_t)i, &stream.txFrames[i])
+                          : Leaf_BenchEncode(command, URB_LEAF_MAX_COMMAND, 0U, (uint8_t)i, &stream.txFrames[i]);
+        }
+    }
+    result->nsEncode = nanoseconds() - t0;
+
+    /* send: batches of KVASER_MAX_TX_BATCH frames (w/o acknowledge) */
+    UrbStub_BytesWritten = 0U;
+    t0 = nanoseconds();
+    for (p = 0; p < passes; p++) {
+        for (uint32_t i = 0U; i < stream.numTxFrames; i += KVASER_MAX_TX_BATCH) {
+            uint32_t count = ((stream.numTxFrames - i) < KVASER_MAX_TX_BATCH) ? (stream.numTxFrames - i) : KVASER_MAX_TX_BATCH;
+            device.recvData.txAck.cntMsg = 0U;
+            CANUSB_Return_t rc = hydra ? Mhydra_SendMessages(&device, &stream.txFrames[i], count)
+                                       : Leaf_SendMessages(&device, &stream.txFrames[i], count);
+            if ((rc != CANUSB_SUCCESS) && ok) {
+                fprintf(stderr, "+++ error: %s_SendMessages returned %i\n", hydra ? "Mhydra" : "Leaf", rc);
+                ok = false;
+            }
+        }
+    }
+    result->nsSend = nanoseconds() - t0;
+    if (sink == 0U)
+        fprintf(stderr, "+++ error: nothing encoded\n");
+
+    /* the result */
+    double frames_ = (double)stream.numFrames * passes;
+    double urbs = (double)stream.urbs * passes;
+    double bytes = (double)stream.bytes * passes;
+    double txFrames = (double)stream.numTxFrames * passes;
+    fprintf(stdout, "  decode: %10.0f frames/s  %8.1f ns/frame  %8.1f ns/URB  %8.1f MB/s",
+            frames_ / ((double)result->nsDecode / 1e9), (double)result->nsDecode / frames_,
+            (double)result->nsDecode / urbs, bytes / ((double)result->nsDecode / 1e3));
+    if (result->cacheMisses >= 0)
+        fprintf(stdout, "  %8.3f cache misses/frame\n", (double)result->cacheMisses / frames_);
+    else
+        fprintf(stdout, "  cache misses: n/a\n");
+    fprintf(stdout, "  encode: %10.0f frames/s  %8.1f ns/frame\n",
+            txFrames / ((double)result->nsEncode / 1e9), (double)result->nsEncode / txFrames);
+    fprintf(stdout, "  send:   %10.0f frames/s  %8.1f ns/frame  %8.1f MB/s (batches of %u)\n",
+            txFrames / ((double)result->nsSend / 1e9), (double)result->nsSend / txFrames,
+            (double)UrbStub_BytesWritten / ((double)result->nsSend / 1e3), KVASER_MAX_TX_BATCH);
+    fprintf(stdout, "  check:  %s\n", ok ? "passed" : "FAILED");
+
+    teardown_device(&device);
+    free_stream(&stream);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    int passes = DEFAULT_PASSES;
+    int frames = DEFAULT_FRAMES;
+    int urbSize = DEFAULT_URB_SIZE;
+    int eventPct = DEFAULT_EVENTS;
+    bool leaf = true, mhydra = true;
+    urb_result_t result;
+    bool ok = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:f:u:e:d:h")) != -1) {
+        switch (opt) {
+            case 'n': passes = atoi(optarg); break;
+            case 'f': frames = atoi(optarg); break;
+            case 'u': urbSize = atoi(optarg); break;
+            case 'e': eventPct = atoi(optarg); break;
+            case 'd':
+                if (!strcmp(optarg, "leaf")) { leaf = true; mhydra = false; }
+                else if (!strcmp(optarg, "mhydra")) { leaf = false; mhydra = true; }
+                else if (!strcmp(optarg, "all")) { leaf = true; mhydra = true; }
+                else { fprintf(stderr, "%s: illegal driver '%s'\n", argv[0], optarg); return 1; }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n <passes>] [-f <frames>] [-u <urb-size>] [-e <event-%%>] [-d leaf|mhydra|all]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((passes < 1) || (frames < 1) || (frames > 1000000) ||
+        (urbSize < (int)MIN_URB_SIZE) || (urbSize > (int)MAX_URB_SIZE) ||
+        (eventPct < 0) || (eventPct > 90)) {
+        fprintf(stderr, "%s: illegal argument\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "Passes: %i, frames: %i, URB size: %i, events: %i%%\n", passes, frames, urbSize, eventPct);
+
+    if (leaf)
+        ok &= run_driver(false, passes, (uint32_t)frames, (uint32_t)eventPct, (uint32_t)urbSize, &result);
+    if (mhydra)
+        ok &= run_driver(true, passes, (uint32_t)frames, (uint32_t)eventPct, (uint32_t)urbSize, &result);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_urb - the Leaf and Mhydra drivers made accessible to the benchmark
+//
+//  The reception callbacks and the encoders of the drivers are static functions,
+//  so the driver sources are included by 'bench_urb_leaf.c' and 'bench_urb_mhydra.c'
+//  and wrapped by the functions below.  The other functions generate Kvaser USB
+//  commands (as the firmware sends them) for the synthetic URB streams.
+//
+#ifndef BENCH_URB_H_INCLUDED
+#define BENCH_URB_H_INCLUDED
+
+#include "KvaserUSB_Device.h"
+
+#define URB_LEAF_MAX_COMMAND  KVASER_MAX_COMMAND_LENGTH
+#define URB_HYDRA_MAX_COMMAND  KVASER_HYDRA_EXT_COMMAND_LENGTH
+
+/* Leaf devices (KvaserUSB_LeafDevice.c) */
+extern void Leaf_BenchReception(void *refCon, uint8_t *buffer, uint32_t size);
+extern uint32_t Leaf_BenchEncode(uint8_t *buffer, uint32_t maxbyte, uint8_t channel, uint8_t transId, const KvaserUSB_CanMessage_t *message);
+extern uint32_t Leaf_BenchLogMessage(uint8_t *buffer, uint8_t channel, const KvaserUSB_CanMessage_t *message, uint64_t ticks);
+extern uint32_t Leaf_BenchChipState(uint8_t *buffer, uint8_t channel, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks);
+extern uint32_t Leaf_BenchCanError(uint8_t *buffer, uint8_t channel, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks);
+extern uint32_t Leaf_BenchTxAck(uint8_t *buffer, uint8_t channel, uint8_t transId, uint64_t ticks);
+
+/* Mhydra devices (KvaserUSB_MhydraDevice.c) */
+extern void Mhydra_BenchReception(void *refCon, uint8_t *buffer, uint32_t size);
+extern uint32_t Mhydra_BenchEncode(uint8_t *buffer, uint32_t maxbyte, uint8_t he, uint8_t transId, const KvaserUSB_CanMessage_t *message);
+extern uint32_t Mhydra_BenchRxMessage(uint8_t *buffer, uint8_t he, const KvaserUSB_CanMessage_t *message, uint64_t ticks);
+extern uint32_t Mhydra_BenchChipState(uint8_t *buffer, uint8_t he, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks);
+extern uint32_t Mhydra_BenchCanError(uint8_t *buffer, uint8_t he, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks);
+extern uint32_t Mhydra_BenchTxAck(uint8_t *buffer, uint8_t he, uint8_t transId, uint64_t ticks);
+
+/* USB write pipe (bench_urb_stubs.c) */
+extern uint64_t UrbStub_BytesWritten;
+
+#endif /* BENCH_URB_H_INCLUDED */
@@ -0,0 +1,100 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_urb_leaf - the Leaf driver made accessible to bench_urb (see bench_urb.h)
+//
+#include "KvaserUSB_LeafDevice.c"
+#include "bench_urb.h"
+
+void Leaf_BenchReception(void *refCon, uint8_t *buffer, uint32_t size) {
+    ReceptionCallback(refCon, (UInt8*)buffer, (UInt32)size);
+}
+
+uint32_t Leaf_BenchEncode(uint8_t *buffer, uint32_t maxbyte, uint8_t channel, uint8_t transId, const KvaserUSB_CanMessage_t *message) {
+    return FillTxCanMessageReq(buffer, maxbyte, channel, transId, message);
+}
+
+static void PutTime(uint8_t *buffer, uint64_t ticks) {
+    /* - byte 4..9: time (48-bit, little endian) */
+    for (int i = 0; i < 6; i++)
+        buffer[4 + i] = (uint8_t)(ticks >> (8 * i));
+}
+
+uint32_t Leaf_BenchLogMessage(uint8_t *buffer, uint8_t channel, const KvaserUSB_CanMessage_t *message, uint64_t ticks) {
+    uint32_t id = message->id | (message->xtd ? 0x80000000U : 0x0U);
+    uint8_t flags = 0x00U;
+
+    /* logged message (cf. DecodeMessage) */
+    bzero(buffer, LEN_LOG_MESSAGE);
+    flags |= message->rtr ? MSGFLAG_REMOTE_FRAME : 0x00U;
+    flags |= message->sts ? MSGFLAG_ERROR_FRAME : 0x00U;
+    buffer[0] = LEN_LOG_MESSAGE;
+    buffer[1] = CMD_LOG_MESSAGE;
+    buffer[2] = UINT8BYTE(channel);
+    buffer[3] = UINT8BYTE(flags);
+    PutTime(buffer, ticks);
+    buffer[10] = UINT8BYTE(message->dlc);
+    buffer[11] = UINT8BYTE(0x00);
+    buffer[12] = UINT32LOLO(id);
+    buffer[13] = UINT32LOHI(id);
+    buffer[14] = UINT32HILO(id);
+    buffer[15] = UINT32HIHI(id);
+    memcpy(&buffer[16], message->data, CAN_MAX_LEN);
+    return LEN_LOG_MESSAGE;
+}
+
+uint32_t Leaf_BenchChipState(uint8_t *buffer, uint8_t channel, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks) {
+    /* chip state event (cf. UpdateEventData) */
+    bzero(buffer, LEN_CHIP_STATE_EVENT);
+    buffer[0] = LEN_CHIP_STATE_EVENT;
+    buffer[1] = CMD_CHIP_STATE_EVENT;
+    buffer[2] = UINT8BYTE(0x00);
+    buffer[3] = UINT8BYTE(channel);
+    PutTime(buffer, ticks);
+    buffer[10] = UINT8BYTE(txErr);
+    buffer[11] = UINT8BYTE(rxErr);
+    buffer[12] = UINT8BYTE(busStatus);
+    return LEN_CHIP_STATE_EVENT;
+}
+
+uint32_t Leaf_BenchCanError(uint8_t *buffer, uint8_t channel, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks) {
+    /* CAN error event (cf. UpdateEventData) */
+    bzero(buffer, LEN_CAN_ERROR_EVENT);
+    buffer[0] = LEN_CAN_ERROR_EVENT;
+    buffer[1] = CMD_CAN_ERROR_EVENT;
+    buffer[2] = UINT8BYTE(0x00);
+    buffer[3] = UINT8BYTE(0x00);
+    PutTime(buffer, ticks);
+    buffer[10] = UINT8BYTE(channel);
+    buffer[12] = UINT8BYTE(txErr);
+    buffer[13] = UINT8BYTE(rxErr);
+    buffer[14] = UINT8BYTE(busStatus);
+    return LEN_CAN_ERROR_EVENT;
+}
+
+uint32_t Leaf_BenchTxAck(uint8_t *buffer, uint8_t channel, uint8_t transId, uint64_t ticks) {
+    /* transmit acknowledge (cf. Leaf_SendMessage) */
+    bzero(buffer, LEN_TX_ACKNOWLEDGE);
+    buffer[0] = LEN_TX_ACKNOWLEDGE;
+    buffer[1] = CMD_TX_ACKNOWLEDGE;
+    buffer[2] = UINT8BYTE(channel);
+    buffer[3] = UINT8BYTE(transId);
+    PutTime(buffer, ticks);
+    return LEN_TX_ACKNOWLEDGE;
+}
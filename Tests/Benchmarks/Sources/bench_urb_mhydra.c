@@ -0,0 +1,113 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_urb_mhydra - the Mhydra driver made accessible to bench_urb (see bench_urb.h)
+//
+#include "KvaserUSB_MhydraDevice.c"
+#include "bench_urb.h"
+
+void Mhydra_BenchReception(void *refCon, uint8_t *buffer, uint32_t size) {
+    ReceptionCallback(refCon, (UInt8*)buffer, (UInt32)size);
+}
+
+uint32_t Mhydra_BenchEncode(uint8_t *buffer, uint32_t maxbyte, uint8_t he, uint8_t transId, const KvaserUSB_CanMessage_t *message) {
+    return FillTxCanMessageReq(buffer, maxbyte, he, transId, message);
+}
+
+static void PutHead(uint8_t *buffer, uint8_t cmdCode, uint8_t he, uint16_t seq) {
+    /* Hydra USB response:
+     * - byte 0: command code
+     * - byte 1: HE address (bit 0..5 = dst, bit 6..7 = src MSB)
+     * - byte 2..3: transaction id. (bit 0..11 = seq, bit 11..15: src LSB)
+     */
+    buffer[0] = cmdCode;
+    buffer[1] = (uint8_t)(((he >> 4) & 0x3U) << 6);
+    buffer[2] = (uint8_t)(seq & 0xFFU);
+    buffer[3] = (uint8_t)(((he & 0xFU) << 4) | ((seq >> 8) & 0xFU));
+}
+
+static void PutTime(uint8_t *buffer, uint64_t ticks, int bytes) {
+    /* - byte 4..9: time (48-bit) or byte 24..31: FPGA timestamp (64-bit), little endian */
+    for (int i = 0; i < bytes; i++)
+        buffer[i] = (uint8_t)(ticks >> (8 * i));
+}
+
+uint32_t Mhydra_BenchRxMessage(uint8_t *buffer, uint8_t he, const KvaserUSB_CanMessage_t *message, uint64_t ticks) {
+    uint8_t length = message->sts ? 4U : Dlc2Len(message->dlc);
+    uint16_t nbyte = (uint16_t)(HYDRA_CMD_SIZE + length);
+    uint32_t flags = 0x0U;
+
+    /* extended command CMD_RX_MESSAGE_FD (cf. DecodeMessage) */
+    bzero(buffer, nbyte);
+    PutHead(buffer, CMD_EXTENDED, he, 0U);
+    buffer[4] = (uint8_t)(nbyte & 0xFFU);
+    buffer[5] = (uint8_t)(nbyte >> 8);
+    buffer[6] = CMD_EXT_RX_MSG_FD;
+    flags |= message->xtd ? MSGFLAG_EXT : 0x0U;
+    flags |= message->rtr ? MSGFLAG_RTR : 0x0U;
+    flags |= message->fdf ? MSGFLAG_FDF : 0x0U;
+    flags |= message->brs ? MSGFLAG_BRS : 0x0U;
+    flags |= message->esi ? MSGFLAG_ESI : 0x0U;
+    flags |= message->sts ? MSGFLAG_STS : 0x0U;
+    buffer[8] = UINT32LOLO(flags);
+    buffer[9] = UINT32LOHI(flags);
+    buffer[10] = UINT32HILO(flags);
+    buffer[11] = UINT32HIHI(flags);
+    buffer[12] = UINT32LOLO(message->id);
+    buffer[13] = UINT32LOHI(message->id);
+    buffer[14] = UINT32HILO(message->id);
+    buffer[15] = UINT32HIHI(message->id);
+    buffer[21] = (uint8_t)(message->dlc & 0xFU);
+    PutTime(&buffer[24], ticks, 8);
+    memcpy(&buffer[32], message->data, (size_t)length);
+    return (uint32_t)nbyte;
+}
+
+uint32_t Mhydra_BenchChipState(uint8_t *buffer, uint8_t he, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks) {
+    /* chip state event (cf. UpdateEventData) */
+    bzero(buffer, HYDRA_CMD_SIZE);
+    PutHead(buffer, CMD_CHIP_STATE_EVENT, he, 0U);
+    PutTime(&buffer[4], ticks, 6);
+    buffer[10] = UINT8BYTE(txErr);
+    buffer[11] = UINT8BYTE(rxErr);
+    buffer[12] = UINT8BYTE(busStatus);
+    return HYDRA_CMD_SIZE;
+}
+
+uint32_t Mhydra_BenchCanError(uint8_t *buffer, uint8_t he, uint8_t busStatus, uint8_t txErr, uint8_t rxErr, uint64_t ticks) {
+    /* CAN error event (cf. UpdateEventData) */
+    bzero(buffer, HYDRA_CMD_SIZE);
+    PutHead(buffer, CMD_CAN_ERROR_EVENT, he, 0U);
+    PutTime(&buffer[4], ticks, 6);
+    buffer[12] = UINT8BYTE(txErr);
+    buffer[13] = UINT8BYTE(rxErr);
+    buffer[14] = UINT8BYTE(busStatus);
+    return HYDRA_CMD_SIZE;
+}
+
+uint32_t Mhydra_BenchTxAck(uint8_t *buffer, uint8_t he, uint8_t transId, uint64_t ticks) {
+    /* extended command CMD_TX_ACKNOWLEDGE_FD (cf. ReceptionCallback) */
+    bzero(buffer, HYDRA_CMD_SIZE);
+    PutHead(buffer, CMD_EXTENDED, he, (uint16_t)transId);
+    buffer[4] = (uint8_t)HYDRA_CMD_SIZE;
+    buffer[5] = 0x00U;
+    buffer[6] = CMD_EXT_TX_ACK_FD;
+    PutTime(&buffer[24], ticks, 8);
+    return HYDRA_CMD_SIZE;
+}
@@ -0,0 +1,126 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  Benchmarks for Kvaser CAN Interfaces (CAN API V3)
+//
+//  Copyright (c) 2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//  bench_urb_stubs - USB functions of MacCAN_IOUsbKit replaced for bench_urb
+//
+//  No USB device is present: a write to a pipe is only counted, all other
+//  functions fail.  The driver functions under test do not need them.
+//
+#include "MacCAN_IOUsbKit.h"
+#include "bench_urb.h"
+
+uint64_t UrbStub_BytesWritten = 0U;
+
+CANUSB_Return_t CANUSB_WritePipe(CANUSB_Handle_t handle, UInt8 pipeRef, const void *buffer, UInt32 size, UInt16 timeout) {
+    (void)handle; (void)pipeRef; (void)timeout;
+    if (!buffer)
+        return CANUSB_ERROR_NULLPTR;
+    UrbStub_BytesWritten += (uint64_t)size;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Handle_t CANUSB_OpenDevice(CANUSB_Index_t index, UInt16 vendorId, UInt16 productId) {
+    (void)index; (void)vendorId; (void)productId;
+    return CANUSB_INVALID_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_CloseDevice(CANUSB_Handle_t handle) {
+    (void)handle;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize) {
+    (void)handle; (void)pipeRef; (void)bufferSize;
+    return NULL;
+}
+
+CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    (void)asyncPipe;
+    return CANUSB_ERROR_RESOURCE;
+}
+
+CANUSB_Return_t CANUSB_AbortPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    (void)asyncPipe;
+    return CANUSB_ERROR_RESOURCE;
+}
+
+CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB_AsyncPipeCbk_t callback, CANUSB_Context_t context) {
+    (void)asyncPipe; (void)callback; (void)context;
+    return CANUSB_ERROR_RESOURCE;
+}
+
+Boolean CANUSB_IsPipeAsyncRunning(CANUSB_AsyncPipe_t asyncPipe) {
+    (void)asyncPipe;
+    return false;
+}
+
+Boolean CANUSB_IsDevicePresent(CANUSB_Index_t index) {
+    (void)index;
+    return false;
+}
+
+Boolean CANUSB_IsDeviceInUse(CANUSB_Index_t index) {
+    (void)index;
+    return false;
+}
+
+CANUSB_Return_t CANUSB_GetDeviceUsbName(CANUSB_Index_t index, char *buffer, size_t n) {
+    (void)index; (void)buffer; (void)n;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetDeviceProductId(CANUSB_Index_t index, UInt16 *value) {
+    (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetDeviceReleaseNo(CANUSB_Index_t index, UInt16 *value) {
+    (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetDeviceLocation(CANUSB_Index_t index, UInt32 *value) {
+    (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetDeviceNumCanChannels(CANUSB_Index_t index, UInt8 *value) {
+    (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceNumEndpoints(CANUSB_Handle_t handle, UInt8 *value) {
+    (void)handle; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointDirection(CANUSB_Handle_t handle, UInt8 index, UInt8 *value) {
+    (void)handle; (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointTransferType(CANUSB_Handle_t handle, UInt8 index, UInt8 *value) {
+    (void)handle; (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointMaxPacketSize(CANUSB_Handle_t handle, UInt8 index, UInt16 *value) {
+    (void)handle; (void)index; (void)value;
+    return CANUSB_ERROR_HANDLE;
+}
@@ -2320,4 +2320,338 @@
     XCTAssertEqual(BTRERR_NULLPTR, rc);
 }
 
+// @xctest TC0B.11.1: call 'btr_solve_bitrate' with valid targets (24 MHz and 80 MHz)
+//
+// @expected BTRERR_NOERROR, the candidates are within the limits and ranked
+//
+- (void)testSolveBitrateWithValidTargets {
+    const int32_t frequency[2] = { BTR_FREQ_24MHz, BTR_FREQ_80MHz };
+    const uint32_t nominal[6] = { 1000000, 500000, 250000, 125000, 50000, 10000 };
+    btr_candidate_t candidate[BTR_SOLVER_CANDIDATES];
+    btr_bitrate_t bitrate;
+    btr_speed_t speed;
+    size_t count;
+    int rc = BTRERR_FATAL;
+    // @test:
+    // @- loop over controller clocks and nominal bit-rates
+    for (int f = 0; f < 2; f++) {
+        btr_limits_t limits = BTR_NOMINAL_LIMITS(frequency[f]);
+        for (int n = 0; n < 6; n++) {
+            btr_target_t target = { nominal[n], 8750, BTR_SJW_MAXIMUM, 0 };
+            NSLog(@"Execute sub-testcase %d: %.1f MHz, %u kbps (SP=87.5%%)\n", (f * 6) + n + 1,
+                  (double)frequency[f] / 1000000.0, nominal[n] / 1000U);
+            // @-- search all candidates
+            count = BTR_SOLVER_CANDIDATES;
+            rc = btr_solve_bitrate(&limits, &target, candidate, &count);
+            XCTAssertEqual(BTRERR_NOERROR, rc);
+            XCTAssertGreaterThan(count, 0U);
+            for (size_t i = 0; i < count; i++) {
+                // @-- each candidate is within the limits and meets the bit-rate
+                XCTAssert((BTR_NOMINAL_BRP_MIN <= candidate[i].brp) && (candidate[i].brp <= BTR_NOMINAL_BRP_MAX));
+                XCTAssert((BTR_NOMINAL_TSEG1_MIN <= candidate[i].tseg1) && (candidate[i].tseg1 <= BTR_NOMINAL_TSEG1_MAX));
+                XCTAssert((BTR_NOMINAL_TSEG2_MIN <= candidate[i].tseg2) && (candidate[i].tseg2 <= BTR_NOMINAL_TSEG2_MAX));
+                XCTAssert((BTR_NOMINAL_SJW_MIN <= candidate[i].sjw) && (candidate[i].sjw <= candidate[i].tseg2));
+                XCTAssertEqual(0, candidate[i].bitrate_error);
+                bzero(&bitrate, sizeof(btr_bitrate_t));
+                bitrate.btr.frequency = frequency[f];
+                bitrate.btr.nominal.brp = candidate[i].brp;
+                bitrate.btr.nominal.tseg1 = candidate[i].tseg1;
+                bitrate.btr.nominal.tseg2 = candidate[i].tseg2;
+                bitrate.btr.nominal.sjw = candidate[i].sjw;
+                XCTAssertEqual(BTRERR_NOERROR, btr_check_bitrate(&bitrate, false, false));
+                XCTAssertEqual(BTRERR_NOERROR, btr_bitrate2speed(&bitrate, &speed));
+                XCTAssertEqual((float)nominal[n], speed.nominal.speed);
+                // @-- the candidates are ranked by their sample-point error
+                if (i > 0)
+                    XCTAssertLessThanOrEqual(abs(candidate[i-1].samplepoint_error), abs(candidate[i].samplepoint_error));
+            }
+            // @-- the best candidate has a sample-point of 87.5% (+/-1%)
+            XCTAssertLessThanOrEqual(abs(candidate[0].samplepoint_error), 100);
+        }
+    }
+}
+
+// @xctest TC0B.11.2: call 'btr_solve_bitrate' with SJW policy, tolerance and SJA1000 limits
+//
+// @expected BTRERR_NOERROR, or BTRERR_BAUDRATE if no candidate exists
+//
+- (void)testSolveBitrateWithPolicies {
+    btr_limits_t nominal = BTR_NOMINAL_LIMITS(BTR_FREQ_24MHz);
+    btr_limits_t sja1000 = BTR_SJA1000_LIMITS;
+    btr_candidate_t candidate[BTR_SOLVER_CANDIDATES];
+    btr_bitrate_t bitrate;
+    size_t count;
+    int rc = BTRERR_FATAL;
+    // @test:
+    // @- fixed SJW: all candidates have this SJW
+    btr_target_t target1 = { 500000, 8000, 2, 0 };
+    count = BTR_SOLVER_CANDIDATES;
+    rc = btr_solve_bitrate(&nominal, &target1, candidate, &count);
+    XCTAssertEqual(BTRERR_NOERROR, rc);
+    for (size_t i = 0; i < count; i++)
+        XCTAssertEqual(2U, candidate[i].sjw);
+    // @- 83.333 kbps at 24 MHz: no exact candidate
+    btr_target_t target2 = { 83333, 8750, BTR_SJW_MAXIMUM, 0 };
+    count = BTR_SOLVER_CANDIDATES;
+    rc = btr_solve_bitrate(&nominal, &target2, candidate, &count);
+    XCTAssertEqual(BTRERR_BAUDRATE, rc);
+    XCTAssertEqual(0U, count);
+    // @- 83.333 kbps at 24 MHz: with 0.1% tolerance
+    target2.tolerance = 1000;
+    count = BTR_SOLVER_CANDIDATES;
+    rc = btr_solve_bitrate(&nominal, &target2, candidate, &count);
+    XCTAssertEqual(BTRERR_NOERROR, rc);
+    XCTAssertGreaterThan(count, 0U);
+    for (size_t i = 0; i < count; i++)
+        XCTAssertLessThanOrEqual(abs(candidate[i].bitrate_error), 1000);
+    // @- 125 kbps with SJA1000 limits: the predefined bit-rate
+    btr_target_t target3 = { 125000, 8750, 1, 0 };
+    count = 1;
+    rc = btr_solve_bitrate(&sja1000, &target3, candidate, &count);
+    XCTAssertEqual(BTRERR_NOERROR, rc);
+    XCTAssertEqual(1U, count);
+    (void)btr_index2bitrate(BTR_INDEX_125K, &bitrate);
+    XCTAssertEqual(bitrate.btr.nominal.brp, candidate[0].brp);
+    XCTAssertEqual(bitrate.btr.nominal.tseg1, candidate[0].tseg1);
+    XCTAssertEqual(bitrate.btr.nominal.tseg2, candidate[0].tseg2);
+    XCTAssertEqual(bitrate.btr.nominal.sjw, candidate[0].sjw);
+}
+
+// @xctest TC0B.11.3: call 'btr_solve_bitrate' repeatedly (cached solutions)
+//
+// @expected the same candidates with and without cache
+//
+- (void)testSolveBitrateWithCache {
+    btr_limits_t limits = BTR_DATA_LIMITS(BTR_FREQ_80MHz);
+    btr_target_t target = { 2000000, 8000, BTR_SJW_MAXIMUM, 0 };
+    btr_candidate_t candidate1[BTR_SOLVER_CANDIDATES];
+    btr_candidate_t candidate2[BTR_SOLVER_CANDIDATES];
+    size_t count1, count2;
+    // @pre:
+    XCTAssertEqual(BTRERR_NOERROR, btr_flush_solutions());
+    // @test:
+    // @- search (not cached)
+    count1 = BTR_SOLVER_CANDIDATES;
+    XCTAssertEqual(BTRERR_NOERROR, btr_solve_bitrate(&limits, &target, candidate1, &count1));
+    // @- lookup (cached) more often than entries in the cache
+    for (int i = 0; i < (BTR_SOLVER_ENTRIES * 2); i++) {
+        count2 = BTR_SOLVER_CANDIDATES;
+        XCTAssertEqual(BTRERR_NOERROR, btr_solve_bitrate(&limits, &target, candidate2, &count2));
+        XCTAssertEqual(count1, count2);
+        XCTAssertEqual(0, memcmp(candidate1, candidate2, count1 * sizeof(btr_candidate_t)));
+    }
+    // @- fill the cache with other targets, then search again (replaced)
+    for (int i = 0; i < (BTR_SOLVER_ENTRIES + 1); i++) {
+        btr_target_t other = { 1000000 + (uint32_t)i * 1000U, 8000, BTR_SJW_MAXIMUM, 5000 };
+        count2 = 1;
+        (void)btr_solve_bitrate(&limits, &other, candidate2, &count2);
+    }
+    count2 = BTR_SOLVER_CANDIDATES;
+    XCTAssertEqual(BTRERR_NOERROR, btr_solve_bitrate(&limits, &target, candidate2, &count2));
+    XCTAssertEqual(count1, count2);
+    XCTAssertEqual(0, memcmp(candidate1, candidate2, count1 * sizeof(btr_candidate_t)));
+    // @- only as many candidates as requested
+    count2 = 2;
+    XCTAssertEqual(BTRERR_NOERROR, btr_solve_bitrate(&limits, &target, candidate2, &count2));
+    XCTAssertEqual(2U, count2);
+    XCTAssertEqual(0, memcmp(candidate1, candidate2, count2 * sizeof(btr_candidate_t)));
+}
+
+// @xctest TC0B.11.4: call 'btr_solve_bitrate' with invalid limits or targets
+//
+// @expected BTRERR_ILLPARA or BTRERR_NULLPTR
+//
+- (void)testSolveBitrateWithInvalidValues {
+    btr_limits_t limits = BTR_NOMINAL_LIMITS(BTR_FREQ_80MHz);
+    btr_target_t target = { 500000, 8750, BTR_SJW_MAXIMUM, 0 };
+    btr_candidate_t candidate;
+    size_t count = 1;
+    // @test:
+    // @- NULL pointer for 'limits', 'target', 'candidates' or 'count'
+    XCTAssertEqual(BTRERR_NULLPTR, btr_solve_bitrate(NULL, &target, &candidate, &count));
+    XCTAssertEqual(BTRERR_NULLPTR, btr_solve_bitrate(&limits, NULL, &candidate, &count));
+    XCTAssertEqual(BTRERR_NULLPTR, btr_solve_bitrate(&limits, &target, NULL, &count));
+    XCTAssertEqual(BTRERR_NULLPTR, btr_solve_bitrate(&limits, &target, &candidate, NULL));
+    // @- array size 0 for 'candidates'
+    count = 0;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    count = 1;
+    // @- bit-rate 0, sample-point 0% and 100%, SJW above its limit
+    target.bitrate = 0;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    target.bitrate = 500000; target.samplepoint = 0;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    target.samplepoint = 10000;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    target.samplepoint = 8750; target.sjw = BTR_NOMINAL_SJW_MAX + 1;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    // @- frequency 0 and invalid register ranges
+    target.sjw = BTR_SJW_MAXIMUM;
+    limits.frequency = 0;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    limits.frequency = BTR_FREQ_80MHz; limits.brp_min = limits.brp_max + 1;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+    limits.brp_min = 0;
+    XCTAssertEqual(BTRERR_ILLPARA, btr_solve_bitrate(&limits, &target, &candidate, &count));
+}
+
+// @xctest TC0B.12.1: call 'btr_find_bitrate' for CAN 2.0 and CAN FD bit-rates
+//
+// @expected BTRERR_NOERROR, the bit-rate settings meet the targets
+//
+- (void)testFindBitrateWithValidTargets {
+    btr_target_t nominal = { 500000, 8000, BTR_SJW_MAXIMUM, 0 };
+    btr_bitrate_t bitrate;
+    btr_speed_t speed;
+    // @test:
+    // @- CAN 2.0: 500 kbps at 80 MHz
+    XCTAssertEqual(BTRERR_NOERROR, btr_find_bitrate(BTR_FREQ_80MHz, &nominal, NULL, &bitrate));
+    XCTAssertEqual(BTRERR_NOERROR, btr_check_bitrate(&bitrate, false, false));
+    XCTAssertEqual(BTRERR_NOERROR, btr_bitrate2speed(&bitrate, &speed));
+    XCTAssertEqual(500000.0f, speed.nominal.speed);
+    XCTAssertEqualWithAccuracy(0.8f, speed.nominal.samplepoint, 0.001f);
+#if (CAN_FD_SUPPORTED == FEATURE_SUPPORTED)
+    btr_target_t data = { 2000000, 8000, BTR_SJW_MAXIMUM, 0 };
+    // @- CAN FD: 500 kbps : 2 Mbps at 80 MHz
+    XCTAssertEqual(BTRERR_NOERROR, btr_find_bitrate(BTR_FREQ_80MHz, &nominal, &data, &bitrate));
+    XCTAssertEqual(BTRERR_NOERROR, btr_check_bitrate(&bitrate, true, true));
+    XCTAssertEqual(BTRERR_NOERROR, btr_bitrate2speed(&bitrate, &speed));
+    XCTAssertEqual(500000.0f, speed.nominal.speed);
+    XCTAssertEqual(2000000.0f, speed.data.speed);
+    XCTAssertEqualWithAccuracy(0.8f, speed.data.samplepoint, 0.001f);
+    // @- CAN FD: 500 kbps : 7 Mbps at 24 MHz (no candidate)
+    data.bitrate = 7000000;
+    XCTAssertEqual(BTRERR_BAUDRATE, btr_find_bitrate(BTR_FREQ_24MHz, &nominal, &data, &bitrate));
+#endif
+    // @- NULL pointer for 'nominal' or 'bitrate'
+    XCTAssertEqual(BTRERR_NULLPTR, btr_find_bitrate(BTR_FREQ_80MHz, NULL, NULL, &bitrate));
+    XCTAssertEqual(BTRERR_NULLPTR, btr_find_bitrate(BTR_FREQ_80MHz, &nominal, NULL, NULL));
+}
+
+// @xctest TC0B.13.1: call 'btr_string2bitrate' and 'btr_bitrate2string' with a round-trip corpus
+//
+// @expected BTRERR_NOERROR, the printed string is the canonical form of the parsed string
+//
+- (void)testStringRoundTripWithCorpus {
+    const struct {
+        const char *input;
+        const char *canonical;
+        bool data;
+        bool sam;
+    } corpus[] = {
+        { "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16",
+          "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16", false, false },
+        { "f_clock=8000000,nom_brp=1,nom_tseg1=5,nom_tseg2=2,nom_sjw=1,nom_sam=0",
+          "f_clock=8000000,nom_brp=1,nom_tseg1=5,nom_tseg2=2,nom_sjw=1,nom_sam=0", false, true },
+        { " nom_sjw = 16 , nom_tseg2=16,nom_tseg1= 63,nom_brp =2, f_clock_mhz=80 ,",
+          "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16", false, false },
+        { "f_clock_mhz=24,nom_brp=3,nom_tseg1=12,nom_tseg2=3,nom_sjw=1",
+          "f_clock=24000000,nom_brp=3,nom_tseg1=12,nom_tseg2=3,nom_sjw=1", false, false },
+#if (CAN_FD_SUPPORTED == FEATURE_SUPPORTED)
+        { "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16,data_brp=2,data_tseg1=7,data_tseg2=2,data_sjw=2",
+          "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16,data_brp=2,data_tseg1=7,data_tseg2=2,data_sjw=2", true, false },
+        { "data_sjw=2,data_tseg2=2,data_tseg1=7,data_brp=2,f_clock_mhz=80,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16",
+          "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16,data_brp=2,data_tseg1=7,data_tseg2=2,data_sjw=2", true, false },
+#endif
+    };
+    char string[BTR_STRING_LENGTH];
+    btr_bitrate_t bitrate, again;
+    bool data, sam;
+    int rc = BTRERR_FATAL;
+    // @test:
+    // @- loop over the corpus
+    for (size_t i = 0; i < (sizeof(corpus) / sizeof(corpus[0])); i++) {
+        NSLog(@"Execute sub-testcase %zu: %s\n", i+1, corpus[i].input);
+        // @-- parse the input string
+        rc = btr_string2bitrate((btr_string_t)corpus[i].input, &bitrate, &data, &sam);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        XCTAssertEqual(corpus[i].data, data);
+        XCTAssertEqual(corpus[i].sam, sam);
+        // @-- print it and compare with its canonical form
+        rc = btr_bitrate2string(&bitrate, data, sam, string, BTR_STRING_LENGTH);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        XCTAssertEqual(0, strcmp(corpus[i].canonical, string));
+        // @-- parse the printed string and compare the bit-rate settings
+        rc = btr_string2bitrate(string, &again, &data, &sam);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        XCTAssertEqual(0, memcmp(&bitrate, &again, sizeof(btr_bitrate_t)));
+    }
+}
+
+// @xctest TC0B.13.2: call 'btr_string2bitrate' with mutated strings (fuzzing)
+//
+// @expected no crash, every accepted string survives a print/parse round-trip
+//
+- (void)testStringToBitrateWithMutatedStrings {
+    const char seed[] = "f_clock=80000000,nom_brp=2,nom_tseg1=63,nom_tseg2=16,nom_sjw=16,nom_sam=0,"
+                        "data_brp=2,data_tseg1=7,data_tseg2=2,data_sjw=2";
+    const char alphabet[] = "=, _0123456789fmnodatsegjwbrpclkhz\t";
+    char input[sizeof(seed) + 16];
+    char string[BTR_STRING_LENGTH];
+    btr_bitrate_t bitrate, again;
+    bool data, sam;
+    int accepted = 0;
+    int rc = BTRERR_FATAL;
+    // @test:
+    // @- mutate the seed string at random positions (reproducible sequence)
+    srand(4711);
+    for (int i = 0; i < 100000; i++) {
+        size_t length = sizeof(seed) - 1;
+        memcpy(input, seed, sizeof(seed));
+        for (int n = (rand() % 4) + 1; n > 0; n--) {
+            size_t pos = (size_t)rand() % length;
+            switch (rand() % 3) {
+                case 0: input[pos] = alphabet[rand() % (sizeof(alphabet) - 1)]; break;
+                case 1: memmove(&input[pos], &input[pos+1], length - pos); length--; break;
+                case 2: length = pos; input[length] = '\0'; break;
+            }
+            if (length == 0) break;
+        }
+        // @-- parse the mutated string
+        rc = btr_string2bitrate(input, &bitrate, &data, &sam);
+        if (rc != BTRERR_NOERROR) {
+            XCTAssertEqual(BTRERR_ILLPARA, rc);
+            continue;
+        }
+        // @-- print and parse again: the bit-rate settings must be the same
+        rc = btr_bitrate2string(&bitrate, data, sam, string, BTR_STRING_LENGTH);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        rc = btr_string2bitrate(string, &again, &data, &sam);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        XCTAssertEqual(0, memcmp(&bitrate, &again, sizeof(btr_bitrate_t)));
+        accepted++;
+    }
+    NSLog(@"%i of 100000 mutated strings accepted\n", accepted);
+}
+
+// @xctest TC0B.13.3: call 'btr_index2bitrate' and 'btr_bitrate2index' against the SJA1000 table
+//
+// @expected BTRERR_NOERROR, index and bit-rate settings are mapped one-to-one
+//
+- (void)testIndexTableAgainstSja1000 {
+    const btr_sja1000_t sja1000[BTR_SJA1000_ENTRIES] = {
+        SJA1000_1M, SJA1000_800K, SJA1000_500K, SJA1000_250K, SJA1000_125K,
+        SJA1000_100K, SJA1000_50K, SJA1000_20K, SJA1000_10K, SJA1000_5K
+    };
+    btr_bitrate_t bitrate, expected;
+    btr_index_t index;
+    int rc = BTRERR_FATAL;
+    // @test:
+    // @- loop over valid indexes to predefined bit-rate table
+    for (btr_index_t i = 0; i < BTR_SJA1000_ENTRIES; i++) {
+        bzero(&expected, sizeof(btr_bitrate_t));
+        (void)btr_sja10002bitrate(sja1000[i], &expected);
+        // @-- index to bit-rate settings
+        bzero(&bitrate, sizeof(btr_bitrate_t));
+        rc = btr_index2bitrate(-i, &bitrate);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        XCTAssertEqual(0, memcmp(&expected, &bitrate, sizeof(btr_bitrate_t)));
+        // @-- bit-rate settings to index
+        index = INT_MIN;
+        rc = btr_bitrate2index(&bitrate, &index);
+        XCTAssertEqual(BTRERR_NOERROR, rc);
+        XCTAssertEqual(-i, index);
+    }
+}
+
 @end
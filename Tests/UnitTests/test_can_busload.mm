@@ -682,6 +682,72 @@
 // @note: already covered by TC09.14 (Get CAN controller status after reception queue overrun)
 //}
 
+// @xctest TC10.17: Get CAN bus load from the bus load and status sampler
+//
+// @expected CANERR_NOERROR and min. <= avg. <= max. bus load, without a request to the device
+//
+- (void)testWhenSamplerRunning {
+    can_bitrate_t bitrate = { TEST_BTRINDEX };
+    can_status_t status = { CANSTAT_RESET };
+    uint32_t interval = 10U;
+    uint16_t minLoad = 0U, maxLoad = 0U, avgLoad = 0U;
+    uint8_t load = 0U;
+    int handle = INVALID_HANDLE;
+    int rc = CANERR_FATAL;
+    int i;
+
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    handle = can_init(DUT1, TEST_CANMODE, NULL);
+    XCTAssertLessThanOrEqual(0, handle);
+    // @- set sampler interval of DUT1 to 10ms (before the CAN controller is started)
+    rc = can_property(handle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_SAMPLER_INTERVAL, (void*)&interval, sizeof(uint32_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- start DUT1 with configured bit-rate settings
+    rc = can_start(handle, &bitrate);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- send and receive some frames to/from DUT2 (optional)
+#if (SEND_TEST_FRAMES != 0)
+    CTester tester;
+    XCTAssertEqual(TEST_FRAMES, tester.SendSomeFrames(handle, DUT2, TEST_FRAMES));
+    XCTAssertEqual(TEST_FRAMES, tester.ReceiveSomeFrames(handle, DUT2, TEST_FRAMES));
+#endif
+    // @- let the sampler fill its window
+    CTimer::Delay(20U * interval * CTimer::MSEC);
+
+    // @test:
+    // @- get bus-load of DUT1 several times (returns from the snapshot)
+    CTimer timer = CTimer(100U * CTimer::MSEC);
+    for (i = 0; i < 100; i++) {
+        rc = can_busload(handle, &load, &status.byte);
+        XCTAssertEqual(CANERR_NOERROR, rc);
+        XCTAssertFalse(status.can_stopped);
+    }
+    // @- note: 100 requests to the device would take 100 * 100ms
+    XCTAssertFalse(timer.Timeout());
+    // @- get min./max./avg. bus-load of DUT1 within the window
+    rc = can_property(handle, CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_MIN, (void*)&minLoad, sizeof(uint16_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    rc = can_property(handle, CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_MAX, (void*)&maxLoad, sizeof(uint16_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    rc = can_property(handle, CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_AVG, (void*)&avgLoad, sizeof(uint16_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    XCTAssertLessThanOrEqual(minLoad, avgLoad);
+    XCTAssertLessThanOrEqual(avgLoad, maxLoad);
+    XCTAssertLessThanOrEqual(maxLoad, 10000U);
+
+    // @post:
+    // @- stop/reset DUT1
+    rc = can_reset(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- min./max./avg. bus-load not available when stopped
+    rc = can_property(handle, CANPROP_GET_VENDOR_PROP + KVASER_PROP_BUSLOAD_AVG, (void*)&avgLoad, sizeof(uint16_t));
+    XCTAssertEqual(CANERR_NOTSUPP, rc);
+    // @- shutdown DUT1
+    rc = can_exit(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+}
+
 @end
 
 // $Id: test_can_busload.mm 1083 2022-07-25 12:40:16Z makemake $  Copyright (c) UV Software, Berlin //
@@ -0,0 +1,298 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+#import "Settings.h"
+#import "can_exp.h"
+#import <XCTest/XCTest.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+static void MakeMessage(exp_message_t *message, uint32_t id, int xtd, int fdf, uint8_t dlc, long usec) {
+    bzero(message, sizeof(exp_message_t));
+    message->id = id;
+    message->xtd = xtd ? 1 : 0;
+    message->fdf = fdf ? 1 : 0;
+    message->dlc = dlc;
+    for (int i = 0; i < CANFD_MAX_LEN; i++)
+        message->data[i] = (uint8_t)(0x11 * (i + 1));
+    message->timestamp.tv_sec = 1700000000 + (usec / 1000000L);
+    message->timestamp.tv_nsec = (usec % 1000000L) * 1000L;
+}
+
+static int ReadFile(const char *path, char *buffer, size_t size) {
+    FILE *fp;
+    size_t n;
+    if ((fp = fopen(path, "rb")) == NULL)
+        return -1;
+    n = fread(buffer, 1U, size - 1U, fp);
+    buffer[n] = '\0';
+    (void)fclose(fp);
+    return (int)n;
+}
+
+static uint32_t GetU32(const uint8_t *ptr) {
+    return (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+}
+
+@interface test_can_exp : XCTestCase {
+    char path[PATH_MAX];
+    char text[4096];
+}
+@end
+
+@implementation test_can_exp
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    (void)snprintf(path, sizeof(path), "%s/test_can_exp", [NSTemporaryDirectory() UTF8String]);
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    (void)unlink(path);
+}
+
+// @xctest TC0E.1: export CAN CC and CAN FD messages to a candump log file
+//
+// @expected one line per message in the candump log file format
+//
+- (void)testExportCandump {
+    exp_exporter_t exporter = NULL;
+    exp_options_t options = {};
+    exp_message_t message[5];
+    exp_stats_t stats;
+    // @pre:
+    MakeMessage(&message[0], 0x123U, 0, 0, 3U, 0L);
+    MakeMessage(&message[1], 0x1ABCDEFU, 1, 0, 0U, 1500L);
+    MakeMessage(&message[2], 0x7FFU, 0, 0, 2U, 2000L);
+    message[2].rtr = 1;
+    MakeMessage(&message[3], 0x456U, 0, 1, 9U, 1000000L);
+    message[3].brs = 1;
+    MakeMessage(&message[4], 0x000U, 0, 0, 1U, 1000001L);
+    message[4].sts = 1;
+    options.format = EXP_FORMAT_CANDUMP;
+    options.time_stamp = MSG_FMT_TIMESTAMP_ZERO;
+    strcpy(options.interface, "can1");
+    // @test:
+    // @- export the messages with time-stamps relative to the first message
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_create(&exporter, path, &options));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_write(exporter, message, 5U));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_stats(exporter, &stats));
+    XCTAssertEqual(5U, stats.messages);
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_close(exporter));
+    // @- check the log file
+    XCTAssertLessThan(0, ReadFile(path, text, sizeof(text)));
+    XCTAssertEqual(0, strcmp(text,
+                             "(0000000000.000000) can1 123#112233\n"
+                             "(0000000000.001500) can1 01ABCDEF#\n"
+                             "(0000000000.002000) can1 7FF#R2\n"
+                             "(0000000001.000000) can1 456##1112233445566778899AABBCC\n"
+                             "(0000000001.000001) can1 20000000#11\n"));
+}
+
+// @xctest TC0E.2: export CAN messages with time-stamps ZERO, ABS and REL
+//
+// @expected the time-stamps are handled as by the message formatter
+//
+- (void)testExportTimestamps {
+    exp_exporter_t exporter = NULL;
+    exp_options_t options = {};
+    exp_message_t message[3];
+    // @pre:
+    MakeMessage(&message[0], 0x100U, 0, 0, 0U, 250000L);
+    MakeMessage(&message[1], 0x101U, 0, 0, 0U, 750000L);
+    MakeMessage(&message[2], 0x102U, 0, 0, 0U, 2000000L);
+    options.format = EXP_FORMAT_CANDUMP;
+    // @test:
+    // @- absolute time-stamps
+    options.time_stamp = MSG_FMT_TIMESTAMP_ABSOLUTE;
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_create(&exporter, path, &options));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_write(exporter, message, 3U));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_close(exporter));
+    XCTAssertLessThan(0, ReadFile(path, text, sizeof(text)));
+    XCTAssertEqual(0, strcmp(text,
+                             "(1700000000.250000) can0 100#\n"
+                             "(1700000000.750000) can0 101#\n"
+                             "(1700000002.000000) can0 102#\n"));
+    // @- relative time-stamps (time since the previous message)
+    options.time_stamp = MSG_FMT_TIMESTAMP_RELATIVE;
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_create(&exporter, path, &options));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_write(exporter, message, 3U));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_close(exporter));
+    XCTAssertLessThan(0, ReadFile(path, text, sizeof(text)));
+    XCTAssertEqual(0, strcmp(text,
+                             "(0000000000.000000) can0 100#\n"
+                             "(0000000000.500000) can0 101#\n"
+                             "(0000000001.250000) can0 102#\n"));
+}
+
+// @xctest TC0E.3: export CAN CC and CAN FD messages to an ASC log file
+//
+// @expected a Vector ASCII log file with header, trigger block and trailer
+//
+- (void)testExportAsc {
+    exp_exporter_t exporter = NULL;
+    exp_options_t options = {};
+    exp_message_t message[3];
+    // @pre:
+    MakeMessage(&message[0], 0x123U, 0, 0, 2U, 0L);
+    MakeMessage(&message[1], 0x1ABCDEFU, 1, 0, 1U, 1500L);
+    MakeMessage(&message[2], 0x456U, 0, 1, 1U, 2000L);
+    message[2].brs = 1;
+    options.format = EXP_FORMAT_ASC;
+    options.time_stamp = MSG_FMT_TIMESTAMP_ZERO;
+    options.channel = 2U;
+    // @test:
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_create(&exporter, path, &options));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_write(exporter, message, 3U));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_close(exporter));
+    // @- check the log file
+    XCTAssertLessThan(0, ReadFile(path, text, sizeof(text)));
+    XCTAssertEqual(0, strncmp(text, "date ", 5));
+    XCTAssertTrue(strstr(text, "\nbase hex  timestamps absolute\n") != NULL);
+    XCTAssertTrue(strstr(text, "\nBegin Triggerblock ") != NULL);
+    XCTAssertTrue(strstr(text, "\n   0.000000 Start of measurement\n") != NULL);
+    XCTAssertTrue(strstr(text, "\n   0.000000 2  123             Rx   d 2 11 22\n") != NULL);
+    XCTAssertTrue(strstr(text, "\n   0.001500 2  1ABCDEFx        Rx   d 1 11\n") != NULL);
+    XCTAssertTrue(strstr(text, "\n   0.002000 CANFD   2 Rx        456") != NULL);
+    XCTAssertTrue(strstr(text, " 1 0 1  1 11        0    0     3000 ") != NULL);
+    XCTAssertEqual(0, strcmp(text + strlen(text) - 17, "End TriggerBlock\n"));
+}
+
+// @xctest TC0E.4: export CAN CC and CAN FD messages to a BLF log file
+//
+// @expected a Vector binary log file with compressed log containers
+//
+- (void)testExportBlf {
+    exp_exporter_t exporter = NULL;
+    exp_options_t options = {};
+    exp_message_t message;
+    exp_stats_t stats;
+    static uint8_t data[EXP_CONTAINER_SIZE];
+    uLongf length = (uLongf)sizeof(data);
+    struct stat st;
+    int n;
+    // @pre:
+    options.format = EXP_FORMAT_BLF;
+    options.time_stamp = MSG_FMT_TIMESTAMP_ZERO;
+    // @test:
+    // @- export 10'000 messages (more than one log container)
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_create(&exporter, path, &options));
+    for (n = 0; n < 10000; n++) {
+        MakeMessage(&message, (uint32_t)n & 0x7FFU, n & 1, n & 2, (uint8_t)(n % 9), (long)n * 100L);
+        XCTAssertEqual(EXPERR_NOERROR, exp_exporter_write(exporter, &message, 1U));
+    }
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_flush(exporter));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_stats(exporter, &stats));
+    XCTAssertEqual(10000U, stats.messages);
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_close(exporter));
+    // @- check the file header
+    XCTAssertEqual(0, stat(path, &st));
+    XCTAssertEqual((uint64_t)st.st_size, stats.bytes);
+    uint8_t *blf = (uint8_t*)malloc((size_t)st.st_size);
+    XCTAssertTrue(blf != NULL);
+    FILE *fp = fopen(path, "rb");
+    XCTAssertTrue(fp != NULL);
+    XCTAssertEqual((size_t)st.st_size, fread(blf, 1U, (size_t)st.st_size, fp));
+    (void)fclose(fp);
+    XCTAssertEqual(0, memcmp(blf, "LOGG", 4));
+    XCTAssertEqual(144U, GetU32(&blf[4]));
+    XCTAssertEqual((uint32_t)st.st_size, GetU32(&blf[16]));
+    XCTAssertEqual(10000U, GetU32(&blf[32]));
+    // @- check the first log container and its first object (CAN message)
+    XCTAssertEqual(0, memcmp(&blf[144], "LOBJ", 4));
+    XCTAssertEqual(10U, GetU32(&blf[144 + 12]));
+    XCTAssertEqual(Z_OK, uncompress(data, &length, &blf[144 + 32], GetU32(&blf[144 + 8]) - 32U));
+    XCTAssertEqual((uLongf)GetU32(&blf[144 + 24]), length);
+    XCTAssertEqual(0, memcmp(&data[0], "LOBJ", 4));
+    XCTAssertEqual(1U, GetU32(&data[12]));
+    XCTAssertEqual(0U, GetU32(&data[32 + 4]));
+    free(blf);
+}
+
+// @xctest TC0E.5: call the exporter with invalid parameters
+//
+// @expected the exporter rejects the call with an error code
+//
+- (void)testInvalidParameters {
+    exp_exporter_t exporter = NULL;
+    exp_options_t options = {};
+    exp_message_t message = {};
+    exp_stats_t stats;
+    // @test:
+    // @- the log file format is determined by the file extension
+    XCTAssertEqual((int)EXP_FORMAT_CANDUMP, exp_format_from_path("trace.log"));
+    XCTAssertEqual((int)EXP_FORMAT_ASC, exp_format_from_path("trace.ASC"));
+    XCTAssertEqual((int)EXP_FORMAT_BLF, exp_format_from_path("/tmp/trace.blf"));
+    XCTAssertEqual(EXPERR_ILLPARA, exp_format_from_path("trace.txt"));
+    XCTAssertEqual(EXPERR_ILLPARA, exp_format_from_path("trace"));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_format_from_path(NULL));
+    // @- illegal format and time-stamp reference
+    options.format = (exp_format_t)3;
+    XCTAssertEqual(EXPERR_ILLPARA, exp_exporter_create(&exporter, path, &options));
+    options.format = EXP_FORMAT_ASC;
+    options.time_stamp = (msg_fmt_timestamp_t)4;
+    XCTAssertEqual(EXPERR_ILLPARA, exp_exporter_create(&exporter, path, &options));
+    // @- null-pointer assignments
+    options.time_stamp = MSG_FMT_TIMESTAMP_ZERO;
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_create(NULL, path, &options));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_create(&exporter, NULL, &options));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_create(&exporter, path, NULL));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_write(NULL, &message, 1U));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_flush(NULL));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_stats(NULL, &stats));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_close(NULL));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_create(&exporter, path, &options));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_write(exporter, NULL, 1U));
+    XCTAssertEqual(EXPERR_NULLPTR, exp_exporter_stats(exporter, NULL));
+    XCTAssertEqual(EXPERR_NOERROR, exp_exporter_close(exporter));
+}
+
+@end
@@ -47,6 +47,7 @@
 //
 #import "Settings.h"
 #import "can_api.h"
+#import "KvaserUSB_InfoCache.h"
 #import <XCTest/XCTest.h>
 
 #ifndef CAN_FD_SUPPORTED
@@ -684,6 +685,63 @@
 //     // @end.
 // }
 
+// @xctest TC02.15: Re-initialize CAN channel with device information from the cache
+//
+// @expected: CANERR_NOERROR, a cache hit (no transceiver and capability requests), and the same hardware,
+//            firmware and capabilities as on the first initialization
+//
+- (void)testReinitializeWithCachedDeviceInformation {
+    char hardware[CANPROP_MAX_BUFFER_SIZE] = "";
+    char firmware[CANPROP_MAX_BUFFER_SIZE] = "";
+    uint64_t hits = 0U, misses = 0U;
+    uint64_t hits2 = 0U, misses2 = 0U;
+    uint8_t capability = 0x00U;
+    uint8_t value = 0x00U;
+    char *string = NULL;
+    int handle = INVALID_HANDLE;
+    int rc = CANERR_FATAL;
+    // @pre:
+    // @- initialize DUT1 with configured settings (device information read from the device)
+    handle = can_init(DUT1, TEST_CANMODE, NULL);
+    XCTAssertLessThanOrEqual(0, handle);
+    // @- get hardware and firmware version, and operation capabilities of DUT1
+    string = can_hardware(handle);
+    XCTAssertNotEqual((char*)NULL, string);
+    if (string) strncpy(hardware, string, CANPROP_MAX_BUFFER_SIZE-1);
+    string = can_firmware(handle);
+    XCTAssertNotEqual((char*)NULL, string);
+    if (string) strncpy(firmware, string, CANPROP_MAX_BUFFER_SIZE-1);
+    rc = can_property(handle, CANPROP_GET_OP_CAPABILITY, (void*)&capability, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- tear down DUT1
+    rc = can_exit(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @test:
+    // @- initialize DUT1 a second time (device information taken from the cache)
+    InfoCache_Statistics(&hits, &misses);
+    handle = can_init(DUT1, TEST_CANMODE, NULL);
+    XCTAssertLessThanOrEqual(0, handle);
+    // @- the cache was hit, i.e. the transceiver info and the capabilities were not requested
+    InfoCache_Statistics(&hits2, &misses2);
+    XCTAssertEqual(hits + 1U, hits2);
+    XCTAssertEqual(misses, misses2);
+    // @- compare hardware and firmware version, and operation capabilities of DUT1
+    string = can_hardware(handle);
+    XCTAssertNotEqual((char*)NULL, string);
+    if (string) XCTAssertEqual(0, strcmp(hardware, string));
+    string = can_firmware(handle);
+    XCTAssertNotEqual((char*)NULL, string);
+    if (string) XCTAssertEqual(0, strcmp(firmware, string));
+    rc = can_property(handle, CANPROP_GET_OP_CAPABILITY, (void*)&value, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    XCTAssertEqual(capability, value);
+    // @post:
+    // @- tear down DUT1
+    rc = can_exit(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @end.
+}
+
 @end
 
 // $Id: test_can_init.mm 1138 2023-08-10 18:25:16Z haumea $  Copyright (c) UV Software, Berlin //
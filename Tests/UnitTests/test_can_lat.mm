@@ -0,0 +1,323 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+#import "Settings.h"
+#import "can_lat.h"
+#import <XCTest/XCTest.h>
+
+#include <unistd.h>
+#include <string.h>
+
+#define LATENCY  100000U  // 100us
+#define SEND_TIME(n)  (1000000000ULL + (uint64_t)(n) * 1000000ULL)
+
+static void Account(lat_meter_t meter, uint32_t sequence, uint64_t sent, uint64_t latency) {
+    uint8_t data[8];
+    (void)lat_stamp(data, sizeof(data), sequence, sent);
+    (void)lat_meter_account(meter, data, sizeof(data), sent + latency);
+}
+
+@interface test_can_lat : XCTestCase {
+    lat_meter_t meter;
+}
+@end
+
+@implementation test_can_lat
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    meter = NULL;
+    (void)lat_meter_create(&meter);
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    (void)lat_meter_destroy(meter);
+}
+
+// @xctest TC0A.1: stamp a payload and read the stamp back
+//
+// @expected sequence number and send time (lower 32 bits) are restored
+//
+- (void)testStampAndUnstamp {
+    uint8_t data[64];
+    uint32_t sequence = 0U, time = 0U;
+    // @test:
+    memset(data, 0xFF, sizeof(data));
+    XCTAssertEqual(LATERR_NOERROR, lat_stamp(data, 8U, 0x12345678U, 0xAABBCCDD11223344ULL));
+    XCTAssertEqual(LATERR_NOERROR, lat_unstamp(data, 8U, &sequence, &time));
+    XCTAssertEqual(0x12345678U, sequence);
+    XCTAssertEqual(0x11223344U, time);
+    // @- little endian, the bytes behind the stamp are not touched
+    XCTAssertEqual(0x78U, data[0]);
+    XCTAssertEqual(0x12U, data[3]);
+    XCTAssertEqual(0x44U, data[4]);
+    XCTAssertEqual(0x11U, data[7]);
+    XCTAssertEqual(0xFFU, data[8]);
+    // @- CAN FD payload
+    XCTAssertEqual(LATERR_NOERROR, lat_stamp(data, 64U, 1U, 2ULL));
+    XCTAssertEqual(LATERR_NOERROR, lat_unstamp(data, 64U, &sequence, &time));
+    XCTAssertEqual(1U, sequence);
+    XCTAssertEqual(2U, time);
+    // @- payload too short for a stamp
+    XCTAssertEqual(LATERR_NOSTAMP, lat_stamp(data, 7U, 0U, 0ULL));
+    XCTAssertEqual(LATERR_NOSTAMP, lat_unstamp(data, 7U, &sequence, &time));
+    XCTAssertEqual(LATERR_NOSTAMP, lat_meter_account(meter, data, 4U, 0ULL));
+    // @- the monotonic clock is running
+    uint64_t t0 = lat_clock();
+    usleep(1000);
+    XCTAssertGreaterThan(lat_clock(), t0);
+}
+
+// @xctest TC0A.2: account frames with a constant latency
+//
+// @expected all percentiles are equal to the latency (within the resolution), no loss, no jitter
+//
+- (void)testConstantLatency {
+    lat_stats_t stats;
+    // @pre:
+    XCTAssert(meter != NULL);
+    // @test:
+    for (uint32_t n = 0U; n < 1000U; n++)
+        Account(meter, n, SEND_TIME(n), LATENCY);
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 1000U, &stats));
+    // @- counters
+    XCTAssertEqual(1000U, stats.sent);
+    XCTAssertEqual(1000U, stats.received);
+    XCTAssertEqual(0U, stats.lost);
+    XCTAssertEqual(0U, stats.reordered);
+    XCTAssertEqual(0U, stats.duplicates);
+    XCTAssertEqual(0U, stats.invalid);
+    // @- latency
+    XCTAssertEqual(1000U, stats.latency.count);
+    XCTAssertEqual(LATENCY, stats.latency.min);
+    XCTAssertEqual(LATENCY, stats.latency.max);
+    XCTAssertEqual(LATENCY, stats.latency.mean);
+    XCTAssertEqual(LATENCY, stats.latency.p50);
+    XCTAssertEqual(LATENCY, stats.latency.p9999);
+    // @- jitter
+    XCTAssertEqual(0U, stats.jitter);
+    XCTAssertEqual(999U, stats.delta.count);
+    XCTAssertEqual(0U, stats.delta.max);
+}
+
+// @xctest TC0A.3: account frames with gaps in the sequence numbers
+//
+// @expected missing frames are counted as lost
+//
+- (void)testLostFrames {
+    lat_stats_t stats;
+    // @pre:
+    XCTAssert(meter != NULL);
+    // @test:
+    for (uint32_t n = 0U; n < 100U; n++)
+        if ((n % 10U) != 5U)
+            Account(meter, n, SEND_TIME(n), LATENCY);
+    // @- 100 frames sent (10 lost)
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 100U, &stats));
+    XCTAssertEqual(100U, stats.sent);
+    XCTAssertEqual(90U, stats.received);
+    XCTAssertEqual(10U, stats.lost);
+    XCTAssertEqual(0U, stats.reordered);
+    // @- 0 = highest sequence number received plus one
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 0U, &stats));
+    XCTAssertEqual(100U, stats.sent);
+    XCTAssertEqual(10U, stats.lost);
+    // @- 110 frames sent (the last 10 lost)
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 110U, &stats));
+    XCTAssertEqual(20U, stats.lost);
+    // @- reset clears all counters
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_reset(meter));
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 0U, &stats));
+    XCTAssertEqual(0U, stats.received);
+    XCTAssertEqual(0U, stats.lost);
+    XCTAssertEqual(0U, stats.latency.count);
+}
+
+// @xctest TC0A.4: account frames out of order and twice
+//
+// @expected late frames are counted as reordered, repeated frames as duplicates (not as received)
+//
+- (void)testReorderedAndDuplicates {
+    const uint32_t order[] = { 0U, 1U, 3U, 2U, 4U, 4U, 5U, 7U, 6U, 3U, 8U, 9U };
+    uint8_t data[8] = { 0 };
+    lat_stats_t stats;
+    // @pre:
+    XCTAssert(meter != NULL);
+    // @test:
+    for (size_t i = 0U; i < sizeof(order) / sizeof(order[0]); i++)
+        Account(meter, order[i], SEND_TIME(order[i]), LATENCY);
+    XCTAssertEqual(LATERR_NOSTAMP, lat_meter_account(meter, data, 2U, SEND_TIME(10)));
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 10U, &stats));
+    // @- 12 frames received: 2 reordered (2, 6), 2 duplicates (4, 3)
+    XCTAssertEqual(12U, stats.received);
+    XCTAssertEqual(2U, stats.reordered);
+    XCTAssertEqual(2U, stats.duplicates);
+    XCTAssertEqual(0U, stats.lost);
+    XCTAssertEqual(1U, stats.invalid);
+    XCTAssertEqual(12U, stats.latency.count);
+}
+
+// @xctest TC0A.5: account frames with alternating latencies
+//
+// @expected the jitter estimate converges to the difference of the latencies
+//
+- (void)testJitter {
+    lat_stats_t stats;
+    // @pre:
+    XCTAssert(meter != NULL);
+    // @test:
+    for (uint32_t n = 0U; n < 1000U; n++)
+        Account(meter, n, SEND_TIME(n), (n & 1U) ? LATENCY + 10000U : LATENCY);
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_stats(meter, 1000U, &stats));
+    // @- latency
+    XCTAssertEqual(LATENCY, stats.latency.min);
+    XCTAssertEqual(LATENCY + 10000U, stats.latency.max);
+    XCTAssertEqual(LATENCY + 5000U, stats.latency.mean);
+    // @- jitter (RFC 3550)
+    XCTAssertGreaterThanOrEqual(stats.jitter, 9900U);
+    XCTAssertLessThanOrEqual(stats.jitter, 10000U);
+    // @- latency differences |D|
+    XCTAssertEqual(999U, stats.delta.count);
+    XCTAssertEqual(10000U, stats.delta.min);
+    XCTAssertEqual(10000U, stats.delta.max);
+    XCTAssertEqual(10000U, stats.delta.p99);
+}
+
+// @xctest TC0A.6: percentiles of a uniform distribution (1us to 100ms)
+//
+// @expected each percentile is within the resolution of the histogram
+//
+- (void)testPercentiles {
+    const double percentile[] = { 0.0, 1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0 };
+    uint64_t value = 0U;
+    // @pre:
+    XCTAssert(meter != NULL);
+    for (uint32_t n = 0U; n < 100000U; n++)
+        Account(meter, n, SEND_TIME(n), (uint64_t)(n + 1U) * 1000U);
+    // @test:
+    for (size_t i = 0U; i < sizeof(percentile) / sizeof(percentile[0]); i++) {
+        double expected = (percentile[i] > 0.0) ? percentile[i] * 1000000.0 : 1000.0;
+        XCTAssertEqual(LATERR_NOERROR, lat_meter_percentile(meter, LAT_LATENCY, percentile[i], &value));
+        // @- relative error below 1/64
+        XCTAssertGreaterThanOrEqual((double)value, expected * (1.0 - 1.0 / 64.0));
+        XCTAssertLessThanOrEqual((double)value, expected * (1.0 + 1.0 / 64.0));
+    }
+    // @- 0th and 100th percentile are min and max
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_percentile(meter, LAT_LATENCY, 0.0, &value));
+    XCTAssertEqual(1000U, value);
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_percentile(meter, LAT_LATENCY, 100.0, &value));
+    XCTAssertEqual(100000000U, value);
+}
+
+// @xctest TC0A.7: write the percentile distribution of the latency histogram
+//
+// @expected a distribution in the format of HdrHistogram (.hgrm)
+//
+- (void)testDistribution {
+    char line[256];
+    int header = 0, rows = 0, footer = 0;
+    // @pre:
+    XCTAssert(meter != NULL);
+    for (uint32_t n = 0U; n < 10000U; n++)
+        Account(meter, n, SEND_TIME(n), LATENCY + (uint64_t)(n % 100U) * 1000U);
+    FILE *fp = tmpfile();
+    XCTAssert(fp != NULL);
+    // @test:
+    XCTAssertEqual(LATERR_NOERROR, lat_meter_distribution(meter, LAT_LATENCY, fp));
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        if (strstr(line, "Value") && strstr(line, "Percentile") && strstr(line, "TotalCount"))
+            header++;
+        else if (strstr(line, "#[Mean") || strstr(line, "#[Max"))
+            footer++;
+        else if (strchr(line, '.') && (line[0] != '#'))
+            rows++;
+    }
+    fclose(fp);
+    // @- one header, some rows and the footer
+    XCTAssertEqual(1, header);
+    XCTAssertGreaterThan(rows, 10);
+    XCTAssertEqual(2, footer);
+}
+
+// @xctest TC0A.8: call the latency meter functions with invalid parameters
+//
+// @expected the respective error code
+//
+- (void)testInvalidParameters {
+    uint8_t data[8] = { 0 };
+    uint32_t sequence, time;
+    uint64_t value;
+    lat_stats_t stats;
+    // @pre:
+    XCTAssert(meter != NULL);
+    // @test:
+    XCTAssertEqual(LATERR_NULLPTR, lat_stamp(NULL, 8U, 0U, 0ULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_unstamp(NULL, 8U, &sequence, &time));
+    XCTAssertEqual(LATERR_NULLPTR, lat_unstamp(data, 8U, NULL, &time));
+    XCTAssertEqual(LATERR_NULLPTR, lat_unstamp(data, 8U, &sequence, NULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_create(NULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_reset(NULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_account(NULL, data, 8U, 0ULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_account(meter, NULL, 8U, 0ULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_stats(NULL, 0U, &stats));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_stats(meter, 0U, NULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_percentile(NULL, LAT_LATENCY, 50.0, &value));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_percentile(meter, LAT_LATENCY, 50.0, NULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_distribution(NULL, LAT_LATENCY, stdout));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_distribution(meter, LAT_LATENCY, NULL));
+    XCTAssertEqual(LATERR_NULLPTR, lat_meter_destroy(NULL));
+    // @- empty histogram
+    XCTAssertEqual(LATERR_EMPTY, lat_meter_percentile(meter, LAT_LATENCY, 50.0, &value));
+    // @- illegal histogram or percentile
+    XCTAssertEqual(LATERR_ILLPARA, lat_meter_percentile(meter, 2, 50.0, &value));
+    XCTAssertEqual(LATERR_ILLPARA, lat_meter_percentile(meter, LAT_LATENCY, -1.0, &value));
+    XCTAssertEqual(LATERR_ILLPARA, lat_meter_percentile(meter, LAT_LATENCY, 100.1, &value));
+    XCTAssertEqual(LATERR_ILLPARA, lat_meter_distribution(meter, -1, stdout));
+}
+
+@end
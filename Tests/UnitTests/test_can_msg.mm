@@ -0,0 +1,377 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#import "Settings.h"
+#import "can_msg.h"
+#import <XCTest/XCTest.h>
+
+// golden output of the message formatter (sprintf/strcat version)
+//
+static const char *golden_data[] = {
+    "00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F 10 11 12 13 14 15 16 17 18 19 1A 1B 1C 1D 1E 1F 20 21 22 23 24 25 26 27 28 29 2A 2B 2C 2D 2E 2F 30 31 32 33 34 35 36 37 38 39 3A 3B 3C 3D 3E 3F",
+    "40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F 50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F 60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F 70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F",
+    "80 81 82 83 84 85 86 87 88 89 8A 8B 8C 8D 8E 8F 90 91 92 93 94 95 96 97 98 99 9A 9B 9C 9D 9E 9F A0 A1 A2 A3 A4 A5 A6 A7 A8 A9 AA AB AC AD AE AF B0 B1 B2 B3 B4 B5 B6 B7 B8 B9 BA BB BC BD BE BF",
+    "C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF D0 D1 D2 D3 D4 D5 D6 D7 D8 D9 DA DB DC DD DE DF E0 E1 E2 E3 E4 E5 E6 E7 E8 E9 EA EB EC ED EE EF F0 F1 F2 F3 F4 F5 F6 F7 F8 F9 FA FB FC FD FE FF"
+};
+static const char *golden_ascii[] = {
+    ". . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .   ! \" # $ % & ' ( ) * + , - . / 0 1 2 3 4 5 6 7 8 9 : ; < = > \?",
+    "@ A B C D E F G H I J K L M N O P Q R S T U V W X Y Z [ \\ ] ^ _ ` a b c d e f g h i j k l m n o p q r s t u v w x y z { | } ~ .",
+    ". . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .",
+    ". . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . ."
+};
+static const char *golden_wraparound[] = {
+    "4711     1700000001.1234  124  SFB-- 64  40 41 42 43 44 45 46 47  @ABCDEFG\n                                         48 49 4A 4B 4C 4D 4E 4F  HIJKLMNO\n                                         50 51 52 53 54 55 56 57  PQRSTUVW\n                                         58 59 5A 5B 5C 5D 5E 5F  XYZ[\\]^_\n                                         60 61 62 63 64 65 66 67  `abcdefg\n                                         68 69 6A 6B 6C 6D 6E 6F  hijklmno\n                                         70 71 72 73 74 75 76 77  pqrstuvw\n                                         78 79 7A 7B 7C 7D 7E 7F  xyz{|}~.",
+    "4711     1700000001.1234  124  SFB-- 64  40 41 42 43 44 45 46 47 48 49  @ABCDEFGHI\n                                         4A 4B 4C 4D 4E 4F 50 51 52 53  JKLMNOPQRS\n                                         54 55 56 57 58 59 5A 5B 5C 5D  TUVWXYZ[\\]\n                                         5E 5F 60 61 62 63 64 65 66 67  ^_`abcdefg\n                                         68 69 6A 6B 6C 6D 6E 6F 70 71  hijklmnopq\n                                         72 73 74 75 76 77 78 79 7A 7B  rstuvwxyz{\n                                         7C 7D 7E 7F                    |}~.",
+    "4711     1700000001.1234  124  SFB-- 64  40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F  @ABCDEFGHIJKLMNO\n                                         50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F  PQRSTUVWXYZ[\\]^_\n                                         60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F  `abcdefghijklmno\n                                         70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F  pqrstuvwxyz{|}~.",
+    "4711     1700000001.1234  124  SFB-- 64  40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F 50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F  @ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_\n                                         60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F 70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F  `abcdefghijklmnopqrstuvwxyz{|}~.",
+    "4711     1700000001.1234  124  SFB-- 64  40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F 50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F 60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F 70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F  @ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~."
+};
+static const char *golden_wraparound_tabs[] = {
+    "4711\t1700000001.1234\t124\tSFB--\t64\t40 41 42 43 44 45 46 47\t@ABCDEFG\n\t48 49 4A 4B 4C 4D 4E 4F\tHIJKLMNO\n\t50 51 52 53 54 55 56 57\tPQRSTUVW\n\t58 59 5A 5B 5C 5D 5E 5F\tXYZ[\\]^_\n\t60 61 62 63 64 65 66 67\t`abcdefg\n\t68 69 6A 6B 6C 6D 6E 6F\thijklmno\n\t70 71 72 73 74 75 76 77\tpqrstuvw\n\t78 79 7A 7B 7C 7D 7E 7F\txyz{|}~.",
+    "4711\t1700000001.1234\t124\tSFB--\t64\t40 41 42 43 44 45 46 47 48 49\t@ABCDEFGHI\n\t4A 4B 4C 4D 4E 4F 50 51 52 53\tJKLMNOPQRS\n\t54 55 56 57 58 59 5A 5B 5C 5D\tTUVWXYZ[\\]\n\t5E 5F 60 61 62 63 64 65 66 67\t^_`abcdefg\n\t68 69 6A 6B 6C 6D 6E 6F 70 71\thijklmnopq\n\t72 73 74 75 76 77 78 79 7A 7B\trstuvwxyz{\n\t7C 7D 7E 7F                  \t|}~.",
+    "4711\t1700000001.1234\t124\tSFB--\t64\t40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F\t@ABCDEFGHIJKLMNO\n\t50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F\tPQRSTUVWXYZ[\\]^_\n\t60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F\t`abcdefghijklmno\n\t70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F\tpqrstuvwxyz{|}~.",
+    "4711\t1700000001.1234\t124\tSFB--\t64\t40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F 50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F\t@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_\n\t60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F 70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F\t`abcdefghijklmnopqrstuvwxyz{|}~.",
+    "4711\t1700000001.1234\t124\tSFB--\t64\t40 41 42 43 44 45 46 47 48 49 4A 4B 4C 4D 4E 4F 50 51 52 53 54 55 56 57 58 59 5A 5B 5C 5D 5E 5F 60 61 62 63 64 65 66 67 68 69 6A 6B 6C 6D 6E 6F 70 71 72 73 74 75 76 77 78 79 7A 7B 7C 7D 7E 7F\t@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~."
+};
+static const char *golden_dec_oct[] = {
+    "4711     1700000002.1234  125  SFB-- 64  128 129 130 131 132 133 134 135 136 137 138 139 140 141 142 143  ................\n                                         144 145 146 147 148 149 150 151 152 153 154 155 156 157 158 159  ................\n                                         160 161 162 163 164 165 166 167 168 169 170 171 172 173 174 175  ................\n                                         176 177 178 179 180 181 182 183 184 185 186 187 188 189 190 191  ................",
+    "4711     1700000002.1234  125  SFB-- 64  200 201 202 203 204 205 206 207 210 211 212 213 214 215 216 217  ................\n                                         220 221 222 223 224 225 226 227 230 231 232 233 234 235 236 237  ................\n                                         240 241 242 243 244 245 246 247 250 251 252 253 254 255 256 257  ................\n                                         260 261 262 263 264 265 266 267 270 271 272 273 274 275 276 277  ................"
+};
+static const char *golden_lengths[] = {
+    "0        1700000003.1234  126  SFB-- 0 ",
+    "1        1700000003.1234  126  SFB-- 1   C0                                                                                                                                                                                               .",
+    "2        1700000003.1234  126  SFB-- 2   C0 C1                                                                                                                                                                                            ..",
+    "3        1700000003.1234  126  SFB-- 3   C0 C1 C2                                                                                                                                                                                         ...",
+    "4        1700000003.1234  126  SFB-- 4   C0 C1 C2 C3                                                                                                                                                                                      ....",
+    "5        1700000003.1234  126  SFB-- 5   C0 C1 C2 C3 C4                                                                                                                                                                                   .....",
+    "6        1700000003.1234  126  SFB-- 6   C0 C1 C2 C3 C4 C5                                                                                                                                                                                ......",
+    "7        1700000003.1234  126  SFB-- 7   C0 C1 C2 C3 C4 C5 C6                                                                                                                                                                             .......",
+    "8        1700000003.1234  126  SFB-- 8   C0 C1 C2 C3 C4 C5 C6 C7                                                                                                                                                                          ........",
+    "9        1700000003.1234  126  SFB-- 12  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB                                                                                                                                                              ............",
+    "10       1700000003.1234  126  SFB-- 16  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF                                                                                                                                                  ................",
+    "11       1700000003.1234  126  SFB-- 20  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF D0 D1 D2 D3                                                                                                                                      ....................",
+    "12       1700000003.1234  126  SFB-- 24  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF D0 D1 D2 D3 D4 D5 D6 D7                                                                                                                          ........................",
+    "13       1700000003.1234  126  SFB-- 32  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF D0 D1 D2 D3 D4 D5 D6 D7 D8 D9 DA DB DC DD DE DF                                                                                                  ................................",
+    "14       1700000003.1234  126  SFB-- 48  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF D0 D1 D2 D3 D4 D5 D6 D7 D8 D9 DA DB DC DD DE DF E0 E1 E2 E3 E4 E5 E6 E7 E8 E9 EA EB EC ED EE EF                                                  ................................................",
+    "15       1700000003.1234  126  SFB-- 64  C0 C1 C2 C3 C4 C5 C6 C7 C8 C9 CA CB CC CD CE CF D0 D1 D2 D3 D4 D5 D6 D7 D8 D9 DA DB DC DD DE DF E0 E1 E2 E3 E4 E5 E6 E7 E8 E9 EA EB EC ED EE EF F0 F1 F2 F3 F4 F5 F6 F7 F8 F9 FA FB FC FD FE FF  ................................................................"
+};
+static const char *golden_can_cc = "42       1700000003.1234  126  S---- 8  C0 C1 C2 C3 C4 C5 C6 C7  ........";
+static const char *golden_can_cc_dlc15[] = {
+    "4711     1700000001.1234  124  S---- 64  40 41 42 43 44 45 46 47  \n                                         48 49 4A 4B 4C 4D 4E 4F  \n                                         50 51 52 53 54 55 56 57  \n                                         58 59 5A 5B 5C 5D 5E 5F  \n                                         60 61 62 63 64 65 66 67  \n                                         68 69 6A 6B 6C 6D 6E 6F  \n                                         70 71 72 73 74 75 76 77  \n                                         78 79 7A 7B 7C 7D 7E 7F  @ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~.",
+    "4711\t1700000001.1234\t124\tS----\t64\t40 41 42 43 44 45 46 47\t\n\t48 49 4A 4B 4C 4D 4E 4F\t\n\t50 51 52 53 54 55 56 57\t\n\t58 59 5A 5B 5C 5D 5E 5F\t\n\t60 61 62 63 64 65 66 67\t\n\t68 69 6A 6B 6C 6D 6E 6F\t\n\t70 71 72 73 74 75 76 77\t\n\t78 79 7A 7B 7C 7D 7E 7F\t@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~."
+};
+
+static void MakeMessage(msg_message_t *message, int n, uint8_t dlc, bool fdf) {
+    bzero(message, sizeof(msg_message_t));
+    message->id = 0x123U + (uint32_t)n;
+    message->fdf = fdf ? 1 : 0;
+    message->brs = fdf ? 1 : 0;
+    message->dlc = dlc;
+    for (int i = 0; i < CANFD_MAX_LEN; i++)
+        message->data[i] = (uint8_t)(n * CANFD_MAX_LEN + i);  // all byte values in 4 messages
+    message->timestamp.tv_sec = 1700000000 + n;
+    message->timestamp.tv_nsec = 123456789;
+}
+
+@interface test_can_msg : XCTestCase
+
+@end
+
+@implementation test_can_msg
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    // note: the formatter options are global, set them to the defaults (but absolute time-stamps)
+    (void)msg_set_fmt_time_stamp(MSG_FMT_TIMESTAMP_ABSOLUTE);
+    (void)msg_set_fmt_time_usec(MSG_FMT_OPTION_OFF);
+    (void)msg_set_fmt_time_format(MSG_FMT_TIME_SEC);
+    (void)msg_set_fmt_id(MSG_FMT_NUMBER_HEX);
+    (void)msg_set_fmt_id_xtd(MSG_FMT_OPTION_OFF);
+    (void)msg_set_fmt_dlc(MSG_FMT_NUMBER_DEC);
+    (void)msg_set_fmt_dlc_format(MSG_FMT_CANFD_LENGTH);
+    (void)msg_set_fmt_dlc_brackets('\0');
+    (void)msg_set_fmt_flags(MSG_FMT_OPTION_ON);
+    (void)msg_set_fmt_data(MSG_FMT_NUMBER_HEX);
+    (void)msg_set_fmt_ascii(MSG_FMT_OPTION_ON);
+    (void)msg_set_fmt_ascii_subst('.');
+    (void)msg_set_fmt_channel(MSG_FMT_OPTION_OFF);
+    (void)msg_set_fmt_counter(MSG_FMT_OPTION_ON);
+    (void)msg_set_fmt_separator(MSG_FMT_SEPARATOR_SPACES);
+    (void)msg_set_fmt_wraparound(MSG_FMT_WRAPAROUND_NO);
+    (void)msg_set_fmt_eol(MSG_FMT_OPTION_OFF);
+    (void)msg_set_fmt_rx_prompt("");
+    (void)msg_set_fmt_tx_prompt("");
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+// @xctest TC0C.1: call 'msg_format_data' with CAN FD frames (64 bytes)
+//
+// @expected the same output as the sprintf/strcat formatter
+//
+- (void)testFormatDataOfCanFdFrames {
+    msg_message_t message;
+    // @test:
+    // @- loop over 4 messages with all byte values
+    for (int n = 0; n < 4; n++) {
+        MakeMessage(&message, n, 0xF, true);
+        // @-- format the data field (hex)
+        XCTAssertEqual(0, strcmp(golden_data[n], msg_format_data(&message)));
+    }
+}
+
+// @xctest TC0C.2: call 'msg_format_ascii' with CAN FD frames (64 bytes)
+//
+// @expected the same output as the sprintf/strcat formatter
+//
+- (void)testFormatAsciiOfCanFdFrames {
+    msg_message_t message;
+    // @test:
+    // @- loop over 4 messages with all byte values
+    for (int n = 0; n < 4; n++) {
+        MakeMessage(&message, n, 0xF, true);
+        // @-- format the data field (ASCII, non-printables substituted)
+        XCTAssertEqual(0, strcmp(golden_ascii[n], msg_format_ascii(&message)));
+    }
+}
+
+// @xctest TC0C.3: call 'msg_format_message' and 'msg_format_message_r' with wraparound {8, 10, 16, 32, 64}
+//
+// @expected the same output as the sprintf/strcat formatter (indent by spaces)
+//
+- (void)testFormatMessageWithWraparound {
+    const msg_fmt_wraparound_t wraparound[5] = {
+        MSG_FMT_WRAPAROUND_8, MSG_FMT_WRAPAROUND_10, MSG_FMT_WRAPAROUND_16, MSG_FMT_WRAPAROUND_32, MSG_FMT_WRAPAROUND_64
+    };
+    char buffer[MSG_STRING_LENGTH];
+    msg_message_t message;
+    int rc;
+    MakeMessage(&message, 1, 0xF, true);
+    // @test:
+    // @- loop over all wraparound options
+    for (int i = 0; i < 5; i++) {
+        XCTAssertEqual(1, msg_set_fmt_wraparound(wraparound[i]));
+        // @-- format the message into the static buffer
+        XCTAssertEqual(0, strcmp(golden_wraparound[i], msg_format_message(&message, MSG_RX_MESSAGE, 4711U, 0)));
+        // @-- format the message into the caller's buffer
+        rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 4711U, 0, NULL);
+        XCTAssertEqual((int)strlen(golden_wraparound[i]), rc);
+        XCTAssertEqual(0, strcmp(golden_wraparound[i], buffer));
+    }
+}
+
+// @xctest TC0C.4: call 'msg_format_message' and 'msg_format_message_r' with wraparound {8, 10, 16, 32, 64} and tabs
+//
+// @expected the same output as the sprintf/strcat formatter (indent by a tab)
+//
+- (void)testFormatMessageWithWraparoundAndTabs {
+    const msg_fmt_wraparound_t wraparound[5] = {
+        MSG_FMT_WRAPAROUND_8, MSG_FMT_WRAPAROUND_10, MSG_FMT_WRAPAROUND_16, MSG_FMT_WRAPAROUND_32, MSG_FMT_WRAPAROUND_64
+    };
+    char buffer[MSG_STRING_LENGTH];
+    msg_message_t message;
+    int rc;
+    MakeMessage(&message, 1, 0xF, true);
+    XCTAssertEqual(1, msg_set_fmt_separator(MSG_FMT_SEPARATOR_TABS));
+    // @test:
+    // @- loop over all wraparound options
+    for (int i = 0; i < 5; i++) {
+        XCTAssertEqual(1, msg_set_fmt_wraparound(wraparound[i]));
+        // @-- format the message into the static buffer
+        XCTAssertEqual(0, strcmp(golden_wraparound_tabs[i], msg_format_message(&message, MSG_RX_MESSAGE, 4711U, 0)));
+        // @-- format the message into the caller's buffer
+        rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 4711U, 0, NULL);
+        XCTAssertEqual((int)strlen(golden_wraparound_tabs[i]), rc);
+        XCTAssertEqual(0, strcmp(golden_wraparound_tabs[i], buffer));
+    }
+}
+
+// @xctest TC0C.5: call 'msg_format_message' with decimal and octal data (wraparound 16)
+//
+// @expected the same output as the sprintf/strcat formatter
+//
+- (void)testFormatMessageWithDecimalAndOctalData {
+    msg_message_t message;
+    MakeMessage(&message, 2, 0xF, true);
+    XCTAssertEqual(1, msg_set_fmt_wraparound(MSG_FMT_WRAPAROUND_16));
+    // @test:
+    // @- format the message with decimal data
+    XCTAssertEqual(1, msg_set_fmt_data(MSG_FMT_NUMBER_DEC));
+    XCTAssertEqual(0, strcmp(golden_dec_oct[0], msg_format_message(&message, MSG_RX_MESSAGE, 4711U, 0)));
+    // @- format the message with octal data
+    XCTAssertEqual(1, msg_set_fmt_data(MSG_FMT_NUMBER_OCT));
+    XCTAssertEqual(0, strcmp(golden_dec_oct[1], msg_format_message(&message, MSG_RX_MESSAGE, 4711U, 0)));
+}
+
+// @xctest TC0C.6: call 'msg_format_message' with all data lengths (CAN FD DLC 0 .. 15 and CAN CC DLC 8)
+//
+// @expected the same output as the sprintf/strcat formatter
+//
+- (void)testFormatMessageOfAllLengths {
+    msg_message_t message;
+    // @test:
+    // @- loop over all CAN FD data length codes
+    for (uint8_t dlc = 0U; dlc < 16U; dlc++) {
+        MakeMessage(&message, 3, dlc, true);
+        // @-- format the message (no wraparound)
+        XCTAssertEqual(0, strcmp(golden_lengths[dlc], msg_format_message(&message, MSG_RX_MESSAGE, (msg_counter_t)dlc, 0)));
+    }
+    // @- format a CAN CC message with 8 bytes
+    MakeMessage(&message, 3, 8U, false);
+    XCTAssertEqual(0, strcmp(golden_can_cc, msg_format_message(&message, MSG_RX_MESSAGE, 42U, 0)));
+}
+
+// @xctest TC0C.7: call 'msg_format_message_r' with buffers too small for the message
+//
+// @expected the message truncated to (length - 1) characters and zero-terminated
+//
+- (void)testFormatMessageIntoTooSmallBuffer {
+    char buffer[MSG_STRING_LENGTH];
+    msg_message_t message;
+    size_t expected;
+    int rc;
+    MakeMessage(&message, 1, 0xF, true);
+    XCTAssertEqual(1, msg_set_fmt_wraparound(MSG_FMT_WRAPAROUND_16));
+    expected = strlen(golden_wraparound[2]);
+    // @test:
+    // @- loop over all buffer sizes up to the message length plus one
+    for (size_t length = 1U; length <= (expected + 1U); length++) {
+        memset(buffer, '#', sizeof(buffer));
+        // @-- format the message into a buffer of the given size
+        rc = msg_format_message_r(buffer, length, &message, MSG_RX_MESSAGE, 4711U, 0, NULL);
+        XCTAssertEqual((int)((length - 1U) < expected ? (length - 1U) : expected), rc);
+        XCTAssertEqual('\0', buffer[rc]);
+        XCTAssertEqual(0, strncmp(golden_wraparound[2], buffer, (size_t)rc));
+        XCTAssertEqual('#', buffer[length]);  // nothing written behind the buffer
+    }
+}
+
+// @xctest TC0C.8: call 'msg_format_message_r' with NULL pointer for 'buffer' and for 'message'
+//
+// @expected a negative value for no buffer, an empty string for no message
+//
+- (void)testFormatMessageWithNullPointer {
+    char buffer[MSG_STRING_LENGTH] = "#";
+    msg_message_t message;
+    int rc;
+    MakeMessage(&message, 0, 8U, false);
+    // @test:
+    // @- call 'msg_format_message_r' with NULL pointer for 'buffer'
+    rc = msg_format_message_r(NULL, sizeof(buffer), &message, MSG_RX_MESSAGE, 0U, 0, NULL);
+    XCTAssertLessThan(rc, 0);
+    // @- call 'msg_format_message_r' with zero for 'length'
+    rc = msg_format_message_r(buffer, 0U, &message, MSG_RX_MESSAGE, 0U, 0, NULL);
+    XCTAssertLessThan(rc, 0);
+    XCTAssertEqual('#', buffer[0]);
+    // @- call 'msg_format_message_r' with NULL pointer for 'message'
+    rc = msg_format_message_r(buffer, sizeof(buffer), NULL, MSG_RX_MESSAGE, 0U, 0, NULL);
+    XCTAssertEqual(0, rc);
+    XCTAssertEqual('\0', buffer[0]);
+}
+
+// @xctest TC0C.9: call 'msg_format_message_r' with relative time-stamps and two caller-owned references
+//
+// @expected each reference keeps its own time of the previous message, no reference gives the absolute time
+//
+- (void)testFormatMessageWithOwnReference {
+    msg_timestamp_t reference[2] = { { 0, 0 }, { 0, 0 } };
+    char buffer[MSG_STRING_LENGTH];
+    msg_message_t message;
+    int rc;
+    MakeMessage(&message, 3, 0U, false);
+    XCTAssertEqual(1, msg_set_fmt_time_stamp(MSG_FMT_TIMESTAMP_RELATIVE));
+    XCTAssertEqual(1, msg_set_fmt_counter(MSG_FMT_OPTION_OFF));
+    // @test:
+    // @- format the first message with reference 1 (time 0)
+    rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 0U, 0, &reference[0]);
+    XCTAssertLessThan(0, rc);
+    XCTAssertEqual(0, strncmp("  0.0000", buffer, 8U));
+    // @- format a message 5 seconds later with reference 2 (time 0)
+    message.timestamp.tv_sec += 5;
+    rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 0U, 0, &reference[1]);
+    XCTAssertLessThan(0, rc);
+    XCTAssertEqual(0, strncmp("  0.0000", buffer, 8U));
+    // @- format a message 2 seconds later with reference 1 (time 7 sec)
+    message.timestamp.tv_sec += 2;
+    rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 0U, 0, &reference[0]);
+    XCTAssertLessThan(0, rc);
+    XCTAssertEqual(0, strncmp("  7.0000", buffer, 8U));
+    // @- format the same message with reference 2 (time 2 sec)
+    rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 0U, 0, &reference[1]);
+    XCTAssertLessThan(0, rc);
+    XCTAssertEqual(0, strncmp("  2.0000", buffer, 8U));
+    // @- format the same message without reference (absolute time)
+    rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 0U, 0, NULL);
+    XCTAssertLessThan(0, rc);
+    XCTAssertEqual(0, strncmp("1700000010.1234", buffer, 15U));
+}
+
+// @xctest TC0C.10: call 'msg_format_message' and 'msg_format_message_r' with a CAN CC frame of DLC 15 (no wraparound)
+//
+// @expected the same output as the sprintf/strcat formatter (wrapped after 8 bytes, all ASCII in the last line)
+//
+- (void)testFormatMessageOfCanCcFrameWithDlc15 {
+    char buffer[MSG_STRING_LENGTH];
+    msg_message_t message;
+    int rc;
+    MakeMessage(&message, 1, 0xF, false);
+    // @test:
+    // @- loop over both separators (spaces and tabs)
+    for (int i = 0; i < 2; i++) {
+        XCTAssertEqual(1, msg_set_fmt_separator(i ? MSG_FMT_SEPARATOR_TABS : MSG_FMT_SEPARATOR_SPACES));
+        // @-- format the message into the static buffer
+        XCTAssertEqual(0, strcmp(golden_can_cc_dlc15[i], msg_format_message(&message, MSG_RX_MESSAGE, 4711U, 0)));
+        // @-- format the message into the caller's buffer
+        rc = msg_format_message_r(buffer, sizeof(buffer), &message, MSG_RX_MESSAGE, 4711U, 0, NULL);
+        XCTAssertEqual((int)strlen(golden_can_cc_dlc15[i]), rc);
+        XCTAssertEqual(0, strcmp(golden_can_cc_dlc15[i], buffer));
+    }
+}
+
+@end
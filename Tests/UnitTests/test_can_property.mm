@@ -1335,6 +1335,60 @@ static struct property {
     XCTAssertEqual(MAX_PROPERTIES, i);
 }
 
+// @xctest TC12.10: Set reception thread properties before and after initialization
+//
+// @expected CANERR_NOERROR before can_init, CANERR_YETINIT while initialized
+//
+- (void)testReceptionThreadProperties {
+    can_bitrate_t bitrate = { TEST_BTRINDEX };
+    uint8_t mode = 0U, pool = 0U;
+    int32_t policy = -1;
+    int handle = INVALID_HANDLE;
+    int rc = CANERR_FATAL;
+
+    // @test:
+    // @- set a pool of 2 reception threads (before can_init)
+    pool = 2U;
+    rc = can_property(INVALID_HANDLE, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_THREAD_POOL, (void*)&pool, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    mode = 2U;
+    rc = can_property(INVALID_HANDLE, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_THREAD_MODE, (void*)&mode, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- an invalid pool size shall be rejected
+    pool = 0U;
+    rc = can_property(INVALID_HANDLE, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_THREAD_POOL, (void*)&pool, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_ILLPARA, rc);
+    // @- read the settings back
+    rc = can_property(INVALID_HANDLE, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_THREAD_MODE, (void*)&mode, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    XCTAssertEqual(2U, mode);
+    rc = can_property(INVALID_HANDLE, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_THREAD_POOL, (void*)&pool, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    XCTAssertEqual(2U, pool);
+    // @- initialize and start DUT1 (reception on the pool)
+    handle = can_init(DUT1, TEST_CANMODE, NULL);
+    XCTAssertLessThanOrEqual(0, handle);
+    rc = can_start(handle, &bitrate);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- send and receive some frames to/from DUT2 (optional)
+#if (SEND_TEST_FRAMES != 0)
+    CTester tester;
+    XCTAssertEqual(TEST_FRAMES, tester.SendSomeFrames(handle, DUT2, TEST_FRAMES));
+    XCTAssertEqual(TEST_FRAMES, tester.ReceiveSomeFrames(handle, DUT2, TEST_FRAMES));
+#endif
+    // @- the settings cannot be changed while initialized
+    policy = SCHED_OTHER;
+    rc = can_property(handle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_SCHED_POLICY, (void*)&policy, sizeof(int32_t));
+    XCTAssertEqual(CANERR_YETINIT, rc);
+    // @- shutdown DUT1
+    rc = can_exit(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- back to the driver thread (after can_exit)
+    mode = 0U;
+    rc = can_property(INVALID_HANDLE, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_THREAD_MODE, (void*)&mode, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+}
+
 @end
 
 // $Id: test_can_property.mm 1083 2022-07-25 12:40:16Z makemake $  Copyright (c) UV Software, Berlin //
@@ -1020,6 +1020,73 @@
 
     // @end.
 }
+
+// @xctest TC04.11: Read CAN messages in spin-then-block and busy-poll wait mode
+//
+// @expected: CANERR_NOERROR, or CANERR_RX_EMPTY when timed out
+//
+- (void)testReadWithSpinAndPollWaitMode {
+    can_bitrate_t bitrate = { TEST_BTRINDEX };
+    can_status_t status = { CANSTAT_RESET };
+    can_message_t message = {};
+    uint8_t waitMode = 0U;
+    uint32_t spinTime = 0U;
+    int handle = INVALID_HANDLE;
+    int rc = CANERR_FATAL;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    handle = can_init(DUT1, TEST_CANMODE, NULL);
+    XCTAssertLessThanOrEqual(0, handle);
+    // @- start DUT1 with configured bit-rate settings
+    rc = can_start(handle, &bitrate);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @test:
+    // @- set spin time of 500us and read it back
+    spinTime = 500U;
+    rc = can_property(handle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_SPIN_TIME, (void*)&spinTime, sizeof(uint32_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    spinTime = 0U;
+    rc = can_property(handle, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_SPIN_TIME, (void*)&spinTime, sizeof(uint32_t));
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    XCTAssertEqual(500U, spinTime);
+    // @- an invalid wait mode shall be rejected
+    waitMode = 3U;
+    rc = can_property(handle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_WAIT_MODE, (void*)&waitMode, sizeof(uint8_t));
+    XCTAssertEqual(CANERR_ILLPARA, rc);
+    // @- loop over wait modes spin-then-block (1) and busy-poll (2)
+    for (waitMode = 1U; waitMode <= 2U; waitMode++) {
+        // @-- set the wait mode and read it back
+        rc = can_property(handle, CANPROP_SET_VENDOR_PROP + KVASER_PROP_RX_WAIT_MODE, (void*)&waitMode, sizeof(uint8_t));
+        XCTAssertEqual(CANERR_NOERROR, rc);
+        uint8_t value = 0U;
+        rc = can_property(handle, CANPROP_GET_VENDOR_PROP + KVASER_PROP_RX_WAIT_MODE, (void*)&value, sizeof(uint8_t));
+        XCTAssertEqual(CANERR_NOERROR, rc);
+        XCTAssertEqual(waitMode, value);
+        // @-- try to read a message from DUT1 when there in none (timed out)
+        CTimer timer = CTimer(10U * CTimer::MSEC);
+        rc = can_read(handle, &message, 10U);
+        XCTAssertEqual(CANERR_RX_EMPTY, rc);
+        XCTAssertTrue(timer.Timeout());
+        // @-- send and receive some frames to/from DUT2 (optional)
+#if (SEND_TEST_FRAMES != 0)
+        CTester tester;
+        XCTAssertEqual(TEST_FRAMES, tester.SendSomeFrames(handle, DUT2, TEST_FRAMES));
+        XCTAssertEqual(TEST_FRAMES, tester.ReceiveSomeFrames(handle, DUT2, TEST_FRAMES));
+#endif
+    }
+    // @- get status of DUT1 and check to be in RUNNING state
+    rc = can_status(handle, &status.byte);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    XCTAssertFalse(status.can_stopped);
+    // @post:
+    // @- stop/reset DUT1
+    rc = can_reset(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @- tear down DUT1
+    rc = can_exit(handle);
+    XCTAssertEqual(CANERR_NOERROR, rc);
+    // @end.
+}
 @end
 
 // $Id: test_can_read.mm 1138 2023-08-10 18:25:16Z haumea $  Copyright (c) UV Software, Berlin //
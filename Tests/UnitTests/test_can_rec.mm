@@ -0,0 +1,293 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#import "Settings.h"
+#import "can_rec.h"
+#import <XCTest/XCTest.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const uint8_t dlc2len[16] = { 0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64 };
+
+static void MakeMessage(rec_message_t *message, int n) {
+    bzero(message, sizeof(rec_message_t));
+    message->xtd = (n % 5) == 0;
+    message->id = message->xtd ? (0x1ABCDE00U + (uint32_t)n) : (0x100U + (uint32_t)(n & 0x6FF));
+    message->fdf = (n % 2) == 0;
+    message->brs = message->fdf && ((n % 4) == 0);
+    message->esi = message->fdf && ((n % 3) == 0);
+    message->rtr = !message->fdf && ((n % 7) == 1);
+    message->sts = (n % 11) == 0;
+    message->dlc = message->fdf ? (uint8_t)(n % 16) : (uint8_t)(n % 9);
+    if (!message->rtr) {
+        for (int i = 0; i < (message->fdf ? dlc2len[message->dlc] : message->dlc); i++)
+            message->data[i] = (uint8_t)(n + i);
+    }
+    message->timestamp.tv_sec = 1700000000 + (n / 1000);
+    message->timestamp.tv_nsec = (long)(n % 1000) * 1000000L + 4711L;
+}
+
+static void RemoveCapture(const char *path) {
+    char name[PATH_MAX];
+    (void)unlink(path);
+    for (int i = 1; i < 100; i++) {
+        (void)snprintf(name, sizeof(name), "%s.%i", path, i);
+        (void)unlink(name);
+    }
+}
+
+@interface test_can_rec : XCTestCase {
+    char path[PATH_MAX];
+}
+@end
+
+@implementation test_can_rec
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    (void)snprintf(path, sizeof(path), "%s/test_can_rec.crec", [NSTemporaryDirectory() UTF8String]);
+    RemoveCapture(path);
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    RemoveCapture(path);
+}
+
+// @xctest TC0D.1: write CAN CC and CAN FD messages to a capture file and read them back
+//
+// @expected the messages read are identical to the messages written
+//
+- (void)testWriteAndReadMessages {
+    rec_recorder_t recorder = NULL;
+    rec_reader_t reader = NULL;
+    rec_message_t message[100], result;
+    rec_stats_t stats;
+    int n;
+    // @pre:
+    for (n = 0; n < 100; n++)
+        MakeMessage(&message[n], n);
+    // @test:
+    // @- create a capture file and write 100 messages (all DLCs and flags)
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_create(&recorder, path, NULL, 0U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_write(recorder, message, 100U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_stats(recorder, &stats));
+    XCTAssertEqual(100U, stats.records);
+    XCTAssertEqual(1U, stats.segments);
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_close(recorder));
+    // @- open the capture file and read all messages (twice)
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_open(&reader, path));
+    for (int pass = 0; pass < 2; pass++) {
+        for (n = 0; n < 100; n++) {
+            XCTAssertEqual(1, rec_reader_read(reader, &result));
+            XCTAssertEqual(0, memcmp(&message[n], &result, sizeof(rec_message_t)));
+        }
+        // @-- the end of the capture is reached
+        XCTAssertEqual(0, rec_reader_read(reader, &result));
+        XCTAssertEqual(RECERR_NOERROR, rec_reader_rewind(reader));
+    }
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_close(reader));
+}
+
+// @xctest TC0D.2: write the capture information to the file header and read it back
+//
+// @expected the capture information read is identical to the information written
+//
+- (void)testCaptureInformation {
+    rec_recorder_t recorder = NULL;
+    rec_reader_t reader = NULL;
+    rec_info_t info, result;
+    // @pre:
+    bzero(&info, sizeof(rec_info_t));
+    info.channel = 7;
+    info.mode = CANMODE_FDOE | CANMODE_BRSE;
+    info.bitrate.btr.frequency = CANBTR_FREQ_80MHz;
+    info.bitrate.btr.nominal.brp = 2U;
+    info.bitrate.btr.nominal.tseg1 = 63U;
+    info.bitrate.btr.nominal.tseg2 = 16U;
+    info.bitrate.btr.nominal.sjw = 16U;
+    info.bitrate.btr.data.brp = 2U;
+    info.bitrate.btr.data.tseg1 = 7U;
+    info.bitrate.btr.data.tseg2 = 2U;
+    info.bitrate.btr.data.sjw = 2U;
+    strcpy(info.device, "Kvaser U100P");
+    // @test:
+    // @- create a capture file with the capture information
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_create(&recorder, path, &info, 0U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_close(recorder));
+    // @- open the capture file and retrieve the capture information
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_open(&reader, path));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_info(reader, &result));
+    XCTAssertEqual(info.channel, result.channel);
+    XCTAssertEqual(info.mode, result.mode);
+    XCTAssertEqual(0, memcmp(&info.bitrate, &result.bitrate, sizeof(btr_bitrate_t)));
+    XCTAssertEqual(0, strcmp(info.device, result.device));
+    XCTAssertEqual(0U, result.segment);
+    XCTAssertNotEqual(0U, result.session);
+    XCTAssertNotEqual(0, result.start.tv_sec);
+    // @- an empty capture has no messages
+    rec_message_t message;
+    XCTAssertEqual(0, rec_reader_read(reader, &message));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_close(reader));
+}
+
+// @xctest TC0D.3: write a capture with file rotation and read it back
+//
+// @expected the reader continues with the next segment at the end of a file
+//
+- (void)testWriteAndReadSegments {
+    const uint64_t segment_size = REC_HEADER_SIZE + 100U * REC_RECORD_MAX;
+    rec_recorder_t recorder = NULL;
+    rec_reader_t reader = NULL;
+    rec_message_t message, result;
+    rec_stats_t stats;
+    rec_info_t info;
+    struct stat st;
+    char name[PATH_MAX];
+    int n;
+    // @test:
+    // @- segment size less than file header plus one record is rejected
+    XCTAssertEqual(RECERR_ILLPARA, rec_recorder_create(&recorder, path, NULL, REC_HEADER_SIZE));
+    // @- create a capture file with rotation and write 1000 messages
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_create(&recorder, path, NULL, segment_size));
+    for (n = 0; n < 1000; n++) {
+        MakeMessage(&message, n);
+        XCTAssertEqual(RECERR_NOERROR, rec_recorder_write(recorder, &message, 1U));
+    }
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_stats(recorder, &stats));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_close(recorder));
+    XCTAssertLessThan(1U, stats.segments);
+    // @- no file exceeds the segment size
+    for (uint32_t i = 0U; i < stats.segments; i++) {
+        if (i)
+            (void)snprintf(name, sizeof(name), "%s.%u", path, i);
+        else
+            (void)snprintf(name, sizeof(name), "%s", path);
+        XCTAssertEqual(0, stat(name, &st));
+        XCTAssertLessThanOrEqual((uint64_t)st.st_size, segment_size);
+    }
+    // @- read all messages across the segments
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_open(&reader, path));
+    for (n = 0; n < 1000; n++) {
+        MakeMessage(&message, n);
+        XCTAssertEqual(1, rec_reader_read(reader, &result));
+        XCTAssertEqual(0, memcmp(&message, &result, sizeof(rec_message_t)));
+    }
+    XCTAssertEqual(0, rec_reader_read(reader, &result));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_info(reader, &info));
+    XCTAssertEqual(stats.segments - 1U, info.segment);
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_close(reader));
+}
+
+// @xctest TC0D.4: open a file that is not a capture file, and read a truncated capture file
+//
+// @expected RECERR_IO, RECERR_FORMAT
+//
+- (void)testInvalidCaptureFiles {
+    rec_recorder_t recorder = NULL;
+    rec_reader_t reader = NULL;
+    rec_message_t message;
+    FILE *fp;
+    // @test:
+    // @- open a file that does not exist
+    XCTAssertEqual(RECERR_IO, rec_reader_open(&reader, path));
+    // @- open a file that is not a capture file
+    XCTAssertTrue((fp = fopen(path, "w")) != NULL);
+    for (int i = 0; i < 32; i++)
+        fputs("Hello, World!\n", fp);
+    fclose(fp);
+    XCTAssertEqual(RECERR_FORMAT, rec_reader_open(&reader, path));
+    // @- read a capture file with a truncated record at its end
+    MakeMessage(&message, 2);
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_create(&recorder, path, NULL, 0U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_write(recorder, &message, 1U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_write(recorder, &message, 1U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_close(recorder));
+    XCTAssertEqual(0, truncate(path, REC_HEADER_SIZE + REC_RECORD_SIZE(2U) + 10U));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_open(&reader, path));
+    XCTAssertEqual(1, rec_reader_read(reader, &message));
+    XCTAssertEqual(RECERR_FORMAT, rec_reader_read(reader, &message));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_close(reader));
+}
+
+// @xctest TC0D.5: call the recorder and the reader with NULL pointers
+//
+// @expected RECERR_NULLPTR
+//
+- (void)testNullPointers {
+    rec_recorder_t recorder = NULL;
+    rec_reader_t reader = NULL;
+    rec_message_t message;
+    rec_stats_t stats;
+    rec_info_t info;
+    // @test:
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_create(NULL, path, NULL, 0U));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_create(&recorder, NULL, NULL, 0U));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_write(NULL, &message, 1U));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_flush(NULL));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_stats(NULL, &stats));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_close(NULL));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_open(NULL, path));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_open(&reader, NULL));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_info(NULL, &info));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_read(NULL, &message));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_rewind(NULL));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_close(NULL));
+    // @- with a valid handle
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_create(&recorder, path, NULL, 0U));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_write(recorder, NULL, 1U));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_write(recorder, NULL, 0U));
+    XCTAssertEqual(RECERR_NULLPTR, rec_recorder_stats(recorder, NULL));
+    XCTAssertEqual(RECERR_NOERROR, rec_recorder_close(recorder));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_open(&reader, path));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_info(reader, NULL));
+    XCTAssertEqual(RECERR_NULLPTR, rec_reader_read(reader, NULL));
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_close(reader));
+}
+
+@end
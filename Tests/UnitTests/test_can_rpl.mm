@@ -0,0 +1,306 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#import "Settings.h"
+#import "Settings.h"
+#import "can_rpl.h"
+#import "can_rec.h"
+#import <XCTest/XCTest.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define MAX_RESULTS  10000
+
+typedef struct {
+    rpl_message_t message[MAX_RESULTS];
+    size_t count;
+    size_t calls;
+    size_t largest;
+    rpl_replayer_t replayer;
+    size_t stopAfter;
+} result_t;
+
+static int Collect(void *context, const rpl_message_t *messages, size_t count) {
+    result_t *result = (result_t*)context;
+    for (size_t i = 0; (i < count) && (result->count < MAX_RESULTS); i++)
+        result->message[result->count++] = messages[i];
+    if (count > result->largest)
+        result->largest = count;
+    result->calls++;
+    if (result->stopAfter && (result->count >= result->stopAfter))
+        (void)rpl_replayer_stop(result->replayer);
+    return 0;
+}
+
+static void WriteCapture(const char *path, int count, long cycle) {
+    rec_recorder_t recorder = NULL;
+    rec_message_t message;
+    (void)rec_recorder_create(&recorder, path, NULL, 0U);
+    for (int n = 0; n < count; n++) {
+        bzero(&message, sizeof(rec_message_t));
+        message.id = 0x100U + (uint32_t)(n % 4);
+        message.dlc = 8U;
+        message.data[0] = (uint8_t)n;
+        message.timestamp.tv_sec = 1700000000 + ((n * cycle) / 1000000L);
+        message.timestamp.tv_nsec = ((n * cycle) % 1000000L) * 1000L;
+        (void)rec_recorder_write(recorder, &message, 1U);
+    }
+    (void)rec_recorder_close(recorder);
+}
+
+@interface test_can_rpl : XCTestCase {
+    char path[PATH_MAX];
+    char text[PATH_MAX];
+    result_t *result;
+}
+@end
+
+@implementation test_can_rpl
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    (void)snprintf(path, sizeof(path), "%s/test_can_rpl.crec", [NSTemporaryDirectory() UTF8String]);
+    (void)snprintf(text, sizeof(text), "%s/test_can_rpl.log", [NSTemporaryDirectory() UTF8String]);
+    result = (result_t*)calloc(1, sizeof(result_t));
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    (void)unlink(path);
+    (void)unlink(text);
+    free(result);
+}
+
+// @xctest TC0F.1: replay a candump log file (CAN CC and CAN FD messages)
+//
+// @expected all messages are handed over in the order of the log file
+//
+- (void)testReplayCandumpLog {
+    rpl_replayer_t replayer = NULL;
+    rpl_options_t options;
+    rpl_stats_t stats;
+    // @pre:
+    FILE *fp = fopen(text, "w");
+    XCTAssert(fp != NULL);
+    fprintf(fp, "(1697702400.000000) can0 123#1122334455667788\n");
+    fprintf(fp, "(1697702400.001000) can0 1ABCDEF0#R\n");
+    fprintf(fp, "(1697702400.002000) can0 456##3001122334455667788990011\n");
+    fprintf(fp, "(1697702400.003000) can0 20000004#0004000000000000\n");
+    fprintf(fp, "(1697702400.004000) can0 7FF#R3\n");
+    fclose(fp);
+    XCTAssertEqual(RPLERR_NOERROR, rpl_options_default(&options));
+    // @test:
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_open(&replayer, text, &options));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_run(replayer, Collect, (void*)result));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_stats(replayer, &stats));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_close(replayer));
+    // @- 4 messages replayed, the error frame is not
+    XCTAssertEqual(4U, result->count);
+    XCTAssertEqual(4U, stats.messages);
+    XCTAssertEqual(1U, stats.filtered);
+    XCTAssertEqual(1U, stats.loops);
+    // @- CAN CC data frame
+    XCTAssertEqual(0x123U, result->message[0].id);
+    XCTAssertFalse(result->message[0].xtd);
+    XCTAssertEqual(8U, result->message[0].dlc);
+    XCTAssertEqual(0x88U, result->message[0].data[7]);
+    // @- CAN CC remote frame (extended)
+    XCTAssertEqual(0x1ABCDEF0U, result->message[1].id);
+    XCTAssertTrue(result->message[1].xtd);
+    XCTAssertTrue(result->message[1].rtr);
+    // @- CAN FD data frame (BRS and ESI)
+    XCTAssertEqual(0x456U, result->message[2].id);
+    XCTAssertTrue(result->message[2].fdf);
+    XCTAssertTrue(result->message[2].brs);
+    XCTAssertTrue(result->message[2].esi);
+    XCTAssertEqual(9U, result->message[2].dlc);
+    XCTAssertEqual(0x11U, result->message[2].data[11]);
+    // @- CAN CC remote frame with DLC
+    XCTAssertEqual(0x7FFU, result->message[3].id);
+    XCTAssertTrue(result->message[3].rtr);
+    XCTAssertEqual(3U, result->message[3].dlc);
+    // @- the timing error is kept within bounds
+    XCTAssertLessThan(stats.error_max, (int64_t)RPL_LATE_LIMIT * 10000);
+}
+
+// @xctest TC0F.2: replay a capture file with acceptance filter and identifier mapping
+//
+// @expected only accepted messages are handed over, with mapped identifiers
+//
+- (void)testReplayFilterAndRemap {
+    rpl_replayer_t replayer = NULL;
+    rpl_options_t options;
+    rpl_stats_t stats;
+    // @pre:
+    WriteCapture(path, 100, 0L);
+    XCTAssertEqual(RPLERR_NOERROR, rpl_options_default(&options));
+    options.speed = 0.0;
+    options.filter_code = 0x100U;
+    options.filter_mask = 0x7FEU;
+    options.num_remaps = 1U;
+    options.remap[0].from = 0x101U;
+    options.remap[0].to = 0x12345U;
+    // @test:
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_open(&replayer, path, &options));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_run(replayer, Collect, (void*)result));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_stats(replayer, &stats));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_close(replayer));
+    // @- 0x100 and 0x101 (as 0x12345) pass, 0x102 and 0x103 not
+    XCTAssertEqual(50U, result->count);
+    XCTAssertEqual(50U, stats.filtered);
+    for (size_t i = 0; i < result->count; i++) {
+        if ((i % 2) == 0) {
+            XCTAssertEqual(0x100U, result->message[i].id);
+            XCTAssertFalse(result->message[i].xtd);
+        } else {
+            XCTAssertEqual(0x12345U, result->message[i].id);
+            XCTAssertTrue(result->message[i].xtd);
+        }
+    }
+}
+
+// @xctest TC0F.3: replay a capture file with several passes and batches
+//
+// @expected every pass hands over all messages, messages due at once are batched
+//
+- (void)testReplayLoopsAndBatches {
+    rpl_replayer_t replayer = NULL;
+    rpl_options_t options;
+    rpl_stats_t stats;
+    // @pre:
+    WriteCapture(path, 100, 0L);
+    XCTAssertEqual(RPLERR_NOERROR, rpl_options_default(&options));
+    options.speed = 0.0;
+    options.loops = 3U;
+    options.max_batch = 8U;
+    // @test:
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_open(&replayer, path, &options));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_run(replayer, Collect, (void*)result));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_stats(replayer, &stats));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_close(replayer));
+    XCTAssertEqual(300U, result->count);
+    XCTAssertEqual(3U, stats.loops);
+    XCTAssertEqual(8U, result->largest);
+    XCTAssertEqual(result->calls, stats.batches);
+    for (size_t i = 0; i < result->count; i++)
+        XCTAssertEqual((uint8_t)(i % 100), result->message[i].data[0]);
+}
+
+// @xctest TC0F.4: replay a capture file at ten times the original speed
+//
+// @expected the replay takes about a tenth of the capture duration
+//
+- (void)testReplaySpeedFactor {
+    rpl_replayer_t replayer = NULL;
+    rpl_options_t options;
+    rpl_stats_t stats;
+    // @pre: 500 messages every 2ms (1 second)
+    WriteCapture(path, 500, 2000L);
+    XCTAssertEqual(RPLERR_NOERROR, rpl_options_default(&options));
+    options.speed = 10.0;
+    // @test:
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_open(&replayer, path, &options));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_run(replayer, Collect, (void*)result));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_stats(replayer, &stats));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_close(replayer));
+    XCTAssertEqual(500U, result->count);
+    XCTAssertGreaterThanOrEqual(stats.duration, 99000000U);
+    XCTAssertLessThan(stats.duration, 200000000U);
+    XCTAssertLessThanOrEqual(stats.error_p50, stats.error_p99);
+    XCTAssertLessThanOrEqual(stats.error_p99, stats.error_p999);
+}
+
+// @xctest TC0F.5: stop a replay from the sender callback
+//
+// @expected the replay returns with RPLERR_STOPPED
+//
+- (void)testReplayStop {
+    rpl_replayer_t replayer = NULL;
+    rpl_options_t options;
+    // @pre:
+    WriteCapture(path, 100, 0L);
+    XCTAssertEqual(RPLERR_NOERROR, rpl_options_default(&options));
+    options.speed = 0.0;
+    options.loops = 0U;
+    options.max_batch = 1U;
+    // @test:
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_open(&replayer, path, &options));
+    result->replayer = replayer;
+    result->stopAfter = 250U;
+    XCTAssertEqual(RPLERR_STOPPED, rpl_replayer_run(replayer, Collect, (void*)result));
+    XCTAssertEqual(RPLERR_NOERROR, rpl_replayer_close(replayer));
+    XCTAssertEqual(250U, result->count);
+}
+
+// @xctest TC0F.6: call the replayer functions with invalid parameters
+//
+// @expected the functions return with an error code
+//
+- (void)testReplayInvalidParameters {
+    rpl_replayer_t replayer = NULL;
+    rpl_options_t options;
+    // @pre:
+    WriteCapture(path, 10, 0L);
+    XCTAssertEqual(RPLERR_NOERROR, rpl_options_default(&options));
+    // @test:
+    XCTAssertEqual(RPLERR_NULLPTR, rpl_replayer_open(NULL, path, &options));
+    XCTAssertEqual(RPLERR_NULLPTR, rpl_replayer_open(&replayer, NULL, &options));
+    XCTAssertEqual(RPLERR_IO, rpl_replayer_open(&replayer, "/nowhere/nothing.log", &options));
+    options.speed = -1.0;
+    XCTAssertEqual(RPLERR_ILLPARA, rpl_replayer_open(&replayer, path, &options));
+    options.speed = 1.0;
+    options.max_batch = 0U;
+    XCTAssertEqual(RPLERR_ILLPARA, rpl_replayer_open(&replayer, path, &options));
+    options.max_batch = RPL_MAX_BATCH + 1U;
+    XCTAssertEqual(RPLERR_ILLPARA, rpl_replayer_open(&replayer, path, &options));
+    XCTAssertEqual(RPLERR_NULLPTR, rpl_replayer_run(NULL, Collect, NULL));
+    XCTAssertEqual(RPLERR_NULLPTR, rpl_replayer_stats(NULL, NULL));
+    XCTAssertEqual(RPLERR_NULLPTR, rpl_replayer_close(NULL));
+}
+
+@end
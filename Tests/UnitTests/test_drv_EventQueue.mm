@@ -0,0 +1,163 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Leaf Interfaces
+ *
+ *  Copyright (c) 2020-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#import "Settings.h"
+#import "KvaserCAN_Driver.h"
+#import <XCTest/XCTest.h>
+
+#define TIMER_FREQ  24U  // Leaf timer in [MHz]
+
+@interface test_drv_EventQueue : XCTestCase {
+    KvaserUSB_RecvData_t context;
+}
+@end
+
+@implementation test_drv_EventQueue
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    memset(&context, 0, sizeof(KvaserUSB_RecvData_t));
+    context.timerFreq = TIMER_FREQ;
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+// @xctest TC1: Chip state events (bus status and error counters)
+//
+// @expected only transitions and counter changes are queued, with time-stamp and previous bus status
+//
+- (void)testChipStateEvents {
+    KvaserUSB_BusEvent_t events[4] = {};
+
+    // @test:
+    // @- error active at 1ms (48-bit timer value)
+    context.evData.chipState.time[0] = (uint16_t)(1000U * TIMER_FREQ);
+    context.evData.chipState.busStatus = BUSSTAT_ERROR_ACTIVE;
+    KvaserUSB_UpdateEventQueue(&context, CMD_CHIP_STATE_EVENT);
+    // @- the same chip state again (e.g. response to a poll)
+    KvaserUSB_UpdateEventQueue(&context, CMD_CHIP_STATE_EVENT);
+    // @- error passive with TEC = 128
+    context.evData.chipState.txErrorCounter = 128U;
+    context.evData.chipState.busStatus = BUSSTAT_ERROR_PASSIVE;
+    KvaserUSB_UpdateEventQueue(&context, CMD_CHIP_STATE_EVENT);
+    // @- still error passive, but REC = 1
+    context.evData.chipState.rxErrorCounter = 1U;
+    KvaserUSB_UpdateEventQueue(&context, CMD_CHIP_STATE_EVENT);
+    // @- three events in the queue
+    XCTAssertEqual(3U, KvaserUSB_ReadEventQueue(&context, events, 4U));
+    XCTAssertEqual(KVASER_EVENT_TYPE_CHIP_STATE, events[0].type);
+    XCTAssertEqual(0, events[0].timestamp.tv_sec);
+    XCTAssertEqual(1000000, events[0].timestamp.tv_nsec);
+    XCTAssertEqual(0x00U, events[0].prevStatus);
+    XCTAssertEqual(BUSSTAT_ERROR_ACTIVE, events[0].busStatus);
+    XCTAssertEqual(BUSSTAT_ERROR_ACTIVE, events[1].prevStatus);
+    XCTAssertEqual(BUSSTAT_ERROR_PASSIVE, events[1].busStatus);
+    XCTAssertEqual(128U, events[1].txErrorCounter);
+    XCTAssertEqual(0U, events[1].rxErrorCounter);
+    XCTAssertEqual(BUSSTAT_ERROR_PASSIVE, events[2].prevStatus);
+    XCTAssertEqual(BUSSTAT_ERROR_PASSIVE, events[2].busStatus);
+    XCTAssertEqual(1U, events[2].rxErrorCounter);
+    // @- the queue is empty
+    XCTAssertEqual(0U, KvaserUSB_ReadEventQueue(&context, events, 4U));
+}
+
+// @xctest TC2: CAN error events and error events
+//
+// @expected every event is queued, the error event keeps the last bus status and error counters
+//
+- (void)testErrorEvents {
+    KvaserUSB_BusEvent_t events[4] = {};
+
+    // @test:
+    // @- two CAN error events with the same bus status
+    context.evData.canError.busStatus = BUSSTAT_ERROR_WARNING;
+    context.evData.canError.txErrorCounter = 96U;
+    context.evData.canError.errorFactor = 0x04U;
+    KvaserUSB_UpdateEventQueue(&context, CMD_CAN_ERROR_EVENT);
+    KvaserUSB_UpdateEventQueue(&context, CMD_CAN_ERROR_EVENT);
+    // @- an error event from the firmware
+    context.evData.errorEvent.errorCode = 0x2AU;
+    KvaserUSB_UpdateEventQueue(&context, CMD_ERROR_EVENT);
+    // @- other commands are ignored
+    KvaserUSB_UpdateEventQueue(&context, CMD_TX_ACKNOWLEDGE);
+    // @- three events in the queue
+    XCTAssertEqual(3U, KvaserUSB_ReadEventQueue(&context, events, 4U));
+    XCTAssertEqual(KVASER_EVENT_TYPE_CAN_ERROR, events[0].type);
+    XCTAssertEqual(KVASER_EVENT_TYPE_CAN_ERROR, events[1].type);
+    XCTAssertEqual(0x04U, events[1].errorCode);
+    XCTAssertEqual(KVASER_EVENT_TYPE_ERROR, events[2].type);
+    XCTAssertEqual(0x2AU, events[2].errorCode);
+    XCTAssertEqual(BUSSTAT_ERROR_WARNING, events[2].busStatus);
+    XCTAssertEqual(96U, events[2].txErrorCounter);
+}
+
+// @xctest TC3: Queue full
+//
+// @expected the events that do not fit are counted as lost, the queued ones are read in batches
+//
+- (void)testQueueFull {
+    KvaserUSB_BusEvent_t events[16] = {};
+    uint32_t n, total = 0U;
+
+    // @test:
+    // @- more error counter changes than the queue can hold
+    for (uint32_t i = 0U; i < KVASER_EVENT_QUEUE_SIZE + 10U; i++) {
+        context.evData.chipState.rxErrorCounter = (uint8_t)(i + 1U);
+        KvaserUSB_UpdateEventQueue(&context, CMD_CHIP_STATE_EVENT);
+    }
+    XCTAssertEqual(10U, context.evQueue.lost);
+    // @- read them in batches of 16 (oldest first)
+    while ((n = KvaserUSB_ReadEventQueue(&context, events, 16U)) > 0U) {
+        XCTAssertEqual((uint8_t)(total + 1U), events[0].rxErrorCounter);
+        total += n;
+    }
+    XCTAssertEqual(KVASER_EVENT_QUEUE_SIZE, total);
+}
+
+@end
@@ -0,0 +1,238 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Leaf Interfaces
+ *
+ *  Copyright (c) 2020-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#import "Settings.h"
+#import "KvaserCAN_Driver.h"
+#import "KvaserUSB_FlightRec.h"
+#import "KvaserUSB_LoadMeter.h"
+#import "can_rec.h"
+#import <XCTest/XCTest.h>
+
+#define NANOSECONDS(ms)  ((uint64_t)(ms) * 1000000ULL)
+
+@interface test_drv_FlightRec : XCTestCase {
+    KvaserUSB_FlightRecorder_t recorder;
+    char prefix[KVASER_FLIGHT_PATH_LENGTH+1];
+    char path[KVASER_FLIGHT_PATH_LENGTH+16];
+}
+@end
+
+@implementation test_drv_FlightRec
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    (void)snprintf(prefix, sizeof(prefix), "%s/test_drv_FlightRec", [NSTemporaryDirectory() UTF8String]);
+    (void)snprintf(path, sizeof(path), "%s-1.crec", prefix);
+    (void)remove(path);
+    FlightRec_Init(&recorder);
+    strncpy(recorder.path, prefix, KVASER_FLIGHT_PATH_LENGTH);
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    FlightRec_Release(&recorder);
+    (void)remove(path);
+}
+
+// @xctest TC1: Capacity of the ring
+//
+// @expected rounded up to a power of 2, 0 = off, not changed while running
+//
+- (void)testCapacity {
+    // @test:
+    // @- the recorder is off by default
+    XCTAssertTrue(recorder.ring == NULL);
+    XCTAssertEqual(0U, recorder.capacity);
+    // @- the capacity is rounded up to a power of 2
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Configure(&recorder, 1000U));
+    XCTAssertTrue(recorder.ring != NULL);
+    XCTAssertEqual(1024U, recorder.capacity);
+    // @- too many CAN frames
+    XCTAssertEqual(CANUSB_ERROR_ILLPARA, FlightRec_Configure(&recorder, KVASER_FLIGHT_MAX_CAPACITY + 1U));
+    XCTAssertEqual(1024U, recorder.capacity);
+    // @- not while the writer thread is running
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    XCTAssertEqual(CANUSB_ERROR_BUSY, FlightRec_Configure(&recorder, 0U));
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    // @- switch it off
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Configure(&recorder, 0U));
+    XCTAssertTrue(recorder.ring == NULL);
+    XCTAssertEqual(0U, recorder.capacity);
+}
+
+// @xctest TC2: Pre- and post-trigger window (API call)
+//
+// @expected the CAN frames within 100ms before and 50ms after the trigger in the capture file,
+//           received and sent CAN frames with time-stamps on one time base (1ms apart)
+//
+- (void)testWindowAroundTrigger {
+    KvaserUSB_CanMessage_t message = {};
+    rec_reader_t reader = NULL;
+    rec_message_t record = {};
+    uint64_t now = LoadMeter_Now();
+    uint64_t stamp, previous = 0U;
+    uint32_t count = 0U, first = 0U, last = 0U, steps = 0U;
+
+    // @pre:
+    // @- a ring of 1024 CAN frames, 100ms before and 50ms after the trigger
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Configure(&recorder, 1024U));
+    recorder.preTime = 100U;
+    recorder.postTime = 50U;
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+
+    // @test:
+    // @- one CAN frame per millisecond from -500ms to +40ms, received and sent
+    // @  (note: all with the same device time-stamp, it must not show up)
+    message.dlc = 1U;
+    message.timestamp.tv_sec = 1;
+    message.timestamp.tv_nsec = 0;
+    for (uint32_t ms = 0U; ms <= 540U; ms++) {
+        message.id = ms;
+        message.data[0] = (uint8_t)ms;
+        if (ms == 500U)
+            XCTAssertTrue(FlightRec_Trigger(&recorder, KVASER_FLIGHT_API_CALL, now));
+        if (ms & 1U)
+            FlightRec_Record(&recorder, &message, now - NANOSECONDS(500U) + NANOSECONDS(ms));
+        else
+            FlightRec_RecordSent(&recorder, &message, now - NANOSECONDS(500U) + NANOSECONDS(ms));
+    }
+    // @- only the first trigger counts
+    XCTAssertFalse(FlightRec_Trigger(&recorder, KVASER_FLIGHT_API_CALL, now));
+    // @- the capture is written when the recorder is stopped
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(1U, recorder.captures);
+
+    // @post:
+    // @- read the capture file: from -100ms to +40ms, time-stamps 1ms apart
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_open(&reader, path));
+    while (rec_reader_read(reader, &record) == 1) {
+        stamp = ((uint64_t)record.timestamp.tv_sec * 1000000000ULL) + (uint64_t)record.timestamp.tv_nsec;
+        if (count++ == 0U)
+            first = record.id;
+        else if (stamp == (previous + NANOSECONDS(1U)))
+            steps++;
+        previous = stamp;
+        last = record.id;
+    }
+    XCTAssertEqual(RECERR_NOERROR, rec_reader_close(reader));
+    XCTAssertEqual(141U, count);
+    XCTAssertEqual(400U, first);
+    XCTAssertEqual(540U, last);
+    XCTAssertEqual(140U, steps);
+}
+
+// @xctest TC3: Trigger conditions
+//
+// @expected a capture on an error frame, on bus off and on an ID and payload match, when enabled
+//
+- (void)testTriggerConditions {
+    KvaserUSB_CanMessage_t message = {};
+
+    // @pre:
+    // @- a ring of 256 CAN frames, no post-trigger window
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Configure(&recorder, 256U));
+    recorder.postTime = 0U;
+    recorder.match.id = 0x123U;
+    recorder.match.dlc = 2U;
+    recorder.match.data[0] = 0xAAU;
+    recorder.match.data[1] = 0x55U;
+    message.id = 0x123U;
+    message.dlc = 8U;
+    message.data[0] = 0xAAU;
+    message.data[1] = 0x55U;
+
+    // @test:
+    // @- no trigger condition enabled
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    FlightRec_Record(&recorder, &message, LoadMeter_Now());
+    FlightRec_BusStatus(&recorder, BUSSTAT_ERROR_ACTIVE, BUSSTAT_BUSOFF);
+    message.sts = 1;
+    FlightRec_Record(&recorder, &message, LoadMeter_Now());
+    message.sts = 0;
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(0U, recorder.captures);
+    // @- error frame
+    recorder.triggers = KVASER_FLIGHT_ERROR_FRAME;
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    message.sts = 1;
+    FlightRec_Record(&recorder, &message, LoadMeter_Now());
+    message.sts = 0;
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(1U, recorder.captures);
+    // @- bus off (only the transition)
+    recorder.triggers = KVASER_FLIGHT_BUS_OFF;
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    FlightRec_BusStatus(&recorder, BUSSTAT_BUSOFF, BUSSTAT_BUSOFF);
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(1U, recorder.captures);
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    FlightRec_BusStatus(&recorder, BUSSTAT_ERROR_PASSIVE, BUSSTAT_BUSOFF);
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(2U, recorder.captures);
+    // @- identifier and payload (sent CAN frame)
+    recorder.triggers = KVASER_FLIGHT_ID_MATCH;
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    message.data[1] = 0x54U;
+    FlightRec_RecordSent(&recorder, &message, LoadMeter_Now());
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(2U, recorder.captures);
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Start(&recorder, 0, "test"));
+    message.data[1] = 0x55U;
+    FlightRec_RecordSent(&recorder, &message, LoadMeter_Now());
+    XCTAssertEqual(CANUSB_SUCCESS, FlightRec_Stop(&recorder));
+    XCTAssertEqual(3U, recorder.captures);
+
+    // @post:
+    // @- remove the other capture files
+    for (uint32_t n = 2U; n <= 3U; n++) {
+        char file[KVASER_FLIGHT_PATH_LENGTH+16];
+        (void)snprintf(file, sizeof(file), "%s-%u.crec", prefix, n);
+        (void)remove(file);
+    }
+}
+
+@end
@@ -0,0 +1,308 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Leaf Interfaces
+ *
+ *  Copyright (c) 2020-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#import "Settings.h"
+#import "KvaserCAN_Driver.h"
+#import <XCTest/XCTest.h>
+#import <pthread.h>
+
+#define QUEUE_SIZE  16U
+#define HIGH_RATE_FRAMES  1000000U
+
+static uint32_t GetUInt32(const uint8_t *data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void MakeFrame(KvaserUSB_CanMessage_t *message, uint32_t number) {
+    // the number of the CAN frame is its identifier and its time-stamp in [us]
+    memset(message, 0, sizeof(KvaserUSB_CanMessage_t));
+    message->id = number & CAN_MAX_XTD_ID;
+    message->xtd = 1;
+    message->dlc = 4U;
+    message->data[0] = (uint8_t)(number >> 0);
+    message->data[1] = (uint8_t)(number >> 8);
+    message->data[2] = (uint8_t)(number >> 16);
+    message->data[3] = (uint8_t)(number >> 24);
+    message->timestamp.tv_sec = (time_t)(number / 1000000U);
+    message->timestamp.tv_nsec = (long)(number % 1000000U) * 1000L;
+}
+
+typedef struct {
+    CANQUE_MsgQueue_t queue;
+    volatile bool done;
+} Producer_t;
+
+static void *ProducerThread(void *arg) {
+    Producer_t *producer = (Producer_t*)arg;
+    KvaserUSB_CanMessage_t message;
+
+    // not throttled, so that the queue overflows again and again
+    for (uint32_t i = 0U; i < HIGH_RATE_FRAMES; i++) {
+        MakeFrame(&message, i);
+        (void)CANQUE_Enqueue(producer->queue, (void*)&message);
+    }
+    producer->done = true;
+    (void)CANQUE_Signal(producer->queue);
+    return NULL;
+}
+
+@interface test_drv_GapMarker : XCTestCase {
+    KvaserUSB_RecvData_t context;
+}
+@end
+
+@implementation test_drv_GapMarker
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    memset(&context, 0, sizeof(KvaserUSB_RecvData_t));
+    context.msgQueue = CANQUE_Create(QUEUE_SIZE, sizeof(KvaserUSB_CanMessage_t));
+    XCTAssertTrue(context.msgQueue != NULL);
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    (void)CANQUE_Destroy(context.msgQueue);
+}
+
+// @xctest TC1: Headroom and gap marker of the queue
+//
+// @expected one element is kept free for the marker, the lost CAN frames are counted in one marker
+//
+- (void)testQueueGapMarker {
+    KvaserUSB_CanMessage_t message = {};
+    uint32_t n = 0U;
+
+    // @pre:
+    // @- gap markers on (a queue of one element is too small)
+    CANQUE_MsgQueue_t tiny = CANQUE_Create(1U, sizeof(KvaserUSB_CanMessage_t));
+    XCTAssertEqual(CANUSB_ERROR_ILLPARA, CANQUE_SetGapMarker(tiny, KvaserUSB_QueueGapMarker));
+    (void)CANQUE_Destroy(tiny);
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetGapMarker(context.msgQueue, KvaserUSB_QueueGapMarker));
+
+    // @test:
+    // @- the CAN frames fill all elements but one
+    for (n = 0U; n < QUEUE_SIZE - 1U; n++) {
+        MakeFrame(&message, n);
+        XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+    }
+    // @- 10 CAN frames lost (1ms apart)
+    for (uint32_t i = 0U; i < 10U; i++, n++) {
+        MakeFrame(&message, n + (i * 999U));
+        XCTAssertEqual(CANUSB_ERROR_OVERRUN, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+    }
+    XCTAssertEqual(QUEUE_SIZE, CANQUE_QueueHigh(context.msgQueue));
+    XCTAssertEqual(10U, CANQUE_OverflowCounter(context.msgQueue));
+    // @- read the CAN frames
+    for (uint32_t i = 0U; i < QUEUE_SIZE - 1U; i++) {
+        XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+        XCTAssertEqual(0, message.sts);
+        XCTAssertEqual(i, GetUInt32(message.data));
+    }
+    // @- then the marker: 10 CAN frames lost within 9ms
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+    XCTAssertEqual(1, message.sts);
+    XCTAssertEqual(KVASER_GAP_QUEUE_OVERRUN, message.id);
+    XCTAssertEqual(8U, message.dlc);
+    XCTAssertEqual(10U, GetUInt32(&message.data[0]));
+    XCTAssertEqual(9000U, GetUInt32(&message.data[4]));
+    XCTAssertEqual(0, message.timestamp.tv_sec);
+    XCTAssertEqual((long)(QUEUE_SIZE - 1U) * 1000L, message.timestamp.tv_nsec);
+    // @- the queue is empty
+    XCTAssertEqual(CANUSB_ERROR_EMPTY, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+
+    // @post:
+    // @- gap markers off: all elements for the CAN frames
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetGapMarker(context.msgQueue, NULL));
+    for (n = 0U; n < QUEUE_SIZE; n++) {
+        MakeFrame(&message, n);
+        XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+    }
+    XCTAssertEqual(CANUSB_ERROR_OVERRUN, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+}
+
+// @xctest TC2: Overflows at high rate
+//
+// @expected the CAN frames read and the CAN frames counted in the markers add up without gaps
+//
+- (void)testOverflowsAtHighRate {
+    KvaserUSB_CanMessage_t message = {};
+    Producer_t producer = { context.msgQueue, false };
+    uint64_t expected = 0U, frames = 0U, lost = 0U, markers = 0U;
+    pthread_t thread;
+    bool done;
+
+    // @pre:
+    // @- gap markers on
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetGapMarker(context.msgQueue, KvaserUSB_QueueGapMarker));
+
+    // @test:
+    // @- one producer w/o throttling and a slow reader
+    XCTAssertEqual(0, pthread_create(&thread, NULL, ProducerThread, (void*)&producer));
+    for (;;) {
+        done = producer.done;
+        if (CANQUE_Dequeue(context.msgQueue, (void*)&message, done ? 0U : 10U) != CANUSB_SUCCESS) {
+            if (done)
+                break;
+            continue;
+        }
+        if (message.sts) {
+            // @- a marker starts at the next expected CAN frame
+            XCTAssertEqual(KVASER_GAP_QUEUE_OVERRUN, message.id);
+            XCTAssertEqual(expected, ((uint64_t)message.timestamp.tv_sec * 1000000U) + ((uint64_t)message.timestamp.tv_nsec / 1000U));
+            XCTAssertEqual(GetUInt32(&message.data[0]) - 1U, GetUInt32(&message.data[4]));
+            expected += GetUInt32(&message.data[0]);
+            lost += GetUInt32(&message.data[0]);
+            markers++;
+        } else {
+            // @- a CAN frame follows the previous one or the marker
+            XCTAssertEqual(expected, GetUInt32(message.data));
+            expected = GetUInt32(message.data) + 1U;
+            frames++;
+        }
+        usleep(1);
+    }
+    XCTAssertEqual(0, pthread_join(thread, NULL));
+    // @- all CAN frames are accounted for
+    XCTAssertEqual(HIGH_RATE_FRAMES, frames + lost);
+    XCTAssertEqual(CANQUE_OverflowCounter(context.msgQueue), lost);
+    XCTAssertTrue(markers > 0U);
+    NSLog(@"%llu CAN frames read, %llu lost (%llu markers)\n", frames, lost, markers);
+}
+
+// @xctest TC3: Overrun flag of the device
+//
+// @expected a marker with an unknown number of lost CAN frames, only when gap markers are on
+//
+- (void)testDeviceGapMarker {
+    KvaserUSB_CanMessage_t message = {};
+    KvaserUSB_Timestamp_t timestamp = { 1, 500000000 };
+
+    // @test:
+    // @- gap markers off: no marker
+    KvaserUSB_DeviceGapMarker(&context, &timestamp);
+    XCTAssertEqual(CANUSB_ERROR_EMPTY, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+    // @- gap markers on: a marker at the time of the CAN frame with the overrun flag
+    context.gapMarkers = true;
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetGapMarker(context.msgQueue, KvaserUSB_QueueGapMarker));
+    KvaserUSB_DeviceGapMarker(&context, &timestamp);
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+    XCTAssertEqual(1, message.sts);
+    XCTAssertEqual(KVASER_GAP_DEVICE_OVERRUN, message.id);
+    XCTAssertEqual(0U, GetUInt32(&message.data[0]));
+    XCTAssertEqual(0U, GetUInt32(&message.data[4]));
+    XCTAssertEqual(1, message.timestamp.tv_sec);
+    XCTAssertEqual(500000000, message.timestamp.tv_nsec);
+}
+
+// @xctest TC4: Overrun flag of the device with a full reception queue
+//
+// @expected the marker is not counted as a lost CAN frame, the number of lost CAN frames is unknown (0)
+//
+- (void)testDeviceGapMarkerWithFullQueue {
+    KvaserUSB_CanMessage_t message = {};
+    KvaserUSB_Timestamp_t timestamp = { 1, 500000000 };
+    uint32_t i;
+
+    // @pre:
+    context.gapMarkers = true;
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetGapMarker(context.msgQueue, KvaserUSB_QueueGapMarker));
+    // @test:
+    // @- fill the queue and lose 2 CAN frames: a marker of the queue with 2 lost CAN frames
+    for (i = 0U; i < (QUEUE_SIZE + 1U); i++) {
+        MakeFrame(&message, 1000U + i);
+        (void)CANQUE_Enqueue(context.msgQueue, (void*)&message);
+    }
+    XCTAssertEqual(2U, CANQUE_OverflowCounter(context.msgQueue));
+    // @- overrun flag of the device: the open marker takes it, but it is not counted
+    KvaserUSB_DeviceGapMarker(&context, &timestamp);
+    XCTAssertEqual(2U, CANQUE_OverflowCounter(context.msgQueue));
+    // @- lose another CAN frame: counted, the number in the marker stays unknown
+    MakeFrame(&message, 2000000U);
+    XCTAssertEqual(CANUSB_ERROR_OVERRUN, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+    XCTAssertEqual(3U, CANQUE_OverflowCounter(context.msgQueue));
+    // @- read the CAN frames and the marker
+    for (i = 0U; i < (QUEUE_SIZE - 1U); i++) {
+        XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+        XCTAssertEqual(0, message.sts);
+        XCTAssertEqual(1000U + i, GetUInt32(&message.data[0]));
+    }
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+    XCTAssertEqual(1, message.sts);
+    XCTAssertEqual(KVASER_GAP_QUEUE_OVERRUN, message.id);
+    XCTAssertEqual(0U, GetUInt32(&message.data[0]));  // unknown
+    XCTAssertEqual(2000000U - (1000U + QUEUE_SIZE - 1U), GetUInt32(&message.data[4]));
+    XCTAssertEqual(CANUSB_ERROR_EMPTY, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+    // @- fill the queue again w/o losing a CAN frame
+    for (i = 0U; i < (QUEUE_SIZE - 1U); i++) {
+        MakeFrame(&message, 3000000U + i);
+        XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+    }
+    // @- overrun flag of the device: the marker of the device takes the entry kept for the marker
+    timestamp.tv_sec = 4;
+    timestamp.tv_nsec = 0;
+    KvaserUSB_DeviceGapMarker(&context, &timestamp);
+    XCTAssertEqual(3U, CANQUE_OverflowCounter(context.msgQueue));
+    // @- lose another CAN frame: counted, the marker of the device is extended
+    MakeFrame(&message, 5000000U);
+    XCTAssertEqual(CANUSB_ERROR_OVERRUN, CANQUE_Enqueue(context.msgQueue, (void*)&message));
+    XCTAssertEqual(4U, CANQUE_OverflowCounter(context.msgQueue));
+    // @- read the CAN frames and the marker
+    for (i = 0U; i < (QUEUE_SIZE - 1U); i++) {
+        XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+        XCTAssertEqual(3000000U + i, GetUInt32(&message.data[0]));
+    }
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+    XCTAssertEqual(1, message.sts);
+    XCTAssertEqual(KVASER_GAP_DEVICE_OVERRUN, message.id);
+    XCTAssertEqual(0U, GetUInt32(&message.data[0]));  // unknown
+    XCTAssertEqual(1000000U, GetUInt32(&message.data[4]));
+    XCTAssertEqual(4, message.timestamp.tv_sec);
+    XCTAssertEqual(CANUSB_ERROR_EMPTY, CANQUE_Dequeue(context.msgQueue, (void*)&message, 0U));
+}
+
+@end
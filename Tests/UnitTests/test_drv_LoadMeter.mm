@@ -0,0 +1,182 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Leaf Interfaces
+ *
+ *  Copyright (c) 2020-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#import "Settings.h"
+#import "KvaserCAN_Driver.h"
+#import "KvaserUSB_LoadMeter.h"
+#import <XCTest/XCTest.h>
+
+#define NANOSECONDS(ms)  ((uint64_t)(ms) * 1000000ULL)
+
+typedef struct {                        // known CAN frame:
+    uint32_t id;                        // - identifier
+    uint8_t flags;                      // - XTD, RTR, FDF and BRS
+    uint8_t dlc;                        // - data length code
+    uint8_t data;                       // - data byte (all bytes)
+    uint32_t nominalBits;               // - bits with nominal bit-rate (SOF to IFS)
+    uint32_t dataBits;                  // - bits with data phase bit-rate
+} KnownFrame_t;
+
+#define XTD  0x01U
+#define RTR  0x02U
+#define FDF  0x04U
+#define BRS  0x08U
+
+static const KnownFrame_t knownFrames[] = {
+    { 0x000U,     0U,        0U,  0x00U,  53U,   0U },  // 19+15 zeros: 6 stuff bits
+    { 0x7FFU,     0U,        8U,  0xFFU, 126U,   0U },
+    { 0x555U,     0U,        8U,  0x55U, 112U,   0U },
+    { 0x123U,     RTR,       8U,  0x00U,  48U,   0U },
+    { 0x1FFFFFFFU, XTD,      8U,  0xFFU, 149U,   0U },
+    { 0x00000000U, XTD,      0U,  0x00U,  74U,   0U },
+    { 0x123U,     FDF,       0U,  0x00U,  63U,   0U },
+    { 0x123U,     FDF|BRS,  15U,  0xAAU,  30U, 550U },
+};
+
+@interface test_drv_LoadMeter : XCTestCase
+
+@end
+
+@implementation test_drv_LoadMeter
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+}
+
+// @xctest TC1: On-wire length of known CAN frames (incl. stuff bits)
+//
+// @expected bit count as calculated from the bit stream
+//
+- (void)testFrameBitsOfKnownFrames {
+    KvaserUSB_CanMessage_t message = {};
+    uint32_t nominalBits = 0U;
+    uint32_t dataBits = 0U;
+
+    // @test: loop over all known frames
+    for (size_t i = 0; i < sizeof(knownFrames) / sizeof(KnownFrame_t); i++) {
+        memset(&message, 0, sizeof(KvaserUSB_CanMessage_t));
+        message.id = knownFrames[i].id;
+        message.xtd = (knownFrames[i].flags & XTD) ? 1 : 0;
+        message.rtr = (knownFrames[i].flags & RTR) ? 1 : 0;
+        message.fdf = (knownFrames[i].flags & FDF) ? 1 : 0;
+        message.brs = (knownFrames[i].flags & BRS) ? 1 : 0;
+        message.dlc = knownFrames[i].dlc;
+        memset(message.data, knownFrames[i].data, CANFD_MAX_LEN);
+        NSLog(@"Execute sub-testcase %zu:\n", i+1);
+
+        // @-- compute bits and compare with the known length
+        LoadMeter_FrameBits(&message, &nominalBits, &dataBits);
+        XCTAssertEqual(knownFrames[i].nominalBits, nominalBits);
+        XCTAssertEqual(knownFrames[i].dataBits, dataBits);
+    }
+}
+
+// @xctest TC2: Worst-case stuffing of CAN 2.0 frames
+//
+// @expected at most 135 bits (11-bit id.) resp. 160 bits (29-bit id.) for 8 data bytes
+//
+- (void)testFrameBitsUpperBound {
+    KvaserUSB_CanMessage_t message = {};
+    uint32_t nominalBits = 0U;
+    uint32_t dataBits = 0U;
+
+    // @test: all 11-bit identifiers with some data patterns
+    for (uint32_t id = 0x000U; id <= 0x7FFU; id++) {
+        for (int pattern = 0; pattern < 4; pattern++) {
+            memset(&message, 0, sizeof(KvaserUSB_CanMessage_t));
+            message.id = id;
+            message.dlc = 8U;
+            memset(message.data, (pattern == 0) ? 0x00 : (pattern == 1) ? 0xFF : (pattern == 2) ? 0x0F : 0xF0, CAN_MAX_LEN);
+            LoadMeter_FrameBits(&message, &nominalBits, &dataBits);
+            XCTAssertLessThanOrEqual(nominalBits, 135U);
+            XCTAssertGreaterThanOrEqual(nominalBits, 111U);
+            // @-- and the same as 29-bit identifier
+            message.xtd = 1;
+            message.id = (id << 18) | id;
+            LoadMeter_FrameBits(&message, &nominalBits, &dataBits);
+            XCTAssertLessThanOrEqual(nominalBits, 160U);
+            XCTAssertGreaterThanOrEqual(nominalBits, 131U);
+        }
+    }
+}
+
+// @xctest TC3: Bus load over the sliding window
+//
+// @expected 25.20% for one frame of 126 bits per millisecond at 500kbps, 0% when the window is empty
+//
+- (void)testBusLoadOverSlidingWindow {
+    KvaserUSB_LoadMeter_t meter = {};
+    KvaserUSB_BusParamsFd_t params = {};
+    KvaserUSB_CanMessage_t message = {};
+    uint64_t start = NANOSECONDS(5000U);
+
+    // @pre:
+    // @- configure the meter for 500kbps and restart it
+    params.nominal.bitRate = 500000U;
+    LoadMeter_Configure(&meter, &params);
+    LoadMeter_Restart(&meter, start);
+    // @- a CAN frame of 126 bits (2us per bit)
+    message.id = 0x7FFU;
+    message.dlc = 8U;
+    memset(message.data, 0xFF, CAN_MAX_LEN);
+
+    // @test:
+    // @- one CAN frame per millisecond for 2 seconds
+    for (uint64_t ms = 0U; ms < 2000U; ms++)
+        LoadMeter_Account(&meter, &message, start + NANOSECONDS(ms));
+    XCTAssertEqual(2520U, LoadMeter_BusLoad(&meter, start + NANOSECONDS(2000U)));
+    // @- 0.5 seconds later: 0.4 seconds with traffic in the window (0.9 seconds)
+    XCTAssertEqual(1120U, LoadMeter_BusLoad(&meter, start + NANOSECONDS(2500U)));
+    // @- 2 seconds later: no traffic in the window
+    XCTAssertEqual(0U, LoadMeter_BusLoad(&meter, start + NANOSECONDS(4000U)));
+}
+
+@end
@@ -0,0 +1,164 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  KvaserCAN - macOS User-Space Driver for Kvaser CAN Leaf Interfaces
+ *
+ *  Copyright (c) 2020-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-KvaserCAN.
+ *
+ *  MacCAN-KvaserCAN is dual-licensed under the BSD 2-Clause "Simplified" License
+ *  and under the GNU General Public License v3.0 (or any later version). You can
+ *  choose between one of them if you use MacCAN-KvaserCAN in whole or in part.
+ *
+ *  BSD 2-Clause Simplified License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-KvaserCAN IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-KvaserCAN, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-KvaserCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-KvaserCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-KvaserCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#import "Settings.h"
+#import "KvaserCAN_Driver.h"
+#import <XCTest/XCTest.h>
+#import <pthread.h>
+#import <time.h>
+
+#define QUEUE_SIZE  16U
+#define SPIN_TIME  500000U  // [us]
+#define SIGNAL_DELAY  20000U  // [us]
+#define MAX_DELAY  200U  // [ms]
+
+typedef struct {
+    CANQUE_MsgQueue_t queue;
+    bool enqueue;
+} Waker_t;
+
+static void *WakerThread(void *arg) {
+    Waker_t *waker = (Waker_t*)arg;
+    KvaserUSB_CanMessage_t message = {};
+
+    // the reader is spinning by now (the spin time is much longer)
+    usleep(SIGNAL_DELAY);
+    if (waker->enqueue)
+        (void)CANQUE_Enqueue(waker->queue, (void*)&message);
+    else
+        (void)CANQUE_Signal(waker->queue);
+    return NULL;
+}
+
+static uint64_t Milliseconds(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000U) + ((uint64_t)now.tv_nsec / 1000000U);
+}
+
+@interface test_drv_WaitMode : XCTestCase {
+    CANQUE_MsgQueue_t queue;
+}
+@end
+
+@implementation test_drv_WaitMode
+
+- (void)setUp {
+    // Put setup code here. This method is called before the invocation of each test method in the class.
+    queue = CANQUE_Create(QUEUE_SIZE, sizeof(KvaserUSB_CanMessage_t));
+    XCTAssertTrue(queue != NULL);
+}
+
+- (void)tearDown {
+    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    (void)CANQUE_Destroy(queue);
+}
+
+// @xctest TC1: Signal a reader spinning in spin-then-block mode (timed read)
+//
+// @expected the reader returns empty right after the signal, not after the timeout
+//
+- (void)testSignalDuringSpinWithTimeout {
+    KvaserUSB_CanMessage_t message = {};
+    Waker_t waker = { queue, false };
+    pthread_t thread;
+    uint64_t start;
+
+    // @pre:
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetWaitMode(queue, CANQUE_WAIT_SPIN, SPIN_TIME));
+    // @test:
+    // @- signal the queue while the reader is spinning
+    XCTAssertEqual(0, pthread_create(&thread, NULL, WakerThread, (void*)&waker));
+    start = Milliseconds();
+    XCTAssertEqual(CANUSB_ERROR_EMPTY, CANQUE_Dequeue(queue, (void*)&message, 1000U));
+    XCTAssertLessThan(Milliseconds() - start, MAX_DELAY);
+    XCTAssertEqual(0, pthread_join(thread, NULL));
+}
+
+// @xctest TC2: Signal a reader spinning in spin-then-block mode (blocking read)
+//
+// @expected the reader returns empty right after the signal, it does not block forever
+//
+- (void)testSignalDuringSpinWithoutTimeout {
+    KvaserUSB_CanMessage_t message = {};
+    Waker_t waker = { queue, false };
+    pthread_t thread;
+    uint64_t start;
+
+    // @pre:
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetWaitMode(queue, CANQUE_WAIT_SPIN, SPIN_TIME));
+    // @test:
+    // @- signal the queue while the reader is spinning
+    XCTAssertEqual(0, pthread_create(&thread, NULL, WakerThread, (void*)&waker));
+    start = Milliseconds();
+    XCTAssertEqual(CANUSB_ERROR_EMPTY, CANQUE_Dequeue(queue, (void*)&message, CANUSB_INFINITE));
+    XCTAssertLessThan(Milliseconds() - start, MAX_DELAY);
+    XCTAssertEqual(0, pthread_join(thread, NULL));
+}
+
+// @xctest TC3: Enqueue an element while the reader is spinning in spin-then-block mode
+//
+// @expected the reader takes the element right after it was enqueued
+//
+- (void)testEnqueueDuringSpin {
+    KvaserUSB_CanMessage_t message = {};
+    Waker_t waker = { queue, true };
+    pthread_t thread;
+    uint64_t start;
+
+    // @pre:
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_SetWaitMode(queue, CANQUE_WAIT_SPIN, SPIN_TIME));
+    // @test:
+    // @- enqueue an element while the reader is spinning
+    XCTAssertEqual(0, pthread_create(&thread, NULL, WakerThread, (void*)&waker));
+    start = Milliseconds();
+    XCTAssertEqual(CANUSB_SUCCESS, CANQUE_Dequeue(queue, (void*)&message, 1000U));
+    XCTAssertLessThan(Milliseconds() - start, MAX_DELAY);
+    XCTAssertEqual(0, pthread_join(thread, NULL));
+}
+
+@end
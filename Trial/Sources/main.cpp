@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 #include "MacCAN_Debug.h"
+#include "MacCAN_Trace.h"
 
 //#define SECOND_CHANNEL
 #define ISSUE_198   (0)
@@ -143,7 +144,7 @@ int main(int argc, const char * argv[]) {
     int option_reply = OPTION_NO;
     int option_transmit = OPTION_NO;
 //    int option_device_id = OPTION_NO;
-//    int option_trace = OPTION_NO;
+    int option_trace = OPTION_NO;
     int option_log = OPTION_NO;
     int option_xor = OPTION_NO;
     uint64_t received = 0ULL;
@@ -218,7 +219,7 @@ int main(int argc, const char * argv[]) {
 //        if (!strcmp(argv[i], "ABS") || !strcmp(argv[i], "ABSOLUTE")) option_time = OPTION_TIME_ABS;
 //        if (!strcmp(argv[i], "REL") || !strcmp(argv[i], "RELATIVE")) option_time = OPTION_TIME_REL;
         /* logging and debugging */
-//        if (!strcmp(argv[i], "TRACE")) option_trace = OPTION_YES;
+        if (!strcmp(argv[i], "TRACE")) option_trace = OPTION_YES;
         if (!strcmp(argv[i], "LOG")) option_log = OPTION_YES;
         /* query some informations: hw, sw, etc. */
         if (!strcmp(argv[i], "INFO")) option_info = OPTION_YES;
@@ -246,6 +247,8 @@ int main(int argc, const char * argv[]) {
     }
     if (option_log)
         MACCAN_LOG_OPEN();
+    if (option_trace)
+        MACCAN_TRACE_OPEN();
     MACCAN_LOG_PRINTF("# MacCAN-KvaserCAN - %s", ctime(&now));
     /* information from library */
     if (option_info) {
@@ -662,6 +665,8 @@ teardown:
 end:
     now = time(NULL);
     MACCAN_LOG_PRINTF("# MacCAN-KvaserCAN - %s", ctime(&now));
+    if (option_trace)
+        MACCAN_TRACE_CLOSE();
     if (option_log)
         MACCAN_LOG_CLOSE();
     fprintf(stdout, "Cheers!\n");
@@ -53,13 +53,20 @@
 
 //  Methods to format a CAN message
 //
-bool CCanMessage::Format(TCanMessage message, uint64_t counter, char *string, size_t length) {
-    char *szMessage = msg_format_message(&message, MSG_RX_MESSAGE, counter, 0);
-    if (szMessage) {
-        strncpy(string, szMessage, length);
-        return true;
-    } else
-        return false;
+//  note: the reference time of relative time-stamps is kept by the caller
+//        (without a reference the time-stamp is absolute)
+//
+bool CCanMessage::Format(TCanMessage message, uint64_t counter, char *string, size_t length, TTimestamp *reference) {
+    return (msg_format_message_r(string, length, &message, MSG_RX_MESSAGE, counter, 0, reference) >= 0) ? true : false;
+}
+
+int CCanMessage::FormatLine(const TCanMessage &message, uint64_t counter, char *string, size_t length, TTimestamp *reference) {
+    int n = msg_format_message_r(string, length, &message, MSG_RX_MESSAGE, counter, 0, reference);
+    if ((n < 0) || ((size_t)n + 2U > length))
+        return -1;
+    string[n++] = '\n';
+    string[n] = '\0';
+    return n;
 }
 
 bool CCanMessage::SetTimestampFormat(EFormatTimestamp option) {
@@ -78,12 +78,14 @@ public:
         OptionWraparound64 = CANPARA_WRAPAROUND_64
     };
     typedef can_message_t TCanMessage;
+    typedef can_timestamp_t TTimestamp;
     static bool SetTimestampFormat(EFormatTimestamp option);
     static bool SetIdentifierFormat(EFormatNumber option);
     static bool SetDataFormat(EFormatNumber option);
     static bool SetAsciiFormat(EFormatOption option);
     static bool SetWraparound(EFormatWraparound option);
-    static bool Format(TCanMessage message, uint64_t counter, char *string, size_t length);
+    static bool Format(TCanMessage message, uint64_t counter, char *string, size_t length, TTimestamp *reference = NULL);
+    static int FormatLine(const TCanMessage &message, uint64_t counter, char *string, size_t length, TTimestamp *reference = NULL);  // incl. '\n'
 };
 /// \}
 
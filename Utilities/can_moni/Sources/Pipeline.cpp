@@ -0,0 +1,302 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  CAN Monitor for generic Interfaces (CAN API V3)
+//
+//  Copyright (c) 2007,2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "Pipeline.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+#define WAIT_TIMEOUT  10000000L  // 10ms (in [ns])
+
+template <typename T, size_t N>
+void CPipeline::Wait(SEvent &event, CQueue<T, N> &queue) {
+    struct timespec timeout;
+    struct timeval now;
+
+    (void)gettimeofday(&now, NULL);
+    timeout.tv_sec = now.tv_sec;
+    timeout.tv_nsec = ((long)now.tv_usec * 1000L) + WAIT_TIMEOUT;
+    if (timeout.tv_nsec >= 1000000000L) {
+        timeout.tv_sec += 1;
+        timeout.tv_nsec -= 1000000000L;
+    }
+    // note: the producer signals only when the consumer is waiting, and
+    //       the queue is checked again after the waiting flag has been set
+    //       (the producer reads the flag after the slot has been committed).
+    (void)pthread_mutex_lock(&event.mutex);
+    __atomic_store_n(&event.waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (queue.IsEmpty())
+        (void)pthread_cond_timedwait(&event.cond, &event.mutex, &timeout);
+    __atomic_store_n(&event.waiting, 0, __ATOMIC_RELAXED);
+    (void)pthread_mutex_unlock(&event.mutex);
+}
+
+void CPipeline::Signal(SEvent &event) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&event.waiting, __ATOMIC_RELAXED)) {
+        (void)pthread_mutex_lock(&event.mutex);
+        (void)pthread_cond_signal(&event.cond);
+        (void)pthread_mutex_unlock(&event.mutex);
+    }
+}
+
+CPipeline::CPipeline(int fd) : m_fd(fd), m_pRecorder(NULL), m_pExporter(NULL) {
+    Initialize();
+}
+
+CPipeline::CPipeline(rec_recorder_t recorder) : m_fd(-1), m_pRecorder(recorder), m_pExporter(NULL) {
+    Initialize();
+}
+
+CPipeline::CPipeline(exp_exporter_t exporter) : m_fd(-1), m_pRecorder(NULL), m_pExporter(exporter) {
+    Initialize();
+}
+
+CPipeline::~CPipeline() {
+    (void)Stop();
+    (void)pthread_cond_destroy(&m_BatchEvent.cond);
+    (void)pthread_mutex_destroy(&m_BatchEvent.mutex);
+    (void)pthread_cond_destroy(&m_ChunkEvent.cond);
+    (void)pthread_mutex_destroy(&m_ChunkEvent.mutex);
+}
+
+bool CPipeline::Start() {
+    if (m_fRunning)
+        return false;
+    __atomic_store_n(&m_nStop, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&m_nFormatterDone, 0, __ATOMIC_RELEASE);
+    if (pthread_create(&m_Writer, NULL, WriterThread, (void*)this) != 0)
+        return false;
+    if (pthread_create(&m_Formatter, NULL, FormatterThread, (void*)this) != 0) {
+        __atomic_store_n(&m_nFormatterDone, 1, __ATOMIC_RELEASE);
+        Signal(m_ChunkEvent);
+        (void)pthread_join(m_Writer, NULL);
+        return false;
+    }
+    m_fRunning = true;
+    return true;
+}
+
+uint64_t CPipeline::Stop() {
+    if (m_fRunning) {
+        // note: the formatter drains the batch queue before it exits,
+        //       and the writer drains the chunk queue thereafter.
+        __atomic_store_n(&m_nStop, 1, __ATOMIC_RELEASE);
+        Signal(m_BatchEvent);
+        (void)pthread_join(m_Formatter, NULL);
+        (void)pthread_join(m_Writer, NULL);
+        m_fRunning = false;
+    }
+    return __atomic_load_n(&m_Counters.u64ReaderFrames, __ATOMIC_RELAXED);
+}
+
+bool CPipeline::Push(const TCanMessage *messages, size_t count) {
+    bool result = true;
+
+    while (count > 0U) {
+        size_t n = (count < BatchSize) ? count : BatchSize;
+        SBatch *batch = m_Batches.Reserve();
+        if (batch) {
+            memcpy(batch->message, messages, n * sizeof(TCanMessage));
+            batch->nCount = n;
+            batch->u64Skipped = m_u64Skipped;
+            m_u64Skipped = 0U;
+            m_Batches.Commit();
+            Signal(m_BatchEvent);
+        } else {
+            // the formatter is lagging behind: drop the batch
+            __atomic_add_fetch(&m_Counters.u64ReaderDrops, (uint64_t)n, __ATOMIC_RELAXED);
+            m_u64Skipped += (uint64_t)n;
+            result = false;
+        }
+        __atomic_add_fetch(&m_Counters.u64ReaderFrames, (uint64_t)n, __ATOMIC_RELAXED);
+        messages += n;
+        count -= n;
+    }
+    return result;
+}
+
+CPipeline::SCounters CPipeline::GetCounters() {
+    SCounters counters;
+    counters.u64ReaderFrames = __atomic_load_n(&m_Counters.u64ReaderFrames, __ATOMIC_RELAXED);
+    counters.u64ReaderDrops = __atomic_load_n(&m_Counters.u64ReaderDrops, __ATOMIC_RELAXED);
+    counters.u64FormatterLines = __atomic_load_n(&m_Counters.u64FormatterLines, __ATOMIC_RELAXED);
+    counters.u64FormatterDrops = __atomic_load_n(&m_Counters.u64FormatterDrops, __ATOMIC_RELAXED);
+    counters.u64WriterBytes = __atomic_load_n(&m_Counters.u64WriterBytes, __ATOMIC_RELAXED);
+    counters.u64WriterDrops = __atomic_load_n(&m_Counters.u64WriterDrops, __ATOMIC_RELAXED);
+    return counters;
+}
+
+void *CPipeline::FormatterThread(void *arg) {
+    CPipeline *self = (CPipeline*)arg;
+    if (self->m_pRecorder || self->m_pExporter)
+        self->Recorder();
+    else
+        self->Formatter();
+    __atomic_store_n(&self->m_nFormatterDone, 1, __ATOMIC_RELEASE);
+    Signal(self->m_ChunkEvent);
+    return NULL;
+}
+
+void *CPipeline::WriterThread(void *arg) {
+    CPipeline *self = (CPipeline*)arg;
+    self->Writer();
+    return NULL;
+}
+
+void CPipeline::Initialize() {
+    m_nStop = 0;
+    m_nFormatterDone = 0;
+    m_fRunning = false;
+    m_u64Counter = 0U;
+    m_u64Skipped = 0U;
+    memset(&m_Reference, 0, sizeof(m_Reference));
+    memset(&m_Counters, 0, sizeof(SCounters));
+    (void)pthread_mutex_init(&m_BatchEvent.mutex, NULL);
+    (void)pthread_cond_init(&m_BatchEvent.cond, NULL);
+    m_BatchEvent.waiting = 0;
+    (void)pthread_mutex_init(&m_ChunkEvent.mutex, NULL);
+    (void)pthread_cond_init(&m_ChunkEvent.cond, NULL);
+    m_ChunkEvent.waiting = 0;
+}
+
+void CPipeline::Formatter() {
+    SChunk *chunk = NULL;
+    SBatch *batch;
+
+    for (;;) {
+        if ((batch = m_Batches.Peek()) != NULL) {
+            // note: the batches dropped by the reader are skipped in the numbering, too.
+            m_u64Counter += batch->u64Skipped;
+            for (size_t i = 0U; i < batch->nCount; i++) {
+                // note: the counter is incremented even when the line is dropped,
+                //       so that a gap in the numbering shows the lost messages.
+                uint64_t counter = ++m_u64Counter;
+                if (!chunk && ((chunk = m_Chunks.Reserve()) != NULL))
+                    chunk->nLength = 0U;
+                if (chunk) {
+                    int n = CCanMessage::FormatLine(batch->message[i], counter,
+                                                    &chunk->szText[chunk->nLength], ChunkSize - chunk->nLength, &m_Reference);
+                    if (n > 0)
+                        chunk->nLength += (size_t)n;
+                    __atomic_add_fetch(&m_Counters.u64FormatterLines, 1U, __ATOMIC_RELAXED);
+                    // hand the chunk over when the next line might not fit
+                    if ((ChunkSize - chunk->nLength) <= (CANPROP_MAX_STRING_LENGTH + 1U)) {
+                        m_Chunks.Commit();
+                        Signal(m_ChunkEvent);
+                        chunk = NULL;
+                    }
+                } else {
+                    // the writer is lagging behind: drop the line
+                    __atomic_add_fetch(&m_Counters.u64FormatterDrops, 1U, __ATOMIC_RELAXED);
+                }
+            }
+            m_Batches.Release();
+        } else {
+            // no more messages for now: hand over what we have
+            if (chunk) {
+                if (chunk->nLength > 0U) {
+                    m_Chunks.Commit();
+                    Signal(m_ChunkEvent);
+                }
+                chunk = NULL;
+            }
+            if (__atomic_load_n(&m_nStop, __ATOMIC_ACQUIRE) && m_Batches.IsEmpty())
+                break;
+            Wait(m_BatchEvent, m_Batches);
+        }
+    }
+}
+
+void CPipeline::Recorder() {
+    SBatch *batch;
+    int rc;
+
+    for (;;) {
+        if ((batch = m_Batches.Peek()) != NULL) {
+            // note: the recorder resp. the exporter collects the records in a
+            //       large buffer and writes it to the file when it is full.
+            if (m_pRecorder)
+                rc = rec_recorder_write(m_pRecorder, batch->message, batch->nCount);
+            else
+                rc = exp_exporter_write(m_pExporter, batch->message, batch->nCount);
+            if (rc == 0)
+                __atomic_add_fetch(&m_Counters.u64FormatterLines, (uint64_t)batch->nCount, __ATOMIC_RELAXED);
+            else
+                __atomic_add_fetch(&m_Counters.u64FormatterDrops, (uint64_t)batch->nCount, __ATOMIC_RELAXED);
+            m_Batches.Release();
+        } else {
+            if (__atomic_load_n(&m_nStop, __ATOMIC_ACQUIRE) && m_Batches.IsEmpty())
+                break;
+            Wait(m_BatchEvent, m_Batches);
+        }
+    }
+    if (m_pRecorder)
+        (void)rec_recorder_flush(m_pRecorder);
+    else
+        (void)exp_exporter_flush(m_pExporter);
+}
+
+void CPipeline::Writer() {
+    struct iovec iov[IovecMax];
+    size_t n, i;
+
+    for (;;) {
+        // gather as many chunks as possible into one writev()
+        SChunk *chunk;
+        for (n = 0U; (n < IovecMax) && ((chunk = m_Chunks.Peek(n)) != NULL); n++) {
+            iov[n].iov_base = (void*)chunk->szText;
+            iov[n].iov_len = chunk->nLength;
+        }
+        if (n > 0U) {
+            for (i = 0U; i < n; ) {
+                ssize_t written = writev(m_fd, &iov[i], (int)(n - i));
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    // write error: drop the remaining characters
+                    for (; i < n; i++)
+                        __atomic_add_fetch(&m_Counters.u64WriterDrops, (uint64_t)iov[i].iov_len, __ATOMIC_RELAXED);
+                    break;
+                }
+                __atomic_add_fetch(&m_Counters.u64WriterBytes, (uint64_t)written, __ATOMIC_RELAXED);
+                // partial write: skip what has been written
+                while ((i < n) && ((size_t)written >= iov[i].iov_len)) {
+                    written -= (ssize_t)iov[i].iov_len;
+                    i++;
+                }
+                if (i < n) {
+                    iov[i].iov_base = (void*)((char*)iov[i].iov_base + written);
+                    iov[i].iov_len -= (size_t)written;
+                }
+            }
+            m_Chunks.Release(n);
+        } else {
+            if (__atomic_load_n(&m_nFormatterDone, __ATOMIC_ACQUIRE) && m_Chunks.IsEmpty())
+                break;
+            Wait(m_ChunkEvent, m_Chunks);
+        }
+    }
+}
+
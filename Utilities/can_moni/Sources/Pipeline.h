@@ -0,0 +1,157 @@
+//  SPDX-License-Identifier: GPL-3.0-or-later
+//
+//  CAN Monitor for generic Interfaces (CAN API V3)
+//
+//  Copyright (c) 2007,2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef PIPELINE_H_INCLUDED
+#define PIPELINE_H_INCLUDED
+
+#include "Message.h"
+#include "can_rec.h"
+#include "can_exp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/// \name   Reception Pipeline
+/// \brief  Reader, formatter and writer stage of the CAN monitor.
+/// \note   The reader stage is the caller of Push (i.e. the reception loop).
+///         It hands batches of CAN messages over to the formatter thread,
+///         which formats them line by line into large text chunks.  The
+///         writer thread emits the chunks with writev() to a file descriptor.
+///         The stages are connected by bounded lock-free queues (single
+///         producer, single consumer).  A stage never waits for the next one:
+///         when a queue is full, the batch resp. the line is dropped and
+///         counted, so that a slow terminal or file cannot stall the reader.
+///         Dropped CAN messages leave a gap in the message numbering.
+///         With a recorder resp. an exporter, the formatter stage writes the
+///         CAN messages to a binary capture file resp. to a log file (candump,
+///         ASC or BLF) instead (the writer stage is then idle).
+/// \{
+class CPipeline {
+public:
+    static const size_t BatchSize = 64U;  // CAN messages per batch
+    static const size_t BatchQueueSize = 256U;  // batches (power of 2)
+    static const size_t ChunkSize = 65536U;  // characters per chunk
+    static const size_t ChunkQueueSize = 64U;  // chunks (power of 2)
+    static const size_t IovecMax = 16U;  // chunks per writev()
+
+    typedef CCanMessage::TCanMessage TCanMessage;
+
+    struct SCounters {
+        uint64_t u64ReaderFrames;  // CAN messages pushed by the reader
+        uint64_t u64ReaderDrops;  // CAN messages dropped (batch queue full)
+        uint64_t u64FormatterLines;  // CAN messages formatted (or recorded/exported)
+        uint64_t u64FormatterDrops;  // CAN messages dropped (chunk queue full or record/export error)
+        uint64_t u64WriterBytes;  // characters written
+        uint64_t u64WriterDrops;  // characters dropped (write error)
+    };
+private:
+    struct SBatch {
+        size_t nCount;
+        uint64_t u64Skipped;  // CAN messages dropped by the reader before this batch
+        TCanMessage message[BatchSize];
+    };
+    struct SChunk {
+        size_t nLength;
+        char szText[ChunkSize];
+    };
+    // bounded lock-free queue (single producer, single consumer)
+    template <typename T, size_t N>
+    class CQueue {
+    private:
+        T *m_pSlots;
+        uint64_t m_u64Head __attribute__((aligned(64)));  // written by the producer
+        uint64_t m_u64Tail __attribute__((aligned(64)));  // written by the consumer
+    public:
+        CQueue() : m_pSlots(new T[N]), m_u64Head(0U), m_u64Tail(0U) {}
+        ~CQueue() { delete[] m_pSlots; }
+        // producer: next free slot or NULL (queue full)
+        T *Reserve() {
+            uint64_t head = __atomic_load_n(&m_u64Head, __ATOMIC_RELAXED);
+            if ((head - __atomic_load_n(&m_u64Tail, __ATOMIC_ACQUIRE)) >= N)
+                return NULL;
+            return &m_pSlots[head & (N - 1U)];
+        }
+        // producer: hand the reserved slot over to the consumer
+        void Commit() {
+            __atomic_store_n(&m_u64Head, m_u64Head + 1U, __ATOMIC_RELEASE);
+        }
+        // consumer: n-th used slot or NULL (less than n+1 slots used)
+        T *Peek(size_t n = 0U) {
+            uint64_t tail = __atomic_load_n(&m_u64Tail, __ATOMIC_RELAXED);
+            if ((__atomic_load_n(&m_u64Head, __ATOMIC_ACQUIRE) - tail) <= (uint64_t)n)
+                return NULL;
+            return &m_pSlots[(tail + n) & (N - 1U)];
+        }
+        // consumer: give n used slots back to the producer
+        void Release(size_t n = 1U) {
+            __atomic_store_n(&m_u64Tail, m_u64Tail + n, __ATOMIC_RELEASE);
+        }
+        bool IsEmpty() {
+            return __atomic_load_n(&m_u64Head, __ATOMIC_ACQUIRE) == __atomic_load_n(&m_u64Tail, __ATOMIC_ACQUIRE);
+        }
+    };
+    // wake-up of a waiting consumer (the producer only signals when needed)
+    struct SEvent {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        int waiting;
+    };
+    CQueue<SBatch, BatchQueueSize> m_Batches;
+    CQueue<SChunk, ChunkQueueSize> m_Chunks;
+    SEvent m_BatchEvent;
+    SEvent m_ChunkEvent;
+    pthread_t m_Formatter;
+    pthread_t m_Writer;
+    int m_nStop;  // the reader has stopped (drain and exit)
+    int m_nFormatterDone;  // the formatter has exited
+    bool m_fRunning;
+    int m_fd;
+    rec_recorder_t m_pRecorder;
+    exp_exporter_t m_pExporter;
+    uint64_t m_u64Counter;  // message counter (formatter)
+    uint64_t m_u64Skipped;  // CAN messages dropped since the last batch (reader)
+    CCanMessage::TTimestamp m_Reference;  // time-stamp reference (formatter)
+    SCounters m_Counters;
+public:
+    CPipeline(int fd);  // formatted text to a file descriptor
+    CPipeline(rec_recorder_t recorder);  // CAN messages to a capture file
+    CPipeline(exp_exporter_t exporter);  // CAN messages to a log file
+    virtual ~CPipeline();
+
+    bool Start();  // start the formatter and the writer thread
+    uint64_t Stop();  // drain the queues and stop the threads
+
+    bool Push(const TCanMessage *messages, size_t count);  // reader stage
+
+    SCounters GetCounters();
+private:
+    static void *FormatterThread(void *arg);
+    static void *WriterThread(void *arg);
+    void Initialize();
+    void Formatter();
+    void Recorder();
+    void Writer();
+    template <typename T, size_t N>
+    static void Wait(SEvent &event, CQueue<T, N> &queue);
+    static void Signal(SEvent &event);
+};
+/// \}
+
+#endif // PIPELINE_H_INCLUDED
@@ -20,6 +20,7 @@
 #include "Driver.h"
 #include "Timer.h"
 #include "Message.h"
+#include "Pipeline.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -30,6 +31,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <inttypes.h>
 
@@ -45,7 +47,8 @@ static int get_exclusion(const char *arg);
 
 class CCanDevice : public CCanDriver {
 public:
-    uint64_t ReceptionLoop();
+    uint64_t ReceptionLoop(rec_recorder_t recorder = NULL, exp_exporter_t exporter = NULL);
+    void ShowPathCounters(FILE *stream);
 public:
     static int ListCanDevices(void);
     static int TestCanDevices(CANAPI_OpMode_t opMode);
@@ -89,6 +92,13 @@ int main(int argc, const char * argv[]) {
     CCanMessage::EFormatOption modeAscii = CCanMessage::OptionOn; int ma = 0;
     CCanMessage::EFormatWraparound wraparound = CCanMessage::OptionWraparoundNo; int mw = 0;
     int exclude = 0;
+    int stats = 0;
+    char *record_file = NULL;
+    unsigned long record_size = 0UL;
+    rec_recorder_t recorder = NULL;
+    char *export_file = NULL;
+    int export_format = 0;
+    exp_exporter_t exporter = NULL;
 //    char *script_file = NULL;
     int verbose = 0;
     int num_boards = 0;
@@ -112,6 +122,10 @@ int main(int argc, const char * argv[]) {
         {"wrap", required_argument, 0, 'w'},
         {"wraparound", required_argument, 0, 'w'},
         {"exclude", required_argument, 0, 'x'},
+        {"record", required_argument, 0, 'F'},
+        {"segment", required_argument, 0, 'G'},
+        {"export", required_argument, 0, 'H'},
+        {"stats", no_argument, 0, 'P'},
         {"script", required_argument, 0, 's'},
         {"list-boards", no_argument, 0, 'L'},
         {"test-boards", no_argument, 0, 'T'},
@@ -378,6 +392,44 @@ int main(int argc, const char * argv[]) {
                 return 1;
             }
             break;
+        case 'F':  /* option `--record=<file>' */
+            if (record_file) {
+                fprintf(stderr, "%s: duplicated option `--record'\n", basename(argv[0]));
+                return 1;
+            }
+            if (!optarg || !*optarg) {
+                fprintf(stderr, "%s: illegal argument for option `--record'\n", basename(argv[0]));
+                return 1;
+            }
+            record_file = optarg;
+            break;
+        case 'G':  /* option `--segment=<MiB>' */
+            if (record_size) {
+                fprintf(stderr, "%s: duplicated option `--segment'\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf(optarg, "%lu", &record_size) != 1) || (record_size < 1UL) || (record_size > 1048576UL)) {
+                fprintf(stderr, "%s: illegal argument for option `--segment'\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case 'H':  /* option `--export=<file>' */
+            if (export_file) {
+                fprintf(stderr, "%s: duplicated option `--export'\n", basename(argv[0]));
+                return 1;
+            }
+            if (!optarg || ((export_format = exp_format_from_path(optarg)) < 0)) {
+                fprintf(stderr, "%s: illegal argument for option `--export' (.log, .asc or .blf)\n", basename(argv[0]));
+                return 1;
+            }
+            export_file = optarg;
+            break;
+        case 'P':  /* option `--stats' */
+            if (stats++) {
+                fprintf(stderr, "%s: duplicated option `--stats'\n", basename(argv[0]));
+                return 1;
+            }
+            break;
         case 'L':  /* option `--list-boards[=<vendor>]' (-L) */
             fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
             /* list all supported interfaces */
@@ -428,6 +480,16 @@ int main(int argc, const char * argv[]) {
         fprintf(stderr, "%s: illegal argument `%s'\n", basename(argv[0]), argv[optind]);
         return 1;
     }
+    /* - check if a capture file is given for option `--segment' */
+    if (record_size && !record_file) {
+        fprintf(stderr, "%s: option `--segment' requires option `--record'\n", basename(argv[0]));
+        return 1;
+    }
+    /* - check if either a capture file or a log file is given */
+    if (record_file && export_file) {
+        fprintf(stderr, "%s: illegal combination of options `--record' and `--export'\n", basename(argv[0]));
+        return 1;
+    }
     /* - check bit-timing index (n/a for CAN FD) */
     if (opMode.fdoe && (bitrate.btr.frequency <= 0)) {
         fprintf(stderr, "%s: illegal combination of options `--mode' (m) and `--bitrate'\n", basename(argv[0]));
@@ -502,8 +564,66 @@ int main(int argc, const char * argv[]) {
         goto teardown;
     }
     fprintf(stdout, "OK!\n");
+    /* - create the capture file (optional) */
+    if (record_file) {
+        rec_info_t info = {};
+        info.channel = channel.m_nChannelNo;
+        info.mode = opMode.byte;
+        info.bitrate = bitrate;
+        strncpy(info.device, channel.m_szDeviceName, REC_DEVICE_LENGTH - 1U);
+        fprintf(stdout, "Recording=%s...", record_file);
+        fflush(stdout);
+        if ((retVal = rec_recorder_create(&recorder, record_file, &info, (uint64_t)record_size << 20)) != RECERR_NOERROR) {
+            fprintf(stdout, "FAILED!\n");
+            fprintf(stderr, "+++ error: capture file could not be created (%i)\n", retVal);
+            goto teardown;
+        }
+        fprintf(stdout, "OK!\n");
+    }
+    /* - create the log file (optional) */
+    if (export_file) {
+        exp_options_t options = {};
+        options.format = (exp_format_t)export_format;
+        options.time_stamp = (msg_fmt_timestamp_t)modeTime;
+        options.channel = (uint32_t)channel.m_nChannelNo + 1U;
+        snprintf(options.interface, EXP_NAME_LENGTH, "can%i", channel.m_nChannelNo);
+        fprintf(stdout, "Exporting=%s...", export_file);
+        fflush(stdout);
+        if ((retVal = exp_exporter_create(&exporter, export_file, &options)) != EXPERR_NOERROR) {
+            fprintf(stdout, "FAILED!\n");
+            fprintf(stderr, "+++ error: log file could not be created (%i)\n", retVal);
+            goto teardown;
+        }
+        fprintf(stdout, "OK!\n");
+    }
+    /* - reset the hot-path counters (optional) */
+    if (stats) {
+        uint8_t dummy = 0U;
+        if ((retVal = canDevice.SetProperty(CANPROP_SET_VENDOR_PROP + KVASER_PROP_PATH_RESET, (void*)&dummy, sizeof(uint8_t))) != CCanApi::NoError)
+            fprintf(stderr, "+++ warning: hot-path counters could not be reset (%i)\n", retVal);
+    }
     /* - reception loop */
-    canDevice.ReceptionLoop();
+    canDevice.ReceptionLoop(recorder, exporter);
+    /* - show the hot-path counters (optional) */
+    if (stats)
+        canDevice.ShowPathCounters(stdout);
+    /* - close the capture file (optional) */
+    if (recorder) {
+        rec_stats_t stats = {};
+        (void)rec_recorder_stats(recorder, &stats);
+        if ((retVal = rec_recorder_close(recorder)) != RECERR_NOERROR)
+            fprintf(stderr, "+++ error: capture file could not be written (%i)\n", retVal);
+        fprintf(stdout, "Recorded: %" PRIu64 " message(s), %" PRIu64 " byte(s) in %" PRIu32 " file(s)\n",
+                        stats.records, stats.bytes, stats.segments);
+    }
+    /* - close the log file (optional) */
+    if (exporter) {
+        exp_stats_t stats = {};
+        (void)exp_exporter_stats(exporter, &stats);
+        if ((retVal = exp_exporter_close(exporter)) != EXPERR_NOERROR)
+            fprintf(stderr, "+++ error: log file could not be written (%i)\n", retVal);
+        fprintf(stdout, "Exported: %" PRIu64 " message(s) to %s\n", stats.messages, export_file);
+    }
     /* - show interface information */
     if ((device = canDevice.GetHardwareVersion()) != NULL)
         fprintf(stdout, "Hardware: %s\n", device);
@@ -566,27 +686,64 @@ int CCanDevice::TestCanDevices(CANAPI_OpMode_t opMode) {
     return n;
 }
 
-uint64_t CCanDevice::ReceptionLoop() {
-    CANAPI_Message_t message;
+uint64_t CCanDevice::ReceptionLoop(rec_recorder_t recorder, exp_exporter_t exporter) {
+    CANAPI_Message_t message[CPipeline::BatchSize];
     CANAPI_Return_t retVal;
-    uint64_t frames = 0U;
-
-    char string[CANPROP_MAX_STRING_LENGTH+1];
-    memset(string, 0, CANPROP_MAX_STRING_LENGTH+1);
+    size_t count;
 
+    // reader (this thread) -> formatter -> writer (stdout), or
+    // reader (this thread) -> recorder (capture file), or
+    // reader (this thread) -> exporter (log file)
+    CPipeline *pipeline = recorder ? new CPipeline(recorder) :
+                          exporter ? new CPipeline(exporter) : new CPipeline(STDOUT_FILENO);
+    fflush(stdout);
+    if (!pipeline->Start()) {
+        fprintf(stderr, "+++ error: reception pipeline could not be started\n");
+        delete pipeline;
+        return 0U;
+    }
     fprintf(stderr, "\nPress ^C to abort.\n\n");
     while(running) {
-        if ((retVal = ReadMessage(message)) == CCanApi::NoError) {
-            if ((((message.id < MAX_ID) && can_id[message.id]) || ((message.id >= MAX_ID) && can_id_xtd))) {
-                (void)CCanMessage::Format(message, ++frames, string, CANPROP_MAX_STRING_LENGTH);
-                fprintf(stdout, "%s\n", string);
-            }
+        // wait for the first message, then drain the queue in a batch
+        for (count = 0U; count < CPipeline::BatchSize; ) {
+            if ((retVal = ReadMessage(message[count], count ? 0U : CANREAD_INFINITE)) != CCanApi::NoError)
+                break;
+            if ((((message[count].id < MAX_ID) && can_id[message[count].id]) || ((message[count].id >= MAX_ID) && can_id_xtd)))
+                count++;
         }
+        if (count > 0U)
+            (void)pipeline->Push(message, count);
     }
+    uint64_t frames = pipeline->Stop();
+    CPipeline::SCounters counters = pipeline->GetCounters();
+    delete pipeline;
     fprintf(stdout, "\n");
+    if (counters.u64ReaderDrops || counters.u64FormatterDrops || counters.u64WriterDrops)
+        fprintf(stderr, "+++ warning: %" PRIu64 " message(s) dropped by the reader, %" PRIu64 " by the formatter, %" PRIu64 " byte(s) not written\n",
+                counters.u64ReaderDrops, counters.u64FormatterDrops, counters.u64WriterDrops);
     return frames;
 }
 
+void CCanDevice::ShowPathCounters(FILE *stream) {
+    uint64_t counters[KVASER_PATH_COUNTERS] = {};
+
+    // one snapshot, all counters from the same instant
+    CANAPI_Return_t retVal = GetProperty(CANPROP_GET_VENDOR_PROP + KVASER_PROP_PATH_COUNTERS, (void*)counters, sizeof(counters));
+    if (retVal != CCanApi::NoError) {
+        fprintf(stderr, "+++ error: hot-path counters could not be read (%i)\n", retVal);
+        return;
+    }
+    fprintf(stream, "Reception: %" PRIu64 " URB(s), %" PRIu64 " byte(s) decoded, %" PRIu64 " reassembly(ies)\n",
+                    counters[KVASER_PATH_URBS_RECEIVED], counters[KVASER_PATH_BYTES_DECODED], counters[KVASER_PATH_REASSEMBLIES]);
+    fprintf(stream, "Decoding: %" PRIu64 " error(s), %" PRIu64 " unknown command(s)\n",
+                    counters[KVASER_PATH_DECODE_ERRORS], counters[KVASER_PATH_UNKNOWN_CMDS]);
+    fprintf(stream, "Queue: high-water mark %" PRIu64 ", %" PRIu64 " overflow(s), %" PRIu64 " lock wait(s) for %.3fms\n",
+                    counters[KVASER_PATH_QUEUE_HIGH], counters[KVASER_PATH_QUEUE_OVERFLOWS],
+                    counters[KVASER_PATH_LOCK_WAITS], (double)counters[KVASER_PATH_LOCK_WAIT_TIME] / 1000000.0);
+    fprintf(stream, "Transmission: %" PRIu64 " acknowledge(s) outstanding, %" PRIu64 " write failure(s)\n",
+                    counters[KVASER_PATH_TX_PENDING], counters[KVASER_PATH_WRITE_FAILURES]);
+}
+
 static int get_exclusion(const char *arg)
 {
     char *val, *end;
@@ -684,6 +841,10 @@ static void usage(FILE *stream, const char *program)
     fprintf(stream, " -w, --wrap=(NO|8|10|16|32|64) wraparound after n data bytes (default=NO)\n");
 #endif
     fprintf(stream, " -x, --exclude=[~]<id-list>    exclude CAN-IDs: <id>[-<id>]{,<id>[-<id>]}\n");
+    fprintf(stream, "     --record=<file>           record CAN messages to a binary capture file\n");
+    fprintf(stream, "     --segment=<MiB>           start a new capture file after <MiB> megabytes\n");
+    fprintf(stream, "     --export=<file>           export CAN messages to a log file (.log, .asc, .blf)\n");
+    fprintf(stream, "     --stats                   show the driver's hot-path counters at exit\n");
 //    fprintf(stream, " -s, --script=<filename>       execute a script file\n"); // TODO: script engine
 #if (CAN_FD_SUPPORTED != 0)
     fprintf(stream, " -m, --mode=(2.0|FDF[+BRS])    CAN operation mode: CAN 2.0 or CAN FD mode\n");
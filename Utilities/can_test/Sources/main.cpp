@@ -19,6 +19,8 @@
 //
 #include "Driver.h"
 #include "Timer.h"
+#include "can_rpl.h"
+#include "can_lat.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -29,6 +31,7 @@
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#include <pthread.h>
 
 #include <inttypes.h>
 
@@ -42,24 +45,39 @@
 #define TxMODE  (1)
 #define TxFRAMES  (2)
 #define TxRANDOM  (3)
+#define TxREPLAY  (4)
+#define TxLATENCY  (5)
 class CCanDevice : public CCanDriver {
 public:
     uint64_t ReceiverTest(bool checkCounter = false, uint64_t expectedNumber = 0U, bool stopOnError = false);
     uint64_t TransmitterTest(time_t duration, CANAPI_OpMode_t opMode, uint32_t id = 0x100U, uint8_t dlc = 0U, uint32_t delay = 0U, uint64_t offset = 0U);
     uint64_t TransmitterTest(uint64_t count, CANAPI_OpMode_t opMode, bool random = false, uint32_t id = 0x100U, uint8_t dlc = 0U, uint32_t delay = 0U, uint64_t offset = 0U);
+    uint64_t ReplayTest(const char *path, const rpl_options_t &options);
+    uint64_t LatencyTest(CCanDevice &rxDevice, uint64_t count, CANAPI_OpMode_t opMode, uint32_t id = 0x100U, uint8_t dlc = 8U, uint64_t period = 0U, const char *hgrm = NULL);
+    int SendMessages(const CANAPI_Message_t *messages, size_t count);
+private:
+    bool m_bBatching;  // one USB transfer for messages that are due at once
+    uint64_t m_u64Errors;
+    uint64_t m_u64Calls;
+public:
+    CCanDevice() : CCanDriver(), m_bBatching(true), m_u64Errors(0U), m_u64Calls(0U) {}
 public:
     static int ListCanDevices(void);
     static int TestCanDevices(CANAPI_OpMode_t opMode);
 };
 
 static void sigterm(int signo);
+static int sender(void *context, const rpl_message_t *messages, size_t count);
+static void *receiver(void *context);
 static void usage(FILE *stream, const char *program);
 static void version(FILE *stream, const char *program);
 
 static const char *prompt[4] = {"-\b", "/\b", "|\b", "\\\b"};
 static volatile int running = 1;
+static rpl_replayer_t replayer = NULL;
 
 static CCanDevice canDevice = CCanDevice();
+static CCanDevice canReceiver = CCanDevice();
 
 static const char APPLICATION[] = "CAN Tester for " TESTER_INTEFACE ", Version " VERSION_STRING;
 static const char COPYRIGHT[]   = "Copyright (c) " TESTER_COPYRIGHT;
@@ -94,6 +112,13 @@ int main(int argc, const char * argv[]) {
     int stop_on_error = 0;
     int num_boards = 0;
     int show_version = 0;
+    char *replay_file = NULL;
+    rpl_options_t replay;
+    long loops = 1, code = 0, mask = 0, from = 0, to = 0;
+    int sp = 0, lp = 0, fi = 0;
+    char *receiver_name = NULL, *hgrm_file = NULL;
+    long rate = 0; int ra = 0;
+    CCanDevice::SChannelInfo rx_channel;
     char *device, *firmware, *software;
     char property[CANPROP_MAX_BUFFER_SIZE] = "";
     struct option long_options[] = {
@@ -117,6 +142,15 @@ int main(int argc, const char * argv[]) {
         {"dlc", required_argument, 0, 'd'},
         {"data", required_argument, 0, 'd'},
         {"id", required_argument, 0, 'i'},
+        {"replay", required_argument, 0, 'P'},
+        {"speed", required_argument, 0, 'Y'},
+        {"loop", required_argument, 0, 'O'},
+        {"filter", required_argument, 0, 'K'},
+        {"remap", required_argument, 0, 'J'},
+        {"latency", required_argument, 0, 'Q'},
+        {"receiver", required_argument, 0, 'G'},
+        {"rate", required_argument, 0, 'Z'},
+        {"hgrm", required_argument, 0, 'H'},
         {"list-boards", no_argument, 0, 'L'},
         {"test-boards", no_argument, 0, 'T'},
         {"help", no_argument, 0, 'h'},
@@ -136,6 +170,7 @@ int main(int argc, const char * argv[]) {
     (void)CCanDevice::MapIndex2Bitrate(bitrate.index, bitrate);
     (void)CCanDevice::MapBitrate2Speed(bitrate, speed);
     (void)op;
+    (void)rpl_options_default(&replay);
 
     /* signal handler */
     if ((signal(SIGINT, sigterm) == SIG_ERR) ||
@@ -390,6 +425,101 @@ int main(int argc, const char * argv[]) {
                 return 1;
             }
             break;
+        case 'P':  /* option `--replay=<file>' */
+            if (m++) {
+                fprintf(stderr, "%s: duplicated option `--replay'\n", basename(argv[0]));
+                return 1;
+            }
+            replay_file = optarg;
+            mode = TxREPLAY;
+            break;
+        case 'Y':  /* option `--speed=<factor>' */
+            if (sp++) {
+                fprintf(stderr, "%s: duplicated option `--speed'\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf(optarg, "%lf", &replay.speed) != 1) || (replay.speed < 0.0)) {
+                fprintf(stderr, "%s: illegal argument for option `--speed'\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case 'O':  /* option `--loop=<number>' */
+            if (lp++) {
+                fprintf(stderr, "%s: duplicated option `--loop'\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf(optarg, "%li", &loops) != 1) || (loops < 0) || (loops > (long)UINT32_MAX)) {
+                fprintf(stderr, "%s: illegal argument for option `--loop'\n", basename(argv[0]));
+                return 1;
+            }
+            replay.loops = (uint32_t)loops;
+            break;
+        case 'K':  /* option `--filter=<code>[:<mask>]' */
+            if (fi++) {
+                fprintf(stderr, "%s: duplicated option `--filter'\n", basename(argv[0]));
+                return 1;
+            }
+            switch (sscanf(optarg, "%li:%li", &code, &mask)) {
+                case 1: mask = 0x1FFFFFFF; break;  // exact match
+                case 2: break;
+                default: code = -1; break;
+            }
+            if ((code < 0x000) || (0x1FFFFFFF < code) || (mask < 0x000) || (0x1FFFFFFF < mask)) {
+                fprintf(stderr, "%s: illegal argument for option `--filter'\n", basename(argv[0]));
+                return 1;
+            }
+            replay.filter_code = (uint32_t)code;
+            replay.filter_mask = (uint32_t)mask;
+            break;
+        case 'J':  /* option `--remap=<from>:<to>' (repeatable) */
+            if (replay.num_remaps >= RPL_MAX_REMAP) {
+                fprintf(stderr, "%s: too many options `--remap' (max. %u)\n", basename(argv[0]), RPL_MAX_REMAP);
+                return 1;
+            }
+            if ((sscanf(optarg, "%li:%li", &from, &to) != 2) ||
+                (from < 0x000) || (0x1FFFFFFF < from) || (to < 0x000) || (0x1FFFFFFF < to)) {
+                fprintf(stderr, "%s: illegal argument for option `--remap'\n", basename(argv[0]));
+                return 1;
+            }
+            replay.remap[replay.num_remaps].from = (uint32_t)from;
+            replay.remap[replay.num_remaps].to = (uint32_t)to;
+            replay.num_remaps++;
+            break;
+        case 'Q':  /* option `--latency=<frames>' */
+            if (m++) {
+                fprintf(stderr, "%s: duplicated option `--latency'\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf(optarg, "%li", &txframes) != 1) || (txframes < 0)) {
+                fprintf(stderr, "%s: illegal argument for option `--latency'\n", basename(argv[0]));
+                return 1;
+            }
+            mode = TxLATENCY;
+            break;
+        case 'G':  /* option `--receiver=<interface>' */
+            if (receiver_name) {
+                fprintf(stderr, "%s: duplicated option `--receiver'\n", basename(argv[0]));
+                return 1;
+            }
+            receiver_name = optarg;
+            break;
+        case 'Z':  /* option `--rate=<frames/s>' */
+            if (ra++) {
+                fprintf(stderr, "%s: duplicated option `--rate'\n", basename(argv[0]));
+                return 1;
+            }
+            if ((sscanf(optarg, "%li", &rate) != 1) || (rate < 0) || (rate > 1000000)) {
+                fprintf(stderr, "%s: illegal argument for option `--rate'\n", basename(argv[0]));
+                return 1;
+            }
+            break;
+        case 'H':  /* option `--hgrm=<file>' */
+            if (hgrm_file) {
+                fprintf(stderr, "%s: duplicated option `--hgrm'\n", basename(argv[0]));
+                return 1;
+            }
+            hgrm_file = optarg;
+            break;
         case 'a':  /* option `--list-boards[=<vendor>]' (-a, deprecated) */
         case 'L':  /* option `--list-boards[=<vendor>]' (-L) */
             fprintf(stdout, "%s\n%s\n\n%s\n\n", APPLICATION, COPYRIGHT, WARRANTY);
@@ -441,6 +571,40 @@ int main(int argc, const char * argv[]) {
         fprintf(stderr, "%s: illegal argument `%s'\n", basename(argv[0]), argv[optind]);
         return 1;
     }
+    /* - search the receiver <interface> for the latency test */
+    if (mode == TxLATENCY) {
+        if (!receiver_name) {
+            fprintf(stderr, "%s: option `--latency' without option `--receiver'\n", basename(argv[0]));
+            return 1;
+        }
+        result = CCanDevice::GetFirstChannel(rx_channel);
+        while (result) {
+            if (strcasecmp(receiver_name, rx_channel.m_szDeviceName) == 0) {
+                break;
+            }
+            result = CCanDevice::GetNextChannel(rx_channel);
+        }
+        if (!result) {
+            fprintf(stderr, "%s: illegal argument for option `--receiver'\n", basename(argv[0]));
+            return 1;
+        }
+        if (rx_channel.m_nChannelNo == channel.m_nChannelNo) {
+            fprintf(stderr, "%s: receiver and transmitter must be different interfaces\n", basename(argv[0]));
+            return 1;
+        }
+        if (can_dlc < (long)LAT_STAMP_LENGTH) {
+            fprintf(stderr, "%s: illegal combination of options `--latency' and `--dlc' (d)\n", basename(argv[0]));
+            return 1;
+        }
+        if (ra && t) {
+            fprintf(stderr, "%s: illegal combination of options `--rate' and `--cycle' (c) or `--usec' (u)\n", basename(argv[0]));
+            return 1;
+        }
+    }
+    else if (receiver_name || ra || hgrm_file) {
+        fprintf(stderr, "%s: option `--receiver', `--rate' or `--hgrm' without option `--latency'\n", basename(argv[0]));
+        return 1;
+    }
     /* - check bit-timing index (n/a for CAN FD) */
     if (opMode.fdoe && (bitrate.btr.frequency <= 0)) {
         fprintf(stderr, "%s: illegal combination of options `--mode' (m) and `--bitrate'\n", basename(argv[0]));
@@ -459,6 +623,11 @@ int main(int argc, const char * argv[]) {
         else if (can_dlc > 12) can_dlc = 0xA;
         else if (can_dlc > 8) can_dlc = 0x9;
     }
+    /* - check replay options */
+    if ((mode != TxREPLAY) && (sp || lp || fi || replay.num_remaps)) {
+        fprintf(stderr, "%s: option `--speed', `--loop', `--filter' or `--remap' without option `--replay'\n", basename(argv[0]));
+        return 1;
+    }
     /* - check operation mode flags */
     if ((mode != RxMODE) && opMode.mon) {
         fprintf(stderr, "%s: illegal option `--listen-only' for transmitter test\n", basename(argv[0]));
@@ -545,6 +714,25 @@ int main(int argc, const char * argv[]) {
         goto teardown;
     }
     fprintf(stdout, "OK!\n");
+    /* - initialize and start the receiver (latency test) */
+    if (mode == TxLATENCY) {
+        fprintf(stdout, "Receiver=%s...", rx_channel.m_szDeviceName);
+        fflush(stdout);
+        retVal = canReceiver.InitializeChannel(rx_channel.m_nChannelNo, opMode);
+        if (retVal != CCanApi::NoError) {
+            fprintf(stdout, "FAILED!\n");
+            fprintf(stderr, "+++ error: CAN Controller of the receiver could not be initialized (%i)\n", retVal);
+            goto teardown;
+        }
+        retVal = canReceiver.StartController(bitrate);
+        if (retVal != CCanApi::NoError) {
+            fprintf(stdout, "FAILED!\n");
+            fprintf(stderr, "+++ error: CAN Controller of the receiver could not be started (%i)\n", retVal);
+            (void)canReceiver.TeardownChannel();
+            goto teardown;
+        }
+        fprintf(stdout, "OK!\n");
+    }
     /* - do your job well: */
     switch (mode) {
     case TxMODE:    /* transmitter test (duration) */
@@ -556,6 +744,14 @@ int main(int argc, const char * argv[]) {
     case TxRANDOM:  /* transmitter test (random) */
         (void)canDevice.TransmitterTest((uint64_t)txframes, opMode, true, (uint32_t)can_id, (uint8_t)can_dlc, (uint32_t)delay, (uint64_t)number);
         break;
+    case TxREPLAY:  /* replay of a capture file */
+        (void)canDevice.ReplayTest(replay_file, replay);
+        break;
+    case TxLATENCY: /* latency test (with a receiver) */
+        (void)canDevice.LatencyTest(canReceiver, (uint64_t)txframes, opMode, (uint32_t)can_id, (uint8_t)can_dlc,
+                                    rate ? (1000000000ULL / (uint64_t)rate) : ((uint64_t)delay * 1000ULL), hgrm_file);
+        (void)canReceiver.TeardownChannel();
+        break;
     default:        /* receiver test (abort with Ctrl+C) */
         (void)canDevice.ReceiverTest((bool)n, (uint64_t)number, (bool)stop_on_error);
         break;
@@ -753,6 +949,203 @@ retry_tx_test:
     CTimer::Delay(1U * CTimer::SEC);  /* afterburner */
     return frames;}
 
+uint64_t CCanDevice::ReplayTest(const char *path, const rpl_options_t &options) {
+    rpl_replayer_t handle = NULL;
+    rpl_stats_t stats;
+    int rc;
+
+    time_t start = time(NULL);
+
+    fprintf(stdout, "\nReplaying=%s...", path);
+    fflush (stdout);
+    if ((rc = rpl_replayer_open(&handle, path, &options)) != RPLERR_NOERROR) {
+        fprintf(stdout, "FAILED!\n");
+        fprintf(stderr, "+++ error: capture file could not be opened (%i)\n", rc);
+        return 0U;
+    }
+    fprintf(stdout, "OK!\n");
+    fprintf(stderr, "\nPress ^C to abort.\n");
+    fprintf(stdout, "\nTransmitting message(s)...");
+    fflush (stdout);
+    m_u64Errors = m_u64Calls = 0U;
+    replayer = handle;
+    rc = running ? rpl_replayer_run(handle, sender, (void*)this) : RPLERR_STOPPED;
+    replayer = NULL;
+    (void)rpl_replayer_stats(handle, &stats);
+    (void)rpl_replayer_close(handle);
+    fprintf(stderr, "\b");
+    if (rc == RPLERR_NOERROR)
+        fprintf(stdout, "OK!\n\n");
+    else if (rc == RPLERR_STOPPED)
+        fprintf(stdout, "STOP!\n\n");
+    else
+        fprintf(stdout, "ERROR(%i)!\n\n", rc);
+    fprintf(stdout, "Message(s)=%" PRIu64 "\n", stats.messages);
+    fprintf(stdout, "Error(s)=%" PRIu64 "\n", m_u64Errors);
+    fprintf(stdout, "Call(s)=%" PRIu64 "\n", m_u64Calls);
+    fprintf(stdout, "Batch(es)=%" PRIu64 "\n", stats.batches);
+    fprintf(stdout, "Filtered=%" PRIu64 "\n", stats.filtered);
+    fprintf(stdout, "Loop(s)=%" PRIu32 "\n", stats.loops);
+    fprintf(stdout, "Time=%lisec\n", time(NULL) - start);
+    fprintf(stdout, "Timing error: min=%.1fus avg=%.1fus max=%.1fus (p50=%.0fus p99=%.0fus p99.9=%.0fus, %" PRIu64 " late)\n\n",
+                     (double)stats.error_min / 1000., (double)stats.error_avg / 1000., (double)stats.error_max / 1000.,
+                     (double)stats.error_p50 / 1000., (double)stats.error_p99 / 1000., (double)stats.error_p999 / 1000., stats.late);
+
+    CTimer::Delay(1U * CTimer::SEC);  /* afterburner */
+    return stats.messages;
+}
+
+typedef struct {
+    CCanDevice *device;
+    lat_meter_t meter;
+    uint32_t id;
+    volatile int active;
+    volatile uint64_t frames;
+} latency_receiver_t;
+
+uint64_t CCanDevice::LatencyTest(CCanDevice &rxDevice, uint64_t count, CANAPI_OpMode_t opMode, uint32_t id, uint8_t dlc, uint64_t period, const char *hgrm) {
+    CANAPI_Message_t message;
+    CANAPI_Return_t retVal;
+    latency_receiver_t context;
+    pthread_t thread;
+    lat_stats_t stats;
+    uint64_t deadline, now;
+    int rc;
+
+    time_t start = time(NULL);
+    uint64_t frames = 0U;
+    uint64_t errors = 0U;
+    uint64_t calls = 0U;
+
+    memset(&context, 0, sizeof(latency_receiver_t));
+    if ((rc = lat_meter_create(&context.meter)) != LATERR_NOERROR) {
+        fprintf(stderr, "+++ error: latency meter could not be created (%i)\n", rc);
+        return 0U;
+    }
+    context.device = &rxDevice;
+    context.id = id;
+    context.active = 1;
+    if (pthread_create(&thread, NULL, receiver, (void*)&context) != 0) {
+        fprintf(stderr, "+++ error: receiver thread could not be created\n");
+        (void)lat_meter_destroy(context.meter);
+        return 0U;
+    }
+    memset(&message, 0, sizeof(CANAPI_Message_t));
+
+    fprintf(stderr, "\nPress ^C to abort.\n");
+    message.id  = id;
+    message.xtd = (id > CAN_MAX_STD_ID) ? 1 : 0;
+    message.rtr = 0;
+    message.fdf = opMode.fdoe;
+    message.brs = opMode.brse;
+    message.dlc = dlc;
+    fprintf(stdout, "\nTransmitting message(s)...");
+    fflush (stdout);
+    deadline = lat_clock();
+    while ((frames < count) && running) {
+        /* pace on absolute deadlines: sleep until shortly before, then spin */
+        if (period) {
+            now = lat_clock();
+            if ((deadline > now) && ((deadline - now) > (200U * 1000U)))
+                CTimer::Delay((uint32_t)((deadline - now - (200U * 1000U)) / 1000U));
+            while (lat_clock() < deadline)
+                ;
+            deadline += period;
+        }
+        /* transmit message (repeat when busy) */
+retry_tx_latency:
+        calls++;
+        (void)lat_stamp(message.data, (size_t)Dlc2Len(message.dlc), (uint32_t)frames, lat_clock());
+        retVal = WriteMessage(message);
+        if (retVal == CCanApi::NoError)
+            fprintf(stderr, "%s", prompt[(frames++ % 4)]);
+        else if ((retVal == CCanApi::TransmitterBusy) && running)
+            goto retry_tx_latency;
+        else
+            errors++;
+    }
+    /* wait for the stragglers (at most one second without progress) */
+    for (int idle = 0; (idle < 100) && (context.frames < frames) && running; idle++) {
+        uint64_t before = context.frames;
+        CTimer::Delay(10U * CTimer::MSEC);
+        if (context.frames != before)
+            idle = 0;
+    }
+    context.active = 0;
+    (void)pthread_join(thread, NULL);
+    fprintf(stderr, "\b");
+    fprintf(stdout, running ? "OK!\n\n" : "STOP!\n\n");
+    fprintf(stdout, "Message(s)=%" PRIu64 "\n", frames);
+    fprintf(stdout, "Error(s)=%" PRIu64 "\n", errors);
+    fprintf(stdout, "Call(s)=%" PRIu64 "\n", calls);
+    fprintf(stdout, "Time=%lisec\n", time(NULL) - start);
+    /* the result: latency, jitter, loss and reordering */
+    (void)lat_meter_stats(context.meter, frames, &stats);
+    fprintf(stdout, "Received=%" PRIu64 "\n", stats.received);
+    fprintf(stdout, "Lost=%" PRIu64 "\n", stats.lost);
+    fprintf(stdout, "Reordered=%" PRIu64 "\n", stats.reordered);
+    fprintf(stdout, "Duplicate(s)=%" PRIu64 "\n", stats.duplicates);
+    fprintf(stdout, "Invalid=%" PRIu64 "\n", stats.invalid);
+    if (stats.latency.count) {
+        fprintf(stdout, "Latency: min=%.1fus avg=%.1fus max=%.1fus (p50=%.1fus p90=%.1fus p99=%.1fus p99.9=%.1fus p99.99=%.1fus)\n",
+                         (double)stats.latency.min / 1000., (double)stats.latency.mean / 1000., (double)stats.latency.max / 1000.,
+                         (double)stats.latency.p50 / 1000., (double)stats.latency.p90 / 1000., (double)stats.latency.p99 / 1000.,
+                         (double)stats.latency.p999 / 1000., (double)stats.latency.p9999 / 1000.);
+        fprintf(stdout, "Jitter: %.1fus (RFC 3550), |D|: p50=%.1fus p99=%.1fus p99.9=%.1fus max=%.1fus\n",
+                         (double)stats.jitter / 1000., (double)stats.delta.p50 / 1000., (double)stats.delta.p99 / 1000.,
+                         (double)stats.delta.p999 / 1000., (double)stats.delta.max / 1000.);
+    }
+    if (hgrm) {
+        FILE *fp = fopen(hgrm, "w");
+        if (fp) {
+            (void)lat_meter_distribution(context.meter, LAT_LATENCY, fp);
+            (void)fclose(fp);
+            fprintf(stdout, "Distribution=%s\n", hgrm);
+        } else
+            fprintf(stderr, "+++ error: file `%s' could not be created\n", hgrm);
+    }
+    fputc('\n', stdout);
+    (void)lat_meter_destroy(context.meter);
+    return frames;
+}
+
+int CCanDevice::SendMessages(const CANAPI_Message_t *messages, size_t count) {
+    CANAPI_Return_t retVal;
+    size_t i;
+
+#if defined(KVASER_PROP_TX_BATCH)
+    /* messages that are due at once: all in one USB transfer (if supported) */
+    if ((count > 1U) && m_bBatching) {
+retry_tx_batch:
+        m_u64Calls++;
+        retVal = SetProperty(CANPROP_SET_VENDOR_PROP + KVASER_PROP_TX_BATCH, (const void*)messages,
+                             (uint32_t)(count * sizeof(CANAPI_Message_t)));
+        if (retVal == CCanApi::NoError) {
+            fprintf(stderr, "%s", prompt[(m_u64Calls % 4)]);
+            return 0;
+        }
+        else if ((retVal == CCanApi::TransmitterBusy) && running)
+            goto retry_tx_batch;
+        else if (retVal == CCanApi::NotSupported)
+            m_bBatching = false;  /* e.g. shared CAN controller access */
+        /* note: otherwise one by one (to count the errors) */
+    }
+#endif
+    /* transmit the messages one by one (repeat when busy) */
+    for (i = 0U; (i < count) && running; i++) {
+retry_tx_replay:
+        m_u64Calls++;
+        retVal = WriteMessage(messages[i]);
+        if (retVal == CCanApi::NoError)
+            fprintf(stderr, "%s", prompt[(m_u64Calls % 4)]);
+        else if ((retVal == CCanApi::TransmitterBusy) && running)
+            goto retry_tx_replay;
+        else
+            m_u64Errors++;
+    }
+    return 0;
+}
+
 uint64_t CCanDevice::ReceiverTest(bool checkCounter, uint64_t expectedNumber, bool stopOnError) {
     CANAPI_Message_t message;
     CANAPI_Status_t status;
@@ -841,10 +1234,44 @@ static void sigterm(int signo)
 {
     //fprintf(stderr, "%s: got signal %d\n", __FILE__, signo);
     (void)canDevice.SignalChannel();
+    (void)canReceiver.SignalChannel();
+    if (replayer)
+        (void)rpl_replayer_stop(replayer);
     running = 0;
     (void)signo;
 }
 
+/** @brief       sender callback of the replayer.
+ *
+ *  @param[in]   context  - the CAN device
+ *  @param[in]   messages - CAN messages that are due
+ *  @param[in]   count    - number of CAN messages
+ */
+static int sender(void *context, const rpl_message_t *messages, size_t count)
+{
+    return ((CCanDevice*)context)->SendMessages(messages, count);
+}
+
+/** @brief       receiver thread of the latency test.
+ *
+ *  @param[in]   context - the receiver (CAN device and latency meter)
+ */
+static void *receiver(void *context)
+{
+    latency_receiver_t *self = (latency_receiver_t*)context;
+    CANAPI_Message_t message;
+
+    while (self->active) {
+        if (self->device->ReadMessage(message, 10U) != CCanApi::NoError)
+            continue;
+        if (message.sts || message.rtr || (message.id != self->id))
+            continue;
+        if (lat_meter_account(self->meter, message.data, (size_t)CCanDevice::Dlc2Len(message.dlc), lat_clock()) == LATERR_NOERROR)
+            self->frames++;
+    }
+    return NULL;
+}
+
 /** @brief       shows a help screen with all command-line options.
  *
  *  @param[in]   stream  - output stream (e.g. stdout)
@@ -877,6 +1304,15 @@ static void usage(FILE *stream, const char *program)
     fprintf(stream, " -d, --dlc=<length>            send messages of given length (default=8)\n");
     fprintf(stream, " -i, --id=<can-id>             use given identifier (default=100h)\n");
     fprintf(stream, " -n, --number=<number>         set first up-counting number (default=0)\n");
+    fprintf(stream, "     --replay=<file>           alternatively replay a capture file (binary or candump log)\n");
+    fprintf(stream, "     --speed=<factor>          replay speed factor (default=1.0, 0 = no delay)\n");
+    fprintf(stream, "     --loop=<number>           replay the capture <number> times (default=1, 0 = endless)\n");
+    fprintf(stream, "     --filter=<code>[:<mask>]  replay only messages with matching identifier\n");
+    fprintf(stream, "     --remap=<from>:<to>       replay messages with identifier <from> as <to>\n");
+    fprintf(stream, "     --latency=<number>        alternatively measure the latency with the given number of messages\n");
+    fprintf(stream, "     --receiver=<interface>    receive the messages of the latency test with a second interface\n");
+    fprintf(stream, "     --rate=<frames/s>         send rate of the latency test (default=0, as fast as possible)\n");
+    fprintf(stream, "     --hgrm=<file>             write the latency distribution to a file (HdrHistogram format)\n");
 #if (CAN_FD_SUPPORTED != 0)
     fprintf(stream, " -m, --mode=(2.0|FDF[+BRS])    CAN operation mode: CAN 2.0 or CAN FD mode\n");
 #endif